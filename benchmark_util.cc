@@ -0,0 +1,31 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/benchmark_util.h"
+
+#include "base/timer/elapsed_timer.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace benchmark {
+
+void RunAndReport(const std::string& metric_basename,
+                  const std::string& story,
+                  int runs,
+                  const base::RepeatingClosure& body) {
+  // Warm up caches and lazy initialization outside the timed region.
+  body.Run();
+
+  base::ElapsedTimer timer;
+  for (int i = 0; i < runs; ++i)
+    body.Run();
+  base::TimeDelta elapsed = timer.Elapsed();
+
+  perf_test::PerfResultReporter reporter(metric_basename, story);
+  reporter.RegisterImportantMetric(".wall_time_per_run", "us");
+  reporter.RegisterImportantMetric(".throughput", "runs/s");
+  reporter.AddResult(".wall_time_per_run", elapsed.InMicrosecondsF() / runs);
+  reporter.AddResult(".throughput", runs / elapsed.InSecondsF());
+}
+
+}  // namespace benchmark
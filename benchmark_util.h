@@ -0,0 +1,25 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_BENCHMARK_UTIL_H_
+#define CHROME_TEST_CHROMEDRIVER_BENCHMARK_UTIL_H_
+
+#include <string>
+
+#include "base/callback.h"
+
+namespace benchmark {
+
+// Times |body| over |runs| iterations and reports wall time per run (us)
+// and throughput (runs/s) through perf_test::PerfResultReporter, under
+// |metric_basename| for the given |story|. Used by the microbenchmarks in
+// the chromedriver_benchmarks target.
+void RunAndReport(const std::string& metric_basename,
+                  const std::string& story,
+                  int runs,
+                  const base::RepeatingClosure& body);
+
+}  // namespace benchmark
+
+#endif  // CHROME_TEST_CHROMEDRIVER_BENCHMARK_UTIL_H_
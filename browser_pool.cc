@@ -0,0 +1,125 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/browser_pool.h"
+
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
+#include "chrome/test/chromedriver/capabilities.h"
+#include "chrome/test/chromedriver/chrome/chrome.h"
+#include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/chrome_launcher.h"
+#include "chrome/test/chromedriver/session.h"
+
+namespace {
+
+// Number of warm browsers to keep available. Set once at startup, before
+// the pool is started, so no synchronization is needed.
+int g_browser_pool_target_size = 0;
+
+}  // namespace
+
+BrowserPool::BrowserPool(network::mojom::URLLoaderFactory* url_loader_factory,
+                         const SyncWebSocketFactory& socket_factory,
+                         DeviceManager* device_manager)
+    : url_loader_factory_(url_loader_factory),
+      socket_factory_(socket_factory),
+      device_manager_(device_manager) {}
+
+BrowserPool::~BrowserPool() = default;
+
+// static
+void BrowserPool::SetTargetSize(int size) {
+  g_browser_pool_target_size = size;
+}
+
+// static
+bool BrowserPool::IsPoolCompatible(const Capabilities& capabilities) {
+  // Pooled browsers are launched with default options, so any capability
+  // that changes the launch itself requires a dedicated launch. Options
+  // applied after launch (e.g. acceptInsecureCerts, timeouts) are fine.
+  return !capabilities.IsAndroid() && !capabilities.IsRemoteBrowser() &&
+         capabilities.binary.empty() && capabilities.switches.GetSize() == 0 &&
+         capabilities.exclude_switches.empty() &&
+         capabilities.extensions.empty() && !capabilities.prefs &&
+         !capabilities.local_state && !capabilities.device_metrics &&
+         capabilities.perf_logging_prefs.trace_categories.empty() &&
+         !capabilities.devtools_events_logging_prefs &&
+         capabilities.minidump_path.empty();
+}
+
+void BrowserPool::Start() {
+  MaybeScheduleLaunches();
+}
+
+void BrowserPool::Shutdown() {
+  std::deque<std::unique_ptr<Chrome>> browsers;
+  {
+    base::AutoLock lock(lock_);
+    shutting_down_ = true;
+    browsers.swap(browsers_);
+  }
+  for (auto& chrome : browsers)
+    chrome->Quit();
+}
+
+std::unique_ptr<Chrome> BrowserPool::TakeBrowser() {
+  std::unique_ptr<Chrome> chrome;
+  {
+    base::AutoLock lock(lock_);
+    if (browsers_.empty())
+      return nullptr;
+    chrome = std::move(browsers_.front());
+    browsers_.pop_front();
+  }
+  // Start replacing the adopted browser right away, so the pool is warm
+  // again by the time the next session arrives.
+  MaybeScheduleLaunches();
+  return chrome;
+}
+
+void BrowserPool::MaybeScheduleLaunches() {
+  base::AutoLock lock(lock_);
+  if (shutting_down_)
+    return;
+  while (static_cast<int>(browsers_.size()) + pending_launches_ <
+         g_browser_pool_target_size) {
+    pending_launches_++;
+    base::ThreadPool::PostTask(
+        FROM_HERE, {base::MayBlock(), base::WithBaseSyncPrimitives()},
+        base::BindOnce(&BrowserPool::LaunchOnWorkerThread, this));
+  }
+}
+
+void BrowserPool::LaunchOnWorkerThread() {
+  Capabilities capabilities;
+  std::vector<std::unique_ptr<DevToolsEventListener>> devtools_event_listeners;
+  std::unique_ptr<Chrome> chrome;
+  Status status = LaunchChrome(url_loader_factory_, socket_factory_,
+                               device_manager_, capabilities,
+                               std::move(devtools_event_listeners), &chrome,
+                               kW3CDefault);
+  bool discard = false;
+  {
+    base::AutoLock lock(lock_);
+    pending_launches_--;
+    if (status.IsError()) {
+      LOG(WARNING) << "failed to launch browser for pool: "
+                   << status.message();
+      return;
+    }
+    if (shutting_down_)
+      discard = true;
+    else
+      browsers_.push_back(std::move(chrome));
+  }
+  if (discard)
+    chrome->Quit();
+}
@@ -0,0 +1,74 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_BROWSER_POOL_H_
+#define CHROME_TEST_CHROMEDRIVER_BROWSER_POOL_H_
+
+#include <deque>
+#include <memory>
+
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "chrome/test/chromedriver/net/sync_websocket_factory.h"
+#include "services/network/public/mojom/url_loader_factory.mojom.h"
+
+struct Capabilities;
+class Chrome;
+class DeviceManager;
+
+// Maintains a pool of pre-launched, never-used Chrome instances, so that
+// sessions whose capabilities do not require a custom launch can adopt a
+// warm browser instead of paying the full launch cost in InitSession.
+// The pool size is configured with --browser-pool-size and defaults to
+// zero, which disables pooling. Thread-safe; launches run on the shared
+// thread pool.
+class BrowserPool : public base::RefCountedThreadSafe<BrowserPool> {
+ public:
+  BrowserPool(network::mojom::URLLoaderFactory* url_loader_factory,
+              const SyncWebSocketFactory& socket_factory,
+              DeviceManager* device_manager);
+  BrowserPool(const BrowserPool&) = delete;
+  BrowserPool& operator=(const BrowserPool&) = delete;
+
+  // Sets the number of warm browsers to keep available. Called once at
+  // startup before the pool is started.
+  static void SetTargetSize(int size);
+
+  // Returns true if |capabilities| only requests things that a browser
+  // launched with default options can satisfy.
+  static bool IsPoolCompatible(const Capabilities& capabilities);
+
+  // Begins filling the pool to its target size.
+  void Start();
+
+  // Quits all pooled browsers and discards any launches still in flight.
+  void Shutdown();
+
+  // Removes and returns a warm browser, or null if none is available, and
+  // schedules a background replacement launch.
+  std::unique_ptr<Chrome> TakeBrowser();
+
+ private:
+  friend class base::RefCountedThreadSafe<BrowserPool>;
+  ~BrowserPool();
+
+  // Posts launch tasks until queued plus in-flight launches reach the
+  // target size.
+  void MaybeScheduleLaunches();
+  void LaunchOnWorkerThread();
+
+  network::mojom::URLLoaderFactory* url_loader_factory_;
+  SyncWebSocketFactory socket_factory_;
+  DeviceManager* device_manager_;
+
+  base::Lock lock_;
+  // Protected by |lock_|.
+  std::deque<std::unique_ptr<Chrome>> browsers_;
+  // Protected by |lock_|.
+  int pending_launches_ = 0;
+  // Protected by |lock_|.
+  bool shutting_down_ = false;
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_BROWSER_POOL_H_
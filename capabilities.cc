@@ -4,11 +4,12 @@
 
 #include "chrome/test/chromedriver/capabilities.h"
 
-#include <map>
+#include <stddef.h>
+#include <stdint.h>
+
 #include <utility>
+#include <vector>
 
-#include "base/bind.h"
-#include "base/callback.h"
 #include "base/json/string_escape.h"
 #include "base/logging.h"
 #include "base/stl_util.h"
@@ -30,87 +31,225 @@
 
 namespace {
 
-typedef base::RepeatingCallback<Status(const base::Value&, Capabilities*)>
-    Parser;
+// One row of a precompiled capability schema: the key, a bitmask of the
+// parse modes the row applies in, and the handler that validates the value
+// and stores it into the Capabilities struct. A key may repeat across rows
+// with disjoint mode masks; the first row whose mask matches wins, and a key
+// whose rows all fail the mask test is as unrecognized as one with no row.
+struct CapabilitySchemaEntry {
+  const char* key;
+  uint8_t modes;
+  Status (*parse)(const base::Value& option,
+                  bool w3c_compliant,
+                  Capabilities* capabilities);
+};
+
+// Parse-mode bits for the top-level capability schema. Exactly one of
+// kModeW3c / kModeLegacy is set per parse, plus the data-dependent bits
+// resolved up front in Capabilities::Parse, so rows can express "only while
+// the prefixed options key is in use" and the like.
+constexpr uint8_t kModeW3c = 1 << 0;
+constexpr uint8_t kModeLegacy = 1 << 1;
+constexpr uint8_t kModeAny = kModeW3c | kModeLegacy;
+constexpr uint8_t kModePrefixedChromeOptions = 1 << 2;
+constexpr uint8_t kModeUnprefixedChromeOptions = 1 << 3;
+constexpr uint8_t kModeSeleniumLoggingPrefs = 1 << 4;
+constexpr uint8_t kModePrefixedLoggingPrefs = 1 << 5;
+constexpr uint8_t kModeUnprefixedLoggingPrefs = 1 << 6;
+constexpr uint8_t kModeMobileEmulation = 1 << 7;
+
+// Mode bits for the browser options schema, derived from which of the
+// androidPackage / debuggerAddress keys the options dictionary carries.
+constexpr uint8_t kChromeModeAndroid = 1 << 0;
+constexpr uint8_t kChromeModeRemote = 1 << 1;
+constexpr uint8_t kChromeModeDesktop = 1 << 2;
+constexpr uint8_t kChromeModeAny =
+    kChromeModeAndroid | kChromeModeRemote | kChromeModeDesktop;
+
+const CapabilitySchemaEntry* FindSchemaEntry(const CapabilitySchemaEntry* table,
+                                             size_t table_size,
+                                             const std::string& key,
+                                             uint8_t modes) {
+  for (size_t i = 0; i < table_size; ++i) {
+    if ((table[i].modes & modes) && key == table[i].key)
+      return &table[i];
+  }
+  return nullptr;
+}
 
-Status ParseBoolean(
-    bool* to_set,
-    const base::Value& option,
-    Capabilities* capabilities) {
-  if (!option.GetAsBoolean(to_set))
+// Typed schema handlers. The destination is a member-pointer template
+// parameter, so every instantiation is a plain function the schema tables
+// can hold without any per-parse allocation or callback binding.
+template <bool Capabilities::*member>
+Status ParseBooleanMember(const base::Value& option,
+                          bool w3c_compliant,
+                          Capabilities* capabilities) {
+  if (!option.is_bool())
     return Status(kInvalidArgument, "must be a boolean");
+  capabilities->*member = option.GetBool();
   return Status(kOk);
 }
 
-Status ParseString(std::string* to_set,
-                   const base::Value& option,
-                   Capabilities* capabilities) {
-  std::string str;
-  if (!option.GetAsString(&str))
+template <std::string Capabilities::*member>
+Status ParseStringMember(const base::Value& option,
+                         bool w3c_compliant,
+                         Capabilities* capabilities) {
+  if (!option.is_string())
     return Status(kInvalidArgument, "must be a string");
-  if (str.empty())
+  if (option.GetString().empty())
     return Status(kInvalidArgument, "cannot be empty");
-  *to_set = str;
+  capabilities->*member = option.GetString();
   return Status(kOk);
 }
 
-Status ParseInterval(int* to_set,
-                     const base::Value& option,
-                     Capabilities* capabilities) {
-  int parsed_int = 0;
-  if (!option.GetAsInteger(&parsed_int))
+template <base::TimeDelta Capabilities::*member>
+Status ParseTimeDeltaMember(const base::Value& option,
+                            bool w3c_compliant,
+                            Capabilities* capabilities) {
+  if (!option.is_int())
     return Status(kInvalidArgument, "must be an integer");
-  if (parsed_int <= 0)
+  if (option.GetInt() < 0)
+    return Status(kInvalidArgument, "must be positive or zero");
+  capabilities->*member = base::TimeDelta::FromMilliseconds(option.GetInt());
+  return Status(kOk);
+}
+
+template <base::FilePath Capabilities::*member>
+Status ParseFilePathMember(const base::Value& option,
+                           bool w3c_compliant,
+                           Capabilities* capabilities) {
+  if (!option.is_string())
+    return Status(kInvalidArgument, "must be a string");
+  capabilities->*member = base::FilePath::FromUTF8Unsafe(option.GetString());
+  return Status(kOk);
+}
+
+template <std::unique_ptr<base::DictionaryValue> Capabilities::*member>
+Status ParseDictMember(const base::Value& option,
+                       bool w3c_compliant,
+                       Capabilities* capabilities) {
+  const base::DictionaryValue* dict = nullptr;
+  if (!option.GetAsDictionary(&dict))
+    return Status(kInvalidArgument, "must be a dictionary");
+  (capabilities->*member).reset(dict->DeepCopy());
+  return Status(kOk);
+}
+
+template <int Capabilities::*member>
+Status ParsePortNumberMember(const base::Value& option,
+                             bool w3c_compliant,
+                             Capabilities* capabilities) {
+  const int kMaxPortNumber = 65535;
+  if (!option.is_int())
+    return Status(kInvalidArgument, "must be an integer");
+  if (option.GetInt() <= 0)
     return Status(kInvalidArgument, "must be positive");
-  *to_set = parsed_int;
+  if (option.GetInt() > kMaxPortNumber) {
+    return Status(kInvalidArgument, "must be less than or equal to " +
+                                        base::NumberToString(kMaxPortNumber));
+  }
+  capabilities->*member = option.GetInt();
   return Status(kOk);
 }
 
-Status ParseTimeDelta(base::TimeDelta* to_set,
-                      const base::Value& option,
-                      Capabilities* capabilities) {
-  int milliseconds = 0;
-  if (!option.GetAsInteger(&milliseconds))
+template <int PerfLoggingPrefs::*member>
+Status ParsePerfIntervalMember(const base::Value& option,
+                               bool w3c_compliant,
+                               Capabilities* capabilities) {
+  if (!option.is_int())
     return Status(kInvalidArgument, "must be an integer");
-  if (milliseconds < 0)
-    return Status(kInvalidArgument, "must be positive or zero");
-  *to_set = base::TimeDelta::FromMilliseconds(milliseconds);
+  if (option.GetInt() <= 0)
+    return Status(kInvalidArgument, "must be positive");
+  capabilities->perf_logging_prefs.*member = option.GetInt();
   return Status(kOk);
 }
 
-Status ParseFilePath(base::FilePath* to_set,
-                     const base::Value& option,
-                     Capabilities* capabilities) {
+template <bool PerfLoggingPrefs::*member>
+Status ParsePerfBooleanMember(const base::Value& option,
+                              bool w3c_compliant,
+                              Capabilities* capabilities) {
+  if (!option.is_bool())
+    return Status(kInvalidArgument, "must be a boolean");
+  capabilities->perf_logging_prefs.*member = option.GetBool();
+  return Status(kOk);
+}
+
+template <std::string PerfLoggingPrefs::*member>
+Status ParsePerfStringMember(const base::Value& option,
+                             bool w3c_compliant,
+                             Capabilities* capabilities) {
   if (!option.is_string())
     return Status(kInvalidArgument, "must be a string");
-  *to_set = base::FilePath::FromUTF8Unsafe(option.GetString());
+  if (option.GetString().empty())
+    return Status(kInvalidArgument, "cannot be empty");
+  capabilities->perf_logging_prefs.*member = option.GetString();
   return Status(kOk);
 }
 
-Status ParseDict(std::unique_ptr<base::DictionaryValue>* to_set,
-                 const base::Value& option,
-                 Capabilities* capabilities) {
-  const base::DictionaryValue* dict = NULL;
-  if (!option.GetAsDictionary(&dict))
-    return Status(kInvalidArgument, "must be a dictionary");
-  to_set->reset(dict->DeepCopy());
+template <PerfLoggingPrefs::InspectorDomainStatus PerfLoggingPrefs::*member>
+Status ParsePerfDomainStatusMember(const base::Value& option,
+                                   bool w3c_compliant,
+                                   Capabilities* capabilities) {
+  if (!option.is_bool())
+    return Status(kInvalidArgument, "must be a boolean");
+  capabilities->perf_logging_prefs.*member =
+      option.GetBool()
+          ? PerfLoggingPrefs::InspectorDomainStatus::kExplicitlyEnabled
+          : PerfLoggingPrefs::InspectorDomainStatus::kExplicitlyDisabled;
   return Status(kOk);
 }
 
-Status IgnoreDeprecatedOption(
-    const char* option_name,
-    const base::Value& option,
-    Capabilities* capabilities) {
+// Type-checks a capability whose value the driver does not consume.
+Status ParseIgnoredBoolean(const base::Value& option,
+                           bool w3c_compliant,
+                           Capabilities* capabilities) {
+  if (!option.is_bool())
+    return Status(kInvalidArgument, "must be a boolean");
+  return Status(kOk);
+}
+
+Status ParseSessionPriority(const base::Value& option,
+                            bool w3c_compliant,
+                            Capabilities* capabilities) {
+  std::string priority;
+  if (!option.GetAsString(&priority))
+    return Status(kInvalidArgument, "must be a string");
+  if (priority == "interactive")
+    capabilities->low_priority = false;
+  else if (priority == "batch")
+    capabilities->low_priority = true;
+  else
+    return Status(kInvalidArgument, "must be 'interactive' or 'batch'");
+  return Status(kOk);
+}
+
+Status IgnoreDeprecatedOption(const char* option_name) {
   LOG(WARNING) << "Deprecated " << base::ToLowerASCII(kBrowserShortName)
                << " option is ignored: " << option_name;
   return Status(kOk);
 }
 
-Status IgnoreCapability(const base::Value& option, Capabilities* capabilities) {
+Status IgnoreDeprecatedLoadAsync(const base::Value& option,
+                                 bool w3c_compliant,
+                                 Capabilities* capabilities) {
+  return IgnoreDeprecatedOption("loadAsync");
+}
+
+Status IgnoreDeprecatedUseAutomationExtension(const base::Value& option,
+                                              bool w3c_compliant,
+                                              Capabilities* capabilities) {
+  return IgnoreDeprecatedOption("useAutomationExtension");
+}
+
+Status IgnoreCapability(const base::Value& option,
+                        bool w3c_compliant,
+                        Capabilities* capabilities) {
   return Status(kOk);
 }
 
-Status ParseLogPath(const base::Value& option, Capabilities* capabilities) {
+Status ParseLogPath(const base::Value& option,
+                    bool w3c_compliant,
+                    Capabilities* capabilities) {
   if (!option.GetAsString(&capabilities->log_path))
     return Status(kInvalidArgument, "must be a string");
   return Status(kOk);
@@ -135,6 +274,7 @@ Status ParseDeviceName(const std::string& device_name,
 }
 
 Status ParseMobileEmulation(const base::Value& option,
+                            bool w3c_compliant,
                             Capabilities* capabilities) {
   const base::DictionaryValue* mobile_emulation;
   if (!option.GetAsDictionary(&mobile_emulation))
@@ -197,6 +337,7 @@ Status ParseMobileEmulation(const base::Value& option,
 }
 
 Status ParsePageLoadStrategy(const base::Value& option,
+                             bool w3c_compliant,
                              Capabilities* capabilities) {
   if (!option.GetAsString(&capabilities->page_load_strategy))
     return Status(kInvalidArgument, "'pageLoadStrategy' must be a string");
@@ -208,6 +349,7 @@ Status ParsePageLoadStrategy(const base::Value& option,
 }
 
 Status ParseUnhandledPromptBehavior(const base::Value& option,
+                                    bool w3c_compliant,
                                     Capabilities* capabilities) {
   if (!option.GetAsString(&capabilities->unhandled_prompt_behavior))
     return Status(kInvalidArgument,
@@ -221,7 +363,9 @@ Status ParseUnhandledPromptBehavior(const base::Value& option,
   return Status(kInvalidArgument, "invalid 'unhandledPromptBehavior'");
 }
 
-Status ParseTimeouts(const base::Value& option, Capabilities* capabilities) {
+Status ParseTimeouts(const base::Value& option,
+                     bool w3c_compliant,
+                     Capabilities* capabilities) {
   const base::DictionaryValue* timeouts;
   if (!option.GetAsDictionary(&timeouts))
     return Status(kInvalidArgument, "'timeouts' must be a JSON object");
@@ -256,6 +400,7 @@ Status ParseTimeouts(const base::Value& option, Capabilities* capabilities) {
 }
 
 Status ParseSwitches(const base::Value& option,
+                     bool w3c_compliant,
                      Capabilities* capabilities) {
   const base::ListValue* switches_list = NULL;
   if (!option.GetAsList(&switches_list))
@@ -272,7 +417,9 @@ Status ParseSwitches(const base::Value& option,
   return Status(kOk);
 }
 
-Status ParseExtensions(const base::Value& option, Capabilities* capabilities) {
+Status ParseExtensions(const base::Value& option,
+                       bool w3c_compliant,
+                       Capabilities* capabilities) {
   const base::ListValue* extensions = NULL;
   if (!option.GetAsList(&extensions))
     return Status(kInvalidArgument, "must be a list");
@@ -287,8 +434,8 @@ Status ParseExtensions(const base::Value& option, Capabilities* capabilities) {
   return Status(kOk);
 }
 
-Status ParseProxy(bool w3c_compliant,
-                  const base::Value& option,
+Status ParseProxy(const base::Value& option,
+                  bool w3c_compliant,
                   Capabilities* capabilities) {
   const base::DictionaryValue* proxy_dict;
   if (!option.GetAsDictionary(&proxy_dict))
@@ -385,6 +532,7 @@ Status ParseProxy(bool w3c_compliant,
 }
 
 Status ParseExcludeSwitches(const base::Value& option,
+                            bool w3c_compliant,
                             Capabilities* capabilities) {
   const base::ListValue* switches = NULL;
   if (!option.GetAsList(&switches))
@@ -402,26 +550,10 @@ Status ParseExcludeSwitches(const base::Value& option,
   return Status(kOk);
 }
 
-Status ParsePortNumber(int* to_set,
-                     const base::Value& option,
-                     Capabilities* capabilities) {
-  int max_port_number = 65535;
-  int parsed_int = 0;
-  if (!option.GetAsInteger(&parsed_int))
-    return Status(kInvalidArgument, "must be an integer");
-  if (parsed_int <= 0)
-    return Status(kInvalidArgument, "must be positive");
-  if (parsed_int > max_port_number)
-    return Status(kInvalidArgument, "must be less than or equal to " +
-                                    base::NumberToString(max_port_number));
-  *to_set = parsed_int;
-  return Status(kOk);
-}
-
-
-Status ParseNetAddress(NetAddress* to_set,
-                       const base::Value& option,
-                       Capabilities* capabilities) {
+template <NetAddress Capabilities::*member>
+Status ParseNetAddressMember(const base::Value& option,
+                             bool w3c_compliant,
+                             Capabilities* capabilities) {
   std::string server_addr;
   if (!option.GetAsString(&server_addr))
     return Status(kInvalidArgument, "must be 'host:port'");
@@ -451,11 +583,12 @@ Status ParseNetAddress(NetAddress* to_set,
   if (port <= 0)
     return Status(kInvalidArgument, "port must be > 0");
 
-  *to_set = NetAddress(values[0], port);
+  capabilities->*member = NetAddress(values[0], port);
   return Status(kOk);
 }
 
 Status ParseLoggingPrefs(const base::Value& option,
+                         bool w3c_compliant,
                          Capabilities* capabilities) {
   const base::DictionaryValue* logging_prefs = NULL;
   if (!option.GetAsDictionary(&logging_prefs))
@@ -464,6 +597,14 @@ Status ParseLoggingPrefs(const base::Value& option,
   for (base::DictionaryValue::Iterator pref(*logging_prefs);
        !pref.IsAtEnd(); pref.Advance()) {
     std::string type = pref.key();
+    if (type == "bufferSize") {
+      // Size knob, not a log type: caps how many entries each log buffers
+      // between retrievals.
+      if (!pref.value().is_int() || pref.value().GetInt() <= 0)
+        return Status(kInvalidArgument, "bufferSize must be a positive int");
+      capabilities->log_buffer_size = pref.value().GetInt();
+      continue;
+    }
     Log::Level level;
     std::string level_name;
     if (!pref.value().GetAsString(&level_name) ||
@@ -476,50 +617,52 @@ Status ParseLoggingPrefs(const base::Value& option,
   return Status(kOk);
 }
 
-Status ParseInspectorDomainStatus(
-    PerfLoggingPrefs::InspectorDomainStatus* to_set,
-    const base::Value& option,
-    Capabilities* capabilities) {
-  bool desired_value;
-  if (!option.GetAsBoolean(&desired_value))
-    return Status(kInvalidArgument, "must be a boolean");
-  if (desired_value)
-    *to_set = PerfLoggingPrefs::InspectorDomainStatus::kExplicitlyEnabled;
-  else
-    *to_set = PerfLoggingPrefs::InspectorDomainStatus::kExplicitlyDisabled;
-  return Status(kOk);
-}
-
 Status ParsePerfLoggingPrefs(const base::Value& option,
+                             bool w3c_compliant,
                              Capabilities* capabilities) {
-  const base::DictionaryValue* perf_logging_prefs = NULL;
+  const base::DictionaryValue* perf_logging_prefs = nullptr;
   if (!option.GetAsDictionary(&perf_logging_prefs))
     return Status(kInvalidArgument, "must be a dictionary");
 
-  std::map<std::string, Parser> parser_map;
-  parser_map["bufferUsageReportingInterval"] = base::BindRepeating(
-      &ParseInterval,
-      &capabilities->perf_logging_prefs.buffer_usage_reporting_interval);
-  parser_map["enableNetwork"] = base::BindRepeating(
-      &ParseInspectorDomainStatus, &capabilities->perf_logging_prefs.network);
-  parser_map["enablePage"] = base::BindRepeating(
-      &ParseInspectorDomainStatus, &capabilities->perf_logging_prefs.page);
-  parser_map["traceCategories"] = base::BindRepeating(
-      &ParseString, &capabilities->perf_logging_prefs.trace_categories);
+  static const CapabilitySchemaEntry kPerfLoggingPrefsSchema[] = {
+      {"bufferUsageReportingInterval", kModeAny,
+       &ParsePerfIntervalMember<
+           &PerfLoggingPrefs::buffer_usage_reporting_interval>},
+      {"captureByteLimit", kModeAny,
+       &ParsePerfIntervalMember<&PerfLoggingPrefs::capture_byte_limit>},
+      {"enableNetwork", kModeAny,
+       &ParsePerfDomainStatusMember<&PerfLoggingPrefs::network>},
+      {"enablePage", kModeAny,
+       &ParsePerfDomainStatusMember<&PerfLoggingPrefs::page>},
+      {"eventSamplingInterval", kModeAny,
+       &ParsePerfIntervalMember<&PerfLoggingPrefs::event_sampling_interval>},
+      {"sessionSamplingFactor", kModeAny,
+       &ParsePerfIntervalMember<&PerfLoggingPrefs::session_sampling_factor>},
+      {"spoolTraceEvents", kModeAny,
+       &ParsePerfBooleanMember<&PerfLoggingPrefs::spool_trace_events>},
+      {"traceCategories", kModeAny,
+       &ParsePerfStringMember<&PerfLoggingPrefs::trace_categories>},
+  };
 
   for (base::DictionaryValue::Iterator it(*perf_logging_prefs); !it.IsAtEnd();
        it.Advance()) {
-     if (parser_map.find(it.key()) == parser_map.end())
-       return Status(kInvalidArgument,
-                     "unrecognized performance logging option: " + it.key());
-     Status status = parser_map[it.key()].Run(it.value(), capabilities);
-     if (status.IsError())
-       return Status(kInvalidArgument, "cannot parse " + it.key(), status);
+    const CapabilitySchemaEntry* entry =
+        FindSchemaEntry(kPerfLoggingPrefsSchema,
+                        base::size(kPerfLoggingPrefsSchema), it.key(),
+                        kModeAny);
+    if (!entry) {
+      return Status(kInvalidArgument,
+                    "unrecognized performance logging option: " + it.key());
+    }
+    Status status = entry->parse(it.value(), w3c_compliant, capabilities);
+    if (status.IsError())
+      return Status(kInvalidArgument, "cannot parse " + it.key(), status);
   }
   return Status(kOk);
 }
 
 Status ParseDevToolsEventsLoggingPrefs(const base::Value& option,
+                                       bool w3c_compliant,
                                        Capabilities* capabilities) {
   const base::ListValue* devtools_events_logging_prefs = nullptr;
   if (!option.GetAsList(&devtools_events_logging_prefs))
@@ -531,7 +674,9 @@ Status ParseDevToolsEventsLoggingPrefs(const base::Value& option,
   return Status(kOk);
 }
 
-Status ParseWindowTypes(const base::Value& option, Capabilities* capabilities) {
+Status ParseWindowTypes(const base::Value& option,
+                        bool w3c_compliant,
+                        Capabilities* capabilities) {
   const base::ListValue* window_types = NULL;
   if (!option.GetAsList(&window_types))
     return Status(kInvalidArgument, "must be a list");
@@ -551,113 +696,120 @@ Status ParseWindowTypes(const base::Value& option, Capabilities* capabilities) {
   return Status(kOk);
 }
 
-Status ParseChromeOptions(
-    const base::Value& capability,
-    Capabilities* capabilities) {
-  const base::DictionaryValue* chrome_options = NULL;
+Status ParseChromeOptions(const base::Value& capability,
+                          bool w3c_compliant,
+                          Capabilities* capabilities) {
+  const base::DictionaryValue* chrome_options = nullptr;
   if (!capability.GetAsDictionary(&chrome_options))
     return Status(kInvalidArgument, "must be a dictionary");
 
-  bool is_android = chrome_options->HasKey("androidPackage");
-  bool is_remote = chrome_options->HasKey("debuggerAddress");
-
-  std::map<std::string, Parser> parser_map;
-  // Ignore 'args', 'binary' and 'extensions' capabilities by default, since the
-  // Java client always passes them.
-  parser_map["args"] = base::BindRepeating(&IgnoreCapability);
-  parser_map["binary"] = base::BindRepeating(&IgnoreCapability);
-  parser_map["extensions"] = base::BindRepeating(&IgnoreCapability);
-
-  parser_map["perfLoggingPrefs"] = base::BindRepeating(&ParsePerfLoggingPrefs);
-  parser_map["devToolsEventsToLog"] =
-      base::BindRepeating(&ParseDevToolsEventsLoggingPrefs);
-  parser_map["windowTypes"] = base::BindRepeating(&ParseWindowTypes);
-  // Compliance is read when session is initialized and correct response is
-  // sent if not parsed correctly.
-  parser_map["w3c"] = base::BindRepeating(&IgnoreCapability);
-
-  if (is_android) {
-    parser_map["androidActivity"] =
-        base::BindRepeating(&ParseString, &capabilities->android_activity);
-    parser_map["androidDeviceSerial"] =
-        base::BindRepeating(&ParseString, &capabilities->android_device_serial);
-    parser_map["androidPackage"] =
-        base::BindRepeating(&ParseString, &capabilities->android_package);
-    parser_map["androidProcess"] =
-        base::BindRepeating(&ParseString, &capabilities->android_process);
-    parser_map["androidExecName"] =
-        base::BindRepeating(&ParseString, &capabilities->android_exec_name);
-    parser_map["androidDeviceSocket"] =
-        base::BindRepeating(&ParseString, &capabilities->android_device_socket);
-    parser_map["androidUseRunningApp"] = base::BindRepeating(
-        &ParseBoolean, &capabilities->android_use_running_app);
-    parser_map["androidDevToolsPort"] = base::BindRepeating(
-        &ParsePortNumber, &capabilities->android_devtools_port);
-    parser_map["args"] = base::BindRepeating(&ParseSwitches);
-    parser_map["excludeSwitches"] = base::BindRepeating(&ParseExcludeSwitches);
-    parser_map["loadAsync"] =
-        base::BindRepeating(&IgnoreDeprecatedOption, "loadAsync");
-  } else if (is_remote) {
-    parser_map["debuggerAddress"] =
-        base::BindRepeating(&ParseNetAddress, &capabilities->debugger_address);
-  } else {
-    parser_map["args"] = base::BindRepeating(&ParseSwitches);
-    parser_map["binary"] =
-        base::BindRepeating(&ParseFilePath, &capabilities->binary);
-    parser_map["detach"] =
-        base::BindRepeating(&ParseBoolean, &capabilities->detach);
-    parser_map["excludeSwitches"] = base::BindRepeating(&ParseExcludeSwitches);
-    parser_map["extensions"] = base::BindRepeating(&ParseExtensions);
-    parser_map["extensionLoadTimeout"] = base::BindRepeating(
-        &ParseTimeDelta, &capabilities->extension_load_timeout);
-    parser_map["loadAsync"] =
-        base::BindRepeating(&IgnoreDeprecatedOption, "loadAsync");
-    parser_map["localState"] =
-        base::BindRepeating(&ParseDict, &capabilities->local_state);
-    parser_map["logPath"] = base::BindRepeating(&ParseLogPath);
-    parser_map["minidumpPath"] =
-        base::BindRepeating(&ParseString, &capabilities->minidump_path);
-    parser_map["mobileEmulation"] = base::BindRepeating(&ParseMobileEmulation);
-    parser_map["prefs"] = base::BindRepeating(&ParseDict, &capabilities->prefs);
-    parser_map["useAutomationExtension"] =
-        base::BindRepeating(&IgnoreDeprecatedOption, "useAutomationExtension");
-  }
+  // The 'args', 'binary' and 'extensions' options are ignored in the modes
+  // that cannot honor them, since the Java client always passes them.
+  // Compliance ('w3c') is read when the session is initialized, so here it
+  // is only accepted, not consumed.
+  static const CapabilitySchemaEntry kChromeOptionsSchema[] = {
+      {"androidActivity", kChromeModeAndroid,
+       &ParseStringMember<&Capabilities::android_activity>},
+      {"androidDeviceSerial", kChromeModeAndroid,
+       &ParseStringMember<&Capabilities::android_device_serial>},
+      {"androidDeviceSocket", kChromeModeAndroid,
+       &ParseStringMember<&Capabilities::android_device_socket>},
+      {"androidDevToolsPort", kChromeModeAndroid,
+       &ParsePortNumberMember<&Capabilities::android_devtools_port>},
+      {"androidExecName", kChromeModeAndroid,
+       &ParseStringMember<&Capabilities::android_exec_name>},
+      {"androidPackage", kChromeModeAndroid,
+       &ParseStringMember<&Capabilities::android_package>},
+      {"androidProcess", kChromeModeAndroid,
+       &ParseStringMember<&Capabilities::android_process>},
+      {"androidUseRunningApp", kChromeModeAndroid,
+       &ParseBooleanMember<&Capabilities::android_use_running_app>},
+      {"args", kChromeModeAndroid | kChromeModeDesktop, &ParseSwitches},
+      {"args", kChromeModeRemote, &IgnoreCapability},
+      {"binary", kChromeModeDesktop,
+       &ParseFilePathMember<&Capabilities::binary>},
+      {"binary", kChromeModeAndroid | kChromeModeRemote, &IgnoreCapability},
+      {"debuggerAddress", kChromeModeRemote,
+       &ParseNetAddressMember<&Capabilities::debugger_address>},
+      {"detach", kChromeModeDesktop,
+       &ParseBooleanMember<&Capabilities::detach>},
+      {"devToolsEventsToLog", kChromeModeAny,
+       &ParseDevToolsEventsLoggingPrefs},
+      {"excludeSwitches", kChromeModeAndroid | kChromeModeDesktop,
+       &ParseExcludeSwitches},
+      {"extensionLoadTimeout", kChromeModeDesktop,
+       &ParseTimeDeltaMember<&Capabilities::extension_load_timeout>},
+      {"extensions", kChromeModeDesktop, &ParseExtensions},
+      {"extensions", kChromeModeAndroid | kChromeModeRemote,
+       &IgnoreCapability},
+      {"fastTyping", kChromeModeAny,
+       &ParseBooleanMember<&Capabilities::fast_typing>},
+      {"loadAsync", kChromeModeAndroid | kChromeModeDesktop,
+       &IgnoreDeprecatedLoadAsync},
+      {"localState", kChromeModeDesktop,
+       &ParseDictMember<&Capabilities::local_state>},
+      {"logPath", kChromeModeDesktop, &ParseLogPath},
+      {"minidumpPath", kChromeModeDesktop,
+       &ParseStringMember<&Capabilities::minidump_path>},
+      {"mobileEmulation", kChromeModeDesktop, &ParseMobileEmulation},
+      {"perfLoggingPrefs", kChromeModeAny, &ParsePerfLoggingPrefs},
+      {"prefs", kChromeModeDesktop, &ParseDictMember<&Capabilities::prefs>},
+      {"priority", kChromeModeAny, &ParseSessionPriority},
+      {"recoverOnCrash", kChromeModeAny,
+       &ParseBooleanMember<&Capabilities::recover_on_crash>},
+      {"steppedTouchGestures", kChromeModeAny,
+       &ParseBooleanMember<&Capabilities::stepped_touch_gestures>},
+      {"traceDriver", kChromeModeAny,
+       &ParseBooleanMember<&Capabilities::trace_driver>},
+      {"useAutomationExtension", kChromeModeDesktop,
+       &IgnoreDeprecatedUseAutomationExtension},
+      {"w3c", kChromeModeAny, &IgnoreCapability},
+  };
+
+  uint8_t mode = kChromeModeDesktop;
+  if (chrome_options->HasKey("androidPackage"))
+    mode = kChromeModeAndroid;
+  else if (chrome_options->HasKey("debuggerAddress"))
+    mode = kChromeModeRemote;
 
   for (base::DictionaryValue::Iterator it(*chrome_options); !it.IsAtEnd();
        it.Advance()) {
-    if (parser_map.find(it.key()) == parser_map.end()) {
+    const CapabilitySchemaEntry* entry = FindSchemaEntry(
+        kChromeOptionsSchema, base::size(kChromeOptionsSchema), it.key(),
+        mode);
+    if (!entry) {
       return Status(
           kInvalidArgument,
           base::StringPrintf("unrecognized %s option: %s",
                              base::ToLowerASCII(kBrowserShortName).c_str(),
                              it.key().c_str()));
     }
-    Status status = parser_map[it.key()].Run(it.value(), capabilities);
+    Status status = entry->parse(it.value(), w3c_compliant, capabilities);
     if (status.IsError())
       return Status(kInvalidArgument, "cannot parse " + it.key(), status);
   }
   return Status(kOk);
 }
 
-Status ParseSeleniumOptions(
-    const base::Value& capability,
-    Capabilities* capabilities) {
-  const base::DictionaryValue* selenium_options = NULL;
+Status ParseSeleniumOptions(const base::Value& capability,
+                            bool w3c_compliant,
+                            Capabilities* capabilities) {
+  const base::DictionaryValue* selenium_options = nullptr;
   if (!capability.GetAsDictionary(&selenium_options))
     return Status(kInvalidArgument, "must be a dictionary");
-  std::map<std::string, Parser> parser_map;
-  parser_map["loggingPrefs"] = base::BindRepeating(&ParseLoggingPrefs);
-
+  // Only loggingPrefs is consumed; the other se:options entries belong to
+  // other components and are ignored.
   for (base::DictionaryValue::Iterator it(*selenium_options); !it.IsAtEnd();
        it.Advance()) {
-    if (parser_map.find(it.key()) == parser_map.end())
+    if (it.key() != "loggingPrefs")
       continue;
-    Status status = parser_map[it.key()].Run(it.value(), capabilities);
+    Status status = ParseLoggingPrefs(it.value(), w3c_compliant, capabilities);
     if (status.IsError())
       return Status(kInvalidArgument, "cannot parse " + it.key(), status);
   }
   return Status(kOk);
 }
+
 }  // namespace
 
 bool GetChromeOptionsDictionary(const base::DictionaryValue& params,
@@ -770,7 +922,11 @@ PerfLoggingPrefs::PerfLoggingPrefs()
     : network(InspectorDomainStatus::kDefaultEnabled),
       page(InspectorDomainStatus::kDefaultEnabled),
       trace_categories(),
-      buffer_usage_reporting_interval(1000) {}
+      buffer_usage_reporting_interval(1000),
+      spool_trace_events(false),
+      event_sampling_interval(1),
+      session_sampling_factor(1),
+      capture_byte_limit(0) {}
 
 PerfLoggingPrefs::~PerfLoggingPrefs() {}
 
@@ -780,8 +936,14 @@ Capabilities::Capabilities()
       strict_file_interactability(false),
       android_use_running_app(false),
       detach(false),
+      fast_typing(false),
       extension_load_timeout(base::TimeDelta::FromSeconds(10)),
-      network_emulation_enabled(false) {}
+      log_buffer_size(0),
+      low_priority(false),
+      network_emulation_enabled(false),
+      stepped_touch_gestures(false),
+      recover_on_crash(false),
+      trace_driver(false) {}
 
 Capabilities::~Capabilities() {}
 
@@ -795,101 +957,115 @@ bool Capabilities::IsRemoteBrowser() const {
 
 Status Capabilities::Parse(const base::DictionaryValue& desired_caps,
                            bool w3c_compliant) {
-  std::map<std::string, Parser> parser_map;
-
-  // W3C defined capabilities.
-  parser_map["acceptInsecureCerts"] =
-      base::BindRepeating(&ParseBoolean, &accept_insecure_certs);
-  parser_map["browserName"] = base::BindRepeating(&ParseString, &browser_name);
-  parser_map["browserVersion"] =
-      base::BindRepeating(&ParseString, &browser_version);
-  parser_map["platformName"] =
-      base::BindRepeating(&ParseString, &platform_name);
-  parser_map["pageLoadStrategy"] = base::BindRepeating(&ParsePageLoadStrategy);
-  parser_map["proxy"] = base::BindRepeating(&ParseProxy, w3c_compliant);
-  parser_map["timeouts"] = base::BindRepeating(&ParseTimeouts);
-  parser_map["strictFileInteractability"] =
-      base::BindRepeating(&ParseBoolean, &strict_file_interactability);
-  parser_map["webSocketUrl"] =
-      base::BindRepeating(&ParseBoolean, &webSocketUrl);
-  if (!w3c_compliant) {
-    // TODO(https://crbug.com/chromedriver/2596): "unexpectedAlertBehaviour" is
-    // legacy name of "unhandledPromptBehavior", remove when we stop supporting
-    // legacy mode.
-    parser_map["unexpectedAlertBehaviour"] =
-        base::BindRepeating(&ParseUnhandledPromptBehavior);
-  }
-  parser_map["unhandledPromptBehavior"] =
-      base::BindRepeating(&ParseUnhandledPromptBehavior);
-
-  // W3C defined extension capabilities.
-  // See https://w3c.github.io/webauthn/#sctn-automation-webdriver-capability
-  parser_map["webauthn:virtualAuthenticators"] =
-      base::BindRepeating(&ParseBoolean, nullptr);
-  parser_map["webauthn:extension:largeBlob"] =
-      base::BindRepeating(&ParseBoolean, nullptr);
-
-  // ChromeDriver specific capabilities.
-  // Vendor-prefixed is the current spec conformance, but unprefixed is
-  // still supported in legacy mode.
+  // goog:loggingPrefs; assembled once since the prefix is a branding
+  // constant, then referenced by the schema below.
+  static const std::string& prefixed_logging_prefs_key = *new std::string(
+      base::StringPrintf("%s:loggingPrefs", kChromeDriverCompanyPrefix));
+
+  static const CapabilitySchemaEntry kCapabilitiesSchema[] = {
+      // W3C defined capabilities.
+      {"acceptInsecureCerts", kModeAny,
+       &ParseBooleanMember<&Capabilities::accept_insecure_certs>},
+      {"browserName", kModeAny,
+       &ParseStringMember<&Capabilities::browser_name>},
+      {"browserVersion", kModeAny,
+       &ParseStringMember<&Capabilities::browser_version>},
+      {"platformName", kModeAny,
+       &ParseStringMember<&Capabilities::platform_name>},
+      {"pageLoadStrategy", kModeAny, &ParsePageLoadStrategy},
+      {"proxy", kModeAny, &ParseProxy},
+      {"timeouts", kModeAny, &ParseTimeouts},
+      {"strictFileInteractability", kModeAny,
+       &ParseBooleanMember<&Capabilities::strict_file_interactability>},
+      {"webSocketUrl", kModeAny,
+       &ParseBooleanMember<&Capabilities::webSocketUrl>},
+      // TODO(https://crbug.com/chromedriver/2596): "unexpectedAlertBehaviour"
+      // is legacy name of "unhandledPromptBehavior", remove when we stop
+      // supporting legacy mode.
+      {"unexpectedAlertBehaviour", kModeLegacy, &ParseUnhandledPromptBehavior},
+      {"unhandledPromptBehavior", kModeAny, &ParseUnhandledPromptBehavior},
+      // W3C defined extension capabilities.
+      // See https://w3c.github.io/webauthn/#sctn-automation-webdriver-capability
+      {"webauthn:virtualAuthenticators", kModeAny, &ParseIgnoredBoolean},
+      {"webauthn:extension:largeBlob", kModeAny, &ParseIgnoredBoolean},
+      // ChromeDriver specific capabilities. Vendor-prefixed is the current
+      // spec conformance, but unprefixed is still supported in legacy mode.
+      {kChromeDriverOptionsKeyPrefixed, kModePrefixedChromeOptions,
+       &ParseChromeOptions},
+      {kChromeDriverOptionsKey, kModeUnprefixedChromeOptions,
+       &ParseChromeOptions},
+      {"se:options", kModeSeleniumLoggingPrefs, &ParseSeleniumOptions},
+      {prefixed_logging_prefs_key.c_str(), kModePrefixedLoggingPrefs,
+       &ParseLoggingPrefs},
+      {"loggingPrefs", kModeUnprefixedLoggingPrefs, &ParseLoggingPrefs},
+      // Network emulation requires device mode, which is only enabled when
+      // mobile emulation is on.
+      {"networkConnectionEnabled", kModeMobileEmulation,
+       &ParseBooleanMember<&Capabilities::network_emulation_enabled>},
+  };
+
+  // Resolve the data-dependent schema modes once, before the pass.
+  uint8_t modes = w3c_compliant ? kModeW3c : kModeLegacy;
   if (w3c_compliant ||
       desired_caps.GetDictionary(kChromeDriverOptionsKeyPrefixed, nullptr)) {
-    parser_map[kChromeDriverOptionsKeyPrefixed] =
-        base::BindRepeating(&ParseChromeOptions);
+    modes |= kModePrefixedChromeOptions;
   } else {
-    parser_map[kChromeDriverOptionsKey] =
-        base::BindRepeating(&ParseChromeOptions);
+    modes |= kModeUnprefixedChromeOptions;
   }
   // se:options.loggingPrefs and goog:loggingPrefs is spec-compliant name,
   // but loggingPrefs is still supported in legacy mode.
-  const std::string prefixedLoggingPrefsKey =
-      base::StringPrintf("%s:loggingPrefs", kChromeDriverCompanyPrefix);
   if (desired_caps.GetDictionary("se:options.loggingPrefs", nullptr)) {
-    parser_map["se:options"] = base::BindRepeating(&ParseSeleniumOptions);
+    modes |= kModeSeleniumLoggingPrefs;
   } else if (w3c_compliant ||
-             desired_caps.GetDictionary(prefixedLoggingPrefsKey, nullptr)) {
-    parser_map[prefixedLoggingPrefsKey] =
-        base::BindRepeating(&ParseLoggingPrefs);
+             desired_caps.GetDictionary(prefixed_logging_prefs_key, nullptr)) {
+    modes |= kModePrefixedLoggingPrefs;
   } else {
-    parser_map["loggingPrefs"] = base::BindRepeating(&ParseLoggingPrefs);
+    modes |= kModeUnprefixedLoggingPrefs;
   }
-  // Network emulation requires device mode, which is only enabled when
-  // mobile emulation is on.
-
   const base::DictionaryValue* chrome_options = nullptr;
   if (GetChromeOptionsDictionary(desired_caps, &chrome_options) &&
       chrome_options->GetDictionary("mobileEmulation", nullptr)) {
-    parser_map["networkConnectionEnabled"] =
-        base::BindRepeating(&ParseBoolean, &network_emulation_enabled);
+    modes |= kModeMobileEmulation;
   }
 
+  // A single pass over the dictionary; every invalid capability is collected
+  // so a client fixing its request sees all the problems at once.
+  std::vector<Status> errors;
   for (base::DictionaryValue::Iterator it(desired_caps); !it.IsAtEnd();
        it.Advance()) {
     if (it.value().is_none())
       continue;
-    if (parser_map.find(it.key()) == parser_map.end()) {
+    const CapabilitySchemaEntry* entry =
+        FindSchemaEntry(kCapabilitiesSchema, base::size(kCapabilitiesSchema),
+                        it.key(), modes);
+    if (!entry) {
       // The specified capability is unrecognized. W3C spec requires us to
       // return an error if capability does not contain ":".
       // In legacy mode, for backward compatibility reasons,
       // we ignore unrecognized capabilities.
-      if (w3c_compliant && it.key().find(':') == std::string::npos)
-        return Status(kInvalidArgument, "unrecognized capability: " + it.key());
-      else
-        continue;
+      if (w3c_compliant && it.key().find(':') == std::string::npos) {
+        errors.push_back(
+            Status(kInvalidArgument, "unrecognized capability: " + it.key()));
+      }
+      continue;
     }
-    Status status = parser_map[it.key()].Run(it.value(), this);
+    Status status = entry->parse(it.value(), w3c_compliant, this);
     if (status.IsError()) {
-      return Status(kInvalidArgument, "cannot parse capability: " + it.key(),
-                    status);
+      errors.push_back(Status(kInvalidArgument,
+                              "cannot parse capability: " + it.key(), status));
     }
   }
+  if (!errors.empty()) {
+    Status result = errors[0];
+    for (size_t i = 1; i < errors.size(); ++i)
+      result.AddDetails(errors[i].message());
+    return result;
+  }
   // Perf log must be enabled if perf log prefs are specified; otherwise, error.
   LoggingPrefs::const_iterator iter = logging_prefs.find(
       WebDriverLog::kPerformanceType);
   if (iter == logging_prefs.end() || iter->second == Log::kOff) {
-    const base::DictionaryValue* chrome_options = nullptr;
-    if (GetChromeOptionsDictionary(desired_caps, &chrome_options) &&
-        chrome_options->HasKey("perfLoggingPrefs")) {
+    if (chrome_options && chrome_options->HasKey("perfLoggingPrefs")) {
       return Status(kInvalidArgument,
                     "perfLoggingPrefs specified, "
                     "but performance logging was not enabled");
@@ -899,9 +1075,7 @@ Status Capabilities::Parse(const base::DictionaryValue& desired_caps,
       WebDriverLog::kDevToolsType);
   if (dt_events_logging_iter == logging_prefs.end()
       || dt_events_logging_iter->second == Log::kOff) {
-    const base::DictionaryValue* chrome_options = nullptr;
-    if (GetChromeOptionsDictionary(desired_caps, &chrome_options) &&
-        chrome_options->HasKey("devToolsEventsToLog")) {
+    if (chrome_options && chrome_options->HasKey("devToolsEventsToLog")) {
       return Status(kInvalidArgument,
                     "devToolsEventsToLog specified, "
                     "but devtools events logging was not enabled");
@@ -83,6 +83,22 @@ struct PerfLoggingPrefs {
 
   std::string trace_categories;  // Non-empty string enables tracing.
   int buffer_usage_reporting_interval;  // ms between trace buffer usage events.
+  // Spool trace events to a compressed temp file instead of buffering them in
+  // memory until the log is fetched.
+  bool spool_trace_events;
+
+  // Log only every Nth Network/Page event; 1 (the default) logs every
+  // event. Trace events are not sampled.
+  int event_sampling_interval;
+
+  // Attach capture to only 1 in this many sessions, chosen at random when
+  // the session's logs are created; unsampled sessions keep an empty
+  // performance log. 1 (the default) captures every session.
+  int session_sampling_factor;
+
+  // Approximate cap, in bytes of formatted log entries, after which capture
+  // self-disables for the rest of the session; 0 (the default) means no cap.
+  int capture_byte_limit;
 };
 
 struct Capabilities {
@@ -161,6 +177,11 @@ struct Capabilities {
 
   std::vector<std::string> extensions;
 
+  // Whether Send Keys delivers plain-text runs with a single
+  // Input.insertText call instead of per-character key-event synthesis.
+  // Special keys and modified text still go through real key events.
+  bool fast_typing;
+
   // Time to wait for extension background page to appear. If 0, no waiting.
   base::TimeDelta extension_load_timeout;
 
@@ -170,6 +191,15 @@ struct Capabilities {
 
   LoggingPrefs logging_prefs;
 
+  // Maximum number of entries each WebDriver log buffers between retrievals,
+  // from the "bufferSize" key in loggingPrefs; 0 means use the default.
+  int log_buffer_size;
+
+  // Whether the session declared itself bulk traffic via the "priority"
+  // chrome option ("batch"). Such sessions yield to interactive sessions in
+  // the driver's schedulers; the default ("interactive") leaves this false.
+  bool low_priority;
+
   // If set, enable minidump for chrome crashes and save to this directory.
   std::string minidump_path;
 
@@ -177,12 +207,26 @@ struct Capabilities {
 
   PerfLoggingPrefs perf_logging_prefs;
 
+  // Whether touch flick falls back to the legacy stepped
+  // Input.dispatchTouchEvent sequence instead of a single browser-side
+  // synthetic gesture.
+  bool stepped_touch_gestures;
+
   std::unique_ptr<base::ListValue> devtools_events_logging_prefs;
 
   std::unique_ptr<base::DictionaryValue> prefs;
 
+  // Whether a page or browser crash relaunches the browser in place and
+  // restores recoverable session state instead of deleting the session;
+  // from the "recoverOnCrash" chromeOptions capability.
+  bool recover_on_crash;
+
   Switches switches;
 
+  // Whether to record spans of the driver's own dispatch path; see
+  // DriverTracing. Process-wide once enabled by any session.
+  bool trace_driver;
+
   std::set<WebViewInfo::Type> window_types;
 
   bool webSocketUrl = false;
@@ -120,6 +120,18 @@ TEST(ParseCapabilities, UnknownCapabilityW3c) {
   ASSERT_EQ(status.code(), kInvalidArgument);
 }
 
+TEST(ParseCapabilities, AllErrorsReportedInOnePass) {
+  // Every invalid capability is reported, not just the first one found.
+  Capabilities capabilities;
+  base::DictionaryValue caps;
+  caps.SetInteger("acceptInsecureCerts", 1);
+  caps.SetString("foo", "bar");
+  Status status = capabilities.Parse(caps);
+  ASSERT_EQ(status.code(), kInvalidArgument);
+  ASSERT_NE(std::string::npos, status.message().find("acceptInsecureCerts"));
+  ASSERT_NE(std::string::npos, status.message().find("foo"));
+}
+
 TEST(ParseCapabilities, WithAndroidPackage) {
   Capabilities capabilities;
   base::DictionaryValue caps;
@@ -155,6 +167,40 @@ TEST(ParseCapabilities, LogPath) {
   ASSERT_STREQ("path/to/logfile", capabilities.log_path.c_str());
 }
 
+TEST(ParseCapabilities, SessionPriorityDefaultsToInteractive) {
+  Capabilities capabilities;
+  base::DictionaryValue caps;
+  Status status = capabilities.Parse(caps);
+  ASSERT_TRUE(status.IsOk());
+  ASSERT_FALSE(capabilities.low_priority);
+}
+
+TEST(ParseCapabilities, SessionPriorityBatch) {
+  Capabilities capabilities;
+  base::DictionaryValue caps;
+  caps.SetString("goog:chromeOptions.priority", "batch");
+  Status status = capabilities.Parse(caps);
+  ASSERT_TRUE(status.IsOk());
+  ASSERT_TRUE(capabilities.low_priority);
+}
+
+TEST(ParseCapabilities, SessionPriorityInteractive) {
+  Capabilities capabilities;
+  base::DictionaryValue caps;
+  caps.SetString("goog:chromeOptions.priority", "interactive");
+  Status status = capabilities.Parse(caps);
+  ASSERT_TRUE(status.IsOk());
+  ASSERT_FALSE(capabilities.low_priority);
+}
+
+TEST(ParseCapabilities, SessionPriorityInvalid) {
+  Capabilities capabilities;
+  base::DictionaryValue caps;
+  caps.SetString("goog:chromeOptions.priority", "urgent");
+  Status status = capabilities.Parse(caps);
+  ASSERT_FALSE(status.IsOk());
+}
+
 TEST(ParseCapabilities, Args) {
   Capabilities capabilities;
   base::Value::ListStorage args;
@@ -8,6 +8,8 @@
 #include <string>
 #include <vector>
 
+#include "base/callback.h"
+
 class Status;
 
 class Adb {
@@ -24,6 +26,9 @@ class Adb {
                                     const std::string& command_line_file,
                                     const std::string& exec_name,
                                     const std::string& args) = 0;
+  virtual Status SendFile(const std::string& device_serial,
+                          const std::string& filename,
+                          const std::string& content) = 0;
   virtual Status CheckAppInstalled(const std::string& device_serial,
                                    const std::string& package) = 0;
   virtual Status ClearAppData(const std::string& device_serial,
@@ -41,6 +46,17 @@ class Adb {
   virtual Status GetSocketByPattern(const std::string& device_serial,
                                     const std::string& grep_pattern,
                                     std::string* socket_name) = 0;
+  // Opens one long-lived logcat stream for the device and delivers each
+  // complete output line to |on_line| on the adb IO thread. Opening a serial
+  // that is already streaming reuses the existing stream, so there is at
+  // most one logcat pipe per device regardless of how many sessions read
+  // from it.
+  virtual Status OpenLogcatStream(
+      const std::string& device_serial,
+      const base::RepeatingCallback<void(const std::string&)>& on_line) = 0;
+  // Closes the logcat stream for the device, if one is open. |on_line| may
+  // still run for lines already in flight on the IO thread.
+  virtual Status CloseLogcatStream(const std::string& device_serial) = 0;
 };
 
 #endif  // CHROME_TEST_CHROMEDRIVER_CHROME_ADB_H_
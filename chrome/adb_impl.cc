@@ -19,13 +19,16 @@
 #include "base/strings/string_tokenizer.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/task/current_thread.h"
 #include "base/time/time.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/constants/version.h"
 #include "chrome/test/chromedriver/net/adb_client_socket.h"
+#include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
+#include "net/socket/stream_socket.h"
 
 namespace {
 
@@ -109,6 +112,105 @@ std::string GetSerialFromEnvironment() {
 
 }  // namespace
 
+// Owns one long-lived "shell:logcat" socket and feeds each complete output
+// line to |on_line_|. Constructed on the caller's thread; everything else,
+// including destruction, happens on the adb IO thread. The reader deletes
+// itself once it is closed or the socket dies; deleting the socket cancels
+// any read in flight, which is what makes the Unretained binds below safe.
+class LogcatStreamReader {
+ public:
+  LogcatStreamReader(
+      int port,
+      const std::string& serial,
+      const base::RepeatingCallback<void(const std::string&)>& on_line)
+      : port_(port), serial_(serial), on_line_(on_line) {}
+
+  void Start() {
+    CHECK(base::CurrentIOThread::IsSet());
+    awaiting_socket_ = true;
+    AdbClientSocket::TransportQuery(
+        port_, serial_, "shell:logcat -v threadtime",
+        base::BindRepeating(&LogcatStreamReader::OnSocket,
+                            base::Unretained(this)));
+  }
+
+  // Stops reading. Deletion is deferred until the pending transport
+  // callback, if any, has come back.
+  void Close() {
+    closed_ = true;
+    if (!awaiting_socket_)
+      delete this;
+  }
+
+ private:
+  static const int kReadSize = 4096;
+
+  ~LogcatStreamReader() {}
+
+  void OnSocket(int result, net::StreamSocket* socket) {
+    awaiting_socket_ = false;
+    socket_.reset(socket);
+    if (closed_ || result < 0 || !socket_) {
+      if (!closed_) {
+        LOG(WARNING) << "logcat stream for device " << serial_
+                     << " failed to open: " << net::ErrorToString(result);
+      }
+      delete this;
+      return;
+    }
+    buffer_ = base::MakeRefCounted<net::IOBuffer>(kReadSize);
+    ReadMore();
+  }
+
+  void ReadMore() {
+    while (true) {
+      int result = socket_->Read(
+          buffer_.get(), kReadSize,
+          base::BindOnce(&LogcatStreamReader::OnRead, base::Unretained(this)));
+      if (result == net::ERR_IO_PENDING)
+        return;
+      if (!ProcessResult(result))
+        return;
+    }
+  }
+
+  void OnRead(int result) {
+    if (ProcessResult(result))
+      ReadMore();
+  }
+
+  // Appends the read bytes and runs |on_line_| for each completed line.
+  // Returns false once the stream has ended and the reader deleted itself.
+  bool ProcessResult(int result) {
+    if (result <= 0) {
+      delete this;
+      return false;
+    }
+    pending_.append(buffer_->data(), result);
+    size_t start = 0;
+    size_t eol;
+    while ((eol = pending_.find('\n', start)) != std::string::npos) {
+      size_t length = eol - start;
+      if (length > 0 && pending_[eol - 1] == '\r')
+        length--;
+      if (length > 0)
+        on_line_.Run(pending_.substr(start, length));
+      start = eol + 1;
+    }
+    pending_.erase(0, start);
+    return true;
+  }
+
+  const int port_;
+  const std::string serial_;
+  const base::RepeatingCallback<void(const std::string&)> on_line_;
+  bool awaiting_socket_ = false;
+  bool closed_ = false;
+  std::unique_ptr<net::StreamSocket> socket_;
+  scoped_refptr<net::IOBuffer> buffer_;
+  std::string pending_;
+};
+
 AdbImpl::AdbImpl(
     const scoped_refptr<base::SingleThreadTaskRunner>& io_task_runner,
     int port)
@@ -196,17 +298,23 @@ Status AdbImpl::SetCommandLineFile(const std::string& device_serial,
                                    const std::string& command_line_file,
                                    const std::string& exec_name,
                                    const std::string& args) {
+  VLOG(1) << "Sending command line file: " << command_line_file;
+  return SendFile(device_serial, command_line_file,
+                  exec_name + " " + args + "\n");
+}
+
+Status AdbImpl::SendFile(const std::string& device_serial,
+                         const std::string& filename,
+                         const std::string& content) {
   std::string response;
-  std::string command(exec_name + " " + args + "\n");
   scoped_refptr<ResponseBuffer> response_buffer = new ResponseBuffer;
-  VLOG(1) << "Sending command line file: " << command_line_file;
   io_task_runner_->PostTask(
-      FROM_HERE,
-      base::BindOnce(&SendFileOnIOThread, device_serial, command_line_file,
-                     command, response_buffer, port_));
-  Status status =
-      response_buffer->GetResponse(&response, base::TimeDelta::FromSeconds(30));
-  return status;
+      FROM_HERE, base::BindOnce(&SendFileOnIOThread, device_serial, filename,
+                                content, response_buffer, port_));
+  // Payloads can be large (e.g. test APKs), and a push over USB 2.0 to a
+  // slow device can take minutes.
+  return response_buffer->GetResponse(&response,
+                                      base::TimeDelta::FromSeconds(300));
 }
 
 Status AdbImpl::CheckAppInstalled(
@@ -330,6 +438,35 @@ Status AdbImpl::GetSocketByPattern(const std::string& device_serial,
                 "Failed to get sockets matching: " + grep_pattern);
 }
 
+Status AdbImpl::OpenLogcatStream(
+    const std::string& device_serial,
+    const base::RepeatingCallback<void(const std::string&)>& on_line) {
+  base::AutoLock lock(logcat_lock_);
+  if (logcat_readers_.count(device_serial))
+    return Status(kOk);
+  VLOG(1) << "Opening logcat stream for device: " << device_serial;
+  LogcatStreamReader* reader =
+      new LogcatStreamReader(port_, device_serial, on_line);
+  logcat_readers_[device_serial] = reader;
+  io_task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&LogcatStreamReader::Start, base::Unretained(reader)));
+  return Status(kOk);
+}
+
+Status AdbImpl::CloseLogcatStream(const std::string& device_serial) {
+  base::AutoLock lock(logcat_lock_);
+  auto it = logcat_readers_.find(device_serial);
+  if (it == logcat_readers_.end())
+    return Status(kOk);
+  VLOG(1) << "Closing logcat stream for device: " << device_serial;
+  io_task_runner_->PostTask(
+      FROM_HERE, base::BindOnce(&LogcatStreamReader::Close,
+                                base::Unretained(it->second)));
+  logcat_readers_.erase(it);
+  return Status(kOk);
+}
+
 Status AdbImpl::ExecuteCommand(
     const std::string& command, std::string* response) {
   scoped_refptr<ResponseBuffer> response_buffer = new ResponseBuffer;
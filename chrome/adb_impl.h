@@ -5,17 +5,20 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_CHROME_ADB_IMPL_H_
 #define CHROME_TEST_CHROMEDRIVER_CHROME_ADB_IMPL_H_
 
+#include <map>
 #include <string>
 #include <vector>
 
 #include "base/compiler_specific.h"
 #include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
 #include "chrome/test/chromedriver/chrome/adb.h"
 
 namespace base {
 class SingleThreadTaskRunner;
 }
 
+class LogcatStreamReader;
 class Status;
 
 class AdbImpl : public Adb {
@@ -36,6 +39,9 @@ class AdbImpl : public Adb {
                             const std::string& command_line_file,
                             const std::string& exec_name,
                             const std::string& args) override;
+  Status SendFile(const std::string& device_serial,
+                  const std::string& filename,
+                  const std::string& content) override;
   Status CheckAppInstalled(const std::string& device_serial,
                            const std::string& package) override;
   Status ClearAppData(const std::string& device_serial,
@@ -53,6 +59,11 @@ class AdbImpl : public Adb {
   Status GetSocketByPattern(const std::string& device_serial,
                             const std::string& grep_pattern,
                             std::string* socket_name) override;
+  Status OpenLogcatStream(
+      const std::string& device_serial,
+      const base::RepeatingCallback<void(const std::string&)>& on_line)
+      override;
+  Status CloseLogcatStream(const std::string& device_serial) override;
 
  private:
   Status ExecuteCommand(const std::string& command,
@@ -67,6 +78,11 @@ class AdbImpl : public Adb {
   scoped_refptr<base::SingleThreadTaskRunner> io_task_runner_;
 
   int port_;
+
+  // Open logcat streams by device serial. The readers live on the IO thread
+  // and delete themselves after Close, so only raw pointers are held here.
+  base::Lock logcat_lock_;
+  std::map<std::string, LogcatStreamReader*> logcat_readers_;
 };
 
 #endif  // CHROME_TEST_CHROMEDRIVER_CHROME_ADB_IMPL_H_
@@ -0,0 +1,195 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/allocation_tracker.h"
+
+#include "base/allocator/buildflags.h"
+
+#if BUILDFLAG(CHROMEDRIVER_TRACK_ALLOCATIONS) && BUILDFLAG(USE_ALLOCATOR_SHIM)
+#include "base/allocator/allocator_shim.h"
+#endif
+
+namespace allocation_tracker {
+
+#if BUILDFLAG(CHROMEDRIVER_TRACK_ALLOCATIONS) && BUILDFLAG(USE_ALLOCATOR_SHIM)
+
+namespace {
+
+using base::allocator::AllocatorDispatch;
+
+// Written only by the owning thread; the counters deliberately ignore
+// frees, since budgets are about allocation rate, not live size.
+thread_local uint64_t tls_allocs = 0;
+thread_local uint64_t tls_bytes = 0;
+
+void RecordAlloc(size_t size) {
+  tls_allocs++;
+  tls_bytes += size;
+}
+
+void* AllocFn(const AllocatorDispatch* self, size_t size, void* context) {
+  RecordAlloc(size);
+  return self->next->alloc_function(self->next, size, context);
+}
+
+void* AllocUncheckedFn(const AllocatorDispatch* self,
+                       size_t size,
+                       void* context) {
+  RecordAlloc(size);
+  return self->next->alloc_unchecked_function(self->next, size, context);
+}
+
+void* AllocZeroInitializedFn(const AllocatorDispatch* self,
+                             size_t n,
+                             size_t size,
+                             void* context) {
+  RecordAlloc(n * size);
+  return self->next->alloc_zero_initialized_function(self->next, n, size,
+                                                     context);
+}
+
+void* AllocAlignedFn(const AllocatorDispatch* self,
+                     size_t alignment,
+                     size_t size,
+                     void* context) {
+  RecordAlloc(size);
+  return self->next->alloc_aligned_function(self->next, alignment, size,
+                                            context);
+}
+
+void* ReallocFn(const AllocatorDispatch* self,
+                void* address,
+                size_t size,
+                void* context) {
+  RecordAlloc(size);
+  return self->next->realloc_function(self->next, address, size, context);
+}
+
+void FreeFn(const AllocatorDispatch* self, void* address, void* context) {
+  self->next->free_function(self->next, address, context);
+}
+
+size_t GetSizeEstimateFn(const AllocatorDispatch* self,
+                         void* address,
+                         void* context) {
+  return self->next->get_size_estimate_function(self->next, address, context);
+}
+
+unsigned BatchMallocFn(const AllocatorDispatch* self,
+                       size_t size,
+                       void** results,
+                       unsigned num_requested,
+                       void* context) {
+  unsigned allocated = self->next->batch_malloc_function(
+      self->next, size, results, num_requested, context);
+  tls_allocs += allocated;
+  tls_bytes += static_cast<uint64_t>(size) * allocated;
+  return allocated;
+}
+
+void BatchFreeFn(const AllocatorDispatch* self,
+                 void** to_be_freed,
+                 unsigned num_to_be_freed,
+                 void* context) {
+  self->next->batch_free_function(self->next, to_be_freed, num_to_be_freed,
+                                  context);
+}
+
+void FreeDefiniteSizeFn(const AllocatorDispatch* self,
+                        void* ptr,
+                        size_t size,
+                        void* context) {
+  self->next->free_definite_size_function(self->next, ptr, size, context);
+}
+
+void* AlignedMallocFn(const AllocatorDispatch* self,
+                      size_t size,
+                      size_t alignment,
+                      void* context) {
+  RecordAlloc(size);
+  return self->next->aligned_malloc_function(self->next, size, alignment,
+                                             context);
+}
+
+void* AlignedReallocFn(const AllocatorDispatch* self,
+                       void* address,
+                       size_t size,
+                       size_t alignment,
+                       void* context) {
+  RecordAlloc(size);
+  return self->next->aligned_realloc_function(self->next, address, size,
+                                              alignment, context);
+}
+
+void AlignedFreeFn(const AllocatorDispatch* self,
+                   void* address,
+                   void* context) {
+  self->next->aligned_free_function(self->next, address, context);
+}
+
+AllocatorDispatch g_counting_dispatch = {
+    &AllocFn,
+    &AllocUncheckedFn,
+    &AllocZeroInitializedFn,
+    &AllocAlignedFn,
+    &ReallocFn,
+    &FreeFn,
+    &GetSizeEstimateFn,
+    &BatchMallocFn,
+    &BatchFreeFn,
+    &FreeDefiniteSizeFn,
+    &AlignedMallocFn,
+    &AlignedReallocFn,
+    &AlignedFreeFn,
+    nullptr /* next */
+};
+
+bool g_installed = false;
+
+}  // namespace
+
+bool Install() {
+  // Called on the main thread at server startup or test setup, before the
+  // threads being measured exist; the dispatch chain itself is safe for
+  // concurrent allocation once inserted.
+  if (!g_installed) {
+    base::allocator::InsertAllocatorDispatch(&g_counting_dispatch);
+    g_installed = true;
+  }
+  return true;
+}
+
+Totals CurrentThreadTotals() {
+  Totals totals;
+  totals.allocs = tls_allocs;
+  totals.bytes = tls_bytes;
+  return totals;
+}
+
+#else  // !(CHROMEDRIVER_TRACK_ALLOCATIONS && USE_ALLOCATOR_SHIM)
+
+bool Install() {
+  return false;
+}
+
+Totals CurrentThreadTotals() {
+  return Totals();
+}
+
+#endif
+
+ScopedThreadAllocationCounter::ScopedThreadAllocationCounter()
+    : start_(CurrentThreadTotals()) {}
+
+ScopedThreadAllocationCounter::~ScopedThreadAllocationCounter() = default;
+
+Totals ScopedThreadAllocationCounter::Delta() const {
+  Totals now = CurrentThreadTotals();
+  Totals delta;
+  delta.allocs = now.allocs - start_.allocs;
+  delta.bytes = now.bytes - start_.bytes;
+  return delta;
+}
+
+}  // namespace allocation_tracker
@@ -0,0 +1,53 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_CHROME_ALLOCATION_TRACKER_H_
+#define CHROME_TEST_CHROMEDRIVER_CHROME_ALLOCATION_TRACKER_H_
+
+#include <stdint.h>
+
+#include "chrome/test/chromedriver/allocation_tracker_buildflags.h"
+
+// Per-thread heap allocation counting, compiled in only when the
+// chromedriver_track_allocations gn arg is set. Used to attribute
+// allocation counts and bytes to individual WebDriver commands and
+// DevTools messages, and to enforce allocation budgets in the unittests
+// so a change that doubles allocation rates fails before it ships.
+namespace allocation_tracker {
+
+// Heap activity on one thread: operation count and requested bytes.
+struct Totals {
+  uint64_t allocs = 0;
+  uint64_t bytes = 0;
+};
+
+// Hooks the allocator shim so per-thread totals are collected from this
+// point on. Idempotent. Returns false (and does nothing) when the build
+// was configured without chromedriver_track_allocations or without the
+// allocator shim. Must be called before other threads start allocating
+// heavily for totals to be comparable across runs.
+bool Install();
+
+// Totals for the calling thread since Install(). All zeros when tracking
+// is unavailable.
+Totals CurrentThreadTotals();
+
+// Measures heap activity on the calling thread within a scope, e.g. one
+// command execution or one DevTools message. Cheap enough to construct
+// unconditionally; Delta() is all zeros when tracking is off.
+class ScopedThreadAllocationCounter {
+ public:
+  ScopedThreadAllocationCounter();
+  ~ScopedThreadAllocationCounter();
+
+  // Allocations made on this thread since construction.
+  Totals Delta() const;
+
+ private:
+  Totals start_;
+};
+
+}  // namespace allocation_tracker
+
+#endif  // CHROME_TEST_CHROMEDRIVER_CHROME_ALLOCATION_TRACKER_H_
@@ -0,0 +1,89 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/ax_node_cache.h"
+
+#include "chrome/test/chromedriver/chrome/devtools_client.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+
+namespace {
+
+// Entries beyond this are unlikely to be re-read before the page mutates;
+// the cache is cleared wholesale rather than tracking usage order.
+const size_t kMaxCachedAXNodes = 1024;
+
+}  // namespace
+
+AXNodeCache::AXNodeCache(DevToolsClient* client)
+    : client_(client), observing_mutations_(false) {
+  client->AddListener(this);
+}
+
+AXNodeCache::~AXNodeCache() {}
+
+bool AXNodeCache::GetAXNode(int node_id, base::Value* ax_node) {
+  auto it = nodes_.find(node_id);
+  if (it == nodes_.end())
+    return false;
+  *ax_node = it->second.Clone();
+  return true;
+}
+
+void AXNodeCache::PutAXNode(int node_id, const base::Value& ax_node) {
+  if (!observing_mutations_) {
+    // Mutation events are only streamed once the DOM domain is enabled;
+    // without them a cached node could go stale unnoticed, so on failure
+    // the node is simply not cached. The browser emits mutation events for
+    // nodes this client knows about, which covers every id cached here:
+    // they were all pushed to us when the element was resolved to a node.
+    if (client_->EnableDomain("DOM").IsError())
+      return;
+    observing_mutations_ = true;
+  }
+  if (nodes_.size() >= kMaxCachedAXNodes)
+    nodes_.clear();
+  nodes_[node_id] = ax_node.Clone();
+}
+
+Status AXNodeCache::OnConnected(DevToolsClient* client) {
+  // A (re)connect resets the browser-side domain state, so mutation events
+  // stop flowing until the next PutAXNode enables the domain again.
+  nodes_.clear();
+  observing_mutations_ = false;
+  return Status(kOk);
+}
+
+Status AXNodeCache::OnEvent(DevToolsClient* client,
+                            const std::string& method,
+                            const base::DictionaryValue& params) {
+  if (method == "DOM.documentUpdated") {
+    nodes_.clear();
+    return Status(kOk);
+  }
+  // Mutation events name the mutated node and, for child-list changes, its
+  // parent; both are evicted. A node's computed label derives from its
+  // attributes and subtree, so a deep mutation can in principle change an
+  // ancestor's label without an event naming the ancestor - accepted here,
+  // since audit suites read each element right after resolving it and the
+  // mutated element itself is always evicted.
+  if (method == "DOM.attributeModified" ||
+      method == "DOM.characterDataModified" ||
+      method == "DOM.childNodeCountUpdated" ||
+      method == "DOM.childNodeInserted" || method == "DOM.childNodeRemoved") {
+    int node_id;
+    if (params.GetInteger("nodeId", &node_id))
+      nodes_.erase(node_id);
+    if (params.GetInteger("parentNodeId", &node_id))
+      nodes_.erase(node_id);
+    return Status(kOk);
+  }
+  // Any other DOM event (e.g. DOM.setChildNodes pushing a fresh subtree)
+  // signals state this cache does not model; drop everything.
+  nodes_.clear();
+  return Status(kOk);
+}
+
+std::vector<std::string> AXNodeCache::SubscribedMethodPrefixes() const {
+  return {"DOM."};
+}
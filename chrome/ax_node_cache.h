@@ -0,0 +1,57 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_CHROME_AX_NODE_CACHE_H_
+#define CHROME_TEST_CHROMEDRIVER_CHROME_AX_NODE_CACHE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/values.h"
+#include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
+
+class DevToolsClient;
+class Status;
+
+// Caches the accessibility nodes fetched per DOM node id, so audit suites
+// that read the computed label and role of every element on a page do not
+// re-fetch overlapping Accessibility.getPartialAXTree fragments for
+// unchanged elements. Caching is pay-as-you-go: the DOM domain is only
+// enabled once the first node is cached, so sessions that never read
+// accessibility state are not streamed DOM mutation events. Mutation
+// events evict the mutated node and its parent; anything coarser
+// (navigation, document replacement) clears the cache outright.
+class AXNodeCache : public DevToolsEventListener {
+ public:
+  explicit AXNodeCache(DevToolsClient* client);
+  ~AXNodeCache() override;
+
+  // Returns true and copies the cached accessibility node for |node_id|
+  // into |ax_node|.
+  bool GetAXNode(int node_id, base::Value* ax_node);
+
+  // Caches the accessibility node for |node_id|. The first call enables
+  // the DOM domain so mutation events invalidate stale entries from then
+  // on; an entry is never served before that enablement is acknowledged.
+  void PutAXNode(int node_id, const base::Value& ax_node);
+
+  // DevToolsEventListener:
+  Status OnConnected(DevToolsClient* client) override;
+  Status OnEvent(DevToolsClient* client,
+                 const std::string& method,
+                 const base::DictionaryValue& params) override;
+  std::vector<std::string> SubscribedMethodPrefixes() const override;
+
+ private:
+  DevToolsClient* client_;
+  // True once the DOM domain has been enabled for invalidation events.
+  bool observing_mutations_;
+  std::map<int, base::Value> nodes_;
+
+  DISALLOW_COPY_AND_ASSIGN(AXNodeCache);
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_CHROME_AX_NODE_CACHE_H_
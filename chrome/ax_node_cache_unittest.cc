@@ -0,0 +1,98 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/ax_node_cache.h"
+
+#include "base/values.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/chrome/stub_devtools_client.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+base::Value CreateAXNode(const std::string& label) {
+  base::Value node(base::Value::Type::DICTIONARY);
+  base::Value name(base::Value::Type::DICTIONARY);
+  name.SetKey("value", base::Value(label));
+  node.SetKey("name", std::move(name));
+  return node;
+}
+
+}  // namespace
+
+TEST(AXNodeCache, PutAndGet) {
+  StubDevToolsClient client;
+  AXNodeCache cache(&client);
+  base::Value node;
+  ASSERT_FALSE(cache.GetAXNode(5, &node));
+
+  cache.PutAXNode(5, CreateAXNode("five"));
+  ASSERT_TRUE(cache.GetAXNode(5, &node));
+  ASSERT_EQ(CreateAXNode("five"), node);
+  ASSERT_FALSE(cache.GetAXNode(6, &node));
+}
+
+TEST(AXNodeCache, DocumentUpdatedClearsCache) {
+  StubDevToolsClient client;
+  AXNodeCache cache(&client);
+  cache.PutAXNode(5, CreateAXNode("five"));
+
+  base::DictionaryValue params;
+  ASSERT_EQ(kOk,
+            cache.OnEvent(&client, "DOM.documentUpdated", params).code());
+  base::Value node;
+  ASSERT_FALSE(cache.GetAXNode(5, &node));
+}
+
+TEST(AXNodeCache, MutationEvictsNodeAndParent) {
+  StubDevToolsClient client;
+  AXNodeCache cache(&client);
+  cache.PutAXNode(5, CreateAXNode("five"));
+  cache.PutAXNode(6, CreateAXNode("six"));
+  cache.PutAXNode(7, CreateAXNode("seven"));
+
+  base::DictionaryValue params;
+  params.SetInteger("nodeId", 5);
+  ASSERT_EQ(kOk,
+            cache.OnEvent(&client, "DOM.attributeModified", params).code());
+  base::Value node;
+  ASSERT_FALSE(cache.GetAXNode(5, &node));
+  ASSERT_TRUE(cache.GetAXNode(6, &node));
+
+  base::DictionaryValue insert_params;
+  insert_params.SetInteger("parentNodeId", 6);
+  ASSERT_EQ(
+      kOk,
+      cache.OnEvent(&client, "DOM.childNodeInserted", insert_params).code());
+  ASSERT_FALSE(cache.GetAXNode(6, &node));
+  ASSERT_TRUE(cache.GetAXNode(7, &node));
+}
+
+TEST(AXNodeCache, UnrecognizedDomEventClearsCache) {
+  StubDevToolsClient client;
+  AXNodeCache cache(&client);
+  cache.PutAXNode(5, CreateAXNode("five"));
+
+  base::DictionaryValue params;
+  ASSERT_EQ(kOk, cache.OnEvent(&client, "DOM.setChildNodes", params).code());
+  base::Value node;
+  ASSERT_FALSE(cache.GetAXNode(5, &node));
+}
+
+TEST(AXNodeCache, ReconnectClearsCache) {
+  StubDevToolsClient client;
+  AXNodeCache cache(&client);
+  cache.PutAXNode(5, CreateAXNode("five"));
+
+  ASSERT_EQ(kOk, cache.OnConnected(&client).code());
+  base::Value node;
+  ASSERT_FALSE(cache.GetAXNode(5, &node));
+}
+
+TEST(AXNodeCache, SubscribesOnlyToDomEvents) {
+  StubDevToolsClient client;
+  AXNodeCache cache(&client);
+  ASSERT_EQ(std::vector<std::string>({"DOM."}),
+            cache.SubscribedMethodPrefixes());
+}
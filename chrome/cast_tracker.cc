@@ -4,12 +4,27 @@
 
 #include "chrome/test/chromedriver/chrome/cast_tracker.h"
 
+#include <utility>
+
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/devtools_client.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 
-CastTracker::CastTracker(DevToolsClient* client)
-    : sinks_(std::vector<base::Value>()), issue_("") {
+namespace {
+
+// Returns the index key for a sink: its id, or its name for sinks that do
+// not report one.
+std::string SinkKey(const base::Value& sink) {
+  const std::string* id = sink.FindStringKey("id");
+  if (id)
+    return *id;
+  const std::string* name = sink.FindStringKey("name");
+  return name ? *name : std::string();
+}
+
+}  // namespace
+
+CastTracker::CastTracker(DevToolsClient* client) : issue_("") {
   client->ConnectIfNecessary();
   client->AddListener(this);
   client->SendCommand("Cast.enable", base::DictionaryValue());
@@ -17,17 +32,48 @@ CastTracker::CastTracker(DevToolsClient* client)
 
 CastTracker::~CastTracker() = default;
 
+std::vector<std::string> CastTracker::SubscribedMethodPrefixes() const {
+  return {"Cast."};
+}
+
 Status CastTracker::OnEvent(DevToolsClient* client,
                             const std::string& method,
                             const base::DictionaryValue& params) {
   if (method == "Cast.sinksUpdated") {
     const base::Value* sinks = params.FindKey("sinks");
-    if (sinks)
-      sinks_ = sinks->Clone();
+    if (sinks && sinks->is_list()) {
+      // The event carries the full list, but in steady state most sinks are
+      // unchanged: keep the stored copy when a sink compares equal and only
+      // clone the ones that differ, dropping entries no longer reported.
+      std::map<std::string, base::Value> updated;
+      std::vector<std::string> order;
+      for (const base::Value& sink : sinks->GetList()) {
+        std::string key = SinkKey(sink);
+        auto it = sinks_by_id_.find(key);
+        if (it != sinks_by_id_.end() && it->second == sink)
+          updated.insert(std::make_pair(key, std::move(it->second)));
+        else
+          updated.insert(std::make_pair(key, sink.Clone()));
+        order.push_back(std::move(key));
+      }
+      sinks_by_id_.swap(updated);
+      sink_order_.swap(order);
+    }
   } else if (method == "Cast.issueUpdated") {
     const base::Value* issue = params.FindKey("issueMessage");
-    if (issue)
+    if (issue && issue_ != *issue)
       issue_ = issue->Clone();
   }
   return Status(kOk);
 }
+
+std::unique_ptr<base::Value> CastTracker::GetSinksSnapshot() const {
+  base::Value::ListStorage sinks;
+  sinks.reserve(sink_order_.size());
+  for (const std::string& id : sink_order_) {
+    auto it = sinks_by_id_.find(id);
+    if (it != sinks_by_id_.end())
+      sinks.push_back(it->second.Clone());
+  }
+  return std::make_unique<base::Value>(std::move(sinks));
+}
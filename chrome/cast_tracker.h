@@ -5,7 +5,10 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_CHROME_CAST_TRACKER_H_
 #define CHROME_TEST_CHROMEDRIVER_CHROME_CAST_TRACKER_H_
 
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "base/macros.h"
 #include "base/values.h"
@@ -14,7 +17,10 @@
 class DevToolsClient;
 class Status;
 
-// Tracks the state of Cast sinks and issues.
+// Tracks the state of Cast sinks and issues. Sinks are held in an index
+// keyed by sink id and updated differentially: Cast.sinksUpdated can arrive
+// continuously on sink-heavy setups, and each event only clones the sinks
+// that actually changed instead of rewriting the whole list.
 class CastTracker : public DevToolsEventListener {
  public:
   explicit CastTracker(DevToolsClient* client);
@@ -24,12 +30,20 @@ class CastTracker : public DevToolsEventListener {
   Status OnEvent(DevToolsClient* client,
                  const std::string& method,
                  const base::DictionaryValue& params) override;
+  std::vector<std::string> SubscribedMethodPrefixes() const override;
+
+  // Returns a copy of the current sink list in the order the browser last
+  // reported it. The caller owns the snapshot, so later events never mutate
+  // a list already handed out.
+  std::unique_ptr<base::Value> GetSinksSnapshot() const;
 
-  const base::Value& sinks() const { return sinks_; }
   const base::Value& issue() const { return issue_; }
 
  private:
-  base::Value sinks_;
+  // Current sinks keyed by sink id (by name for sinks without one).
+  // |sink_order_| preserves the browser's reporting order for snapshots.
+  std::map<std::string, base::Value> sinks_by_id_;
+  std::vector<std::string> sink_order_;
   base::Value issue_;
 
   DISALLOW_COPY_AND_ASSIGN(CastTracker);
@@ -49,20 +49,54 @@ class CastTrackerTest : public testing::Test {
 };
 
 TEST_F(CastTrackerTest, OnSinksUpdated) {
-  const base::Value empty_sinks = base::Value(std::vector<base::Value>());
   base::DictionaryValue params;
-  EXPECT_EQ(0u, cast_tracker_->sinks().GetList().size());
+  EXPECT_EQ(0u, cast_tracker_->GetSinksSnapshot()->GetList().size());
 
   base::Value sinks(base::Value::Type::LIST);
   sinks.Append(CreateSink("sink1", "1"));
   sinks.Append(CreateSink("sink2", "2"));
   params.SetKey("sinks", std::move(sinks));
   cast_tracker_->OnEvent(&devtools_client_, "Cast.sinksUpdated", params);
-  EXPECT_EQ(2u, cast_tracker_->sinks().GetList().size());
+  EXPECT_EQ(2u, cast_tracker_->GetSinksSnapshot()->GetList().size());
 
   params.SetKey("sinks", base::Value(base::Value::Type::LIST));
   cast_tracker_->OnEvent(&devtools_client_, "Cast.sinksUpdated", params);
-  EXPECT_EQ(0u, cast_tracker_->sinks().GetList().size());
+  EXPECT_EQ(0u, cast_tracker_->GetSinksSnapshot()->GetList().size());
+}
+
+TEST_F(CastTrackerTest, SinksKeepReportedOrder) {
+  base::DictionaryValue params;
+  base::Value sinks(base::Value::Type::LIST);
+  sinks.Append(CreateSink("sink2", "2"));
+  sinks.Append(CreateSink("sink1", "1"));
+  params.SetKey("sinks", std::move(sinks));
+  cast_tracker_->OnEvent(&devtools_client_, "Cast.sinksUpdated", params);
+
+  std::unique_ptr<base::Value> snapshot = cast_tracker_->GetSinksSnapshot();
+  ASSERT_EQ(2u, snapshot->GetList().size());
+  EXPECT_EQ("2", *snapshot->GetList()[0].FindStringKey("id"));
+  EXPECT_EQ("1", *snapshot->GetList()[1].FindStringKey("id"));
+}
+
+TEST_F(CastTrackerTest, SnapshotUnaffectedByLaterUpdates) {
+  base::DictionaryValue params;
+  base::Value sinks(base::Value::Type::LIST);
+  sinks.Append(CreateSink("sink1", "1"));
+  params.SetKey("sinks", std::move(sinks));
+  cast_tracker_->OnEvent(&devtools_client_, "Cast.sinksUpdated", params);
+  std::unique_ptr<base::Value> snapshot = cast_tracker_->GetSinksSnapshot();
+
+  base::Value updated_sinks(base::Value::Type::LIST);
+  base::Value renamed = CreateSink("renamed", "1");
+  updated_sinks.Append(std::move(renamed));
+  params.SetKey("sinks", std::move(updated_sinks));
+  cast_tracker_->OnEvent(&devtools_client_, "Cast.sinksUpdated", params);
+
+  ASSERT_EQ(1u, snapshot->GetList().size());
+  EXPECT_EQ("sink1", *snapshot->GetList()[0].FindStringKey("name"));
+  std::unique_ptr<base::Value> updated = cast_tracker_->GetSinksSnapshot();
+  ASSERT_EQ(1u, updated->GetList().size());
+  EXPECT_EQ("renamed", *updated->GetList()[0].FindStringKey("name"));
 }
 
 TEST_F(CastTrackerTest, OnIssueUpdated) {
@@ -0,0 +1,108 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/cdp_bindings.h"
+
+#include <memory>
+#include <string>
+
+#include "base/json/json_reader.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+std::unique_ptr<base::Value> ParseJson(const std::string& json) {
+  return base::JSONReader::ReadDeprecated(json);
+}
+
+}  // namespace
+
+TEST(CdpBindingsTest, MouseEventRequiredFields) {
+  cdp::InputDispatchMouseEvent params;
+  params.type = "mousePressed";
+  params.x = 10;
+  params.y = 20;
+  params.button = "left";
+  params.click_count = 1;
+  params.pointer_type = "mouse";
+  std::string json;
+  params.WriteJson(&json);
+
+  std::unique_ptr<base::Value> parsed = ParseJson(json);
+  ASSERT_TRUE(parsed);
+  EXPECT_EQ("mousePressed", *parsed->FindStringKey("type"));
+  EXPECT_EQ(10, parsed->FindIntKey("x").value_or(-1));
+  EXPECT_EQ(20, parsed->FindIntKey("y").value_or(-1));
+  EXPECT_EQ("left", *parsed->FindStringKey("button"));
+  EXPECT_EQ(1, parsed->FindIntKey("clickCount").value_or(-1));
+  // Unset optional fields must be omitted, not emitted as null.
+  EXPECT_FALSE(parsed->FindKey("timestamp"));
+  EXPECT_FALSE(parsed->FindKey("deltaX"));
+}
+
+TEST(CdpBindingsTest, MouseEventOptionalFields) {
+  cdp::InputDispatchMouseEvent params;
+  params.type = "mouseWheel";
+  params.button = "none";
+  params.pointer_type = "mouse";
+  params.timestamp = 123.5;
+  params.delta_x = -15;
+  params.delta_y = 30;
+  std::string json;
+  params.WriteJson(&json);
+
+  std::unique_ptr<base::Value> parsed = ParseJson(json);
+  ASSERT_TRUE(parsed);
+  EXPECT_EQ(123.5, parsed->FindDoubleKey("timestamp").value_or(-1));
+  EXPECT_EQ(-15, parsed->FindIntKey("deltaX").value_or(0));
+  EXPECT_EQ(30, parsed->FindIntKey("deltaY").value_or(0));
+}
+
+TEST(CdpBindingsTest, KeyEventCommandsAndEscaping) {
+  cdp::InputDispatchKeyEvent params;
+  params.type = "keyDown";
+  params.text = "\"quoted\"\n";
+  params.unmodified_text = "a";
+  params.key = base::StringPiece("a");
+  params.is_keypad = true;
+  params.commands.push_back("SelectAll");
+  std::string json;
+  params.WriteJson(&json);
+
+  std::unique_ptr<base::Value> parsed = ParseJson(json);
+  ASSERT_TRUE(parsed);
+  EXPECT_EQ("\"quoted\"\n", *parsed->FindStringKey("text"));
+  EXPECT_EQ("a", *parsed->FindStringKey("key"));
+  EXPECT_EQ(true, parsed->FindBoolKey("isKeypad").value_or(false));
+  const base::Value* commands = parsed->FindListKey("commands");
+  ASSERT_TRUE(commands);
+  ASSERT_EQ(1u, commands->GetList().size());
+  EXPECT_EQ("SelectAll", commands->GetList()[0].GetString());
+}
+
+TEST(CdpBindingsTest, KeyEventEmptyCommandsOmitted) {
+  cdp::InputDispatchKeyEvent params;
+  params.type = "keyUp";
+  params.unmodified_text = "a";
+  std::string json;
+  params.WriteJson(&json);
+
+  std::unique_ptr<base::Value> parsed = ParseJson(json);
+  ASSERT_TRUE(parsed);
+  EXPECT_FALSE(parsed->FindKey("commands"));
+  EXPECT_FALSE(parsed->FindKey("code"));
+  EXPECT_FALSE(parsed->FindKey("location"));
+}
+
+TEST(CdpBindingsTest, InsertTextNonAscii) {
+  cdp::InputInsertText params;
+  params.text = "h\xC3\xA9llo";
+  std::string json;
+  params.WriteJson(&json);
+
+  std::unique_ptr<base::Value> parsed = ParseJson(json);
+  ASSERT_TRUE(parsed);
+  EXPECT_EQ("h\xC3\xA9llo", *parsed->FindStringKey("text"));
+}
@@ -7,12 +7,14 @@
 
 #include <list>
 #include <string>
+#include <vector>
 #include "base/values.h"
 
 struct BrowserInfo;
 class ChromeDesktopImpl;
 class Status;
 class WebView;
+struct WebViewInfo;
 
 class Chrome {
  public:
@@ -52,6 +54,12 @@ class Chrome {
   virtual Status GetWebViewIds(std::list<std::string>* web_view_ids,
                                bool w3c_compliant) = 0;
 
+  // Returns metadata (id, URL, title, type) for the same WebViews
+  // GetWebViewIds reports, in the same order, without activating any of
+  // them. Sourced from the event-maintained target list when available.
+  virtual Status GetWebViewsSummary(std::vector<WebViewInfo>* views,
+                                    bool w3c_compliant) = 0;
+
   // Return the WebView for the given id.
   virtual Status GetWebViewById(const std::string& id, WebView** web_view) = 0;
 
@@ -79,8 +87,10 @@ class Chrome {
   // Closes the specified WebView.
   virtual Status CloseWebView(const std::string& id) = 0;
 
-  // Activates the specified WebView.
-  virtual Status ActivateWebView(const std::string& id) = 0;
+  // Activates the specified WebView. When |force| is false, implementations
+  // may skip the activation if the view is already known to be foreground;
+  // pass true when the user-visible bring-to-front must happen regardless.
+  virtual Status ActivateWebView(const std::string& id, bool force) = 0;
 
   // Enables acceptInsecureCerts mode for the browser.
   virtual Status SetAcceptInsecureCerts() = 0;
@@ -105,6 +115,11 @@ class Chrome {
   // Return the page load strategy for this session.
   virtual std::string page_load_strategy() const = 0;
 
+  // Moves the device console lines buffered since the last call into
+  // |lines|. Only supported on Android, where a persistent logcat capture
+  // feeds the buffer.
+  virtual Status GetBufferedDeviceLog(std::vector<std::string>* lines) = 0;
+
   // Quits Chrome.
   virtual Status Quit() = 0;
 };
@@ -37,6 +37,11 @@ std::string ChromeAndroidImpl::GetOperatingSystemName() {
   return "ANDROID";
 }
 
+Status ChromeAndroidImpl::GetBufferedDeviceLog(
+    std::vector<std::string>* lines) {
+  return device_->ReadLogcatLines(lines);
+}
+
 Status ChromeAndroidImpl::GetWindow(const std::string& target_id,
                                     Window* window) {
   WebView* web_view = nullptr;
@@ -29,6 +29,7 @@ class ChromeAndroidImpl : public ChromeImpl {
   // Overridden from Chrome:
   Status GetAsDesktop(ChromeDesktopImpl** desktop) override;
   std::string GetOperatingSystemName() override;
+  Status GetBufferedDeviceLog(std::vector<std::string>* lines) override;
 
   // Overridden from ChromeImpl:
   bool HasTouchScreen() const override;
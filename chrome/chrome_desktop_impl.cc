@@ -14,7 +14,6 @@
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/system/sys_info.h"
-#include "base/threading/platform_thread.h"
 #include "base/time/time.h"
 #include "build/build_config.h"
 #include "chrome/test/chromedriver/chrome/devtools_client.h"
@@ -41,9 +40,9 @@ bool KillProcess(const base::Process& process, bool kill_gracefully) {
 #if defined(OS_POSIX)
   if (!kill_gracefully) {
     kill(process.Pid(), SIGKILL);
-    base::TimeTicks deadline =
-        base::TimeTicks::Now() + base::TimeDelta::FromSeconds(30);
-    while (base::TimeTicks::Now() < deadline) {
+    Timeout timeout(base::TimeDelta::FromSeconds(30));
+    AdaptiveWaiter waiter(base::TimeDelta::FromMilliseconds(50));
+    while (!timeout.IsExpired()) {
       pid_t pid = HANDLE_EINTR(waitpid(process.Pid(), NULL, WNOHANG));
       if (pid == process.Pid())
         return true;
@@ -55,7 +54,7 @@ bool KillProcess(const base::Process& process, bool kill_gracefully) {
         }
         LOG(WARNING) << "Error waiting for process " << process.Pid();
       }
-      base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(50));
+      waiter.Wait(&timeout);
     }
     return false;
   }
@@ -121,6 +120,7 @@ Status ChromeDesktopImpl::WaitForPageToLoad(
   Timeout timeout(timeout_raw);
   std::string id;
   WebViewInfo::Type type = WebViewInfo::Type::kPage;
+  AdaptiveWaiter waiter(base::TimeDelta::FromMilliseconds(100));
   while (timeout.GetRemainingTime() > base::TimeDelta()) {
     WebViewsInfo views_info;
     Status status = devtools_http_client_->GetWebViewsInfo(&views_info);
@@ -137,7 +137,7 @@ Status ChromeDesktopImpl::WaitForPageToLoad(
     }
     if (!id.empty())
       break;
-    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(100));
+    waiter.Wait(&timeout);
   }
   if (id.empty())
     return Status(kUnknownError, "page could not be found: " + url);
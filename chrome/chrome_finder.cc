@@ -13,9 +13,13 @@
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/environment.h"
+#include "base/files/file.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
+#include "base/lazy_instance.h"
 #include "base/path_service.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
 #include "base/stl_util.h"
 #include "base/strings/string_split.h"
 #include "base/strings/utf_string_conversions.h"
@@ -107,6 +111,21 @@ void GetPathsFromEnvironment(std::vector<base::FilePath>* paths) {
   }
 }
 
+// Cache of the discovered browser binary, kept for the process lifetime.
+// Probing the well-known install locations stats dozens of paths; on
+// network filesystems each stat can take tens of milliseconds, and the
+// result almost never changes while the server runs. The cached path is
+// revalidated with a single stat per launch, and the full probe reruns
+// only when the binary has disappeared or been replaced.
+struct FoundChromeCache {
+  base::Lock lock;
+  base::FilePath path;
+  base::Time last_modified;
+};
+
+base::LazyInstance<FoundChromeCache>::Leaky g_found_chrome_cache =
+    LAZY_INSTANCE_INITIALIZER;
+
 }  // namespace
 
 namespace internal {
@@ -134,7 +153,10 @@ bool FindExe(
 void GetApplicationDirs(std::vector<base::FilePath>* locations);
 #endif
 
-bool FindChrome(base::FilePath* browser_exe) {
+namespace {
+
+// Runs the full probe over the well-known install locations and PATH.
+bool FindChromeOnDisk(base::FilePath* browser_exe) {
   base::FilePath browser_exes_array[] = {
 #if defined(OS_WIN) || defined(OS_MAC)
     base::FilePath(chrome::kBrowserProcessExecutablePath),
@@ -168,3 +190,28 @@ bool FindChrome(base::FilePath* browser_exe) {
   return internal::FindExe(base::BindRepeating(&base::PathExists), browser_exes,
                            locations, browser_exe);
 }
+
+}  // namespace
+
+bool FindChrome(base::FilePath* browser_exe) {
+  FoundChromeCache& cache = g_found_chrome_cache.Get();
+  base::AutoLock lock(cache.lock);
+  if (!cache.path.empty()) {
+    base::File::Info info;
+    if (base::GetFileInfo(cache.path, &info) &&
+        info.last_modified == cache.last_modified) {
+      *browser_exe = cache.path;
+      return true;
+    }
+    // The binary disappeared or was replaced; fall through to a fresh probe.
+    cache.path.clear();
+  }
+  if (!FindChromeOnDisk(browser_exe))
+    return false;
+  base::File::Info info;
+  if (base::GetFileInfo(*browser_exe, &info)) {
+    cache.path = *browser_exe;
+    cache.last_modified = info.last_modified;
+  }
+  return true;
+}
@@ -10,10 +10,13 @@
 #include "base/strings/string_number_conversions.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/devtools_client.h"
+#include "chrome/test/chromedriver/chrome/devtools_client_impl.h"
 #include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
 #include "chrome/test/chromedriver/chrome/devtools_http_client.h"
 #include "chrome/test/chromedriver/chrome/page_load_strategy.h"
 #include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/chrome/target_tracker.h"
+#include "chrome/test/chromedriver/net/timeout.h"
 #include "chrome/test/chromedriver/chrome/web_view_impl.h"
 #include "url/gurl.h"
 
@@ -26,6 +29,29 @@ Status MakeFailedStatus(const std::string& desired_state,
 }
 }  // namespace
 
+class ChromeImpl::WindowCacheInvalidator : public DevToolsEventListener {
+ public:
+  WindowCacheInvalidator(ChromeImpl* chrome, DevToolsClient* client)
+      : chrome_(chrome) {
+    client->AddListener(this);
+  }
+
+  Status OnConnected(DevToolsClient* client) override {
+    chrome_->window_cache_.clear();
+    return Status(kOk);
+  }
+
+  std::vector<std::string> SubscribedMethodPrefixes() const override {
+    // Only connection notifications matter here; the Browser domain emits
+    // nothing this listener acts on, so this keeps it off the all-events
+    // delivery path.
+    return {"Browser."};
+  }
+
+ private:
+  ChromeImpl* chrome_;
+};
+
 ChromeImpl::~ChromeImpl() {
 }
 
@@ -38,8 +64,8 @@ const BrowserInfo* ChromeImpl::GetBrowserInfo() const {
 }
 
 bool ChromeImpl::HasCrashedWebView() {
-  for (const auto& view : web_views_) {
-    if (view->WasCrashed())
+  for (const WebViewEntry& entry : web_views_) {
+    if (entry.view && entry.view->WasCrashed())
       return true;
   }
   return false;
@@ -48,7 +74,7 @@ bool ChromeImpl::HasCrashedWebView() {
 Status ChromeImpl::GetWebViewIdForFirstTab(std::string* web_view_id,
                                            bool w3c_compliant) {
   WebViewsInfo views_info;
-  Status status = devtools_http_client_->GetWebViewsInfo(&views_info);
+  Status status = GetWebViewsInfo(&views_info);
   if (status.IsError())
     return status;
   UpdateWebViews(views_info, w3c_compliant);
@@ -64,25 +90,70 @@ Status ChromeImpl::GetWebViewIdForFirstTab(std::string* web_view_id,
 
 Status ChromeImpl::GetWebViewIds(std::list<std::string>* web_view_ids,
                                  bool w3c_compliant) {
+  // Claim any pending pool creations first so their ids are known and the
+  // targets can be kept out of the reported handles below.
+  for (auto it = target_pool_.begin(); it != target_pool_.end();) {
+    if (ResolvePooledTarget(&*it).IsError())
+      it = target_pool_.erase(it);
+    else
+      ++it;
+  }
   WebViewsInfo views_info;
-  Status status = devtools_http_client_->GetWebViewsInfo(&views_info);
+  Status status = GetWebViewsInfo(&views_info);
   if (status.IsError())
     return status;
   UpdateWebViews(views_info, w3c_compliant);
   std::list<std::string> web_view_ids_tmp;
-  for (const auto& view : web_views_)
-    web_view_ids_tmp.push_back(view->GetId());
+  for (const WebViewEntry& entry : web_views_)
+    web_view_ids_tmp.push_back(entry.id);
   web_view_ids->swap(web_view_ids_tmp);
   return Status(kOk);
 }
 
+Status ChromeImpl::GetWebViewsSummary(std::vector<WebViewInfo>* views,
+                                      bool w3c_compliant) {
+  WebViewsInfo views_info;
+  Status status = GetWebViewsInfo(&views_info);
+  if (status.IsError())
+    return status;
+  UpdateWebViews(views_info, w3c_compliant);
+  std::vector<WebViewInfo> views_tmp;
+  for (const WebViewEntry& entry : web_views_) {
+    const WebViewInfo* view = views_info.GetForId(entry.id);
+    if (view)
+      views_tmp.push_back(*view);
+  }
+  views->swap(views_tmp);
+  return Status(kOk);
+}
+
+Status ChromeImpl::GetWebViewsInfo(WebViewsInfo* views_info) {
+  Status status = devtools_websocket_client_->ConnectIfNecessary();
+  if (status.IsOk())
+    status = target_tracker_->EnsureEnabled(devtools_websocket_client_.get());
+  if (status.IsOk() && target_tracker_->IsActive()) {
+    // Fold in any target events received since the last command, then serve
+    // the list from memory.
+    status = devtools_websocket_client_->HandleReceivedEvents();
+    if (status.IsError())
+      return status;
+    if (target_tracker_->IsActive()) {
+      *views_info = target_tracker_->GetWebViewsInfo();
+      return Status(kOk);
+    }
+  }
+  // Target discovery is unavailable, so fetch the full target list from the
+  // DevTools HTTP endpoint.
+  return devtools_http_client_->GetWebViewsInfo(views_info);
+}
+
 void ChromeImpl::UpdateWebViews(const WebViewsInfo& views_info,
                                 bool w3c_compliant) {
   // Check if some web views are closed (or in the case of background pages,
   // become inactive).
   auto it = web_views_.begin();
   while (it != web_views_.end()) {
-    const WebViewInfo* view = views_info.GetForId((*it)->GetId());
+    const WebViewInfo* view = views_info.GetForId(it->id);
     if (!view || view->IsInactiveBackgroundPage()) {
       it = web_views_.erase(it);
     } else {
@@ -90,48 +161,78 @@ void ChromeImpl::UpdateWebViews(const WebViewsInfo& views_info,
     }
   }
 
-  // Check for newly-opened web views.
+  // Check for newly-opened web views. They are only tracked by id here; the
+  // WebViewImpl is built when a command first addresses the handle, so tabs
+  // the session never touches cost nothing beyond this entry.
   for (size_t i = 0; i < views_info.GetSize(); ++i) {
     const WebViewInfo& view = views_info.Get(i);
+    if (IsPooledTargetId(view.id))
+      continue;
     if (devtools_http_client_->IsBrowserWindow(view) &&
-        !view.IsInactiveBackgroundPage()) {
-      bool found = false;
-      for (const auto& web_view : web_views_) {
-        if (web_view->GetId() == view.id) {
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
-        std::unique_ptr<DevToolsClient> client(
-            devtools_http_client_->CreateClient(view.id));
-        for (const auto& listener : devtools_event_listeners_)
-          client->AddListener(listener.get());
-        // OnConnected will fire when DevToolsClient connects later.
-        CHECK(!page_load_strategy_.empty());
-        if (view.type == WebViewInfo::kServiceWorker) {
-          web_views_.push_back(std::make_unique<WebViewImpl>(
-              view.id, w3c_compliant, nullptr,
-              devtools_http_client_->browser_info(), std::move(client)));
-        } else {
-          web_views_.push_back(std::make_unique<WebViewImpl>(
-              view.id, w3c_compliant, nullptr,
-              devtools_http_client_->browser_info(), std::move(client),
-              devtools_http_client_->device_metrics(), page_load_strategy_));
-        }
-      }
+        !view.IsInactiveBackgroundPage() && !FindWebViewEntry(view.id)) {
+      web_views_.emplace_back(
+          view.id, view.type == WebViewInfo::kServiceWorker, w3c_compliant);
     }
   }
 }
 
-Status ChromeImpl::GetWebViewById(const std::string& id, WebView** web_view) {
-  for (const auto& view : web_views_) {
-    if (view->GetId() == id) {
-      *web_view = view.get();
-      return Status(kOk);
-    }
+ChromeImpl::WebViewEntry::WebViewEntry(const std::string& id,
+                                       bool is_service_worker,
+                                       bool w3c_compliant)
+    : id(id),
+      is_service_worker(is_service_worker),
+      w3c_compliant(w3c_compliant) {}
+
+ChromeImpl::WebViewEntry::WebViewEntry(WebViewEntry&& other) = default;
+
+ChromeImpl::WebViewEntry::~WebViewEntry() {}
+
+ChromeImpl::WebViewEntry* ChromeImpl::FindWebViewEntry(const std::string& id) {
+  for (WebViewEntry& entry : web_views_) {
+    if (entry.id == id)
+      return &entry;
+  }
+  return nullptr;
+}
+
+void ChromeImpl::AttachWebView(WebViewEntry* entry) {
+  std::unique_ptr<DevToolsClient> client(CreateClientForWebView(entry->id));
+  for (const auto& listener : devtools_event_listeners_)
+    client->AddListener(listener.get());
+  // OnConnected will fire when DevToolsClient connects later.
+  CHECK(!page_load_strategy_.empty());
+  if (entry->is_service_worker) {
+    entry->view = std::make_unique<WebViewImpl>(
+        entry->id, entry->w3c_compliant, nullptr,
+        devtools_http_client_->browser_info(), std::move(client));
+  } else {
+    entry->view = std::make_unique<WebViewImpl>(
+        entry->id, entry->w3c_compliant, nullptr,
+        devtools_http_client_->browser_info(), std::move(client),
+        devtools_http_client_->device_metrics(), page_load_strategy_);
   }
-  return Status(kUnknownError, "web view not found");
+}
+
+std::unique_ptr<DevToolsClient> ChromeImpl::CreateClientForWebView(
+    const std::string& id) {
+  Status status = devtools_websocket_client_->ConnectIfNecessary();
+  if (status.IsOk()) {
+    return DevToolsClientImpl::CreateTargetClient(
+        static_cast<DevToolsClientImpl*>(
+            devtools_websocket_client_->GetRootClient()),
+        id);
+  }
+  return devtools_http_client_->CreateClient(id);
+}
+
+Status ChromeImpl::GetWebViewById(const std::string& id, WebView** web_view) {
+  WebViewEntry* entry = FindWebViewEntry(id);
+  if (!entry)
+    return Status(kUnknownError, "web view not found");
+  if (!entry->view)
+    AttachWebView(entry);
+  *web_view = entry->view.get();
+  return Status(kOk);
 }
 
 Status ChromeImpl::NewWindow(const std::string& target_id,
@@ -146,6 +247,23 @@ Status ChromeImpl::NewWindow(const std::string& target_id,
   if (status.IsError())
     return Status(kNoSuchWindow);
 
+  // Adopt a pre-created blank target when one is ready; its createTarget
+  // round trip already happened in the background of earlier commands.
+  for (auto it = target_pool_.begin(); it != target_pool_.end(); ++it) {
+    if (it->type != type)
+      continue;
+    status = ResolvePooledTarget(&*it);
+    std::string pooled_id = it->id;
+    target_pool_.erase(it);
+    if (status.IsOk() && !pooled_id.empty()) {
+      RefillTargetPool(type);
+      *window_handle = pooled_id;
+      return Status(kOk);
+    }
+    // A failed pool creation falls through to the synchronous path.
+    break;
+  }
+
   base::DictionaryValue params;
   params.SetString("url", "about:blank");
   params.SetBoolean("newWindow", type == WindowType::kWindow);
@@ -159,9 +277,58 @@ Status ChromeImpl::NewWindow(const std::string& target_id,
   if (!result->GetString("targetId", window_handle))
     return Status(kUnknownError, "no targetId from createTarget");
 
+  RefillTargetPool(type);
+  return Status(kOk);
+}
+
+Status ChromeImpl::ResolvePooledTarget(PooledTarget* entry) {
+  if (!entry->id.empty())
+    return Status(kOk);
+  std::unique_ptr<base::DictionaryValue> result;
+  Status status = entry->future->Get(nullptr, &result);
+  if (status.IsError())
+    return status;
+  if (!result->GetString("targetId", &entry->id))
+    return Status(kUnknownError, "no targetId from createTarget");
   return Status(kOk);
 }
 
+void ChromeImpl::RefillTargetPool(WindowType type) {
+  // One spare per type hides the createTarget latency from back-to-back
+  // opens without accumulating idle targets.
+  for (const PooledTarget& entry : target_pool_) {
+    if (entry.type == type)
+      return;
+  }
+  DevToolsClientImpl* client = static_cast<DevToolsClientImpl*>(
+      devtools_websocket_client_->GetRootClient());
+  base::DictionaryValue params;
+  params.SetString("url", "about:blank");
+  params.SetBoolean("newWindow", type == WindowType::kWindow);
+  params.SetBoolean("background", true);
+  target_pool_.emplace_back(
+      type, std::make_unique<DevToolsCommandFuture>(
+                client->SendCommandAndGetResultAsync("Target.createTarget",
+                                                     params)));
+}
+
+bool ChromeImpl::IsPooledTargetId(const std::string& id) const {
+  for (const PooledTarget& entry : target_pool_) {
+    if (entry.id == id)
+      return true;
+  }
+  return false;
+}
+
+ChromeImpl::PooledTarget::PooledTarget(
+    WindowType type,
+    std::unique_ptr<DevToolsCommandFuture> future)
+    : type(type), future(std::move(future)) {}
+
+ChromeImpl::PooledTarget::PooledTarget(PooledTarget&& other) = default;
+
+ChromeImpl::PooledTarget::~PooledTarget() {}
+
 Status ChromeImpl::GetWindow(const std::string& target_id, Window* window) {
   Status status = devtools_websocket_client_->ConnectIfNecessary();
   if (status.IsError())
@@ -181,9 +348,17 @@ Status ChromeImpl::GetWindow(const std::string& target_id, Window* window) {
 Status ChromeImpl::GetWindowRect(const std::string& target_id,
                                  WindowRect* rect) {
   Window window;
-  Status status = GetWindow(target_id, &window);
-  if (status.IsError())
-    return status;
+  // Rect reads are served from cache while the driver is the only thing
+  // changing window geometry; mutations and reconnects invalidate it.
+  auto cached = window_cache_.find(target_id);
+  if (cached != window_cache_.end()) {
+    window = cached->second;
+  } else {
+    Status status = GetWindow(target_id, &window);
+    if (status.IsError())
+      return status;
+    window_cache_[target_id] = window;
+  }
 
   rect->x = window.left;
   rect->y = window.top;
@@ -286,6 +461,15 @@ Status ChromeImpl::SetWindowBounds(
   if (status.IsError())
     return status;
 
+  // Drop cached bounds for every target sharing this window before the
+  // mutation; tabs in the same browser window share a window id.
+  for (auto it = window_cache_.begin(); it != window_cache_.end();) {
+    if (it->second.id == window->id)
+      it = window_cache_.erase(it);
+    else
+      ++it;
+  }
+
   base::DictionaryValue params;
   params.SetInteger("windowId", window->id);
   const std::string normal = "normal";
@@ -295,7 +479,10 @@ Status ChromeImpl::SetWindowBounds(
                                                      params);
     if (status.IsError())
       return status;
-    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(100));
+    // Wait for the window state change to land, waking early if the browser
+    // sends any event in the meantime.
+    devtools_websocket_client_->HandleNextEvent(
+        Timeout(base::TimeDelta::FromMilliseconds(100)));
 
     status = GetWindowBounds(window->id, window);
     if (status.IsError())
@@ -346,7 +533,10 @@ Status ChromeImpl::SetWindowBounds(
   if (status.IsError())
     return status;
 
-  base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(100));
+  // Wait for the window state change to land, waking early if the browser
+  // sends any event in the meantime.
+  devtools_websocket_client_->HandleNextEvent(
+      Timeout(base::TimeDelta::FromMilliseconds(100)));
 
   if (desired_state.empty())
     return Status(kOk);
@@ -400,7 +590,10 @@ Status ChromeImpl::SetWindowBounds(
     status = devtools_websocket_client_->SendCommand("Browser.setWindowBounds",
                                                      params);
 
-    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(100));
+    // Wait for the window state change to land, waking early if the browser
+    // sends any event in the meantime.
+    devtools_websocket_client_->HandleNextEvent(
+        Timeout(base::TimeDelta::FromMilliseconds(100)));
 
     status = GetWindowBounds(window->id, window);
     if (status.IsError())
@@ -448,20 +641,38 @@ Status ChromeImpl::CloseWebView(const std::string& id) {
   if (status.IsError())
     return status;
   for (auto iter = web_views_.begin(); iter != web_views_.end(); ++iter) {
-    if ((*iter)->GetId() == id) {
+    if (iter->id == id) {
       web_views_.erase(iter);
       break;
     }
   }
+  window_cache_.erase(id);
+  if (id == active_web_view_id_)
+    active_web_view_id_.clear();
   return Status(kOk);
 }
 
-Status ChromeImpl::ActivateWebView(const std::string& id) {
-  WebView* webview = nullptr;
-  GetWebViewById(id, &webview);
-  if (webview && webview->IsServiceWorker())
+Status ChromeImpl::ActivateWebView(const std::string& id, bool force) {
+  // Checked on the entry so that activating an unattached handle does not
+  // force its WebViewImpl into existence.
+  WebViewEntry* entry = FindWebViewEntry(id);
+  if (entry && entry->is_service_worker)
     return Status(kOk);
-  return devtools_http_client_->ActivateWebView(id);
+  if (!force && id == active_web_view_id_ && target_tracker_->IsActive()) {
+    // Fold in any target events received since the activation was recorded;
+    // a target appearing or disappearing may have moved focus elsewhere.
+    Status status = devtools_websocket_client_->HandleReceivedEvents();
+    if (status.IsOk() && target_tracker_->IsActive() &&
+        target_tracker_->Revision() == active_target_list_revision_) {
+      return Status(kOk);
+    }
+  }
+  Status status = devtools_http_client_->ActivateWebView(id);
+  if (status.IsError())
+    return status;
+  active_web_view_id_ = id;
+  active_target_list_revision_ = target_tracker_->Revision();
+  return Status(kOk);
 }
 
 Status ChromeImpl::SetAcceptInsecureCerts() {
@@ -520,6 +731,10 @@ std::string ChromeImpl::page_load_strategy() const {
   return page_load_strategy_;
 }
 
+Status ChromeImpl::GetBufferedDeviceLog(std::vector<std::string>* lines) {
+  return Status(kUnknownError, "device log is only available on Android");
+}
+
 Status ChromeImpl::Quit() {
   Status status = QuitImpl();
   if (status.IsOk())
@@ -535,5 +750,11 @@ ChromeImpl::ChromeImpl(std::unique_ptr<DevToolsHttpClient> http_client,
     : quit_(false),
       devtools_http_client_(std::move(http_client)),
       devtools_websocket_client_(std::move(websocket_client)),
+      active_target_list_revision_(0),
       devtools_event_listeners_(std::move(devtools_event_listeners)),
-      page_load_strategy_(page_load_strategy) {}
+      page_load_strategy_(page_load_strategy) {
+  target_tracker_ =
+      std::make_unique<TargetTracker>(devtools_websocket_client_.get());
+  window_cache_invalidator_ = std::make_unique<WindowCacheInvalidator>(
+      this, devtools_websocket_client_.get());
+}
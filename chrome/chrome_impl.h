@@ -6,6 +6,7 @@
 #define CHROME_TEST_CHROMEDRIVER_CHROME_CHROME_IMPL_H_
 
 #include <list>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -16,9 +17,11 @@
 
 struct BrowserInfo;
 class DevToolsClient;
+class DevToolsCommandFuture;
 class DevToolsEventListener;
 class DevToolsHttpClient;
 class Status;
+class TargetTracker;
 class WebView;
 class WebViewImpl;
 class WebViewsInfo;
@@ -34,6 +37,8 @@ class ChromeImpl : public Chrome {
                                  bool w3c_complaint) override;
   Status GetWebViewIds(std::list<std::string>* web_view_ids,
                        bool w3c_compliant) override;
+  Status GetWebViewsSummary(std::vector<WebViewInfo>* views,
+                            bool w3c_compliant) override;
   Status GetWebViewById(const std::string& id, WebView** web_view) override;
   Status NewWindow(const std::string& target_id,
                    WindowType type,
@@ -45,7 +50,7 @@ class ChromeImpl : public Chrome {
   Status MinimizeWindow(const std::string& target_id) override;
   Status FullScreenWindow(const std::string& target_id) override;
   Status CloseWebView(const std::string& id) override;
-  Status ActivateWebView(const std::string& id) override;
+  Status ActivateWebView(const std::string& id, bool force) override;
   Status SetAcceptInsecureCerts() override;
   Status SetPermission(
       std::unique_ptr<base::DictionaryValue> permission_descriptor,
@@ -55,6 +60,7 @@ class ChromeImpl : public Chrome {
   bool IsMobileEmulationEnabled() const override;
   bool HasTouchScreen() const override;
   std::string page_load_strategy() const override;
+  Status GetBufferedDeviceLog(std::vector<std::string>* lines) override;
   Status Quit() override;
 
  protected:
@@ -89,6 +95,10 @@ class ChromeImpl : public Chrome {
   std::unique_ptr<DevToolsClient> devtools_websocket_client_;
 
  private:
+  // Clears |window_cache_| whenever the browser-wide client (re)connects,
+  // since window geometry may have changed while the connection was down.
+  class WindowCacheInvalidator;
+
   static Status PermissionNameToChromePermissions(
       const base::DictionaryValue& permission_descriptor,
       Chrome::PermissionState setting,
@@ -96,8 +106,91 @@ class ChromeImpl : public Chrome {
 
   void UpdateWebViews(const WebViewsInfo& views_info, bool w3c_compliant);
 
+  // One discovered browser-window target. |view| stays null until the first
+  // command addresses this handle (GetWebViewById), so sessions with many
+  // untouched background tabs do not pay for a DevTools attachment and a
+  // full tracker set per tab.
+  struct WebViewEntry {
+    WebViewEntry(const std::string& id,
+                 bool is_service_worker,
+                 bool w3c_compliant);
+    WebViewEntry(WebViewEntry&& other);
+    ~WebViewEntry();
+
+    std::string id;
+    bool is_service_worker;
+    bool w3c_compliant;
+    std::unique_ptr<WebViewImpl> view;
+  };
+
+  WebViewEntry* FindWebViewEntry(const std::string& id);
+
+  // A pre-created blank target awaiting adoption by NewWindow, so opening a
+  // window costs no createTarget round trip once the pool is primed. |id|
+  // is empty until the pending response is claimed.
+  struct PooledTarget {
+    PooledTarget(WindowType type,
+                 std::unique_ptr<DevToolsCommandFuture> future);
+    PooledTarget(PooledTarget&& other);
+    ~PooledTarget();
+
+    WindowType type;
+    std::string id;
+    std::unique_ptr<DevToolsCommandFuture> future;
+  };
+
+  // Claims |entry|'s pending Target.createTarget response and fills its id;
+  // a no-op once resolved.
+  Status ResolvePooledTarget(PooledTarget* entry);
+
+  // Issues an asynchronous Target.createTarget so the next NewWindow of
+  // |type| finds a ready-made target; keeps one spare per type.
+  void RefillTargetPool(WindowType type);
+
+  // Whether |id| belongs to a pooled target that no command has adopted
+  // yet; such targets are kept out of the reported web views.
+  bool IsPooledTargetId(const std::string& id) const;
+
+  // Builds |entry|'s WebViewImpl with its DevToolsClient and the session's
+  // event listeners attached.
+  void AttachWebView(WebViewEntry* entry);
+
+  // Creates the DevToolsClient for a newly seen web view. Prefers a session
+  // multiplexed over the browser-wide WebSocket, so attaching the Nth target
+  // costs one CDP command instead of a new connection handshake; falls back
+  // to a dedicated connection when the shared one is unavailable.
+  std::unique_ptr<DevToolsClient> CreateClientForWebView(const std::string& id);
+
+  // Fills |views_info| from the target tracker's event-maintained snapshot,
+  // falling back to a fetch of the DevTools HTTP target list when target
+  // discovery is unavailable.
+  Status GetWebViewsInfo(WebViewsInfo* views_info);
+
+  // Keeps the target list current from Target events on
+  // |devtools_websocket_client_|.
+  std::unique_ptr<TargetTracker> target_tracker_;
+
+  std::unique_ptr<WindowCacheInvalidator> window_cache_invalidator_;
+
+  // Window bounds served to rect reads without a round trip, keyed by
+  // target id. Valid only while the driver is the sole geometry mutator:
+  // entries for a window are dropped when the driver changes its bounds,
+  // and the whole cache on reconnect.
+  std::map<std::string, Window> window_cache_;
+
+  // Pre-created blank targets, at most one per window type.
+  std::list<PooledTarget> target_pool_;
+
+  // The last web view this session activated, used to elide the activation
+  // round trip when a command re-activates the same view. Trusted only while
+  // the target tracker is active and its revision matches
+  // |active_target_list_revision_|; a target appearing or disappearing can
+  // move focus, so either event invalidates the skip.
+  std::string active_web_view_id_;
+  uint64_t active_target_list_revision_;
+
   // Web views in this list are in the same order as they are opened.
-  std::list<std::unique_ptr<WebViewImpl>> web_views_;
+  std::list<WebViewEntry> web_views_;
   std::vector<std::unique_ptr<DevToolsEventListener>> devtools_event_listeners_;
   std::string page_load_strategy_;
 };
@@ -18,6 +18,10 @@
 
 namespace {
 
+// How many identical consecutive messages are stored per second by default;
+// see ConsoleLogger::set_max_identical_entries_per_second.
+const int kDefaultMaxIdenticalEntriesPerSecond = 10;
+
 // Translates DevTools log level strings into Log::Level.
 bool ConsoleLevelToLogLevel(const std::string& name, Log::Level *out_level) {
   if (name == "verbose" || name == "debug" || name == "timeEnd")
@@ -36,15 +40,20 @@ bool ConsoleLevelToLogLevel(const std::string& name, Log::Level *out_level) {
 }  // namespace
 
 ConsoleLogger::ConsoleLogger(Log* log)
-    : log_(log) {}
+    : log_(log),
+      max_identical_entries_per_second_(kDefaultMaxIdenticalEntriesPerSecond),
+      last_level_(Log::kOff),
+      entries_this_window_(0),
+      suppressed_count_(0) {}
 
 Status ConsoleLogger::OnConnected(DevToolsClient* client) {
-  base::DictionaryValue params;
-  Status status = client->SendCommand("Log.enable", params);
+  Status status = client->EnableDomain("Log");
   if (status.IsError()) {
     return status;
   }
-  return client->SendCommand("Runtime.enable", params);
+  // Runtime is shared with FrameTracker; the reference count in the client
+  // makes sure only one enable command actually goes out.
+  return client->EnableDomain("Runtime");
 }
 
 Status ConsoleLogger::OnEvent(
@@ -93,10 +102,10 @@ Status ConsoleLogger::OnLogEntryAdded(const base::DictionaryValue& params) {
   if (!entry->GetString("text", &text))
     return Status(kUnknownError, "missing or invalid 'entry.text'");
 
-  log_->AddEntry(level, source, base::StringPrintf("%s %s %s",
-                                                   origin.c_str(),
-                                                   line_number.c_str(),
-                                                   text.c_str()));
+  AddEntryDeduped(level, source, base::StringPrintf("%s %s %s",
+                                                    origin.c_str(),
+                                                    line_number.c_str(),
+                                                    text.c_str()));
   return Status(kOk);
 }
 
@@ -167,10 +176,10 @@ Status ConsoleLogger::OnRuntimeConsoleApiCalled(
     text += temp_text;
    }
 
-  log_->AddEntry(level, "console-api", base::StringPrintf("%s %s %s",
-                                                          origin.c_str(),
-                                                          line_column.c_str(),
-                                                          text.c_str()));
+  AddEntryDeduped(level, "console-api", base::StringPrintf("%s %s %s",
+                                                           origin.c_str(),
+                                                           line_column.c_str(),
+                                                           text.c_str()));
   return Status(kOk);
 }
 
@@ -223,7 +232,40 @@ Status ConsoleLogger::OnRuntimeExceptionThrown(
       return Status(kUnknownError, "missing or invalid exception message text");
   }
 
-  log_->AddEntry(Log::kError, "javascript", base::StringPrintf(
+  AddEntryDeduped(Log::kError, "javascript", base::StringPrintf(
       "%s %s %s", origin.c_str(), line_column.c_str(), text.c_str()));
   return Status(kOk);
 }
+
+void ConsoleLogger::AddEntryDeduped(Log::Level level,
+                                    const std::string& source,
+                                    const std::string& message) {
+  base::TimeTicks now = base::TimeTicks::Now();
+  bool repeats_last = level == last_level_ && source == last_source_ &&
+                      message == last_message_;
+  if (!repeats_last ||
+      now - window_start_ >= base::TimeDelta::FromSeconds(1)) {
+    FlushSuppressedEntries();
+    last_level_ = level;
+    last_source_ = source;
+    last_message_ = message;
+    window_start_ = now;
+    entries_this_window_ = 0;
+  }
+  if (entries_this_window_ < max_identical_entries_per_second_) {
+    entries_this_window_++;
+    log_->AddEntry(level, source, message);
+  } else {
+    suppressed_count_++;
+  }
+}
+
+void ConsoleLogger::FlushSuppressedEntries() {
+  if (!suppressed_count_)
+    return;
+  log_->AddEntry(
+      last_level_, last_source_,
+      base::StringPrintf("%s (message repeated %d more times)",
+                         last_message_.c_str(), suppressed_count_));
+  suppressed_count_ = 0;
+}
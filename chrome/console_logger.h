@@ -5,8 +5,11 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_CHROME_CONSOLE_LOGGER_H_
 #define CHROME_TEST_CHROMEDRIVER_CHROME_CONSOLE_LOGGER_H_
 
+#include <string>
+
 #include "base/compiler_specific.h"
 #include "base/macros.h"
+#include "base/time/time.h"
 #include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
 
 class Log;
@@ -30,6 +33,13 @@ class ConsoleLogger : public DevToolsEventListener {
                  const std::string& method,
                  const base::DictionaryValue& params) override;
 
+  // Caps how many identical consecutive messages are stored per second.
+  // Repeats beyond the cap are collapsed into one summary entry, so pages
+  // that log in a tight loop do not flood the log.
+  void set_max_identical_entries_per_second(int max) {
+    max_identical_entries_per_second_ = max;
+  }
+
  private:
   Log* log_;  // The log where to create entries.
 
@@ -37,6 +47,25 @@ class ConsoleLogger : public DevToolsEventListener {
   Status OnRuntimeConsoleApiCalled(const base::DictionaryValue& params);
   Status OnRuntimeExceptionThrown(const base::DictionaryValue& params);
 
+  // Stores the entry in the log, unless it repeats the previous entry faster
+  // than the per-second cap; excess repeats are counted and flushed as one
+  // summary entry when a different message arrives or a new second starts.
+  void AddEntryDeduped(Log::Level level,
+                       const std::string& source,
+                       const std::string& message);
+  void FlushSuppressedEntries();
+
+  int max_identical_entries_per_second_;
+  // The (level, source, message) tuple of the last entry seen, plus how many
+  // times it was stored in the current one-second window and how many repeats
+  // were suppressed beyond the cap.
+  Log::Level last_level_;
+  std::string last_source_;
+  std::string last_message_;
+  int entries_this_window_;
+  int suppressed_count_;
+  base::TimeTicks window_start_;
+
   DISALLOW_COPY_AND_ASSIGN(ConsoleLogger);
 };
 
@@ -190,3 +190,50 @@ TEST(ConsoleLogger, ConsoleMessages) {
   ValidateLogEntry(log.GetEntries()[1].get(), Log::kInfo, "source2",
                    "source2 - text2");
 }
+
+TEST(ConsoleLogger, DedupesRepeatedMessages) {
+  FakeDevToolsClient client("webview");
+  FakeLog log;
+  ConsoleLogger logger(&log);
+  logger.set_max_identical_entries_per_second(2);
+  client.AddListener(&logger);
+
+  base::DictionaryValue repeated;
+  ConsoleLogParams(&repeated, "source", "url", "log", 1, "looping");
+  for (int i = 0; i < 5; ++i)
+    ASSERT_EQ(kOk, client.TriggerEvent("Log.entryAdded", repeated).code());
+
+  // Only the first two repeats within the window are stored directly.
+  ASSERT_EQ(2u, log.GetEntries().size());
+  ValidateLogEntry(log.GetEntries()[0].get(), Log::kInfo, "source",
+                   "url 1 looping");
+  ValidateLogEntry(log.GetEntries()[1].get(), Log::kInfo, "source",
+                   "url 1 looping");
+
+  // A different message flushes the suppressed repeats as one summary entry.
+  base::DictionaryValue other;
+  ConsoleLogParams(&other, "source", "url", "log", 2, "done");
+  ASSERT_EQ(kOk, client.TriggerEvent("Log.entryAdded", other).code());
+  ASSERT_EQ(4u, log.GetEntries().size());
+  ValidateLogEntry(log.GetEntries()[2].get(), Log::kInfo, "source",
+                   "url 1 looping (message repeated 3 more times)");
+  ValidateLogEntry(log.GetEntries()[3].get(), Log::kInfo, "source",
+                   "url 2 done");
+}
+
+TEST(ConsoleLogger, DistinctMessagesAreNotDeduped) {
+  FakeDevToolsClient client("webview");
+  FakeLog log;
+  ConsoleLogger logger(&log);
+  logger.set_max_identical_entries_per_second(1);
+  client.AddListener(&logger);
+
+  for (int i = 0; i < 3; ++i) {
+    base::DictionaryValue params;
+    ConsoleLogParams(&params, "source", "url", "log", i, "text");
+    ASSERT_EQ(kOk, client.TriggerEvent("Log.entryAdded", params).code());
+  }
+
+  // Differing line numbers make each message unique, so all are stored.
+  ASSERT_EQ(3u, log.GetEntries().size());
+}
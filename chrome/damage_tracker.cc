@@ -0,0 +1,125 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/damage_tracker.h"
+
+#include <algorithm>
+
+#include "base/values.h"
+#include "chrome/test/chromedriver/chrome/devtools_client.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+
+namespace {
+
+// Past this many distinct rects the bookkeeping and per-rect captures cost
+// more than they save; collapse everything into one bounding rect instead.
+const size_t kMaxDamageRects = 8;
+
+bool Intersects(const DamageTracker::Rect& a, const DamageTracker::Rect& b) {
+  return a.x < b.x + b.width && b.x < a.x + a.width &&
+         a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+DamageTracker::Rect Union(const DamageTracker::Rect& a,
+                          const DamageTracker::Rect& b) {
+  DamageTracker::Rect result;
+  result.x = std::min(a.x, b.x);
+  result.y = std::min(a.y, b.y);
+  result.width = std::max(a.x + a.width, b.x + b.width) - result.x;
+  result.height = std::max(a.y + a.height, b.y + b.height) - result.y;
+  return result;
+}
+
+}  // namespace
+
+DamageTracker::DamageTracker(DevToolsClient* client)
+    : client_(client), tracking_(false), has_baseline_(false), frame_id_(0) {
+  client->ConnectIfNecessary();
+  client->AddListener(this);
+}
+
+DamageTracker::~DamageTracker() = default;
+
+Status DamageTracker::EnsureTracking() {
+  if (tracking_)
+    return Status(kOk);
+  Status status =
+      client_->SendCommand("LayerTree.enable", base::DictionaryValue());
+  if (status.IsError())
+    return status;
+  tracking_ = true;
+  return Status(kOk);
+}
+
+void DamageTracker::SetBaseline() {
+  has_baseline_ = true;
+  frame_id_++;
+  rects_.clear();
+}
+
+std::vector<DamageTracker::Rect> DamageTracker::TakeDamageRects() {
+  std::vector<Rect> taken;
+  taken.swap(rects_);
+  if (!taken.empty())
+    frame_id_++;
+  return taken;
+}
+
+Status DamageTracker::OnConnected(DevToolsClient* client) {
+  if (!tracking_)
+    return Status(kOk);
+  // The connection was re-established, which resets the browser-side domain
+  // and may have skipped paints; the client must resync with a full frame.
+  has_baseline_ = false;
+  rects_.clear();
+  return client->SendCommandAndIgnoreResponse("LayerTree.enable",
+                                              base::DictionaryValue());
+}
+
+std::vector<std::string> DamageTracker::SubscribedMethodPrefixes() const {
+  return {"LayerTree.layerPainted"};
+}
+
+Status DamageTracker::OnEvent(DevToolsClient* client,
+                              const std::string& method,
+                              const base::DictionaryValue& params) {
+  if (method == "LayerTree.layerPainted") {
+    Rect rect;
+    if (!params.GetDouble("clip.x", &rect.x) ||
+        !params.GetDouble("clip.y", &rect.y) ||
+        !params.GetDouble("clip.width", &rect.width) ||
+        !params.GetDouble("clip.height", &rect.height)) {
+      // A malformed paint event must not be dropped silently: without its
+      // rect the accumulated damage understates what changed, so force the
+      // next delta to resync with a full frame.
+      has_baseline_ = false;
+      return Status(kOk);
+    }
+    if (rect.width > 0 && rect.height > 0)
+      AddRect(rect);
+  }
+  return Status(kOk);
+}
+
+void DamageTracker::AddRect(const Rect& rect) {
+  // Fold the new rect into any rect it touches; repainted regions routinely
+  // overlap frame to frame, and overlapping captures would be wasted bytes.
+  Rect merged = rect;
+  std::vector<Rect> kept;
+  for (const Rect& existing : rects_) {
+    if (Intersects(existing, merged))
+      merged = Union(existing, merged);
+    else
+      kept.push_back(existing);
+  }
+  kept.push_back(merged);
+  if (kept.size() > kMaxDamageRects) {
+    Rect all = kept[0];
+    for (size_t i = 1; i < kept.size(); ++i)
+      all = Union(all, kept[i]);
+    kept.clear();
+    kept.push_back(all);
+  }
+  rects_.swap(kept);
+}
@@ -0,0 +1,76 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_CHROME_DAMAGE_TRACKER_H_
+#define CHROME_TEST_CHROMEDRIVER_CHROME_DAMAGE_TRACKER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
+
+class DevToolsClient;
+class Status;
+
+// Accumulates compositor damage between incremental screenshot requests.
+//
+// Listens for LayerTree.layerPainted events, whose clip rect is the damage
+// the compositor actually repainted, and coalesces them into a small rect
+// list. Serving a capture per damaged rect instead of a full-viewport frame
+// is what makes steady-state visual monitoring cheap: consecutive frames
+// are usually >95% identical.
+class DamageTracker : public DevToolsEventListener {
+ public:
+  struct Rect {
+    double x;
+    double y;
+    double width;
+    double height;
+  };
+
+  explicit DamageTracker(DevToolsClient* client);
+  ~DamageTracker() override;
+
+  // Enables LayerTree events on the first call; later calls are free.
+  Status EnsureTracking();
+
+  // True once a full frame has been served since tracking (re)started, so
+  // the accumulated rects describe changes against a frame the client has.
+  bool has_baseline() const { return has_baseline_; }
+
+  // Marks the current state as the client's baseline and drops any damage
+  // accumulated before it. Called after serving a full frame.
+  void SetBaseline();
+
+  // Identifies the frame the accumulated damage is relative to; bumped by
+  // TakeDamageRects when there was damage to hand out.
+  int frame_id() const { return frame_id_; }
+
+  bool HasDamage() const { return !rects_.empty(); }
+
+  // Returns the coalesced damage since the last call (or SetBaseline) and
+  // clears it, advancing frame_id() when non-empty.
+  std::vector<Rect> TakeDamageRects();
+
+  // Overridden from DevToolsEventListener:
+  Status OnConnected(DevToolsClient* client) override;
+  Status OnEvent(DevToolsClient* client,
+                 const std::string& method,
+                 const base::DictionaryValue& params) override;
+  std::vector<std::string> SubscribedMethodPrefixes() const override;
+
+ private:
+  void AddRect(const Rect& rect);
+
+  DevToolsClient* client_;
+  bool tracking_;
+  bool has_baseline_;
+  int frame_id_;
+  std::vector<Rect> rects_;
+
+  DISALLOW_COPY_AND_ASSIGN(DamageTracker);
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_CHROME_DAMAGE_TRACKER_H_
@@ -0,0 +1,98 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/damage_tracker.h"
+
+#include "base/values.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/chrome/stub_devtools_client.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+base::DictionaryValue MakePaintEvent(double x,
+                                     double y,
+                                     double width,
+                                     double height) {
+  base::DictionaryValue params;
+  params.SetInteger("layerId", 1);
+  params.SetDouble("clip.x", x);
+  params.SetDouble("clip.y", y);
+  params.SetDouble("clip.width", width);
+  params.SetDouble("clip.height", height);
+  return params;
+}
+
+void SendPaint(DamageTracker* tracker,
+               DevToolsClient* client,
+               double x,
+               double y,
+               double width,
+               double height) {
+  base::DictionaryValue params = MakePaintEvent(x, y, width, height);
+  ASSERT_EQ(kOk,
+            tracker->OnEvent(client, "LayerTree.layerPainted", params).code());
+}
+
+}  // namespace
+
+TEST(DamageTracker, AccumulatesAndTakesRects) {
+  StubDevToolsClient client;
+  DamageTracker tracker(&client);
+  tracker.SetBaseline();
+  ASSERT_FALSE(tracker.HasDamage());
+
+  SendPaint(&tracker, &client, 0, 0, 10, 10);
+  SendPaint(&tracker, &client, 100, 100, 10, 10);
+  ASSERT_TRUE(tracker.HasDamage());
+
+  int frame_id = tracker.frame_id();
+  std::vector<DamageTracker::Rect> rects = tracker.TakeDamageRects();
+  ASSERT_EQ(2U, rects.size());
+  // Taking damage advances the frame and clears the accumulation.
+  ASSERT_EQ(frame_id + 1, tracker.frame_id());
+  ASSERT_FALSE(tracker.HasDamage());
+  ASSERT_TRUE(tracker.TakeDamageRects().empty());
+  ASSERT_EQ(frame_id + 1, tracker.frame_id());
+}
+
+TEST(DamageTracker, MergesOverlappingRects) {
+  StubDevToolsClient client;
+  DamageTracker tracker(&client);
+  SendPaint(&tracker, &client, 0, 0, 10, 10);
+  SendPaint(&tracker, &client, 5, 5, 10, 10);
+
+  std::vector<DamageTracker::Rect> rects = tracker.TakeDamageRects();
+  ASSERT_EQ(1U, rects.size());
+  ASSERT_EQ(0, rects[0].x);
+  ASSERT_EQ(0, rects[0].y);
+  ASSERT_EQ(15, rects[0].width);
+  ASSERT_EQ(15, rects[0].height);
+}
+
+TEST(DamageTracker, CollapsesExcessiveRectsIntoBounds) {
+  StubDevToolsClient client;
+  DamageTracker tracker(&client);
+  // Disjoint rects along a diagonal, past the per-frame cap.
+  for (int i = 0; i < 12; ++i)
+    SendPaint(&tracker, &client, i * 20, i * 20, 10, 10);
+
+  std::vector<DamageTracker::Rect> rects = tracker.TakeDamageRects();
+  ASSERT_EQ(1U, rects.size());
+  ASSERT_EQ(0, rects[0].x);
+  ASSERT_EQ(11 * 20 + 10, rects[0].width);
+}
+
+TEST(DamageTracker, MalformedPaintEventDropsBaseline) {
+  StubDevToolsClient client;
+  DamageTracker tracker(&client);
+  tracker.SetBaseline();
+  ASSERT_TRUE(tracker.has_baseline());
+
+  base::DictionaryValue params;
+  params.SetInteger("layerId", 1);
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(&client, "LayerTree.layerPainted", params).code());
+  ASSERT_FALSE(tracker.has_baseline());
+}
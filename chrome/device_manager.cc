@@ -5,26 +5,186 @@
 #include "chrome/test/chromedriver/chrome/device_manager.h"
 
 #include <algorithm>
+#include <memory>
+#include <utility>
 #include <vector>
 
+#include "base/atomic_sequence_num.h"
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/callback_helpers.h"
 #include "base/check.h"
 #include "base/containers/contains.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted_memory.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
+#include "base/task/thread_pool/thread_pool_instance.h"
 #include "chrome/test/chromedriver/chrome/adb.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 
 const char kChromeCmdLineFile[] = "/data/local/tmp/chrome-command-line";
 
+namespace {
+
+// Released forwards older than this are killed the next time the registry
+// is asked to reap, covering farms whose devices come and go.
+const int kForwardIdleReapMinutes = 5;
+
+// How many bytes of logcat output each session may have buffered before its
+// oldest lines are evicted, bounding driver memory when a session runs for
+// a long time without reading its log.
+const size_t kLogcatConsumerBufferBytes = 1 << 20;
+
+// Consumer ids must be unique across DeviceManager instances because the
+// demuxer callback outlives any one session.
+base::AtomicSequenceNumber g_logcat_consumer_ids;
+
+std::string ForwardKey(const std::string& device_serial,
+                       const std::string& device_socket) {
+  return device_serial + "\n" + device_socket;
+}
+
+}  // namespace
+
+ForwardRegistry::ForwardRegistry() {}
+
+ForwardRegistry::~ForwardRegistry() {}
+
+bool ForwardRegistry::Claim(const std::string& device_serial,
+                            const std::string& device_socket,
+                            int* local_port) {
+  base::AutoLock lock(lock_);
+  auto it = entries_.find(ForwardKey(device_serial, device_socket));
+  if (it == entries_.end())
+    return false;
+  it->second.use_count++;
+  *local_port = it->second.local_port;
+  return true;
+}
+
+void ForwardRegistry::Register(const std::string& device_serial,
+                               const std::string& device_socket,
+                               int local_port) {
+  base::AutoLock lock(lock_);
+  Entry& entry = entries_[ForwardKey(device_serial, device_socket)];
+  entry.serial = device_serial;
+  entry.local_port = local_port;
+  entry.use_count = 1;
+}
+
+void ForwardRegistry::Release(const std::string& device_serial,
+                              const std::string& device_socket) {
+  base::AutoLock lock(lock_);
+  auto it = entries_.find(ForwardKey(device_serial, device_socket));
+  if (it == entries_.end())
+    return;
+  if (it->second.use_count > 0)
+    it->second.use_count--;
+  if (it->second.use_count == 0)
+    it->second.last_release = base::TimeTicks::Now();
+}
+
+void ForwardRegistry::Drop(const std::string& device_serial,
+                           const std::string& device_socket) {
+  base::AutoLock lock(lock_);
+  entries_.erase(ForwardKey(device_serial, device_socket));
+}
+
+void ForwardRegistry::ReapIdle(Adb* adb, const base::TimeDelta& max_idle) {
+  std::vector<std::pair<std::string, int>> to_kill;
+  {
+    base::AutoLock lock(lock_);
+    base::TimeTicks now = base::TimeTicks::Now();
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->second.use_count == 0 &&
+          now - it->second.last_release >= max_idle) {
+        to_kill.push_back(
+            std::make_pair(it->second.serial, it->second.local_port));
+        it = entries_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  // Kill outside the lock; each kill is an adb server round trip.
+  for (const auto& kill : to_kill)
+    adb->KillForwardPort(kill.first, kill.second);
+}
+
+LogcatDemuxer::LogcatDemuxer() {}
+
+LogcatDemuxer::~LogcatDemuxer() {}
+
+void LogcatDemuxer::OnLogcatLine(const std::string& line) {
+  int line_pid = 0;
+  bool has_pid = GetLinePid(line, &line_pid);
+  base::AutoLock lock(lock_);
+  for (auto& entry : consumers_) {
+    Consumer& consumer = entry.second;
+    if (consumer.pid != 0 && (!has_pid || line_pid != consumer.pid))
+      continue;
+    consumer.lines.push_back(line);
+    consumer.buffered_bytes += line.size();
+    while (consumer.buffered_bytes > kLogcatConsumerBufferBytes) {
+      consumer.buffered_bytes -= consumer.lines.front().size();
+      consumer.lines.pop_front();
+    }
+  }
+}
+
+void LogcatDemuxer::AttachConsumer(int consumer_id, int pid) {
+  base::AutoLock lock(lock_);
+  Consumer& consumer = consumers_[consumer_id];
+  consumer.pid = pid;
+  consumer.buffered_bytes = 0;
+  consumer.lines.clear();
+}
+
+void LogcatDemuxer::DetachConsumer(int consumer_id) {
+  base::AutoLock lock(lock_);
+  consumers_.erase(consumer_id);
+}
+
+void LogcatDemuxer::ReadAndClearLines(int consumer_id,
+                                      std::vector<std::string>* lines) {
+  base::AutoLock lock(lock_);
+  auto it = consumers_.find(consumer_id);
+  if (it == consumers_.end())
+    return;
+  for (std::string& line : it->second.lines)
+    lines->push_back(std::move(line));
+  it->second.lines.clear();
+  it->second.buffered_bytes = 0;
+}
+
+// static
+bool LogcatDemuxer::GetLinePid(const std::string& line, int* pid) {
+  // threadtime format: "MM-DD HH:MM:SS.mmm  PID  TID LEVEL TAG: message",
+  // so the pid is the third whitespace-separated token.
+  std::vector<base::StringPiece> tokens = base::SplitStringPiece(
+      line, base::kWhitespaceASCII, base::TRIM_WHITESPACE,
+      base::SPLIT_WANT_NONEMPTY);
+  if (tokens.size() < 3)
+    return false;
+  return base::StringToInt(tokens[2], pid);
+}
+
 Device::Device(const std::string& device_serial,
                Adb* adb,
+               ForwardRegistry* forward_registry,
+               LogcatDemuxer* logcat_demuxer,
                base::OnceCallback<void()> release_callback)
     : serial_(device_serial),
       adb_(adb),
+      forward_registry_(forward_registry),
+      logcat_demuxer_(logcat_demuxer),
+      logcat_consumer_id_(g_logcat_consumer_ids.GetNext()),
       release_callback_(std::move(release_callback)) {}
 
 Device::~Device() {
@@ -38,6 +198,77 @@ bool IsValidExecName(const std::string& exec_name) {
          }) == exec_name.end();
 }
 
+namespace {
+
+// Runs one independent pre-launch adb step and signals completion; used to
+// overlap the steps on the thread pool.
+void RunDeviceSetUpStep(base::OnceCallback<Status()> step,
+                        Status* result,
+                        base::WaitableEvent* done) {
+  *result = std::move(step).Run();
+  done->Signal();
+}
+
+// Runs the given adb steps, concurrently when the thread pool is available
+// (it is not in unit tests), and returns the first error in the order the
+// steps were given, matching the former sequential error precedence.
+Status RunDeviceSetUpSteps(std::vector<base::OnceCallback<Status()>> steps) {
+  std::vector<Status> results(steps.size(), Status(kOk));
+  if (base::ThreadPoolInstance::Get()) {
+    std::vector<std::unique_ptr<base::WaitableEvent>> done_events;
+    for (size_t i = 0; i < steps.size(); ++i) {
+      done_events.push_back(std::make_unique<base::WaitableEvent>());
+      base::ThreadPool::PostTask(
+          FROM_HERE, {base::MayBlock()},
+          base::BindOnce(&RunDeviceSetUpStep, std::move(steps[i]), &results[i],
+                         done_events[i].get()));
+    }
+    for (const auto& done : done_events)
+      done->Wait();
+  } else {
+    for (size_t i = 0; i < steps.size(); ++i)
+      results[i] = std::move(steps[i]).Run();
+  }
+  for (const Status& result : results) {
+    if (result.IsError())
+      return result;
+  }
+  return Status(kOk);
+}
+
+// Binding the content as a RefCountedString keeps one copy in memory no
+// matter how many devices the push fans out to.
+Status SendFileStep(Adb* adb,
+                    const std::string& serial,
+                    const std::string& remote_path,
+                    scoped_refptr<base::RefCountedString> content) {
+  Status status = adb->SendFile(serial, remote_path, content->data());
+  if (status.IsError()) {
+    return Status(kUnknownError,
+                  "Failed to push " + remote_path + " to device " + serial,
+                  status);
+  }
+  return status;
+}
+
+Status SetCommandLineFileStep(Adb* adb,
+                              const std::string& serial,
+                              const std::string& command_line_file,
+                              const std::string& exec_name,
+                              const std::string& args) {
+  Status status =
+      adb->SetCommandLineFile(serial, command_line_file, exec_name, args);
+  if (status.IsError()) {
+    return Status(kUnknownError,
+                  "Failed to set Chrome's command line file on device " +
+                      serial,
+                  status);
+  }
+  return status;
+}
+
+}  // namespace
+
 Status Device::SetUp(const std::string& package,
                      const std::string& activity,
                      const std::string& process,
@@ -50,10 +281,6 @@ Status Device::SetUp(const std::string& package,
     return Status(kUnknownError,
         active_package_ + " was launched and has not been quit");
 
-  Status status = adb_->CheckAppInstalled(serial_, package);
-  if (status.IsError())
-    return status;
-
   std::string known_activity;
   std::string command_line_file;
   std::string known_device_socket;
@@ -96,7 +323,25 @@ Status Device::SetUp(const std::string& package,
     known_exec_name = "weblayer_shell";
   }
 
+  // The pre-launch steps are independent of one another: the debug-app flag
+  // and the command line file live outside the app data that gets cleared.
+  // Collecting them and running them concurrently saves a device round trip
+  // per step, which adds up on slow devices and busy farms.
+  std::vector<base::OnceCallback<Status()>> steps;
+  steps.push_back(base::BindOnce(&Adb::CheckAppInstalled,
+                                 base::Unretained(adb_), serial_, package));
+
   if (!use_running_app) {
+    if (!known_activity.empty()) {
+      if (!activity.empty() ||
+          !process.empty())
+        return Status(kUnknownError, "known package " + package +
+                      " does not accept activity/process");
+    } else if (activity.empty()) {
+      return Status(kUnknownError,
+                    "WebView/WebLayer apps require activity name");
+    }
+
     if (use_debug_flag) {
       // Some apps (such as Google Chrome) read command line from different
       // locations depending on if the app debug flag is set. When the debug
@@ -108,35 +353,24 @@ Status Device::SetUp(const std::string& package,
       // * It's too late to set the command line if the app is already running.
       // * Setting the debug flag has the side effect of shutting down the app,
       //   preventing use_running_app from working.
-      status = adb_->SetDebugApp(serial_, package);
-      if (status.IsError())
-        return status;
+      steps.push_back(base::BindOnce(&Adb::SetDebugApp, base::Unretained(adb_),
+                                     serial_, package));
     }
 
-    status = adb_->ClearAppData(serial_, package);
-    if (status.IsError())
-      return status;
-
-    if (!known_activity.empty()) {
-      if (!activity.empty() ||
-          !process.empty())
-        return Status(kUnknownError, "known package " + package +
-                      " does not accept activity/process");
-    } else if (activity.empty()) {
-      return Status(kUnknownError,
-                    "WebView/WebLayer apps require activity name");
-    }
+    steps.push_back(base::BindOnce(&Adb::ClearAppData, base::Unretained(adb_),
+                                   serial_, package));
 
     if (!command_line_file.empty()) {
-      status = adb_->SetCommandLineFile(serial_, command_line_file,
-                                        known_exec_name, args);
-      if (status.IsError())
-        return Status(
-            kUnknownError,
-            "Failed to set Chrome's command line file on device " + serial_,
-            status);
+      steps.push_back(base::BindOnce(&SetCommandLineFileStep, adb_, serial_,
+                                     command_line_file, known_exec_name, args));
     }
+  }
+
+  Status status = RunDeviceSetUpSteps(std::move(steps));
+  if (status.IsError())
+    return status;
 
+  if (!use_running_app) {
     status = adb_->Launch(serial_, package,
                           known_activity.empty() ? activity : known_activity);
     if (status.IsError())
@@ -144,8 +378,27 @@ Status Device::SetUp(const std::string& package,
 
     active_package_ = package;
   }
-  return this->ForwardDevtoolsPort(package, process, &known_device_socket,
-                                   devtools_port);
+  status = this->ForwardDevtoolsPort(package, process, &known_device_socket,
+                                     devtools_port);
+  if (status.IsError())
+    return status;
+
+  // Begin buffering the app's console output now, so later log reads are
+  // served from memory instead of polling the adb server. Best effort: a
+  // session without console logs is still usable, so failures only warn.
+  int pid = app_pid_;
+  if (pid == 0) {
+    Status pid_status = adb_->GetPidByName(
+        serial_, process.empty() ? package : process, &pid);
+    if (pid_status.IsError())
+      pid = 0;  // Fall back to capturing the whole device log.
+  }
+  Status capture_status = StartLogcatCapture(pid);
+  if (capture_status.IsError()) {
+    LOG(WARNING) << "Failed to start logcat capture on device " << serial_
+                 << ": " << capture_status.message();
+  }
+  return status;
 }
 
 Status Device::ForwardDevtoolsPort(const std::string& package,
@@ -188,15 +441,67 @@ Status Device::ForwardDevtoolsPort(const std::string& package,
     }
     // When used in adb with "localabstract:", the leading '@' is not needed.
     *device_socket = socket_name.substr(1);
+    app_pid_ = pid;
+  }
+
+  // Reuse a forward left over from an earlier session on this device when
+  // the caller doesn't demand a specific port. Re-issuing the same forward
+  // spec is idempotent on the adb server and costs a single round trip, so
+  // it doubles as the liveness check.
+  if (*devtools_port == 0) {
+    int claimed_port = 0;
+    if (forward_registry_->Claim(serial_, *device_socket, &claimed_port)) {
+      int port = claimed_port;
+      Status status = adb_->ForwardPort(serial_, *device_socket, &port);
+      if (status.IsOk()) {
+        devtools_port_ = port;
+        forwarded_socket_ = *device_socket;
+        *devtools_port = port;
+        return status;
+      }
+      // The device or forward went away; fall through to a fresh forward.
+      forward_registry_->Drop(serial_, *device_socket);
+    }
   }
 
   Status status = adb_->ForwardPort(serial_, *device_socket, devtools_port);
-  if (status.IsOk())
+  if (status.IsOk()) {
     devtools_port_ = *devtools_port;
+    forwarded_socket_ = *device_socket;
+    forward_registry_->Register(serial_, *device_socket, *devtools_port);
+  }
   return status;
 }
 
+Status Device::StartLogcatCapture(int pid) {
+  // The demuxer is owned by the DeviceManager and outlives both this
+  // session and the stream, so handing it to the IO thread unretained is
+  // safe.
+  Status status = adb_->OpenLogcatStream(
+      serial_, base::BindRepeating(&LogcatDemuxer::OnLogcatLine,
+                                   base::Unretained(logcat_demuxer_)));
+  if (status.IsError())
+    return status;
+  logcat_demuxer_->AttachConsumer(logcat_consumer_id_, pid);
+  logcat_capturing_ = true;
+  return Status(kOk);
+}
+
+Status Device::ReadLogcatLines(std::vector<std::string>* lines) {
+  if (!logcat_capturing_)
+    return Status(kUnknownError, "logcat capture is not running");
+  logcat_demuxer_->ReadAndClearLines(logcat_consumer_id_, lines);
+  return Status(kOk);
+}
+
 Status Device::TearDown() {
+  if (logcat_capturing_) {
+    // Only this session's buffer is dropped; the device's logcat stream
+    // stays open for the next session.
+    logcat_demuxer_->DetachConsumer(logcat_consumer_id_);
+    logcat_capturing_ = false;
+  }
+  app_pid_ = 0;
   if (!active_package_.empty()) {
     std::string response;
     Status status = adb_->ForceStop(serial_, active_package_);
@@ -205,10 +510,13 @@ Status Device::TearDown() {
     active_package_ = "";
   }
   if (devtools_port_ != 0) {
-    Status status = adb_->KillForwardPort(serial_, devtools_port_);
-    if (status.IsError())
-      return status;
+    // Leave the forward alive for the next session on this device instead
+    // of killing it; the registry reaps it if nobody reclaims it.
+    forward_registry_->Release(serial_, forwarded_socket_);
+    forward_registry_->ReapIdle(
+        adb_, base::TimeDelta::FromMinutes(kForwardIdleReapMinutes));
     devtools_port_ = 0;
+    forwarded_socket_.clear();
   }
   return Status(kOk);
 }
@@ -217,7 +525,12 @@ DeviceManager::DeviceManager(Adb* adb) : adb_(adb) {
   CHECK(adb_);
 }
 
-DeviceManager::~DeviceManager() {}
+DeviceManager::~DeviceManager() {
+  // Best effort at process shutdown: close the device streams before the
+  // demuxers they feed are destroyed.
+  for (const auto& entry : logcat_demuxers_)
+    adb_->CloseLogcatStream(entry.first);
+}
 
 Status DeviceManager::AcquireDevice(std::unique_ptr<Device>* device) {
   std::vector<std::string> devices;
@@ -265,6 +578,21 @@ Status DeviceManager::AcquireSpecificDevice(const std::string& device_serial,
   return status;
 }
 
+Status DeviceManager::SendFileToDevices(
+    const std::vector<std::string>& device_serials,
+    const std::string& remote_path,
+    const std::string& content) {
+  std::string content_copy = content;
+  scoped_refptr<base::RefCountedString> shared_content =
+      base::RefCountedString::TakeString(&content_copy);
+  std::vector<base::OnceCallback<Status()>> steps;
+  for (const std::string& serial : device_serials) {
+    steps.push_back(base::BindOnce(&SendFileStep, adb_, serial, remote_path,
+                                   shared_content));
+  }
+  return RunDeviceSetUpSteps(std::move(steps));
+}
+
 void DeviceManager::ReleaseDevice(const std::string& device_serial) {
   base::AutoLock lock(devices_lock_);
   active_devices_.remove(device_serial);
@@ -272,7 +600,10 @@ void DeviceManager::ReleaseDevice(const std::string& device_serial) {
 
 Device* DeviceManager::LockDevice(const std::string& device_serial) {
   active_devices_.push_back(device_serial);
-  return new Device(device_serial, adb_,
+  std::unique_ptr<LogcatDemuxer>& demuxer = logcat_demuxers_[device_serial];
+  if (!demuxer)
+    demuxer = std::make_unique<LogcatDemuxer>();
+  return new Device(device_serial, adb_, &forward_registry_, demuxer.get(),
                     base::BindOnce(&DeviceManager::ReleaseDevice,
                                    base::Unretained(this), device_serial));
 }
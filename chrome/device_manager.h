@@ -5,20 +5,115 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_CHROME_DEVICE_MANAGER_H_
 #define CHROME_TEST_CHROMEDRIVER_CHROME_DEVICE_MANAGER_H_
 
+#include <deque>
 #include <list>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/callback.h"
 #include "base/compiler_specific.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/synchronization/lock.h"
+#include "base/time/time.h"
 
 class Adb;
 class Status;
 class DeviceManager;
 
+// Keeps established adb port forwards alive across sessions on the same
+// device. Quitting a session releases its forward instead of killing it, so
+// the next session on that device reuses the local port after a single
+// liveness round trip rather than a kill/re-forward pair. Released forwards
+// that nobody reclaims are reaped once they have sat idle for a while.
+// Thread-safe; sessions run on different threads.
+class ForwardRegistry {
+ public:
+  ForwardRegistry();
+  ~ForwardRegistry();
+
+  // If a forward for |device_socket| on |device_serial| is registered,
+  // marks it in use, sets |local_port| and returns true. The caller still
+  // owes a liveness check before relying on it.
+  bool Claim(const std::string& device_serial,
+             const std::string& device_socket,
+             int* local_port);
+
+  // Records a freshly established forward as in use.
+  void Register(const std::string& device_serial,
+                const std::string& device_socket,
+                int local_port);
+
+  // Marks the forward no longer used by a session; it stays alive for
+  // reuse until reaped.
+  void Release(const std::string& device_serial,
+               const std::string& device_socket);
+
+  // Forgets a forward without killing it, for when a claimed forward turns
+  // out to be dead.
+  void Drop(const std::string& device_serial,
+            const std::string& device_socket);
+
+  // Kills and forgets forwards that have been idle for longer than
+  // |max_idle|.
+  void ReapIdle(Adb* adb, const base::TimeDelta& max_idle);
+
+ private:
+  struct Entry {
+    std::string serial;
+    int local_port;
+    int use_count;
+    base::TimeTicks last_release;
+  };
+
+  base::Lock lock_;
+  std::map<std::string, Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(ForwardRegistry);
+};
+
+// Fans one device's logcat stream out to per-session buffers. The adb IO
+// thread appends lines as they arrive; each session attaches a consumer
+// filtered by app pid (0 keeps every line) and drains its own buffer, so
+// serving a log read never touches the adb server. A consumer's buffer is
+// capped by bytes and evicts its oldest lines first. Thread-safe.
+class LogcatDemuxer {
+ public:
+  LogcatDemuxer();
+  ~LogcatDemuxer();
+
+  // Producer side; called once per complete logcat line.
+  void OnLogcatLine(const std::string& line);
+
+  // Starts buffering lines whose pid column matches |pid| for |consumer_id|.
+  void AttachConsumer(int consumer_id, int pid);
+
+  // Stops buffering for |consumer_id| and drops whatever it had buffered.
+  void DetachConsumer(int consumer_id);
+
+  // Moves the lines buffered for |consumer_id| since the last read into
+  // |lines|.
+  void ReadAndClearLines(int consumer_id, std::vector<std::string>* lines);
+
+  // Extracts the pid column from a "logcat -v threadtime" line. Returns
+  // false for lines that do not carry one (e.g. buffer headers).
+  static bool GetLinePid(const std::string& line, int* pid);
+
+ private:
+  struct Consumer {
+    int pid = 0;
+    size_t buffered_bytes = 0;
+    std::deque<std::string> lines;
+  };
+
+  base::Lock lock_;
+  std::map<int, Consumer> consumers_;
+
+  DISALLOW_COPY_AND_ASSIGN(LogcatDemuxer);
+};
+
 class Device {
  public:
   ~Device();
@@ -34,11 +129,21 @@ class Device {
 
   Status TearDown();
 
+  // Begins buffering the device's logcat output for this session, keeping
+  // only lines from |pid| (0 keeps everything). Called from SetUp once the
+  // app's pid is known; safe to call when the device stream already exists.
+  Status StartLogcatCapture(int pid);
+
+  // Moves the logcat lines buffered since the last read into |lines|.
+  Status ReadLogcatLines(std::vector<std::string>* lines);
+
  private:
   friend class DeviceManager;
 
   Device(const std::string& device_serial,
          Adb* adb,
+         ForwardRegistry* forward_registry,
+         LogcatDemuxer* logcat_demuxer,
          base::OnceCallback<void()> release_callback);
 
   Status ForwardDevtoolsPort(const std::string& package,
@@ -49,7 +154,14 @@ class Device {
   const std::string serial_;
   std::string active_package_;
   Adb* adb_;
+  ForwardRegistry* forward_registry_;
+  // Owned by the DeviceManager and shared by every session on this device.
+  LogcatDemuxer* logcat_demuxer_;
+  const int logcat_consumer_id_;
+  bool logcat_capturing_ = false;
+  int app_pid_ = 0;
   int devtools_port_ = 0;
+  std::string forwarded_socket_;
   base::OnceCallback<void()> release_callback_;
 
   DISALLOW_COPY_AND_ASSIGN(Device);
@@ -68,6 +180,14 @@ class DeviceManager {
   Status AcquireSpecificDevice(const std::string& device_serial,
                                std::unique_ptr<Device>* device);
 
+  // Pushes |content| to |remote_path| on every listed device, concurrently
+  // when the thread pool is available, sharing one copy of the content
+  // across the pushes. Returns the first error in the order the devices
+  // were given.
+  Status SendFileToDevices(const std::vector<std::string>& device_serials,
+                           const std::string& remote_path,
+                           const std::string& content);
+
  private:
   void ReleaseDevice(const std::string& device_serial);
 
@@ -76,6 +196,11 @@ class DeviceManager {
 
   base::Lock devices_lock_;
   std::list<std::string> active_devices_;
+  ForwardRegistry forward_registry_;
+  // One demuxer per device that has ever been locked, created lazily and
+  // kept for the manager's lifetime so the logcat stream callback always
+  // has a live target.
+  std::map<std::string, std::unique_ptr<LogcatDemuxer>> logcat_demuxers_;
   Adb* adb_;
 
   DISALLOW_COPY_AND_ASSIGN(DeviceManager);
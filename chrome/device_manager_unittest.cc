@@ -44,6 +44,12 @@ class FakeAdb : public Adb {
     return Status(kOk);
   }
 
+  Status SendFile(const std::string& device_serial,
+                  const std::string& filename,
+                  const std::string& content) override {
+    return Status(kOk);
+  }
+
   Status CheckAppInstalled(const std::string& device_serial,
                            const std::string& package) override {
     return Status(kOk);
@@ -83,6 +89,23 @@ class FakeAdb : public Adb {
     *socket_name = "@webview_devtools_remote_0";
     return Status(kOk);
   }
+
+  Status OpenLogcatStream(
+      const std::string& device_serial,
+      const base::RepeatingCallback<void(const std::string&)>& on_line)
+      override {
+    on_line_ = on_line;
+    return Status(kOk);
+  }
+
+  Status CloseLogcatStream(const std::string& device_serial) override {
+    on_line_.Reset();
+    return Status(kOk);
+  }
+
+  // The line sink of the last opened stream, so tests can feed fake logcat
+  // output into whatever is on the other end.
+  base::RepeatingCallback<void(const std::string&)> on_line_;
 };
 
 class SucceedsForwardPortFakeAdb : public FakeAdb {
@@ -123,6 +146,25 @@ class FailsForwardPortFakeAdb : public SucceedsForwardPortFakeAdb {
   }
 };
 
+class RecordsSendFileFakeAdb : public FakeAdb {
+ public:
+  RecordsSendFileFakeAdb() {}
+  ~RecordsSendFileFakeAdb() override {}
+
+  Status SendFile(const std::string& device_serial,
+                  const std::string& filename,
+                  const std::string& content) override {
+    pushes_.push_back(device_serial + ":" + filename + ":" + content);
+    if (device_serial == "bad")
+      return Status(kUnknownError);
+    return Status(kOk);
+  }
+
+  const std::vector<std::string>& pushes() const { return pushes_; }
+
+ private:
+  std::vector<std::string> pushes_;
+};
 
 }  // namespace
 
@@ -195,8 +237,31 @@ TEST(Device, StartStopApp) {
   ASSERT_TRUE(device1->TearDown().IsOk());
 }
 
-TEST(ForwardPort, Success) {
-  int devtools_port;
+TEST(DeviceManager, SendFileToDevices) {
+  RecordsSendFileFakeAdb adb;
+  DeviceManager device_manager(&adb);
+  std::vector<std::string> serials = {"a", "b"};
+  ASSERT_TRUE(device_manager
+                  .SendFileToDevices(serials, "/data/local/tmp/f", "payload")
+                  .IsOk());
+  ASSERT_EQ(2U, adb.pushes().size());
+  ASSERT_EQ("a:/data/local/tmp/f:payload", adb.pushes()[0]);
+  ASSERT_EQ("b:/data/local/tmp/f:payload", adb.pushes()[1]);
+}
+
+TEST(DeviceManager, SendFileToDevicesReportsFirstError) {
+  RecordsSendFileFakeAdb adb;
+  DeviceManager device_manager(&adb);
+  std::vector<std::string> serials = {"a", "bad", "b"};
+  Status status =
+      device_manager.SendFileToDevices(serials, "/data/local/tmp/f", "x");
+  ASSERT_EQ(kUnknownError, status.code());
+  // The failing device does not stop the pushes to the others.
+  ASSERT_EQ(3U, adb.pushes().size());
+}
+
+TEST(ForwardPort, KeptAliveAfterTearDown) {
+  int devtools_port = 0;
   SucceedsForwardPortFakeAdb adb;
   DeviceManager device_manager(&adb);
   std::unique_ptr<Device> device1;
@@ -204,7 +269,140 @@ TEST(ForwardPort, Success) {
   device1->SetUp("a.chrome.package", "", "",
                  "", "", "", false, &devtools_port);
   device1->TearDown();
+  // The forward outlives the session so the next session on this device
+  // can reclaim it instead of re-establishing it.
+  ASSERT_FALSE(adb.KillForwardPortIsCalled());
+}
+
+TEST(ForwardRegistry, ClaimReleaseReap) {
+  SucceedsForwardPortFakeAdb adb;
+  ForwardRegistry registry;
+  registry.Register("a", "a.socket", 7);
+
+  int port = 0;
+  ASSERT_TRUE(registry.Claim("a", "a.socket", &port));
+  ASSERT_EQ(7, port);
+  ASSERT_FALSE(registry.Claim("a", "b.socket", &port));
+
+  // Two sessions hold the forward; reaping must not touch it until both
+  // released it.
+  registry.Release("a", "a.socket");
+  registry.ReapIdle(&adb, base::TimeDelta());
+  ASSERT_FALSE(adb.KillForwardPortIsCalled());
+
+  registry.Release("a", "a.socket");
+  registry.ReapIdle(&adb, base::TimeDelta());
   ASSERT_TRUE(adb.KillForwardPortIsCalled());
+  ASSERT_FALSE(registry.Claim("a", "a.socket", &port));
+}
+
+TEST(ForwardRegistry, DropForgetsWithoutKilling) {
+  SucceedsForwardPortFakeAdb adb;
+  ForwardRegistry registry;
+  registry.Register("a", "a.socket", 7);
+  registry.Drop("a", "a.socket");
+  int port = 0;
+  ASSERT_FALSE(registry.Claim("a", "a.socket", &port));
+  registry.ReapIdle(&adb, base::TimeDelta());
+  ASSERT_FALSE(adb.KillForwardPortIsCalled());
+}
+
+TEST(LogcatDemuxer, RoutesLinesByPid) {
+  LogcatDemuxer demuxer;
+  demuxer.AttachConsumer(1, 1234);
+  demuxer.AttachConsumer(2, 5678);
+  demuxer.OnLogcatLine("06-02 10:11:12.131  1234  1300 I chromium: a");
+  demuxer.OnLogcatLine("06-02 10:11:12.132  5678  5700 I chromium: b");
+  demuxer.OnLogcatLine("--------- beginning of main");
+
+  std::vector<std::string> lines;
+  demuxer.ReadAndClearLines(1, &lines);
+  ASSERT_EQ(1U, lines.size());
+  ASSERT_EQ("06-02 10:11:12.131  1234  1300 I chromium: a", lines[0]);
+
+  lines.clear();
+  demuxer.ReadAndClearLines(2, &lines);
+  ASSERT_EQ(1U, lines.size());
+  ASSERT_EQ("06-02 10:11:12.132  5678  5700 I chromium: b", lines[0]);
+
+  // A second read returns nothing until new lines arrive.
+  lines.clear();
+  demuxer.ReadAndClearLines(1, &lines);
+  ASSERT_EQ(0U, lines.size());
+}
+
+TEST(LogcatDemuxer, ZeroPidKeepsEveryLine) {
+  LogcatDemuxer demuxer;
+  demuxer.AttachConsumer(1, 0);
+  demuxer.OnLogcatLine("06-02 10:11:12.131  1234  1300 I chromium: a");
+  demuxer.OnLogcatLine("--------- beginning of main");
+
+  std::vector<std::string> lines;
+  demuxer.ReadAndClearLines(1, &lines);
+  ASSERT_EQ(2U, lines.size());
+}
+
+TEST(LogcatDemuxer, EvictsOldestLinesWhenOverBudget) {
+  LogcatDemuxer demuxer;
+  demuxer.AttachConsumer(1, 0);
+  // Each line is well over half the 1 MiB per-consumer budget, so every
+  // new line evicts the previous one.
+  std::string payload(700 * 1024, 'x');
+  demuxer.OnLogcatLine("first " + payload);
+  demuxer.OnLogcatLine("second " + payload);
+  demuxer.OnLogcatLine("third " + payload);
+
+  std::vector<std::string> lines;
+  demuxer.ReadAndClearLines(1, &lines);
+  ASSERT_EQ(1U, lines.size());
+  ASSERT_EQ("third ", lines[0].substr(0, 6));
+}
+
+TEST(LogcatDemuxer, DetachStopsBuffering) {
+  LogcatDemuxer demuxer;
+  demuxer.AttachConsumer(1, 0);
+  demuxer.OnLogcatLine("a line");
+  demuxer.DetachConsumer(1);
+  demuxer.OnLogcatLine("another line");
+
+  std::vector<std::string> lines;
+  demuxer.ReadAndClearLines(1, &lines);
+  ASSERT_EQ(0U, lines.size());
+}
+
+TEST(LogcatDemuxer, GetLinePid) {
+  int pid = 0;
+  ASSERT_TRUE(LogcatDemuxer::GetLinePid(
+      "06-02 10:11:12.131  1234  1300 I chromium: msg", &pid));
+  ASSERT_EQ(1234, pid);
+  ASSERT_FALSE(
+      LogcatDemuxer::GetLinePid("--------- beginning of main", &pid));
+}
+
+TEST(Device, LogcatCaptureServesBufferedLines) {
+  int devtools_port = 0;
+  FakeAdb adb;
+  DeviceManager device_manager(&adb);
+  std::unique_ptr<Device> device1;
+  ASSERT_TRUE(device_manager.AcquireDevice(&device1).IsOk());
+  ASSERT_TRUE(
+      device1->SetUp("a.chrome.package", "", "",
+                     "", "", "", false, &devtools_port).IsOk());
+  // SetUp opened the stream and attached this session's buffer.
+  ASSERT_FALSE(adb.on_line_.is_null());
+  adb.on_line_.Run("06-02 10:11:12.131  1234  1300 I chromium: a");
+  adb.on_line_.Run("06-02 10:11:12.132  1234  1300 I chromium: b");
+
+  std::vector<std::string> lines;
+  ASSERT_TRUE(device1->ReadLogcatLines(&lines).IsOk());
+  ASSERT_EQ(2U, lines.size());
+
+  // Tearing the session down stops its capture; the stream itself stays
+  // open for the next session on the device.
+  ASSERT_TRUE(device1->TearDown().IsOk());
+  ASSERT_FALSE(adb.on_line_.is_null());
+  lines.clear();
+  ASSERT_FALSE(device1->ReadLogcatLines(&lines).IsOk());
 }
 
 TEST(ForwardPort, Failure) {
@@ -4,6 +4,57 @@
 
 #include "chrome/test/chromedriver/chrome/devtools_client.h"
 
+#include <memory>
+
+#include "base/json/json_reader.h"
+#include "base/values.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+
+namespace {
+
+Status ParseSerializedParams(const std::string& params_json,
+                             std::unique_ptr<base::Value>* value,
+                             base::DictionaryValue** dict) {
+  *value = base::JSONReader::ReadDeprecated(params_json);
+  if (!*value || !(*value)->GetAsDictionary(dict))
+    return Status(kUnknownError, "invalid serialized command params");
+  return Status(kOk);
+}
+
+}  // namespace
+
+Status DevToolsClient::SendCommandSerialized(const std::string& method,
+                                             const std::string& params_json) {
+  std::unique_ptr<base::Value> value;
+  base::DictionaryValue* dict = nullptr;
+  Status status = ParseSerializedParams(params_json, &value, &dict);
+  if (status.IsError())
+    return status;
+  return SendCommand(method, *dict);
+}
+
+Status DevToolsClient::SendCommandSerializedAndIgnoreResponse(
+    const std::string& method,
+    const std::string& params_json) {
+  std::unique_ptr<base::Value> value;
+  base::DictionaryValue* dict = nullptr;
+  Status status = ParseSerializedParams(params_json, &value, &dict);
+  if (status.IsError())
+    return status;
+  return SendCommandAndIgnoreResponse(method, *dict);
+}
+
+Status DevToolsClient::HandleEventsUntil(
+    const ConditionalFunc& conditional_func,
+    const std::vector<std::string>& trigger_method_prefixes,
+    const Timeout& timeout) {
+  return HandleEventsUntil(conditional_func, timeout);
+}
+
+DevToolsClient* DevToolsClient::GetBulkTransferClient() {
+  return this;
+}
+
 bool DevToolsClient::IsMainPage() {
   return GetRootClient() == this;
 }
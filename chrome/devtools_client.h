@@ -7,6 +7,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/callback_forward.h"
 
@@ -14,6 +15,7 @@ namespace base {
 class DictionaryValue;
 }
 
+class DevToolsCommandFuture;
 class DevToolsEventListener;
 class Timeout;
 class Status;
@@ -68,6 +70,55 @@ class DevToolsClient {
       const std::string& method,
       const base::DictionaryValue& params) = 0;
 
+  // Variants of SendCommand / SendCommandAndIgnoreResponse taking params
+  // already serialized to JSON, e.g. by a generated binding from
+  // cdp_bindings.h, so the hot event-dispatch path skips base::Value tree
+  // construction. The default implementations parse |params_json| back into
+  // a tree and delegate, so stub and replay clients see the usual calls;
+  // DevToolsClientImpl sends the string as-is.
+  virtual Status SendCommandSerialized(const std::string& method,
+                                       const std::string& params_json);
+  virtual Status SendCommandSerializedAndIgnoreResponse(
+      const std::string& method,
+      const std::string& params_json);
+
+  // Sends |method| once per entry of |params_batch| without waiting
+  // between sends, then collects the responses in order. DevTools
+  // executes commands sequentially, so a batch costs one round trip
+  // rather than one per command. A command-level error produces a null
+  // entry in |results| instead of failing the batch; transport errors
+  // fail it.
+  virtual Status SendCommandBatch(
+      const std::string& method,
+      const std::vector<const base::DictionaryValue*>& params_batch,
+      std::vector<std::unique_ptr<base::DictionaryValue>>* results) = 0;
+
+  // Sends |method| without waiting and hands back a future for its response
+  // via |future|, so independent commands on several clients can be issued
+  // together and their responses collected afterwards. Implementations
+  // without pipelining execute the command synchronously instead, report
+  // its status directly, and leave |future| null.
+  virtual Status SendCommandAndGetFuture(
+      const std::string& method,
+      const base::DictionaryValue& params,
+      std::unique_ptr<DevToolsCommandFuture>* future) = 0;
+
+  // Like SendCommand, except that while OnConnected listeners are being
+  // notified the command is only enqueued; the client flushes all commands
+  // queued during one (re)connect as a single pipelined batch, so each
+  // listener no longer costs its own round trip. Outside connect
+  // notification this is plain SendCommand.
+  virtual Status SendCommandDeferred(
+      const std::string& method,
+      const base::DictionaryValue& params) = 0;
+
+  // Reference-counted DevTools domain enablement. The first user of a domain
+  // sends <domain>.enable (pipelined, no blocking round trip) and the last
+  // one to leave sends <domain>.disable, so features can share a domain's
+  // event stream without knowing about each other.
+  virtual Status EnableDomain(const std::string& domain) = 0;
+  virtual Status DisableDomain(const std::string& domain) = 0;
+
   // Adds a listener. This must only be done when the client is disconnected.
   virtual void AddListener(DevToolsEventListener* listener) = 0;
 
@@ -79,9 +130,33 @@ class DevToolsClient {
   virtual Status HandleEventsUntil(const ConditionalFunc& conditional_func,
                                    const Timeout& timeout) = 0;
 
+  // Like HandleEventsUntil, but |conditional_func| is re-evaluated only
+  // after an event whose method starts with one of
+  // |trigger_method_prefixes| has been handled; unrelated events are
+  // processed without a condition check. The condition is also re-checked
+  // periodically so state advanced through a different client is still
+  // noticed. An empty prefix list means every event is a trigger. The
+  // default implementation ignores the prefixes and delegates to the
+  // unfiltered overload.
+  virtual Status HandleEventsUntil(
+      const ConditionalFunc& conditional_func,
+      const std::vector<std::string>& trigger_method_prefixes,
+      const Timeout& timeout);
+
   // Handles events that have been received but not yet handled.
   virtual Status HandleReceivedEvents() = 0;
 
+  // Returns false only if it is certain that no dialog-opening event is
+  // waiting unprocessed in the socket's receive queue. Cheap flag read;
+  // does not pump the event loop.
+  virtual bool MayHavePendingDialogEvents() = 0;
+
+  // Blocks on the socket until at least one message has been received and
+  // handled, or |timeout| expires. Expiry is not an error; callers use this
+  // to wait event-driven instead of sleeping for a fixed interval, and
+  // re-check their condition after each wakeup.
+  virtual Status HandleNextEvent(const Timeout& timeout) = 0;
+
   // Indicate that we've been detached from the DevTools target.
   virtual void SetDetached() = 0;
 
@@ -92,6 +167,15 @@ class DevToolsClient {
 
   virtual DevToolsClient* GetRootClient() = 0;
 
+  // Returns a client connected to the same target over a separate WebSocket,
+  // for commands whose responses run to tens of MB (screenshots, PDFs, heap
+  // snapshots). Routing those onto their own connection keeps the primary
+  // socket free for interactive commands, which would otherwise queue behind
+  // the large frame. The secondary connection is created lazily and reused;
+  // the default implementation, and any client that cannot open one, returns
+  // |this| so callers degrade to the shared connection transparently.
+  virtual DevToolsClient* GetBulkTransferClient();
+
   virtual bool IsMainPage();
 };
 
@@ -9,6 +9,8 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/callback.h"
 #include "base/compiler_specific.h"
@@ -16,6 +18,7 @@
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_refptr.h"
 #include "chrome/test/chromedriver/chrome/devtools_client.h"
+#include "chrome/test/chromedriver/net/command_id.h"
 #include "chrome/test/chromedriver/net/sync_websocket_factory.h"
 #include "chrome/test/chromedriver/net/timeout.h"
 #include "url/gurl.h"
@@ -31,10 +34,26 @@ enum InspectorMessageType {
   kCommandResponseMessageType
 };
 
+// Methods the receive loop itself reacts to, interned to integer tokens at
+// parse time so the per-event checks in ProcessEvent compare integers
+// instead of strings. Every other method maps to kMethodTokenUnknown and is
+// handled by its string, as before.
+enum MethodToken {
+  kMethodTokenUnknown = -1,
+  kMethodTokenInspectorDetached,
+  kMethodTokenInspectorTargetCrashed,
+  kMethodTokenPageJavascriptDialogOpening,
+};
+
+// Returns the token for |method|, or kMethodTokenUnknown.
+MethodToken InternMethodToken(const std::string& method);
+
 struct InspectorEvent {
   InspectorEvent();
   ~InspectorEvent();
   std::string method;
+  // InternMethodToken(method), filled in by the default parser.
+  MethodToken method_token;
   std::unique_ptr<base::DictionaryValue> params;
 };
 
@@ -48,6 +67,8 @@ struct InspectorCommandResponse {
 
 }  // namespace internal
 
+class BufferPool;
+class DevToolsCommandFuture;
 class DevToolsEventListener;
 class Status;
 class SyncWebSocket;
@@ -68,6 +89,15 @@ class DevToolsClientImpl : public DevToolsClient {
 
   DevToolsClientImpl(DevToolsClientImpl* parent, const std::string& session_id);
 
+  // Creates a client for |target_id| that multiplexes over |parent|'s
+  // WebSocket instead of opening its own connection. The DevTools session is
+  // attached lazily: the first ConnectIfNecessary sends Target.attachToTarget
+  // (flatten) on |parent|, so creating the client stays as cheap as the
+  // connect-on-first-use behavior of socket-owning clients.
+  static std::unique_ptr<DevToolsClientImpl> CreateTargetClient(
+      DevToolsClientImpl* parent,
+      const std::string& target_id);
+
   typedef base::RepeatingCallback<bool(const std::string&,
                                        int,
                                        std::string*,
@@ -112,19 +142,56 @@ class DevToolsClientImpl : public DevToolsClient {
       const base::DictionaryValue& params,
       const Timeout* timeout,
       std::unique_ptr<base::DictionaryValue>* result) override;
+  Status SendCommandBatch(
+      const std::string& method,
+      const std::vector<const base::DictionaryValue*>& params_batch,
+      std::vector<std::unique_ptr<base::DictionaryValue>>* results) override;
   Status SendCommandAndIgnoreResponse(
       const std::string& method,
       const base::DictionaryValue& params) override;
+  Status SendCommandSerialized(const std::string& method,
+                               const std::string& params_json) override;
+  Status SendCommandSerializedAndIgnoreResponse(
+      const std::string& method,
+      const std::string& params_json) override;
+  // Sends |method| without waiting and returns a future for its response,
+  // so independent commands can be pipelined: issue several, then collect.
+  // The response is claimed with DevToolsCommandFuture::Get; an abandoned
+  // future lets its response be discarded on arrival.
+  DevToolsCommandFuture SendCommandAndGetResultAsync(
+      const std::string& method,
+      const base::DictionaryValue& params);
+  Status SendCommandAndGetFuture(
+      const std::string& method,
+      const base::DictionaryValue& params,
+      std::unique_ptr<DevToolsCommandFuture>* future) override;
+  Status SendCommandDeferred(const std::string& method,
+                             const base::DictionaryValue& params) override;
+  Status EnableDomain(const std::string& domain) override;
+  Status DisableDomain(const std::string& domain) override;
   void AddListener(DevToolsEventListener* listener) override;
   Status HandleEventsUntil(const ConditionalFunc& conditional_func,
                            const Timeout& timeout) override;
+  Status HandleEventsUntil(
+      const ConditionalFunc& conditional_func,
+      const std::vector<std::string>& trigger_method_prefixes,
+      const Timeout& timeout) override;
   Status HandleReceivedEvents() override;
+  bool MayHavePendingDialogEvents() override;
+  Status HandleNextEvent(const Timeout& timeout) override;
   void SetDetached() override;
   void SetOwner(WebViewImpl* owner) override;
   WebViewImpl* GetOwner() const override;
   DevToolsClient* GetRootClient() override;
+  DevToolsClient* GetBulkTransferClient() override;
 
  private:
+  // See CreateTargetClient. |lazy_attach| exists only to distinguish this
+  // signature from the (parent, session_id) constructor and must be true.
+  DevToolsClientImpl(DevToolsClientImpl* parent,
+                     const std::string& target_id,
+                     bool lazy_attach);
+
   enum ResponseState {
     // The client is waiting for the response.
     kWaiting,
@@ -149,6 +216,25 @@ class DevToolsClientImpl : public DevToolsClient {
     friend class base::RefCounted<ResponseInfo>;
     ~ResponseInfo();
   };
+  // Returns the pre-serialized message fragment for |method|, building and
+  // caching it on first use. See SendCommandInternal.
+  const std::string& GetCommandTemplate(const std::string& method);
+  // True if |listener| declared a subscription covering |method|, or
+  // subscribes to all events.
+  bool ListenerSubscribesToEvent(DevToolsEventListener* listener,
+                                 const std::string& method) const;
+  // True if this client or any of its children would act on an event with
+  // the given method, either in a listener or in ProcessEvent itself.
+  bool AnyClientConsumesEvent(const std::string& method) const;
+  // Builds the wire message for one command and sends it, without
+  // registering any interest in its response.
+  Status SendCommandMessage(const std::string& method,
+                            const base::DictionaryValue& params,
+                            int command_id);
+  // Same, with |params| already serialized to JSON.
+  Status SendCommandMessage(const std::string& method,
+                            const std::string& params_json,
+                            int command_id);
   Status SendCommandInternal(const std::string& method,
                              const base::DictionaryValue& params,
                              std::unique_ptr<base::DictionaryValue>* result,
@@ -156,27 +242,97 @@ class DevToolsClientImpl : public DevToolsClient {
                              bool wait_for_response,
                              int client_command_id,
                              const Timeout* timeout);
+  Status SendCommandInternal(const std::string& method,
+                             const std::string& params_json,
+                             std::unique_ptr<base::DictionaryValue>* result,
+                             bool expect_response,
+                             bool wait_for_response,
+                             int client_command_id,
+                             const Timeout* timeout);
+  // Pumps the connection until the response registered for |command_id|
+  // arrives or |timeout| expires, then moves its result into |result|.
+  // Shared by the synchronous send path and DevToolsCommandFuture::Get.
+  Status AwaitCommandResponse(int command_id,
+                              scoped_refptr<ResponseInfo> response_info,
+                              const Timeout* timeout,
+                              std::unique_ptr<base::DictionaryValue>* result);
   Status ProcessNextMessage(int expected_id,
                             bool log_timeout,
                             const Timeout& timeout);
   Status HandleMessage(int expected_id, const std::string& message);
+  Status HandleMessageInternal(int expected_id, const std::string& message);
+
+  // One message's worth of parse output. Recycled between messages (see
+  // AcquireScratch) so the contained strings keep their capacity instead of
+  // being reallocated per received event.
+  struct MessageScratch {
+    MessageScratch();
+    ~MessageScratch();
+    std::string session_id;
+    internal::InspectorEvent event;
+    internal::InspectorCommandResponse response;
+  };
+  // Takes a scratch object from scratch_pool_, or allocates one the first
+  // time the receive loop reaches a new re-entrancy depth (processing an
+  // event can send commands, which pump the connection recursively).
+  std::unique_ptr<MessageScratch> AcquireScratch();
+  // Clears |scratch| - keeping string capacity - and returns it to the pool.
+  void ReleaseScratch(std::unique_ptr<MessageScratch> scratch);
+  // Parses |message| into |scratch| and dispatches it; the tail of
+  // HandleMessageInternal, split out so the scratch release covers every
+  // return path.
+  Status HandleParsedMessage(int expected_id,
+                             const std::string& message,
+                             MessageScratch* scratch);
   Status ProcessEvent(const internal::InspectorEvent& event);
-  Status ProcessCommandResponse(
-      const internal::InspectorCommandResponse& response);
+  // Consumes |response|: its result tree is moved into the pending command's
+  // ResponseInfo rather than copied.
+  Status ProcessCommandResponse(internal::InspectorCommandResponse& response);
   Status EnsureListenersNotifiedOfConnect();
+  // Sends every command queued by SendCommandDeferred during connect
+  // notification as one pipelined batch and awaits all acknowledgements.
+  Status FlushDeferredConnectCommands();
   Status EnsureListenersNotifiedOfEvent();
   Status EnsureListenersNotifiedOfCommandResponse();
 
   std::unique_ptr<SyncWebSocket> socket_;
+  // Factory socket_ came from, kept so GetBulkTransferClient can open a
+  // second connection lazily. Null for child clients, which have no socket.
+  SyncWebSocketFactory factory_;
+  // Recycles the buffers that outgoing command messages are serialized
+  // into; the socket releases them back after the write. Created only by
+  // root clients (which own the socket); see SendCommandMessage.
+  scoped_refptr<BufferPool> send_buffer_pool_;
   GURL url_;
+  // Pre-serialized JSON fragments, keyed by method, spliced into outgoing
+  // command messages so the send path need not build and serialize an
+  // envelope Value tree for every command.
+  std::map<std::string, std::string> command_templates_;
+  // Pre-serialized ,"sessionId":"..." fragment; empty for root clients.
+  std::string session_suffix_;
   // WebViewImpl that owns this instance; nullptr for browser-wide DevTools.
   WebViewImpl* owner_;
-  const std::string session_id_;
+  // Empty for a target client until its lazy attach assigns it a session.
+  std::string session_id_;
+  // Target to attach to over the parent connection; empty unless this client
+  // was made by CreateTargetClient.
+  std::string target_id_;
+  // True while a CreateTargetClient client has not yet attached its session.
+  bool attach_pending_;
   // parent_ / children_: it's a flat hierarchy - nesting is at most one level
   // deep. children_ holds child sessions - identified by their session id -
   // which send/receive messages via the socket_ of their parent.
   DevToolsClientImpl* parent_;
   std::map<std::string, DevToolsClientImpl*> children_;
+  // Secondary connection for bulk-transfer commands; see
+  // GetBulkTransferClient. For a multiplexed target client the channel is a
+  // target session attached over a dedicated root connection, which
+  // bulk_transfer_root_ owns. Both stay null until first use.
+  std::unique_ptr<DevToolsClientImpl> bulk_transfer_root_;
+  std::unique_ptr<DevToolsClientImpl> bulk_transfer_client_;
+  // True for a client serving as another client's bulk channel; such clients
+  // never spawn a channel of their own.
+  bool is_bulk_channel_;
   bool crashed_;
   bool detached_;
   // For the top-level session, this is the target id.
@@ -184,21 +340,120 @@ class DevToolsClientImpl : public DevToolsClient {
   const std::string id_;
   FrontendCloserFunc frontend_closer_func_;
   ParserFunc parser_func_;
+  // True while parser_func_ is internal::ParseInspectorMessage; the phase-one
+  // method peek in HandleMessage is only safe with the default parser.
+  bool uses_default_parser_;
   std::list<DevToolsEventListener*> listeners_;
+  // Method-name prefixes each listener subscribed to at AddListener time;
+  // an empty vector subscribes the listener to all events.
+  std::map<DevToolsEventListener*, std::vector<std::string>>
+      listener_prefixes_;
+  // Listeners subscribed to each distinct event method, resolved once per
+  // method and reused; DevTools traffic repeats a small set of methods many
+  // thousands of times, so this replaces per-event prefix matching with one
+  // map lookup. Invalidated whenever a listener is added.
+  std::map<std::string, std::vector<DevToolsEventListener*>>
+      method_dispatch_cache_;
   std::list<DevToolsEventListener*> unnotified_connect_listeners_;
+  // True while an OnConnected listener is being notified; makes
+  // SendCommandDeferred queue instead of send.
+  bool notifying_connect_listeners_;
+  // Commands queued by SendCommandDeferred, in send order.
+  std::vector<std::pair<std::string, std::unique_ptr<base::DictionaryValue>>>
+      deferred_connect_commands_;
   std::list<DevToolsEventListener*> unnotified_event_listeners_;
   const internal::InspectorEvent* unnotified_event_;
   std::list<DevToolsEventListener*> unnotified_cmd_response_listeners_;
   scoped_refptr<ResponseInfo> unnotified_cmd_response_info_;
+  // Demultiplexer for in-flight commands: every expected response is
+  // registered here by id, and the receive loop routes each arriving
+  // response to its waiter regardless of arrival order. This is what lets
+  // synchronous waits, futures and batches share one connection with any
+  // number of commands outstanding.
   std::map<int, scoped_refptr<ResponseInfo>> response_info_map_;
-  int next_id_;  // The id identifying a particular request.
+  // Users per DevTools domain; the enable command goes out on the 0 -> 1
+  // transition and the disable command on 1 -> 0. Cleared on every (re)connect
+  // since the browser side starts over with all domains disabled.
+  std::map<std::string, int> domain_refcounts_;
+  // Non-null while a filtered HandleEventsUntil runs on this client; points
+  // at that wait's trigger prefixes. ProcessEvent sets |wait_trigger_fired_|
+  // when it handles an event one of the prefixes covers, which is what lets
+  // the wait loop re-evaluate its condition; other events bypass the check.
+  const std::vector<std::string>* wait_trigger_method_prefixes_;
+  bool wait_trigger_fired_;
+  // Issues this client's request ids from its own shard of the id space,
+  // so clients never coordinate on id uniqueness.
+  CommandIdAllocator id_allocator_;
   int stack_count_;
+  // Recycled parse-output objects; holds at most one object per re-entrancy
+  // depth the receive loop has reached. See AcquireScratch.
+  std::vector<std::unique_ptr<MessageScratch>> scratch_pool_;
+
+  friend class DevToolsCommandFuture;
 
   DISALLOW_COPY_AND_ASSIGN(DevToolsClientImpl);
 };
 
+// A command in flight on a DevToolsClientImpl, obtained from
+// SendCommandAndGetResultAsync. The response resolves whenever the client
+// pumps its connection — during a later synchronous command, an event wait,
+// or this future's own Get — so a caller can issue several independent
+// commands and pay one round trip for the batch. Move-only; destroying an
+// unclaimed future discards its response when it arrives.
+class DevToolsCommandFuture {
+ public:
+  DevToolsCommandFuture(DevToolsCommandFuture&& other);
+  DevToolsCommandFuture& operator=(DevToolsCommandFuture&& other);
+  ~DevToolsCommandFuture();
+
+  DevToolsCommandFuture(const DevToolsCommandFuture&) = delete;
+  DevToolsCommandFuture& operator=(const DevToolsCommandFuture&) = delete;
+
+  // True once the response has been received, without pumping for it.
+  bool ready() const;
+
+  // Blocks until the response arrives or |timeout| (a long default when
+  // null) expires, and moves its result out, like SendCommandAndGetResult.
+  // May only be called once, on the thread that owns the client.
+  Status Get(const Timeout* timeout,
+             std::unique_ptr<base::DictionaryValue>* result);
+
+ private:
+  friend class DevToolsClientImpl;
+
+  DevToolsCommandFuture(DevToolsClientImpl* client,
+                        int command_id,
+                        scoped_refptr<DevToolsClientImpl::ResponseInfo>
+                            response_info,
+                        const Status& send_status);
+
+  DevToolsClientImpl* client_;
+  int command_id_;
+  scoped_refptr<DevToolsClientImpl::ResponseInfo> response_info_;
+  // Error from the send itself; reported by Get when the command never
+  // made it onto the wire.
+  Status send_status_;
+};
+
 namespace internal {
 
+// Phase-one scan of a raw inspector message. Returns true and fills |method|
+// only if |message| is positively identified as an event notification, which
+// DevTools serializes with "method" as its first key; command responses start
+// with "id" instead. Anything unexpected returns false, and the caller must
+// fall back to a full parse.
+bool PeekInspectorEventMethod(const std::string& message, std::string* method);
+
+// Extracts the flat-protocol session id a raw message carries at top level.
+// Returns false if the message has none (e.g. it is for the root target).
+bool PeekInspectorSessionId(const std::string& message,
+                            std::string* session_id);
+
+// Whether an event only describes the latest state of its target, so older
+// queued instances may be dropped when a newer one is pending; see
+// DevToolsClientImpl::HandleReceivedEvents.
+bool IsCoalescibleEvent(const std::string& method);
+
 bool ParseInspectorMessage(const std::string& message,
                            int expected_id,
                            std::string* session_id,
@@ -0,0 +1,55 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/bind.h"
+#include "chrome/test/chromedriver/benchmark_util.h"
+#include "chrome/test/chromedriver/chrome/devtools_client_impl.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kRuns = 20000;
+
+void ParseMessage(const std::string& message, int expected_id) {
+  std::string session_id;
+  internal::InspectorMessageType type;
+  internal::InspectorEvent event;
+  internal::InspectorCommandResponse response;
+  ASSERT_TRUE(internal::ParseInspectorMessage(message, expected_id,
+                                              &session_id, &type, &event,
+                                              &response));
+}
+
+}  // namespace
+
+TEST(ParseInspectorMessageBenchmark, SmallEvent) {
+  std::string message =
+      "{\"method\":\"Page.frameNavigated\",\"params\":{\"frame\":"
+      "{\"id\":\"F1\",\"loaderId\":\"L1\",\"url\":\"http://test/\"}}}";
+  benchmark::RunAndReport("ChromeDriver.ParseInspectorMessage", "small_event",
+                          kRuns, base::BindRepeating(&ParseMessage, message, 0));
+}
+
+TEST(ParseInspectorMessageBenchmark, CommandResponse) {
+  std::string message =
+      "{\"id\":42,\"result\":{\"result\":{\"type\":\"string\","
+      "\"value\":\"done\"}}}";
+  benchmark::RunAndReport("ChromeDriver.ParseInspectorMessage",
+                          "command_response", kRuns,
+                          base::BindRepeating(&ParseMessage, message, 42));
+}
+
+TEST(ParseInspectorMessageBenchmark, LargeEvent) {
+  // Mimics a console/network event dragging a sizable payload string, the
+  // shape that dominates parse time on busy pages.
+  std::string message =
+      "{\"method\":\"Runtime.consoleAPICalled\",\"params\":{\"type\":\"log\","
+      "\"args\":[{\"type\":\"string\",\"value\":\"" +
+      std::string(64 * 1024, 'x') + "\"}]}}";
+  benchmark::RunAndReport("ChromeDriver.ParseInspectorMessage", "large_event",
+                          kRuns / 20,
+                          base::BindRepeating(&ParseMessage, message, 0));
+}
@@ -7,6 +7,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/compiler_specific.h"
@@ -16,6 +17,7 @@
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
 #include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/net/command_id.h"
 #include "chrome/test/chromedriver/net/sync_websocket.h"
 #include "chrome/test/chromedriver/net/sync_websocket_factory.h"
 #include "chrome/test/chromedriver/net/timeout.h"
@@ -146,7 +148,11 @@ std::unique_ptr<SyncWebSocket> CreateMockSyncWebSocket() {
 
 class DevToolsClientImplTest : public testing::Test {
  protected:
-  DevToolsClientImplTest() : long_timeout_(base::TimeDelta::FromMinutes(5)) {}
+  DevToolsClientImplTest() : long_timeout_(base::TimeDelta::FromMinutes(5)) {
+    // Canned responses below hardcode ids 1, 2, ... for the first client
+    // each test creates.
+    CommandIdAllocator::ResetNextShardForTesting();
+  }
 
   const base::TimeDelta long_timeout_;
 };
@@ -474,6 +480,35 @@ bool ReturnError(const std::string& message,
   return false;
 }
 
+// Emits four Network events and then a Page event, counting how many events
+// have been emitted so far in |*events_emitted|.
+bool ReturnEventSequence(
+    int* events_emitted,
+    const std::string& message,
+    int expected_id,
+    std::string* session_id,
+    internal::InspectorMessageType* type,
+    internal::InspectorEvent* event,
+    internal::InspectorCommandResponse* command_response) {
+  static const char* const kMethods[] = {
+      "Network.requestWillBeSent", "Network.responseReceived",
+      "Network.dataReceived", "Network.loadingFinished",
+      "Page.frameStoppedLoading"};
+  *type = internal::kEventMessageType;
+  event->method = kMethods[*events_emitted < 5 ? *events_emitted : 4];
+  event->params = std::make_unique<base::DictionaryValue>();
+  ++*events_emitted;
+  return true;
+}
+
+Status CountEvalsUntilPageEvent(int* eval_count,
+                                const int* events_emitted,
+                                bool* is_met) {
+  ++*eval_count;
+  *is_met = *events_emitted >= 5;
+  return Status(kOk);
+}
+
 Status AlwaysTrue(bool* is_met) {
   *is_met = true;
   return Status(kOk);
@@ -483,6 +518,30 @@ Status AlwaysError(bool* is_met) {
   return Status(kUnknownError);
 }
 
+// Answers the first receive with the response for the command before the one
+// being waited on, and only then the waited-on response, simulating DevTools
+// completing pipelined commands out of order.
+bool ReturnReversedResponses(
+    int* count,
+    const std::string& message,
+    int expected_id,
+    std::string* session_id,
+    internal::InspectorMessageType* type,
+    internal::InspectorEvent* event,
+    internal::InspectorCommandResponse* command_response) {
+  session_id->clear();
+  *type = internal::kCommandResponseMessageType;
+  command_response->result = std::make_unique<base::DictionaryValue>();
+  if ((*count)++ == 0) {
+    command_response->id = expected_id - 1;
+    command_response->result->SetInteger("key", 1);
+  } else {
+    command_response->id = expected_id;
+    command_response->result->SetInteger("key", 2);
+  }
+  return true;
+}
+
 }  // namespace
 
 TEST_F(DevToolsClientImplTest, SendCommandOnlyConnectsOnce) {
@@ -497,6 +556,107 @@ TEST_F(DevToolsClientImplTest, SendCommandOnlyConnectsOnce) {
   ASSERT_TRUE(client.SendCommand("method", params).IsOk());
 }
 
+TEST_F(DevToolsClientImplTest, SendCommandBatch) {
+  SyncWebSocketFactory factory =
+      base::BindRepeating(&CreateMockSyncWebSocket<FakeSyncWebSocket>);
+  DevToolsClientImpl client(factory, "http://url", "id",
+                            base::BindRepeating(&CloserFunc));
+  ASSERT_EQ(kOk, client.ConnectIfNecessary().code());
+  client.SetParserFuncForTesting(base::BindRepeating(&ReturnCommand));
+  base::DictionaryValue params1;
+  params1.SetInteger("param", 1);
+  base::DictionaryValue params2;
+  params2.SetInteger("param", 2);
+  std::vector<const base::DictionaryValue*> batch = {&params1, &params2};
+  std::vector<std::unique_ptr<base::DictionaryValue>> results;
+  ASSERT_EQ(kOk, client.SendCommandBatch("method", batch, &results).code());
+  ASSERT_EQ(2u, results.size());
+  ASSERT_TRUE(results[0]);
+  ASSERT_TRUE(results[1]);
+}
+
+TEST_F(DevToolsClientImplTest, SendCommandAsyncPipelined) {
+  SyncWebSocketFactory factory =
+      base::BindRepeating(&CreateMockSyncWebSocket<FakeSyncWebSocket>);
+  DevToolsClientImpl client(factory, "http://url", "id",
+                            base::BindRepeating(&CloserFunc));
+  ASSERT_EQ(kOk, client.ConnectIfNecessary().code());
+  client.SetParserFuncForTesting(base::BindRepeating(&ReturnCommand));
+  base::DictionaryValue params;
+  // Both commands go on the wire before either response is claimed.
+  DevToolsCommandFuture future1 =
+      client.SendCommandAndGetResultAsync("method", params);
+  DevToolsCommandFuture future2 =
+      client.SendCommandAndGetResultAsync("method", params);
+  ASSERT_FALSE(future1.ready());
+  std::unique_ptr<base::DictionaryValue> result1;
+  ASSERT_EQ(kOk, future1.Get(nullptr, &result1).code());
+  ASSERT_TRUE(result1);
+  std::unique_ptr<base::DictionaryValue> result2;
+  ASSERT_EQ(kOk, future2.Get(nullptr, &result2).code());
+  ASSERT_TRUE(result2);
+}
+
+TEST_F(DevToolsClientImplTest, FuturesResolveOutOfOrder) {
+  SyncWebSocketFactory factory =
+      base::BindRepeating(&CreateMockSyncWebSocket<FakeSyncWebSocket>);
+  DevToolsClientImpl client(factory, "http://url", "id",
+                            base::BindRepeating(&CloserFunc));
+  ASSERT_EQ(kOk, client.ConnectIfNecessary().code());
+  int count = 0;
+  client.SetParserFuncForTesting(
+      base::BindRepeating(&ReturnReversedResponses, &count));
+  base::DictionaryValue params;
+  DevToolsCommandFuture future1 =
+      client.SendCommandAndGetResultAsync("method", params);
+  DevToolsCommandFuture future2 =
+      client.SendCommandAndGetResultAsync("method", params);
+  // Claim the later command first; pumping for it delivers the earlier
+  // command's response along the way, which must land in its own waiter.
+  std::unique_ptr<base::DictionaryValue> result2;
+  ASSERT_EQ(kOk, future2.Get(nullptr, &result2).code());
+  int key = 0;
+  ASSERT_TRUE(result2->GetInteger("key", &key));
+  ASSERT_EQ(2, key);
+  // The earlier response was demultiplexed while waiting, so its future is
+  // ready without touching the socket again.
+  ASSERT_TRUE(future1.ready());
+  std::unique_ptr<base::DictionaryValue> result1;
+  ASSERT_EQ(kOk, future1.Get(nullptr, &result1).code());
+  ASSERT_TRUE(result1->GetInteger("key", &key));
+  ASSERT_EQ(1, key);
+}
+
+TEST_F(DevToolsClientImplTest, SendCommandAsyncResponseError) {
+  SyncWebSocketFactory factory =
+      base::BindRepeating(&CreateMockSyncWebSocket<FakeSyncWebSocket>);
+  DevToolsClientImpl client(factory, "http://url", "id",
+                            base::BindRepeating(&CloserFunc));
+  ASSERT_EQ(kOk, client.ConnectIfNecessary().code());
+  client.SetParserFuncForTesting(base::BindRepeating(&ReturnCommandError));
+  base::DictionaryValue params;
+  DevToolsCommandFuture future =
+      client.SendCommandAndGetResultAsync("method", params);
+  std::unique_ptr<base::DictionaryValue> result;
+  ASSERT_TRUE(future.Get(nullptr, &result).IsError());
+}
+
+TEST_F(DevToolsClientImplTest, SendCommandAsyncAbandonedFuture) {
+  SyncWebSocketFactory factory =
+      base::BindRepeating(&CreateMockSyncWebSocket<FakeSyncWebSocket>);
+  DevToolsClientImpl client(factory, "http://url", "id",
+                            base::BindRepeating(&CloserFunc));
+  ASSERT_EQ(kOk, client.ConnectIfNecessary().code());
+  client.SetParserFuncForTesting(base::BindRepeating(&ReturnCommand));
+  base::DictionaryValue params;
+  {
+    DevToolsCommandFuture future =
+        client.SendCommandAndGetResultAsync("method", params);
+  }
+  // Dropping the future must not disturb later commands on the client.
+  ASSERT_TRUE(client.SendCommand("method", params).IsOk());
+}
+
 TEST_F(DevToolsClientImplTest, SendCommandBadResponse) {
   SyncWebSocketFactory factory =
       base::BindRepeating(&CreateMockSyncWebSocket<FakeSyncWebSocket>);
@@ -580,6 +740,38 @@ TEST(ParseInspectorMessage, EventNoParams) {
   ASSERT_TRUE(event.params->is_dict());
 }
 
+TEST(ParseInspectorMessage, EventMethodToken) {
+  internal::InspectorMessageType type;
+  internal::InspectorEvent event;
+  internal::InspectorCommandResponse response;
+  std::string session_id;
+  ASSERT_TRUE(internal::ParseInspectorMessage(
+      "{\"method\":\"Inspector.detached\"}", 0, &session_id, &type, &event,
+      &response));
+  ASSERT_EQ(internal::kEventMessageType, type);
+  EXPECT_EQ(internal::kMethodTokenInspectorDetached, event.method_token);
+  ASSERT_TRUE(internal::ParseInspectorMessage(
+      "{\"method\":\"Network.dataReceived\"}", 0, &session_id, &type, &event,
+      &response));
+  EXPECT_EQ(internal::kMethodTokenUnknown, event.method_token);
+}
+
+TEST(InternMethodToken, KnownMethods) {
+  EXPECT_EQ(internal::kMethodTokenInspectorDetached,
+            internal::InternMethodToken("Inspector.detached"));
+  EXPECT_EQ(internal::kMethodTokenInspectorTargetCrashed,
+            internal::InternMethodToken("Inspector.targetCrashed"));
+  EXPECT_EQ(internal::kMethodTokenPageJavascriptDialogOpening,
+            internal::InternMethodToken("Page.javascriptDialogOpening"));
+  EXPECT_EQ(internal::kMethodTokenUnknown,
+            internal::InternMethodToken("Page.frameNavigated"));
+  // Same length as "Inspector.detached" but a different method; the
+  // length-keyed fast path must still compare the contents.
+  EXPECT_EQ(internal::kMethodTokenUnknown,
+            internal::InternMethodToken("Inspector.attached"));
+  EXPECT_EQ(internal::kMethodTokenUnknown, internal::InternMethodToken(""));
+}
+
 TEST(ParseInspectorMessage, EventNoParamsWithSessionId) {
   internal::InspectorMessageType type;
   internal::InspectorEvent event;
@@ -654,6 +846,50 @@ TEST(ParseInspectorMessage, Command) {
   ASSERT_EQ(1, key);
 }
 
+TEST(PeekInspectorEventMethod, Event) {
+  std::string method;
+  ASSERT_TRUE(internal::PeekInspectorEventMethod(
+      "{\"method\":\"Network.dataReceived\",\"params\":{\"key\":100}}",
+      &method));
+  ASSERT_EQ("Network.dataReceived", method);
+}
+
+TEST(PeekInspectorEventMethod, CommandResponse) {
+  std::string method;
+  ASSERT_FALSE(internal::PeekInspectorEventMethod(
+      "{\"id\":1,\"result\":{\"key\":1}}", &method));
+}
+
+TEST(PeekInspectorEventMethod, Unrecognized) {
+  std::string method;
+  // Anything that is not unambiguously an event must fall back to a full
+  // parse.
+  ASSERT_FALSE(internal::PeekInspectorEventMethod("hi", &method));
+  ASSERT_FALSE(internal::PeekInspectorEventMethod("{}", &method));
+  ASSERT_FALSE(internal::PeekInspectorEventMethod("{\"method\":\"\"}", &method));
+  ASSERT_FALSE(internal::PeekInspectorEventMethod(
+      "{\"method\":\"odd \\\"name\",\"params\":{}}", &method));
+}
+
+TEST(PeekInspectorSessionId, PresentAndAbsent) {
+  std::string session_id;
+  ASSERT_TRUE(internal::PeekInspectorSessionId(
+      "{\"method\":\"Page.frameResized\",\"params\":{},"
+      "\"sessionId\":\"ABC123\"}",
+      &session_id));
+  ASSERT_EQ("ABC123", session_id);
+  // Root-target messages carry no session id.
+  ASSERT_FALSE(internal::PeekInspectorSessionId(
+      "{\"method\":\"Page.frameResized\",\"params\":{}}", &session_id));
+}
+
+TEST(IsCoalescibleEvent, OnlyLatestStateEvents) {
+  ASSERT_TRUE(internal::IsCoalescibleEvent("Page.frameResized"));
+  // Counted or accumulated events must never coalesce.
+  ASSERT_FALSE(internal::IsCoalescibleEvent("Page.frameStartedLoading"));
+  ASSERT_FALSE(internal::IsCoalescibleEvent("Network.dataReceived"));
+}
+
 TEST(ParseInspectorError, EmptyError) {
   Status status = internal::ParseInspectorError("");
   ASSERT_EQ(kUnknownError, status.code());
@@ -708,6 +944,27 @@ TEST_F(DevToolsClientImplTest, HandleEventsUntilTimeout) {
   ASSERT_EQ(kTimeout, status.code());
 }
 
+TEST_F(DevToolsClientImplTest, HandleEventsUntilTriggerFiltering) {
+  SyncWebSocketFactory factory =
+      base::BindRepeating(&CreateMockSyncWebSocket<MockSyncWebSocket>);
+  DevToolsClientImpl client(factory, "http://url", "id",
+                            base::BindRepeating(&CloserFunc));
+  ASSERT_EQ(kOk, client.ConnectIfNecessary().code());
+  int events_emitted = 0;
+  client.SetParserFuncForTesting(
+      base::BindRepeating(&ReturnEventSequence, &events_emitted));
+  int eval_count = 0;
+  Status status = client.HandleEventsUntil(
+      base::BindRepeating(&CountEvalsUntilPageEvent, &eval_count,
+                          &events_emitted),
+      std::vector<std::string>({"Page."}), Timeout(long_timeout_));
+  ASSERT_EQ(kOk, status.code());
+  // All five events were handled, but only the initial check and the one
+  // after the Page event ran the condition; the Network events bypassed it.
+  ASSERT_EQ(5, events_emitted);
+  ASSERT_EQ(2, eval_count);
+}
+
 TEST_F(DevToolsClientImplTest, WaitForNextEventCommand) {
   SyncWebSocketFactory factory =
       base::BindRepeating(&CreateMockSyncWebSocket<MockSyncWebSocket>);
@@ -880,6 +1137,49 @@ TEST_F(DevToolsClientImplTest, ProcessOnConnectedFirstOnCommand) {
   listener3.VerifyCalled();
 }
 
+namespace {
+
+class DeferredOnConnectedListener : public DevToolsEventListener {
+ public:
+  DeferredOnConnectedListener(const std::string& method, DevToolsClient* client)
+      : method_(method), client_(client), on_connected_called_(false) {
+    client_->AddListener(this);
+  }
+  ~DeferredOnConnectedListener() override {}
+
+  Status OnConnected(DevToolsClient* client) override {
+    on_connected_called_ = true;
+    base::DictionaryValue params;
+    return client_->SendCommandDeferred(method_, params);
+  }
+
+  bool on_connected_called() const { return on_connected_called_; }
+
+ private:
+  std::string method_;
+  DevToolsClient* client_;
+  bool on_connected_called_;
+};
+
+}  // namespace
+
+TEST_F(DevToolsClientImplTest, DeferredConnectCommandsFlushOnConnect) {
+  SyncWebSocketFactory factory =
+      base::BindRepeating(&CreateMockSyncWebSocket<OnConnectedSyncWebSocket>);
+  DevToolsClientImpl client(factory, "http://url", "onconnected-id",
+                            base::BindRepeating(&CloserFunc));
+  DeferredOnConnectedListener listener1("DOM.getDocument", &client);
+  DeferredOnConnectedListener listener2("Runtime.enable", &client);
+  // Connecting notifies the listeners and then flushes their queued
+  // commands as one acknowledged batch.
+  ASSERT_EQ(kOk, client.ConnectIfNecessary().code());
+  EXPECT_TRUE(listener1.on_connected_called());
+  EXPECT_TRUE(listener2.on_connected_called());
+  // Outside connect notification, the deferred variant sends synchronously.
+  base::DictionaryValue params;
+  EXPECT_EQ(kOk, client.SendCommandDeferred("Runtime.execute", params).code());
+}
+
 TEST_F(DevToolsClientImplTest, ProcessOnConnectedFirstOnHandleEventsUntil) {
   SyncWebSocketFactory factory =
       base::BindRepeating(&CreateMockSyncWebSocket<OnConnectedSyncWebSocket>);
@@ -987,6 +1287,87 @@ TEST_F(DevToolsClientImplTest, ProcessOnEventFirst) {
 
 namespace {
 
+class RepeatedEventSyncWebSocket : public SyncWebSocket {
+ public:
+  RepeatedEventSyncWebSocket() : id_(-1), sent_events_(0) {}
+  ~RepeatedEventSyncWebSocket() override {}
+
+  bool IsConnected() override { return true; }
+
+  bool Connect(const GURL& url) override { return true; }
+
+  bool Send(const std::string& message) override {
+    std::unique_ptr<base::Value> value =
+        base::JSONReader::ReadDeprecated(message);
+    base::DictionaryValue* dict = nullptr;
+    EXPECT_TRUE(value->GetAsDictionary(&dict));
+    EXPECT_TRUE(dict->GetInteger("id", &id_));
+    return true;
+  }
+
+  SyncWebSocket::StatusCode ReceiveNextMessage(
+      std::string* message,
+      const Timeout& timeout) override {
+    // The same event twice, so the second dispatch is served from the
+    // method dispatch cache, then the command response.
+    if (sent_events_ < 2) {
+      sent_events_++;
+      *message = "{\"method\": \"Page.m\", \"params\": {}}";
+    } else {
+      *message = base::StringPrintf("{\"result\": {}, \"id\": %d}", id_);
+    }
+    return SyncWebSocket::kOk;
+  }
+
+  bool HasNextMessage() override { return false; }
+
+ private:
+  int id_;
+  int sent_events_;
+};
+
+class CountingPrefixListener : public DevToolsEventListener {
+ public:
+  explicit CountingPrefixListener(const std::string& prefix)
+      : prefix_(prefix) {}
+  ~CountingPrefixListener() override {}
+
+  Status OnEvent(DevToolsClient* client,
+                 const std::string& method,
+                 const base::DictionaryValue& params) override {
+    event_count_++;
+    return Status(kOk);
+  }
+
+  std::vector<std::string> SubscribedMethodPrefixes() const override {
+    return {prefix_};
+  }
+
+  int event_count_ = 0;
+
+ private:
+  std::string prefix_;
+};
+
+}  // namespace
+
+TEST_F(DevToolsClientImplTest, CachedDispatchRespectsSubscriptions) {
+  SyncWebSocketFactory factory = base::BindRepeating(
+      &CreateMockSyncWebSocket<RepeatedEventSyncWebSocket>);
+  DevToolsClientImpl client(factory, "http://url", "id",
+                            base::BindRepeating(&CloserFunc));
+  CountingPrefixListener page_listener("Page.");
+  CountingPrefixListener network_listener("Network.");
+  client.AddListener(&page_listener);
+  client.AddListener(&network_listener);
+  base::DictionaryValue params;
+  ASSERT_EQ(kOk, client.SendCommand("method", params).code());
+  EXPECT_EQ(2, page_listener.event_count_);
+  EXPECT_EQ(0, network_listener.event_count_);
+}
+
+namespace {
+
 class DisconnectedSyncWebSocket : public MockSyncWebSocket {
  public:
   DisconnectedSyncWebSocket() : connection_count_(0), command_count_(0) {}
@@ -1289,3 +1670,216 @@ TEST_F(DevToolsClientImplTest, SendCommandAndIgnoreResponse) {
   ASSERT_EQ(kOk, client.SendCommandAndIgnoreResponse("method", params).code());
   ASSERT_EQ(kOk, client.SendCommand("method", params).code());
 }
+
+namespace {
+
+// Records every sent message and replies to each command in order, answering
+// Target.attachToTarget with a fixed session id and echoing the sessionId of
+// any session-scoped command back in its response.
+class MockSyncWebSocket8 : public SyncWebSocket {
+ public:
+  explicit MockSyncWebSocket8(std::vector<std::string>* sent_messages)
+      : connected_(false), sent_messages_(sent_messages) {}
+  ~MockSyncWebSocket8() override {}
+
+  bool IsConnected() override { return connected_; }
+
+  bool Connect(const GURL& url) override {
+    connected_ = true;
+    return true;
+  }
+
+  bool Send(const std::string& message) override {
+    sent_messages_->push_back(message);
+    std::unique_ptr<base::Value> value =
+        base::JSONReader::ReadDeprecated(message);
+    base::DictionaryValue* dict = nullptr;
+    if (!value || !value->GetAsDictionary(&dict))
+      return false;
+    int id = -1;
+    std::string method;
+    if (!dict->GetInteger("id", &id) || !dict->GetString("method", &method))
+      return false;
+    std::string response;
+    if (method == "Target.attachToTarget") {
+      response = base::StringPrintf(
+          "{\"id\":%d,\"result\":{\"sessionId\":\"session-abc\"}}", id);
+    } else {
+      std::string session_suffix;
+      std::string session_id;
+      if (dict->GetString("sessionId", &session_id))
+        session_suffix = ",\"sessionId\":\"" + session_id + "\"";
+      response =
+          base::StringPrintf("{\"id\":%d,\"result\":{}%s}", id,
+                             session_suffix.c_str());
+    }
+    queued_responses_.push_back(response);
+    return true;
+  }
+
+  SyncWebSocket::StatusCode ReceiveNextMessage(
+      std::string* message,
+      const Timeout& timeout) override {
+    if (queued_responses_.empty())
+      return SyncWebSocket::kDisconnected;
+    *message = queued_responses_.front();
+    queued_responses_.pop_front();
+    return SyncWebSocket::kOk;
+  }
+
+  bool HasNextMessage() override { return !queued_responses_.empty(); }
+
+ private:
+  bool connected_;
+  std::vector<std::string>* sent_messages_;
+  std::list<std::string> queued_responses_;
+};
+
+std::unique_ptr<SyncWebSocket> CreateMockSyncWebSocket8(
+    std::vector<std::string>* sent_messages) {
+  return std::make_unique<MockSyncWebSocket8>(sent_messages);
+}
+
+int CountAttachMessages(const std::vector<std::string>& sent_messages) {
+  int count = 0;
+  for (const std::string& message : sent_messages) {
+    if (message.find("Target.attachToTarget") != std::string::npos)
+      count++;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST_F(DevToolsClientImplTest, TargetClientAttachesLazily) {
+  std::vector<std::string> sent_messages;
+  SyncWebSocketFactory factory =
+      base::BindRepeating(&CreateMockSyncWebSocket8, &sent_messages);
+  DevToolsClientImpl parent(factory, "http://url",
+                            DevToolsClientImpl::kBrowserwideDevToolsClientId,
+                            base::BindRepeating(&CloserFunc));
+  std::unique_ptr<DevToolsClientImpl> child =
+      DevToolsClientImpl::CreateTargetClient(&parent, "target-1");
+  // Creating the client must not touch the connection.
+  ASSERT_TRUE(sent_messages.empty());
+
+  ASSERT_EQ(kOk, child->ConnectIfNecessary().code());
+  ASSERT_EQ(1, CountAttachMessages(sent_messages));
+  const std::string& attach = sent_messages[0];
+  EXPECT_NE(std::string::npos, attach.find("\"targetId\":\"target-1\""));
+  EXPECT_NE(std::string::npos, attach.find("\"flatten\":true"));
+
+  // Commands are scoped to the attached session over the shared socket.
+  base::DictionaryValue params;
+  ASSERT_EQ(kOk, child->SendCommand("method", params).code());
+  EXPECT_NE(std::string::npos,
+            sent_messages.back().find("\"sessionId\":\"session-abc\""));
+
+  // Reconnecting an attached client must not attach a second session.
+  ASSERT_EQ(kOk, child->ConnectIfNecessary().code());
+  ASSERT_EQ(1, CountAttachMessages(sent_messages));
+}
+
+namespace {
+
+int CountMessagesContaining(const std::vector<std::string>& sent_messages,
+                            const std::string& substring) {
+  int count = 0;
+  for (const std::string& message : sent_messages) {
+    if (message.find(substring) != std::string::npos)
+      count++;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST_F(DevToolsClientImplTest, EnableDomainIsReferenceCounted) {
+  std::vector<std::string> sent_messages;
+  SyncWebSocketFactory factory =
+      base::BindRepeating(&CreateMockSyncWebSocket8, &sent_messages);
+  DevToolsClientImpl client(factory, "http://url",
+                            DevToolsClientImpl::kBrowserwideDevToolsClientId,
+                            base::BindRepeating(&CloserFunc));
+  ASSERT_EQ(kOk, client.ConnectIfNecessary().code());
+
+  // The enable command goes out only for the first user of the domain.
+  ASSERT_EQ(kOk, client.EnableDomain("Network").code());
+  ASSERT_EQ(kOk, client.EnableDomain("Network").code());
+  ASSERT_EQ(1, CountMessagesContaining(sent_messages, "Network.enable"));
+
+  // The disable command goes out only when the last user lets go.
+  ASSERT_EQ(kOk, client.DisableDomain("Network").code());
+  ASSERT_EQ(0, CountMessagesContaining(sent_messages, "Network.disable"));
+  ASSERT_EQ(kOk, client.DisableDomain("Network").code());
+  ASSERT_EQ(1, CountMessagesContaining(sent_messages, "Network.disable"));
+
+  // Disabling a domain with no users is a no-op.
+  ASSERT_EQ(kOk, client.DisableDomain("Network").code());
+  ASSERT_EQ(1, CountMessagesContaining(sent_messages, "Network.disable"));
+
+  // A new user enables the domain again.
+  ASSERT_EQ(kOk, client.EnableDomain("Network").code());
+  ASSERT_EQ(2, CountMessagesContaining(sent_messages, "Network.enable"));
+}
+
+namespace {
+
+std::unique_ptr<SyncWebSocket> CreateCountingMockSyncWebSocket8(
+    std::vector<std::string>* sent_messages,
+    int* socket_count) {
+  ++*socket_count;
+  return std::make_unique<MockSyncWebSocket8>(sent_messages);
+}
+
+}  // namespace
+
+TEST_F(DevToolsClientImplTest, BulkTransferClientUsesItsOwnConnection) {
+  std::vector<std::string> sent_messages;
+  int socket_count = 0;
+  SyncWebSocketFactory factory = base::BindRepeating(
+      &CreateCountingMockSyncWebSocket8, &sent_messages, &socket_count);
+  DevToolsClientImpl client(factory, "http://url", "id",
+                            base::BindRepeating(&CloserFunc));
+  ASSERT_EQ(kOk, client.ConnectIfNecessary().code());
+  ASSERT_EQ(1, socket_count);
+
+  DevToolsClient* bulk = client.GetBulkTransferClient();
+  ASSERT_NE(&client, bulk);
+  ASSERT_EQ(2, socket_count);
+
+  // The channel is created once and reused, and does not chain further.
+  ASSERT_EQ(bulk, client.GetBulkTransferClient());
+  ASSERT_EQ(bulk, bulk->GetBulkTransferClient());
+  ASSERT_EQ(2, socket_count);
+
+  base::DictionaryValue params;
+  ASSERT_EQ(kOk, bulk->SendCommand("Page.captureScreenshot", params).code());
+}
+
+TEST_F(DevToolsClientImplTest, TargetClientBulkChannelAttachesOverOwnRoot) {
+  std::vector<std::string> sent_messages;
+  int socket_count = 0;
+  SyncWebSocketFactory factory = base::BindRepeating(
+      &CreateCountingMockSyncWebSocket8, &sent_messages, &socket_count);
+  DevToolsClientImpl parent(factory, "http://url",
+                            DevToolsClientImpl::kBrowserwideDevToolsClientId,
+                            base::BindRepeating(&CloserFunc));
+  std::unique_ptr<DevToolsClientImpl> child =
+      DevToolsClientImpl::CreateTargetClient(&parent, "target-1");
+  ASSERT_EQ(kOk, child->ConnectIfNecessary().code());
+  ASSERT_EQ(1, socket_count);
+  ASSERT_EQ(1, CountAttachMessages(sent_messages));
+
+  // The bulk session attaches to the same target over a new connection, so
+  // its responses cannot stall commands on the shared socket.
+  DevToolsClient* bulk = child->GetBulkTransferClient();
+  ASSERT_NE(child.get(), bulk);
+  ASSERT_EQ(2, socket_count);
+  ASSERT_EQ(2, CountAttachMessages(sent_messages));
+  EXPECT_NE(std::string::npos,
+            sent_messages.back().find("\"targetId\":\"target-1\""));
+
+  ASSERT_EQ(bulk, child->GetBulkTransferClient());
+  ASSERT_EQ(2, socket_count);
+}
@@ -18,6 +18,11 @@ Status DevToolsEventListener::OnEvent(DevToolsClient* client,
   return Status(kOk);
 }
 
+std::vector<std::string> DevToolsEventListener::SubscribedMethodPrefixes()
+    const {
+  return std::vector<std::string>();
+}
+
 Status DevToolsEventListener::OnCommandSuccess(
     DevToolsClient* client,
     const std::string& method,
@@ -6,6 +6,7 @@
 #define CHROME_TEST_CHROMEDRIVER_CHROME_DEVTOOLS_EVENT_LISTENER_H_
 
 #include <string>
+#include <vector>
 
 namespace base {
 class DictionaryValue;
@@ -29,6 +30,12 @@ class DevToolsEventListener {
                          const std::string& method,
                          const base::DictionaryValue& params);
 
+  // Method-name prefixes of the events this listener consumes, e.g.
+  // {"DOM."} or {"Page.javascriptDialog"}. The client only calls |OnEvent|
+  // for events whose method starts with one of these prefixes. An empty list
+  // (the default) subscribes the listener to all events.
+  virtual std::vector<std::string> SubscribedMethodPrefixes() const;
+
   // Called when a command success response is received.
   virtual Status OnCommandSuccess(DevToolsClient* client,
                                   const std::string& method,
@@ -4,15 +4,17 @@
 
 #include "chrome/test/chromedriver/chrome/devtools_http_client.h"
 
+#include <map>
 #include <utility>
 
 #include "base/bind.h"
 #include "base/callback_helpers.h"
 #include "base/containers/contains.h"
 #include "base/json/json_reader.h"
+#include "base/lazy_instance.h"
+#include "base/synchronization/lock.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
-#include "base/threading/platform_thread.h"
 #include "base/time/time.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/device_metrics.h"
@@ -21,8 +23,74 @@
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/web_view_impl.h"
 #include "chrome/test/chromedriver/net/net_util.h"
+#include "chrome/test/chromedriver/net/timeout.h"
 #include "services/network/public/mojom/url_loader_factory.mojom.h"
 
+namespace {
+
+// Upper bound for the exponential backoff of AdaptiveWaiter-paced polls, so
+// waits that resolve quickly (the common case at session startup) return
+// after a few milliseconds instead of always paying a full 50 ms period.
+constexpr base::TimeDelta kMaxPollInterval =
+    base::TimeDelta::FromMilliseconds(50);
+
+// How long a cached /json/version response stays valid. Long-lived nodes
+// run the same browser build for hours, but a minute bounds how stale the
+// reported version can get if the browser behind a port is swapped.
+constexpr base::TimeDelta kBrowserVersionCacheTTL =
+    base::TimeDelta::FromMinutes(1);
+
+struct BrowserVersionCacheEntry {
+  std::string data;
+  base::TimeTicks fetch_time;
+};
+
+// Process-wide cache of raw /json/version responses keyed by version URL,
+// so only the first session targeting a long-lived browser instance pays
+// the fetch. Session threads access it concurrently, hence the lock.
+struct BrowserVersionCache {
+  base::Lock lock;
+  std::map<std::string, BrowserVersionCacheEntry> entries;
+};
+
+base::LazyInstance<BrowserVersionCache>::Leaky g_browser_version_cache =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+namespace internal {
+
+bool LookupCachedBrowserVersion(const std::string& version_url,
+                                std::string* data) {
+  BrowserVersionCache& cache = g_browser_version_cache.Get();
+  base::AutoLock lock(cache.lock);
+  auto it = cache.entries.find(version_url);
+  if (it == cache.entries.end())
+    return false;
+  if (base::TimeTicks::Now() - it->second.fetch_time >
+      kBrowserVersionCacheTTL) {
+    cache.entries.erase(it);
+    return false;
+  }
+  *data = it->second.data;
+  return true;
+}
+
+void StoreCachedBrowserVersion(const std::string& version_url,
+                               const std::string& data) {
+  BrowserVersionCache& cache = g_browser_version_cache.Get();
+  base::AutoLock lock(cache.lock);
+  cache.entries[version_url] = {data, base::TimeTicks::Now()};
+}
+
+void InvalidateCachedBrowserVersion(const std::string& version_url) {
+  BrowserVersionCache& cache = g_browser_version_cache.Get();
+  base::AutoLock lock(cache.lock);
+  cache.entries.erase(version_url);
+}
+
+}  // namespace internal
+
 WebViewInfo::WebViewInfo(const std::string& id,
                          const std::string& debugger_url,
                          const std::string& url,
@@ -90,23 +158,38 @@ Status DevToolsHttpClient::Init(const base::TimeDelta& timeout) {
 
   browser_info_.debugger_endpoint = endpoint_;
 
-  base::TimeTicks deadline = base::TimeTicks::Now() + timeout;
+  Timeout server_timeout(timeout);
   std::string version_url = endpoint_.GetVersionUrl();
   std::string data;
 
-  while (!FetchUrlAndLog(version_url, &data) || data.empty()) {
-    if (base::TimeTicks::Now() > deadline)
-      return Status(kChromeNotReachable);
-    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(50));
+  if (!internal::LookupCachedBrowserVersion(version_url, &data)) {
+    AdaptiveWaiter waiter(kMaxPollInterval);
+    while (!FetchUrlAndLog(version_url, &data) || data.empty()) {
+      if (server_timeout.IsExpired()) {
+        // The browser behind this endpoint is gone or not up yet, so any
+        // cached version for it can no longer be trusted either.
+        internal::InvalidateCachedBrowserVersion(version_url);
+        return Status(kChromeNotReachable);
+      }
+      waiter.Wait(&server_timeout);
+    }
+    internal::StoreCachedBrowserVersion(version_url, data);
   }
 
   return ParseBrowserInfo(data, &browser_info_);
 }
 
+void DevToolsHttpClient::SetCachedBrowserInfo(const BrowserInfo& browser_info) {
+  browser_info_ = browser_info;
+  browser_info_.debugger_endpoint = endpoint_;
+}
+
 Status DevToolsHttpClient::GetWebViewsInfo(WebViewsInfo* views_info) {
   std::string data;
-  if (!FetchUrlAndLog(endpoint_.GetListUrl(), &data))
+  if (!FetchUrlAndLog(endpoint_.GetListUrl(), &data)) {
+    internal::InvalidateCachedBrowserVersion(endpoint_.GetVersionUrl());
     return Status(kChromeNotReachable);
+  }
 
   return internal::ParseWebViewsInfo(data, views_info);
 }
@@ -126,9 +209,9 @@ Status DevToolsHttpClient::CloseWebView(const std::string& id) {
   }
 
   // Wait for the target window to be completely closed.
-  base::TimeTicks deadline =
-      base::TimeTicks::Now() + base::TimeDelta::FromSeconds(20);
-  while (base::TimeTicks::Now() < deadline) {
+  Timeout close_timeout(base::TimeDelta::FromSeconds(20));
+  AdaptiveWaiter waiter(kMaxPollInterval);
+  while (!close_timeout.IsExpired()) {
     WebViewsInfo views_info;
     Status status = GetWebViewsInfo(&views_info);
     if (status.code() == kChromeNotReachable)
@@ -137,7 +220,7 @@ Status DevToolsHttpClient::CloseWebView(const std::string& id) {
       return status;
     if (!views_info.GetForId(id))
       return Status(kOk);
-    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(50));
+    waiter.Wait(&close_timeout);
   }
   return Status(kUnknownError, "failed to close window in 20 seconds");
 }
@@ -217,9 +300,9 @@ Status DevToolsHttpClient::CloseFrontends(const std::string& for_client_id) {
   }
 
   // Wait until DevTools UI disconnects from the given web view.
-  base::TimeTicks deadline =
-      base::TimeTicks::Now() + base::TimeDelta::FromSeconds(20);
-  while (base::TimeTicks::Now() < deadline) {
+  Timeout debugger_timeout(base::TimeDelta::FromSeconds(20));
+  AdaptiveWaiter waiter(kMaxPollInterval);
+  while (!debugger_timeout.IsExpired()) {
     status = GetWebViewsInfo(&views_info);
     if (status.IsError())
       return status;
@@ -230,7 +313,7 @@ Status DevToolsHttpClient::CloseFrontends(const std::string& for_client_id) {
     if (view_info->debugger_url.size())
       return Status(kOk);
 
-    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(50));
+    waiter.Wait(&debugger_timeout);
   }
   return Status(kUnknownError, "failed to close UI debuggers");
 }
@@ -276,6 +359,34 @@ Status ParseType(const std::string& type_as_string, WebViewInfo::Type* type) {
   return Status(kOk);
 }
 
+std::string WebViewTypeToString(WebViewInfo::Type type) {
+  switch (type) {
+    case WebViewInfo::kApp:
+      return "app";
+    case WebViewInfo::kBackgroundPage:
+      return "background_page";
+    case WebViewInfo::kPage:
+      return "page";
+    case WebViewInfo::kWorker:
+      return "worker";
+    case WebViewInfo::kWebView:
+      return "webview";
+    case WebViewInfo::kIFrame:
+      return "iframe";
+    case WebViewInfo::kOther:
+      return "other";
+    case WebViewInfo::kServiceWorker:
+      return "service_worker";
+    case WebViewInfo::kSharedWorker:
+      return "shared_worker";
+    case WebViewInfo::kExternal:
+      return "external";
+    case WebViewInfo::kBrowser:
+      return "browser";
+  }
+  return "other";
+}
+
 namespace internal {
 
 Status ParseWebViewsInfo(const std::string& data, WebViewsInfo* views_info) {
@@ -306,7 +417,9 @@ Status ParseWebViewsInfo(const std::string& data, WebViewsInfo* views_info) {
     Status status = ParseType(type_as_string, &type);
     if (status.IsError())
       return status;
-    temp_views_info.push_back(WebViewInfo(id, debugger_url, url, type));
+    WebViewInfo view_info(id, debugger_url, url, type);
+    info->GetString("title", &view_info.title);
+    temp_views_info.push_back(view_info);
   }
   *views_info = WebViewsInfo(temp_views_info);
   return Status(kOk);
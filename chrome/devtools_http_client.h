@@ -60,6 +60,8 @@ struct WebViewInfo {
   std::string id;
   std::string debugger_url;
   std::string url;
+  // The target's title; empty when the source did not report one.
+  std::string title;
   Type type;
 };
 
@@ -89,6 +91,11 @@ class DevToolsHttpClient {
 
   Status Init(const base::TimeDelta& timeout);
 
+  // Adopts a BrowserInfo recorded by an earlier session's handshake with the
+  // same endpoint, in place of Init's fetch and parse. See
+  // RemoteBrowserRegistry.
+  void SetCachedBrowserInfo(const BrowserInfo& browser_info);
+
   Status GetWebViewsInfo(WebViewsInfo* views_info);
 
   std::unique_ptr<DevToolsClient> CreateClient(const std::string& id);
@@ -118,8 +125,22 @@ class DevToolsHttpClient {
 
 Status ParseType(const std::string& data, WebViewInfo::Type* type);
 
+// The inverse of ParseType: renders a target type with the names the
+// DevTools HTTP target list uses.
+std::string WebViewTypeToString(WebViewInfo::Type type);
+
 namespace internal {
 Status ParseWebViewsInfo(const std::string& data, WebViewsInfo* views_info);
+
+// Process-wide cache of raw /json/version responses keyed by version URL,
+// so only the first session targeting a long-lived browser instance pays
+// the round trip. Entries expire after a short TTL and are invalidated
+// when the endpoint stops responding.
+bool LookupCachedBrowserVersion(const std::string& version_url,
+                                std::string* data);
+void StoreCachedBrowserVersion(const std::string& version_url,
+                               const std::string& data);
+void InvalidateCachedBrowserVersion(const std::string& version_url);
 }  // namespace internal
 
 #endif  // CHROME_TEST_CHROMEDRIVER_CHROME_DEVTOOLS_HTTP_CLIENT_H_
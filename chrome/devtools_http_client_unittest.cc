@@ -145,3 +145,33 @@ TEST(ParseWebViewsInfo, InvalidUrl) {
       "[{\"type\": \"page\", \"id\": \"1\", \"url\": 1,"
       "  \"webSocketDebuggerUrl\": \"ws://debugurl1\"}]");
 }
+
+TEST(BrowserVersionCache, StoreLookupInvalidate) {
+  const std::string url = "http://localhost:9999/json/version";
+  std::string data;
+  ASSERT_FALSE(internal::LookupCachedBrowserVersion(url, &data));
+
+  internal::StoreCachedBrowserVersion(url, "{\"Browser\": \"Chrome/1\"}");
+  ASSERT_TRUE(internal::LookupCachedBrowserVersion(url, &data));
+  ASSERT_EQ("{\"Browser\": \"Chrome/1\"}", data);
+
+  // A second store for the same endpoint replaces the entry.
+  internal::StoreCachedBrowserVersion(url, "{\"Browser\": \"Chrome/2\"}");
+  ASSERT_TRUE(internal::LookupCachedBrowserVersion(url, &data));
+  ASSERT_EQ("{\"Browser\": \"Chrome/2\"}", data);
+
+  internal::InvalidateCachedBrowserVersion(url);
+  ASSERT_FALSE(internal::LookupCachedBrowserVersion(url, &data));
+}
+
+TEST(BrowserVersionCache, EntriesAreKeyedByUrl) {
+  const std::string url_a = "http://localhost:11111/json/version";
+  const std::string url_b = "http://localhost:22222/json/version";
+  internal::StoreCachedBrowserVersion(url_a, "a");
+
+  std::string data;
+  ASSERT_FALSE(internal::LookupCachedBrowserVersion(url_b, &data));
+  ASSERT_TRUE(internal::LookupCachedBrowserVersion(url_a, &data));
+  ASSERT_EQ("a", data);
+  internal::InvalidateCachedBrowserVersion(url_a);
+}
@@ -0,0 +1,451 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/dom_snapshot_extractor.h"
+
+#include <utility>
+
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/values.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+
+namespace {
+
+// From DOM.Node.nodeType.
+const int kElementNodeType = 1;
+const int kTextNodeType = 3;
+
+// One compound selector (e.g. "div.item[data-id=3]") within a chain.
+struct SimpleSelector {
+  struct AttributeTest {
+    std::string name;
+    // False for a bare presence test ("[attr]").
+    bool has_value = false;
+    std::string value;
+  };
+
+  std::string tag;  // Empty or "*" matches any element.
+  std::string id;
+  std::vector<std::string> classes;
+  std::vector<AttributeTest> attributes;
+  // Whether the next selector in the chain must match a direct child of
+  // this one's match rather than any descendant. Unused on the last entry.
+  bool child_combinator = false;
+};
+
+// A decoded row of the snapshot's parallel node arrays.
+struct NodeData {
+  int parent = -1;
+  int type = 0;
+  std::string name;  // Lowercased; empty for non-element nodes.
+  std::string value;
+  std::vector<std::pair<std::string, std::string>> attributes;
+  const base::ListValue* bounds = nullptr;  // [x, y, width, height] or null.
+};
+
+bool IsIdentChar(char c) {
+  return base::IsAsciiAlpha(c) || base::IsAsciiDigit(c) || c == '-' ||
+         c == '_';
+}
+
+// Parses one compound selector token. Returns false on syntax outside the
+// supported subset.
+bool ParseCompound(const std::string& token, SimpleSelector* out) {
+  size_t i = 0;
+  if (i < token.size() && token[i] == '*') {
+    out->tag = "*";
+    ++i;
+  } else {
+    size_t start = i;
+    while (i < token.size() && IsIdentChar(token[i]))
+      ++i;
+    out->tag = base::ToLowerASCII(token.substr(start, i - start));
+  }
+  while (i < token.size()) {
+    char c = token[i];
+    if (c == '#' || c == '.') {
+      ++i;
+      size_t start = i;
+      while (i < token.size() && IsIdentChar(token[i]))
+        ++i;
+      if (i == start)
+        return false;
+      std::string ident = token.substr(start, i - start);
+      if (c == '#') {
+        if (!out->id.empty())
+          return false;
+        out->id = ident;
+      } else {
+        out->classes.push_back(ident);
+      }
+    } else if (c == '[') {
+      ++i;
+      size_t start = i;
+      while (i < token.size() && IsIdentChar(token[i]))
+        ++i;
+      if (i == start)
+        return false;
+      SimpleSelector::AttributeTest test;
+      test.name = base::ToLowerASCII(token.substr(start, i - start));
+      if (i < token.size() && token[i] == '=') {
+        ++i;
+        test.has_value = true;
+        char quote = 0;
+        if (i < token.size() && (token[i] == '"' || token[i] == '\''))
+          quote = token[i++];
+        size_t value_start = i;
+        char terminator = quote ? quote : ']';
+        while (i < token.size() && token[i] != terminator)
+          ++i;
+        test.value = token.substr(value_start, i - value_start);
+        if (quote) {
+          if (i >= token.size())
+            return false;
+          ++i;
+        }
+      }
+      if (i >= token.size() || token[i] != ']')
+        return false;
+      ++i;
+      out->attributes.push_back(test);
+    } else {
+      // Pseudo-classes, sibling combinators, and everything else the
+      // snapshot cannot answer.
+      return false;
+    }
+  }
+  return !(out->tag.empty() && out->id.empty() && out->classes.empty() &&
+           out->attributes.empty());
+}
+
+// Parses a selector group (no commas) into a left-to-right chain of
+// compound selectors joined by descendant or child combinators.
+bool ParseSelectorChain(const std::string& selector,
+                        std::vector<SimpleSelector>* chain) {
+  // Normalize "a>b" to "a > b" so splitting on whitespace exposes the
+  // combinator as its own token.
+  std::string normalized;
+  for (char c : selector) {
+    if (c == '>')
+      normalized += " > ";
+    else
+      normalized += c;
+  }
+  std::vector<std::string> tokens =
+      base::SplitString(normalized, base::kWhitespaceASCII,
+                        base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+  bool pending_child = false;
+  for (const std::string& token : tokens) {
+    if (token == ">") {
+      if (chain->empty() || pending_child)
+        return false;
+      pending_child = true;
+      continue;
+    }
+    SimpleSelector compound;
+    if (!ParseCompound(token, &compound))
+      return false;
+    if (pending_child) {
+      chain->back().child_combinator = true;
+      pending_child = false;
+    }
+    chain->push_back(compound);
+  }
+  return !chain->empty() && !pending_child;
+}
+
+bool MatchesSimple(const NodeData& node, const SimpleSelector& selector) {
+  if (node.type != kElementNodeType)
+    return false;
+  if (!selector.tag.empty() && selector.tag != "*" &&
+      selector.tag != node.name)
+    return false;
+  for (const auto& entry : selector.attributes) {
+    bool found = false;
+    for (const auto& attribute : node.attributes) {
+      if (attribute.first == entry.name) {
+        found = !entry.has_value || attribute.second == entry.value;
+        break;
+      }
+    }
+    if (!found)
+      return false;
+  }
+  if (!selector.id.empty() || !selector.classes.empty()) {
+    std::string id, class_attr;
+    for (const auto& attribute : node.attributes) {
+      if (attribute.first == "id")
+        id = attribute.second;
+      else if (attribute.first == "class")
+        class_attr = attribute.second;
+    }
+    if (!selector.id.empty() && selector.id != id)
+      return false;
+    if (!selector.classes.empty()) {
+      std::vector<std::string> classes =
+          base::SplitString(class_attr, base::kWhitespaceASCII,
+                            base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+      for (const std::string& wanted : selector.classes) {
+        bool found = false;
+        for (const std::string& actual : classes) {
+          if (actual == wanted) {
+            found = true;
+            break;
+          }
+        }
+        if (!found)
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Whether chain[pos] matches |node_index| with all preceding selectors
+// satisfied by its ancestors. Descendant steps backtrack, so a nearer
+// ancestor failing the rest of the chain does not hide a farther one that
+// satisfies it.
+bool MatchesChainAt(const std::vector<NodeData>& nodes,
+                    int node_index,
+                    const std::vector<SimpleSelector>& chain,
+                    size_t pos) {
+  if (!MatchesSimple(nodes[node_index], chain[pos]))
+    return false;
+  if (pos == 0)
+    return true;
+  int parent = nodes[node_index].parent;
+  if (chain[pos - 1].child_combinator)
+    return parent >= 0 && MatchesChainAt(nodes, parent, chain, pos - 1);
+  while (parent >= 0) {
+    if (MatchesChainAt(nodes, parent, chain, pos - 1))
+      return true;
+    parent = nodes[parent].parent;
+  }
+  return false;
+}
+
+bool GetIntFromValue(const base::Value& value, int* out) {
+  if (value.is_int()) {
+    *out = value.GetInt();
+    return true;
+  }
+  if (value.is_double()) {
+    *out = static_cast<int>(value.GetDouble());
+    return true;
+  }
+  return false;
+}
+
+// Resolves |index| against the snapshot's string table; -1 means absent.
+bool StringFromTable(const base::ListValue& strings,
+                     int index,
+                     std::string* out) {
+  if (index < 0) {
+    out->clear();
+    return true;
+  }
+  return strings.GetString(index, out);
+}
+
+Status MalformedSnapshot() {
+  return Status(kUnknownError,
+                "malformed DOMSnapshot.captureSnapshot response");
+}
+
+// Decodes one document's parallel node arrays, plus the layout table's
+// bounds, into |nodes| and a child adjacency list for text assembly.
+Status DecodeDocument(const base::DictionaryValue& document,
+                      const base::ListValue& strings,
+                      std::vector<NodeData>* nodes,
+                      std::vector<std::vector<int>>* children) {
+  const base::DictionaryValue* node_table = nullptr;
+  if (!document.GetDictionary("nodes", &node_table))
+    return MalformedSnapshot();
+  const base::ListValue* parent_index = nullptr;
+  const base::ListValue* node_type = nullptr;
+  const base::ListValue* node_name = nullptr;
+  const base::ListValue* node_value = nullptr;
+  const base::ListValue* attributes = nullptr;
+  if (!node_table->GetList("parentIndex", &parent_index) ||
+      !node_table->GetList("nodeType", &node_type) ||
+      !node_table->GetList("nodeName", &node_name) ||
+      !node_table->GetList("nodeValue", &node_value) ||
+      !node_table->GetList("attributes", &attributes))
+    return MalformedSnapshot();
+  size_t count = node_type->GetSize();
+  if (parent_index->GetSize() != count || node_name->GetSize() != count ||
+      node_value->GetSize() != count || attributes->GetSize() != count)
+    return MalformedSnapshot();
+
+  nodes->resize(count);
+  children->resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    NodeData& node = (*nodes)[i];
+    const base::Value* entry = nullptr;
+    int string_index = 0;
+    if (!parent_index->Get(i, &entry) || !GetIntFromValue(*entry, &node.parent))
+      return MalformedSnapshot();
+    if (!node_type->Get(i, &entry) || !GetIntFromValue(*entry, &node.type))
+      return MalformedSnapshot();
+    if (!node_name->Get(i, &entry) || !GetIntFromValue(*entry, &string_index) ||
+        !StringFromTable(strings, string_index, &node.name))
+      return MalformedSnapshot();
+    node.name = base::ToLowerASCII(node.name);
+    if (!node_value->Get(i, &entry) ||
+        !GetIntFromValue(*entry, &string_index) ||
+        !StringFromTable(strings, string_index, &node.value))
+      return MalformedSnapshot();
+    const base::ListValue* attribute_row = nullptr;
+    if (!attributes->GetList(i, &attribute_row))
+      return MalformedSnapshot();
+    for (size_t j = 0; j + 1 < attribute_row->GetSize(); j += 2) {
+      const base::Value* name_entry = nullptr;
+      const base::Value* value_entry = nullptr;
+      int name_index = 0, value_index = 0;
+      std::string name, value;
+      if (!attribute_row->Get(j, &name_entry) ||
+          !GetIntFromValue(*name_entry, &name_index) ||
+          !attribute_row->Get(j + 1, &value_entry) ||
+          !GetIntFromValue(*value_entry, &value_index) ||
+          !StringFromTable(strings, name_index, &name) ||
+          !StringFromTable(strings, value_index, &value))
+        return MalformedSnapshot();
+      node.attributes.emplace_back(base::ToLowerASCII(name), value);
+    }
+    if (node.parent >= 0 && static_cast<size_t>(node.parent) < count)
+      (*children)[node.parent].push_back(static_cast<int>(i));
+  }
+
+  // Layout bounds are optional per node; elements the renderer never laid
+  // out (display:none and descendants) simply have no row here.
+  const base::DictionaryValue* layout = nullptr;
+  if (document.GetDictionary("layout", &layout)) {
+    const base::ListValue* layout_index = nullptr;
+    const base::ListValue* bounds = nullptr;
+    if (layout->GetList("nodeIndex", &layout_index) &&
+        layout->GetList("bounds", &bounds)) {
+      for (size_t i = 0;
+           i < layout_index->GetSize() && i < bounds->GetSize(); ++i) {
+        const base::Value* entry = nullptr;
+        const base::ListValue* rect = nullptr;
+        int target = 0;
+        if (layout_index->Get(i, &entry) && GetIntFromValue(*entry, &target) &&
+            target >= 0 && static_cast<size_t>(target) < count &&
+            bounds->GetList(i, &rect)) {
+          (*nodes)[target].bounds = rect;
+        }
+      }
+    }
+  }
+  return Status(kOk);
+}
+
+// Concatenates the values of |root|'s descendant text nodes in document
+// order, i.e. textContent.
+std::string CollectText(const std::vector<NodeData>& nodes,
+                        const std::vector<std::vector<int>>& children,
+                        int root) {
+  std::string text;
+  std::vector<int> stack(children[root].rbegin(), children[root].rend());
+  while (!stack.empty()) {
+    int index = stack.back();
+    stack.pop_back();
+    if (nodes[index].type == kTextNodeType)
+      text += nodes[index].value;
+    stack.insert(stack.end(), children[index].rbegin(),
+                 children[index].rend());
+  }
+  return text;
+}
+
+std::unique_ptr<base::DictionaryValue> BuildMatch(
+    const std::vector<NodeData>& nodes,
+    const std::vector<std::vector<int>>& children,
+    int index) {
+  auto match = std::make_unique<base::DictionaryValue>();
+  match->SetString("text", CollectText(nodes, children, index));
+  auto attributes = std::make_unique<base::DictionaryValue>();
+  for (const auto& attribute : nodes[index].attributes) {
+    // SetKey, since attribute names may contain path separators.
+    attributes->SetKey(attribute.first, base::Value(attribute.second));
+  }
+  match->Set("attributes", std::move(attributes));
+  const base::ListValue* bounds = nodes[index].bounds;
+  double x, y, width, height;
+  if (bounds && bounds->GetDouble(0, &x) && bounds->GetDouble(1, &y) &&
+      bounds->GetDouble(2, &width) && bounds->GetDouble(3, &height)) {
+    auto rect = std::make_unique<base::DictionaryValue>();
+    rect->SetDouble("x", x);
+    rect->SetDouble("y", y);
+    rect->SetDouble("width", width);
+    rect->SetDouble("height", height);
+    match->Set("rect", std::move(rect));
+  }
+  return match;
+}
+
+}  // namespace
+
+Status ExtractContentFromSnapshot(const base::DictionaryValue& snapshot,
+                                  const std::vector<std::string>& selectors,
+                                  std::unique_ptr<base::ListValue>* result) {
+  // Comma-separated groups per selector, each a combinator chain.
+  std::vector<std::vector<std::vector<SimpleSelector>>> parsed;
+  for (const std::string& selector : selectors) {
+    std::vector<std::vector<SimpleSelector>> groups;
+    for (const std::string& group :
+         base::SplitString(selector, ",", base::TRIM_WHITESPACE,
+                           base::SPLIT_WANT_NONEMPTY)) {
+      std::vector<SimpleSelector> chain;
+      if (!ParseSelectorChain(group, &chain))
+        return Status(kInvalidArgument, "unsupported selector: " + selector);
+      groups.push_back(std::move(chain));
+    }
+    if (groups.empty())
+      return Status(kInvalidArgument, "unsupported selector: " + selector);
+    parsed.push_back(std::move(groups));
+  }
+
+  const base::ListValue* strings = nullptr;
+  const base::ListValue* documents = nullptr;
+  if (!snapshot.GetList("strings", &strings) ||
+      !snapshot.GetList("documents", &documents))
+    return MalformedSnapshot();
+
+  std::vector<std::unique_ptr<base::ListValue>> matches;
+  for (size_t i = 0; i < selectors.size(); ++i)
+    matches.push_back(std::make_unique<base::ListValue>());
+
+  for (size_t doc = 0; doc < documents->GetSize(); ++doc) {
+    const base::DictionaryValue* document = nullptr;
+    if (!documents->GetDictionary(doc, &document))
+      return MalformedSnapshot();
+    std::vector<NodeData> nodes;
+    std::vector<std::vector<int>> children;
+    Status status = DecodeDocument(*document, *strings, &nodes, &children);
+    if (status.IsError())
+      return status;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (nodes[i].type != kElementNodeType)
+        continue;
+      for (size_t s = 0; s < parsed.size(); ++s) {
+        for (const std::vector<SimpleSelector>& chain : parsed[s]) {
+          if (MatchesChainAt(nodes, static_cast<int>(i), chain,
+                             chain.size() - 1)) {
+            matches[s]->Append(BuildMatch(nodes, children,
+                                          static_cast<int>(i)));
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  auto lists = std::make_unique<base::ListValue>();
+  for (auto& entry : matches)
+    lists->Append(std::move(entry));
+  *result = std::move(lists);
+  return Status(kOk);
+}
@@ -0,0 +1,38 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_CHROME_DOM_SNAPSHOT_EXTRACTOR_H_
+#define CHROME_TEST_CHROMEDRIVER_CHROME_DOM_SNAPSHOT_EXTRACTOR_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace base {
+class DictionaryValue;
+class ListValue;
+}
+
+class Status;
+
+// Decodes a flattened DOMSnapshot.captureSnapshot response and returns, for
+// each entry of |selectors|, the matching elements across all captured
+// documents with their text content, attributes, and layout rect, so bulk
+// extraction costs one CDP exchange instead of per-element atom round trips.
+//
+// |result| receives one list per selector, aligned with the input; each
+// match is a dictionary with "text" (the element's concatenated descendant
+// text nodes, i.e. textContent), "attributes", and, when the element was
+// laid out, "rect" with frame-local coordinates.
+//
+// Selectors support a matching subset decodable from the snapshot: tag, "*",
+// "#id", ".class", "[attr]" and "[attr=value]" tests, compounds of those,
+// and descendant/child combinators, with comma-separated groups. Anything
+// else (notably pseudo-classes, which depend on state the snapshot does not
+// carry) fails with kInvalidArgument.
+Status ExtractContentFromSnapshot(const base::DictionaryValue& snapshot,
+                                  const std::vector<std::string>& selectors,
+                                  std::unique_ptr<base::ListValue>* result);
+
+#endif  // CHROME_TEST_CHROMEDRIVER_CHROME_DOM_SNAPSHOT_EXTRACTOR_H_
@@ -0,0 +1,144 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/dom_snapshot_extractor.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/json/json_reader.h"
+#include "base/values.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// A flattened snapshot of:
+//   <html><body>
+//     <div id="main" class="item big">Hello <span>world</span></div>
+//     <p class="empty"></p>
+//   </body></html>
+// where the <p> was never laid out.
+std::unique_ptr<base::DictionaryValue> MakeTestSnapshot() {
+  const char kSnapshotJson[] = R"({
+    "strings": ["#document", "HTML", "BODY", "DIV", "id", "main", "class",
+                "item big", "#text", "Hello ", "SPAN", "world", "P", "empty"],
+    "documents": [{
+      "nodes": {
+        "parentIndex": [-1, 0, 1, 2, 3, 3, 5, 2],
+        "nodeType": [9, 1, 1, 1, 3, 1, 3, 1],
+        "nodeName": [0, 1, 2, 3, 8, 10, 8, 12],
+        "nodeValue": [-1, -1, -1, -1, 9, -1, 11, -1],
+        "attributes": [[], [], [], [4, 5, 6, 7], [], [], [], [6, 13]]
+      },
+      "layout": {
+        "nodeIndex": [1, 2, 3, 5],
+        "bounds": [[0, 0, 800, 600], [0, 0, 800, 600], [10, 20, 100, 50],
+                   [12, 22, 40, 10]]
+      }
+    }]
+  })";
+  std::unique_ptr<base::Value> value =
+      base::JSONReader::ReadDeprecated(kSnapshotJson);
+  base::DictionaryValue* dict = nullptr;
+  EXPECT_TRUE(value && value->GetAsDictionary(&dict));
+  return base::DictionaryValue::From(std::move(value));
+}
+
+}  // namespace
+
+TEST(DomSnapshotExtractor, CompoundSelectors) {
+  std::unique_ptr<base::DictionaryValue> snapshot = MakeTestSnapshot();
+  std::unique_ptr<base::ListValue> result;
+  ASSERT_EQ(kOk, ExtractContentFromSnapshot(
+                     *snapshot, {"div#main.item", "p[class=empty]", ".missing"},
+                     &result)
+                     .code());
+  ASSERT_EQ(3u, result->GetSize());
+
+  const base::ListValue* matches = nullptr;
+  const base::DictionaryValue* match = nullptr;
+  ASSERT_TRUE(result->GetList(0, &matches));
+  ASSERT_EQ(1u, matches->GetSize());
+  ASSERT_TRUE(matches->GetDictionary(0, &match));
+  std::string text;
+  ASSERT_TRUE(match->GetString("text", &text));
+  ASSERT_EQ("Hello world", text);
+  std::string attribute;
+  ASSERT_TRUE(match->GetString("attributes.id", &attribute));
+  ASSERT_EQ("main", attribute);
+  double x, width;
+  ASSERT_TRUE(match->GetDouble("rect.x", &x));
+  ASSERT_TRUE(match->GetDouble("rect.width", &width));
+  ASSERT_EQ(10, x);
+  ASSERT_EQ(100, width);
+
+  // The <p> was never laid out, so its match carries no rect.
+  ASSERT_TRUE(result->GetList(1, &matches));
+  ASSERT_EQ(1u, matches->GetSize());
+  ASSERT_TRUE(matches->GetDictionary(0, &match));
+  ASSERT_FALSE(match->HasKey("rect"));
+
+  ASSERT_TRUE(result->GetList(2, &matches));
+  ASSERT_EQ(0u, matches->GetSize());
+}
+
+TEST(DomSnapshotExtractor, Combinators) {
+  std::unique_ptr<base::DictionaryValue> snapshot = MakeTestSnapshot();
+  std::unique_ptr<base::ListValue> result;
+  ASSERT_EQ(kOk, ExtractContentFromSnapshot(
+                     *snapshot, {"body > div span", "html span", "div > p"},
+                     &result)
+                     .code());
+  const base::ListValue* matches = nullptr;
+  const base::DictionaryValue* match = nullptr;
+  ASSERT_TRUE(result->GetList(0, &matches));
+  ASSERT_EQ(1u, matches->GetSize());
+  ASSERT_TRUE(matches->GetDictionary(0, &match));
+  std::string text;
+  ASSERT_TRUE(match->GetString("text", &text));
+  ASSERT_EQ("world", text);
+  ASSERT_TRUE(result->GetList(1, &matches));
+  ASSERT_EQ(1u, matches->GetSize());
+  // The <p> is a child of <body>, not of the <div>.
+  ASSERT_TRUE(result->GetList(2, &matches));
+  ASSERT_EQ(0u, matches->GetSize());
+}
+
+TEST(DomSnapshotExtractor, CommaGroupsMatchInDocumentOrder) {
+  std::unique_ptr<base::DictionaryValue> snapshot = MakeTestSnapshot();
+  std::unique_ptr<base::ListValue> result;
+  ASSERT_EQ(kOk,
+            ExtractContentFromSnapshot(*snapshot, {"span, p"}, &result).code());
+  const base::ListValue* matches = nullptr;
+  ASSERT_TRUE(result->GetList(0, &matches));
+  ASSERT_EQ(2u, matches->GetSize());
+  const base::DictionaryValue* match = nullptr;
+  std::string text;
+  ASSERT_TRUE(matches->GetDictionary(0, &match));
+  ASSERT_TRUE(match->GetString("text", &text));
+  ASSERT_EQ("world", text);
+}
+
+TEST(DomSnapshotExtractor, RejectsUnsupportedSelectors) {
+  std::unique_ptr<base::DictionaryValue> snapshot = MakeTestSnapshot();
+  std::unique_ptr<base::ListValue> result;
+  // Pseudo-classes depend on state the snapshot does not carry.
+  ASSERT_EQ(kInvalidArgument,
+            ExtractContentFromSnapshot(*snapshot, {"div:hover"}, &result)
+                .code());
+  ASSERT_EQ(kInvalidArgument,
+            ExtractContentFromSnapshot(*snapshot, {"div ~ p"}, &result)
+                .code());
+  ASSERT_EQ(kInvalidArgument,
+            ExtractContentFromSnapshot(*snapshot, {""}, &result).code());
+}
+
+TEST(DomSnapshotExtractor, MalformedSnapshot) {
+  base::DictionaryValue snapshot;
+  std::unique_ptr<base::ListValue> result;
+  ASSERT_EQ(kUnknownError,
+            ExtractContentFromSnapshot(snapshot, {"div"}, &result).code());
+}
@@ -5,40 +5,31 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_CHROME_DOM_TRACKER_H_
 #define CHROME_TEST_CHROMEDRIVER_CHROME_DOM_TRACKER_H_
 
-#include <map>
 #include <string>
 
-#include "base/compiler_specific.h"
 #include "base/macros.h"
-#include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
-
-namespace base {
-class DictionaryValue;
-class Value;
-}
 
 class DevToolsClient;
 class Status;
 
-// Tracks the state of the DOM and execution context creation.
-class DomTracker : public DevToolsEventListener {
+// Resolves the frame owned by a frame or iframe element. Resolution is
+// lazy: nothing subscribes to DOM push events and no DOM state is
+// mirrored, so the browser never streams DOM mutations to the client just
+// to keep a node-to-frame map warm. The handful of frame switches a
+// session performs each cost one DOM.describeNode round trip instead.
+class DomTracker {
  public:
   explicit DomTracker(DevToolsClient* client);
-  ~DomTracker() override;
-
-  Status GetFrameIdForNode(int node_id, std::string* frame_id);
+  ~DomTracker();
 
-  // Overridden from DevToolsEventListener:
-  Status OnConnected(DevToolsClient* client) override;
-  Status OnEvent(DevToolsClient* client,
-                 const std::string& method,
-                 const base::DictionaryValue& params) override;
+  // Resolves the frame id of the frame element referenced by |object_id|
+  // (a Runtime remote object handle, which the caller still owns and must
+  // release). Returns kNoSuchFrame if the element does not own a frame.
+  Status GetFrameIdForObject(const std::string& object_id,
+                             std::string* frame_id);
 
  private:
-  bool ProcessNodeList(const base::Value* nodes);
-  bool ProcessNode(const base::Value* node);
-
-  std::map<int, std::string> node_to_frame_map_;
+  DevToolsClient* client_;
 
   DISALLOW_COPY_AND_ASSIGN(DomTracker);
 };
@@ -2,10 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include <list>
+#include <memory>
 #include <string>
 
-#include "base/json/json_reader.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/dom_tracker.h"
 #include "chrome/test/chromedriver/chrome/status.h"
@@ -19,77 +18,56 @@ class FakeDevToolsClient : public StubDevToolsClient {
   FakeDevToolsClient() {}
   ~FakeDevToolsClient() override {}
 
-  std::string PopSentCommand() {
-    std::string command;
-    if (!sent_command_queue_.empty()) {
-      command = sent_command_queue_.front();
-      sent_command_queue_.pop_front();
-    }
-    return command;
+  void SetDescribedFrameId(const std::string& frame_id) {
+    described_frame_id_ = frame_id;
   }
 
+  const std::string& last_method() const { return last_method_; }
+  const std::string& last_object_id() const { return last_object_id_; }
+
   // Overridden from DevToolsClient:
-  Status SendCommand(const std::string& method,
-                     const base::DictionaryValue& params) override {
-    sent_command_queue_.push_back(method);
-    return Status(kOk);
-  }
   Status SendCommandAndGetResult(
       const std::string& method,
       const base::DictionaryValue& params,
       std::unique_ptr<base::DictionaryValue>* result) override {
-    return SendCommand(method, params);
+    last_method_ = method;
+    params.GetString("objectId", &last_object_id_);
+    auto node = std::make_unique<base::DictionaryValue>();
+    node->SetInteger("nodeId", 1);
+    if (!described_frame_id_.empty())
+      node->SetString("frameId", described_frame_id_);
+    *result = std::make_unique<base::DictionaryValue>();
+    (*result)->SetKey("node",
+                      base::Value::FromUniquePtrValue(std::move(node)));
+    return Status(kOk);
   }
 
  private:
-  std::list<std::string> sent_command_queue_;
+  std::string described_frame_id_;
+  std::string last_method_;
+  std::string last_object_id_;
 };
 
 }  // namespace
 
-TEST(DomTracker, GetFrameIdForNode) {
+TEST(DomTracker, GetFrameIdForFrameElement) {
   FakeDevToolsClient client;
+  client.SetDescribedFrameId("f");
   DomTracker tracker(&client);
-  std::string frame_id;
-  ASSERT_TRUE(tracker.GetFrameIdForNode(101, &frame_id).IsError());
-  ASSERT_TRUE(frame_id.empty());
 
-  const char nodes[] =
-      "[{\"nodeId\":100,\"children\":"
-      "    [{\"nodeId\":101},"
-      "     {\"nodeId\":102,\"frameId\":\"f\"}]"
-      "}]";
-  base::DictionaryValue params;
-  params.Set("nodes", base::JSONReader::ReadDeprecated(nodes));
-  ASSERT_EQ(kOk, tracker.OnEvent(&client, "DOM.setChildNodes", params).code());
-  ASSERT_TRUE(tracker.GetFrameIdForNode(101, &frame_id).IsError());
-  ASSERT_TRUE(frame_id.empty());
-  ASSERT_TRUE(tracker.GetFrameIdForNode(102, &frame_id).IsOk());
+  std::string frame_id;
+  ASSERT_TRUE(tracker.GetFrameIdForObject("obj-1", &frame_id).IsOk());
   ASSERT_STREQ("f", frame_id.c_str());
-
-  ASSERT_EQ(kOk,
-            tracker.OnEvent(&client, "DOM.documentUpdated", params).code());
-  ASSERT_TRUE(tracker.GetFrameIdForNode(102, &frame_id).IsError());
-  ASSERT_STREQ("DOM.getDocument", client.PopSentCommand().c_str());
+  ASSERT_STREQ("DOM.describeNode", client.last_method().c_str());
+  ASSERT_STREQ("obj-1", client.last_object_id().c_str());
 }
 
-TEST(DomTracker, ChildNodeInserted) {
+TEST(DomTracker, NonFrameElementIsAnError) {
   FakeDevToolsClient client;
   DomTracker tracker(&client);
-  std::string frame_id;
 
-  base::DictionaryValue params;
-  params.Set("node", base::JSONReader::ReadDeprecated("{\"nodeId\":1}"));
-  ASSERT_EQ(kOk,
-            tracker.OnEvent(&client, "DOM.childNodeInserted", params).code());
-  ASSERT_TRUE(tracker.GetFrameIdForNode(1, &frame_id).IsError());
+  std::string frame_id;
+  Status status = tracker.GetFrameIdForObject("obj-2", &frame_id);
+  ASSERT_EQ(kNoSuchFrame, status.code());
   ASSERT_TRUE(frame_id.empty());
-
-  params.Clear();
-  params.Set("node", base::JSONReader::ReadDeprecated(
-                         "{\"nodeId\":2,\"frameId\":\"f\"}"));
-  ASSERT_EQ(kOk,
-            tracker.OnEvent(&client, "DOM.childNodeInserted", params).code());
-  ASSERT_TRUE(tracker.GetFrameIdForNode(2, &frame_id).IsOk());
-  ASSERT_STREQ("f", frame_id.c_str());
 }
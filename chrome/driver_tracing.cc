@@ -0,0 +1,91 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/driver_tracing.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/threading/platform_thread.h"
+#include "base/values.h"
+
+namespace {
+
+base::LazyInstance<DriverTracing>::Leaky g_driver_tracing =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// static
+std::atomic<bool> DriverTracing::enabled_{false};
+
+DriverTracing::DriverTracing() = default;
+
+DriverTracing::~DriverTracing() = default;
+
+// static
+DriverTracing* DriverTracing::GetInstance() {
+  return g_driver_tracing.Pointer();
+}
+
+// static
+void DriverTracing::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void DriverTracing::RecordSpan(const char* name,
+                               const base::TimeTicks& start,
+                               const base::TimeTicks& end) {
+  uint32_t slot =
+      next_slot_.fetch_add(1, std::memory_order_relaxed) & (kRingSize - 1);
+  Span& span = ring_[slot];
+  uint32_t seq = span.seq.load(std::memory_order_relaxed);
+  // Odd marks the slot as mid-write so a concurrent dump skips it.
+  span.seq.store(seq + 1, std::memory_order_release);
+  span.name = name;
+  span.start_us = (start - base::TimeTicks()).InMicroseconds();
+  span.duration_us = (end - start).InMicroseconds();
+  span.thread_id = static_cast<int32_t>(base::PlatformThread::CurrentId());
+  span.seq.store(seq + 2, std::memory_order_release);
+}
+
+std::unique_ptr<base::ListValue> DriverTracing::ToValue() const {
+  struct Snapshot {
+    const char* name;
+    int64_t start_us;
+    int64_t duration_us;
+    int32_t thread_id;
+  };
+  std::vector<Snapshot> spans;
+  spans.reserve(kRingSize);
+  for (size_t i = 0; i < kRingSize; ++i) {
+    const Span& span = ring_[i];
+    uint32_t seq_before = span.seq.load(std::memory_order_acquire);
+    if (seq_before == 0 || (seq_before & 1))
+      continue;
+    Snapshot snapshot = {span.name, span.start_us, span.duration_us,
+                         span.thread_id};
+    if (span.seq.load(std::memory_order_acquire) != seq_before)
+      continue;  // Overwritten while being read.
+    spans.push_back(snapshot);
+  }
+  std::sort(spans.begin(), spans.end(),
+            [](const Snapshot& a, const Snapshot& b) {
+              return a.start_us < b.start_us;
+            });
+
+  auto events = std::make_unique<base::ListValue>();
+  for (const Snapshot& span : spans) {
+    auto event = std::make_unique<base::DictionaryValue>();
+    event->SetString("name", span.name);
+    event->SetString("cat", "chromedriver");
+    event->SetString("ph", "X");
+    event->SetDouble("ts", static_cast<double>(span.start_us));
+    event->SetDouble("dur", static_cast<double>(span.duration_us));
+    event->SetInteger("pid", 1);
+    event->SetInteger("tid", span.thread_id);
+    events->Append(std::move(event));
+  }
+  return events;
+}
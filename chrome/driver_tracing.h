@@ -0,0 +1,101 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_CHROME_DRIVER_TRACING_H_
+#define CHROME_TEST_CHROMEDRIVER_CHROME_DRIVER_TRACING_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+
+#include "base/lazy_instance.h"
+#include "base/time/time.h"
+
+namespace base {
+class ListValue;
+}
+
+// Opt-in span recorder for the driver's own dispatch path. Spans are
+// recorded at the choke points a slow command can hide in (HTTP handling,
+// session-thread execution, the DevTools round trip, socket receives) into
+// a fixed lock-free ring, and dumped as Trace Event JSON that loads into
+// chrome://tracing or Perfetto. Recording costs two clock reads and one
+// ring write; when disabled a span is a single relaxed flag read.
+class DriverTracing {
+ public:
+  static DriverTracing* GetInstance();
+
+  DriverTracing(const DriverTracing&) = delete;
+  DriverTracing& operator=(const DriverTracing&) = delete;
+
+  static bool IsEnabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Enabled for the whole process once any session asks for it via
+  // goog:chromeOptions.traceDriver; the lower layers that record spans do
+  // not know which session their work belongs to, so spans are attributed
+  // by thread instead.
+  static void SetEnabled(bool enabled);
+
+  void RecordSpan(const char* name,
+                  const base::TimeTicks& start,
+                  const base::TimeTicks& end);
+
+  // Returns the ring's surviving spans, oldest first, as a list of Trace
+  // Event complete events: {"name", "cat", "ph": "X", "ts", "dur", "pid",
+  // "tid"} with microsecond timestamps. Spans overwritten or mid-write
+  // while dumping are skipped.
+  std::unique_ptr<base::ListValue> ToValue() const;
+
+ private:
+  friend struct base::LazyInstanceTraitsBase<DriverTracing>;
+
+  // One slot of the ring. |seq| is a per-slot write counter: odd while a
+  // writer is mid-update, so a concurrent dump can detect and skip torn
+  // slots without any lock.
+  struct Span {
+    std::atomic<uint32_t> seq{0};
+    const char* name = nullptr;  // Must point at a string literal.
+    int64_t start_us = 0;
+    int64_t duration_us = 0;
+    int32_t thread_id = 0;
+  };
+
+  static constexpr size_t kRingSize = 16384;  // Must be a power of two.
+
+  DriverTracing();
+  ~DriverTracing();
+
+  static std::atomic<bool> enabled_;
+
+  std::atomic<uint32_t> next_slot_{0};
+  Span ring_[kRingSize];
+};
+
+// Records one span over its own lifetime. The name must be a string
+// literal; it is stored by pointer.
+class ScopedDriverSpan {
+ public:
+  explicit ScopedDriverSpan(const char* name)
+      : name_(DriverTracing::IsEnabled() ? name : nullptr) {
+    if (name_)
+      start_ = base::TimeTicks::Now();
+  }
+  ScopedDriverSpan(const ScopedDriverSpan&) = delete;
+  ScopedDriverSpan& operator=(const ScopedDriverSpan&) = delete;
+  ~ScopedDriverSpan() {
+    if (name_) {
+      DriverTracing::GetInstance()->RecordSpan(name_, start_,
+                                               base::TimeTicks::Now());
+    }
+  }
+
+ private:
+  const char* name_;
+  base::TimeTicks start_;
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_CHROME_DRIVER_TRACING_H_
@@ -0,0 +1,106 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/driver_tracing.h"
+
+#include <memory>
+#include <string>
+
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// Enabled state and the ring are process-wide, so each test restores the
+// disabled default on exit.
+class ScopedTracingEnabled {
+ public:
+  ScopedTracingEnabled() { DriverTracing::SetEnabled(true); }
+  ~ScopedTracingEnabled() { DriverTracing::SetEnabled(false); }
+};
+
+}  // namespace
+
+TEST(DriverTracingTest, DisabledSpanRecordsNothing) {
+  ASSERT_FALSE(DriverTracing::IsEnabled());
+  std::unique_ptr<base::ListValue> before =
+      DriverTracing::GetInstance()->ToValue();
+  { ScopedDriverSpan span("DriverTracingTest::Disabled"); }
+  std::unique_ptr<base::ListValue> after =
+      DriverTracing::GetInstance()->ToValue();
+  EXPECT_EQ(before->GetSize(), after->GetSize());
+}
+
+TEST(DriverTracingTest, RecordSpanEmitsCompleteEvent) {
+  ScopedTracingEnabled enabled;
+  base::TimeTicks start = base::TimeTicks::Now();
+  DriverTracing::GetInstance()->RecordSpan(
+      "DriverTracingTest::Event", start,
+      start + base::TimeDelta::FromMilliseconds(5));
+
+  std::unique_ptr<base::ListValue> events =
+      DriverTracing::GetInstance()->ToValue();
+  const base::DictionaryValue* found = nullptr;
+  for (size_t i = 0; i < events->GetSize(); ++i) {
+    const base::DictionaryValue* event;
+    ASSERT_TRUE(events->GetDictionary(i, &event));
+    std::string name;
+    ASSERT_TRUE(event->GetString("name", &name));
+    if (name == "DriverTracingTest::Event")
+      found = event;
+  }
+  ASSERT_TRUE(found);
+  std::string phase;
+  ASSERT_TRUE(found->GetString("ph", &phase));
+  EXPECT_EQ("X", phase);
+  std::string category;
+  ASSERT_TRUE(found->GetString("cat", &category));
+  EXPECT_EQ("chromedriver", category);
+  double duration = 0;
+  ASSERT_TRUE(found->GetDouble("dur", &duration));
+  EXPECT_EQ(5000, duration);
+  EXPECT_TRUE(found->HasKey("ts"));
+  EXPECT_TRUE(found->HasKey("tid"));
+}
+
+TEST(DriverTracingTest, ScopedSpanRecordsWhenEnabled) {
+  ScopedTracingEnabled enabled;
+  { ScopedDriverSpan span("DriverTracingTest::Scoped"); }
+
+  std::unique_ptr<base::ListValue> events =
+      DriverTracing::GetInstance()->ToValue();
+  bool found = false;
+  for (size_t i = 0; i < events->GetSize(); ++i) {
+    const base::DictionaryValue* event;
+    ASSERT_TRUE(events->GetDictionary(i, &event));
+    std::string name;
+    ASSERT_TRUE(event->GetString("name", &name));
+    if (name == "DriverTracingTest::Scoped")
+      found = true;
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST(DriverTracingTest, EventsSortedByStartTime) {
+  ScopedTracingEnabled enabled;
+  base::TimeTicks start = base::TimeTicks::Now();
+  DriverTracing* tracing = DriverTracing::GetInstance();
+  tracing->RecordSpan("DriverTracingTest::Later",
+                      start + base::TimeDelta::FromMilliseconds(2),
+                      start + base::TimeDelta::FromMilliseconds(3));
+  tracing->RecordSpan("DriverTracingTest::Earlier", start,
+                      start + base::TimeDelta::FromMilliseconds(1));
+
+  std::unique_ptr<base::ListValue> events = tracing->ToValue();
+  double last_ts = 0;
+  for (size_t i = 0; i < events->GetSize(); ++i) {
+    const base::DictionaryValue* event;
+    ASSERT_TRUE(events->GetDictionary(i, &event));
+    double ts = 0;
+    ASSERT_TRUE(event->GetDouble("ts", &ts));
+    EXPECT_GE(ts, last_ts);
+    last_ts = ts;
+  }
+}
@@ -13,10 +13,20 @@
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/web_view_impl.h"
 
+namespace {
+
+// Upper bound on installed remote functions per execution context. The atom
+// scripts account for a couple dozen entries; the rest is user script
+// bodies, which data-driven suites reuse heavily but which must not pin an
+// unbounded number of function objects in the page.
+const size_t kMaxRemoteFunctionsPerContext = 512;
+
+}  // namespace
+
 FrameTracker::FrameTracker(DevToolsClient* client,
                            WebView* web_view,
                            const BrowserInfo* browser_info)
-    : web_view_(web_view) {
+    : navigation_epoch_(0), web_view_(web_view) {
   client->AddListener(this);
 }
 
@@ -24,21 +34,29 @@ FrameTracker::~FrameTracker() {}
 
 Status FrameTracker::GetContextIdForFrame(
     const std::string& frame_id, int* context_id) {
-  if (frame_to_context_map_.count(frame_id) == 0) {
+  auto it = frame_to_context_map_.find(frame_id);
+  if (it == frame_to_context_map_.end()) {
     return Status(kNoSuchExecutionContext,
                   "frame does not have execution context");
   }
-  *context_id = frame_to_context_map_[frame_id];
+  *context_id = it->second;
   return Status(kOk);
 }
 
+void FrameTracker::GetAllFrameContexts(
+    std::vector<std::pair<std::string, int>>* contexts) const {
+  for (const auto& entry : frame_to_context_map_)
+    contexts->push_back(entry);
+}
+
 WebView* FrameTracker::GetTargetForFrame(const std::string& frame_id) {
   // Context in the current target, return current target.
   if (frame_to_context_map_.count(frame_id) != 0)
     return web_view_;
   // Child target of the current target, return that child target.
-  if (frame_to_target_map_.count(frame_id) != 0)
-    return frame_to_target_map_[frame_id].get();
+  auto target_it = frame_to_target_map_.find(frame_id);
+  if (target_it != frame_to_target_map_.end())
+    return target_it->second.get();
   // Frame unknown, recursively search all child targets.
   for (auto it = frame_to_target_map_.begin(); it != frame_to_target_map_.end();
        ++it) {
@@ -71,24 +89,99 @@ void FrameTracker::DeleteTargetForFrame(const std::string& frame_id) {
   frame_to_target_map_.erase(frame_id);
 }
 
+bool FrameTracker::GetCachedRemoteFunction(int context_id,
+                                           const std::string& function,
+                                           std::string* object_id) {
+  auto context_it = context_to_function_map_.find(context_id);
+  if (context_it == context_to_function_map_.end())
+    return false;
+  RemoteFunctionCache& cache = context_it->second;
+  auto function_it = cache.index.find(function);
+  if (function_it == cache.index.end())
+    return false;
+  cache.entries.splice(cache.entries.begin(), cache.entries,
+                       function_it->second);
+  *object_id = function_it->second->second;
+  return true;
+}
+
+void FrameTracker::CacheRemoteFunction(
+    int context_id,
+    const std::string& function,
+    const std::string& object_id,
+    std::vector<std::string>* evicted_object_ids) {
+  RemoteFunctionCache& cache = context_to_function_map_[context_id];
+  auto function_it = cache.index.find(function);
+  if (function_it != cache.index.end()) {
+    function_it->second->second = object_id;
+    cache.entries.splice(cache.entries.begin(), cache.entries,
+                         function_it->second);
+    return;
+  }
+  cache.entries.emplace_front(function, object_id);
+  cache.index[function] = cache.entries.begin();
+  while (cache.entries.size() > kMaxRemoteFunctionsPerContext) {
+    evicted_object_ids->push_back(cache.entries.back().second);
+    cache.index.erase(cache.entries.back().first);
+    cache.entries.pop_back();
+  }
+}
+
+void FrameTracker::ClearCachedRemoteFunctions(int context_id) {
+  context_to_function_map_.erase(context_id);
+}
+
+bool FrameTracker::GetCachedElementObjectId(int context_id,
+                                            const std::string& element_id,
+                                            std::string* object_id) const {
+  auto context_it = context_to_element_map_.find(context_id);
+  if (context_it == context_to_element_map_.end())
+    return false;
+  auto element_it = context_it->second.find(element_id);
+  if (element_it == context_it->second.end())
+    return false;
+  *object_id = element_it->second;
+  return true;
+}
+
+void FrameTracker::CacheElementObjectId(int context_id,
+                                        const std::string& element_id,
+                                        const std::string& object_id) {
+  context_to_element_map_[context_id][element_id] = object_id;
+}
+
+void FrameTracker::ClearCachedElementObjectIds(int context_id) {
+  context_to_element_map_.erase(context_id);
+}
+
 Status FrameTracker::OnConnected(DevToolsClient* client) {
   frame_to_context_map_.clear();
+  context_to_function_map_.clear();
+  context_to_element_map_.clear();
   frame_to_target_map_.clear();
   attached_frames_.clear();
   // Enable target events to allow tracking iframe targets creation.
+  // These enables are independent of each other, so they are pipelined:
+  // DevTools processes commands in order, so each is guaranteed to have taken
+  // effect by the time the next synchronous round trip completes, and their
+  // responses carry no data. See NavigationTracker::OnConnected, which runs
+  // after this and collects the acknowledgements with its blocking enable.
   base::DictionaryValue params;
   params.SetBoolean("autoAttach", true);
   params.SetBoolean("flatten", true);
   params.SetBoolean("waitForDebuggerOnStart", false);
-  Status status = client->SendCommand("Target.setAutoAttach", params);
+  Status status = client->SendCommandAndIgnoreResponse("Target.setAutoAttach",
+                                                       params);
   if (status.IsError())
     return status;
   // Enable runtime events to allow tracking execution context creation.
-  params.Clear();
-  status = client->SendCommand("Runtime.enable", params);
+  // EnableDomain sends these without waiting and reference-counts them, so
+  // other features sharing a domain (e.g. ConsoleLogger with Runtime) do not
+  // repeat the enable.
+  status = client->EnableDomain("Runtime");
   if (status.IsError())
     return status;
-  return client->SendCommand("Page.enable", params);
+  return client->EnableDomain("Page");
 }
 
 Status FrameTracker::OnEvent(DevToolsClient* client,
@@ -127,7 +220,9 @@ Status FrameTracker::OnEvent(DevToolsClient* client,
     int execution_context_id;
     if (!params.GetInteger("executionContextId", &execution_context_id))
       return Status(kUnknownError, method + " missing 'executionContextId'");
-    for (auto entry : frame_to_context_map_) {
+    context_to_function_map_.erase(execution_context_id);
+    context_to_element_map_.erase(execution_context_id);
+    for (const auto& entry : frame_to_context_map_) {
       if (entry.second == execution_context_id) {
         frame_to_context_map_.erase(entry.first);
         break;
@@ -135,6 +230,9 @@ Status FrameTracker::OnEvent(DevToolsClient* client,
     }
   } else if (method == "Runtime.executionContextsCleared") {
     frame_to_context_map_.clear();
+    context_to_function_map_.clear();
+    context_to_element_map_.clear();
+    navigation_epoch_++;
   } else if (method == "Page.frameAttached") {
     std::string frame_id;
     if (!params.GetString("frameId", &frame_id))
@@ -147,10 +245,15 @@ Status FrameTracker::OnEvent(DevToolsClient* client,
       return Status(kUnknownError,
                     "missing frameId in Page.frameDetached event");
     attached_frames_.erase(frame_id);
+    navigation_epoch_++;
   } else if (method == "Page.frameNavigated") {
+    navigation_epoch_++;
     const base::Value* unused_value;
-    if (!params.Get("frame.parentId", &unused_value))
+    if (!params.Get("frame.parentId", &unused_value)) {
       frame_to_context_map_.clear();
+      context_to_function_map_.clear();
+      context_to_element_map_.clear();
+    }
   } else if (method == "Target.attachedToTarget") {
     std::string type, target_id, session_id;
     if (!params.GetString("targetInfo.type", &type))
@@ -5,9 +5,13 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_CHROME_FRAME_TRACKER_H_
 #define CHROME_TEST_CHROMEDRIVER_CHROME_FRAME_TRACKER_H_
 
+#include <list>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "base/compiler_specific.h"
 #include "base/macros.h"
@@ -31,10 +35,47 @@ class FrameTracker : public DevToolsEventListener {
   ~FrameTracker() override;
 
   Status GetContextIdForFrame(const std::string& frame_id, int* context_id);
+  // Monotonic counter bumped whenever a frame in this target navigates, is
+  // detached or loses its execution contexts. Callers that memoize
+  // frame-derived state record the epoch alongside it and treat a mismatch
+  // as invalidation; see ExecuteSwitchToFrame.
+  int navigation_epoch() const { return navigation_epoch_; }
+  // Appends every frame currently known to have an execution context in
+  // this target, as (frame id, context id) pairs, in no particular order.
+  void GetAllFrameContexts(
+      std::vector<std::pair<std::string, int>>* contexts) const;
   WebView* GetTargetForFrame(const std::string& frame_id);
   bool IsKnownFrame(const std::string& frame_id) const;
   void DeleteTargetForFrame(const std::string& frame_id);
 
+  // Cache of remote object ids for functions already installed in an
+  // execution context, keyed by context id and function source text. Entries
+  // are dropped when their context is destroyed, so a cached handle is valid
+  // for exactly as long as the context that owns it. Each context keeps a
+  // bounded LRU: user script bodies flow through this cache too, so it must
+  // not grow without bound in long-lived contexts. Displaced object ids are
+  // appended to |evicted_object_ids| for the caller to release.
+  bool GetCachedRemoteFunction(int context_id,
+                               const std::string& function,
+                               std::string* object_id);
+  void CacheRemoteFunction(int context_id,
+                           const std::string& function,
+                           const std::string& object_id,
+                           std::vector<std::string>* evicted_object_ids);
+  void ClearCachedRemoteFunctions(int context_id);
+
+  // Cache of remote object ids for element references, keyed by context id
+  // and element id. Populated on first use of an element reference so later
+  // commands can target the element's remote object directly, and dropped
+  // alongside the function cache when the owning context goes away.
+  bool GetCachedElementObjectId(int context_id,
+                                const std::string& element_id,
+                                std::string* object_id) const;
+  void CacheElementObjectId(int context_id,
+                            const std::string& element_id,
+                            const std::string& object_id);
+  void ClearCachedElementObjectIds(int context_id);
+
   // Overridden from DevToolsEventListener:
   Status OnConnected(DevToolsClient* client) override;
   Status OnEvent(DevToolsClient* client,
@@ -42,9 +83,24 @@ class FrameTracker : public DevToolsEventListener {
                  const base::DictionaryValue& params) override;
 
  private:
-  std::map<std::string, int> frame_to_context_map_;
+  // Consulted on nearly every script and element command, so it is kept as a
+  // hash map for O(1) lookups on pages with many frames.
+  std::unordered_map<std::string, int> frame_to_context_map_;
+  // Installed remote functions for one context, most recently used first,
+  // with an index into the list for O(1) lookup.
+  struct RemoteFunctionCache {
+    std::list<std::pair<std::string, std::string>> entries;
+    std::unordered_map<
+        std::string,
+        std::list<std::pair<std::string, std::string>>::iterator>
+        index;
+  };
+  std::unordered_map<int, RemoteFunctionCache> context_to_function_map_;
+  std::unordered_map<int, std::unordered_map<std::string, std::string>>
+      context_to_element_map_;
   std::map<std::string, std::unique_ptr<WebView>> frame_to_target_map_;
   std::unordered_set<std::string> attached_frames_;
+  int navigation_epoch_;
   WebView* web_view_;
 
   DISALLOW_COPY_AND_ASSIGN(FrameTracker);
@@ -3,8 +3,10 @@
 // found in the LICENSE file.
 
 #include <string>
+#include <vector>
 
 #include "base/json/json_reader.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/frame_tracker.h"
 #include "chrome/test/chromedriver/chrome/status.h"
@@ -65,6 +67,36 @@ TEST(FrameTracker, AuxData) {
   ASSERT_EQ(100, context_id);
 }
 
+TEST(FrameTracker, NavigationEpoch) {
+  StubDevToolsClient client;
+  FrameTracker tracker(&client);
+  ASSERT_EQ(0, tracker.navigation_epoch());
+
+  // Subframe and main-frame navigations both bump the epoch.
+  base::DictionaryValue nav_params;
+  nav_params.SetString("frame.parentId", "1");
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(&client, "Page.frameNavigated", nav_params).code());
+  ASSERT_EQ(1, tracker.navigation_epoch());
+  nav_params.Clear();
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(&client, "Page.frameNavigated", nav_params).code());
+  ASSERT_EQ(2, tracker.navigation_epoch());
+
+  // So do frame removal and context teardown.
+  base::DictionaryValue detach_params;
+  detach_params.SetString("frameId", "f");
+  ASSERT_EQ(
+      kOk,
+      tracker.OnEvent(&client, "Page.frameDetached", detach_params).code());
+  ASSERT_EQ(3, tracker.navigation_epoch());
+  base::DictionaryValue no_params;
+  ASSERT_EQ(kOk, tracker.OnEvent(&client, "Runtime.executionContextsCleared",
+                                 no_params)
+                     .code());
+  ASSERT_EQ(4, tracker.navigation_epoch());
+}
+
 TEST(FrameTracker, CanUpdateFrameContextId) {
   StubDevToolsClient client;
   FrameTracker tracker(&client);
@@ -111,3 +143,38 @@ TEST(FrameTracker, DontTrackContentScriptContexts) {
   ASSERT_TRUE(tracker.GetContextIdForFrame("f", &context_id).IsOk());
   ASSERT_EQ(1, context_id);
 }
+
+TEST(FrameTracker, RemoteFunctionCacheEvictsLeastRecentlyUsed) {
+  // Must match kMaxRemoteFunctionsPerContext in frame_tracker.cc.
+  const size_t kMaxEntries = 512;
+  StubDevToolsClient client;
+  FrameTracker tracker(&client);
+  std::vector<std::string> evicted;
+  for (size_t i = 0; i < kMaxEntries; ++i) {
+    tracker.CacheRemoteFunction(1, "f" + base::NumberToString(i),
+                                "obj" + base::NumberToString(i), &evicted);
+  }
+  ASSERT_TRUE(evicted.empty());
+
+  // Touching the oldest entry makes the second oldest the eviction victim.
+  std::string object_id;
+  ASSERT_TRUE(tracker.GetCachedRemoteFunction(1, "f0", &object_id));
+  tracker.CacheRemoteFunction(1, "extra", "objextra", &evicted);
+  ASSERT_EQ(1u, evicted.size());
+  ASSERT_EQ("obj1", evicted[0]);
+  ASSERT_TRUE(tracker.GetCachedRemoteFunction(1, "f0", &object_id));
+  ASSERT_FALSE(tracker.GetCachedRemoteFunction(1, "f1", &object_id));
+  ASSERT_TRUE(tracker.GetCachedRemoteFunction(1, "extra", &object_id));
+}
+
+TEST(FrameTracker, RemoteFunctionCacheRecachesUnderSameKey) {
+  StubDevToolsClient client;
+  FrameTracker tracker(&client);
+  std::vector<std::string> evicted;
+  tracker.CacheRemoteFunction(1, "f", "obj1", &evicted);
+  tracker.CacheRemoteFunction(1, "f", "obj2", &evicted);
+  ASSERT_TRUE(evicted.empty());
+  std::string object_id;
+  ASSERT_TRUE(tracker.GetCachedRemoteFunction(1, "f", &object_id));
+  ASSERT_EQ("obj2", object_id);
+}
@@ -26,9 +26,17 @@ Status GeolocationOverrideManager::OverrideGeolocation(
 }
 
 Status GeolocationOverrideManager::OnConnected(DevToolsClient* client) {
+  // The (re)connected browser holds no override state, so the next apply
+  // must send regardless of what the previous connection was told.
+  last_applied_params_.reset();
   return ApplyOverrideIfNeeded();
 }
 
+std::vector<std::string> GeolocationOverrideManager::SubscribedMethodPrefixes()
+    const {
+  return {"Page.frameNavigated"};
+}
+
 Status GeolocationOverrideManager::OnEvent(
     DevToolsClient* client,
     const std::string& method,
@@ -49,5 +57,13 @@ Status GeolocationOverrideManager::ApplyOverrideIfNeeded() {
   params.SetDouble("latitude", overridden_geoposition_->latitude);
   params.SetDouble("longitude", overridden_geoposition_->longitude);
   params.SetDouble("accuracy", overridden_geoposition_->accuracy);
-  return client_->SendCommand("Page.setGeolocationOverride", params);
+  // Overrides survive navigation within a connection, so re-applying an
+  // unchanged position would be pure chatter.
+  if (last_applied_params_ && *last_applied_params_ == params)
+    return Status(kOk);
+  Status status =
+      client_->SendCommandDeferred("Page.setGeolocationOverride", params);
+  if (status.IsOk())
+    last_applied_params_ = params.CreateDeepCopy();
+  return status;
 }
@@ -7,6 +7,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/compiler_specific.h"
 #include "base/macros.h"
@@ -34,12 +35,18 @@ class GeolocationOverrideManager : public DevToolsEventListener {
   Status OnEvent(DevToolsClient* client,
                  const std::string& method,
                  const base::DictionaryValue& params) override;
+  std::vector<std::string> SubscribedMethodPrefixes() const override;
 
  private:
   Status ApplyOverrideIfNeeded();
 
   DevToolsClient* client_;
   std::unique_ptr<Geoposition> overridden_geoposition_;
+  // Parameters of the override last sent on the current connection; a
+  // re-application with identical parameters is skipped. Null while the
+  // browser-side state is unknown (before the first apply and after every
+  // reconnect).
+  std::unique_ptr<base::DictionaryValue> last_applied_params_;
 
   DISALLOW_COPY_AND_ASSIGN(GeolocationOverrideManager);
 };
@@ -39,6 +39,10 @@ TEST(GeolocationOverrideManager, OverrideSendsCommand) {
   ASSERT_EQ(2u, client.commands_.size());
   ASSERT_NO_FATAL_FAILURE(
       AssertGeolocationCommand(client.commands_[1], geoposition));
+
+  // Overriding with the identical position is a no-op on the wire.
+  manager.OverrideGeolocation(geoposition);
+  ASSERT_EQ(2u, client.commands_.size());
 }
 
 TEST(GeolocationOverrideManager, SendsCommandOnConnect) {
@@ -56,7 +60,7 @@ TEST(GeolocationOverrideManager, SendsCommandOnConnect) {
       AssertGeolocationCommand(client.commands_[1], geoposition));
 }
 
-TEST(GeolocationOverrideManager, SendsCommandOnNavigation) {
+TEST(GeolocationOverrideManager, SkipsUnchangedReapplyOnNavigation) {
   RecorderDevToolsClient client;
   GeolocationOverrideManager manager(&client);
   base::DictionaryValue main_frame_params;
@@ -68,9 +72,15 @@ TEST(GeolocationOverrideManager, SendsCommandOnNavigation) {
   Geoposition geoposition = {1, 2, 3};
   manager.OverrideGeolocation(geoposition);
   ASSERT_EQ(1u, client.commands_.size());
+  // The override survives navigation within a connection, so re-applying
+  // the unchanged position is skipped.
   ASSERT_EQ(kOk,
             manager.OnEvent(&client, "Page.frameNavigated", main_frame_params)
                 .code());
+  ASSERT_EQ(1u, client.commands_.size());
+
+  geoposition.latitude = 5;
+  manager.OverrideGeolocation(geoposition);
   ASSERT_EQ(2u, client.commands_.size());
   ASSERT_NO_FATAL_FAILURE(
       AssertGeolocationCommand(client.commands_[1], geoposition));
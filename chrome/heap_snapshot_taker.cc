@@ -7,6 +7,7 @@
 #include <stddef.h>
 #include <utility>
 
+#include "base/files/file_util.h"
 #include "base/json/json_reader.h"
 #include "base/stl_util.h"
 #include "base/values.h"
@@ -39,6 +40,30 @@ Status HeapSnapshotTaker::TakeSnapshot(std::unique_ptr<base::Value>* snapshot) {
   }
 }
 
+Status HeapSnapshotTaker::TakeSnapshotToFile(base::FilePath* snapshot_path) {
+  base::FilePath path;
+  if (!base::CreateTemporaryFile(&path))
+    return Status(kUnknownError, "cannot create temporary file for snapshot");
+  snapshot_file_.Initialize(
+      path, base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE);
+  if (!snapshot_file_.IsValid()) {
+    base::DeleteFile(path);
+    return Status(kUnknownError, "cannot open temporary file for snapshot");
+  }
+
+  Status status1 = TakeSnapshotInternal();
+  base::DictionaryValue params;
+  Status status2 = client_->SendCommand("Debugger.disable", params);
+
+  snapshot_file_.Close();
+  if (status1.IsError() || status2.IsError()) {
+    base::DeleteFile(path);
+    return status1.IsError() ? status1 : status2;
+  }
+  *snapshot_path = path;
+  return Status(kOk);
+}
+
 Status HeapSnapshotTaker::TakeSnapshotInternal() {
   base::DictionaryValue params;
   const char* const kMethods[] = {
@@ -55,6 +80,10 @@ Status HeapSnapshotTaker::TakeSnapshotInternal() {
   return Status(kOk);
 }
 
+std::vector<std::string> HeapSnapshotTaker::SubscribedMethodPrefixes() const {
+  return {"HeapProfiler."};
+}
+
 Status HeapSnapshotTaker::OnEvent(DevToolsClient* client,
                                   const std::string& method,
                                   const base::DictionaryValue& params) {
@@ -64,7 +93,15 @@ Status HeapSnapshotTaker::OnEvent(DevToolsClient* client,
       return Status(kUnknownError,
                     "HeapProfiler.addHeapSnapshotChunk has no 'chunk'");
     }
-    snapshot_.append(chunk);
+    if (snapshot_file_.IsValid()) {
+      int size = static_cast<int>(chunk.size());
+      if (snapshot_file_.WriteAtCurrentPos(chunk.data(), size) != size) {
+        return Status(kUnknownError,
+                      "cannot write heap snapshot chunk to file");
+      }
+    } else {
+      snapshot_.append(chunk);
+    }
   }
   return Status(kOk);
 }
@@ -7,8 +7,11 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/compiler_specific.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
 #include "base/macros.h"
 #include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
 
@@ -28,16 +31,26 @@ class HeapSnapshotTaker : public DevToolsEventListener {
 
   Status TakeSnapshot(std::unique_ptr<base::Value>* snapshot);
 
+  // Like TakeSnapshot, but streams the chunks to a temporary file as they
+  // arrive instead of accumulating them in memory, so the snapshot never
+  // resides in this process as one large string. On success, the path of
+  // the file holding the snapshot is returned in |snapshot_path|; the
+  // caller owns the file and is responsible for deleting it.
+  Status TakeSnapshotToFile(base::FilePath* snapshot_path);
+
   // Overridden from DevToolsEventListener:
   Status OnEvent(DevToolsClient* client,
                  const std::string& method,
                  const base::DictionaryValue& params) override;
+  std::vector<std::string> SubscribedMethodPrefixes() const override;
 
  private:
   Status TakeSnapshotInternal();
 
   DevToolsClient* client_;
   std::string snapshot_;
+  // Valid only while a file-backed snapshot is in progress.
+  base::File snapshot_file_;
 
   DISALLOW_COPY_AND_ASSIGN(HeapSnapshotTaker);
 };
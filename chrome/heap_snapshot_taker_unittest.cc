@@ -11,6 +11,8 @@
 #include <string>
 #include <utility>
 
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
 #include "base/stl_util.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/status.h"
@@ -88,6 +90,29 @@ TEST(HeapSnapshotTaker, SuccessfulCase) {
   ASSERT_TRUE(client.IsDisabled());
 }
 
+TEST(HeapSnapshotTaker, SuccessfulFileCase) {
+  DummyDevToolsClient client("", false);
+  HeapSnapshotTaker taker(&client);
+  base::FilePath snapshot_path;
+  Status status = taker.TakeSnapshotToFile(&snapshot_path);
+  ASSERT_EQ(kOk, status.code());
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(snapshot_path, &contents));
+  ASSERT_EQ("{\"a\": 1,\"b\": 2}", contents);
+  ASSERT_TRUE(client.IsDisabled());
+  base::DeleteFile(snapshot_path);
+}
+
+TEST(HeapSnapshotTaker, FileCaseDeletesFileOnError) {
+  DummyDevToolsClient client("HeapProfiler.takeHeapSnapshot", true);
+  HeapSnapshotTaker taker(&client);
+  base::FilePath snapshot_path;
+  Status status = taker.TakeSnapshotToFile(&snapshot_path);
+  ASSERT_TRUE(status.IsError());
+  ASSERT_TRUE(snapshot_path.empty());
+  ASSERT_TRUE(client.IsDisabled());
+}
+
 TEST(HeapSnapshotTaker, FailIfErrorOnDebuggerEnable) {
   DummyDevToolsClient client("Debugger.enable", false);
   HeapSnapshotTaker taker(&client);
@@ -22,6 +22,10 @@ bool JavaScriptDialogManager::IsDialogOpen() const {
   return !unhandled_dialog_queue_.empty();
 }
 
+bool JavaScriptDialogManager::MayHavePendingDialogEvents() const {
+  return client_->MayHavePendingDialogEvents();
+}
+
 Status JavaScriptDialogManager::GetDialogMessage(std::string* message) {
   if (!IsDialogOpen())
     return Status(kNoSuchAlert);
@@ -72,8 +76,15 @@ Status JavaScriptDialogManager::HandleDialog(bool accept,
 Status JavaScriptDialogManager::OnConnected(DevToolsClient* client) {
   unhandled_dialog_queue_.clear();
   dialog_type_queue_.clear();
+  // Pipelined with the other connect-time enables; see
+  // FrameTracker::OnConnected.
   base::DictionaryValue params;
-  return client_->SendCommand("Page.enable", params);
+  return client_->SendCommandAndIgnoreResponse("Page.enable", params);
+}
+
+std::vector<std::string> JavaScriptDialogManager::SubscribedMethodPrefixes()
+    const {
+  return {"Page.javascriptDialog"};
 }
 
 Status JavaScriptDialogManager::OnEvent(DevToolsClient* client,
@@ -7,6 +7,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include "base/compiler_specific.h"
 #include "base/macros.h"
@@ -30,6 +31,11 @@ class JavaScriptDialogManager : public DevToolsEventListener {
 
   bool IsDialogOpen() const;
 
+  // Returns false only if no unprocessed dialog-opening event is waiting
+  // on the wire, so callers that see false here and false from
+  // IsDialogOpen() can skip pumping the event queue entirely.
+  bool MayHavePendingDialogEvents() const;
+
   Status GetDialogMessage(std::string* message);
 
   Status GetTypeOfDialog(std::string* type);
@@ -41,6 +47,7 @@ class JavaScriptDialogManager : public DevToolsEventListener {
   Status OnEvent(DevToolsClient* client,
                  const std::string& method,
                  const base::DictionaryValue& params) override;
+  std::vector<std::string> SubscribedMethodPrefixes() const override;
 
  private:
   DevToolsClient* client_;
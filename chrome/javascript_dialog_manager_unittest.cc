@@ -23,6 +23,7 @@ TEST(JavaScriptDialogManager, NoDialog) {
   ASSERT_FALSE(manager.IsDialogOpen());
   ASSERT_STREQ("HI", message.c_str());
   ASSERT_EQ(kNoSuchAlert, manager.HandleDialog(false, NULL).code());
+  ASSERT_FALSE(manager.MayHavePendingDialogEvents());
 }
 
 TEST(JavaScriptDialogManager, HandleDialogPassesParams) {
@@ -0,0 +1,25 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/json_parser.h"
+
+#include <utility>
+
+#include "base/json/json_reader.h"
+#include "base/optional.h"
+
+std::unique_ptr<base::Value> ParseJsonHotPath(base::StringPiece json,
+                                              int options) {
+#if BUILDFLAG(CHROMEDRIVER_USE_SIMDJSON)
+  std::unique_ptr<base::Value> value = ParseJsonSimd(json);
+  if (value)
+    return value;
+  // The vectorized backend parses strictly; inputs that need the portable
+  // parser's tolerances (e.g. JSON_REPLACE_INVALID_CHARACTERS) land here.
+#endif
+  base::Optional<base::Value> result = base::JSONReader::Read(json, options);
+  if (!result)
+    return nullptr;
+  return base::Value::ToUniquePtrValue(std::move(*result));
+}
@@ -0,0 +1,32 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_CHROME_JSON_PARSER_H_
+#define CHROME_TEST_CHROMEDRIVER_CHROME_JSON_PARSER_H_
+
+#include <memory>
+
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+#include "build/buildflag.h"
+#include "chrome/test/chromedriver/json_parser_buildflags.h"
+
+// Decodes JSON on the driver's message hot paths: DevTools messages coming
+// off the WebSocket and HTTP request bodies. A thin seam over the decoder so
+// an alternative backend can be selected at build time without touching
+// callers; by default it is base::JSONReader. |options| takes
+// base::JSONParserOptions bits. Returns null on a parse error.
+std::unique_ptr<base::Value> ParseJsonHotPath(base::StringPiece json,
+                                              int options);
+
+#if BUILDFLAG(CHROMEDRIVER_USE_SIMDJSON)
+// Implemented by the simdjson backend (json_parser_simdjson.cc), compiled in
+// when the chromedriver_use_simdjson GN arg is set. Returns null on any
+// input it cannot handle exactly (including invalid UTF-8 that the portable
+// parser would repair), in which case the caller falls back to
+// base::JSONReader.
+std::unique_ptr<base::Value> ParseJsonSimd(base::StringPiece json);
+#endif
+
+#endif  // CHROME_TEST_CHROMEDRIVER_CHROME_JSON_PARSER_H_
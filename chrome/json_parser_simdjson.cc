@@ -0,0 +1,101 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// simdjson backend for ParseJsonHotPath, compiled in when the
+// chromedriver_use_simdjson GN arg is set (requires //third_party/simdjson
+// in the checkout). simdjson runs a vectorized structural-index pass over
+// the whole buffer and then materializes values from the index; on the
+// event-heavy DevTools message stream this replaces the byte-at-a-time
+// recursive descent of base::JSONReader.
+
+#include "chrome/test/chromedriver/chrome/json_parser.h"
+
+#include <limits>
+#include <utility>
+
+#include "third_party/simdjson/src/include/simdjson.h"
+
+namespace {
+
+// Builds the base::Value tree for |element|, mirroring base::JSONReader's
+// number conventions: integers that fit in int stay ints, everything else
+// becomes a double. Returns false on depth or type surprises so the caller
+// can fall back to the portable parser.
+bool ConvertElement(const simdjson::dom::element& element, base::Value* out) {
+  switch (element.type()) {
+    case simdjson::dom::element_type::NULL_VALUE:
+      *out = base::Value();
+      return true;
+    case simdjson::dom::element_type::BOOL:
+      *out = base::Value(element.get_bool().value_unsafe());
+      return true;
+    case simdjson::dom::element_type::INT64: {
+      int64_t number = element.get_int64().value_unsafe();
+      if (number >= std::numeric_limits<int>::min() &&
+          number <= std::numeric_limits<int>::max()) {
+        *out = base::Value(static_cast<int>(number));
+      } else {
+        *out = base::Value(static_cast<double>(number));
+      }
+      return true;
+    }
+    case simdjson::dom::element_type::UINT64:
+      *out = base::Value(
+          static_cast<double>(element.get_uint64().value_unsafe()));
+      return true;
+    case simdjson::dom::element_type::DOUBLE:
+      *out = base::Value(element.get_double().value_unsafe());
+      return true;
+    case simdjson::dom::element_type::STRING: {
+      std::string_view piece = element.get_string().value_unsafe();
+      *out = base::Value(base::StringPiece(piece.data(), piece.size()));
+      return true;
+    }
+    case simdjson::dom::element_type::ARRAY: {
+      base::Value list(base::Value::Type::LIST);
+      for (const simdjson::dom::element& item :
+           element.get_array().value_unsafe()) {
+        base::Value converted;
+        if (!ConvertElement(item, &converted))
+          return false;
+        list.Append(std::move(converted));
+      }
+      *out = std::move(list);
+      return true;
+    }
+    case simdjson::dom::element_type::OBJECT: {
+      base::Value dict(base::Value::Type::DICTIONARY);
+      for (const simdjson::dom::key_value_pair& field :
+           element.get_object().value_unsafe()) {
+        base::Value converted;
+        if (!ConvertElement(field.value, &converted))
+          return false;
+        dict.SetKey(base::StringPiece(field.key.data(), field.key.size()),
+                    std::move(converted));
+      }
+      *out = std::move(dict);
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+std::unique_ptr<base::Value> ParseJsonSimd(base::StringPiece json) {
+  // One parser per thread reuses its structural-index and string buffers
+  // across messages, so steady-state parsing allocates only the output tree.
+  static thread_local simdjson::dom::parser parser;
+  simdjson::dom::element root;
+  if (parser.parse(json.data(), json.size()).get(root) !=
+      simdjson::SUCCESS) {
+    // Invalid UTF-8 or malformed input: let the portable parser decide, so
+    // lenient options like JSON_REPLACE_INVALID_CHARACTERS keep working.
+    return nullptr;
+  }
+  base::Value value;
+  if (!ConvertElement(root, &value))
+    return nullptr;
+  return std::make_unique<base::Value>(std::move(value));
+}
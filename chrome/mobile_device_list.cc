@@ -9,172 +9,187 @@
 
 #include "chrome/test/chromedriver/chrome/mobile_device_list.h"
 
-const char kMobileDevices[] =
-    "{\"iPad\": {\"deviceScaleFactor\": 2, \"mobile\": true, \"height\": 1024, "
-    "\"width\": 768, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (iPad; CPU "
-    "OS 11_0 like Mac OS X) AppleWebKit/604.1.34 (KHTML, like Gecko) "
-    "Version/11.0 Mobile/15A5341f Safari/604.1\"}, \"Laptop with touch\": "
-    "{\"deviceScaleFactor\": 1, \"mobile\": false, \"height\": 1280, "
-    "\"width\": 950, \"touch\": true, \"userAgent\": \"\"}, \"BlackBerry "
-    "Z30\": {\"deviceScaleFactor\": 2, \"mobile\": true, \"height\": 640, "
-    "\"width\": 360, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (BB10; "
-    "Touch) AppleWebKit/537.10+ (KHTML, like Gecko) Version/10.0.9.2372 Mobile "
-    "Safari/537.10+\"}, \"Nexus 6\": {\"deviceScaleFactor\": 3.5, \"mobile\": "
-    "true, \"height\": 732, \"width\": 412, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (Linux; Android 7.1.1; Nexus 6 Build/N6F26U) "
-    "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile "
-    "Safari/537.36\"}, \"Nexus 7\": {\"deviceScaleFactor\": 2, \"mobile\": "
-    "true, \"height\": 960, \"width\": 600, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (Linux; Android 6.0.1; Nexus 7 Build/MOB30X) "
-    "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 "
-    "Safari/537.36\"}, \"Nexus 4\": {\"deviceScaleFactor\": 2, \"mobile\": "
-    "true, \"height\": 640, \"width\": 384, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (Linux; Android 4.4.2; Nexus 4 Build/KOT49H) "
-    "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile "
-    "Safari/537.36\"}, \"Nexus 5\": {\"deviceScaleFactor\": 3, \"mobile\": "
-    "true, \"height\": 640, \"width\": 360, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (Linux; Android 6.0; Nexus 5 Build/MRA58N) "
-    "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile "
-    "Safari/537.36\"}, \"Blackberry PlayBook\": {\"deviceScaleFactor\": 1, "
-    "\"mobile\": true, \"height\": 1024, \"width\": 600, \"touch\": true, "
-    "\"userAgent\": \"Mozilla/5.0 (PlayBook; U; RIM Tablet OS 2.1.0; en-US) "
-    "AppleWebKit/536.2+ (KHTML like Gecko) Version/7.2.1.0 Safari/536.2+\"}, "
-    "\"Pixel 2\": {\"deviceScaleFactor\": 2.625, \"mobile\": true, \"height\": "
-    "731, \"width\": 411, \"touch\": true, \"userAgent\": \"Mozilla/5.0 "
-    "(Linux; Android 8.0; Pixel 2 Build/OPD3.170816.012) AppleWebKit/537.36 "
-    "(KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36\"}, \"Nexus "
-    "6P\": {\"deviceScaleFactor\": 3.5, \"mobile\": true, \"height\": 732, "
-    "\"width\": 412, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Linux; "
-    "Android 8.0.0; Nexus 6P Build/OPP3.170518.006) AppleWebKit/537.36 (KHTML, "
-    "like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36\"}, \"iPhone 8 "
-    "Plus\": {\"deviceScaleFactor\": 3, \"mobile\": true, \"height\": 736, "
-    "\"width\": 414, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (iPhone; "
-    "CPU iPhone OS 13_2_3 like Mac OS X) AppleWebKit/605.1.15 (KHTML, like "
-    "Gecko) Version/13.0.3 Mobile/15E148 Safari/604.1\"}, \"iPhone 7 Plus\": "
-    "{\"deviceScaleFactor\": 3, \"mobile\": true, \"height\": 736, \"width\": "
-    "414, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (iPhone; CPU iPhone OS "
-    "13_2_3 like Mac OS X) AppleWebKit/605.1.15 (KHTML, like Gecko) "
-    "Version/13.0.3 Mobile/15E148 Safari/604.1\"}, \"Laptop with HiDPI "
-    "screen\": {\"deviceScaleFactor\": 2, \"mobile\": false, \"height\": 1440, "
-    "\"width\": 900, \"touch\": false, \"userAgent\": \"\"}, \"Moto G4\": "
-    "{\"deviceScaleFactor\": 3, \"mobile\": true, \"height\": 640, \"width\": "
-    "360, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Linux; Android 6.0.1; "
-    "Moto G (4)) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 "
-    "Mobile Safari/537.36\"}, \"Nokia N9\": {\"deviceScaleFactor\": 1, "
-    "\"mobile\": true, \"height\": 854, \"width\": 480, \"touch\": true, "
-    "\"userAgent\": \"Mozilla/5.0 (MeeGo; NokiaN9) AppleWebKit/534.13 (KHTML, "
-    "like Gecko) NokiaBrowser/8.5.0 Mobile Safari/534.13\"}, \"Nokia Lumia "
-    "520\": {\"deviceScaleFactor\": 1.5, \"mobile\": true, \"height\": 533, "
-    "\"width\": 320, \"touch\": true, \"userAgent\": \"Mozilla/5.0 "
-    "(compatible; MSIE 10.0; Windows Phone 8.0; Trident/6.0; IEMobile/10.0; "
-    "ARM; Touch; NOKIA; Lumia 520)\"}, \"Kindle Fire HDX\": "
-    "{\"deviceScaleFactor\": 2, \"mobile\": true, \"height\": 1280, \"width\": "
-    "800, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Linux; U; en-us; "
-    "KFAPWI Build/JDQ39) AppleWebKit/535.19 (KHTML, like Gecko) Silk/3.13 "
-    "Safari/535.19 Silk-Accelerated=true\"}, \"Galaxy S5\": "
-    "{\"deviceScaleFactor\": 3, \"mobile\": true, \"height\": 640, \"width\": "
-    "360, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Linux; Android 5.0; "
-    "SM-G900P Build/LRX21T) AppleWebKit/537.36 (KHTML, like Gecko) "
-    "Chrome/86.0.4239.0 Mobile Safari/537.36\"}, \"iPhone 7\": "
-    "{\"deviceScaleFactor\": 2, \"mobile\": true, \"height\": 667, \"width\": "
-    "375, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (iPhone; CPU iPhone OS "
-    "13_2_3 like Mac OS X) AppleWebKit/605.1.15 (KHTML, like Gecko) "
-    "Version/13.0.3 Mobile/15E148 Safari/604.1\"}, \"LG Optimus L70\": "
-    "{\"deviceScaleFactor\": 1.25, \"mobile\": true, \"height\": 640, "
-    "\"width\": 384, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Linux; U; "
-    "Android 4.4.2; en-us; LGMS323 Build/KOT49I.MS32310c) AppleWebKit/537.36 "
-    "(KHTML, like Gecko) Version/4.0 Chrome/86.0.4239.0 Mobile "
-    "Safari/537.36\"}, \"iPhone 5\": {\"deviceScaleFactor\": 2, \"mobile\": "
-    "true, \"height\": 568, \"width\": 320, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (iPhone; CPU iPhone OS 10_3_1 like Mac OS X) "
-    "AppleWebKit/603.1.30 (KHTML, like Gecko) Version/10.0 Mobile/14E304 "
-    "Safari/602.1\"}, \"iPhone 4\": {\"deviceScaleFactor\": 2, \"mobile\": "
-    "true, \"height\": 480, \"width\": 320, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (iPhone; CPU iPhone OS 7_1_2 like Mac OS X) "
-    "AppleWebKit/537.51.2 (KHTML, like Gecko) Version/7.0 Mobile/11D257 "
-    "Safari/9537.53\"}, \"Nexus 10\": {\"deviceScaleFactor\": 2, \"mobile\": "
-    "true, \"height\": 1280, \"width\": 800, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (Linux; Android 6.0.1; Nexus 10 Build/MOB31T) "
-    "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 "
-    "Safari/537.36\"}, \"iPhone 8\": {\"deviceScaleFactor\": 2, \"mobile\": "
-    "true, \"height\": 667, \"width\": 375, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) "
-    "AppleWebKit/605.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 "
-    "Safari/604.1\"}, \"iPhone 6\": {\"deviceScaleFactor\": 2, \"mobile\": "
-    "true, \"height\": 667, \"width\": 375, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) "
-    "AppleWebKit/605.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 "
-    "Safari/604.1\"}, \"Galaxy S III\": {\"deviceScaleFactor\": 2, \"mobile\": "
-    "true, \"height\": 640, \"width\": 360, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (Linux; U; Android 4.0; en-us; GT-I9300 Build/IMM76D) "
-    "AppleWebKit/534.30 (KHTML, like Gecko) Version/4.0 Mobile "
-    "Safari/534.30\"}, \"iPhone 6/7/8\": {\"deviceScaleFactor\": 2, "
-    "\"mobile\": true, \"height\": 667, \"width\": 375, \"touch\": true, "
-    "\"userAgent\": \"Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) "
-    "AppleWebKit/605.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 "
-    "Safari/604.1\"}, \"iPhone SE\": {\"deviceScaleFactor\": 2, \"mobile\": "
-    "true, \"height\": 568, \"width\": 320, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (iPhone; CPU iPhone OS 10_3_1 like Mac OS X) "
-    "AppleWebKit/603.1.30 (KHTML, like Gecko) Version/10.0 Mobile/14E304 "
-    "Safari/602.1\"}, \"Galaxy Fold\": {\"deviceScaleFactor\": 3, \"mobile\": "
-    "true, \"height\": 653, \"width\": 280, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (Linux; Android 8.0; Pixel 2 Build/OPD3.170816.012) "
-    "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile "
-    "Safari/537.36\"}, \"Microsoft Lumia 550\": {\"deviceScaleFactor\": 2, "
-    "\"mobile\": true, \"height\": 360, \"width\": 640, \"touch\": true, "
-    "\"userAgent\": \"Mozilla/5.0 (Windows Phone 10.0; Android 4.2.1; "
-    "Microsoft; Lumia 550) AppleWebKit/537.36 (KHTML, like Gecko) "
-    "Chrome/46.0.2486.0 Mobile Safari/537.36 Edge/14.14263\"}, \"iPad Mini\": "
-    "{\"deviceScaleFactor\": 2, \"mobile\": true, \"height\": 1024, \"width\": "
-    "768, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (iPad; CPU OS 11_0 "
-    "like Mac OS X) AppleWebKit/604.1.34 (KHTML, like Gecko) Version/11.0 "
-    "Mobile/15A5341f Safari/604.1\"}, \"iPhone 5/SE\": {\"deviceScaleFactor\": "
-    "2, \"mobile\": true, \"height\": 568, \"width\": 320, \"touch\": true, "
-    "\"userAgent\": \"Mozilla/5.0 (iPhone; CPU iPhone OS 10_3_1 like Mac OS X) "
-    "AppleWebKit/603.1.30 (KHTML, like Gecko) Version/10.0 Mobile/14E304 "
-    "Safari/602.1\"}, \"iPad Pro\": {\"deviceScaleFactor\": 2, \"mobile\": "
-    "true, \"height\": 1366, \"width\": 1024, \"touch\": true, \"userAgent\": "
-    "\"Mozilla/5.0 (iPad; CPU OS 11_0 like Mac OS X) AppleWebKit/604.1.34 "
-    "(KHTML, like Gecko) Version/11.0 Mobile/15A5341f Safari/604.1\"}, \"Nexus "
-    "5X\": {\"deviceScaleFactor\": 2.625, \"mobile\": true, \"height\": 732, "
-    "\"width\": 412, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Linux; "
-    "Android 8.0.0; Nexus 5X Build/OPR4.170623.006) AppleWebKit/537.36 (KHTML, "
-    "like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36\"}, \"iPhone 6/7/8 "
-    "Plus\": {\"deviceScaleFactor\": 3, \"mobile\": true, \"height\": 736, "
-    "\"width\": 414, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (iPhone; "
-    "CPU iPhone OS 13_2_3 like Mac OS X) AppleWebKit/605.1.15 (KHTML, like "
-    "Gecko) Version/13.0.3 Mobile/15E148 Safari/604.1\"}, \"Galaxy Note II\": "
-    "{\"deviceScaleFactor\": 2, \"mobile\": true, \"height\": 640, \"width\": "
-    "360, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Linux; U; Android "
-    "4.1; en-us; GT-N7100 Build/JRO03C) AppleWebKit/534.30 (KHTML, like Gecko) "
-    "Version/4.0 Mobile Safari/534.30\"}, \"iPhone 6 Plus\": "
-    "{\"deviceScaleFactor\": 3, \"mobile\": true, \"height\": 736, \"width\": "
-    "414, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (iPhone; CPU iPhone OS "
-    "13_2_3 like Mac OS X) AppleWebKit/605.1.15 (KHTML, like Gecko) "
-    "Version/13.0.3 Mobile/15E148 Safari/604.1\"}, \"iPhone X\": "
-    "{\"deviceScaleFactor\": 3, \"mobile\": true, \"height\": 812, \"width\": "
-    "375, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (iPhone; CPU iPhone OS "
-    "13_2_3 like Mac OS X) AppleWebKit/605.1.15 (KHTML, like Gecko) "
-    "Version/13.0.3 Mobile/15E148 Safari/604.1\"}, \"Microsoft Lumia 950\": "
-    "{\"deviceScaleFactor\": 4, \"mobile\": true, \"height\": 640, \"width\": "
-    "360, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Windows Phone 10.0; "
-    "Android 4.2.1; Microsoft; Lumia 950) AppleWebKit/537.36 (KHTML, like "
-    "Gecko) Chrome/46.0.2486.0 Mobile Safari/537.36 Edge/14.14263\"}, \"Pixel "
-    "2 XL\": {\"deviceScaleFactor\": 3.5, \"mobile\": true, \"height\": 823, "
-    "\"width\": 411, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Linux; "
-    "Android 8.0.0; Pixel 2 XL Build/OPD1.170816.004) AppleWebKit/537.36 "
-    "(KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36\"}, \"Galaxy "
-    "Note 3\": {\"deviceScaleFactor\": 3, \"mobile\": true, \"height\": 640, "
-    "\"width\": 360, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Linux; U; "
-    "Android 4.3; en-us; SM-N900T Build/JSS15J) AppleWebKit/534.30 (KHTML, "
-    "like Gecko) Version/4.0 Mobile Safari/534.30\"}, \"JioPhone 2\": "
-    "{\"deviceScaleFactor\": 1, \"mobile\": true, \"height\": 320, \"width\": "
-    "240, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Mobile; "
-    "LYF/F300B/LYF-F300B-001-01-15-130718-i;Android; rv:48.0) Gecko/48.0 "
-    "Firefox/48.0 KAIOS/2.5\"}, \"Laptop with MDPI screen\": "
-    "{\"deviceScaleFactor\": 1, \"mobile\": false, \"height\": 1280, "
-    "\"width\": 800, \"touch\": false, \"userAgent\": \"\"}, \"Surface Duo\": "
-    "{\"deviceScaleFactor\": 2.5, \"mobile\": true, \"height\": 720, "
-    "\"width\": 540, \"touch\": true, \"userAgent\": \"Mozilla/5.0 (Linux; "
-    "Android 8.0; Pixel 2 Build/OPD3.170816.012) AppleWebKit/537.36 (KHTML, "
-    "like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36\"}}";
+constexpr MobileDeviceEntry kMobileDevices[] = {
+    {"BlackBerry Z30",
+     "Mozilla/5.0 (BB10; Touch) AppleWebKit/537.10+ (KHTML, like Gecko) Versi"
+     "on/10.0.9.2372 Mobile Safari/537.10+",
+     360, 640, 2, true, true},
+    {"Blackberry PlayBook",
+     "Mozilla/5.0 (PlayBook; U; RIM Tablet OS 2.1.0; en-US) AppleWebKit/536.2"
+     "+ (KHTML like Gecko) Version/7.2.1.0 Safari/536.2+",
+     600, 1024, 1, true, true},
+    {"Galaxy Fold",
+     "Mozilla/5.0 (Linux; Android 8.0; Pixel 2 Build/OPD3.170816.012) AppleWe"
+     "bKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36",
+     280, 653, 3, true, true},
+    {"Galaxy Note 3",
+     "Mozilla/5.0 (Linux; U; Android 4.3; en-us; SM-N900T Build/JSS15J) Apple"
+     "WebKit/534.30 (KHTML, like Gecko) Version/4.0 Mobile Safari/534.30",
+     360, 640, 3, true, true},
+    {"Galaxy Note II",
+     "Mozilla/5.0 (Linux; U; Android 4.1; en-us; GT-N7100 Build/JRO03C) Apple"
+     "WebKit/534.30 (KHTML, like Gecko) Version/4.0 Mobile Safari/534.30",
+     360, 640, 2, true, true},
+    {"Galaxy S III",
+     "Mozilla/5.0 (Linux; U; Android 4.0; en-us; GT-I9300 Build/IMM76D) Apple"
+     "WebKit/534.30 (KHTML, like Gecko) Version/4.0 Mobile Safari/534.30",
+     360, 640, 2, true, true},
+    {"Galaxy S5",
+     "Mozilla/5.0 (Linux; Android 5.0; SM-G900P Build/LRX21T) AppleWebKit/537"
+     ".36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36",
+     360, 640, 3, true, true},
+    {"JioPhone 2",
+     "Mozilla/5.0 (Mobile; LYF/F300B/LYF-F300B-001-01-15-130718-i;Android; rv"
+     ":48.0) Gecko/48.0 Firefox/48.0 KAIOS/2.5",
+     240, 320, 1, true, true},
+    {"Kindle Fire HDX",
+     "Mozilla/5.0 (Linux; U; en-us; KFAPWI Build/JDQ39) AppleWebKit/535.19 (K"
+     "HTML, like Gecko) Silk/3.13 Safari/535.19 Silk-Accelerated=true",
+     800, 1280, 2, true, true},
+    {"LG Optimus L70",
+     "Mozilla/5.0 (Linux; U; Android 4.4.2; en-us; LGMS323 Build/KOT49I.MS323"
+     "10c) AppleWebKit/537.36 (KHTML, like Gecko) Version/4.0 Chrome/86.0.423"
+     "9.0 Mobile Safari/537.36",
+     384, 640, 1.25, true, true},
+    {"Laptop with HiDPI screen",
+     "",
+     900, 1440, 2, false, false},
+    {"Laptop with MDPI screen",
+     "",
+     800, 1280, 1, false, false},
+    {"Laptop with touch",
+     "",
+     950, 1280, 1, true, false},
+    {"Microsoft Lumia 550",
+     "Mozilla/5.0 (Windows Phone 10.0; Android 4.2.1; Microsoft; Lumia 550) A"
+     "ppleWebKit/537.36 (KHTML, like Gecko) Chrome/46.0.2486.0 Mobile Safari/"
+     "537.36 Edge/14.14263",
+     640, 360, 2, true, true},
+    {"Microsoft Lumia 950",
+     "Mozilla/5.0 (Windows Phone 10.0; Android 4.2.1; Microsoft; Lumia 950) A"
+     "ppleWebKit/537.36 (KHTML, like Gecko) Chrome/46.0.2486.0 Mobile Safari/"
+     "537.36 Edge/14.14263",
+     360, 640, 4, true, true},
+    {"Moto G4",
+     "Mozilla/5.0 (Linux; Android 6.0.1; Moto G (4)) AppleWebKit/537.36 (KHTM"
+     "L, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36",
+     360, 640, 3, true, true},
+    {"Nexus 10",
+     "Mozilla/5.0 (Linux; Android 6.0.1; Nexus 10 Build/MOB31T) AppleWebKit/5"
+     "37.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Safari/537.36",
+     800, 1280, 2, true, true},
+    {"Nexus 4",
+     "Mozilla/5.0 (Linux; Android 4.4.2; Nexus 4 Build/KOT49H) AppleWebKit/53"
+     "7.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36",
+     384, 640, 2, true, true},
+    {"Nexus 5",
+     "Mozilla/5.0 (Linux; Android 6.0; Nexus 5 Build/MRA58N) AppleWebKit/537."
+     "36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36",
+     360, 640, 3, true, true},
+    {"Nexus 5X",
+     "Mozilla/5.0 (Linux; Android 8.0.0; Nexus 5X Build/OPR4.170623.006) Appl"
+     "eWebKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537"
+     ".36",
+     412, 732, 2.625, true, true},
+    {"Nexus 6",
+     "Mozilla/5.0 (Linux; Android 7.1.1; Nexus 6 Build/N6F26U) AppleWebKit/53"
+     "7.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36",
+     412, 732, 3.5, true, true},
+    {"Nexus 6P",
+     "Mozilla/5.0 (Linux; Android 8.0.0; Nexus 6P Build/OPP3.170518.006) Appl"
+     "eWebKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537"
+     ".36",
+     412, 732, 3.5, true, true},
+    {"Nexus 7",
+     "Mozilla/5.0 (Linux; Android 6.0.1; Nexus 7 Build/MOB30X) AppleWebKit/53"
+     "7.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Safari/537.36",
+     600, 960, 2, true, true},
+    {"Nokia Lumia 520",
+     "Mozilla/5.0 (compatible; MSIE 10.0; Windows Phone 8.0; Trident/6.0; IEM"
+     "obile/10.0; ARM; Touch; NOKIA; Lumia 520)",
+     320, 533, 1.5, true, true},
+    {"Nokia N9",
+     "Mozilla/5.0 (MeeGo; NokiaN9) AppleWebKit/534.13 (KHTML, like Gecko) Nok"
+     "iaBrowser/8.5.0 Mobile Safari/534.13",
+     480, 854, 1, true, true},
+    {"Pixel 2",
+     "Mozilla/5.0 (Linux; Android 8.0; Pixel 2 Build/OPD3.170816.012) AppleWe"
+     "bKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36",
+     411, 731, 2.625, true, true},
+    {"Pixel 2 XL",
+     "Mozilla/5.0 (Linux; Android 8.0.0; Pixel 2 XL Build/OPD1.170816.004) Ap"
+     "pleWebKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/5"
+     "37.36",
+     411, 823, 3.5, true, true},
+    {"Surface Duo",
+     "Mozilla/5.0 (Linux; Android 8.0; Pixel 2 Build/OPD3.170816.012) AppleWe"
+     "bKit/537.36 (KHTML, like Gecko) Chrome/86.0.4239.0 Mobile Safari/537.36",
+     540, 720, 2.5, true, true},
+    {"iPad",
+     "Mozilla/5.0 (iPad; CPU OS 11_0 like Mac OS X) AppleWebKit/604.1.34 (KHT"
+     "ML, like Gecko) Version/11.0 Mobile/15A5341f Safari/604.1",
+     768, 1024, 2, true, true},
+    {"iPad Mini",
+     "Mozilla/5.0 (iPad; CPU OS 11_0 like Mac OS X) AppleWebKit/604.1.34 (KHT"
+     "ML, like Gecko) Version/11.0 Mobile/15A5341f Safari/604.1",
+     768, 1024, 2, true, true},
+    {"iPad Pro",
+     "Mozilla/5.0 (iPad; CPU OS 11_0 like Mac OS X) AppleWebKit/604.1.34 (KHT"
+     "ML, like Gecko) Version/11.0 Mobile/15A5341f Safari/604.1",
+     1024, 1366, 2, true, true},
+    {"iPhone 4",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 7_1_2 like Mac OS X) AppleWebKit/537"
+     ".51.2 (KHTML, like Gecko) Version/7.0 Mobile/11D257 Safari/9537.53",
+     320, 480, 2, true, true},
+    {"iPhone 5",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 10_3_1 like Mac OS X) AppleWebKit/60"
+     "3.1.30 (KHTML, like Gecko) Version/10.0 Mobile/14E304 Safari/602.1",
+     320, 568, 2, true, true},
+    {"iPhone 5/SE",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 10_3_1 like Mac OS X) AppleWebKit/60"
+     "3.1.30 (KHTML, like Gecko) Version/10.0 Mobile/14E304 Safari/602.1",
+     320, 568, 2, true, true},
+    {"iPhone 6",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) AppleWebKit/60"
+     "5.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 Safari/604.1",
+     375, 667, 2, true, true},
+    {"iPhone 6 Plus",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) AppleWebKit/60"
+     "5.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 Safari/604.1",
+     414, 736, 3, true, true},
+    {"iPhone 6/7/8",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) AppleWebKit/60"
+     "5.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 Safari/604.1",
+     375, 667, 2, true, true},
+    {"iPhone 6/7/8 Plus",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) AppleWebKit/60"
+     "5.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 Safari/604.1",
+     414, 736, 3, true, true},
+    {"iPhone 7",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) AppleWebKit/60"
+     "5.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 Safari/604.1",
+     375, 667, 2, true, true},
+    {"iPhone 7 Plus",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) AppleWebKit/60"
+     "5.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 Safari/604.1",
+     414, 736, 3, true, true},
+    {"iPhone 8",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) AppleWebKit/60"
+     "5.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 Safari/604.1",
+     375, 667, 2, true, true},
+    {"iPhone 8 Plus",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) AppleWebKit/60"
+     "5.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 Safari/604.1",
+     414, 736, 3, true, true},
+    {"iPhone SE",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 10_3_1 like Mac OS X) AppleWebKit/60"
+     "3.1.30 (KHTML, like Gecko) Version/10.0 Mobile/14E304 Safari/602.1",
+     320, 568, 2, true, true},
+    {"iPhone X",
+     "Mozilla/5.0 (iPhone; CPU iPhone OS 13_2_3 like Mac OS X) AppleWebKit/60"
+     "5.1.15 (KHTML, like Gecko) Version/13.0.3 Mobile/15E148 Safari/604.1",
+     375, 812, 3, true, true},
+};
+
+const size_t kMobileDeviceCount =
+    sizeof(kMobileDevices) / sizeof(kMobileDevices[0]);
@@ -10,6 +10,21 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_CHROME_MOBILE_DEVICE_LIST_H_
 #define CHROME_TEST_CHROMEDRIVER_CHROME_MOBILE_DEVICE_LIST_H_
 
-extern const char kMobileDevices[];
+#include <stddef.h>
+
+// An emulated device entry from the DevTools front-end device list.
+struct MobileDeviceEntry {
+  const char* name;
+  const char* user_agent;
+  int width;
+  int height;
+  double device_scale_factor;
+  bool touch;
+  bool mobile;
+};
+
+// Sorted by |name| (byte-wise), so entries can be found by binary search.
+extern const MobileDeviceEntry kMobileDevices[];
+extern const size_t kMobileDeviceCount;
 
 #endif  // CHROME_TEST_CHROMEDRIVER_CHROME_MOBILE_DEVICE_LIST_H_
@@ -22,9 +22,17 @@ MobileEmulationOverrideManager::~MobileEmulationOverrideManager() {
 }
 
 Status MobileEmulationOverrideManager::OnConnected(DevToolsClient* client) {
+  // The (re)connected browser holds no override state, so the next apply
+  // must send regardless of what the previous connection was told.
+  last_applied_params_.reset();
   return ApplyOverrideIfNeeded();
 }
 
+std::vector<std::string>
+MobileEmulationOverrideManager::SubscribedMethodPrefixes() const {
+  return {"Page.frameNavigated"};
+}
+
 Status MobileEmulationOverrideManager::OnEvent(
     DevToolsClient* client,
     const std::string& method,
@@ -46,6 +54,9 @@ bool MobileEmulationOverrideManager::HasOverrideMetrics() const {
 }
 
 Status MobileEmulationOverrideManager::RestoreOverrideMetrics() {
+  // Callers clear the metrics override behind this manager's back (see
+  // ExecuteSetWindowRect), so the browser-side state cannot be assumed.
+  last_applied_params_.reset();
   return ApplyOverrideIfNeeded();
 }
 
@@ -68,19 +79,25 @@ Status MobileEmulationOverrideManager::ApplyOverrideIfNeeded() {
                     overridden_device_metrics_->text_autosizing);
   params.SetDouble("fontScaleFactor",
                    overridden_device_metrics_->font_scale_factor);
-  Status status = client_->SendCommand("Page.setDeviceMetricsOverride", params);
+  // The metrics never change within a session, so after the first apply on
+  // a connection every navigation-triggered re-apply is skipped.
+  if (last_applied_params_ && *last_applied_params_ == params)
+    return Status(kOk);
+  Status status =
+      client_->SendCommandDeferred("Page.setDeviceMetricsOverride", params);
   if (status.IsError())
     return status;
 
   if (overridden_device_metrics_->touch) {
     base::DictionaryValue emulate_touch_params;
     emulate_touch_params.SetBoolean("enabled", true);
-    status = client_->SendCommand("Emulation.setTouchEmulationEnabled",
-                                  emulate_touch_params);
+    status = client_->SendCommandDeferred("Emulation.setTouchEmulationEnabled",
+                                          emulate_touch_params);
     if (status.IsError())
       return status;
 
   }
 
+  last_applied_params_ = params.CreateDeepCopy();
   return Status(kOk);
 }
@@ -7,6 +7,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/compiler_specific.h"
 #include "base/macros.h"
@@ -33,6 +34,7 @@ class MobileEmulationOverrideManager : public DevToolsEventListener {
   Status OnEvent(DevToolsClient* client,
                  const std::string& method,
                  const base::DictionaryValue& params) override;
+  std::vector<std::string> SubscribedMethodPrefixes() const override;
 
   bool IsEmulatingTouch() const;
   bool HasOverrideMetrics() const;
@@ -44,6 +46,12 @@ class MobileEmulationOverrideManager : public DevToolsEventListener {
 
   DevToolsClient* client_;
   const DeviceMetrics* overridden_device_metrics_;
+  // Metrics parameters last sent on the current connection; the touch
+  // emulation command derives from the same fixed metrics, so both are
+  // skipped together when nothing changed. Null while the browser-side
+  // state is unknown (before the first apply, after a reconnect, and after
+  // another command clears the metrics override).
+  std::unique_ptr<base::DictionaryValue> last_applied_params_;
 
   DISALLOW_COPY_AND_ASSIGN(MobileEmulationOverrideManager);
 };
@@ -64,7 +64,7 @@ TEST(MobileEmulationOverrideManager, SendsCommandWithoutTouchOnConnect) {
       AssertDeviceMetricsCommand(client.commands_[1], device_metrics));
 }
 
-TEST(MobileEmulationOverrideManager, SendsCommandOnNavigation) {
+TEST(MobileEmulationOverrideManager, SkipsUnchangedReapplyOnNavigation) {
   RecorderDevToolsClient client;
   DeviceMetrics device_metrics(1, 2, 3.0, true, true);
   MobileEmulationOverrideManager manager(&client, &device_metrics);
@@ -73,17 +73,24 @@ TEST(MobileEmulationOverrideManager, SendsCommandOnNavigation) {
             manager.OnEvent(&client, "Page.frameNavigated", main_frame_params)
                 .code());
   ASSERT_EQ(2u, client.commands_.size());
+  // The metrics are fixed for the session, so navigation-triggered
+  // re-applies are skipped once the override has been sent.
   ASSERT_EQ(kOk,
             manager.OnEvent(&client, "Page.frameNavigated", main_frame_params)
                 .code());
-  ASSERT_EQ(4u, client.commands_.size());
-  ASSERT_NO_FATAL_FAILURE(
-      AssertDeviceMetricsCommand(client.commands_[2], device_metrics));
+  ASSERT_EQ(2u, client.commands_.size());
 
   base::DictionaryValue sub_frame_params;
   sub_frame_params.SetString("frame.parentId", "id");
   ASSERT_EQ(
       kOk,
       manager.OnEvent(&client, "Page.frameNavigated", sub_frame_params).code());
+  ASSERT_EQ(2u, client.commands_.size());
+
+  // RestoreOverrideMetrics is used after another command has cleared the
+  // metrics override, so it must send even though nothing changed here.
+  ASSERT_EQ(kOk, manager.RestoreOverrideMetrics().code());
   ASSERT_EQ(4u, client.commands_.size());
+  ASSERT_NO_FATAL_FAILURE(
+      AssertDeviceMetricsCommand(client.commands_[2], device_metrics));
 }
@@ -149,6 +149,9 @@ Status NavigationTracker::IsPendingNavigation(const Timeout* timeout,
     *is_pending = false;
     return Status(kOk);
   } else if (loadingState() == kUnknown) {
+    // Rare doubt-resolution path: lifecycle events normally move a frame out
+    // of kUnknown before any command checks it, so this probe only runs for
+    // frames seen before the first lifecycle event arrived.
     // In the case that a http request is sent to server to fetch the page
     // content and the server hasn't responded at all, a dummy page is created
     // for the new window. In such case, the baseURL will be 'about:blank'.
@@ -211,7 +214,20 @@ bool NavigationTracker::IsNonBlocking() const {
 Status NavigationTracker::OnConnected(DevToolsClient* client) {
   clearFrameStates();
   initCurrentFrame(kUnknown);
+  // Lifecycle events (init/load/networkIdle) feed the cached per-frame
+  // loading state, so pending-navigation checks rarely need to probe the
+  // renderer; see IsPendingNavigation.
+  base::DictionaryValue lifecycle_params;
+  lifecycle_params.SetBoolean("enabled", true);
+  Status status = client_->SendCommandDeferred("Page.setLifecycleEventsEnabled",
+                                               lifecycle_params);
+  if (status.IsError())
+    return status;
   // Enable page domain notifications to allow tracking navigation state.
+  // This listener is registered after the other trackers, and DevTools
+  // responds to commands in order, so this blocking round trip also collects
+  // the acknowledgements for the pipelined enables the earlier listeners
+  // sent (see FrameTracker::OnConnected).
   base::DictionaryValue empty_params;
   return client_->SendCommand("Page.enable", empty_params);
 }
@@ -224,6 +240,22 @@ Status NavigationTracker::OnEvent(DevToolsClient* client,
        (is_eager_ && method == "Page.domContentEventFired"))) {
     frame_to_state_map_[top_frame_id_] = kNotLoading;
     return UpdateCurrentLoadingState();
+  } else if (method == "Page.lifecycleEvent") {
+    // Lifecycle events carry a frame id and fire in a fixed order (init,
+    // ..., DOMContentLoaded, load, networkAlmostIdle, networkIdle), so they
+    // keep the per-frame state current without any renderer round trip.
+    std::string frame_id;
+    std::string name;
+    if (!params.GetString("frameId", &frame_id))
+      return Status(kUnknownError, "missing or invalid 'frameId'");
+    if (!params.GetString("name", &name))
+      return Status(kUnknownError, "missing or invalid 'name'");
+    if (name == "init") {
+      frame_to_state_map_[frame_id] = kLoading;
+    } else if (name == "load" || name == "networkIdle" ||
+               (is_eager_ && name == "DOMContentLoaded")) {
+      frame_to_state_map_[frame_id] = kNotLoading;
+    }
   } else if (method == "Page.frameAttached") {
     std::string frame_id;
     if (!params.GetString("frameId", &frame_id))
@@ -253,6 +285,24 @@ Status NavigationTracker::OnEvent(DevToolsClient* client,
     if (!params.GetString("frameId", &frame_id))
       return Status(kUnknownError, "missing or invalid 'frameId'");
     frame_to_state_map_[frame_id] = kNotLoading;
+  } else if (method == "Page.frameNavigated") {
+    // The tracked top-frame URL serves GetCurrentUrl from memory; see
+    // GetTrackedTopFrameUrl. Subframe navigations (frames with a parent)
+    // do not affect it.
+    if (!params.FindPath("frame.parentId")) {
+      std::string url;
+      if (params.GetString("frame.url", &url))
+        top_frame_url_ = url;
+    }
+  } else if (method == "Page.navigatedWithinDocument") {
+    // Same-document navigations (pushState, fragment changes) update the
+    // URL without a load; this is the SPA route-change case.
+    std::string frame_id;
+    std::string url;
+    if (params.GetString("frameId", &frame_id) &&
+        params.GetString("url", &url) && frame_id == top_frame_id_) {
+      top_frame_url_ = url;
+    }
   } else if (method == "Inspector.targetCrashed") {
     clearFrameStates();
     initCurrentFrame(kNotLoading);
@@ -260,6 +310,16 @@ Status NavigationTracker::OnEvent(DevToolsClient* client,
   return Status(kOk);
 }
 
+bool NavigationTracker::GetTrackedTopFrameUrl(std::string* url) {
+  if (top_frame_url_.empty())
+    return false;
+  auto it = frame_to_state_map_.find(top_frame_id_);
+  if (it == frame_to_state_map_.end() || it->second != kNotLoading)
+    return false;  // Mid-load or unknown; the URL may be about to change.
+  *url = top_frame_url_;
+  return true;
+}
+
 Status NavigationTracker::UpdateCurrentLoadingState() {
   if (current_frame_id_.empty()) {
     // Under cases such as frame detached but current frame has not been
@@ -318,6 +378,7 @@ void NavigationTracker::initCurrentFrame(LoadingState state) {
 
 void NavigationTracker::clearFrameStates() {
   frame_to_state_map_.clear();
+  top_frame_url_.clear();
   setCurrentFrameInvalid();
 }
 
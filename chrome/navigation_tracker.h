@@ -52,6 +52,10 @@ class NavigationTracker : public DevToolsEventListener,
   // top frame
   void SetFrame(const std::string& new_frame_id) override;
   bool IsNonBlocking() const override;
+  // Serves the top frame's URL from Page.frameNavigated and
+  // Page.navigatedWithinDocument events: true only once a navigation has
+  // been observed on this connection and no top-frame load is in progress.
+  bool GetTrackedTopFrameUrl(std::string* url) override;
 
   Status CheckFunctionExists(const Timeout* timeout, bool* exists);
 
@@ -84,6 +88,9 @@ class NavigationTracker : public DevToolsEventListener,
   const bool is_eager_;
   bool timed_out_;
   std::unordered_map<std::string, LoadingState> frame_to_state_map_;
+  // Top-frame URL from the last Page.frameNavigated or
+  // Page.navigatedWithinDocument on this connection; empty when unknown.
+  std::string top_frame_url_;
   LoadingState* loading_state_;
   // Used when current frame is invalid
   LoadingState dummy_state_;
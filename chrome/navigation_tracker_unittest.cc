@@ -143,6 +143,125 @@ TEST(NavigationTracker, FrameLoadStartStop) {
   ASSERT_NO_FATAL_FAILURE(AssertPendingState(&tracker, false));
 }
 
+TEST(NavigationTracker, TracksTopFrameUrl) {
+  base::DictionaryValue dict;
+  BrowserInfo browser_info;
+  std::unique_ptr<DevToolsClient> client_uptr =
+      std::make_unique<DeterminingLoadStateDevToolsClient>(
+          false, true, std::string(), &dict);
+  DevToolsClient* client_ptr = client_uptr.get();
+  JavaScriptDialogManager dialog_manager(client_ptr, &browser_info);
+  WebViewImpl web_view(client_ptr->GetId(), true, nullptr, &browser_info,
+                       std::move(client_uptr), nullptr,
+                       PageLoadStrategy::kNormal);
+  NavigationTracker tracker(client_ptr, &web_view, &browser_info,
+                            &dialog_manager);
+  std::string url;
+  // Nothing observed yet.
+  ASSERT_FALSE(tracker.GetTrackedTopFrameUrl(&url));
+
+  base::DictionaryValue params;
+  params.SetString("frame.id", client_ptr->GetId());
+  params.SetString("frame.url", "http://test/a");
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(client_ptr, "Page.frameNavigated", params).code());
+  // The URL is known, but the load state is not yet kNotLoading.
+  ASSERT_FALSE(tracker.GetTrackedTopFrameUrl(&url));
+
+  base::DictionaryValue stop_params;
+  stop_params.SetString("frameId", client_ptr->GetId());
+  ASSERT_EQ(kOk, tracker.OnEvent(client_ptr, "Page.frameStoppedLoading",
+                                 stop_params).code());
+  ASSERT_TRUE(tracker.GetTrackedTopFrameUrl(&url));
+  ASSERT_EQ("http://test/a", url);
+
+  // Same-document navigation of the top frame updates the URL in place.
+  base::DictionaryValue within_params;
+  within_params.SetString("frameId", client_ptr->GetId());
+  within_params.SetString("url", "http://test/a#route");
+  ASSERT_EQ(kOk, tracker.OnEvent(client_ptr, "Page.navigatedWithinDocument",
+                                 within_params).code());
+  ASSERT_TRUE(tracker.GetTrackedTopFrameUrl(&url));
+  ASSERT_EQ("http://test/a#route", url);
+
+  // A subframe navigation leaves the top-frame URL alone.
+  base::DictionaryValue sub_params;
+  sub_params.SetString("frame.id", "subframe");
+  sub_params.SetString("frame.parentId", client_ptr->GetId());
+  sub_params.SetString("frame.url", "http://test/iframe");
+  ASSERT_EQ(
+      kOk,
+      tracker.OnEvent(client_ptr, "Page.frameNavigated", sub_params).code());
+  ASSERT_TRUE(tracker.GetTrackedTopFrameUrl(&url));
+  ASSERT_EQ("http://test/a#route", url);
+
+  // A new top-frame load puts the URL back in doubt until it finishes.
+  base::DictionaryValue start_params;
+  start_params.SetString("frameId", client_ptr->GetId());
+  ASSERT_EQ(kOk, tracker.OnEvent(client_ptr, "Page.frameStartedLoading",
+                                 start_params).code());
+  ASSERT_FALSE(tracker.GetTrackedTopFrameUrl(&url));
+}
+
+TEST(NavigationTracker, LifecycleEventsDriveLoadingState) {
+  base::DictionaryValue dict;
+  BrowserInfo browser_info;
+  std::unique_ptr<DevToolsClient> client_uptr =
+      std::make_unique<DeterminingLoadStateDevToolsClient>(
+          false, true, std::string(), &dict);
+  DevToolsClient* client_ptr = client_uptr.get();
+  JavaScriptDialogManager dialog_manager(client_ptr, &browser_info);
+  WebViewImpl web_view(client_ptr->GetId(), true, nullptr, &browser_info,
+                       std::move(client_uptr), nullptr,
+                       PageLoadStrategy::kNormal);
+  NavigationTracker tracker(client_ptr, &web_view, &browser_info,
+                            &dialog_manager);
+
+  base::DictionaryValue params;
+  params.SetString("frameId", client_ptr->GetId());
+
+  params.SetString("name", "init");
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(client_ptr, "Page.lifecycleEvent", params).code());
+  ASSERT_NO_FATAL_FAILURE(AssertPendingState(&tracker, true));
+  // DOMContentLoaded ends the wait only for the eager strategy.
+  params.SetString("name", "DOMContentLoaded");
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(client_ptr, "Page.lifecycleEvent", params).code());
+  ASSERT_NO_FATAL_FAILURE(AssertPendingState(&tracker, true));
+  params.SetString("name", "load");
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(client_ptr, "Page.lifecycleEvent", params).code());
+  ASSERT_NO_FATAL_FAILURE(AssertPendingState(&tracker, false));
+}
+
+TEST(NavigationTracker, LifecycleEventsEagerStrategy) {
+  base::DictionaryValue dict;
+  BrowserInfo browser_info;
+  std::unique_ptr<DevToolsClient> client_uptr =
+      std::make_unique<DeterminingLoadStateDevToolsClient>(
+          false, true, std::string(), &dict);
+  DevToolsClient* client_ptr = client_uptr.get();
+  JavaScriptDialogManager dialog_manager(client_ptr, &browser_info);
+  WebViewImpl web_view(client_ptr->GetId(), true, nullptr, &browser_info,
+                       std::move(client_uptr), nullptr,
+                       PageLoadStrategy::kEager);
+  NavigationTracker tracker(client_ptr, &web_view, &browser_info,
+                            &dialog_manager, true /* is_eager */);
+
+  base::DictionaryValue params;
+  params.SetString("frameId", client_ptr->GetId());
+
+  params.SetString("name", "init");
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(client_ptr, "Page.lifecycleEvent", params).code());
+  ASSERT_NO_FATAL_FAILURE(AssertPendingState(&tracker, true));
+  params.SetString("name", "DOMContentLoaded");
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(client_ptr, "Page.lifecycleEvent", params).code());
+  ASSERT_NO_FATAL_FAILURE(AssertPendingState(&tracker, false));
+}
+
 // When a frame fails to load due to (for example) a DNS resolution error, we
 // can sometimes see two Page.frameStartedLoading events with only a single
 // Page.loadEventFired event.
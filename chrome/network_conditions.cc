@@ -4,10 +4,9 @@
 
 #include "chrome/test/chromedriver/chrome/network_conditions.h"
 
-#include "base/json/json_reader.h"
-#include "base/strings/string_number_conversions.h"
-#include "base/strings/string_split.h"
-#include "base/values.h"
+#include <algorithm>
+#include <cstring>
+
 #include "chrome/test/chromedriver/chrome/network_list.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 
@@ -23,59 +22,26 @@ NetworkConditions::~NetworkConditions() {}
 
 Status FindPresetNetwork(std::string network_name,
                          NetworkConditions* network_conditions) {
-  base::JSONReader::ValueWithError parsed_json =
-      base::JSONReader::ReadAndReturnValueWithError(
-          kNetworks, base::JSON_ALLOW_TRAILING_COMMAS);
-  if (!parsed_json.value)
-    return Status(kUnknownError, "could not parse network list because " +
-                                     parsed_json.error_message);
-
-  base::ListValue* networks;
-  if (!parsed_json.value->GetAsList(&networks))
-    return Status(kUnknownError, "malformed networks list");
-
-  for (auto it = networks->begin(); it != networks->end(); ++it) {
-    base::DictionaryValue* network = NULL;
-    if (!it->GetAsDictionary(&network)) {
-      return Status(kUnknownError,
-                    "malformed network in list: should be a dictionary");
-    }
-
-    if (network == NULL)
-      continue;
-
-    std::string title;
-    if (!network->GetString("title", &title)) {
-      return Status(kUnknownError,
-                    "malformed network title: should be a string");
-    }
-    if (title != network_name)
-      continue;
-
-    if (!network->GetDouble("latency",  &network_conditions->latency)) {
-      return Status(kUnknownError,
-                    "malformed network latency: should be a double");
-    }
-    // Preset list maintains a single "throughput" attribute for each network,
-    // so we use that value for both |download_throughput| and
-    // |upload_throughput| in the NetworkConditions (as does Chrome).
-    if (!network->GetDouble("throughput",
-                            &network_conditions->download_throughput) ||
-        !network->GetDouble("throughput",
-                            &network_conditions->upload_throughput)) {
-      return Status(kUnknownError,
-                    "malformed network throughput: should be a double");
-    }
-
-    // The throughputs of the network presets are listed in kbps, but must be
-    // supplied to the OverrideNetworkConditions command as bps.
-    network_conditions->download_throughput *= 1024;
-    network_conditions->upload_throughput *= 1024;
-
-    // |offline| is always false for now.
-    network_conditions->offline = false;
-    return Status(kOk);
-  }
-
-  return Status(kUnknownError, "must be a valid network");
+  // |kNetworks| is generated sorted by title, so the preset can be found with
+  // a binary search; nothing is parsed or heap-allocated per lookup.
+  const NetworkListEntry* end = kNetworks + kNetworkCount;
+  const NetworkListEntry* entry = std::lower_bound(
+      kNetworks, end, network_name,
+      [](const NetworkListEntry& entry, const std::string& name) {
+        return std::strcmp(entry.title, name.c_str()) < 0;
+      });
+  if (entry == end || network_name != entry->title)
+    return Status(kUnknownError, "must be a valid network");
+
+  network_conditions->latency = entry->latency;
+  // The preset list maintains a single "throughput" attribute for each
+  // network, so that value is used for both |download_throughput| and
+  // |upload_throughput| (as does Chrome). The throughputs are listed in kbps,
+  // but must be supplied to the OverrideNetworkConditions command as bps.
+  network_conditions->download_throughput = entry->throughput * 1024;
+  network_conditions->upload_throughput = entry->throughput * 1024;
+
+  // |offline| is always false for now.
+  network_conditions->offline = false;
+  return Status(kOk);
 }
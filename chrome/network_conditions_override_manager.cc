@@ -6,12 +6,28 @@
 
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/devtools_client.h"
+#include "chrome/test/chromedriver/chrome/devtools_client_impl.h"
 #include "chrome/test/chromedriver/chrome/network_conditions.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 
+namespace {
+
+void BuildEmulateParams(const NetworkConditions& network_conditions,
+                        base::DictionaryValue* params) {
+  params->SetBoolean("offline", network_conditions.offline);
+  params->SetDouble("latency", network_conditions.latency);
+  params->SetDouble("downloadThroughput",
+                    network_conditions.download_throughput);
+  params->SetDouble("uploadThroughput", network_conditions.upload_throughput);
+}
+
+}  // namespace
+
 NetworkConditionsOverrideManager::NetworkConditionsOverrideManager(
     DevToolsClient* client)
-    : client_(client), overridden_network_conditions_(nullptr) {
+    : client_(client),
+      overridden_network_conditions_(nullptr),
+      network_enabled_(false) {
   client_->AddListener(this);
 }
 
@@ -26,10 +42,108 @@ Status NetworkConditionsOverrideManager::OverrideNetworkConditions(
   return status;
 }
 
+Status NetworkConditionsOverrideManager::OverrideNetworkConditionsAsync(
+    const NetworkConditions& network_conditions) {
+  pending_can_emulate_.reset();
+  pending_emulate_.reset();
+
+  base::DictionaryValue params, empty_params;
+  BuildEmulateParams(network_conditions, &params);
+  if (network_enabled_ && last_applied_params_ &&
+      *last_applied_params_ == params) {
+    overridden_network_conditions_ = &network_conditions;
+    return Status(kOk);
+  }
+
+  // Enabling the domain is reference-counted in the client, so it stays
+  // synchronous; it only costs a round trip on this view's first apply.
+  if (!network_enabled_) {
+    Status status = client_->EnableDomain("Network");
+    if (status.IsError())
+      return status;
+    network_enabled_ = true;
+  }
+
+  // The probe and the emulation command are pipelined; DevTools answers in
+  // order, so CollectOverrideAck can still report a failed probe first.
+  Status status = client_->SendCommandAndGetFuture(
+      "Network.canEmulateNetworkConditions", empty_params,
+      &pending_can_emulate_);
+  if (status.IsError())
+    return status;
+  status = client_->SendCommandAndGetFuture("Network.emulateNetworkConditions",
+                                            params, &pending_emulate_);
+  if (status.IsError())
+    return status;
+  // Recorded optimistically; CollectOverrideAck clears it on failure so the
+  // next apply resends.
+  overridden_network_conditions_ = &network_conditions;
+  last_applied_params_ = params.CreateDeepCopy();
+  return Status(kOk);
+}
+
+Status NetworkConditionsOverrideManager::CollectOverrideAck() {
+  std::unique_ptr<DevToolsCommandFuture> can_emulate =
+      std::move(pending_can_emulate_);
+  std::unique_ptr<DevToolsCommandFuture> emulate = std::move(pending_emulate_);
+  Status status(kOk);
+  if (can_emulate) {
+    std::unique_ptr<base::DictionaryValue> result;
+    bool can = false;
+    status = can_emulate->Get(nullptr, &result);
+    if (status.IsError() || !result->GetBoolean("result", &can)) {
+      status = Status(kUnknownError,
+          "unable to detect if chrome can emulate network conditions", status);
+    } else if (!can) {
+      status = Status(kUnknownError, "Cannot emulate network conditions");
+    }
+  }
+  if (emulate) {
+    std::unique_ptr<base::DictionaryValue> result;
+    Status emulate_status = emulate->Get(nullptr, &result);
+    if (status.IsOk())
+      status = emulate_status;
+  }
+  if (status.IsError())
+    last_applied_params_.reset();
+  return status;
+}
+
+Status NetworkConditionsOverrideManager::RemoveOverride() {
+  if (!overridden_network_conditions_)
+    return Status(kOk);
+  overridden_network_conditions_ = nullptr;
+  last_applied_params_.reset();
+  if (!network_enabled_)
+    return Status(kOk);
+  // Restore the default conditions before releasing the domain; disabling
+  // Network does not by itself undo an active emulation.
+  base::DictionaryValue params;
+  params.SetBoolean("offline", false);
+  params.SetDouble("latency", 0);
+  params.SetDouble("downloadThroughput", -1);
+  params.SetDouble("uploadThroughput", -1);
+  Status status = client_->SendCommand("Network.emulateNetworkConditions",
+                                       params);
+  if (status.IsError())
+    return status;
+  network_enabled_ = false;
+  return client_->DisableDomain("Network");
+}
+
 Status NetworkConditionsOverrideManager::OnConnected(DevToolsClient* client) {
+  // The browser side comes back with all domains disabled and no override
+  // state, so the next apply must send regardless.
+  network_enabled_ = false;
+  last_applied_params_.reset();
   return ApplyOverrideIfNeeded();
 }
 
+std::vector<std::string>
+NetworkConditionsOverrideManager::SubscribedMethodPrefixes() const {
+  return {"Page.frameNavigated"};
+}
+
 Status NetworkConditionsOverrideManager::OnEvent(
     DevToolsClient* client,
     const std::string& method,
@@ -51,15 +165,25 @@ Status NetworkConditionsOverrideManager::ApplyOverrideIfNeeded() {
 Status NetworkConditionsOverrideManager::ApplyOverride(
     const NetworkConditions* network_conditions) {
   base::DictionaryValue params, empty_params;
-  params.SetBoolean("offline", network_conditions->offline);
-  params.SetDouble("latency", network_conditions->latency);
-  params.SetDouble("downloadThroughput",
-                    network_conditions->download_throughput);
-  params.SetDouble("uploadThroughput", network_conditions->upload_throughput);
+  BuildEmulateParams(*network_conditions, &params);
 
-  Status status = client_->SendCommand("Network.enable", empty_params);
-  if (status.IsError())
-    return status;
+  // Conditions survive navigation within a connection, so an unchanged
+  // re-apply would only generate chatter (including the can-emulate probe).
+  if (network_enabled_ && last_applied_params_ &&
+      *last_applied_params_ == params) {
+    return Status(kOk);
+  }
+
+  // The override is re-applied on every top-level navigation, so only take
+  // the domain reference once; re-enabling on each navigation would inflate
+  // the reference count.
+  Status status(kOk);
+  if (!network_enabled_) {
+    status = client_->EnableDomain("Network");
+    if (status.IsError())
+      return status;
+    network_enabled_ = true;
+  }
 
   std::unique_ptr<base::DictionaryValue> result;
   bool can = false;
@@ -71,5 +195,9 @@ Status NetworkConditionsOverrideManager::ApplyOverride(
   if (!can)
     return Status(kUnknownError, "Cannot emulate network conditions");
 
-  return client_->SendCommand("Network.emulateNetworkConditions", params);
+  status = client_->SendCommandDeferred("Network.emulateNetworkConditions",
+                                        params);
+  if (status.IsOk())
+    last_applied_params_ = params.CreateDeepCopy();
+  return status;
 }
@@ -7,6 +7,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/compiler_specific.h"
 #include "base/macros.h"
@@ -17,6 +18,7 @@ class DictionaryValue;
 }
 
 class DevToolsClient;
+class DevToolsCommandFuture;
 struct NetworkConditions;
 class Status;
 
@@ -29,11 +31,28 @@ class NetworkConditionsOverrideManager : public DevToolsEventListener {
 
   Status OverrideNetworkConditions(const NetworkConditions& network_conditions);
 
+  // Phase one of a batched override: issues the emulation commands for
+  // |network_conditions| without waiting for their responses, so a caller
+  // fanning the same conditions out over many views can issue them all and
+  // pay one round trip for the batch. Must be followed by
+  // CollectOverrideAck before the next apply on this manager.
+  Status OverrideNetworkConditionsAsync(
+      const NetworkConditions& network_conditions);
+
+  // Phase two: claims the responses issued by OverrideNetworkConditionsAsync
+  // and reports their combined status. A no-op when nothing is pending.
+  Status CollectOverrideAck();
+
+  // Stops overriding the network conditions, restoring the defaults and
+  // releasing this manager's reference on the Network domain.
+  Status RemoveOverride();
+
   // Overridden from DevToolsEventListener:
   Status OnConnected(DevToolsClient* client) override;
   Status OnEvent(DevToolsClient* client,
                  const std::string& method,
                  const base::DictionaryValue& params) override;
+  std::vector<std::string> SubscribedMethodPrefixes() const override;
 
  private:
   Status ApplyOverrideIfNeeded();
@@ -41,6 +60,18 @@ class NetworkConditionsOverrideManager : public DevToolsEventListener {
 
   DevToolsClient* client_;
   const NetworkConditions* overridden_network_conditions_;
+  // Whether this manager currently holds a reference on the Network domain.
+  // Reset on (re)connect, since the browser starts over with it disabled.
+  bool network_enabled_;
+  // Conditions last sent on the current connection; a re-application with
+  // identical conditions skips both the emulation command and the
+  // can-emulate probe. Null while the browser-side state is unknown.
+  std::unique_ptr<base::DictionaryValue> last_applied_params_;
+  // Responses outstanding from OverrideNetworkConditionsAsync, claimed by
+  // CollectOverrideAck. Either may be null when the command was executed
+  // synchronously or the apply was deduplicated.
+  std::unique_ptr<DevToolsCommandFuture> pending_can_emulate_;
+  std::unique_ptr<DevToolsCommandFuture> pending_emulate_;
 
   DISALLOW_COPY_AND_ASSIGN(NetworkConditionsOverrideManager);
 };
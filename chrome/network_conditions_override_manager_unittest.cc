@@ -40,11 +40,42 @@ TEST(NetworkConditionsOverrideManager, OverrideSendsCommand) {
   ASSERT_NO_FATAL_FAILURE(
      AssertNetworkConditionsCommand(client.commands_[2], network_conditions));
 
+  // The domain is already enabled, so the second override skips the enable.
   network_conditions.latency = 200;
   manager.OverrideNetworkConditions(network_conditions);
-  ASSERT_EQ(6u, client.commands_.size());
+  ASSERT_EQ(5u, client.commands_.size());
   ASSERT_NO_FATAL_FAILURE(
-      AssertNetworkConditionsCommand(client.commands_[5], network_conditions));
+      AssertNetworkConditionsCommand(client.commands_[4], network_conditions));
+  // Overriding with identical conditions is a no-op on the wire.
+  manager.OverrideNetworkConditions(network_conditions);
+  ASSERT_EQ(5u, client.commands_.size());
+}
+
+TEST(NetworkConditionsOverrideManager, BatchedOverrideSendsCommand) {
+  RecorderDevToolsClient client;
+  NetworkConditionsOverrideManager manager(&client);
+  NetworkConditions network_conditions = {false, 100, 750*1024, 750*1024};
+  ASSERT_EQ(kOk,
+            manager.OverrideNetworkConditionsAsync(network_conditions).code());
+  ASSERT_EQ(3u, client.commands_.size());
+  ASSERT_NO_FATAL_FAILURE(
+      AssertNetworkConditionsCommand(client.commands_[2], network_conditions));
+  ASSERT_EQ(kOk, manager.CollectOverrideAck().code());
+
+  // A batched re-apply with identical conditions is a no-op on the wire,
+  // like the synchronous path.
+  ASSERT_EQ(kOk,
+            manager.OverrideNetworkConditionsAsync(network_conditions).code());
+  ASSERT_EQ(3u, client.commands_.size());
+  ASSERT_EQ(kOk, manager.CollectOverrideAck().code());
+
+  // The override was recorded, so a navigation re-applies it if needed.
+  network_conditions.latency = 200;
+  manager.OverrideNetworkConditionsAsync(network_conditions);
+  manager.CollectOverrideAck();
+  ASSERT_EQ(5u, client.commands_.size());
+  ASSERT_NO_FATAL_FAILURE(
+      AssertNetworkConditionsCommand(client.commands_[4], network_conditions));
 }
 
 TEST(NetworkConditionsOverrideManager, SendsCommandOnConnect) {
@@ -56,13 +87,15 @@ TEST(NetworkConditionsOverrideManager, SendsCommandOnConnect) {
   NetworkConditions network_conditions = {false, 100, 750*1024, 750*1024};
   manager.OverrideNetworkConditions(network_conditions);
   ASSERT_EQ(3u, client.commands_.size());
+  // A reconnect starts over with all domains disabled, so the enable is sent
+  // again.
   ASSERT_EQ(kOk, manager.OnConnected(&client).code());
   ASSERT_EQ(6u, client.commands_.size());
   ASSERT_NO_FATAL_FAILURE(
       AssertNetworkConditionsCommand(client.commands_[5], network_conditions));
 }
 
-TEST(NetworkConditionsOverrideManager, SendsCommandOnNavigation) {
+TEST(NetworkConditionsOverrideManager, SkipsUnchangedReapplyOnNavigation) {
   RecorderDevToolsClient client;
   NetworkConditionsOverrideManager manager(&client);
   base::DictionaryValue main_frame_params;
@@ -74,19 +107,50 @@ TEST(NetworkConditionsOverrideManager, SendsCommandOnNavigation) {
   NetworkConditions network_conditions = {false, 100, 750*1024, 750*1024};
   manager.OverrideNetworkConditions(network_conditions);
   ASSERT_EQ(3u, client.commands_.size());
+  // Conditions survive navigation within a connection, so the unchanged
+  // re-apply (including its can-emulate probe) is skipped.
   ASSERT_EQ(kOk,
             manager.OnEvent(&client, "Page.frameNavigated", main_frame_params)
                 .code());
-  ASSERT_EQ(6u, client.commands_.size());
+  ASSERT_EQ(3u, client.commands_.size());
+
+  network_conditions.latency = 200;
+  manager.OverrideNetworkConditions(network_conditions);
+  ASSERT_EQ(5u, client.commands_.size());
   ASSERT_NO_FATAL_FAILURE(
-      AssertNetworkConditionsCommand(client.commands_[2], network_conditions));
+      AssertNetworkConditionsCommand(client.commands_[4], network_conditions));
 
   base::DictionaryValue sub_frame_params;
   sub_frame_params.SetString("frame.parentId", "id");
   ASSERT_EQ(
       kOk,
       manager.OnEvent(&client, "Page.frameNavigated", sub_frame_params).code());
-  ASSERT_EQ(6u, client.commands_.size());
+  ASSERT_EQ(5u, client.commands_.size());
+}
+
+TEST(NetworkConditionsOverrideManager, RemoveOverrideRestoresDefaults) {
+  RecorderDevToolsClient client;
+  NetworkConditionsOverrideManager manager(&client);
+
+  // Without an active override there is nothing to undo.
+  ASSERT_EQ(kOk, manager.RemoveOverride().code());
+  ASSERT_EQ(0u, client.commands_.size());
+
+  NetworkConditions network_conditions = {false, 100, 750*1024, 750*1024};
+  manager.OverrideNetworkConditions(network_conditions);
+  ASSERT_EQ(3u, client.commands_.size());
+
+  ASSERT_EQ(kOk, manager.RemoveOverride().code());
+  ASSERT_EQ(5u, client.commands_.size());
+  NetworkConditions default_conditions = {false, 0, -1, -1};
   ASSERT_NO_FATAL_FAILURE(
-      AssertNetworkConditionsCommand(client.commands_[5], network_conditions));
+      AssertNetworkConditionsCommand(client.commands_[3], default_conditions));
+  ASSERT_EQ("Network.disable", client.commands_[4].method);
+
+  // The override is gone, so a navigation no longer re-applies it.
+  base::DictionaryValue main_frame_params;
+  ASSERT_EQ(kOk,
+            manager.OnEvent(&client, "Page.frameNavigated", main_frame_params)
+                .code());
+  ASSERT_EQ(5u, client.commands_.size());
 }
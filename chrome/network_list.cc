@@ -9,17 +9,17 @@
 
 #include "chrome/test/chromedriver/chrome/network_list.h"
 
-const char kNetworks[] =
-    "[{\"id\": \"offline\", \"title\": \"Offline\", \"throughput\": 0, "
-    "\"latency\": 0},{\"id\": \"gprs\", \"title\": \"GPRS\", \"throughput\": "
-    "50, \"latency\": 500},{\"id\": \"edge\", \"title\": \"Regular 2G\", "
-    "\"throughput\": 250, \"latency\": 300},{\"id\": \"2g+\", \"title\": "
-    "\"Good 2G\", \"throughput\": 450, \"latency\": 150},{\"id\": \"3g\", "
-    "\"title\": \"Regular 3G\", \"throughput\": 750, \"latency\": "
-    "100},{\"id\": \"3g+\", \"title\": \"Good 3G\", \"throughput\": 1536.0, "
-    "\"latency\": 40},{\"id\": \"4g\", \"title\": \"Regular 4G\", "
-    "\"throughput\": 4096.0, \"latency\": 20},{\"id\": \"dsl\", \"title\": "
-    "\"DSL\", \"throughput\": 2048.0, \"latency\": 5},{\"id\": \"wifi\", "
-    "\"title\": \"WiFi\", \"throughput\": 30720.0, \"latency\": 2},{\"id\": "
-    "\"online\", \"title\": \"No throttling\", \"throughput\": -1, "
-    "\"latency\": 0}]";
+constexpr NetworkListEntry kNetworks[] = {
+    {"dsl", "DSL", 2048, 5},
+    {"gprs", "GPRS", 50, 500},
+    {"2g+", "Good 2G", 450, 150},
+    {"3g+", "Good 3G", 1536, 40},
+    {"online", "No throttling", -1, 0},
+    {"offline", "Offline", 0, 0},
+    {"edge", "Regular 2G", 250, 300},
+    {"3g", "Regular 3G", 750, 100},
+    {"4g", "Regular 4G", 4096, 20},
+    {"wifi", "WiFi", 30720, 2},
+};
+
+const size_t kNetworkCount = sizeof(kNetworks) / sizeof(kNetworks[0]);
@@ -10,6 +10,18 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_CHROME_NETWORK_LIST_H_
 #define CHROME_TEST_CHROMEDRIVER_CHROME_NETWORK_LIST_H_
 
-extern const char kNetworks[];
+#include <stddef.h>
+
+// A network throttling preset from the DevTools front-end preset list.
+struct NetworkListEntry {
+  const char* id;
+  const char* title;
+  double throughput;  // In kbps; -1 means unlimited.
+  double latency;     // In milliseconds.
+};
+
+// Sorted by |title| (byte-wise), so entries can be found by binary search.
+extern const NetworkListEntry kNetworks[];
+extern const size_t kNetworkCount;
 
 #endif  // CHROME_TEST_CHROMEDRIVER_CHROME_NETWORK_LIST_H_
@@ -10,6 +10,10 @@
 #include "chrome/test/chromedriver/chrome/navigation_tracker.h"
 #include "chrome/test/chromedriver/chrome/non_blocking_navigation_tracker.h"
 
+bool PageLoadStrategy::GetTrackedTopFrameUrl(std::string* url) {
+  return false;
+}
+
 const char PageLoadStrategy::kNormal[] = "normal";
 const char PageLoadStrategy::kNone[] = "none";
 const char PageLoadStrategy::kEager[] = "eager";
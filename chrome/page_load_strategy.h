@@ -5,6 +5,8 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_CHROME_PAGE_LOAD_STRATEGY_H_
 #define CHROME_TEST_CHROMEDRIVER_CHROME_PAGE_LOAD_STRATEGY_H_
 
+#include <string>
+
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/web_view.h"
 
@@ -40,6 +42,11 @@ class PageLoadStrategy {
 
   virtual bool IsNonBlocking() const = 0;
 
+  // Returns true and sets |url| when the strategy tracks the top frame's
+  // current URL and knows it to be current. Strategies that do not observe
+  // navigation events decline, and callers fall back to asking the page.
+  virtual bool GetTrackedTopFrameUrl(std::string* url);
+
   // Types of page load strategies.
   static const char kNormal[];
   static const char kNone[];
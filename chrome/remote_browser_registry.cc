@@ -0,0 +1,51 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/remote_browser_registry.h"
+
+#include "chrome/test/chromedriver/chrome/devtools_endpoint.h"
+
+namespace {
+
+base::LazyInstance<RemoteBrowserRegistry>::Leaky g_remote_browser_registry =
+    LAZY_INSTANCE_INITIALIZER;
+
+// Endpoints are keyed by their version URL, which embeds the scheme, host,
+// port and any path prefix, so distinct debugger addresses never collide.
+std::string KeyForEndpoint(const DevToolsEndpoint& endpoint) {
+  return endpoint.GetVersionUrl();
+}
+
+}  // namespace
+
+// static
+RemoteBrowserRegistry* RemoteBrowserRegistry::GetInstance() {
+  return g_remote_browser_registry.Pointer();
+}
+
+RemoteBrowserRegistry::RemoteBrowserRegistry() {}
+
+RemoteBrowserRegistry::~RemoteBrowserRegistry() {}
+
+bool RemoteBrowserRegistry::FindBrowserInfo(const DevToolsEndpoint& endpoint,
+                                            BrowserInfo* browser_info) {
+  base::AutoLock lock(lock_);
+  auto it = known_browsers_.find(KeyForEndpoint(endpoint));
+  if (it == known_browsers_.end())
+    return false;
+  *browser_info = it->second;
+  return true;
+}
+
+void RemoteBrowserRegistry::RegisterBrowserInfo(
+    const DevToolsEndpoint& endpoint,
+    const BrowserInfo& browser_info) {
+  base::AutoLock lock(lock_);
+  known_browsers_[KeyForEndpoint(endpoint)] = browser_info;
+}
+
+void RemoteBrowserRegistry::Invalidate(const DevToolsEndpoint& endpoint) {
+  base::AutoLock lock(lock_);
+  known_browsers_.erase(KeyForEndpoint(endpoint));
+}
@@ -0,0 +1,60 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_CHROME_REMOTE_BROWSER_REGISTRY_H_
+#define CHROME_TEST_CHROMEDRIVER_CHROME_REMOTE_BROWSER_REGISTRY_H_
+
+#include <map>
+#include <string>
+
+#include "base/lazy_instance.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "chrome/test/chromedriver/chrome/browser_info.h"
+
+class DevToolsEndpoint;
+
+// Process-wide registry of remote browsers some session has already
+// completed the version handshake with, keyed by debugger endpoint. When
+// many sessions attach to the same long-lived browser (debuggerAddress),
+// the first one pays for the /json/version fetch and the compatibility
+// check; later sessions adopt the recorded BrowserInfo and go straight to
+// discovering and attaching their targets. An entry is dropped when a
+// session later fails to reach its endpoint, so a browser that has gone
+// away (or restarted) is re-verified by whoever connects next.
+//
+// Only the handshake result is shared. The synchronous WebSockets used for
+// the browser-level connection are pumped by the session thread that owns
+// them, so each session still opens its own socket, and target isolation
+// comes from each session attaching its own child clients.
+class RemoteBrowserRegistry {
+ public:
+  static RemoteBrowserRegistry* GetInstance();
+
+  RemoteBrowserRegistry();
+  ~RemoteBrowserRegistry();
+
+  // Returns true and fills |browser_info| if some session has already
+  // verified the browser behind |endpoint|.
+  bool FindBrowserInfo(const DevToolsEndpoint& endpoint,
+                       BrowserInfo* browser_info);
+
+  // Records the result of a successful handshake with |endpoint|.
+  void RegisterBrowserInfo(const DevToolsEndpoint& endpoint,
+                           const BrowserInfo& browser_info);
+
+  // Forgets |endpoint|. Called when a request to it fails, since the cached
+  // info may describe a browser that no longer exists.
+  void Invalidate(const DevToolsEndpoint& endpoint);
+
+ private:
+  friend struct base::LazyInstanceTraitsBase<RemoteBrowserRegistry>;
+
+  base::Lock lock_;
+  std::map<std::string, BrowserInfo> known_browsers_;
+
+  DISALLOW_COPY_AND_ASSIGN(RemoteBrowserRegistry);
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_CHROME_REMOTE_BROWSER_REGISTRY_H_
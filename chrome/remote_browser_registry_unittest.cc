@@ -0,0 +1,50 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/remote_browser_registry.h"
+
+#include "chrome/test/chromedriver/chrome/devtools_endpoint.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+TEST(RemoteBrowserRegistry, FindMissesUnknownEndpoint) {
+  RemoteBrowserRegistry registry;
+  BrowserInfo browser_info;
+  ASSERT_FALSE(registry.FindBrowserInfo(DevToolsEndpoint(9222), &browser_info));
+}
+
+TEST(RemoteBrowserRegistry, RegisterThenFind) {
+  RemoteBrowserRegistry registry;
+  BrowserInfo browser_info;
+  browser_info.browser_version = "91.0.4472.0";
+  browser_info.major_version = 91;
+  registry.RegisterBrowserInfo(DevToolsEndpoint(9222), browser_info);
+
+  BrowserInfo found_info;
+  ASSERT_TRUE(registry.FindBrowserInfo(DevToolsEndpoint(9222), &found_info));
+  ASSERT_EQ("91.0.4472.0", found_info.browser_version);
+  ASSERT_EQ(91, found_info.major_version);
+}
+
+TEST(RemoteBrowserRegistry, EndpointsAreIndependent) {
+  RemoteBrowserRegistry registry;
+  BrowserInfo browser_info;
+  registry.RegisterBrowserInfo(DevToolsEndpoint(9222), browser_info);
+
+  BrowserInfo found_info;
+  ASSERT_FALSE(registry.FindBrowserInfo(DevToolsEndpoint(9223), &found_info));
+  ASSERT_TRUE(registry.FindBrowserInfo(DevToolsEndpoint(9222), &found_info));
+}
+
+TEST(RemoteBrowserRegistry, InvalidateForgetsEndpoint) {
+  RemoteBrowserRegistry registry;
+  BrowserInfo browser_info;
+  registry.RegisterBrowserInfo(DevToolsEndpoint(9222), browser_info);
+  registry.Invalidate(DevToolsEndpoint(9222));
+
+  BrowserInfo found_info;
+  ASSERT_FALSE(registry.FindBrowserInfo(DevToolsEndpoint(9222), &found_info));
+
+  // Invalidating an endpoint that was never registered is a no-op.
+  registry.Invalidate(DevToolsEndpoint(9223));
+}
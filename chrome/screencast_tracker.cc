@@ -0,0 +1,87 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/screencast_tracker.h"
+
+#include "base/optional.h"
+#include "base/values.h"
+#include "chrome/test/chromedriver/chrome/devtools_client.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+
+ScreencastTracker::ScreencastTracker(DevToolsClient* client)
+    : client_(client), active_(false), has_frame_(false), frame_timestamp_(0) {
+  client->ConnectIfNecessary();
+  client->AddListener(this);
+}
+
+ScreencastTracker::~ScreencastTracker() = default;
+
+Status ScreencastTracker::Start(const base::DictionaryValue& params) {
+  start_params_.Clear();
+  start_params_.MergeDictionary(&params);
+  if (!start_params_.FindStringKey("format"))
+    start_params_.SetString("format", "png");
+  Status status = client_->SendCommand("Page.startScreencast", start_params_);
+  if (status.IsError())
+    return status;
+  active_ = true;
+  has_frame_ = false;
+  return Status(kOk);
+}
+
+Status ScreencastTracker::Stop() {
+  if (!active_)
+    return Status(kOk);
+  active_ = false;
+  has_frame_ = false;
+  frame_data_.clear();
+  return client_->SendCommand("Page.stopScreencast", base::DictionaryValue());
+}
+
+Status ScreencastTracker::GetLatestFrame(std::string* data,
+                                         double* timestamp) const {
+  if (!has_frame_)
+    return Status(kUnknownError, "no screencast frame received yet");
+  *data = frame_data_;
+  *timestamp = frame_timestamp_;
+  return Status(kOk);
+}
+
+Status ScreencastTracker::OnConnected(DevToolsClient* client) {
+  if (!active_)
+    return Status(kOk);
+  // The connection was re-established (e.g. after a cross-process
+  // navigation), which discards the browser-side screencast state, so the
+  // screencast must be restarted.
+  has_frame_ = false;
+  return client->SendCommandAndIgnoreResponse("Page.startScreencast",
+                                              start_params_);
+}
+
+std::vector<std::string> ScreencastTracker::SubscribedMethodPrefixes() const {
+  return {"Page.screencastFrame"};
+}
+
+Status ScreencastTracker::OnEvent(DevToolsClient* client,
+                                  const std::string& method,
+                                  const base::DictionaryValue& params) {
+  if (method == "Page.screencastFrame") {
+    const std::string* data = params.FindStringKey("data");
+    if (!data)
+      return Status(kUnknownError, "Page.screencastFrame missing 'data'");
+    frame_data_ = *data;
+    frame_timestamp_ = params.FindDoublePath("metadata.timestamp").value_or(0);
+    has_frame_ = true;
+    // Each frame must be acknowledged or DevTools stops sending new ones.
+    // The ack response carries no data, so there is no need to wait for it.
+    base::Optional<int> session_id = params.FindIntKey("sessionId");
+    if (session_id.has_value()) {
+      base::DictionaryValue ack_params;
+      ack_params.SetInteger("sessionId", session_id.value());
+      return client->SendCommandAndIgnoreResponse("Page.screencastFrameAck",
+                                                  ack_params);
+    }
+  }
+  return Status(kOk);
+}
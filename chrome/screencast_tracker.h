@@ -0,0 +1,59 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_CHROME_SCREENCAST_TRACKER_H_
+#define CHROME_TEST_CHROMEDRIVER_CHROME_SCREENCAST_TRACKER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/values.h"
+#include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
+
+class DevToolsClient;
+class Status;
+
+// Keeps the most recent Page.screencastFrame event buffered so that
+// high-frequency screenshot polling can be served without a DevTools round
+// trip per request.
+class ScreencastTracker : public DevToolsEventListener {
+ public:
+  explicit ScreencastTracker(DevToolsClient* client);
+  ~ScreencastTracker() override;
+
+  // Starts the screencast with the given Page.startScreencast parameters.
+  // The image format defaults to PNG so buffered frames carry the same kind
+  // of data that Page.captureScreenshot returns.
+  Status Start(const base::DictionaryValue& params);
+
+  // Stops the screencast and drops the buffered frame.
+  Status Stop();
+
+  bool is_active() const { return active_; }
+
+  // Returns the most recently received frame as base64-encoded image data,
+  // along with its capture time in seconds since the epoch. Returns an error
+  // if no frame has arrived since the screencast started.
+  Status GetLatestFrame(std::string* data, double* timestamp) const;
+
+  // Overridden from DevToolsEventListener:
+  Status OnConnected(DevToolsClient* client) override;
+  Status OnEvent(DevToolsClient* client,
+                 const std::string& method,
+                 const base::DictionaryValue& params) override;
+  std::vector<std::string> SubscribedMethodPrefixes() const override;
+
+ private:
+  DevToolsClient* client_;
+  base::DictionaryValue start_params_;
+  bool active_;
+  bool has_frame_;
+  std::string frame_data_;
+  double frame_timestamp_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScreencastTracker);
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_CHROME_SCREENCAST_TRACKER_H_
@@ -0,0 +1,122 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/chrome/screencast_tracker.h"
+
+#include "base/values.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/chrome/stub_devtools_client.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using testing::_;
+using testing::Return;
+
+namespace {
+
+class MockDevToolsClient : public StubDevToolsClient {
+ public:
+  MOCK_METHOD2(SendCommand,
+               Status(const std::string& method,
+                      const base::DictionaryValue& params));
+  MOCK_METHOD2(SendCommandAndIgnoreResponse,
+               Status(const std::string& method,
+                      const base::DictionaryValue& params));
+  MOCK_METHOD1(AddListener, void(DevToolsEventListener* listener));
+};
+
+base::DictionaryValue CreateFrameParams(const std::string& data,
+                                        double timestamp,
+                                        int session_id) {
+  base::DictionaryValue params;
+  params.SetString("data", data);
+  params.SetDoublePath("metadata.timestamp", timestamp);
+  params.SetInteger("sessionId", session_id);
+  return params;
+}
+
+}  // namespace
+
+class ScreencastTrackerTest : public testing::Test {
+ public:
+  void SetUp() override {
+    testing::Test::SetUp();
+    EXPECT_CALL(devtools_client_, AddListener(_));
+    tracker_ = std::make_unique<ScreencastTracker>(&devtools_client_);
+  }
+
+ protected:
+  std::unique_ptr<ScreencastTracker> tracker_;
+  MockDevToolsClient devtools_client_;
+};
+
+TEST_F(ScreencastTrackerTest, StartDefaultsToPngFormat) {
+  std::string format;
+  EXPECT_CALL(devtools_client_, SendCommand("Page.startScreencast", _))
+      .WillOnce([&format](const std::string& method,
+                          const base::DictionaryValue& params) {
+        params.GetString("format", &format);
+        return Status(kOk);
+      });
+  ASSERT_EQ(kOk, tracker_->Start(base::DictionaryValue()).code());
+  EXPECT_EQ("png", format);
+  EXPECT_TRUE(tracker_->is_active());
+}
+
+TEST_F(ScreencastTrackerTest, BuffersLatestFrameAndAcks) {
+  EXPECT_CALL(devtools_client_, SendCommand("Page.startScreencast", _))
+      .WillOnce(Return(Status(kOk)));
+  ASSERT_EQ(kOk, tracker_->Start(base::DictionaryValue()).code());
+
+  std::string data;
+  double timestamp = 0;
+  EXPECT_TRUE(tracker_->GetLatestFrame(&data, &timestamp).IsError());
+
+  EXPECT_CALL(devtools_client_,
+              SendCommandAndIgnoreResponse("Page.screencastFrameAck", _))
+      .Times(2)
+      .WillRepeatedly(Return(Status(kOk)));
+  tracker_->OnEvent(&devtools_client_, "Page.screencastFrame",
+                    CreateFrameParams("frame1", 1.5, 1));
+  tracker_->OnEvent(&devtools_client_, "Page.screencastFrame",
+                    CreateFrameParams("frame2", 2.5, 2));
+
+  ASSERT_EQ(kOk, tracker_->GetLatestFrame(&data, &timestamp).code());
+  EXPECT_EQ("frame2", data);
+  EXPECT_EQ(2.5, timestamp);
+}
+
+TEST_F(ScreencastTrackerTest, StopDropsBufferedFrame) {
+  EXPECT_CALL(devtools_client_, SendCommand("Page.startScreencast", _))
+      .WillOnce(Return(Status(kOk)));
+  ASSERT_EQ(kOk, tracker_->Start(base::DictionaryValue()).code());
+  EXPECT_CALL(devtools_client_,
+              SendCommandAndIgnoreResponse("Page.screencastFrameAck", _))
+      .WillOnce(Return(Status(kOk)));
+  tracker_->OnEvent(&devtools_client_, "Page.screencastFrame",
+                    CreateFrameParams("frame", 1.0, 1));
+
+  EXPECT_CALL(devtools_client_, SendCommand("Page.stopScreencast", _))
+      .WillOnce(Return(Status(kOk)));
+  ASSERT_EQ(kOk, tracker_->Stop().code());
+  EXPECT_FALSE(tracker_->is_active());
+
+  std::string data;
+  double timestamp = 0;
+  EXPECT_TRUE(tracker_->GetLatestFrame(&data, &timestamp).IsError());
+}
+
+TEST_F(ScreencastTrackerTest, RestartsScreencastOnReconnect) {
+  // Before Start, a reconnect must not start a screencast.
+  ASSERT_EQ(kOk, tracker_->OnConnected(&devtools_client_).code());
+
+  EXPECT_CALL(devtools_client_, SendCommand("Page.startScreencast", _))
+      .WillOnce(Return(Status(kOk)));
+  ASSERT_EQ(kOk, tracker_->Start(base::DictionaryValue()).code());
+
+  EXPECT_CALL(devtools_client_,
+              SendCommandAndIgnoreResponse("Page.startScreencast", _))
+      .WillOnce(Return(Status(kOk)));
+  ASSERT_EQ(kOk, tracker_->OnConnected(&devtools_client_).code());
+}
@@ -4,8 +4,11 @@
 
 #include "chrome/test/chromedriver/chrome/status.h"
 
+#include <string.h>
+
+#include <utility>
+
 #include "base/debug/stack_trace.h"
-#include "base/strings/stringprintf.h"
 
 // Returns the string equivalent of the given |ErrorCode|.
 const char* StatusCodeToString(StatusCode code) {
@@ -74,35 +77,60 @@ const char* StatusCodeToString(StatusCode code) {
       return "target frame detached";
     case kElementClickIntercepted:
       return "element click intercepted";
+    case kSessionOverloaded:
+      return "session overloaded";
     default:
       return "<unknown>";
   }
 }
 
-Status::Status(StatusCode code) : code_(code), msg_(StatusCodeToString(code)) {
+Status::Status(StatusCode code)
+    : code_(code), static_msg_(StatusCodeToString(code)) {
   if (code != kOk)
     stack_trace_ = base::debug::StackTrace().ToString();
 }
 
 Status::Status(StatusCode code, const std::string& details)
-    : code_(code),
-      msg_(StatusCodeToString(code) + std::string(": ") + details) {
+    : code_(code), static_msg_(nullptr) {
+  const char* code_str = StatusCodeToString(code);
+  msg_.reserve(strlen(code_str) + 2 + details.size());
+  msg_ = code_str;
+  msg_ += ": ";
+  msg_ += details;
+  if (code != kOk)
+    stack_trace_ = base::debug::StackTrace().ToString();
+}
+
+Status::Status(StatusCode code, std::string&& details)
+    : code_(code), static_msg_(nullptr), msg_(std::move(details)) {
+  const char* code_str = StatusCodeToString(code);
+  msg_.insert(0, ": ").insert(0, code_str);
   if (code != kOk)
-        stack_trace_ = base::debug::StackTrace().ToString();
+    stack_trace_ = base::debug::StackTrace().ToString();
 }
 
 Status::Status(StatusCode code, const Status& cause)
-    : code_(code),
-      msg_(StatusCodeToString(code) + std::string("\nfrom ") +
-           cause.message()) {
+    : code_(code), static_msg_(nullptr) {
+  const char* code_str = StatusCodeToString(code);
+  const std::string& cause_msg = cause.message();
+  msg_.reserve(strlen(code_str) + 6 + cause_msg.size());
+  msg_ = code_str;
+  msg_ += "\nfrom ";
+  msg_ += cause_msg;
   if (code != kOk)
     stack_trace_ = cause.stack_trace();
 }
 
 Status::Status(StatusCode code, const std::string& details, const Status& cause)
-    : code_(code),
-      msg_(StatusCodeToString(code) + std::string(": ") + details + "\nfrom " +
-           cause.message()) {
+    : code_(code), static_msg_(nullptr) {
+  const char* code_str = StatusCodeToString(code);
+  const std::string& cause_msg = cause.message();
+  msg_.reserve(strlen(code_str) + 2 + details.size() + 6 + cause_msg.size());
+  msg_ = code_str;
+  msg_ += ": ";
+  msg_ += details;
+  msg_ += "\nfrom ";
+  msg_ += cause_msg;
   if (code != kOk)
     stack_trace_ = cause.stack_trace();
 }
@@ -110,7 +138,14 @@ Status::Status(StatusCode code, const std::string& details, const Status& cause)
 Status::~Status() {}
 
 void Status::AddDetails(const std::string& details) {
-  msg_ += base::StringPrintf("\n  (%s)", details.c_str());
+  if (static_msg_) {
+    msg_ = static_msg_;
+    static_msg_ = nullptr;
+  }
+  msg_.reserve(msg_.size() + details.size() + 6);
+  msg_ += "\n  (";
+  msg_ += details;
+  msg_ += ")";
 }
 
 bool Status::IsOk() const {
@@ -126,6 +161,10 @@ StatusCode Status::code() const {
 }
 
 const std::string& Status::message() const {
+  // Materialize the static code string on first use; until then carrying the
+  // status around costs no allocation.
+  if (static_msg_ && msg_.empty())
+    msg_ = static_msg_;
   return msg_;
 }
 
@@ -43,13 +43,20 @@ enum StatusCode {
   kTabCrashed,
   kTargetDetached,
   kUnexpectedAlertOpen_Keep,
+  kSessionOverloaded,
 };
 
 // Represents a WebDriver status, which may be an error or ok.
+//
+// A Status built from a code alone (notably Status(kOk), constructed on
+// virtually every return path) stores only a pointer to the static code
+// string and performs no allocation; a message string is materialized
+// lazily if message() is called or details are attached.
 class Status {
  public:
   explicit Status(StatusCode code);
   Status(StatusCode code, const std::string& details);
+  Status(StatusCode code, std::string&& details);
   Status(StatusCode code, const Status& cause);
   Status(StatusCode code, const std::string& details, const Status& cause);
   ~Status();
@@ -67,7 +74,11 @@ class Status {
 
  private:
   StatusCode code_;
-  std::string msg_;
+  // Points at the static code string while no details have been attached;
+  // null once |msg_| carries the message. |msg_| is built lazily from
+  // |static_msg_| on first use, hence mutable.
+  const char* static_msg_;
+  mutable std::string msg_;
   std::string stack_trace_;
 };
 
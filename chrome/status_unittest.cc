@@ -50,3 +50,24 @@ TEST(StatusTest, AddDetails) {
   error.AddDetails("details");
   ASSERT_STREQ("unknown error\n  (details)", error.message().c_str());
 }
+
+TEST(StatusTest, AddDetailsToCodeOnlyStatus) {
+  // The code-only constructor stores just the static code string; attaching
+  // details must materialize the message first.
+  Status error(kUnknownError);
+  ASSERT_STREQ("unknown error", error.message().c_str());
+  error.AddDetails("details");
+  ASSERT_STREQ("unknown error\n  (details)", error.message().c_str());
+}
+
+TEST(StatusTest, MovedDetails) {
+  std::string details = "something happened";
+  Status error(kUnknownError, std::move(details));
+  ASSERT_STREQ("unknown error: something happened", error.message().c_str());
+}
+
+TEST(StatusTest, CodeOnlyCause) {
+  Status error(kUnknownCommand, Status(kSessionNotCreated));
+  ASSERT_STREQ("unknown command\nfrom session not created",
+               error.message().c_str());
+}
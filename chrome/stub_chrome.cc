@@ -32,6 +32,11 @@ Status StubChrome::GetWebViewIds(std::list<std::string>* web_view_ids,
   return Status(kOk);
 }
 
+Status StubChrome::GetWebViewsSummary(std::vector<WebViewInfo>* views,
+                                      bool w3c_compliant) {
+  return Status(kOk);
+}
+
 Status StubChrome::GetWebViewById(const std::string& id, WebView** web_view) {
   return Status(kOk);
 }
@@ -67,7 +72,7 @@ Status StubChrome::CloseWebView(const std::string& id) {
   return Status(kOk);
 }
 
-Status StubChrome::ActivateWebView(const std::string& id) {
+Status StubChrome::ActivateWebView(const std::string& id, bool force) {
   return Status(kOk);
 }
 
@@ -99,6 +104,10 @@ std::string StubChrome::page_load_strategy() const {
   return std::string();
 }
 
+Status StubChrome::GetBufferedDeviceLog(std::vector<std::string>* lines) {
+  return Status(kOk);
+}
+
 Status StubChrome::Quit() {
   return Status(kOk);
 }
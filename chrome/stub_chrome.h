@@ -28,6 +28,8 @@ class StubChrome : public Chrome {
                                  bool w3c_compliant) override;
   Status GetWebViewIds(std::list<std::string>* web_view_ids,
                        bool w3c_compliant) override;
+  Status GetWebViewsSummary(std::vector<WebViewInfo>* views,
+                            bool w3c_compliant) override;
   Status GetWebViewById(const std::string& id, WebView** web_view) override;
   Status NewWindow(const std::string& target_id,
                    WindowType type,
@@ -39,7 +41,7 @@ class StubChrome : public Chrome {
   Status MinimizeWindow(const std::string& target_id) override;
   Status FullScreenWindow(const std::string& target_id) override;
   Status CloseWebView(const std::string& id) override;
-  Status ActivateWebView(const std::string& id) override;
+  Status ActivateWebView(const std::string& id, bool force) override;
   Status SetAcceptInsecureCerts() override;
   Status SetPermission(
       std::unique_ptr<base::DictionaryValue> permission_descriptor,
@@ -50,6 +52,7 @@ class StubChrome : public Chrome {
   bool IsMobileEmulationEnabled() const override;
   bool HasTouchScreen() const override;
   std::string page_load_strategy() const override;
+  Status GetBufferedDeviceLog(std::vector<std::string>* lines) override;
   Status Quit() override;
 
  private:
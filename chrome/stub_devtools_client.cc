@@ -7,6 +7,7 @@
 #include <memory>
 
 #include "base/values.h"
+#include "chrome/test/chromedriver/chrome/devtools_client_impl.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 
 StubDevToolsClient::StubDevToolsClient() : id_("stub-id") {}
@@ -80,6 +81,47 @@ Status StubDevToolsClient::SendCommandAndIgnoreResponse(
   return SendCommand(method, params);
 }
 
+Status StubDevToolsClient::SendCommandBatch(
+    const std::string& method,
+    const std::vector<const base::DictionaryValue*>& params_batch,
+    std::vector<std::unique_ptr<base::DictionaryValue>>* results) {
+  results->clear();
+  for (const base::DictionaryValue* params : params_batch) {
+    std::unique_ptr<base::DictionaryValue> result;
+    Status status = SendCommandAndGetResult(method, *params, &result);
+    if (status.IsError())
+      return status;
+    results->push_back(std::move(result));
+  }
+  return Status(kOk);
+}
+
+Status StubDevToolsClient::SendCommandAndGetFuture(
+    const std::string& method,
+    const base::DictionaryValue& params,
+    std::unique_ptr<DevToolsCommandFuture>* future) {
+  // No pipelining in the stub: execute synchronously and leave no future,
+  // per the interface contract.
+  future->reset();
+  return SendCommand(method, params);
+}
+
+Status StubDevToolsClient::SendCommandDeferred(
+    const std::string& method,
+    const base::DictionaryValue& params) {
+  return SendCommand(method, params);
+}
+
+Status StubDevToolsClient::EnableDomain(const std::string& domain) {
+  base::DictionaryValue params;
+  return SendCommand(domain + ".enable", params);
+}
+
+Status StubDevToolsClient::DisableDomain(const std::string& domain) {
+  base::DictionaryValue params;
+  return SendCommand(domain + ".disable", params);
+}
+
 void StubDevToolsClient::AddListener(DevToolsEventListener* listener) {
   listeners_.push_back(listener);
 }
@@ -94,6 +136,14 @@ Status StubDevToolsClient::HandleReceivedEvents() {
   return Status(kOk);
 }
 
+bool StubDevToolsClient::MayHavePendingDialogEvents() {
+  return false;
+}
+
+Status StubDevToolsClient::HandleNextEvent(const Timeout& timeout) {
+  return Status(kOk);
+}
+
 void StubDevToolsClient::SetDetached() {}
 
 void StubDevToolsClient::SetOwner(WebViewImpl* owner) {}
@@ -8,6 +8,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/compiler_specific.h"
 #include "chrome/test/chromedriver/chrome/devtools_client.h"
@@ -54,10 +55,24 @@ class StubDevToolsClient : public DevToolsClient {
   Status SendCommandAndIgnoreResponse(
       const std::string& method,
       const base::DictionaryValue& params) override;
+  Status SendCommandBatch(
+      const std::string& method,
+      const std::vector<const base::DictionaryValue*>& params_batch,
+      std::vector<std::unique_ptr<base::DictionaryValue>>* results) override;
+  Status SendCommandAndGetFuture(
+      const std::string& method,
+      const base::DictionaryValue& params,
+      std::unique_ptr<DevToolsCommandFuture>* future) override;
+  Status SendCommandDeferred(const std::string& method,
+                             const base::DictionaryValue& params) override;
+  Status EnableDomain(const std::string& domain) override;
+  Status DisableDomain(const std::string& domain) override;
   void AddListener(DevToolsEventListener* listener) override;
   Status HandleEventsUntil(const ConditionalFunc& conditional_func,
                            const Timeout& timeout) override;
   Status HandleReceivedEvents() override;
+  bool MayHavePendingDialogEvents() override;
+  Status HandleNextEvent(const Timeout& timeout) override;
   void SetDetached() override;
   void SetOwner(WebViewImpl* owner) override;
   WebViewImpl* GetOwner() const override;
@@ -4,6 +4,7 @@
 
 #include "base/files/file_path.h"
 #include "base/values.h"
+#include "chrome/test/chromedriver/chrome/devtools_client_impl.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/stub_web_view.h"
 #include "chrome/test/chromedriver/chrome/ui_events.h"
@@ -36,6 +37,10 @@ Status StubWebView::HandleReceivedEvents() {
   return Status(kOk);
 }
 
+Status StubWebView::HandleNextEvent(const Timeout& timeout) {
+  return Status(kOk);
+}
+
 Status StubWebView::GetUrl(std::string* url) {
   return Status(kOk);
 }
@@ -61,6 +66,12 @@ Status StubWebView::SendCommand(const std::string& cmd,
   return Status(kOk);
 }
 
+Status StubWebView::SendCommandAndIgnoreResponse(
+    const std::string& cmd,
+    const base::DictionaryValue& params) {
+  return Status(kOk);
+}
+
 Status StubWebView::SendCommandFromWebSocket(
     const std::string& cmd,
     const base::DictionaryValue& params,
@@ -75,6 +86,13 @@ Status StubWebView::SendCommandAndGetResult(
   return Status(kOk);
 }
 
+Status StubWebView::SendCommandBatch(
+    const std::string& cmd,
+    const std::vector<const base::DictionaryValue*>& params_batch,
+    std::vector<std::unique_ptr<base::DictionaryValue>>* results) {
+  return Status(kOk);
+}
+
 Status StubWebView::TraverseHistory(int delta, const Timeout* timeout) {
   return Status(kOk);
 }
@@ -93,6 +111,15 @@ Status StubWebView::CallFunction(const std::string& frame,
   return Status(kOk);
 }
 
+Status StubWebView::CallFunctionWithTimeout(
+    const std::string& frame,
+    const std::string& function,
+    const base::ListValue& args,
+    const base::TimeDelta& timeout,
+    std::unique_ptr<base::Value>* result) {
+  return Status(kOk);
+}
+
 Status StubWebView::CallAsyncFunction(const std::string& frame,
                                       const std::string& function,
                                       const base::ListValue& args,
@@ -125,6 +152,28 @@ Status StubWebView::GetFrameByFunction(const std::string& frame,
   return Status(kOk);
 }
 
+Status StubWebView::GetPageSource(const std::string& frame,
+                                  std::unique_ptr<base::Value>* value) {
+  return Status(kOk);
+}
+
+Status StubWebView::FindElementsByCssSelector(
+    const std::string& frame,
+    const std::string& selector,
+    const std::string* root_element_id,
+    bool only_one,
+    std::unique_ptr<base::Value>* value) {
+  // An error keeps find tests on the scripted CallFunction fallback path.
+  return Status(kUnknownError, "native find not implemented in stub");
+}
+
+Status StubWebView::CallFunctionInAllFrames(
+    const std::string& function,
+    const base::ListValue& args,
+    std::unique_ptr<base::Value>* result) {
+  return Status(kOk);
+}
+
 Status StubWebView::DispatchMouseEvents(const std::vector<MouseEvent>& events,
                                         const std::string& frame,
                                         bool async_dispatch_events) {
@@ -152,6 +201,10 @@ Status StubWebView::DispatchKeyEvents(const std::vector<KeyEvent>& events,
   return Status(kOk);
 }
 
+Status StubWebView::InsertText(const std::string& text) {
+  return Status(kOk);
+}
+
 Status StubWebView::GetCookies(std::unique_ptr<base::ListValue>* cookies,
                                const std::string& current_page_url) {
   return Status(kOk);
@@ -164,6 +217,10 @@ Status StubWebView::DeleteCookie(const std::string& name,
   return Status(kOk);
 }
 
+Status StubWebView::SetCookies(const base::ListValue& cookies) {
+  return Status(kOk);
+}
+
 Status StubWebView::AddCookie(const std::string& name,
                               const std::string& url,
                               const std::string& value,
@@ -191,6 +248,10 @@ JavaScriptDialogManager* StubWebView::GetJavaScriptDialogManager() {
   return nullptr;
 }
 
+AXNodeCache* StubWebView::GetAXNodeCache() {
+  return nullptr;
+}
+
 MobileEmulationOverrideManager* StubWebView::GetMobileEmulationOverrideManager()
     const {
   return nullptr;
@@ -205,6 +266,19 @@ Status StubWebView::OverrideNetworkConditions(
   return Status(kOk);
 }
 
+Status StubWebView::OverrideNetworkConditionsAsync(
+    const NetworkConditions& network_conditions) {
+  return Status(kOk);
+}
+
+Status StubWebView::CollectNetworkConditionsAck() {
+  return Status(kOk);
+}
+
+Status StubWebView::RemoveNetworkConditionsOverride() {
+  return Status(kOk);
+}
+
 Status StubWebView::OverrideDownloadDirectoryIfNeeded(
     const std::string& download_directory) {
   return Status(kOk);
@@ -216,11 +290,42 @@ Status StubWebView::CaptureScreenshot(
   return Status(kOk);
 }
 
+Status StubWebView::CaptureScreenshotAndGetFuture(
+    const base::DictionaryValue& params,
+    std::string* screenshot,
+    std::unique_ptr<DevToolsCommandFuture>* future) {
+  future->reset();
+  return CaptureScreenshot(screenshot, params);
+}
+
+Status StubWebView::CaptureScreenshotDelta(
+    int last_frame_id,
+    std::unique_ptr<base::DictionaryValue>* delta) {
+  *delta = std::make_unique<base::DictionaryValue>();
+  return Status(kOk);
+}
+
+Status StubWebView::StartScreencast(const base::DictionaryValue& params) {
+  return Status(kOk);
+}
+
+Status StubWebView::StopScreencast() {
+  return Status(kOk);
+}
+
+Status StubWebView::GetScreencastFrame(std::string* data, double* timestamp) {
+  return Status(kOk);
+}
+
 Status StubWebView::PrintToPDF(const base::DictionaryValue& params,
                                std::string* pdf) {
   return Status(kOk);
 }
 
+Status StubWebView::CaptureSnapshot(std::string* mhtml) {
+  return Status(kOk);
+}
+
 Status StubWebView::SetFileInputFiles(const std::string& frame,
                                       const base::DictionaryValue& element,
                                       const std::vector<base::FilePath>& files,
@@ -232,6 +337,10 @@ Status StubWebView::TakeHeapSnapshot(std::unique_ptr<base::Value>* snapshot) {
   return Status(kOk);
 }
 
+Status StubWebView::TakeHeapSnapshotToFile(base::FilePath* snapshot_path) {
+  return Status(kOk);
+}
+
 Status StubWebView::StartProfile() {
   return Status(kOk);
 }
@@ -250,7 +359,16 @@ Status StubWebView::SynthesizeTapGesture(int x,
 Status StubWebView::SynthesizeScrollGesture(int x,
                                             int y,
                                             int xoffset,
-                                            int yoffset) {
+                                            int yoffset,
+                                            int speed) {
+  return Status(kOk);
+}
+
+Status StubWebView::ScrollIntoViewIfNeeded(const std::string& frame,
+                                           const std::string& element_id,
+                                           const WebRect& region,
+                                           bool* scrolled) {
+  *scrolled = false;
   return Status(kOk);
 }
 
@@ -258,6 +376,10 @@ bool StubWebView::IsNonBlocking() const {
   return false;
 }
 
+bool StubWebView::GetTrackedTopFrameUrl(std::string* url) {
+  return false;
+}
+
 bool StubWebView::IsOOPIF(const std::string& frame_id) {
   return false;
 }
@@ -23,6 +23,7 @@ class StubWebView : public WebView {
   Status ConnectIfNecessary() override;
   Status SetUpDevTools() override;
   Status HandleReceivedEvents() override;
+  Status HandleNextEvent(const Timeout& timeout) override;
   Status GetUrl(std::string* url) override;
   Status Load(const std::string& url, const Timeout* timeout) override;
   Status Reload(const Timeout* timeout) override;
@@ -30,12 +31,19 @@ class StubWebView : public WebView {
   Status Resume(const Timeout* timeout) override;
   Status SendCommand(const std::string& cmd,
                      const base::DictionaryValue& params) override;
+  Status SendCommandAndIgnoreResponse(
+      const std::string& cmd,
+      const base::DictionaryValue& params) override;
   Status SendCommandFromWebSocket(const std::string& cmd,
                                   const base::DictionaryValue& params,
                                   const int client_cmd_id) override;
   Status SendCommandAndGetResult(const std::string& cmd,
                                  const base::DictionaryValue& params,
                                  std::unique_ptr<base::Value>* value) override;
+  Status SendCommandBatch(
+      const std::string& cmd,
+      const std::vector<const base::DictionaryValue*>& params_batch,
+      std::vector<std::unique_ptr<base::DictionaryValue>>* results) override;
   Status TraverseHistory(int delta, const Timeout* timeout) override;
   Status EvaluateScript(const std::string& frame,
                         const std::string& function,
@@ -45,6 +53,11 @@ class StubWebView : public WebView {
                       const std::string& function,
                       const base::ListValue& args,
                       std::unique_ptr<base::Value>* result) override;
+  Status CallFunctionWithTimeout(const std::string& frame,
+                                 const std::string& function,
+                                 const base::ListValue& args,
+                                 const base::TimeDelta& timeout,
+                                 std::unique_ptr<base::Value>* result) override;
   Status CallAsyncFunction(const std::string& frame,
                            const std::string& function,
                            const base::ListValue& args,
@@ -64,6 +77,16 @@ class StubWebView : public WebView {
                             const std::string& function,
                             const base::ListValue& args,
                             std::string* out_frame) override;
+  Status FindElementsByCssSelector(const std::string& frame,
+                                   const std::string& selector,
+                                   const std::string* root_element_id,
+                                   bool only_one,
+                                   std::unique_ptr<base::Value>* value) override;
+  Status GetPageSource(const std::string& frame,
+                       std::unique_ptr<base::Value>* value) override;
+  Status CallFunctionInAllFrames(const std::string& function,
+                                 const base::ListValue& args,
+                                 std::unique_ptr<base::Value>* result) override;
   Status DispatchMouseEvents(const std::vector<MouseEvent>& events,
                              const std::string& frame,
                              bool async_dispatch_events = false) override;
@@ -76,12 +99,14 @@ class StubWebView : public WebView {
       bool async_dispatch_events = false) override;
   Status DispatchKeyEvents(const std::vector<KeyEvent>& events,
                            bool async_dispatch_events = false) override;
+  Status InsertText(const std::string& text) override;
   Status GetCookies(std::unique_ptr<base::ListValue>* cookies,
                     const std::string& current_page_url) override;
   Status DeleteCookie(const std::string& name,
                       const std::string& url,
                       const std::string& domain,
                       const std::string& path) override;
+  Status SetCookies(const base::ListValue& cookies) override;
   Status AddCookie(const std::string& name,
                    const std::string& url,
                    const std::string& value,
@@ -97,23 +122,40 @@ class StubWebView : public WebView {
   Status IsPendingNavigation(const Timeout* timeout,
                              bool* is_pending) const override;
   JavaScriptDialogManager* GetJavaScriptDialogManager() override;
+  AXNodeCache* GetAXNodeCache() override;
   MobileEmulationOverrideManager* GetMobileEmulationOverrideManager()
       const override;
   Status OverrideGeolocation(const Geoposition& geoposition) override;
   Status OverrideNetworkConditions(
       const NetworkConditions& network_conditions) override;
+  Status OverrideNetworkConditionsAsync(
+      const NetworkConditions& network_conditions) override;
+  Status CollectNetworkConditionsAck() override;
+  Status RemoveNetworkConditionsOverride() override;
   Status OverrideDownloadDirectoryIfNeeded(
       const std::string& download_directory) override;
   Status CaptureScreenshot(
       std::string* screenshot,
       const base::DictionaryValue& params) override;
+  Status CaptureScreenshotAndGetFuture(
+      const base::DictionaryValue& params,
+      std::string* screenshot,
+      std::unique_ptr<DevToolsCommandFuture>* future) override;
+  Status CaptureScreenshotDelta(
+      int last_frame_id,
+      std::unique_ptr<base::DictionaryValue>* delta) override;
+  Status StartScreencast(const base::DictionaryValue& params) override;
+  Status StopScreencast() override;
+  Status GetScreencastFrame(std::string* data, double* timestamp) override;
   Status PrintToPDF(const base::DictionaryValue& params,
                     std::string* pdf) override;
+  Status CaptureSnapshot(std::string* mhtml) override;
   Status SetFileInputFiles(const std::string& frame,
                            const base::DictionaryValue& element,
                            const std::vector<base::FilePath>& files,
                            const bool append) override;
   Status TakeHeapSnapshot(std::unique_ptr<base::Value>* snapshot) override;
+  Status TakeHeapSnapshotToFile(base::FilePath* snapshot_path) override;
   Status StartProfile() override;
   Status EndProfile(std::unique_ptr<base::Value>* profile_data) override;
   Status SynthesizeTapGesture(int x,
@@ -123,8 +165,14 @@ class StubWebView : public WebView {
   Status SynthesizeScrollGesture(int x,
                                  int y,
                                  int xoffset,
-                                 int yoffset) override;
+                                 int yoffset,
+                                 int speed) override;
+  Status ScrollIntoViewIfNeeded(const std::string& frame,
+                                const std::string& element_id,
+                                const WebRect& region,
+                                bool* scrolled) override;
   bool IsNonBlocking() const override;
+  bool GetTrackedTopFrameUrl(std::string* url) override;
   bool IsOOPIF(const std::string& frame_id) override;
   FrameTracker* GetFrameTracker() const override;
   std::unique_ptr<base::Value> GetCastSinks() override;
@@ -0,0 +1,73 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_CHROME_TARGET_TRACKER_H_
+#define CHROME_TEST_CHROMEDRIVER_CHROME_TARGET_TRACKER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
+#include "chrome/test/chromedriver/chrome/devtools_http_client.h"
+
+namespace base {
+class DictionaryValue;
+}
+
+class DevToolsClient;
+class Status;
+
+// Maintains a snapshot of the browser's target list from Target.targetCreated,
+// Target.targetInfoChanged and Target.targetDestroyed events on the
+// browser-wide DevTools client, so that enumerating web views does not need a
+// fetch of the DevTools HTTP target list on every command.
+class TargetTracker : public DevToolsEventListener {
+ public:
+  explicit TargetTracker(DevToolsClient* client);
+  ~TargetTracker() override;
+
+  // Whether the snapshot reflects the browser's target list. False until the
+  // client connects and target discovery is enabled, in which case callers
+  // must fall back to the DevTools HTTP endpoint.
+  bool IsActive() const;
+
+  // Enables target discovery on |client|, which must be connected. Needed
+  // when the connection was established before this tracker was registered
+  // (tracing connects the browser-wide client at launch); a no-op if
+  // discovery has already been attempted on this connection.
+  Status EnsureEnabled(DevToolsClient* client);
+
+  // Returns the current snapshot. Call DevToolsClient::HandleReceivedEvents
+  // first to fold in any target events received since the last command.
+  WebViewsInfo GetWebViewsInfo() const;
+
+  // A counter bumped whenever a target appears or disappears (events that
+  // can move browser focus); unchanged by title or URL updates. Lets
+  // callers detect that the target list is the same as when they last
+  // looked without comparing snapshots.
+  uint64_t Revision() const;
+
+  // Overridden from DevToolsEventListener:
+  Status OnConnected(DevToolsClient* client) override;
+  Status OnEvent(DevToolsClient* client,
+                 const std::string& method,
+                 const base::DictionaryValue& params) override;
+  std::vector<std::string> SubscribedMethodPrefixes() const override;
+
+ private:
+  bool active_;
+  // Whether discovery has been attempted on the current connection.
+  bool enable_attempted_;
+  // Bumped on target creation, destruction, and reconnect; see Revision().
+  uint64_t revision_;
+  // Targets in creation order, matching the DevTools HTTP target list.
+  std::vector<WebViewInfo> targets_;
+
+  DISALLOW_COPY_AND_ASSIGN(TargetTracker);
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_CHROME_TARGET_TRACKER_H_
@@ -0,0 +1,174 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <list>
+#include <string>
+
+#include "base/values.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/chrome/stub_devtools_client.h"
+#include "chrome/test/chromedriver/chrome/target_tracker.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+class FakeDevToolsClient : public StubDevToolsClient {
+ public:
+  FakeDevToolsClient() {}
+  ~FakeDevToolsClient() override {}
+
+  std::string PopSentCommand() {
+    std::string command;
+    if (!sent_command_queue_.empty()) {
+      command = sent_command_queue_.front();
+      sent_command_queue_.pop_front();
+    }
+    return command;
+  }
+
+  // Overridden from DevToolsClient:
+  Status SendCommand(const std::string& method,
+                     const base::DictionaryValue& params) override {
+    sent_command_queue_.push_back(method);
+    return Status(kOk);
+  }
+
+ private:
+  std::list<std::string> sent_command_queue_;
+};
+
+base::DictionaryValue CreateTargetCreatedParams(const std::string& target_id,
+                                                const std::string& type,
+                                                const std::string& url,
+                                                bool attached) {
+  base::DictionaryValue params;
+  auto target_info = std::make_unique<base::DictionaryValue>();
+  target_info->SetString("targetId", target_id);
+  target_info->SetString("type", type);
+  target_info->SetString("url", url);
+  target_info->SetBoolean("attached", attached);
+  params.SetDictionary("targetInfo", std::move(target_info));
+  return params;
+}
+
+}  // namespace
+
+TEST(TargetTracker, EnablesDiscoveryOnConnect) {
+  FakeDevToolsClient client;
+  TargetTracker tracker(&client);
+  ASSERT_FALSE(tracker.IsActive());
+  ASSERT_EQ(kOk, tracker.OnConnected(&client).code());
+  ASSERT_TRUE(tracker.IsActive());
+  ASSERT_STREQ("Target.setDiscoverTargets", client.PopSentCommand().c_str());
+  // Enabling again on the same connection is a no-op.
+  ASSERT_EQ(kOk, tracker.EnsureEnabled(&client).code());
+  ASSERT_TRUE(client.PopSentCommand().empty());
+}
+
+TEST(TargetTracker, TracksCreatedAndDestroyedTargets) {
+  FakeDevToolsClient client;
+  TargetTracker tracker(&client);
+  ASSERT_EQ(kOk, tracker.OnConnected(&client).code());
+
+  base::DictionaryValue params =
+      CreateTargetCreatedParams("t1", "page", "http://a/", false);
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(&client, "Target.targetCreated", params).code());
+  params = CreateTargetCreatedParams("t2", "page", "http://b/", false);
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(&client, "Target.targetCreated", params).code());
+
+  WebViewsInfo views_info = tracker.GetWebViewsInfo();
+  ASSERT_EQ(2u, views_info.GetSize());
+  ASSERT_EQ("t1", views_info.Get(0).id);
+  ASSERT_EQ("t2", views_info.Get(1).id);
+
+  params.Clear();
+  params.SetString("targetId", "t1");
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(&client, "Target.targetDestroyed", params).code());
+  views_info = tracker.GetWebViewsInfo();
+  ASSERT_EQ(1u, views_info.GetSize());
+  ASSERT_EQ("t2", views_info.Get(0).id);
+}
+
+TEST(TargetTracker, TargetInfoChangedUpdatesInPlace) {
+  FakeDevToolsClient client;
+  TargetTracker tracker(&client);
+  ASSERT_EQ(kOk, tracker.OnConnected(&client).code());
+
+  base::DictionaryValue params =
+      CreateTargetCreatedParams("t1", "background_page", "http://a/", false);
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(&client, "Target.targetCreated", params).code());
+  ASSERT_FALSE(tracker.GetWebViewsInfo().Get(0).IsInactiveBackgroundPage());
+
+  // An attached target has no debugger URL, like the HTTP target list.
+  params = CreateTargetCreatedParams("t1", "background_page", "http://a/",
+                                     true);
+  ASSERT_EQ(
+      kOk,
+      tracker.OnEvent(&client, "Target.targetInfoChanged", params).code());
+  WebViewsInfo views_info = tracker.GetWebViewsInfo();
+  ASSERT_EQ(1u, views_info.GetSize());
+  ASSERT_TRUE(views_info.Get(0).IsInactiveBackgroundPage());
+}
+
+TEST(TargetTracker, ReconnectClearsSnapshot) {
+  FakeDevToolsClient client;
+  TargetTracker tracker(&client);
+  ASSERT_EQ(kOk, tracker.OnConnected(&client).code());
+
+  base::DictionaryValue params =
+      CreateTargetCreatedParams("t1", "page", "http://a/", false);
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(&client, "Target.targetCreated", params).code());
+  ASSERT_EQ(1u, tracker.GetWebViewsInfo().GetSize());
+
+  ASSERT_EQ(kOk, tracker.OnConnected(&client).code());
+  ASSERT_EQ(0u, tracker.GetWebViewsInfo().GetSize());
+}
+
+TEST(TargetTracker, RevisionTracksTargetListChanges) {
+  FakeDevToolsClient client;
+  TargetTracker tracker(&client);
+  ASSERT_EQ(kOk, tracker.OnConnected(&client).code());
+  uint64_t revision = tracker.Revision();
+
+  base::DictionaryValue params =
+      CreateTargetCreatedParams("t1", "page", "http://a/", false);
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(&client, "Target.targetCreated", params).code());
+  ASSERT_NE(revision, tracker.Revision());
+  revision = tracker.Revision();
+
+  // An in-place update does not change the target list.
+  params = CreateTargetCreatedParams("t1", "page", "http://b/", false);
+  ASSERT_EQ(
+      kOk,
+      tracker.OnEvent(&client, "Target.targetInfoChanged", params).code());
+  ASSERT_EQ(revision, tracker.Revision());
+
+  params.Clear();
+  params.SetString("targetId", "t1");
+  ASSERT_EQ(kOk,
+            tracker.OnEvent(&client, "Target.targetDestroyed", params).code());
+  ASSERT_NE(revision, tracker.Revision());
+  revision = tracker.Revision();
+
+  ASSERT_EQ(kOk, tracker.OnConnected(&client).code());
+  ASSERT_NE(revision, tracker.Revision());
+}
+
+TEST(TargetTracker, MalformedEventDeactivatesTracker) {
+  FakeDevToolsClient client;
+  TargetTracker tracker(&client);
+  ASSERT_EQ(kOk, tracker.OnConnected(&client).code());
+
+  base::DictionaryValue params =
+      CreateTargetCreatedParams("t1", "bogus_type", "http://a/", false);
+  ASSERT_TRUE(
+      tracker.OnEvent(&client, "Target.targetCreated", params).IsError());
+  ASSERT_FALSE(tracker.IsActive());
+}
@@ -28,7 +28,8 @@ MouseEvent::MouseEvent(MouseEventType type,
       tiltX(0),
       tiltY(0),
       twist(0),
-      pointer_type(kMouse) {}
+      pointer_type(kMouse),
+      timestamp(-1) {}
 
 MouseEvent::MouseEvent(const MouseEvent& other) = default;
 
@@ -49,7 +50,8 @@ TouchEvent::TouchEvent(TouchEventType type, int x, int y)
       tiltY(0),
       twist(0),
       id(0),
-      dispatch(true) {}
+      dispatch(true),
+      timestamp(-1) {}
 
 TouchEvent::TouchEvent(const TouchEvent& other) = default;
 
@@ -64,7 +66,8 @@ KeyEvent::KeyEvent()
       key_code(ui::VKEY_UNKNOWN),
       location(0),
       code(),
-      is_from_action(false) {}
+      is_from_action(false),
+      timestamp(-1) {}
 
 KeyEvent::KeyEvent(const KeyEvent& that)
     : type(that.type),
@@ -75,7 +78,8 @@ KeyEvent::KeyEvent(const KeyEvent& that)
       key_code(that.key_code),
       location(that.location),
       code(that.code),
-      is_from_action(that.is_from_action) {}
+      is_from_action(that.is_from_action),
+      timestamp(that.timestamp) {}
 
 KeyEvent::~KeyEvent() {}
 
@@ -63,6 +63,11 @@ struct MouseEvent {
   int tiltY;
   int twist;
   PointerType pointer_type;
+  // Intended dispatch time in seconds since the unix epoch, or a negative
+  // value to let the browser stamp the event on arrival. Action ticks stamp
+  // events with their precomputed timeline time so that pages measuring
+  // event.timeStamp see the intended pacing even when dispatch runs early.
+  double timestamp;
 };
 
 // Specifies the type of the touch event.
@@ -95,6 +100,8 @@ struct TouchEvent {
   int twist;
   int id;
   bool dispatch;
+  // See MouseEvent::timestamp.
+  double timestamp;
 };
 
 // Specifies the type of the keyboard event.
@@ -133,6 +140,8 @@ struct KeyEvent {
   int location;
   std::string code;
   bool is_from_action;
+  // See MouseEvent::timestamp.
+  double timestamp;
 };
 
 class KeyEventBuilder {
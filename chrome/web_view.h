@@ -18,6 +18,8 @@ class TimeDelta;
 class Value;
 }
 
+class AXNodeCache;
+class DevToolsCommandFuture;
 class FrameTracker;
 struct Geoposition;
 class JavaScriptDialogManager;
@@ -29,6 +31,8 @@ class Status;
 class Timeout;
 struct TouchEvent;
 
+struct WebRect;
+
 class WebView {
  public:
   virtual ~WebView() {}
@@ -50,6 +54,11 @@ class WebView {
   // Handles events that have been received but not yet handled.
   virtual Status HandleReceivedEvents() = 0;
 
+  // Blocks until the next event arrives on the DevTools connection and has
+  // been handled, or |timeout| expires. Lets long-poll commands sleep until
+  // tracked state may have changed instead of re-querying on a timer.
+  virtual Status HandleNextEvent(const Timeout& timeout) = 0;
+
   // Get the current URL of the main frame.
   virtual Status GetUrl(std::string* url) = 0;
 
@@ -69,6 +78,12 @@ class WebView {
   virtual Status SendCommand(const std::string& cmd,
                              const base::DictionaryValue& params) = 0;
 
+  // Send a command to the DevTools debugger without waiting for its
+  // response, so several commands can be pipelined on one round trip.
+  virtual Status SendCommandAndIgnoreResponse(
+      const std::string& cmd,
+      const base::DictionaryValue& params) = 0;
+
   // Send a command to the DevTools debugger. Received from WebSocket
   virtual Status SendCommandFromWebSocket(const std::string& cmd,
                                           const base::DictionaryValue& params,
@@ -80,6 +95,13 @@ class WebView {
           const base::DictionaryValue& params,
           std::unique_ptr<base::Value>* value) = 0;
 
+  // Sends |cmd| once per entry of |params_batch| on one round trip and
+  // collects the responses in order; see DevToolsClient::SendCommandBatch.
+  virtual Status SendCommandBatch(
+      const std::string& cmd,
+      const std::vector<const base::DictionaryValue*>& params_batch,
+      std::vector<std::unique_ptr<base::DictionaryValue>>* results) = 0;
+
   // Navigate |delta| steps forward in the browser history. A negative value
   // will navigate back in the history. If the delta exceeds the number of items
   // in the browser history, stay on the current page.
@@ -108,6 +130,16 @@ class WebView {
                               const base::ListValue& args,
                               std::unique_ptr<base::Value>* result) = 0;
 
+  // Same as |CallFunction|, but gives up with |kTimeout| if the call has not
+  // completed within |timeout|. Intended for functions that block inside the
+  // page, e.g. by returning a promise that resolves later.
+  virtual Status CallFunctionWithTimeout(
+      const std::string& frame,
+      const std::string& function,
+      const base::ListValue& args,
+      const base::TimeDelta& timeout,
+      std::unique_ptr<base::Value>* result) = 0;
+
   // Calls a JavaScript function in a specified frame with the given args and
   // two callbacks. The first may be invoked with a value to return to the user.
   // The second may be used to report an error. This function waits until
@@ -148,6 +180,35 @@ class WebView {
                                     const base::ListValue& args,
                                     std::string* out_frame) = 0;
 
+  // Gets the outer HTML of the document element of |frame| via
+  // DOM.getOuterHTML, avoiding the injected-script round trip of
+  // CallFunction for what may be a very large string.
+  virtual Status GetPageSource(const std::string& frame,
+                               std::unique_ptr<base::Value>* value) = 0;
+
+  // Finds elements matching a CSS |selector| natively via DOM.querySelector
+  // or DOM.querySelectorAll, skipping the JS find atom and its result
+  // marshaling. The search is rooted at the element with |root_element_id|,
+  // or at the document of |frame| when null. On a miss the status is kOk and
+  // |value| holds a null value (|only_one|) or an empty list, mirroring the
+  // find atom's result shape so callers can share the handling.
+  virtual Status FindElementsByCssSelector(
+      const std::string& frame,
+      const std::string& selector,
+      const std::string* root_element_id,
+      bool only_one,
+      std::unique_ptr<base::Value>* value) = 0;
+
+  // Calls the given JavaScript function once in every frame of this view
+  // that has an execution context, pipelining the evaluations so the fan
+  // out costs one round trip instead of one per frame. |result| receives
+  // a list of {"frame": <frame id>, "value": <result>} entries in a
+  // stable frame order; frames whose evaluation fails are omitted.
+  virtual Status CallFunctionInAllFrames(
+      const std::string& function,
+      const base::ListValue& args,
+      std::unique_ptr<base::Value>* result) = 0;
+
   // Dispatch a sequence of mouse events.
   virtual Status DispatchMouseEvents(const std::vector<MouseEvent>& events,
                                      const std::string& frame,
@@ -169,6 +230,10 @@ class WebView {
   virtual Status DispatchKeyEvents(const std::vector<KeyEvent>& events,
                                    bool async_dispatch_events) = 0;
 
+  // Insert |text| at the focused element's cursor in one call, as if pasted,
+  // without synthesizing per-character key events.
+  virtual Status InsertText(const std::string& text) = 0;
+
   // Return all the cookies visible to the current page.
   virtual Status GetCookies(std::unique_ptr<base::ListValue>* cookies,
                             const std::string& current_page_url) = 0;
@@ -179,6 +244,10 @@ class WebView {
                               const std::string& domain,
                               const std::string& path) = 0;
 
+  // Sets multiple cookies with one DevTools command. Each entry must already
+  // be in the Network.CookieParam shape.
+  virtual Status SetCookies(const base::ListValue& cookies) = 0;
+
   virtual Status AddCookie(const std::string& name,
                            const std::string& url,
                            const std::string& value,
@@ -207,6 +276,10 @@ class WebView {
   // Returns the JavaScriptDialogManager. Never null.
   virtual JavaScriptDialogManager* GetJavaScriptDialogManager() = 0;
 
+  // Returns the accessibility node cache, or null for views that do not
+  // track one (e.g. service workers).
+  virtual AXNodeCache* GetAXNodeCache() = 0;
+
   // Returns the MobileEmulationOverrideManager.
   virtual MobileEmulationOverrideManager* GetMobileEmulationOverrideManager()
       const = 0;
@@ -218,6 +291,17 @@ class WebView {
   virtual Status OverrideNetworkConditions(
       const NetworkConditions& network_conditions) = 0;
 
+  // Phase one of applying the same conditions to many views: issues this
+  // view's emulation commands without waiting for their responses.
+  virtual Status OverrideNetworkConditionsAsync(
+      const NetworkConditions& network_conditions) = 0;
+
+  // Phase two: collects the responses from OverrideNetworkConditionsAsync.
+  virtual Status CollectNetworkConditionsAck() = 0;
+
+  // Stops overriding the network conditions, restoring the defaults.
+  virtual Status RemoveNetworkConditionsOverride() = 0;
+
   // Overrides normal download directory with given path.
   virtual Status OverrideDownloadDirectoryIfNeeded(
       const std::string& download_directory) = 0;
@@ -227,9 +311,44 @@ class WebView {
       std::string* screenshot,
       const base::DictionaryValue& params) = 0;
 
+  // Issues the capture without waiting for the image, so captures across
+  // several views can run in the browser concurrently; the PNG is claimed
+  // later from |future|. When the underlying client cannot pipeline, the
+  // capture runs synchronously instead: |screenshot| is filled and |future|
+  // left null.
+  virtual Status CaptureScreenshotAndGetFuture(
+      const base::DictionaryValue& params,
+      std::string* screenshot,
+      std::unique_ptr<DevToolsCommandFuture>* future) = 0;
+
+  // Captures only the regions repainted since the frame identified by
+  // |last_frame_id|, using compositor damage tracking. The result carries
+  // "frameId" plus either clipped per-rect images under "rects", or a
+  // full-viewport image under "data" with "full": true when the client must
+  // resync (first call, reconnect, or an unknown |last_frame_id|).
+  virtual Status CaptureScreenshotDelta(
+      int last_frame_id,
+      std::unique_ptr<base::DictionaryValue>* delta) = 0;
+
+  // Starts a screencast that keeps the most recent frame buffered in the web
+  // view, so GetScreencastFrame can serve it without a DevTools round trip.
+  // |params| are parameters for Page.startScreencast.
+  virtual Status StartScreencast(const base::DictionaryValue& params) = 0;
+
+  // Stops the screencast started by StartScreencast.
+  virtual Status StopScreencast() = 0;
+
+  // Returns the most recent screencast frame as base64-encoded image data,
+  // along with its capture time in seconds since the epoch.
+  virtual Status GetScreencastFrame(std::string* data, double* timestamp) = 0;
+
   virtual Status PrintToPDF(const base::DictionaryValue& params,
                             std::string* pdf) = 0;
 
+  // Captures the page, including subframes and resources, as one MHTML
+  // archive.
+  virtual Status CaptureSnapshot(std::string* mhtml) = 0;
+
   // Set files in a file input element.
   // |element| is the WebElement JSON Object of the input element.
   virtual Status SetFileInputFiles(const std::string& frame,
@@ -243,6 +362,11 @@ class WebView {
   //  2. Data elements: "nodes", "edges", "strings".
   virtual Status TakeHeapSnapshot(std::unique_ptr<base::Value>* snapshot) = 0;
 
+  // Like TakeHeapSnapshot, but streams the snapshot to a temporary file
+  // instead of building it up in memory, and returns the file's path in
+  // |snapshot_path|. The caller owns the file.
+  virtual Status TakeHeapSnapshotToFile(base::FilePath* snapshot_path) = 0;
+
   // Start recording Javascript CPU Profile.
   virtual Status StartProfile() = 0;
 
@@ -256,13 +380,34 @@ class WebView {
                                       int tap_count,
                                       bool is_long_press) = 0;
 
+  // Scrolls by (|xoffset|, |yoffset|) with a browser-side synthetic gesture.
+  // |speed| is the swipe speed in pixels per second; pass 0 for the
+  // browser's default.
   virtual Status SynthesizeScrollGesture(int x,
                                          int y,
                                          int xoffset,
-                                         int yoffset) = 0;
+                                         int yoffset,
+                                         int speed) = 0;
+
+  // Scrolls |region| (relative to the element's border box) into view with
+  // DOM.scrollIntoViewIfNeeded, which performs the scroll and forces final
+  // layout browser-side in one call. Leaves |*scrolled| false without error
+  // when the element cannot be resolved to a remote object or the browser
+  // lacks the command, so callers can fall back to the JS scrolling atom.
+  virtual Status ScrollIntoViewIfNeeded(const std::string& frame,
+                                        const std::string& element_id,
+                                        const WebRect& region,
+                                        bool* scrolled) = 0;
 
   virtual bool IsNonBlocking() const = 0;
 
+  // Returns true and sets |url| when the top frame's current URL is known
+  // from tracked navigation events (Page.frameNavigated and same-document
+  // navigations), with no load in progress; pending events are folded in
+  // first. Returns false when in doubt, in which case the caller must ask
+  // the page.
+  virtual bool GetTrackedTopFrameUrl(std::string* url) = 0;
+
   virtual bool IsOOPIF(const std::string& frame_id) = 0;
 
   virtual FrameTracker* GetFrameTracker() const = 0;
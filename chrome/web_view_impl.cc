@@ -5,20 +5,29 @@
 #include "chrome/test/chromedriver/chrome/web_view_impl.h"
 
 #include <stddef.h>
+
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/files/file_path.h"
 #include "base/json/json_writer.h"
 #include "base/logging.h"
+#include "base/optional.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/threading/platform_thread.h"
 #include "base/time/time.h"
 #include "base/values.h"
 #include "build/build_config.h"
+#include "chrome/test/chromedriver/basic_types.h"
+#include "chrome/test/chromedriver/chrome/ax_node_cache.h"
 #include "chrome/test/chromedriver/chrome/browser_info.h"
 #include "chrome/test/chromedriver/chrome/cast_tracker.h"
+#include "chrome/test/chromedriver/chrome/cdp_bindings.h"
+#include "chrome/test/chromedriver/chrome/damage_tracker.h"
 #include "chrome/test/chromedriver/chrome/devtools_client_impl.h"
 #include "chrome/test/chromedriver/chrome/dom_tracker.h"
 #include "chrome/test/chromedriver/chrome/download_directory_override_manager.h"
@@ -32,9 +41,11 @@
 #include "chrome/test/chromedriver/chrome/network_conditions_override_manager.h"
 #include "chrome/test/chromedriver/chrome/non_blocking_navigation_tracker.h"
 #include "chrome/test/chromedriver/chrome/page_load_strategy.h"
+#include "chrome/test/chromedriver/chrome/screencast_tracker.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/ui_events.h"
 #include "chrome/test/chromedriver/net/timeout.h"
+#include "chrome/test/chromedriver/net/wait_site.h"
 #include "ui/events/keycodes/dom/keycode_converter.h"
 #include "ui/events/keycodes/keyboard_code_conversion.h"
 
@@ -42,6 +53,29 @@ namespace {
 
 const int kWaitForNavigationStopSeconds = 10;
 
+// Keys under which element references are serialized; must match
+// element_util.cc and call_function.js.
+const char kElementKey[] = "ELEMENT";
+const char kElementKeyW3C[] = "element-6066-11e4-a52e-4f735466cecf";
+
+// Returns true and extracts the element id when |args| starts with a
+// serialized element reference, the pattern used by element commands.
+bool GetLeadingElementReference(const base::ListValue& args,
+                                bool w3c_compliant,
+                                std::string* element_id) {
+  if (args.GetList().empty())
+    return false;
+  const base::Value& first = args.GetList()[0];
+  if (!first.is_dict() || first.DictSize() != 1)
+    return false;
+  const std::string* id =
+      first.FindStringKey(w3c_compliant ? kElementKeyW3C : kElementKey);
+  if (!id)
+    return false;
+  *element_id = *id;
+  return true;
+}
+
 Status GetContextIdForFrame(WebViewImpl* web_view,
                             const std::string& frame,
                             int* context_id) {
@@ -171,6 +205,7 @@ WebViewImpl::WebViewImpl(const std::string& id,
       is_detached_(false),
       parent_(parent),
       client_(std::move(client)),
+      ax_node_cache_(nullptr),
       dom_tracker_(nullptr),
       frame_tracker_(nullptr),
       dialog_manager_(nullptr),
@@ -196,6 +231,7 @@ WebViewImpl::WebViewImpl(const std::string& id,
       is_detached_(false),
       parent_(parent),
       client_(std::move(client)),
+      ax_node_cache_(new AXNodeCache(client_.get())),
       dom_tracker_(new DomTracker(client_.get())),
       frame_tracker_(new FrameTracker(client_.get(), this, browser_info)),
       dialog_manager_(new JavaScriptDialogManager(client_.get(), browser_info)),
@@ -205,7 +241,7 @@ WebViewImpl::WebViewImpl(const std::string& id,
           new GeolocationOverrideManager(client_.get())),
       network_conditions_override_manager_(
           new NetworkConditionsOverrideManager(client_.get())),
-      heap_snapshot_taker_(new HeapSnapshotTaker(client_.get())),
+      heap_snapshot_taker_(nullptr),
       is_service_worker_(false) {
   // Downloading in headless mode requires the setting of
   // Browser.setDownloadBehavior. This is handled by the
@@ -276,6 +312,10 @@ Status WebViewImpl::HandleReceivedEvents() {
   return client_->HandleReceivedEvents();
 }
 
+Status WebViewImpl::HandleNextEvent(const Timeout& timeout) {
+  return client_->HandleNextEvent(timeout);
+}
+
 Status WebViewImpl::GetUrl(std::string* url) {
   base::DictionaryValue params;
   std::unique_ptr<base::DictionaryValue> result;
@@ -341,6 +381,12 @@ Status WebViewImpl::SendCommand(const std::string& cmd,
   return client_->SendCommand(cmd, params);
 }
 
+Status WebViewImpl::SendCommandAndIgnoreResponse(
+    const std::string& cmd,
+    const base::DictionaryValue& params) {
+  return client_->SendCommandAndIgnoreResponse(cmd, params);
+}
+
 Status WebViewImpl::SendCommandFromWebSocket(
     const std::string& cmd,
     const base::DictionaryValue& params,
@@ -360,6 +406,13 @@ Status WebViewImpl::SendCommandAndGetResult(
   return Status(kOk);
 }
 
+Status WebViewImpl::SendCommandBatch(
+    const std::string& cmd,
+    const std::vector<const base::DictionaryValue*>& params_batch,
+    std::vector<std::unique_ptr<base::DictionaryValue>>* results) {
+  return client_->SendCommandBatch(cmd, params_batch, results);
+}
+
 Status WebViewImpl::TraverseHistory(int delta, const Timeout* timeout) {
   base::DictionaryValue params;
   std::unique_ptr<base::DictionaryValue> result;
@@ -452,22 +505,63 @@ Status WebViewImpl::CallFunctionWithTimeout(
     const base::ListValue& args,
     const base::TimeDelta& timeout,
     std::unique_ptr<base::Value>* result) {
-  std::string json;
-  base::JSONWriter::Write(args, &json);
-  std::string w3c = w3c_compliant_ ? "true" : "false";
-  // TODO(zachconrad): Second null should be array of shadow host ids.
-  std::string expression = base::StringPrintf(
-      "(%s).apply(null, [%s, %s, %s])",
-      kCallFunctionScript,
-      function.c_str(),
-      json.c_str(),
-      w3c.c_str());
-  std::unique_ptr<base::Value> temp_result;
-  Status status =
-      EvaluateScriptWithTimeout(frame, expression, timeout, true, &temp_result);
+  WebViewImpl* target = GetTargetForFrame(this, frame);
+  if (target != nullptr && target != this) {
+    if (target->IsDetached())
+      return Status(kTargetDetached);
+    WebViewImplHolder target_holder(target);
+    return target->CallFunctionWithTimeout(frame, function, args, timeout,
+                                           result);
+  }
+
+  int context_id;
+  Status status = GetContextIdForFrame(this, frame, &context_id);
   if (status.IsError())
-      return status;
-  return internal::ParseCallFunctionResult(*temp_result, result);
+    return status;
+
+  // Element fast path: commands on an element pass its reference as the
+  // first argument. Resolve the reference to a remote object handle once,
+  // cache it per context and pass the handle directly on later calls, so
+  // the page-side element-cache lookup drops out of the hot path.
+  std::string element_object_id;
+  std::string element_id;
+  base::ListValue trimmed_args;
+  const base::ListValue* call_args = &args;
+  if (GetLeadingElementReference(args, w3c_compliant_, &element_id)) {
+    if (!frame_tracker_->GetCachedElementObjectId(context_id, element_id,
+                                                  &element_object_id)) {
+      status = internal::ResolveElementReference(
+          client_.get(), context_id, frame_tracker_.get(), element_id,
+          w3c_compliant_, timeout, &element_object_id);
+      if (status.IsError())
+        return status;
+      if (!element_object_id.empty()) {
+        frame_tracker_->CacheElementObjectId(context_id, element_id,
+                                             element_object_id);
+      }
+    }
+    if (!element_object_id.empty()) {
+      for (size_t i = 1; i < args.GetList().size(); ++i)
+        trimmed_args.Append(args.GetList()[i].Clone());
+      call_args = &trimmed_args;
+    }
+  }
+
+  status = internal::CallCachedFunction(
+      client_.get(), context_id, frame_tracker_.get(), function, *call_args,
+      element_object_id, w3c_compliant_, timeout, result);
+  if (!element_object_id.empty() && status.IsError() &&
+      status.message().find("Could not find object with given id") !=
+          std::string::npos) {
+    // The cached element handle outlived its object; drop this context's
+    // element handles and fall back to the reference path, which either
+    // succeeds or reports the element as stale.
+    frame_tracker_->ClearCachedElementObjectIds(context_id);
+    status = internal::CallCachedFunction(
+        client_.get(), context_id, frame_tracker_.get(), function, args,
+        std::string(), w3c_compliant_, timeout, result);
+  }
+  return status;
 }
 
 Status WebViewImpl::CallFunction(const std::string& frame,
@@ -493,12 +587,22 @@ Status WebViewImpl::CallUserSyncScript(const std::string& frame,
                                        const base::ListValue& args,
                                        const base::TimeDelta& timeout,
                                        std::unique_ptr<base::Value>* result) {
-  base::ListValue sync_args;
-  sync_args.AppendString(script);
-  // Deep-copy needed since ListValue only accepts unique_ptrs of Values.
-  sync_args.Append(args.CreateDeepCopy());
-  return CallFunctionWithTimeout(frame, kExecuteScriptScript, sync_args,
-                                 timeout, result);
+  // Wrap the script body as an async function literal and go through the
+  // cached-function path, which installs it once per execution context.
+  // Repeated ExecuteScript calls with the same body then skip shipping the
+  // source and re-compiling it in the page, where executeScript built a
+  // fresh Function object per call.
+  std::string function = "async function(){" + script + "}";
+  Status status =
+      CallFunctionWithTimeout(frame, function, args, timeout, result);
+  if (status.code() == kUnknownError &&
+      status.message().find("Runtime.evaluate threw exception:") !=
+          std::string::npos) {
+    // Compilation happens at install time now; report script syntax errors
+    // the way in-page compilation did.
+    return Status(kJavaScriptError, status.message());
+  }
+  return status;
 }
 
 Status WebViewImpl::CallUserAsyncFunction(
@@ -528,15 +632,332 @@ Status WebViewImpl::GetFrameByFunction(const std::string& frame,
   if (status.IsError())
     return status;
   bool found_node;
-  int node_id;
-  status = internal::GetNodeIdFromFunction(
+  std::string object_id;
+  status = internal::GetObjectIdFromFunction(
       client_.get(), context_id, function, args,
-      &found_node, &node_id, w3c_compliant_);
+      &found_node, &object_id, w3c_compliant_);
   if (status.IsError())
     return status;
   if (!found_node)
     return Status(kNoSuchFrame);
-  return dom_tracker_->GetFrameIdForNode(node_id, out_frame);
+  status = dom_tracker_->GetFrameIdForObject(object_id, out_frame);
+  {
+    // Release the remote object before doing anything else.
+    cdp::RuntimeReleaseObject release_params;
+    release_params.object_id = object_id;
+    std::string release_json;
+    release_params.WriteJson(&release_json);
+    Status release_status = client_->SendCommandSerialized(
+        cdp::RuntimeReleaseObject::kMethod, release_json);
+    if (release_status.IsError()) {
+      LOG(ERROR) << "Failed to release remote object: "
+                 << release_status.message();
+    }
+  }
+  return status;
+}
+
+Status WebViewImpl::GetPageSource(const std::string& frame,
+                                  std::unique_ptr<base::Value>* value) {
+  WebViewImpl* target = GetTargetForFrame(this, frame);
+  if (target != nullptr && target != this) {
+    if (target->IsDetached())
+      return Status(kTargetDetached);
+    WebViewImplHolder target_holder(target);
+    return target->GetPageSource(frame, value);
+  }
+
+  int context_id;
+  Status status = GetContextIdForFrame(this, frame, &context_id);
+  if (status.IsError())
+    return status;
+  bool found_node;
+  std::string object_id;
+  base::ListValue args;
+  status = internal::GetObjectIdFromFunction(
+      client_.get(), context_id, "() => document.documentElement", args,
+      &found_node, &object_id, w3c_compliant_);
+  if (status.IsError())
+    return status;
+  if (!found_node) {
+    // Pages like about:blank may not have a document element yet; the old
+    // script path returned an empty string for them.
+    *value = std::make_unique<base::Value>(std::string());
+    return Status(kOk);
+  }
+  base::DictionaryValue params;
+  params.SetString("objectId", object_id);
+  std::unique_ptr<base::DictionaryValue> result;
+  status =
+      client_->SendCommandAndGetResult("DOM.getOuterHTML", params, &result);
+  std::string source;
+  if (status.IsOk() && !result->GetString("outerHTML", &source))
+    status = Status(kUnknownError, "DOM.getOuterHTML missing 'outerHTML'");
+  {
+    // Release the remote object before doing anything else.
+    cdp::RuntimeReleaseObject release_params;
+    release_params.object_id = object_id;
+    std::string release_json;
+    release_params.WriteJson(&release_json);
+    Status release_status = client_->SendCommandSerialized(
+        cdp::RuntimeReleaseObject::kMethod, release_json);
+    if (release_status.IsError()) {
+      LOG(ERROR) << "Failed to release remote object: "
+                 << release_status.message();
+    }
+  }
+  if (status.IsError())
+    return status;
+  *value = std::make_unique<base::Value>(std::move(source));
+  return Status(kOk);
+}
+
+Status WebViewImpl::FindElementsByCssSelector(
+    const std::string& frame,
+    const std::string& selector,
+    const std::string* root_element_id,
+    bool only_one,
+    std::unique_ptr<base::Value>* value) {
+  WebViewImpl* target = GetTargetForFrame(this, frame);
+  if (target != nullptr && target != this) {
+    if (target->IsDetached())
+      return Status(kTargetDetached);
+    WebViewImplHolder target_holder(target);
+    return target->FindElementsByCssSelector(frame, selector, root_element_id,
+                                             only_one, value);
+  }
+
+  int context_id;
+  Status status = GetContextIdForFrame(this, frame, &context_id);
+  if (status.IsError())
+    return status;
+
+  // Locate the query root. The main document's node id comes straight off
+  // DOM.getDocument; a root element or an in-process subframe's document is
+  // only reachable through the execution context, so those take the
+  // object-id detour.
+  int root_node_id = 0;
+  if (root_element_id) {
+    base::ListValue args;
+    auto element_ref = std::make_unique<base::DictionaryValue>();
+    element_ref->SetString(w3c_compliant_ ? kElementKeyW3C : kElementKey,
+                           *root_element_id);
+    args.Append(std::move(element_ref));
+    bool found_node = false;
+    status = internal::GetNodeIdFromFunction(
+        client_.get(), context_id, "function(element) { return element; }",
+        args, &found_node, &root_node_id, w3c_compliant_);
+    if (status.IsError())
+      return status;
+    if (!found_node)
+      return Status(kNoSuchElement, "no node ID for find root element");
+  } else if (frame.empty() || frame == id_) {
+    base::DictionaryValue params;
+    params.SetInteger("depth", 0);
+    std::unique_ptr<base::DictionaryValue> cmd_result;
+    status = client_->SendCommandAndGetResult("DOM.getDocument", params,
+                                              &cmd_result);
+    if (status.IsError())
+      return status;
+    if (!cmd_result->GetInteger("root.nodeId", &root_node_id))
+      return Status(kUnknownError, "DOM.getDocument missing int 'root.nodeId'");
+  } else {
+    base::ListValue no_args;
+    bool found_node = false;
+    status = internal::GetNodeIdFromFunction(
+        client_.get(), context_id, "function() { return document; }", no_args,
+        &found_node, &root_node_id, w3c_compliant_);
+    if (status.IsError())
+      return status;
+    if (!found_node)
+      return Status(kUnknownError, "no node ID for frame document");
+  }
+
+  // Run the query in the browser's selector engine. An invalid selector
+  // surfaces as a command error here; the caller falls back to the find
+  // atom, which classifies it with the proper WebDriver status.
+  std::vector<int> node_ids;
+  {
+    base::DictionaryValue params;
+    params.SetInteger("nodeId", root_node_id);
+    params.SetString("selector", selector);
+    std::unique_ptr<base::DictionaryValue> cmd_result;
+    if (only_one) {
+      status = client_->SendCommandAndGetResult("DOM.querySelector", params,
+                                                &cmd_result);
+      if (status.IsError())
+        return status;
+      int node_id = 0;
+      if (!cmd_result->GetInteger("nodeId", &node_id))
+        return Status(kUnknownError, "DOM.querySelector missing int 'nodeId'");
+      // Node id 0 means no match.
+      if (node_id != 0)
+        node_ids.push_back(node_id);
+    } else {
+      status = client_->SendCommandAndGetResult("DOM.querySelectorAll", params,
+                                                &cmd_result);
+      if (status.IsError())
+        return status;
+      base::ListValue* id_list = nullptr;
+      if (!cmd_result->GetList("nodeIds", &id_list))
+        return Status(kUnknownError, "DOM.querySelectorAll missing 'nodeIds'");
+      for (const base::Value& id : id_list->GetList()) {
+        if (id.is_int())
+          node_ids.push_back(id.GetInt());
+      }
+    }
+  }
+
+  if (node_ids.empty()) {
+    // Mirror the find atom's miss results: null for a single find, an empty
+    // list for a multi find.
+    if (only_one)
+      *value = std::make_unique<base::Value>();
+    else
+      *value = std::make_unique<base::ListValue>();
+    return Status(kOk);
+  }
+
+  // Convert the compact node ids to remote object handles on one round trip.
+  std::vector<std::unique_ptr<base::DictionaryValue>> resolve_params;
+  std::vector<const base::DictionaryValue*> resolve_batch;
+  for (int node_id : node_ids) {
+    auto params = std::make_unique<base::DictionaryValue>();
+    params->SetInteger("nodeId", node_id);
+    params->SetInteger("executionContextId", context_id);
+    resolve_batch.push_back(params.get());
+    resolve_params.push_back(std::move(params));
+  }
+  std::vector<std::unique_ptr<base::DictionaryValue>> resolve_results;
+  status = client_->SendCommandBatch("DOM.resolveNode", resolve_batch,
+                                     &resolve_results);
+  if (status.IsError())
+    return status;
+  std::vector<std::string> object_ids;
+  for (const std::unique_ptr<base::DictionaryValue>& resolved :
+       resolve_results) {
+    std::string object_id;
+    if (!resolved || !resolved->GetString("object.objectId", &object_id))
+      return Status(kUnknownError, "DOM.resolveNode missing 'object.objectId'");
+    object_ids.push_back(object_id);
+  }
+
+  std::unique_ptr<base::Value> serialized;
+  status = internal::SerializeNodeHandles(client_.get(), context_id,
+                                          frame_tracker_.get(), object_ids,
+                                          w3c_compliant_, &serialized);
+  base::ListValue* element_list = nullptr;
+  if (status.IsOk() &&
+      (!serialized || !serialized->GetAsList(&element_list) ||
+       element_list->GetList().size() != object_ids.size())) {
+    status = Status(kUnknownError, "unexpected native find serialization");
+  }
+
+  // Seed the per-context element handle cache with a single find's result,
+  // so the follow-up command on the found element skips its resolve round
+  // trip. Multi finds release their handles instead of caching a whole match
+  // set, as does everything on the error path.
+  std::vector<std::unique_ptr<base::DictionaryValue>> release_params;
+  std::vector<const base::DictionaryValue*> release_batch;
+  for (size_t i = 0; i < object_ids.size(); ++i) {
+    bool cached = false;
+    if (status.IsOk() && only_one) {
+      base::DictionaryValue* element_dict = nullptr;
+      std::string element_id;
+      if (element_list->GetDictionary(i, &element_dict) &&
+          element_dict->GetString(
+              w3c_compliant_ ? kElementKeyW3C : kElementKey, &element_id)) {
+        frame_tracker_->CacheElementObjectId(context_id, element_id,
+                                             object_ids[i]);
+        cached = true;
+      }
+    }
+    if (!cached) {
+      auto params = std::make_unique<base::DictionaryValue>();
+      params->SetString("objectId", object_ids[i]);
+      release_batch.push_back(params.get());
+      release_params.push_back(std::move(params));
+    }
+  }
+  if (!release_batch.empty()) {
+    // Best effort: a failure only delays collection until the context dies.
+    std::vector<std::unique_ptr<base::DictionaryValue>> release_results;
+    client_->SendCommandBatch("Runtime.releaseObject", release_batch,
+                              &release_results);
+  }
+  if (status.IsError())
+    return status;
+
+  if (only_one)
+    *value = std::make_unique<base::Value>(std::move(element_list->GetList()[0]));
+  else
+    *value = std::move(serialized);
+  return Status(kOk);
+}
+
+Status WebViewImpl::CallFunctionInAllFrames(
+    const std::string& function,
+    const base::ListValue& args,
+    std::unique_ptr<base::Value>* result) {
+  std::string json;
+  base::JSONWriter::Write(args, &json);
+  std::string w3c = w3c_compliant_ ? "true" : "false";
+  // Splice with a pre-sized append rather than StringPrintf: the script
+  // constant is tens of KB and its length is known at compile time.
+  std::string expression;
+  expression.reserve(kCallFunctionScriptLen + function.size() + json.size() +
+                     w3c.size() + 32);
+  expression.append("(");
+  expression.append(kCallFunctionScript, kCallFunctionScriptLen);
+  expression.append(").apply(null, [");
+  expression.append(function);
+  expression.append(", ");
+  expression.append(json);
+  expression.append(", ");
+  expression.append(w3c);
+  expression.append("])");
+
+  std::vector<std::pair<std::string, int>> contexts;
+  frame_tracker_->GetAllFrameContexts(&contexts);
+  // The tracker's map is unordered; sort by frame id so repeated searches
+  // merge their per-frame results in a stable order.
+  std::sort(contexts.begin(), contexts.end());
+
+  // Pipeline one evaluation per context, so the search across N frames
+  // costs one round trip instead of N.
+  std::vector<std::unique_ptr<base::DictionaryValue>> params_batch;
+  std::vector<const base::DictionaryValue*> params_ptrs;
+  for (const auto& context : contexts) {
+    auto params = std::make_unique<base::DictionaryValue>();
+    params->SetString("expression", expression);
+    params->SetInteger("contextId", context.second);
+    params->SetBoolean("returnByValue", true);
+    params->SetBoolean("awaitPromise", true);
+    params_ptrs.push_back(params.get());
+    params_batch.push_back(std::move(params));
+  }
+  std::vector<std::unique_ptr<base::DictionaryValue>> responses;
+  Status status =
+      client_->SendCommandBatch("Runtime.evaluate", params_ptrs, &responses);
+  if (status.IsError())
+    return status;
+
+  auto frame_results = std::make_unique<base::ListValue>();
+  for (size_t i = 0; i < responses.size(); ++i) {
+    // Frames whose context went away mid-search, or whose evaluation
+    // threw, are omitted rather than failing the whole search.
+    if (!responses[i] || responses[i]->HasKey("exceptionDetails"))
+      continue;
+    base::Value* value;
+    if (!responses[i]->Get("result.value", &value))
+      continue;
+    auto entry = std::make_unique<base::DictionaryValue>();
+    entry->SetString("frame", contexts[i].first);
+    entry->SetKey("value", std::move(*value));
+    frame_results->Append(std::move(entry));
+  }
+  *result = std::move(frame_results);
+  return Status(kOk);
 }
 
 Status WebViewImpl::DispatchTouchEventsForMouseEvents(
@@ -545,11 +966,13 @@ Status WebViewImpl::DispatchTouchEventsForMouseEvents(
   // Touch events are filtered by the compositor if there are no touch listeners
   // on the page. Wait two frames for the compositor to sync with the main
   // thread to get consistent behavior.
-  base::DictionaryValue params;
-  params.SetString("expression",
-                   "new Promise(x => setTimeout(() => setTimeout(x, 20), 20))");
-  params.SetBoolean("awaitPromise", true);
-  client_->SendCommand("Runtime.evaluate", params);
+  cdp::RuntimeEvaluate evaluate_params;
+  evaluate_params.expression =
+      "new Promise(x => setTimeout(() => setTimeout(x, 20), 20))";
+  evaluate_params.await_promise = true;
+  std::string evaluate_json;
+  evaluate_params.WriteJson(&evaluate_json);
+  client_->SendCommandSerialized(cdp::RuntimeEvaluate::kMethod, evaluate_json);
   for (auto it = events.begin(); it != events.end(); ++it) {
     base::DictionaryValue params;
 
@@ -593,33 +1016,41 @@ Status WebViewImpl::DispatchMouseEvents(const std::vector<MouseEvent>& events,
     return DispatchTouchEventsForMouseEvents(events, frame);
 
   Status status(kOk);
+  std::string params_json;
   for (auto it = events.begin(); it != events.end(); ++it) {
-    base::DictionaryValue params;
+    cdp::InputDispatchMouseEvent params;
     std::string type = GetAsString(it->type);
-    params.SetString("type", type);
-    params.SetInteger("x", it->x);
-    params.SetInteger("y", it->y);
-    params.SetInteger("modifiers", it->modifiers);
-    params.SetString("button", GetAsString(it->button));
-    params.SetInteger("buttons", it->buttons);
-    params.SetInteger("clickCount", it->click_count);
-    params.SetDouble("force", it->force);
-    params.SetDouble("tangentialPressure", it->tangentialPressure);
-    params.SetInteger("tiltX", it->tiltX);
-    params.SetInteger("tiltY", it->tiltY);
-    params.SetInteger("twist", it->twist);
-    params.SetString("pointerType", GetAsString(it->pointer_type));
+    std::string button = GetAsString(it->button);
+    std::string pointer_type = GetAsString(it->pointer_type);
+    params.type = type;
+    params.x = it->x;
+    params.y = it->y;
+    params.modifiers = it->modifiers;
+    params.button = button;
+    params.buttons = it->buttons;
+    params.click_count = it->click_count;
+    params.force = it->force;
+    params.tangential_pressure = it->tangentialPressure;
+    params.tilt_x = it->tiltX;
+    params.tilt_y = it->tiltY;
+    params.twist = it->twist;
+    params.pointer_type = pointer_type;
+    if (it->timestamp >= 0)
+      params.timestamp = it->timestamp;
     if (type == "mouseWheel") {
-      params.SetInteger("deltaX", it->delta_x);
-      params.SetInteger("deltaY", it->delta_y);
+      params.delta_x = it->delta_x;
+      params.delta_y = it->delta_y;
     }
+    params_json.clear();
+    params.WriteJson(&params_json);
 
     const bool last_event = (it == events.end() - 1);
     if (async_dispatch_events || !last_event) {
-      status = client_->SendCommandAndIgnoreResponse("Input.dispatchMouseEvent",
-                                                     params);
+      status = client_->SendCommandSerializedAndIgnoreResponse(
+          cdp::InputDispatchMouseEvent::kMethod, params_json);
     } else {
-      status = client_->SendCommand("Input.dispatchMouseEvent", params);
+      status = client_->SendCommandSerialized(
+          cdp::InputDispatchMouseEvent::kMethod, params_json);
     }
 
     if (status.IsError())
@@ -672,9 +1103,13 @@ Status WebViewImpl::DispatchTouchEventWithMultiPoints(
   size_t touch_count = 1;
   for (const TouchEvent& event : events) {
     std::unique_ptr<base::ListValue> point_list(new base::ListValue);
-    int32_t current_time =
-        (base::Time::Now() - base::Time::UnixEpoch()).InMilliseconds();
-    params.SetInteger("timestamp", current_time);
+    if (event.timestamp >= 0) {
+      params.SetDouble("timestamp", event.timestamp);
+    } else {
+      int32_t current_time =
+          (base::Time::Now() - base::Time::UnixEpoch()).InMilliseconds();
+      params.SetInteger("timestamp", current_time);
+    }
     std::string type = GetAsString(event.type);
     params.SetString("type", type);
     if (type == "touchCancel")
@@ -700,19 +1135,20 @@ Status WebViewImpl::DispatchTouchEventWithMultiPoints(
 Status WebViewImpl::DispatchKeyEvents(const std::vector<KeyEvent>& events,
                                       bool async_dispatch_events) {
   Status status(kOk);
+  std::string params_json;
   for (auto it = events.begin(); it != events.end(); ++it) {
-    base::DictionaryValue params;
-    params.SetString("type", GetAsString(it->type));
+    cdp::InputDispatchKeyEvent params;
+    std::string type = GetAsString(it->type);
+    params.type = type;
     if (it->modifiers & kNumLockKeyModifierMask) {
-      params.SetBoolean("isKeypad", true);
-      params.SetInteger("modifiers",
-                        it->modifiers & ~kNumLockKeyModifierMask);
+      params.is_keypad = true;
+      params.modifiers = it->modifiers & ~kNumLockKeyModifierMask;
     } else {
-      params.SetInteger("modifiers", it->modifiers);
+      params.modifiers = it->modifiers;
     }
-    params.SetString("text", it->modified_text);
-    params.SetString("unmodifiedText", it->unmodified_text);
-    params.SetInteger("windowsVirtualKeyCode", it->key_code);
+    params.text = it->modified_text;
+    params.unmodified_text = it->unmodified_text;
+    params.windows_virtual_key_code = it->key_code;
     std::string code;
     if (it->is_from_action) {
       code = it->code;
@@ -730,11 +1166,11 @@ Status WebViewImpl::DispatchKeyEvents(const std::vector<KeyEvent>& events,
       is_ctrl_cmd_key_down = true;
 #endif
     if (!code.empty())
-      params.SetString("code", code);
+      params.code = code;
     if (!it->key.empty())
-      params.SetString("key", it->key);
+      params.key = it->key;
     else if (it->is_from_action)
-      params.SetString("key", it->modified_text);
+      params.key = it->modified_text;
 
     if (is_ctrl_cmd_key_down) {
       std::string command;
@@ -758,9 +1194,7 @@ Status WebViewImpl::DispatchKeyEvents(const std::vector<KeyEvent>& events,
           command = "Undo";
       }
 
-      std::unique_ptr<base::ListValue> command_list(new base::ListValue);
-      command_list->AppendString(command);
-      params.SetList("commands", std::move(command_list));
+      params.commands.push_back(command);
     }
 
     if (it->location != 0) {
@@ -768,17 +1202,23 @@ Status WebViewImpl::DispatchKeyEvents(const std::vector<KeyEvent>& events,
       // modifiers) and 2 (right modifiers). For location 3 (numeric keypad),
       // it is necessary to set the |isKeypad| parameter.
       if (it->location == 3)
-        params.SetBoolean("isKeypad", true);
+        params.is_keypad = true;
       else
-        params.SetInteger("location", it->location);
+        params.location = it->location;
     }
 
+    if (it->timestamp >= 0)
+      params.timestamp = it->timestamp;
+    params_json.clear();
+    params.WriteJson(&params_json);
+
     const bool last_event = (it == events.end() - 1);
     if (async_dispatch_events || !last_event) {
-      status = client_->SendCommandAndIgnoreResponse("Input.dispatchKeyEvent",
-                                                     params);
+      status = client_->SendCommandSerializedAndIgnoreResponse(
+          cdp::InputDispatchKeyEvent::kMethod, params_json);
     } else {
-      status = client_->SendCommand("Input.dispatchKeyEvent", params);
+      status = client_->SendCommandSerialized(
+          cdp::InputDispatchKeyEvent::kMethod, params_json);
     }
 
     if (status.IsError())
@@ -787,6 +1227,15 @@ Status WebViewImpl::DispatchKeyEvents(const std::vector<KeyEvent>& events,
   return status;
 }
 
+Status WebViewImpl::InsertText(const std::string& text) {
+  cdp::InputInsertText params;
+  params.text = text;
+  std::string params_json;
+  params.WriteJson(&params_json);
+  return client_->SendCommandSerialized(cdp::InputInsertText::kMethod,
+                                        params_json);
+}
+
 Status WebViewImpl::GetCookies(std::unique_ptr<base::ListValue>* cookies,
                                const std::string& current_page_url) {
   base::DictionaryValue params;
@@ -807,10 +1256,11 @@ Status WebViewImpl::GetCookies(std::unique_ptr<base::ListValue>* cookies,
       return status;
   }
 
-  base::ListValue* cookies_tmp;
-  if (!result->GetList("cookies", &cookies_tmp))
+  base::Optional<base::Value> cookies_tmp = result->ExtractKey("cookies");
+  if (!cookies_tmp || !cookies_tmp->is_list())
     return Status(kUnknownError, "DevTools didn't return cookies");
-  cookies->reset(cookies_tmp->DeepCopy());
+  *cookies = base::ListValue::From(
+      std::make_unique<base::Value>(std::move(*cookies_tmp)));
   return Status(kOk);
 }
 
@@ -828,6 +1278,15 @@ Status WebViewImpl::DeleteCookie(const std::string& name,
   return client_->SendCommand(command, params);
 }
 
+Status WebViewImpl::SetCookies(const base::ListValue& cookies) {
+  base::DictionaryValue params;
+  params.SetKey("cookies", cookies.Clone());
+  Status status = client_->SendCommand("Network.setCookies", params);
+  if (status.IsError())
+    return Status(kUnableToSetCookie, status.message());
+  return Status(kOk);
+}
+
 Status WebViewImpl::AddCookie(const std::string& name,
                               const std::string& url,
                               const std::string& value,
@@ -869,10 +1328,17 @@ Status WebViewImpl::WaitForPendingNavigations(const std::string& frame_id,
     return Status(kUnsupportedOperation,
                   "Call WaitForPendingNavigations only on the parent WebView");
   VLOG(0) << "Waiting for pending navigations...";
+  ScopedWaitSite wait_site("WebViewImpl::WaitForPendingNavigations");
   const auto not_pending_navigation = base::BindRepeating(
       &WebViewImpl::IsNotPendingNavigation, base::Unretained(this), frame_id,
       base::Unretained(&timeout));
-  Status status = client_->HandleEventsUntil(not_pending_navigation, timeout);
+  // Navigation state only changes on Page.* (load, lifecycle, frame and
+  // dialog events) and Inspector.* (crash) events; everything else received
+  // during the wait skips the pending-navigation check.
+  const std::vector<std::string> navigation_triggers = {"Page.", "Inspector."};
+  Status status =
+      client_->HandleEventsUntil(not_pending_navigation, navigation_triggers,
+                                 timeout);
   if (status.code() == kTimeout && stop_load_on_timeout) {
     VLOG(0) << "Timed out. Stopping navigation...";
     navigation_tracker_->set_timed_out(true);
@@ -882,7 +1348,7 @@ Status WebViewImpl::WaitForPendingNavigations(const std::string& frame_id,
     // that timed out.  Otherwise we might have to wait for that before
     // executing the next command, and it will be counted towards its timeout.
     Status new_status = client_->HandleEventsUntil(
-        not_pending_navigation,
+        not_pending_navigation, navigation_triggers,
         Timeout(base::TimeDelta::FromSeconds(kWaitForNavigationStopSeconds)));
     navigation_tracker_->set_timed_out(false);
     if (new_status.IsError())
@@ -905,6 +1371,10 @@ JavaScriptDialogManager* WebViewImpl::GetJavaScriptDialogManager() {
   return dialog_manager_.get();
 }
 
+AXNodeCache* WebViewImpl::GetAXNodeCache() {
+  return ax_node_cache_.get();
+}
+
 MobileEmulationOverrideManager* WebViewImpl::GetMobileEmulationOverrideManager()
     const {
   return mobile_emulation_override_manager_.get();
@@ -920,6 +1390,20 @@ Status WebViewImpl::OverrideNetworkConditions(
       network_conditions);
 }
 
+Status WebViewImpl::OverrideNetworkConditionsAsync(
+    const NetworkConditions& network_conditions) {
+  return network_conditions_override_manager_->OverrideNetworkConditionsAsync(
+      network_conditions);
+}
+
+Status WebViewImpl::CollectNetworkConditionsAck() {
+  return network_conditions_override_manager_->CollectOverrideAck();
+}
+
+Status WebViewImpl::RemoveNetworkConditionsOverride() {
+  return network_conditions_override_manager_->RemoveOverride();
+}
+
 Status WebViewImpl::OverrideDownloadDirectoryIfNeeded(
     const std::string& download_directory) {
   if (download_directory_override_manager_)
@@ -933,15 +1417,153 @@ Status WebViewImpl::CaptureScreenshot(
     const base::DictionaryValue& params) {
   std::unique_ptr<base::DictionaryValue> result;
   Timeout timeout(base::TimeDelta::FromSeconds(10));
-  Status status = client_->SendCommandAndGetResultWithTimeout(
-      "Page.captureScreenshot", params, &timeout, &result);
+  // Captured PNGs routinely run to tens of MB; route them over the bulk
+  // channel so interactive commands don't queue behind the response.
+  Status status =
+      client_->GetBulkTransferClient()->SendCommandAndGetResultWithTimeout(
+          "Page.captureScreenshot", params, &timeout, &result);
   if (status.IsError())
     return status;
-  if (!result->GetString("data", screenshot))
+  // Move the base64 data out of the result instead of copying it; captured
+  // PNGs routinely run to several MB.
+  std::string* data = result->FindStringKey("data");
+  if (!data)
     return Status(kUnknownError, "expected string 'data' in response");
+  *screenshot = std::move(*data);
+  return Status(kOk);
+}
+
+Status WebViewImpl::CaptureScreenshotAndGetFuture(
+    const base::DictionaryValue& params,
+    std::string* screenshot,
+    std::unique_ptr<DevToolsCommandFuture>* future) {
+  // Same bulk-channel routing as CaptureScreenshot; only the wait moves to
+  // the caller.
+  Status status =
+      client_->GetBulkTransferClient()->SendCommandAndGetFuture(
+          "Page.captureScreenshot", params, future);
+  if (status.IsError() || *future)
+    return status;
+  // The client ran the command synchronously and its response is gone; fall
+  // back to a full synchronous capture.
+  return CaptureScreenshot(screenshot, params);
+}
+
+Status WebViewImpl::CaptureScreenshotDelta(
+    int last_frame_id,
+    std::unique_ptr<base::DictionaryValue>* delta) {
+  if (!damage_tracker_)
+    damage_tracker_ = std::make_unique<DamageTracker>(client_.get());
+  Status status = damage_tracker_->EnsureTracking();
+  if (status.IsError())
+    return status;
+  // Drain paint events already sitting in the socket buffer; this issues no
+  // DevTools commands.
+  status = HandleReceivedEvents();
+  if (status.IsError())
+    return status;
+
+  auto result = std::make_unique<base::DictionaryValue>();
+  if (!damage_tracker_->has_baseline() ||
+      last_frame_id != damage_tracker_->frame_id()) {
+    // No common baseline with the client (first call, reconnect, or the
+    // client acknowledged a frame this tracker never produced): serve a
+    // full frame to resync.
+    std::string data;
+    base::DictionaryValue capture_params;
+    status = CaptureScreenshot(&data, capture_params);
+    if (status.IsError())
+      return status;
+    damage_tracker_->SetBaseline();
+    result->SetInteger("frameId", damage_tracker_->frame_id());
+    result->SetBoolean("full", true);
+    result->SetKey("data", base::Value(std::move(data)));
+    *delta = std::move(result);
+    return Status(kOk);
+  }
+
+  std::vector<DamageTracker::Rect> rects = damage_tracker_->TakeDamageRects();
+  // Issue all clipped captures before collecting any, as in
+  // CaptureScreenshotAndGetFuture; each costs only the damaged pixels.
+  std::vector<std::unique_ptr<DevToolsCommandFuture>> futures;
+  for (const DamageTracker::Rect& rect : rects) {
+    base::DictionaryValue capture_params;
+    capture_params.SetDouble("clip.x", rect.x);
+    capture_params.SetDouble("clip.y", rect.y);
+    capture_params.SetDouble("clip.width", rect.width);
+    capture_params.SetDouble("clip.height", rect.height);
+    capture_params.SetDouble("clip.scale", 1.0);
+    std::unique_ptr<DevToolsCommandFuture> future;
+    status = client_->GetBulkTransferClient()->SendCommandAndGetFuture(
+        "Page.captureScreenshot", capture_params, &future);
+    if (status.IsError())
+      return status;
+    futures.push_back(std::move(future));
+  }
+
+  auto rect_list = std::make_unique<base::ListValue>();
+  Timeout timeout(base::TimeDelta::FromSeconds(10));
+  for (size_t i = 0; i < rects.size(); ++i) {
+    std::string rect_data;
+    if (futures[i]) {
+      std::unique_ptr<base::DictionaryValue> capture;
+      status = futures[i]->Get(&timeout, &capture);
+      if (status.IsError())
+        return status;
+      std::string* data = capture->FindStringKey("data");
+      if (!data)
+        return Status(kUnknownError, "expected string 'data' in response");
+      rect_data = std::move(*data);
+    } else {
+      // No pipelining; the send above ran synchronously but its response is
+      // gone, so recapture this rect the slow way.
+      base::DictionaryValue capture_params;
+      capture_params.SetDouble("clip.x", rects[i].x);
+      capture_params.SetDouble("clip.y", rects[i].y);
+      capture_params.SetDouble("clip.width", rects[i].width);
+      capture_params.SetDouble("clip.height", rects[i].height);
+      capture_params.SetDouble("clip.scale", 1.0);
+      status = CaptureScreenshot(&rect_data, capture_params);
+      if (status.IsError())
+        return status;
+    }
+    auto entry = std::make_unique<base::DictionaryValue>();
+    entry->SetDouble("x", rects[i].x);
+    entry->SetDouble("y", rects[i].y);
+    entry->SetDouble("width", rects[i].width);
+    entry->SetDouble("height", rects[i].height);
+    entry->SetKey("data", base::Value(std::move(rect_data)));
+    rect_list->Append(std::move(entry));
+  }
+  result->SetInteger("frameId", damage_tracker_->frame_id());
+  result->Set("rects", std::move(rect_list));
+  *delta = std::move(result);
   return Status(kOk);
 }
 
+Status WebViewImpl::StartScreencast(const base::DictionaryValue& params) {
+  if (!screencast_tracker_)
+    screencast_tracker_ = std::make_unique<ScreencastTracker>(client_.get());
+  return screencast_tracker_->Start(params);
+}
+
+Status WebViewImpl::StopScreencast() {
+  if (!screencast_tracker_)
+    return Status(kOk);
+  return screencast_tracker_->Stop();
+}
+
+Status WebViewImpl::GetScreencastFrame(std::string* data, double* timestamp) {
+  if (!screencast_tracker_ || !screencast_tracker_->is_active())
+    return Status(kUnknownError, "screencast has not been started");
+  // Drain frames already sitting in the socket buffer; this issues no
+  // DevTools commands.
+  Status status = HandleReceivedEvents();
+  if (status.IsError())
+    return status;
+  return screencast_tracker_->GetLatestFrame(data, timestamp);
+}
+
 Status WebViewImpl::PrintToPDF(const base::DictionaryValue& params,
                                std::string* pdf) {
   // https://bugs.chromium.org/p/chromedriver/issues/detail?id=3517
@@ -951,7 +1573,8 @@ Status WebViewImpl::PrintToPDF(const base::DictionaryValue& params,
   }
   std::unique_ptr<base::DictionaryValue> result;
   Timeout timeout(base::TimeDelta::FromSeconds(10));
-  Status status = client_->SendCommandAndGetResultWithTimeout(
+  DevToolsClient* bulk_client = client_->GetBulkTransferClient();
+  Status status = bulk_client->SendCommandAndGetResultWithTimeout(
       "Page.printToPDF", params, &timeout, &result);
   if (status.IsError()) {
     if (status.code() == kUnknownError) {
@@ -959,8 +1582,68 @@ Status WebViewImpl::PrintToPDF(const base::DictionaryValue& params,
     }
     return status;
   }
-  if (!result->GetString("data", pdf))
+  std::string* stream_handle = result->FindStringKey("stream");
+  if (stream_handle)
+    return ReadStreamToString(bulk_client, *stream_handle, &timeout, pdf);
+  std::string* data = result->FindStringKey("data");
+  if (!data)
+    return Status(kUnknownError, "expected string 'data' in response");
+  *pdf = std::move(*data);
+  return Status(kOk);
+}
+
+Status WebViewImpl::CaptureSnapshot(std::string* mhtml) {
+  base::DictionaryValue params;
+  params.SetString("format", "mhtml");
+  std::unique_ptr<base::DictionaryValue> result;
+  // Serializing every frame and resource of a heavy page takes a while, so
+  // allow more than the PrintToPDF budget.
+  Timeout timeout(base::TimeDelta::FromSeconds(30));
+  // The archive arrives as one large DevTools message; route it over the
+  // bulk transfer client so it does not stall commands and events on the
+  // main connection.
+  Status status = client_->GetBulkTransferClient()
+      ->SendCommandAndGetResultWithTimeout("Page.captureSnapshot", params,
+                                           &timeout, &result);
+  if (status.IsError())
+    return status;
+  std::string* data = result->FindStringKey("data");
+  if (!data)
     return Status(kUnknownError, "expected string 'data' in response");
+  *mhtml = std::move(*data);
+  return Status(kOk);
+}
+
+Status WebViewImpl::ReadStreamToString(DevToolsClient* client,
+                                       const std::string& handle,
+                                       const Timeout* timeout,
+                                       std::string* data) {
+  // Chunks of a binary stream are base64-encoded individually by IO.read; a
+  // multiple-of-3 byte size keeps every full chunk's encoding free of
+  // padding, so the chunks concatenate into one valid base64 string without
+  // a decode and re-encode pass.
+  const int kChunkSizeBytes = 3 * 128 * 1024;
+  base::DictionaryValue read_params;
+  read_params.SetString("handle", handle);
+  read_params.SetInteger("size", kChunkSizeBytes);
+  bool eof = false;
+  while (!eof) {
+    std::unique_ptr<base::DictionaryValue> result;
+    Status status = client->SendCommandAndGetResultWithTimeout(
+        "IO.read", read_params, timeout, &result);
+    if (status.IsError())
+      return status;
+    std::string* chunk = result->FindStringKey("data");
+    if (!chunk)
+      return Status(kUnknownError, "expected string 'data' in IO.read response");
+    data->append(*chunk);
+    if (!result->GetBoolean("eof", &eof))
+      return Status(kUnknownError, "expected bool 'eof' in IO.read response");
+  }
+  base::DictionaryValue close_params;
+  close_params.SetString("handle", handle);
+  // Best effort; the browser releases the stream with the session anyway.
+  client->SendCommand("IO.close", close_params);
   return Status(kOk);
 }
 
@@ -1094,9 +1777,24 @@ Status WebViewImpl::SetFileInputFiles(const std::string& frame,
 }
 
 Status WebViewImpl::TakeHeapSnapshot(std::unique_ptr<base::Value>* snapshot) {
+  // Created lazily so the taker binds to the bulk channel, which only exists
+  // once someone asks for it; snapshot chunks arrive as events on the
+  // connection the command was sent on, keeping them off the primary socket.
+  if (!heap_snapshot_taker_) {
+    heap_snapshot_taker_ =
+        std::make_unique<HeapSnapshotTaker>(client_->GetBulkTransferClient());
+  }
   return heap_snapshot_taker_->TakeSnapshot(snapshot);
 }
 
+Status WebViewImpl::TakeHeapSnapshotToFile(base::FilePath* snapshot_path) {
+  if (!heap_snapshot_taker_) {
+    heap_snapshot_taker_ =
+        std::make_unique<HeapSnapshotTaker>(client_->GetBulkTransferClient());
+  }
+  return heap_snapshot_taker_->TakeSnapshotToFile(snapshot_path);
+}
+
 Status WebViewImpl::InitProfileInternal() {
   base::DictionaryValue params;
 
@@ -1163,7 +1861,8 @@ Status WebViewImpl::SynthesizeTapGesture(int x,
 Status WebViewImpl::SynthesizeScrollGesture(int x,
                                             int y,
                                             int xoffset,
-                                            int yoffset) {
+                                            int yoffset,
+                                            int speed) {
   base::DictionaryValue params;
   params.SetInteger("x", x);
   params.SetInteger("y", y);
@@ -1172,9 +1871,68 @@ Status WebViewImpl::SynthesizeScrollGesture(int x,
   // down, and a swipe left scrolls right).
   params.SetInteger("xDistance", -xoffset);
   params.SetInteger("yDistance", -yoffset);
+  if (speed > 0)
+    params.SetInteger("speed", speed);
   return client_->SendCommand("Input.synthesizeScrollGesture", params);
 }
 
+Status WebViewImpl::ScrollIntoViewIfNeeded(const std::string& frame,
+                                           const std::string& element_id,
+                                           const WebRect& region,
+                                           bool* scrolled) {
+  *scrolled = false;
+  WebViewImpl* target = GetTargetForFrame(this, frame);
+  if (target != nullptr && target != this) {
+    if (target->IsDetached())
+      return Status(kTargetDetached);
+    WebViewImplHolder target_holder(target);
+    return target->ScrollIntoViewIfNeeded(frame, element_id, region, scrolled);
+  }
+
+  int context_id;
+  Status status = GetContextIdForFrame(this, frame, &context_id);
+  if (status.IsError())
+    return status;
+  std::string object_id;
+  if (!frame_tracker_->GetCachedElementObjectId(context_id, element_id,
+                                                &object_id)) {
+    status = internal::ResolveElementReference(
+        client_.get(), context_id, frame_tracker_.get(), element_id,
+        w3c_compliant_, base::TimeDelta::Max(), &object_id);
+    if (status.IsError())
+      return status;
+    // An unresolvable reference is not an error here; the JS path reports
+    // staleness precisely.
+    if (object_id.empty())
+      return Status(kOk);
+    frame_tracker_->CacheElementObjectId(context_id, element_id, object_id);
+  }
+
+  base::DictionaryValue params;
+  params.SetString("objectId", object_id);
+  auto rect = std::make_unique<base::DictionaryValue>();
+  rect->SetInteger("x", region.X());
+  rect->SetInteger("y", region.Y());
+  rect->SetInteger("width", region.Width());
+  rect->SetInteger("height", region.Height());
+  params.Set("rect", std::move(rect));
+  status = client_->SendCommand("DOM.scrollIntoViewIfNeeded", params);
+  if (status.IsError()) {
+    if (status.message().find("Could not find object with given id") !=
+        std::string::npos) {
+      frame_tracker_->ClearCachedElementObjectIds(context_id);
+    }
+    // The command is best-effort: on command-level failures (missing in
+    // older browsers, nodes without layout objects, stale handles) leave
+    // |*scrolled| false and let the JS path produce the canonical result.
+    if (status.code() == kUnknownCommand || status.code() == kUnknownError)
+      return Status(kOk);
+    return status;
+  }
+  *scrolled = true;
+  return Status(kOk);
+}
+
 Status WebViewImpl::CallAsyncFunctionInternal(
     const std::string& frame,
     const std::string& function,
@@ -1241,8 +1999,15 @@ Status WebViewImpl::CallAsyncFunctionInternal(
     if (local_timeout.IsExpired())
       return Status(kTimeout);
 
-    base::PlatformThread::Sleep(
-        std::min(kOneHundredMs, local_timeout.GetRemainingTime()));
+    // Block on the DevTools socket so that any event (e.g. a navigation the
+    // script triggered finishing) wakes the loop immediately; the 100 ms tick
+    // is only a fallback re-query interval.
+    status = client_->HandleNextEvent(
+        Timeout(std::min(kOneHundredMs, local_timeout.GetRemainingTime())));
+    if (status.IsError()) {
+      base::PlatformThread::Sleep(
+          std::min(kOneHundredMs, local_timeout.GetRemainingTime()));
+    }
   }
 }
 
@@ -1284,6 +2049,16 @@ bool WebViewImpl::IsNonBlocking() const {
     return parent_->IsNonBlocking();
 }
 
+bool WebViewImpl::GetTrackedTopFrameUrl(std::string* url) {
+  if (!navigation_tracker_)
+    return false;
+  // Fold in navigation events already received, so the answer is as fresh
+  // as the connection.
+  if (client_->HandleReceivedEvents().IsError())
+    return false;
+  return navigation_tracker_->GetTrackedTopFrameUrl(url);
+}
+
 bool WebViewImpl::IsOOPIF(const std::string& frame_id) {
   WebView* target = GetTargetForFrame(this, frame_id);
   return target != nullptr && frame_id == target->GetId();
@@ -1324,7 +2099,7 @@ std::unique_ptr<base::Value> WebViewImpl::GetCastSinks() {
   if (!cast_tracker_)
     cast_tracker_ = std::make_unique<CastTracker>(client_.get());
   HandleReceivedEvents();
-  return std::unique_ptr<base::Value>(cast_tracker_->sinks().DeepCopy());
+  return cast_tracker_->GetSinksSnapshot();
 }
 
 std::unique_ptr<base::Value> WebViewImpl::GetCastIssueMessage() {
@@ -1386,12 +2161,8 @@ Status EvaluateScript(DevToolsClient* client,
   if (status.IsError())
     return status;
 
-  if (cmd_result->HasKey("exceptionDetails")) {
-    std::string description = "unknown";
-    cmd_result->GetString("result.description", &description);
-    return Status(kUnknownError,
-                  "Runtime.evaluate threw exception: " + description);
-  }
+  if (cmd_result->HasKey("exceptionDetails"))
+    return ParseCallFunctionException(*cmd_result, "Runtime.evaluate");
 
   base::DictionaryValue* unscoped_result;
   if (!cmd_result->GetDictionary("result", &unscoped_result))
@@ -1449,61 +2220,376 @@ Status EvaluateScriptAndGetValue(DevToolsClient* client,
   return Status(kOk);
 }
 
-Status ParseCallFunctionResult(const base::Value& temp_result,
-                               std::unique_ptr<base::Value>* result) {
-  const base::DictionaryValue* dict;
-  if (!temp_result.GetAsDictionary(&dict))
-    return Status(kUnknownError, "call function result must be a dictionary");
-  int status_code;
-  if (!dict->GetInteger("status", &status_code)) {
-    return Status(kUnknownError,
-                  "call function result missing int 'status'");
+Status ParseCallFunctionException(const base::DictionaryValue& cmd_result,
+                                  const std::string& method) {
+  // Failures raised by the callFunction wrapper arrive as a thrown
+  // "wd-status:<code>:<message>" string; see encodeError in
+  // js/call_function.js. The thrown value doubles as the command result.
+  const base::StringPiece kEncodedStatusPrefix("wd-status:");
+  std::string encoded;
+  if (cmd_result.GetString("result.value", &encoded) &&
+      base::StartsWith(encoded, kEncodedStatusPrefix,
+                       base::CompareCase::SENSITIVE)) {
+    std::string rest = encoded.substr(kEncodedStatusPrefix.size());
+    size_t separator = rest.find(':');
+    int code;
+    if (separator != std::string::npos &&
+        base::StringToInt(rest.substr(0, separator), &code)) {
+      return Status(static_cast<StatusCode>(code), rest.substr(separator + 1));
+    }
   }
-  if (status_code != kOk) {
-    std::string message;
-    dict->GetString("value", &message);
-    return Status(static_cast<StatusCode>(status_code), message);
+  std::string description = "unknown";
+  cmd_result.GetString("result.description", &description);
+  return Status(kUnknownError, method + " threw exception: " + description);
+}
+
+namespace {
+
+// Invoked via Runtime.callFunctionOn with the cached callFunction wrapper as
+// the target object, so |this| is the wrapper itself.
+const char kInvokeCachedFunctionScript[] =
+    "function(func, args, w3c) { return this.apply(null, [func, args, w3c]); }";
+
+// Variant taking the subject element as a remote object. The wrapper passes
+// it to callFunction as the bound element, which prepends it to the
+// deserialized arguments without a JS element-cache lookup.
+const char kInvokeCachedFunctionWithElementScript[] =
+    "function(func, elem, args, w3c) {"
+    " return this.apply(null, [func, args, w3c, undefined, elem]); }";
+
+// Installed per context to resolve element references; see
+// ResolveElementReference.
+const char kIdentityFunctionScript[] = "function(elem) { return elem; }";
+
+// Invokes callFunction with an unwrapped return, so a resolvable element
+// reference comes back as the node's own remote object.
+const char kResolveElementScript[] =
+    "function(func, args, w3c) {"
+    " return this.apply(null, [func, args, w3c, true]); }";
+
+// Serializes node handles passed as trailing remote-object arguments. The
+// nodes are handed to callFunction via a closure rather than the bound
+// element parameter, which only accepts a single node.
+const char kSerializeNodesScript[] =
+    "function(w3c) {"
+    " var nodes = Array.prototype.slice.call(arguments, 1);"
+    " return this.apply(null, [function() { return nodes; }, [], w3c]); }";
+
+// Returns the remote object id of |function| in the given context, evaluating
+// it there first if no handle is cached yet. The handle lives until the
+// context is destroyed, at which point FrameTracker drops the cache entry.
+Status GetOrInstallRemoteFunction(DevToolsClient* client,
+                                  int context_id,
+                                  FrameTracker* frame_tracker,
+                                  const std::string& function,
+                                  bool* was_cached,
+                                  std::string* object_id) {
+  if (frame_tracker->GetCachedRemoteFunction(context_id, function,
+                                             object_id)) {
+    *was_cached = true;
+    return Status(kOk);
+  }
+  *was_cached = false;
+  bool got_object = false;
+  Status status = EvaluateScriptAndGetObject(
+      client, context_id, "(" + function + ")", base::TimeDelta::Max(), false,
+      &got_object, object_id);
+  if (status.IsError())
+    return status;
+  if (!got_object)
+    return Status(kUnknownError, "function evaluation did not yield an object");
+  std::vector<std::string> evicted_object_ids;
+  frame_tracker->CacheRemoteFunction(context_id, function, *object_id,
+                                     &evicted_object_ids);
+  for (const std::string& evicted_id : evicted_object_ids) {
+    // Release displaced handles so the page can collect their functions.
+    // Best effort: a failure only delays collection until the context dies.
+    base::DictionaryValue release_params;
+    release_params.SetString("objectId", evicted_id);
+    client->SendCommand("Runtime.releaseObject", release_params);
+  }
+  return Status(kOk);
+}
+
+Status CallCachedFunctionOnce(DevToolsClient* client,
+                              int context_id,
+                              FrameTracker* frame_tracker,
+                              const std::string& function,
+                              const base::ListValue& args,
+                              const std::string& element_object_id,
+                              bool w3c_compliant,
+                              const base::TimeDelta& timeout,
+                              bool* used_cache,
+                              std::unique_ptr<base::Value>* result) {
+  bool call_function_cached = false;
+  bool function_cached = false;
+  std::string call_function_id;
+  std::string function_id;
+  Status status =
+      GetOrInstallRemoteFunction(client, context_id, frame_tracker,
+                                 kCallFunctionScript, &call_function_cached,
+                                 &call_function_id);
+  if (status.IsError())
+    return status;
+  status = GetOrInstallRemoteFunction(client, context_id, frame_tracker,
+                                      function, &function_cached,
+                                      &function_id);
+  if (status.IsError())
+    return status;
+  *used_cache = call_function_cached || function_cached;
+
+  base::DictionaryValue params;
+  params.SetString("functionDeclaration",
+                   element_object_id.empty()
+                       ? kInvokeCachedFunctionScript
+                       : kInvokeCachedFunctionWithElementScript);
+  params.SetString("objectId", call_function_id);
+  auto arguments = std::make_unique<base::ListValue>();
+  auto function_arg = std::make_unique<base::DictionaryValue>();
+  function_arg->SetString("objectId", function_id);
+  arguments->Append(std::move(function_arg));
+  if (!element_object_id.empty()) {
+    auto element_arg = std::make_unique<base::DictionaryValue>();
+    element_arg->SetString("objectId", element_object_id);
+    arguments->Append(std::move(element_arg));
   }
-  const base::Value* unscoped_value;
-  if (!dict->Get("value", &unscoped_value)) {
-    // Missing 'value' indicates the JavaScript code didn't return a value.
+  auto args_arg = std::make_unique<base::DictionaryValue>();
+  args_arg->SetKey("value", args.Clone());
+  arguments->Append(std::move(args_arg));
+  auto w3c_arg = std::make_unique<base::DictionaryValue>();
+  w3c_arg->SetBoolean("value", w3c_compliant);
+  arguments->Append(std::move(w3c_arg));
+  params.Set("arguments", std::move(arguments));
+  params.SetBoolean("returnByValue", true);
+  params.SetBoolean("awaitPromise", true);
+
+  std::unique_ptr<base::DictionaryValue> cmd_result;
+  Timeout local_timeout(timeout);
+  status = client->SendCommandAndGetResultWithTimeout(
+      "Runtime.callFunctionOn", params, &local_timeout, &cmd_result);
+  if (status.IsError())
+    return status;
+
+  if (cmd_result->HasKey("exceptionDetails"))
+    return ParseCallFunctionException(*cmd_result, "Runtime.callFunctionOn");
+
+  std::string type;
+  if (!cmd_result->GetString("result.type", &type))
+    return Status(kUnknownError, "Runtime.callFunctionOn missing 'type'");
+  if (type == "undefined") {
+    *result = std::make_unique<base::Value>();
     return Status(kOk);
   }
-  result->reset(unscoped_value->DeepCopy());
+  base::Value* value;
+  if (!cmd_result->Get("result.value", &value))
+    return Status(kUnknownError, "Runtime.callFunctionOn missing 'value'");
+  // The wrapper resolves to the serialized value itself, so it can be moved
+  // out of the parsed message instead of deep-copied from an envelope.
+  *result = std::make_unique<base::Value>(std::move(*value));
   return Status(kOk);
 }
 
-Status GetNodeIdFromFunction(DevToolsClient* client,
-                             int context_id,
-                             const std::string& function,
-                             const base::ListValue& args,
-                             bool* found_node,
-                             int* node_id,
-                             bool w3c_compliant) {
+}  // namespace
+
+Status CallCachedFunction(DevToolsClient* client,
+                          int context_id,
+                          FrameTracker* frame_tracker,
+                          const std::string& function,
+                          const base::ListValue& args,
+                          const std::string& element_object_id,
+                          bool w3c_compliant,
+                          const base::TimeDelta& timeout,
+                          std::unique_ptr<base::Value>* result) {
+  bool used_cache = false;
+  Status status =
+      CallCachedFunctionOnce(client, context_id, frame_tracker, function, args,
+                             element_object_id, w3c_compliant, timeout,
+                             &used_cache, result);
+  if (status.IsError() && used_cache &&
+      status.message().find("Could not find object with given id") !=
+          std::string::npos) {
+    // A cached handle went stale without the usual context destruction
+    // events. The failed call was rejected before executing anything, so
+    // reinstalling and retrying once is safe.
+    frame_tracker->ClearCachedRemoteFunctions(context_id);
+    status = CallCachedFunctionOnce(client, context_id, frame_tracker,
+                                    function, args, element_object_id,
+                                    w3c_compliant, timeout, &used_cache,
+                                    result);
+  }
+  return status;
+}
+
+Status ResolveElementReference(DevToolsClient* client,
+                               int context_id,
+                               FrameTracker* frame_tracker,
+                               const std::string& element_id,
+                               bool w3c_compliant,
+                               const base::TimeDelta& timeout,
+                               std::string* object_id) {
+  object_id->clear();
+  bool was_cached = false;
+  std::string call_function_id;
+  std::string identity_id;
+  Status status =
+      GetOrInstallRemoteFunction(client, context_id, frame_tracker,
+                                 kCallFunctionScript, &was_cached,
+                                 &call_function_id);
+  if (status.IsError())
+    return status;
+  status = GetOrInstallRemoteFunction(client, context_id, frame_tracker,
+                                      kIdentityFunctionScript, &was_cached,
+                                      &identity_id);
+  if (status.IsError())
+    return status;
+
+  base::DictionaryValue params;
+  params.SetString("functionDeclaration", kResolveElementScript);
+  params.SetString("objectId", call_function_id);
+  auto arguments = std::make_unique<base::ListValue>();
+  auto function_arg = std::make_unique<base::DictionaryValue>();
+  function_arg->SetString("objectId", identity_id);
+  arguments->Append(std::move(function_arg));
+  auto args_arg = std::make_unique<base::DictionaryValue>();
+  base::ListValue element_args;
+  auto element_ref = std::make_unique<base::DictionaryValue>();
+  element_ref->SetString(w3c_compliant ? kElementKeyW3C : kElementKey,
+                         element_id);
+  element_args.Append(std::move(element_ref));
+  args_arg->SetKey("value", std::move(element_args));
+  arguments->Append(std::move(args_arg));
+  auto w3c_arg = std::make_unique<base::DictionaryValue>();
+  w3c_arg->SetBoolean("value", w3c_compliant);
+  arguments->Append(std::move(w3c_arg));
+  params.Set("arguments", std::move(arguments));
+  params.SetBoolean("returnByValue", false);
+  params.SetBoolean("awaitPromise", true);
+
+  std::unique_ptr<base::DictionaryValue> cmd_result;
+  Timeout local_timeout(timeout);
+  status = client->SendCommandAndGetResultWithTimeout(
+      "Runtime.callFunctionOn", params, &local_timeout, &cmd_result);
+  if (status.IsError())
+    return status;
+  // An unresolvable reference (e.g. a stale element) yields the error
+  // object, not a node; leave |object_id| empty so the caller takes the
+  // element-cache path, which reports the precise failure.
+  if (cmd_result->HasKey("exceptionDetails"))
+    return Status(kOk);
+  std::string subtype;
+  if (!cmd_result->GetString("result.subtype", &subtype) || subtype != "node")
+    return Status(kOk);
+  cmd_result->GetString("result.objectId", object_id);
+  return Status(kOk);
+}
+
+Status SerializeNodeHandles(DevToolsClient* client,
+                            int context_id,
+                            FrameTracker* frame_tracker,
+                            const std::vector<std::string>& node_object_ids,
+                            bool w3c_compliant,
+                            std::unique_ptr<base::Value>* result) {
+  bool was_cached = false;
+  std::string call_function_id;
+  Status status =
+      GetOrInstallRemoteFunction(client, context_id, frame_tracker,
+                                 kCallFunctionScript, &was_cached,
+                                 &call_function_id);
+  if (status.IsError())
+    return status;
+
+  base::DictionaryValue params;
+  params.SetString("functionDeclaration", kSerializeNodesScript);
+  params.SetString("objectId", call_function_id);
+  auto arguments = std::make_unique<base::ListValue>();
+  auto w3c_arg = std::make_unique<base::DictionaryValue>();
+  w3c_arg->SetBoolean("value", w3c_compliant);
+  arguments->Append(std::move(w3c_arg));
+  for (const std::string& node_object_id : node_object_ids) {
+    auto node_arg = std::make_unique<base::DictionaryValue>();
+    node_arg->SetString("objectId", node_object_id);
+    arguments->Append(std::move(node_arg));
+  }
+  params.Set("arguments", std::move(arguments));
+  params.SetBoolean("returnByValue", true);
+  params.SetBoolean("awaitPromise", true);
+
+  std::unique_ptr<base::DictionaryValue> cmd_result;
+  status = client->SendCommandAndGetResult("Runtime.callFunctionOn", params,
+                                           &cmd_result);
+  if (status.IsError())
+    return status;
+  if (cmd_result->HasKey("exceptionDetails"))
+    return ParseCallFunctionException(*cmd_result, "Runtime.callFunctionOn");
+  base::Value* value;
+  if (!cmd_result->Get("result.value", &value))
+    return Status(kUnknownError, "Runtime.callFunctionOn missing 'value'");
+  *result = std::make_unique<base::Value>(std::move(*value));
+  return Status(kOk);
+}
+
+Status GetObjectIdFromFunction(DevToolsClient* client,
+                               int context_id,
+                               const std::string& function,
+                               const base::ListValue& args,
+                               bool* found_node,
+                               std::string* object_id,
+                               bool w3c_compliant) {
   std::string json;
   base::JSONWriter::Write(args, &json);
   std::string w3c = w3c_compliant ? "true" : "false";
   // TODO(zachconrad): Second null should be array of shadow host ids.
-  std::string expression = base::StringPrintf(
-      "(%s).apply(null, [%s, %s, %s, true])",
-      kCallFunctionScript,
-      function.c_str(),
-      json.c_str(),
-      w3c.c_str());
+  std::string expression;
+  expression.reserve(kCallFunctionScriptLen + function.size() + json.size() +
+                     w3c.size() + 32);
+  expression.append("(");
+  expression.append(kCallFunctionScript, kCallFunctionScriptLen);
+  expression.append(").apply(null, [");
+  expression.append(function);
+  expression.append(", ");
+  expression.append(json);
+  expression.append(", ");
+  expression.append(w3c);
+  expression.append(", true])");
 
   bool got_object;
-  std::string element_id;
   Status status = internal::EvaluateScriptAndGetObject(
       client, context_id, expression, base::TimeDelta::Max(), true, &got_object,
-      &element_id);
+      object_id);
   if (status.IsError())
     return status;
-  if (!got_object) {
-    *found_node = false;
+  *found_node = got_object;
+  return Status(kOk);
+}
+
+Status GetNodeIdFromFunction(DevToolsClient* client,
+                             int context_id,
+                             const std::string& function,
+                             const base::ListValue& args,
+                             bool* found_node,
+                             int* node_id,
+                             bool w3c_compliant) {
+  std::string element_id;
+  Status status = GetObjectIdFromFunction(client, context_id, function, args,
+                                          found_node, &element_id,
+                                          w3c_compliant);
+  if (status.IsError())
+    return status;
+  if (!*found_node)
     return Status(kOk);
-  }
 
   std::unique_ptr<base::DictionaryValue> cmd_result;
+  {
+    // DOM.requestNode can only push a node path once the DOM agent knows
+    // the document, and nothing requests it at connect time anymore, so
+    // ask for just the root node (depth 0) first. This also refreshes the
+    // root after a navigation.
+    base::DictionaryValue params;
+    params.SetInteger("depth", 0);
+    status = client->SendCommand("DOM.getDocument", params);
+    if (status.IsError())
+      return status;
+  }
   {
     base::DictionaryValue params;
     params.SetString("objectId", element_id);
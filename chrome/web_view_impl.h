@@ -19,8 +19,10 @@ class ListValue;
 class Value;
 }
 
+class AXNodeCache;
 struct BrowserInfo;
 struct DeviceMetrics;
+class DamageTracker;
 class DevToolsClient;
 class DomTracker;
 class DownloadDirectoryOverrideManager;
@@ -32,6 +34,7 @@ class HeapSnapshotTaker;
 struct KeyEvent;
 struct MouseEvent;
 class PageLoadStrategy;
+class ScreencastTracker;
 class Status;
 class CastTracker;
 
@@ -61,6 +64,7 @@ class WebViewImpl : public WebView {
   Status ConnectIfNecessary() override;
   Status SetUpDevTools() override;
   Status HandleReceivedEvents() override;
+  Status HandleNextEvent(const Timeout& timeout) override;
   Status GetUrl(std::string* url) override;
   Status Load(const std::string& url, const Timeout* timeout) override;
   Status Reload(const Timeout* timeout) override;
@@ -68,12 +72,19 @@ class WebViewImpl : public WebView {
   Status Resume(const Timeout* timeout) override;
   Status SendCommand(const std::string& cmd,
                      const base::DictionaryValue& params) override;
+  Status SendCommandAndIgnoreResponse(
+      const std::string& cmd,
+      const base::DictionaryValue& params) override;
   Status SendCommandFromWebSocket(const std::string& cmd,
                                   const base::DictionaryValue& params,
                                   const int client_cmd_id) override;
   Status SendCommandAndGetResult(const std::string& cmd,
                                  const base::DictionaryValue& params,
                                  std::unique_ptr<base::Value>* value) override;
+  Status SendCommandBatch(
+      const std::string& cmd,
+      const std::vector<const base::DictionaryValue*>& params_batch,
+      std::vector<std::unique_ptr<base::DictionaryValue>>* results) override;
   Status TraverseHistory(int delta, const Timeout* timeout) override;
   Status EvaluateScriptWithTimeout(const std::string& frame,
                                    const std::string& expression,
@@ -88,7 +99,7 @@ class WebViewImpl : public WebView {
                                  const std::string& function,
                                  const base::ListValue& args,
                                  const base::TimeDelta& timeout,
-                                 std::unique_ptr<base::Value>* result);
+                                 std::unique_ptr<base::Value>* result) override;
   Status CallFunction(const std::string& frame,
                       const std::string& function,
                       const base::ListValue& args,
@@ -112,6 +123,16 @@ class WebViewImpl : public WebView {
                             const std::string& function,
                             const base::ListValue& args,
                             std::string* out_frame) override;
+  Status GetPageSource(const std::string& frame,
+                       std::unique_ptr<base::Value>* value) override;
+  Status FindElementsByCssSelector(const std::string& frame,
+                                   const std::string& selector,
+                                   const std::string* root_element_id,
+                                   bool only_one,
+                                   std::unique_ptr<base::Value>* value) override;
+  Status CallFunctionInAllFrames(const std::string& function,
+                                 const base::ListValue& args,
+                                 std::unique_ptr<base::Value>* result) override;
   Status DispatchMouseEvents(const std::vector<MouseEvent>& events,
                              const std::string& frame,
                              bool async_dispatch_events = false) override;
@@ -124,12 +145,14 @@ class WebViewImpl : public WebView {
       bool async_dispatch_events = false) override;
   Status DispatchKeyEvents(const std::vector<KeyEvent>& events,
                            bool async_dispatch_events = false) override;
+  Status InsertText(const std::string& text) override;
   Status GetCookies(std::unique_ptr<base::ListValue>* cookies,
                     const std::string& current_page_url) override;
   Status DeleteCookie(const std::string& name,
                       const std::string& url,
                       const std::string& domain,
                       const std::string& path) override;
+  Status SetCookies(const base::ListValue& cookies) override;
   Status AddCookie(const std::string& name,
                    const std::string& url,
                    const std::string& value,
@@ -145,23 +168,40 @@ class WebViewImpl : public WebView {
   Status IsPendingNavigation(const Timeout* timeout,
                              bool* is_pending) const override;
   JavaScriptDialogManager* GetJavaScriptDialogManager() override;
+  AXNodeCache* GetAXNodeCache() override;
   MobileEmulationOverrideManager* GetMobileEmulationOverrideManager()
       const override;
   Status OverrideGeolocation(const Geoposition& geoposition) override;
   Status OverrideNetworkConditions(
       const NetworkConditions& network_conditions) override;
+  Status OverrideNetworkConditionsAsync(
+      const NetworkConditions& network_conditions) override;
+  Status CollectNetworkConditionsAck() override;
+  Status RemoveNetworkConditionsOverride() override;
   Status OverrideDownloadDirectoryIfNeeded(
       const std::string& download_directory) override;
   Status CaptureScreenshot(
       std::string* screenshot,
       const base::DictionaryValue& params) override;
+  Status CaptureScreenshotAndGetFuture(
+      const base::DictionaryValue& params,
+      std::string* screenshot,
+      std::unique_ptr<DevToolsCommandFuture>* future) override;
+  Status CaptureScreenshotDelta(
+      int last_frame_id,
+      std::unique_ptr<base::DictionaryValue>* delta) override;
+  Status StartScreencast(const base::DictionaryValue& params) override;
+  Status StopScreencast() override;
+  Status GetScreencastFrame(std::string* data, double* timestamp) override;
   Status PrintToPDF(const base::DictionaryValue& params,
                     std::string* pdf) override;
+  Status CaptureSnapshot(std::string* mhtml) override;
   Status SetFileInputFiles(const std::string& frame,
                            const base::DictionaryValue& element,
                            const std::vector<base::FilePath>& files,
                            const bool append) override;
   Status TakeHeapSnapshot(std::unique_ptr<base::Value>* snapshot) override;
+  Status TakeHeapSnapshotToFile(base::FilePath* snapshot_path) override;
   Status StartProfile() override;
   Status EndProfile(std::unique_ptr<base::Value>* profile_data) override;
   Status SynthesizeTapGesture(int x,
@@ -171,12 +211,18 @@ class WebViewImpl : public WebView {
   Status SynthesizeScrollGesture(int x,
                                  int y,
                                  int xoffset,
-                                 int yoffset) override;
+                                 int yoffset,
+                                 int speed) override;
+  Status ScrollIntoViewIfNeeded(const std::string& frame,
+                                const std::string& element_id,
+                                const WebRect& region,
+                                bool* scrolled) override;
   Status GetNodeIdByElement(const std::string& frame,
                             const base::DictionaryValue& element,
                             int* node_id) override;
 
   bool IsNonBlocking() const override;
+  bool GetTrackedTopFrameUrl(std::string* url) override;
   bool IsOOPIF(const std::string& frame_id) override;
   FrameTracker* GetFrameTracker() const override;
   std::unique_ptr<base::Value> GetCastSinks() override;
@@ -202,6 +248,17 @@ class WebViewImpl : public WebView {
                                 const Timeout* timeout,
                                 bool* is_not_pending);
 
+  // Drains a DevTools IO stream (e.g. from Page.printToPDF with
+  // transferMode ReturnAsStream) into |data| by pumping IO.read on
+  // |client|, which must be the client the stream handle was issued on.
+  // Chunking keeps each DevTools message small instead of carrying the
+  // whole document. Binary streams arrive base64-encoded and are appended
+  // as-is.
+  Status ReadStreamToString(DevToolsClient* client,
+                            const std::string& handle,
+                            const Timeout* timeout,
+                            std::string* data);
+
   Status InitProfileInternal();
   Status StopProfileInternal();
   Status DispatchTouchEventsForMouseEvents(
@@ -218,6 +275,7 @@ class WebViewImpl : public WebView {
   // Many trackers hold pointers to DevToolsClient, so client_ must be declared
   // before the trackers, to ensured trackers are destructed before client_.
   std::unique_ptr<DevToolsClient> client_;
+  std::unique_ptr<AXNodeCache> ax_node_cache_;
   std::unique_ptr<DomTracker> dom_tracker_;
   std::unique_ptr<FrameTracker> frame_tracker_;
   std::unique_ptr<JavaScriptDialogManager> dialog_manager_;
@@ -230,6 +288,8 @@ class WebViewImpl : public WebView {
   std::unique_ptr<DownloadDirectoryOverrideManager>
       download_directory_override_manager_;
   std::unique_ptr<HeapSnapshotTaker> heap_snapshot_taker_;
+  std::unique_ptr<ScreencastTracker> screencast_tracker_;
+  std::unique_ptr<DamageTracker> damage_tracker_;
   std::unique_ptr<CastTracker> cast_tracker_;
   bool is_service_worker_;
 };
@@ -277,8 +337,64 @@ Status EvaluateScriptAndGetValue(DevToolsClient* client,
                                  const base::TimeDelta& timeout,
                                  const bool awaitPromise,
                                  std::unique_ptr<base::Value>* result);
-Status ParseCallFunctionResult(const base::Value& temp_result,
-                               std::unique_ptr<base::Value>* result);
+// Converts a Runtime response carrying exceptionDetails into a Status. A
+// failure raised by the callFunction wrapper arrives as a thrown
+// "wd-status:<code>:<message>" string and keeps its WebDriver status code;
+// any other exception becomes an unknown error quoting |method| and the
+// exception description. Successful results need no parsing at all: the
+// wrapper resolves to the serialized value itself, with no envelope around
+// it, so callers move the value straight out of the parsed message.
+Status ParseCallFunctionException(const base::DictionaryValue& cmd_result,
+                                  const std::string& method);
+// Calls |function| with |args| in the given context. The function source and
+// the callFunction wrapper are installed once per execution context as remote
+// function objects (cached in |frame_tracker|) and invoked through
+// Runtime.callFunctionOn, so only the argument payload is shipped per call
+// instead of the multi-KB script text. A non-empty |element_object_id| is
+// passed as an extra remote-object argument and prepended to |args| in the
+// page, bypassing the JS element-cache lookup for the hot
+// element-as-first-argument pattern.
+Status CallCachedFunction(DevToolsClient* client,
+                          int context_id,
+                          FrameTracker* frame_tracker,
+                          const std::string& function,
+                          const base::ListValue& args,
+                          const std::string& element_object_id,
+                          bool w3c_compliant,
+                          const base::TimeDelta& timeout,
+                          std::unique_ptr<base::Value>* result);
+// Resolves the element with the given id to its remote object handle in the
+// given context. Leaves |object_id| empty, without error, when the reference
+// does not resolve to a node; callers then fall back to the element-cache
+// path, which reports the precise failure.
+Status ResolveElementReference(DevToolsClient* client,
+                               int context_id,
+                               FrameTracker* frame_tracker,
+                               const std::string& element_id,
+                               bool w3c_compliant,
+                               const base::TimeDelta& timeout,
+                               std::string* object_id);
+// Serializes already-resolved node handles into element references with a
+// single Runtime.callFunctionOn, routing them through the cached callFunction
+// wrapper so the nodes land in the page-side element cache exactly like a
+// find atom's results. |result| receives the list of references, in the
+// order of |node_object_ids|. The handles themselves are not released.
+Status SerializeNodeHandles(DevToolsClient* client,
+                            int context_id,
+                            FrameTracker* frame_tracker,
+                            const std::vector<std::string>& node_object_ids,
+                            bool w3c_compliant,
+                            std::unique_ptr<base::Value>* result);
+// Evaluates |function| with |args| and hands back the remote object handle
+// of the returned node, which the caller must release. |found_node| is
+// false if the function returned no object.
+Status GetObjectIdFromFunction(DevToolsClient* client,
+                               int context_id,
+                               const std::string& function,
+                               const base::ListValue& args,
+                               bool* found_node,
+                               std::string* object_id,
+                               bool w3c_compliant);
 Status GetNodeIdFromFunction(DevToolsClient* client,
                              int context_id,
                              const std::string& function,
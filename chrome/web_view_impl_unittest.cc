@@ -10,10 +10,12 @@
 
 #include "base/bind.h"
 #include "base/compiler_specific.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/time/time.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/browser_info.h"
 #include "chrome/test/chromedriver/chrome/devtools_client_impl.h"
+#include "chrome/test/chromedriver/chrome/frame_tracker.h"
 #include "chrome/test/chromedriver/chrome/page_load_strategy.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/stub_devtools_client.h"
@@ -172,32 +174,229 @@ TEST(EvaluateScriptAndGetObject, Ok) {
   ASSERT_STREQ("id", object_id.c_str());
 }
 
-TEST(ParseCallFunctionResult, NotDict) {
+TEST(ParseCallFunctionException, EncodedStatus) {
+  // The callFunction wrapper throws "wd-status:<code>:<message>" strings;
+  // the WebDriver status code must survive the round trip.
+  base::DictionaryValue dict;
+  dict.SetString("result.type", "string");
+  dict.SetString("result.value", "wd-status:10:element is not attached");
+  Status status =
+      internal::ParseCallFunctionException(dict, "Runtime.callFunctionOn");
+  ASSERT_EQ(kStaleElementReference, status.code());
+  ASSERT_NE(std::string::npos,
+            status.message().find("element is not attached"));
+}
+
+TEST(ParseCallFunctionException, PlainException) {
+  // Exceptions not in the encoded form surface as unknown errors quoting
+  // the description.
+  base::DictionaryValue dict;
+  dict.SetString("result.type", "object");
+  dict.SetString("result.description", "Error: boom");
+  Status status =
+      internal::ParseCallFunctionException(dict, "Runtime.callFunctionOn");
+  ASSERT_EQ(kUnknownError, status.code());
+  ASSERT_NE(std::string::npos, status.message().find("Error: boom"));
+}
+
+TEST(ParseCallFunctionException, MalformedEncoding) {
+  base::DictionaryValue dict;
+  dict.SetString("result.type", "string");
+  dict.SetString("result.value", "wd-status:nonsense");
+  Status status =
+      internal::ParseCallFunctionException(dict, "Runtime.callFunctionOn");
+  ASSERT_EQ(kUnknownError, status.code());
+}
+
+namespace {
+
+// Serves Runtime.evaluate with fresh remote object ids and
+// Runtime.callFunctionOn with a fixed value, counting each.
+class CachedCallDevToolsClient : public StubDevToolsClient {
+ public:
+  CachedCallDevToolsClient() : evaluate_count_(0), call_function_on_count_(0) {}
+  ~CachedCallDevToolsClient() override = default;
+
+  int evaluate_count() const { return evaluate_count_; }
+  int call_function_on_count() const { return call_function_on_count_; }
+  void set_fail_next_call(const Status& status) { next_call_status_ = status; }
+  void set_serve_node_result(bool serve) { serve_node_result_ = serve; }
+  const base::DictionaryValue& last_call_params() const {
+    return last_call_params_;
+  }
+
+  // Overridden from DevToolsClient:
+  Status SendCommandAndGetResult(
+      const std::string& method,
+      const base::DictionaryValue& params,
+      std::unique_ptr<base::DictionaryValue>* result) override {
+    auto dict = std::make_unique<base::DictionaryValue>();
+    if (method == "Runtime.evaluate") {
+      evaluate_count_++;
+      dict->SetString("result.type", "function");
+      dict->SetString("result.objectId",
+                      "obj" + base::NumberToString(evaluate_count_));
+    } else if (method == "Runtime.callFunctionOn") {
+      call_function_on_count_++;
+      last_call_params_.Clear();
+      last_call_params_.MergeDictionary(&params);
+      if (next_call_status_.IsError()) {
+        Status status = next_call_status_;
+        next_call_status_ = Status(kOk);
+        return status;
+      }
+      if (serve_node_result_) {
+        dict->SetString("result.type", "object");
+        dict->SetString("result.subtype", "node");
+        dict->SetString("result.objectId", "nodeobj");
+      } else {
+        dict->SetString("result.type", "string");
+        dict->SetString("result.value", "ok");
+      }
+    }
+    *result = std::move(dict);
+    return Status(kOk);
+  }
+
+ private:
+  int evaluate_count_;
+  int call_function_on_count_;
+  Status next_call_status_ = Status(kOk);
+  bool serve_node_result_ = false;
+  base::DictionaryValue last_call_params_;
+};
+
+}  // namespace
+
+TEST(CallCachedFunction, InstallsFunctionsOncePerContext) {
+  CachedCallDevToolsClient client;
+  FrameTracker tracker(&client);
+  base::ListValue args;
   std::unique_ptr<base::Value> result;
-  base::Value value(1);
-  ASSERT_NE(kOk, internal::ParseCallFunctionResult(value, &result).code());
+  ASSERT_EQ(kOk, internal::CallCachedFunction(
+                     &client, 1, &tracker, "function() {}", args,
+                     std::string(), true, base::TimeDelta::Max(), &result)
+                     .code());
+  // One evaluate for the callFunction wrapper, one for the function itself.
+  ASSERT_EQ(2, client.evaluate_count());
+  ASSERT_EQ(1, client.call_function_on_count());
+  std::string value;
+  ASSERT_TRUE(result->GetAsString(&value));
+  ASSERT_EQ("ok", value);
+
+  result.reset();
+  ASSERT_EQ(kOk, internal::CallCachedFunction(
+                     &client, 1, &tracker, "function() {}", args,
+                     std::string(), true, base::TimeDelta::Max(), &result)
+                     .code());
+  // Both functions are served from the cache on the second call.
+  ASSERT_EQ(2, client.evaluate_count());
+  ASSERT_EQ(2, client.call_function_on_count());
+
+  // A different context gets its own installation.
+  ASSERT_EQ(kOk, internal::CallCachedFunction(
+                     &client, 2, &tracker, "function() {}", args,
+                     std::string(), true, base::TimeDelta::Max(), &result)
+                     .code());
+  ASSERT_EQ(4, client.evaluate_count());
 }
 
-TEST(ParseCallFunctionResult, Ok) {
+TEST(CallCachedFunction, ReinstallsOnStaleObjectId) {
+  CachedCallDevToolsClient client;
+  FrameTracker tracker(&client);
+  base::ListValue args;
   std::unique_ptr<base::Value> result;
-  base::DictionaryValue dict;
-  dict.SetInteger("status", 0);
-  dict.SetInteger("value", 1);
-  Status status = internal::ParseCallFunctionResult(dict, &result);
-  ASSERT_EQ(kOk, status.code());
-  int value;
-  ASSERT_TRUE(result && result->GetAsInteger(&value));
-  ASSERT_EQ(1, value);
+  ASSERT_EQ(kOk, internal::CallCachedFunction(
+                     &client, 1, &tracker, "function() {}", args,
+                     std::string(), true, base::TimeDelta::Max(), &result)
+                     .code());
+  ASSERT_EQ(2, client.evaluate_count());
+
+  client.set_fail_next_call(Status(
+      kUnknownError,
+      "unhandled inspector error: Could not find object with given id"));
+  result.reset();
+  ASSERT_EQ(kOk, internal::CallCachedFunction(
+                     &client, 1, &tracker, "function() {}", args,
+                     std::string(), true, base::TimeDelta::Max(), &result)
+                     .code());
+  // The stale handles were dropped and both functions reinstalled.
+  ASSERT_EQ(4, client.evaluate_count());
+  ASSERT_EQ(3, client.call_function_on_count());
 }
 
-TEST(ParseCallFunctionResult, ScriptError) {
+TEST(CallCachedFunction, PassesElementHandleArgument) {
+  CachedCallDevToolsClient client;
+  FrameTracker tracker(&client);
+  base::ListValue args;
   std::unique_ptr<base::Value> result;
-  base::DictionaryValue dict;
-  dict.SetInteger("status", 1);
-  dict.SetInteger("value", 1);
-  Status status = internal::ParseCallFunctionResult(dict, &result);
-  ASSERT_EQ(1, status.code());
-  ASSERT_FALSE(result);
+  ASSERT_EQ(kOk, internal::CallCachedFunction(
+                     &client, 1, &tracker, "function() {}", args, "elemobj",
+                     true, base::TimeDelta::Max(), &result)
+                     .code());
+  // The element handle rides along as the second remote argument, between
+  // the function handle and the serialized argument list.
+  const base::ListValue* arguments;
+  ASSERT_TRUE(client.last_call_params().GetList("arguments", &arguments));
+  ASSERT_EQ(4u, arguments->GetList().size());
+  const std::string* element_object_id =
+      arguments->GetList()[1].FindStringKey("objectId");
+  ASSERT_TRUE(element_object_id);
+  ASSERT_EQ("elemobj", *element_object_id);
+}
+
+TEST(ResolveElementReference, ResolvesToNodeHandle) {
+  CachedCallDevToolsClient client;
+  FrameTracker tracker(&client);
+  client.set_serve_node_result(true);
+  std::string object_id;
+  ASSERT_EQ(kOk, internal::ResolveElementReference(
+                     &client, 1, &tracker, "some-element-id", true,
+                     base::TimeDelta::Max(), &object_id)
+                     .code());
+  ASSERT_EQ("nodeobj", object_id);
+  // One evaluate for the callFunction wrapper, one for the identity helper.
+  ASSERT_EQ(2, client.evaluate_count());
+}
+
+TEST(ResolveElementReference, NonNodeResultYieldsEmptyHandle) {
+  CachedCallDevToolsClient client;
+  FrameTracker tracker(&client);
+  std::string object_id;
+  ASSERT_EQ(kOk, internal::ResolveElementReference(
+                     &client, 1, &tracker, "some-element-id", true,
+                     base::TimeDelta::Max(), &object_id)
+                     .code());
+  ASSERT_TRUE(object_id.empty());
+}
+
+TEST(SerializeNodeHandles, PassesHandlesAsTrailingArguments) {
+  CachedCallDevToolsClient client;
+  FrameTracker tracker(&client);
+  std::vector<std::string> node_object_ids = {"nodeobj1", "nodeobj2"};
+  std::unique_ptr<base::Value> result;
+  ASSERT_EQ(kOk, internal::SerializeNodeHandles(&client, 1, &tracker,
+                                                node_object_ids, true, &result)
+                     .code());
+  // Only the callFunction wrapper needs installing.
+  ASSERT_EQ(1, client.evaluate_count());
+  ASSERT_EQ(1, client.call_function_on_count());
+  // The w3c flag leads, followed by one remote argument per node handle.
+  const base::ListValue* arguments;
+  ASSERT_TRUE(client.last_call_params().GetList("arguments", &arguments));
+  ASSERT_EQ(3u, arguments->GetList().size());
+  ASSERT_TRUE(arguments->GetList()[0].FindBoolKey("value").value_or(false));
+  const std::string* first_handle =
+      arguments->GetList()[1].FindStringKey("objectId");
+  ASSERT_TRUE(first_handle);
+  ASSERT_EQ("nodeobj1", *first_handle);
+  const std::string* second_handle =
+      arguments->GetList()[2].FindStringKey("objectId");
+  ASSERT_TRUE(second_handle);
+  ASSERT_EQ("nodeobj2", *second_handle);
+  std::string value;
+  ASSERT_TRUE(result->GetAsString(&value));
+  ASSERT_EQ("ok", value);
 }
 
 namespace {
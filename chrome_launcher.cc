@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -18,6 +19,7 @@
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/files/scoped_file.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/format_macros.h"
 #include "base/json/json_reader.h"
 #include "base/json/json_writer.h"
@@ -31,6 +33,10 @@
 #include "base/strings/stringprintf.h"
 #include "base/strings/sys_string_conversions.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task/thread_pool.h"
+#include "base/task/thread_pool/thread_pool_instance.h"
 #include "base/threading/platform_thread.h"
 #include "base/time/time.h"
 #include "base/values.h"
@@ -47,6 +53,7 @@
 #include "chrome/test/chromedriver/chrome/devtools_client_impl.h"
 #include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
 #include "chrome/test/chromedriver/chrome/devtools_http_client.h"
+#include "chrome/test/chromedriver/chrome/remote_browser_registry.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/user_data_dir.h"
 #include "chrome/test/chromedriver/chrome/web_view.h"
@@ -54,12 +61,15 @@
 #include "chrome/test/chromedriver/log_replay/chrome_replay_impl.h"
 #include "chrome/test/chromedriver/log_replay/replay_http_client.h"
 #include "chrome/test/chromedriver/net/net_util.h"
+#include "chrome/test/chromedriver/net/sync_websocket_pool.h"
+#include "chrome/test/chromedriver/net/timeout.h"
+#include "chrome/test/chromedriver/numa_policy.h"
+#include "chrome/test/chromedriver/util.h"
 #include "components/crx_file/crx_verifier.h"
 #include "components/embedder_support/switches.h"
 #include "crypto/rsa_private_key.h"
 #include "crypto/sha2.h"
 #include "services/network/public/mojom/url_loader_factory.mojom.h"
-#include "third_party/zlib/google/zip.h"
 #include "url/gurl.h"
 
 #if defined(OS_POSIX)
@@ -67,6 +77,13 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+
+#include "base/posix/eintr_wrapper.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
 #elif defined(OS_WIN)
 #include "chrome/test/chromedriver/keycode_text_conversion.h"
 #endif
@@ -124,6 +141,19 @@ const int kReadFD = 3;
 const int kWriteFD = 4;
 #endif
 
+// Runs internal::PrepareUserDataDir on a worker so it can overlap with
+// extension unpacking, reporting through |status| and signaling |done|.
+// The pointers must stay valid until |done| is signaled.
+void RunPrepareUserDataDir(const base::FilePath& user_data_dir,
+                           const base::DictionaryValue* custom_prefs,
+                           const base::DictionaryValue* custom_local_state,
+                           Status* status,
+                           base::WaitableEvent* done) {
+  *status = internal::PrepareUserDataDir(user_data_dir, custom_prefs,
+                                         custom_local_state);
+  done->Signal();
+}
+
 Status PrepareDesktopCommandLine(const Capabilities& capabilities,
                                  bool enable_chrome_logs,
                                  base::CommandLine* prepared_command,
@@ -181,6 +211,11 @@ Status PrepareDesktopCommandLine(const Capabilities& capabilities,
   switches.SetFromSwitches(capabilities.switches);
   if (!switches.HasSwitch("remote-debugging-port") &&
       !switches.HasSwitch("remote-debugging-pipe")) {
+    // Port 0 lets the kernel assign a free ephemeral port, which the browser
+    // reports back through the DevToolsActivePort file; LaunchDesktopChrome
+    // reads it from there. This means parallel launches never collide on a
+    // port and no pre-scan or spawn retry is needed. Callers who pass a fixed
+    // remote-debugging-port opt back into collision risk.
     switches.SetSwitch("remote-debugging-port", "0");
   }
   if (capabilities.exclude_switches.count("user-data-dir") > 0) {
@@ -204,27 +239,46 @@ Status PrepareDesktopCommandLine(const Capabilities& capabilities,
     *user_data_dir = user_data_dir_temp_dir->GetPath();
   }
 
-  Status status = internal::PrepareUserDataDir(
-      *user_data_dir, capabilities.prefs.get(), capabilities.local_state.get());
-  if (status.IsError())
-    return status;
+  // Prefs writing and extension unpacking are independent disk work (the
+  // former fills |user_data_dir|, the latter |extension_dir| and the
+  // load-extension switch), and together they dominate the pre-spawn part of
+  // launch. Overlap them: prefs go to a worker while extensions are unpacked
+  // here, since ProcessExtensions must finish before switch serialization.
+  Status prefs_status(kOk);
+  base::WaitableEvent prefs_done;
+  if (base::ThreadPoolInstance::Get()) {
+    base::ThreadPool::PostTask(
+        FROM_HERE, {base::MayBlock()},
+        base::BindOnce(&RunPrepareUserDataDir, *user_data_dir,
+                       capabilities.prefs.get(), capabilities.local_state.get(),
+                       &prefs_status, &prefs_done));
+  } else {
+    // Without a thread pool (e.g. in unit tests), prepare on this thread.
+    RunPrepareUserDataDir(*user_data_dir, capabilities.prefs.get(),
+                          capabilities.local_state.get(), &prefs_status,
+                          &prefs_done);
+  }
 
+  Status status(kOk);
   if (capabilities.exclude_switches.count("load-extension") > 0) {
     if (capabilities.extensions.size() > 0)
-      return Status(
+      status = Status(
           kUnknownError,
           "cannot exclude load-extension switch when extensions are specified");
-  } else {
-    if (!extension_dir->CreateUniqueTempDir()) {
-      return Status(kUnknownError,
+  } else if (!extension_dir->CreateUniqueTempDir()) {
+    status = Status(kUnknownError,
                     "cannot create temp dir for unpacking extensions");
-    }
+  } else {
     status = internal::ProcessExtensions(capabilities.extensions,
                                          extension_dir->GetPath(), &switches,
                                          extension_bg_pages);
-    if (status.IsError())
-      return status;
   }
+  // Join before any return; the worker writes to stack locals.
+  prefs_done.Wait();
+  if (status.IsError())
+    return status;
+  if (prefs_status.IsError())
+    return prefs_status;
   switches.AppendToCommandLine(&command);
   *prepared_command = command;
   return Status(kOk);
@@ -270,12 +324,28 @@ Status WaitForDevToolsAndCheckVersion(
         std::move(window_types), capabilities->page_load_strategy);
   }
 
+  // Attaching to an already-running browser repeats the same handshake for
+  // every session, so reuse the verdict an earlier session reached for this
+  // endpoint. Replay runs must go through their log instead.
+  bool used_cached_info = false;
+  if (ct == ChromeType::Remote && !cmd_line->HasSwitch("devtools-replay")) {
+    BrowserInfo cached_info;
+    if (RemoteBrowserRegistry::GetInstance()->FindBrowserInfo(endpoint,
+                                                              &cached_info)) {
+      client->SetCachedBrowserInfo(cached_info);
+      used_cached_info = true;
+    }
+  }
+
   const base::TimeTicks initial = base::TimeTicks::Now();
   const base::TimeTicks deadline =
       initial + base::TimeDelta::FromSeconds(wait_time);
-  Status status = client->Init(deadline - initial);
-  if (status.IsError())
-    return status;
+  Status status(kOk);
+  if (!used_cached_info) {
+    status = client->Init(deadline - initial);
+    if (status.IsError())
+      return status;
+  }
 
   const BrowserInfo* browser_info = client->browser_info();
   if (browser_info->is_android &&
@@ -287,7 +357,10 @@ Status WaitForDevToolsAndCheckVersion(
   }
 
   *retry = true;
-  if (cmd_line->HasSwitch("disable-build-check")) {
+  if (used_cached_info) {
+    // The version check below already passed when the endpoint was
+    // registered; re-running it would only repeat its warnings.
+  } else if (cmd_line->HasSwitch("disable-build-check")) {
     LOG(WARNING) << "You are using an unsupported command-line switch: "
                     "--disable-build-check. Please don't report bugs that "
                     "cannot be reproduced with this switch removed.";
@@ -322,19 +395,42 @@ Status WaitForDevToolsAndCheckVersion(
   }
 
   // Always try GetWebViewsInfo at least once if the client
-  // initialized successfully.
+  // initialized successfully. Back the poll interval off exponentially so
+  // pages that appear quickly are discovered within a few milliseconds.
+  base::TimeDelta poll_interval = base::TimeDelta::FromMilliseconds(5);
   do {
     WebViewsInfo views_info;
     status = client->GetWebViewsInfo(&views_info);
-    if (status.IsError())
+    if (status.IsError()) {
+      if (used_cached_info) {
+        // The entry may describe a browser that has since gone away; make
+        // the next session re-verify from scratch.
+        RemoteBrowserRegistry::GetInstance()->Invalidate(endpoint);
+      }
       return status;
+    }
     for (size_t i = 0; i < views_info.GetSize(); ++i) {
       if (views_info.Get(i).type == WebViewInfo::kPage) {
+        if (ct == ChromeType::Remote && !used_cached_info &&
+            !cmd_line->HasSwitch("devtools-replay")) {
+          RemoteBrowserRegistry::GetInstance()->RegisterBrowserInfo(
+              endpoint, *client->browser_info());
+        }
+        if (!cmd_line->HasSwitch("devtools-replay")) {
+          // Park spare connections to the browser endpoint so the first root
+          // dials (the browser-wide client, the first bulk-transfer channel)
+          // skip the WebSocket handshake. Replay sockets follow a log and
+          // must not be shared across clients.
+          SyncWebSocketPool::GetInstance()->Prewarm(
+              socket_factory, endpoint.GetBrowserDebuggerUrl(), 2);
+        }
         *user_client = std::move(client);
         return Status(kOk);
       }
     }
-    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(50));
+    base::PlatformThread::Sleep(poll_interval);
+    poll_interval =
+        std::min(poll_interval * 2, base::TimeDelta::FromMilliseconds(50));
   } while (base::TimeTicks::Now() < deadline);
 
   return Status(kUnknownError, "unable to discover open pages");
@@ -566,6 +662,11 @@ Status LaunchDesktopChrome(network::mojom::URLLoaderFactory* factory,
         kUnknownError,
         base::StringPrintf("Failed to create %s process.", kBrowserShortName));
 
+  // Keep the browser on the same NUMA node as the session thread this runs
+  // on, so DevTools traffic stays on one node. A no-op unless --numa-policy
+  // pinned the session thread.
+  PinProcessToNumaNode(process.Pid(), CurrentThreadNumaNode());
+
   // Attempt to connect to devtools in order to send commands to Chrome. If
   // attempts fail, check if Chrome has crashed and return error.
   std::unique_ptr<DevToolsHttpClient> devtools_http_client;
@@ -574,10 +675,14 @@ Status LaunchDesktopChrome(network::mojom::URLLoaderFactory* factory,
       base::TERMINATION_STATUS_STILL_RUNNING;
   base::TimeTicks deadline =
       base::TimeTicks::Now() + base::TimeDelta::FromSeconds(60);
+  base::TimeDelta poll_interval = base::TimeDelta::FromMilliseconds(5);
+  internal::DevToolsActivePortWatcher port_watcher(user_data_dir);
   while (base::TimeTicks::Now() < deadline) {
     if (!devtools_port) {
-      status =
-          internal::ParseDevToolsActivePortFile(user_data_dir, &devtools_port);
+      // Block until Chrome writes DevToolsActivePort or the slice elapses;
+      // the slice bounds how long a crashed browser goes unnoticed below.
+      status = port_watcher.WaitForPortFile(
+          base::TimeDelta::FromMilliseconds(250), &devtools_port);
     } else {
       status = Status(kOk);
     }
@@ -636,7 +741,13 @@ Status LaunchDesktopChrome(network::mojom::URLLoaderFactory* factory,
           kChromeDriverProductShortName, kBrowserShortName));
       return failure_status;
     }
-    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(50));
+    // When the port is still unknown the iteration already blocked inside
+    // WaitForPortFile; only pace retries of the version check.
+    if (devtools_port) {
+      base::PlatformThread::Sleep(poll_interval);
+      poll_interval =
+          std::min(poll_interval * 2, base::TimeDelta::FromMilliseconds(50));
+    }
   }
 
   if (status.IsError()) {
@@ -902,10 +1013,41 @@ Status GetExtensionBackgroundPage(const base::DictionaryValue* manifest,
   return Status(kOk);
 }
 
+// Extensions already processed by this process, keyed by their base64
+// payload from the capabilities. Entries are unpacked under a
+// process-lifetime temp dir and shared read-only by every session that loads
+// the same extension, so the base64 decode, CRX verification, key generation
+// and unzipping happen once per distinct extension rather than per session.
+struct ProcessedExtensionsCache {
+  struct Entry {
+    base::FilePath dir;
+    std::string bg_page;
+  };
+  base::Lock lock;
+  base::ScopedTempDir root_dir;
+  std::map<std::string, Entry> entries;
+};
+
+ProcessedExtensionsCache* GetProcessedExtensionsCache() {
+  static ProcessedExtensionsCache* cache = new ProcessedExtensionsCache();
+  return cache;
+}
+
 Status ProcessExtension(const std::string& extension,
-                        const base::FilePath& temp_dir,
                         base::FilePath* path,
                         std::string* bg_page) {
+  ProcessedExtensionsCache* cache = GetProcessedExtensionsCache();
+  base::AutoLock auto_lock(cache->lock);
+  auto cached = cache->entries.find(extension);
+  if (cached != cache->entries.end()) {
+    *path = cached->second.dir;
+    if (cached->second.bg_page.size())
+      *bg_page = cached->second.bg_page;
+    return Status(kOk);
+  }
+  if (!cache->root_dir.IsValid() && !cache->root_dir.CreateUniqueTempDir())
+    return Status(kUnknownError, "cannot create temp dir for extensions");
+
   // Decodes extension string.
   // Some WebDriver client base64 encoders follow RFC 1521, which require that
   // 'encoded lines be no more than 76 characters long'. Just remove any
@@ -916,15 +1058,6 @@ Status ProcessExtension(const std::string& extension,
   if (!base::Base64Decode(extension_base64, &decoded_extension))
     return Status(kUnknownError, "cannot base64 decode");
 
-  base::ScopedTempDir temp_crx_dir;
-  if (!temp_crx_dir.CreateUniqueTempDir())
-    return Status(kUnknownError, "cannot create temp dir");
-  base::FilePath extension_crx = temp_crx_dir.GetPath().AppendASCII("temp.crx");
-  int size = static_cast<int>(decoded_extension.length());
-  if (base::WriteFile(extension_crx, decoded_extension.c_str(), size) != size) {
-    return Status(kUnknownError, "cannot write file");
-  }
-
   // If the file is a crx file, extract the extension's ID from its public key.
   // Otherwise generate a random public key and use its derived extension ID.
   std::string public_key_base64;
@@ -936,6 +1069,18 @@ Status ProcessExtension(const std::string& extension,
   std::string id;
 
   if (is_crx_file) {
+    // crx_file::Verify reads from disk, so only crx payloads are staged in a
+    // temp file; plain zip payloads are unzipped straight from memory below.
+    base::ScopedTempDir temp_crx_dir;
+    if (!temp_crx_dir.CreateUniqueTempDir())
+      return Status(kUnknownError, "cannot create temp dir");
+    base::FilePath extension_crx =
+        temp_crx_dir.GetPath().AppendASCII("temp.crx");
+    int size = static_cast<int>(decoded_extension.length());
+    if (base::WriteFile(extension_crx, decoded_extension.c_str(), size) !=
+        size) {
+      return Status(kUnknownError, "cannot write file");
+    }
     crx_file::VerifierResult result = crx_file::Verify(
         extension_crx, crx_file::VerifierFormat::CRX3,
         {} /** required_key_hashes */, {} /** required_file_hash */,
@@ -965,10 +1110,18 @@ Status ProcessExtension(const std::string& extension,
     base::Base64Encode(public_key, &public_key_base64);
   }
 
-  // Unzip the crx file.
-  base::FilePath extension_dir = temp_dir.AppendASCII("extension_" + id);
-  if (!zip::Unzip(extension_crx, extension_dir))
-    return Status(kUnknownError, "cannot unzip");
+  // Unzip the crx data from memory. Different payloads can carry the same
+  // extension id (e.g. two versions of one extension), so each cache entry
+  // gets its own numbered subdirectory. The crx header bytes before the zip
+  // data are harmless: the reader locates the central directory from the end
+  // of the buffer.
+  base::FilePath extension_dir =
+      cache->root_dir.GetPath()
+          .AppendASCII(base::NumberToString(cache->entries.size()))
+          .AppendASCII("extension_" + id);
+  Status unzip_status = UnzipArchive(extension_dir, decoded_extension);
+  if (unzip_status.IsError())
+    return Status(kUnknownError, "cannot unzip: " + unzip_status.message());
 
   // Parse the manifest and set the 'key' if not already present.
   base::FilePath manifest_path(extension_dir.AppendASCII("manifest.json"));
@@ -1018,6 +1171,11 @@ Status ProcessExtension(const std::string& extension,
   if (status.IsError())
     return status;
 
+  ProcessedExtensionsCache::Entry entry;
+  entry.dir = extension_dir;
+  entry.bg_page = bg_page_tmp;
+  cache->entries[extension] = std::move(entry);
+
   *path = extension_dir;
   if (bg_page_tmp.size())
     *bg_page = bg_page_tmp;
@@ -1043,7 +1201,7 @@ Status ProcessExtensions(const std::vector<std::string>& extensions,
   for (size_t i = 0; i < extensions.size(); ++i) {
     base::FilePath path;
     std::string bg_page;
-    Status status = ProcessExtension(extensions[i], temp_dir, &path, &bg_page);
+    Status status = ProcessExtension(extensions[i], &path, &bg_page);
     if (status.IsError()) {
       return Status(
           kSessionNotCreated,
@@ -1063,29 +1221,68 @@ Status ProcessExtensions(const std::vector<std::string>& extensions,
   return Status(kOk);
 }
 
+// Fully-merged prefs file contents, keyed by the template and custom prefs
+// they were built from. Each session launched with the same options produces
+// byte-identical Preferences and Local State files, so the template JSON only
+// needs to be parsed, merged and re-serialized once per distinct
+// configuration. Sessions run on separate threads, hence the lock.
+struct PrefsFileCache {
+  base::Lock lock;
+  std::map<std::string, std::string> contents;
+};
+
+PrefsFileCache* GetPrefsFileCache() {
+  static PrefsFileCache* cache = new PrefsFileCache();
+  return cache;
+}
+
 Status WritePrefsFile(
     const std::string& template_string,
     const base::DictionaryValue* custom_prefs,
+    bool use_contents_cache,
     const base::FilePath& path) {
-  base::JSONReader::ValueWithError parsed_json =
-      base::JSONReader::ReadAndReturnValueWithError(template_string);
-  base::DictionaryValue* prefs;
-  if (!parsed_json.value || !parsed_json.value->GetAsDictionary(&prefs)) {
-    return Status(kUnknownError, "cannot parse internal JSON template: " +
-                                     parsed_json.error_message);
+  std::string cache_key;
+  std::string prefs_str;
+  PrefsFileCache* cache = GetPrefsFileCache();
+  if (use_contents_cache) {
+    cache_key = template_string;
+    cache_key += '\n';
+    if (custom_prefs)
+      base::JSONWriter::Write(*custom_prefs, &cache_key);
+    base::AutoLock auto_lock(cache->lock);
+    auto it = cache->contents.find(cache_key);
+    if (it != cache->contents.end())
+      prefs_str = it->second;
   }
 
-  if (custom_prefs) {
-    for (base::DictionaryValue::Iterator it(*custom_prefs); !it.IsAtEnd();
-         it.Advance()) {
-      prefs->Set(it.key(), std::make_unique<base::Value>(it.value().Clone()));
+  if (prefs_str.empty()) {
+    base::JSONReader::ValueWithError parsed_json =
+        base::JSONReader::ReadAndReturnValueWithError(template_string);
+    base::DictionaryValue* prefs;
+    if (!parsed_json.value || !parsed_json.value->GetAsDictionary(&prefs)) {
+      return Status(kUnknownError, "cannot parse internal JSON template: " +
+                                       parsed_json.error_message);
     }
+
+    if (custom_prefs) {
+      for (base::DictionaryValue::Iterator it(*custom_prefs); !it.IsAtEnd();
+           it.Advance()) {
+        prefs->Set(it.key(), std::make_unique<base::Value>(it.value().Clone()));
+      }
+    }
+
+    base::JSONWriter::Write(*prefs, &prefs_str);
+    VLOG(0) << "Populating " << path.BaseName().value()
+            << " file: " << PrettyPrintValue(*prefs);
+    if (use_contents_cache) {
+      base::AutoLock auto_lock(cache->lock);
+      cache->contents[cache_key] = prefs_str;
+    }
+  } else {
+    VLOG(0) << "Populating " << path.BaseName().value()
+            << " file from cached contents";
   }
 
-  std::string prefs_str;
-  base::JSONWriter::Write(*prefs, &prefs_str);
-  VLOG(0) << "Populating " << path.BaseName().value()
-          << " file: " << PrettyPrintValue(*prefs);
   if (static_cast<int>(prefs_str.length()) != base::WriteFile(
           path, prefs_str.c_str(), prefs_str.length())) {
     return Status(kUnknownError, "failed to write prefs file");
@@ -1102,18 +1299,23 @@ Status PrepareUserDataDir(
   if (!base::CreateDirectory(default_dir))
     return Status(kUnknownError, "cannot create default profile directory");
 
+  // Merged contents are only cached when starting from the built-in
+  // templates: a user-supplied user-data-dir carries files Chrome rewrote on
+  // previous runs, which rarely repeat and would only bloat the cache.
   std::string preferences;
   base::FilePath preferences_path =
       default_dir.Append(chrome::kPreferencesFilename);
 
-  if (base::PathExists(preferences_path))
-    base::ReadFileToString(preferences_path, &preferences);
-  else
+  bool use_preferences_template = !base::PathExists(preferences_path);
+  if (use_preferences_template)
     preferences = kPreferences;
+  else
+    base::ReadFileToString(preferences_path, &preferences);
 
   Status status =
       WritePrefsFile(preferences,
                      custom_prefs,
+                     use_preferences_template,
                      default_dir.Append(chrome::kPreferencesFilename));
   if (status.IsError())
     return status;
@@ -1122,13 +1324,15 @@ Status PrepareUserDataDir(
   base::FilePath local_state_path =
       user_data_dir.Append(chrome::kLocalStateFilename);
 
-  if (base::PathExists(local_state_path))
-    base::ReadFileToString(local_state_path, &local_state);
-  else
+  bool use_local_state_template = !base::PathExists(local_state_path);
+  if (use_local_state_template)
     local_state = kLocalState;
+  else
+    base::ReadFileToString(local_state_path, &local_state);
 
   status = WritePrefsFile(local_state,
                           custom_local_state,
+                          use_local_state_template,
                           user_data_dir.Append(chrome::kLocalStateFilename));
   if (status.IsError())
     return status;
@@ -1182,6 +1386,63 @@ Status RemoveOldDevToolsActivePortFile(const base::FilePath& user_data_dir) {
           user_data_dir.AsUTF8Unsafe().c_str(), kBrowserShortName));
 }
 
+DevToolsActivePortWatcher::DevToolsActivePortWatcher(
+    const base::FilePath& user_data_dir)
+    : user_data_dir_(user_data_dir) {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  inotify_fd_.reset(inotify_init1(IN_NONBLOCK | IN_CLOEXEC));
+  if (inotify_fd_.is_valid() &&
+      inotify_add_watch(
+          inotify_fd_.get(), user_data_dir.value().c_str(),
+          IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE | IN_MODIFY) < 0) {
+    // No watch on the directory; WaitForPortFile falls back to polling.
+    inotify_fd_.reset();
+  }
+#endif
+}
+
+DevToolsActivePortWatcher::~DevToolsActivePortWatcher() = default;
+
+Status DevToolsActivePortWatcher::WaitForPortFile(const base::TimeDelta& slice,
+                                                  int* port) {
+  // The file may already be there, or may have appeared before the watch was
+  // established, so always check before blocking.
+  Status status = ParseDevToolsActivePortFile(user_data_dir_, port);
+  if (status.IsOk())
+    return status;
+  Timeout timeout(slice);
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (inotify_fd_.is_valid()) {
+    while (!timeout.IsExpired()) {
+      struct pollfd poll_fd = {inotify_fd_.get(), POLLIN, 0};
+      int wait_ms =
+          static_cast<int>(timeout.GetRemainingTime().InMilliseconds());
+      if (HANDLE_EINTR(poll(&poll_fd, 1, std::max(wait_ms, 0))) <= 0)
+        break;
+      // Drain the queued events; their contents don't matter, the port file
+      // is simply re-parsed after any activity in the directory. A partially
+      // written file fails to parse and the wait continues until the next
+      // write event.
+      char buffer[4096];
+      while (HANDLE_EINTR(read(inotify_fd_.get(), buffer, sizeof(buffer))) > 0)
+        continue;
+      status = ParseDevToolsActivePortFile(user_data_dir_, port);
+      if (status.IsOk())
+        return status;
+    }
+    return ParseDevToolsActivePortFile(user_data_dir_, port);
+  }
+#endif
+  AdaptiveWaiter waiter(base::TimeDelta::FromMilliseconds(50));
+  while (!timeout.IsExpired()) {
+    waiter.Wait(&timeout);
+    status = ParseDevToolsActivePortFile(user_data_dir_, port);
+    if (status.IsOk())
+      return status;
+  }
+  return status;
+}
+
 std::string GetTerminationReason(base::TerminationStatus status) {
   switch (status) {
     case base::TERMINATION_STATUS_STILL_RUNNING:
@@ -11,7 +11,13 @@
 
 #include "base/files/file_path.h"
 #include "base/process/kill.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
 #include "chrome/test/chromedriver/capabilities.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include "base/files/scoped_file.h"
+#endif
 #include "chrome/test/chromedriver/net/sync_websocket_factory.h"
 
 class DevToolsEventListener;
@@ -53,6 +59,28 @@ Status PrepareUserDataDir(
 Status ParseDevToolsActivePortFile(const base::FilePath& user_data_dir,
                                    int* port);
 Status RemoveOldDevToolsActivePortFile(const base::FilePath& user_data_dir);
+
+// Watches |user_data_dir| for Chrome writing its DevToolsActivePort file, so
+// launch readiness is detected the moment the file appears instead of on the
+// next poll tick. Uses inotify where available; elsewhere it degrades to
+// adaptive polling within each wait.
+class DevToolsActivePortWatcher {
+ public:
+  explicit DevToolsActivePortWatcher(const base::FilePath& user_data_dir);
+  ~DevToolsActivePortWatcher();
+
+  // Waits up to |slice| for the port file to become parseable and fills in
+  // |port| on success. A non-ok status means the file has not (completely)
+  // appeared yet; callers check that the browser process is still alive and
+  // wait again.
+  Status WaitForPortFile(const base::TimeDelta& slice, int* port);
+
+ private:
+  const base::FilePath user_data_dir_;
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  base::ScopedFD inotify_fd_;
+#endif
+};
 std::string GetTerminationReason(base::TerminationStatus status);
 }  // namespace internal
 
@@ -232,6 +232,48 @@ TEST(PrepareUserDataDir, CustomPrefs) {
   AssertEQ(*local_state_dict, "local.state.sub", "2");
 }
 
+TEST(PrepareUserDataDir, CachedContentsMatchFirstLaunch) {
+  // A second launch with the same custom prefs is served from the merged
+  // contents cache and must produce byte-identical files.
+  base::DictionaryValue prefs;
+  prefs.SetString("cachedPrefsKey", "ok");
+  base::DictionaryValue local_state;
+  local_state.SetString("cachedLocalKey", "ok");
+
+  base::ScopedTempDir first_dir;
+  ASSERT_TRUE(first_dir.CreateUniqueTempDir());
+  Status status =
+      internal::PrepareUserDataDir(first_dir.GetPath(), &prefs, &local_state);
+  ASSERT_EQ(kOk, status.code());
+
+  base::ScopedTempDir second_dir;
+  ASSERT_TRUE(second_dir.CreateUniqueTempDir());
+  status =
+      internal::PrepareUserDataDir(second_dir.GetPath(), &prefs, &local_state);
+  ASSERT_EQ(kOk, status.code());
+
+  base::FilePath prefs_name = base::FilePath()
+                                  .AppendASCII(chrome::kInitialProfile)
+                                  .Append(chrome::kPreferencesFilename);
+  std::string first_prefs;
+  std::string second_prefs;
+  ASSERT_TRUE(base::ReadFileToString(
+      first_dir.GetPath().Append(prefs_name), &first_prefs));
+  ASSERT_TRUE(base::ReadFileToString(
+      second_dir.GetPath().Append(prefs_name), &second_prefs));
+  ASSERT_EQ(first_prefs, second_prefs);
+
+  std::string first_local_state;
+  std::string second_local_state;
+  ASSERT_TRUE(base::ReadFileToString(
+      first_dir.GetPath().Append(chrome::kLocalStateFilename),
+      &first_local_state));
+  ASSERT_TRUE(base::ReadFileToString(
+      second_dir.GetPath().Append(chrome::kLocalStateFilename),
+      &second_local_state));
+  ASSERT_EQ(first_local_state, second_local_state);
+}
+
 TEST(DesktopLauncher, ParseDevToolsActivePortFile_Success) {
   base::ScopedTempDir temp_dir;
   ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
@@ -307,3 +349,27 @@ TEST(DesktopLauncher, RemoveOldDevToolsActivePortFile_Failure) {
   base::CloseFile(fd);
 }
 #endif
+
+TEST(DesktopLauncher, DevToolsActivePortWatcher_ExistingFile) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath temp_file =
+      temp_dir.GetPath().Append(FILE_PATH_LITERAL("DevToolsActivePort"));
+  char data[] = "12345\nblahblah";
+  ASSERT_TRUE(base::WriteFile(temp_file, data, strlen(data)));
+  internal::DevToolsActivePortWatcher watcher(temp_dir.GetPath());
+  int port = 0;
+  ASSERT_TRUE(watcher.WaitForPortFile(base::TimeDelta(), &port).IsOk());
+  ASSERT_EQ(port, 12345);
+}
+
+TEST(DesktopLauncher, DevToolsActivePortWatcher_FileNeverAppears) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  internal::DevToolsActivePortWatcher watcher(temp_dir.GetPath());
+  int port = 0;
+  ASSERT_FALSE(
+      watcher
+          .WaitForPortFile(base::TimeDelta::FromMilliseconds(50), &port)
+          .IsOk());
+}
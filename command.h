@@ -21,7 +21,10 @@ typedef base::RepeatingCallback<
     void(const Status&, std::unique_ptr<base::Value>, const std::string&, bool)>
     CommandCallback;
 
-typedef base::RepeatingCallback<void(const base::DictionaryValue&,
+// Top-level command entry point. The command takes ownership of its
+// parameter tree, so layers below can move pieces out of it instead of
+// cloning them.
+typedef base::RepeatingCallback<void(std::unique_ptr<base::DictionaryValue>,
                                      const std::string&,
                                      const CommandCallback&)>
     Command;
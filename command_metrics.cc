@@ -0,0 +1,105 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/command_metrics.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/values.h"
+
+namespace {
+
+base::LazyInstance<CommandMetrics>::Leaky g_command_metrics =
+    LAZY_INSTANCE_INITIALIZER;
+
+// Index of the exponential bucket holding |micros|: bucket i covers
+// [2^i, 2^(i+1)) microseconds, with bucket 0 also covering sub-microsecond
+// samples and the last bucket catching everything beyond ~35 minutes.
+size_t BucketIndex(int64_t micros) {
+  size_t index = 0;
+  while (micros > 1 && index < 31) {
+    micros >>= 1;
+    index++;
+  }
+  return index;
+}
+
+// Upper bound of bucket |index| in milliseconds.
+double BucketUpperBoundInMs(size_t index) {
+  return static_cast<double>(int64_t{1} << (index + 1)) / 1000.0;
+}
+
+}  // namespace
+
+CommandLatencyHistogram::CommandLatencyHistogram() {
+  for (auto& bucket : buckets_)
+    bucket.store(0, std::memory_order_relaxed);
+}
+
+CommandLatencyHistogram::~CommandLatencyHistogram() {}
+
+void CommandLatencyHistogram::Record(base::TimeDelta elapsed) {
+  int64_t micros = std::max(elapsed.InMicroseconds(), int64_t{0});
+  buckets_[BucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::unique_ptr<base::DictionaryValue> CommandLatencyHistogram::ToValue()
+    const {
+  int64_t counts[kBucketCount];
+  int64_t total = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+
+  auto summary = std::make_unique<base::DictionaryValue>();
+  summary->SetDoubleKey("count", static_cast<double>(total));
+  const struct {
+    const char* key;
+    double quantile;
+  } kPercentiles[] = {{"p50", 0.50}, {"p95", 0.95}, {"p99", 0.99}};
+  for (const auto& percentile : kPercentiles) {
+    double value = 0;
+    if (total > 0) {
+      int64_t rank = static_cast<int64_t>(percentile.quantile * total);
+      int64_t seen = 0;
+      for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts[i];
+        if (seen > rank) {
+          value = BucketUpperBoundInMs(i);
+          break;
+        }
+      }
+    }
+    summary->SetDoubleKey(percentile.key, value);
+  }
+  return summary;
+}
+
+CommandMetrics::CommandMetrics() {}
+
+CommandMetrics::~CommandMetrics() {}
+
+CommandMetrics* CommandMetrics::GetInstance() {
+  return g_command_metrics.Pointer();
+}
+
+CommandLatencyHistogram* CommandMetrics::GetHistogram(
+    const std::string& command) {
+  base::AutoLock lock(lock_);
+  std::unique_ptr<CommandLatencyHistogram>& histogram = histograms_[command];
+  if (!histogram)
+    histogram = std::make_unique<CommandLatencyHistogram>();
+  return histogram.get();
+}
+
+std::unique_ptr<base::DictionaryValue> CommandMetrics::ToValue() const {
+  auto stats = std::make_unique<base::DictionaryValue>();
+  base::AutoLock lock(lock_);
+  for (const auto& entry : histograms_)
+    stats->SetKey(entry.first, base::Value::FromUniquePtrValue(
+                                   entry.second->ToValue()));
+  return stats;
+}
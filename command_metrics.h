@@ -0,0 +1,73 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_COMMAND_METRICS_H_
+#define CHROME_TEST_CHROMEDRIVER_COMMAND_METRICS_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/lazy_instance.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+
+namespace base {
+class DictionaryValue;
+}
+
+// Latency histogram for one WebDriver command. Samples land in
+// exponential power-of-two microsecond buckets with atomic counters, so
+// recording is lock-free and cheap enough to stay always on.
+class CommandLatencyHistogram {
+ public:
+  CommandLatencyHistogram();
+  CommandLatencyHistogram(const CommandLatencyHistogram&) = delete;
+  CommandLatencyHistogram& operator=(const CommandLatencyHistogram&) = delete;
+  ~CommandLatencyHistogram();
+
+  void Record(base::TimeDelta elapsed);
+
+  // Returns {"count": N, "p50": ms, "p95": ms, "p99": ms}. Percentiles are
+  // the upper bound of the bucket holding the requested quantile, in
+  // milliseconds.
+  std::unique_ptr<base::DictionaryValue> ToValue() const;
+
+ private:
+  static constexpr size_t kBucketCount = 32;
+
+  std::atomic<int64_t> buckets_[kBucketCount];
+};
+
+// Process-wide registry of per-command latency histograms, recorded in
+// HttpHandler and reported by the /status endpoint.
+class CommandMetrics {
+ public:
+  static CommandMetrics* GetInstance();
+
+  CommandMetrics(const CommandMetrics&) = delete;
+  CommandMetrics& operator=(const CommandMetrics&) = delete;
+
+  // Returns the histogram for |command|, creating it on first use. The
+  // returned pointer remains valid for the life of the process.
+  CommandLatencyHistogram* GetHistogram(const std::string& command);
+
+  // Returns a dictionary mapping each recorded command to its histogram
+  // summary.
+  std::unique_ptr<base::DictionaryValue> ToValue() const;
+
+ private:
+  friend struct base::LazyInstanceTraitsBase<CommandMetrics>;
+
+  CommandMetrics();
+  ~CommandMetrics();
+
+  // Guards map mutation only; recording into an existing histogram does
+  // not take the lock.
+  mutable base::Lock lock_;
+  std::map<std::string, std::unique_ptr<CommandLatencyHistogram>> histograms_;
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_COMMAND_METRICS_H_
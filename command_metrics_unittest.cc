@@ -0,0 +1,44 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/command_metrics.h"
+
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+TEST(CommandLatencyHistogramTest, EmptyHistogram) {
+  CommandLatencyHistogram histogram;
+  std::unique_ptr<base::DictionaryValue> summary = histogram.ToValue();
+  EXPECT_EQ(0, summary->FindDoubleKey("count").value_or(-1));
+  EXPECT_EQ(0, summary->FindDoubleKey("p50").value_or(-1));
+  EXPECT_EQ(0, summary->FindDoubleKey("p99").value_or(-1));
+}
+
+TEST(CommandLatencyHistogramTest, PercentilesAreOrdered) {
+  CommandLatencyHistogram histogram;
+  for (int i = 1; i <= 100; ++i)
+    histogram.Record(base::TimeDelta::FromMilliseconds(i));
+  std::unique_ptr<base::DictionaryValue> summary = histogram.ToValue();
+  EXPECT_EQ(100, summary->FindDoubleKey("count").value_or(-1));
+  double p50 = summary->FindDoubleKey("p50").value_or(-1);
+  double p95 = summary->FindDoubleKey("p95").value_or(-1);
+  double p99 = summary->FindDoubleKey("p99").value_or(-1);
+  EXPECT_GT(p50, 0);
+  EXPECT_LE(p50, p95);
+  EXPECT_LE(p95, p99);
+}
+
+TEST(CommandMetricsTest, GetHistogramIsStable) {
+  CommandMetrics* metrics = CommandMetrics::GetInstance();
+  CommandLatencyHistogram* histogram = metrics->GetHistogram("GET /status");
+  ASSERT_TRUE(histogram);
+  EXPECT_EQ(histogram, metrics->GetHistogram("GET /status"));
+  histogram->Record(base::TimeDelta::FromMilliseconds(5));
+
+  std::unique_ptr<base::DictionaryValue> stats = metrics->ToValue();
+  base::DictionaryValue* summary = nullptr;
+  ASSERT_TRUE(stats->GetDictionary("GET /status", &summary));
+  EXPECT_GE(summary->FindDoubleKey("count").value_or(0), 1);
+}
@@ -5,6 +5,7 @@
 #include "chrome/test/chromedriver/commands.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #include <algorithm>
 #include <list>
@@ -13,29 +14,38 @@
 #include "base/bind.h"
 #include "base/callback_helpers.h"
 #include "base/containers/contains.h"
+#include "base/format_macros.h"
 #include "base/location.h"
 #include "base/logging.h"
-#include "base/memory/ptr_util.h"
 #include "base/run_loop.h"
 #include "base/single_thread_task_runner.h"
 #include "base/strings/stringprintf.h"
 #include "base/system/sys_info.h"
 #include "base/task/current_thread.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/capabilities.h"
+#include "chrome/test/chromedriver/chrome/allocation_tracker.h"
 #include "chrome/test/chromedriver/chrome/browser_info.h"
 #include "chrome/test/chromedriver/chrome/chrome.h"
+#include "chrome/test/chromedriver/chrome/driver_tracing.h"
 #include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/command_metrics.h"
 #include "chrome/test/chromedriver/constants/version.h"
 #include "chrome/test/chromedriver/logging.h"
+#include "chrome/test/chromedriver/net/mpsc_message_queue.h"
+#include "chrome/test/chromedriver/net/wait_site.h"
 #include "chrome/test/chromedriver/session.h"
 #include "chrome/test/chromedriver/session_commands.h"
+#include "chrome/test/chromedriver/session_metrics.h"
 #include "chrome/test/chromedriver/session_thread_map.h"
 #include "chrome/test/chromedriver/util.h"
 
 void ExecuteGetStatus(
-    const base::DictionaryValue& params,
+    std::unique_ptr<base::DictionaryValue> params,
     const std::string& session_id,
     const CommandCallback& callback) {
   // W3C defined data:
@@ -57,20 +67,56 @@ void ExecuteGetStatus(
   os.SetString("arch", base::SysInfo::OperatingSystemArchitecture());
   info.SetKey("os", std::move(os));
 
+  info.SetKey("commandStats", base::Value::FromUniquePtrValue(
+                                  CommandMetrics::GetInstance()->ToValue()));
+
+  info.SetKey("sessionStats", base::Value::FromUniquePtrValue(
+                                  SessionMetrics::GetInstance()->ToValue()));
+
+  // Watchdog samples of session threads stuck in one command past the
+  // stall SLO; see SessionMetrics::StartWatchdog.
+  info.SetKey("stalledCommands",
+              base::Value::FromUniquePtrValue(
+                  SessionMetrics::GetInstance()->StallSamplesToValue()));
+
+  // Inbound DevTools WebSocket backlog, summed across all live connections;
+  // the queues live below the session layer so per-session attribution is
+  // not available here.
+  base::DictionaryValue inbound_queues;
+  inbound_queues.SetDoubleKey("queuedMessages",
+                              MpscMessageQueue::TotalQueuedMessages());
+  inbound_queues.SetDoubleKey("queuedBytes",
+                              MpscMessageQueue::TotalQueuedBytes());
+  info.SetKey("webSocketInboundQueues", std::move(inbound_queues));
+
   callback.Run(Status(kOk), base::Value::ToUniquePtrValue(std::move(info)),
                std::string(), kW3CDefault);
 }
 
+void ExecuteGetDriverTrace(std::unique_ptr<base::DictionaryValue> params,
+                           const std::string& session_id,
+                           const CommandCallback& callback) {
+  callback.Run(Status(kOk), DriverTracing::GetInstance()->ToValue(),
+               std::string(), kW3CDefault);
+}
+
 void ExecuteCreateSession(SessionThreadMap* session_thread_map,
                           const Command& init_session_cmd,
-                          const base::DictionaryValue& params,
+                          std::unique_ptr<base::DictionaryValue> params,
                           const std::string& host,
                           const CommandCallback& callback) {
   std::string new_id = GenerateId();
   std::unique_ptr<Session> session = std::make_unique<Session>(new_id, host);
+  // The priority class must be known before the executor starts, and again
+  // by the IO threads when they order response writes, so it is peeked from
+  // the parameters here and published through the metrics registry.
+  bool low_priority = GetLowPrioritySetting(*params);
   std::unique_ptr<SessionThreadInfo> threadInfo =
-      std::make_unique<SessionThreadInfo>(new_id, GetW3CSetting(params));
-  if (!threadInfo->thread()->Start()) {
+      std::make_unique<SessionThreadInfo>(new_id, GetW3CSetting(*params),
+                                          low_priority);
+  SessionMetrics::GetInstance()->Register(new_id)->low_priority.store(
+      low_priority, std::memory_order_relaxed);
+  if (!threadInfo->Start()) {
     callback.Run(
         Status(kUnknownError, "failed to start a thread for the new session"),
         std::unique_ptr<base::Value>(), std::string(),
@@ -78,10 +124,10 @@ void ExecuteCreateSession(SessionThreadMap* session_thread_map,
     return;
   }
 
-  threadInfo->thread()->task_runner()->PostTask(
+  threadInfo->task_runner()->PostTask(
       FROM_HERE, base::BindOnce(&SetThreadLocalSession, std::move(session)));
   session_thread_map->insert(std::make_pair(new_id, std::move(threadInfo)));
-  init_session_cmd.Run(params, new_id, callback);
+  init_session_cmd.Run(std::move(params), new_id, callback);
 }
 
 namespace {
@@ -111,11 +157,17 @@ void OnGetSession(const base::WeakPtr<size_t>& session_remaining_count,
   }
 }
 
+// Sink for per-command parameter trees. base::Value has no allocator
+// hooks, so the trees cannot come from an arena; handing them to a
+// best-effort worker at least takes their node-by-node teardown off the
+// session thread. Destruction happens when the bound argument is freed.
+void DeleteParamsInBackground(std::unique_ptr<base::DictionaryValue> params) {}
+
 }  // namespace
 
 void ExecuteGetSessions(const Command& session_capabilities_command,
                         SessionThreadMap* session_thread_map,
-                        const base::DictionaryValue& params,
+                        std::unique_ptr<base::DictionaryValue> params,
                         const std::string& session_id,
                         const CommandCallback& callback) {
   size_t get_remaining_count = session_thread_map->size();
@@ -132,7 +184,7 @@ void ExecuteGetSessions(const Command& session_capabilities_command,
   for (auto iter = session_thread_map->begin();
        iter != session_thread_map->end(); ++iter) {
     session_capabilities_command.Run(
-        params, iter->first,
+        params->CreateDeepCopy(), iter->first,
         base::BindRepeating(&OnGetSession, weak_ptr_factory.GetWeakPtr(),
                             run_loop.QuitClosure(), session_list.get()));
   }
@@ -165,7 +217,7 @@ void OnSessionQuit(const base::WeakPtr<size_t>& quit_remaining_count,
 void ExecuteQuitAll(
     const Command& quit_command,
     SessionThreadMap* session_thread_map,
-    const base::DictionaryValue& params,
+    std::unique_ptr<base::DictionaryValue> params,
     const std::string& session_id,
     const CommandCallback& callback) {
   size_t quit_remaining_count = session_thread_map->size();
@@ -179,7 +231,7 @@ void ExecuteQuitAll(
   for (auto iter = session_thread_map->begin();
        iter != session_thread_map->end(); ++iter) {
     quit_command.Run(
-        params, iter->first,
+        params->CreateDeepCopy(), iter->first,
         base::BindRepeating(&OnSessionQuit, weak_ptr_factory.GetWeakPtr(),
                             run_loop.QuitClosure()));
   }
@@ -194,23 +246,89 @@ void ExecuteQuitAll(
 
 namespace {
 
+void JoinSessionThreadInBackground(
+    std::unique_ptr<SessionThreadInfo> thread_info) {
+  // Destroying |thread_info| joins the dedicated session thread, which can
+  // take as long as the slowest work still queued on it (browser exit,
+  // profile cleanup). Nothing else to do; the join is the point.
+}
+
 void TerminateSessionThreadOnCommandThread(SessionThreadMap* session_thread_map,
                                            const std::string& session_id) {
-  session_thread_map->erase(session_id);
+  auto iter = session_thread_map->find(session_id);
+  if (iter == session_thread_map->end())
+    return;
+  // The command thread serializes all session teardowns, so joining each
+  // session thread here would drain a node one session at a time. Hand the
+  // join to the thread pool instead; the pool bounds how many joins run
+  // concurrently, and the quit response has already been sent.
+  std::unique_ptr<SessionThreadInfo> thread_info = std::move(iter->second);
+  session_thread_map->erase(iter);
+  base::ThreadPool::PostTask(
+      FROM_HERE,
+      {base::MayBlock(), base::WithBaseSyncPrimitives(),
+       base::TaskShutdownBehavior::BLOCK_SHUTDOWN},
+      base::BindOnce(&JoinSessionThreadInBackground, std::move(thread_info)));
 }
 
+// Publishes the running command into the session's stats block and aims
+// the thread's wait-site slot at it, so the stall watchdog can report what
+// a wedged session thread is doing and where it is blocked; everything is
+// cleared again when the command finishes. |command_name| must be a string
+// literal (the watchdog reads it from another thread).
+class ScopedCommandActivity {
+ public:
+  ScopedCommandActivity(scoped_refptr<SessionMemoryStats> stats,
+                        const char* command_name)
+      : stats_(std::move(stats)) {
+    stats_->command_name.store(command_name, std::memory_order_relaxed);
+    stats_->command_start_us.store(
+        (base::TimeTicks::Now() - base::TimeTicks()).InMicroseconds(),
+        std::memory_order_release);
+    SetWaitSiteSlotForCurrentThread(&stats_->wait_site);
+  }
+
+  ~ScopedCommandActivity() {
+    SetWaitSiteSlotForCurrentThread(nullptr);
+    stats_->command_start_us.store(0, std::memory_order_release);
+    stats_->wait_site.store(nullptr, std::memory_order_relaxed);
+    stats_->command_name.store(nullptr, std::memory_order_relaxed);
+  }
+
+ private:
+  scoped_refptr<SessionMemoryStats> stats_;
+};
+
 void ExecuteSessionCommandOnSessionThread(
     const char* command_name,
+    const std::string& session_id,
     const SessionCommand& command,
     bool w3c_standard_command,
     bool return_ok_without_session,
     std::unique_ptr<base::DictionaryValue> params,
+    std::shared_ptr<std::atomic<bool>> cancel_flag,
     scoped_refptr<base::SingleThreadTaskRunner> cmd_task_runner,
     const CommandCallback& callback_on_cmd,
     const base::RepeatingClosure& terminate_on_cmd) {
-  Session* session = GetThreadLocalSession();
+  ScopedDriverSpan span(command_name);
+  // The thread may be shared with other sessions when the pooled session
+  // executor is in use, so the right session must be made current here.
+  Session* session = SwitchThreadLocalSession(session_id);
+
+  // Discard any cancelation aimed at an earlier, already finished command,
+  // then expose the flag to the waits this command will enter.
+  if (cancel_flag)
+    cancel_flag->store(false, std::memory_order_relaxed);
+  if (session)
+    session->cmd_cancel_flag = cancel_flag.get();
 
   if (!session) {
+    // The session is already gone; drop the backlog gauge through a lookup so
+    // the entry is not resurrected after Unregister.
+    scoped_refptr<SessionMemoryStats> stats =
+        SessionMetrics::GetInstance()->Lookup(session_id);
+    if (stats)
+      stats->command_backlog.fetch_sub(1, std::memory_order_relaxed);
     cmd_task_runner->PostTask(
         FROM_HERE,
         base::BindOnce(
@@ -220,6 +338,11 @@ void ExecuteSessionCommandOnSessionThread(
     return;
   }
 
+  // From here until the command returns, the watchdog can attribute this
+  // thread's time to |command_name|.
+  ScopedCommandActivity activity(
+      SessionMetrics::GetInstance()->Register(session_id), command_name);
+
   if (IsVLogOn(0)) {
     if (!session->driver_log ||
         session->driver_log->min_level() != Log::Level::kOff) {
@@ -257,19 +380,52 @@ void ExecuteSessionCommandOnSessionThread(
     if (status.IsError()) {
       LOG(ERROR) << status.message();
     } else {
+      allocation_tracker::ScopedThreadAllocationCounter alloc_counter;
       status = command.Run(session, *params, &value);
+      allocation_tracker::Totals allocated = alloc_counter.Delta();
+      if (allocated.allocs > 0 && IsVLogOn(2)) {
+        VLOG(2) << "[" << session->id << "] ALLOC " << command_name << " "
+                << allocated.allocs << " allocations " << allocated.bytes
+                << " bytes";
+      }
+
+      if (status.IsOk())
+        MaybeRefreshCrashRecoverySnapshot(session);
+
+      // Stream entries the command just produced to a subscribed WebSocket
+      // client; no-op without a subscription.
+      PushSubscribedLogEntries(session);
 
       if (status.IsError() && session->chrome) {
         if (!session->quit && session->chrome->HasCrashedWebView()) {
-          session->quit = true;
-          std::string message("session deleted because of page crash");
-          if (!session->detach) {
-            Status quit_status = session->chrome->Quit();
-            if (quit_status.IsError())
-              message +=
-                  ", but failed to kill browser:" + quit_status.message();
+          bool recovered = false;
+          if (session->recover_on_crash &&
+              !session->crash_recovery.is_null()) {
+            Status recover_status = session->crash_recovery.Run(session);
+            if (recover_status.IsOk()) {
+              recovered = true;
+              // The browser was relaunched in place; only the in-flight
+              // command is lost, and the client may retry it.
+              status = Status(kTabCrashed,
+                              "page crash; session recovered in place, "
+                              "retry the command",
+                              status);
+            } else {
+              status.AddDetails("crash recovery failed: " +
+                                recover_status.message());
+            }
+          }
+          if (!recovered) {
+            session->quit = true;
+            std::string message("session deleted because of page crash");
+            if (!session->detach && session->chrome) {
+              Status quit_status = session->chrome->Quit();
+              if (quit_status.IsError())
+                message +=
+                    ", but failed to kill browser:" + quit_status.message();
+            }
+            status = Status(kUnknownError, message, status);
           }
-          status = Status(kUnknownError, message, status);
         } else if (status.code() == kDisconnected) {
           // Some commands, like clicking a button or link which closes the
           // window, may result in a kDisconnected error code.
@@ -284,7 +440,8 @@ void ExecuteSessionCommandOnSessionThread(
             status = Status(kOk);
           }
         }
-        if (status.IsError()) {
+        // A failed recovery may have torn down |chrome| without replacing it.
+        if (status.IsError() && session->chrome) {
           const BrowserInfo* browser_info = session->chrome->GetBrowserInfo();
           status.AddDetails("Session info: " + browser_info->browser_name +
                             "=" + browser_info->browser_version);
@@ -311,25 +468,52 @@ void ExecuteSessionCommandOnSessionThread(
     }
   }
 
+  // Deep parameter trees mean thousands of small frees; do them on a
+  // background worker rather than while the session thread could already
+  // be running the next command.
+  base::ThreadPool::PostTask(
+      FROM_HERE, {base::TaskPriority::BEST_EFFORT},
+      base::BindOnce(&DeleteParamsInBackground, std::move(params)));
+
+  if (session->memory_stats)
+    session->memory_stats->command_backlog.fetch_sub(1,
+                                                     std::memory_order_relaxed);
+
   cmd_task_runner->PostTask(
       FROM_HERE, base::BindOnce(callback_on_cmd, status, std::move(value),
                                 session->id, session->w3c_compliant));
 
   if (session->quit) {
-    SetThreadLocalSession(std::unique_ptr<Session>());
-    delete session;
+    RemoveThreadLocalSession(session_id);
     cmd_task_runner->PostTask(FROM_HERE, terminate_on_cmd);
   }
 }
 
+// Upper bound on commands queued on one session's thread. A client stuck in
+// a retry loop can post commands far faster than the session thread drains
+// them; each queued command pins its request buffers, so an unbounded
+// backlog turns a runaway client into a node-wide memory spike and
+// minutes-long drain. Beyond the limit, dispatch fails fast with
+// kSessionOverloaded instead of queuing.
+constexpr int64_t kMaxCommandBacklog = 64;
+
 }  // namespace
 
+// Commands of one session execute strictly one at a time, in order, on the
+// session's thread. This is a correctness contract, not just an
+// implementation artifact: WebView clients for tabs multiplex over their
+// parent's WebSocket (DevToolsClientImpl::CreateTargetClient), and frame,
+// input and prompt state live on the Session itself, so commands targeting
+// different windows still share unsynchronized state. Per-window execution
+// lanes would need a thread-safe socket mux and per-window session state
+// first; until then, long waits inside a command should yield via
+// Session::IsCommandCancelled rather than expecting parallelism.
 void ExecuteSessionCommand(SessionThreadMap* session_thread_map,
                            const char* command_name,
                            const SessionCommand& command,
                            bool w3c_standard_command,
                            bool return_ok_without_session,
-                           const base::DictionaryValue& params,
+                           std::unique_ptr<base::DictionaryValue> params,
                            const std::string& session_id,
                            const CommandCallback& callback) {
   auto iter = session_thread_map->find(session_id);
@@ -338,12 +522,30 @@ void ExecuteSessionCommand(SessionThreadMap* session_thread_map,
     callback.Run(status, std::unique_ptr<base::Value>(), session_id,
                  kW3CDefault);
   } else {
-    iter->second->thread()->task_runner()->PostTask(
+    iter->second->TouchActivity();
+    scoped_refptr<SessionMemoryStats> stats =
+        SessionMetrics::GetInstance()->Register(session_id);
+    // Admission control: shed load once the backlog hits the limit. Quit is
+    // always admitted so an overloaded session can still be torn down.
+    int64_t backlog = stats->command_backlog.load(std::memory_order_relaxed);
+    if (backlog >= kMaxCommandBacklog && strcmp(command_name, "Quit") != 0) {
+      stats->commands_rejected.fetch_add(1, std::memory_order_relaxed);
+      callback.Run(
+          Status(kSessionOverloaded,
+                 base::StringPrintf("session has %" PRId64
+                                    " commands queued (limit %" PRId64
+                                    "); retry after the backlog drains",
+                                    backlog, kMaxCommandBacklog)),
+          std::unique_ptr<base::Value>(), session_id, kW3CDefault);
+      return;
+    }
+    stats->command_backlog.fetch_add(1, std::memory_order_relaxed);
+    iter->second->task_runner()->PostTask(
         FROM_HERE,
         base::BindOnce(
-            &ExecuteSessionCommandOnSessionThread, command_name, command,
-            w3c_standard_command, return_ok_without_session,
-            base::WrapUnique(params.DeepCopy()),
+            &ExecuteSessionCommandOnSessionThread, command_name, session_id,
+            command, w3c_standard_command, return_ok_without_session,
+            std::move(params), iter->second->cancel_flag(),
             base::ThreadTaskRunnerHandle::Get(), callback,
             base::BindRepeating(&TerminateSessionThreadOnCommandThread,
                                 session_thread_map, session_id)));
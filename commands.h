@@ -23,14 +23,21 @@ class Status;
 
 // Gets status/info about ChromeDriver.
 void ExecuteGetStatus(
-    const base::DictionaryValue& params,
+    std::unique_ptr<base::DictionaryValue> params,
+    const std::string& session_id,
+    const CommandCallback& callback);
+
+// Dumps the driver's recorded dispatch spans as Trace Event JSON. Empty
+// unless tracing was enabled via goog:chromeOptions.traceDriver.
+void ExecuteGetDriverTrace(
+    std::unique_ptr<base::DictionaryValue> params,
     const std::string& session_id,
     const CommandCallback& callback);
 
 // Creates a new session.
 void ExecuteCreateSession(SessionThreadMap* session_thread_map,
                           const Command& init_session_cmd,
-                          const base::DictionaryValue& params,
+                          std::unique_ptr<base::DictionaryValue> params,
                           const std::string& host,
                           const CommandCallback& callback);
 
@@ -38,7 +45,7 @@ void ExecuteCreateSession(SessionThreadMap* session_thread_map,
 void ExecuteGetSessions(
     const Command& session_capabilities_command,
     SessionThreadMap* session_thread_map,
-    const base::DictionaryValue& params,
+    std::unique_ptr<base::DictionaryValue> params,
     const std::string& session_id,
     const CommandCallback& callback);
 
@@ -46,7 +53,7 @@ void ExecuteGetSessions(
 void ExecuteQuitAll(
     const Command& quit_command,
     SessionThreadMap* session_thread_map,
-    const base::DictionaryValue& params,
+    std::unique_ptr<base::DictionaryValue> params,
     const std::string& session_id,
     const CommandCallback& callback);
 
@@ -62,7 +69,7 @@ void ExecuteSessionCommand(SessionThreadMap* session_thread_map,
                            const SessionCommand& command,
                            bool w3c_standard_command,
                            bool return_ok_without_session,
-                           const base::DictionaryValue& params,
+                           std::unique_ptr<base::DictionaryValue> params,
                            const std::string& session_id,
                            const CommandCallback& callback);
 
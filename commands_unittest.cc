@@ -18,10 +18,14 @@
 
 #include "base/run_loop.h"
 #include "base/single_thread_task_runner.h"
+#include "base/strings/stringprintf.h"
 #include "base/synchronization/lock.h"
 #include "base/test/task_environment.h"
+#include "base/threading/platform_thread.h"
 #include "base/threading/thread.h"
 #include "base/values.h"
+#include "chrome/test/chromedriver/chrome/allocation_tracker.h"
+#include "chrome/test/chromedriver/chrome/js.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/stub_chrome.h"
 #include "chrome/test/chromedriver/chrome/stub_web_view.h"
@@ -30,6 +34,7 @@
 #include "chrome/test/chromedriver/element_commands.h"
 #include "chrome/test/chromedriver/session.h"
 #include "chrome/test/chromedriver/session_commands.h"
+#include "chrome/test/chromedriver/session_metrics.h"
 #include "chrome/test/chromedriver/window_commands.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "third_party/webdriver/atoms.h"
@@ -56,14 +61,41 @@ void OnGetStatus(const Status& status,
 }  // namespace
 
 TEST(CommandsTest, GetStatus) {
-  base::DictionaryValue params;
-  ExecuteGetStatus(params, std::string(), base::BindRepeating(&OnGetStatus));
+  ExecuteGetStatus(std::make_unique<base::DictionaryValue>(), std::string(),
+                   base::BindRepeating(&OnGetStatus));
 }
 
+#if BUILDFLAG(CHROMEDRIVER_TRACK_ALLOCATIONS)
+
+namespace {
+
+// Budgets are deliberately generous: they exist to fail the build on
+// order-of-magnitude allocation regressions, not to pin exact counts.
+// Raising one requires justifying the extra allocations in review.
+constexpr uint64_t kGetStatusAllocBudget = 2000;
+constexpr uint64_t kGetStatusByteBudget = 256 * 1024;
+
+}  // namespace
+
+TEST(CommandsTest, GetStatusAllocationBudget) {
+  // Tracking is compiled in but still needs the allocator shim at runtime.
+  if (!allocation_tracker::Install())
+    return;
+  allocation_tracker::ScopedThreadAllocationCounter counter;
+  ExecuteGetStatus(std::make_unique<base::DictionaryValue>(), std::string(),
+                   base::BindRepeating(&OnGetStatus));
+  allocation_tracker::Totals allocated = counter.Delta();
+  EXPECT_GT(allocated.allocs, 0u);
+  EXPECT_LE(allocated.allocs, kGetStatusAllocBudget);
+  EXPECT_LE(allocated.bytes, kGetStatusByteBudget);
+}
+
+#endif  // BUILDFLAG(CHROMEDRIVER_TRACK_ALLOCATIONS)
+
 namespace {
 
 void ExecuteStubGetSession(int* count,
-                           const base::DictionaryValue& params,
+                           std::unique_ptr<base::DictionaryValue> params,
                            const std::string& session_id,
                            const CommandCallback& callback) {
   if (*count == 0) {
@@ -148,11 +180,10 @@ TEST(CommandsTest, GetSessions) {
 
   Command cmd = base::BindRepeating(&ExecuteStubGetSession, &count);
 
-  base::DictionaryValue params;
   base::test::SingleThreadTaskEnvironment task_environment;
 
-  ExecuteGetSessions(cmd, &map, params, std::string(),
-                     base::BindRepeating(&OnGetSessions));
+  ExecuteGetSessions(cmd, &map, std::make_unique<base::DictionaryValue>(),
+                     std::string(), base::BindRepeating(&OnGetSessions));
   ASSERT_EQ(2, count);
 }
 
@@ -160,7 +191,7 @@ namespace {
 
 void ExecuteStubQuit(
     int* count,
-    const base::DictionaryValue& params,
+    std::unique_ptr<base::DictionaryValue> params,
     const std::string& session_id,
     const CommandCallback& callback) {
   if (*count == 0) {
@@ -191,10 +222,9 @@ TEST(CommandsTest, QuitAll) {
 
   int count = 0;
   Command cmd = base::BindRepeating(&ExecuteStubQuit, &count);
-  base::DictionaryValue params;
   base::test::SingleThreadTaskEnvironment task_environment;
-  ExecuteQuitAll(cmd, &map, params, std::string(),
-                 base::BindRepeating(&OnQuitAll));
+  ExecuteQuitAll(cmd, &map, std::make_unique<base::DictionaryValue>(),
+                 std::string(), base::BindRepeating(&OnQuitAll));
   ASSERT_EQ(2, count);
 }
 
@@ -231,14 +261,47 @@ void OnSimpleCommand(base::RunLoop* run_loop,
 TEST(CommandsTest, ExecuteSessionCommand) {
   SessionThreadMap map;
   auto threadInfo = std::make_unique<SessionThreadInfo>("1", true);
-  base::Thread* thread = threadInfo->thread();
-  ASSERT_TRUE(thread->Start());
+  ASSERT_TRUE(threadInfo->Start());
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner =
+      threadInfo->task_runner();
+  std::string id("id");
+  task_runner->PostTask(
+      FROM_HERE,
+      base::BindOnce(&internal::CreateSessionOnSessionThreadForTesting, id));
+  map[id] = std::move(threadInfo);
+
+  base::DictionaryValue params;
+  params.SetInteger("param", 5);
+  base::Value expected_value(6);
+  SessionCommand cmd =
+      base::BindRepeating(&ExecuteSimpleCommand, id, &params, &expected_value);
+
+  base::test::SingleThreadTaskEnvironment task_environment;
+  base::RunLoop run_loop;
+  ExecuteSessionCommand(
+      &map, "cmd", cmd, true /*w3c_standard_command*/, false,
+      params.CreateDeepCopy(), id,
+      base::BindRepeating(&OnSimpleCommand, &run_loop, id, &expected_value));
+  run_loop.Run();
+}
+
+TEST(CommandsTest, ExecuteSessionCommandTouchesActivityStamp) {
+  SessionThreadMap map;
+  auto threadInfo = std::make_unique<SessionThreadInfo>("1", true);
+  ASSERT_TRUE(threadInfo->Start());
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner =
+      threadInfo->task_runner();
   std::string id("id");
-  thread->task_runner()->PostTask(
+  task_runner->PostTask(
       FROM_HERE,
       base::BindOnce(&internal::CreateSessionOnSessionThreadForTesting, id));
   map[id] = std::move(threadInfo);
 
+  base::TimeTicks before = map[id]->LastActivity();
+  ASSERT_FALSE(before.is_null());
+  // TimeTicks can be coarse, so make sure the clock moves before dispatch.
+  base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(5));
+
   base::DictionaryValue params;
   params.SetInteger("param", 5);
   base::Value expected_value(6);
@@ -248,9 +311,41 @@ TEST(CommandsTest, ExecuteSessionCommand) {
   base::test::SingleThreadTaskEnvironment task_environment;
   base::RunLoop run_loop;
   ExecuteSessionCommand(
-      &map, "cmd", cmd, true /*w3c_standard_command*/, false, params, id,
+      &map, "cmd", cmd, true /*w3c_standard_command*/, false,
+      params.CreateDeepCopy(), id,
       base::BindRepeating(&OnSimpleCommand, &run_loop, id, &expected_value));
   run_loop.Run();
+  ASSERT_GT(map[id]->LastActivity(), before);
+}
+
+TEST(CommandsTest, ExecuteSessionCommandOnPooledExecutor) {
+  SessionThreadInfo::SetUsePooledExecutor(true);
+  base::test::TaskEnvironment task_environment;
+
+  SessionThreadMap map;
+  auto threadInfo = std::make_unique<SessionThreadInfo>("1", true);
+  ASSERT_TRUE(threadInfo->Start());
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner =
+      threadInfo->task_runner();
+  std::string id("id");
+  task_runner->PostTask(
+      FROM_HERE,
+      base::BindOnce(&internal::CreateSessionOnSessionThreadForTesting, id));
+  map[id] = std::move(threadInfo);
+
+  base::DictionaryValue params;
+  params.SetInteger("param", 5);
+  base::Value expected_value(6);
+  SessionCommand cmd =
+      base::BindRepeating(&ExecuteSimpleCommand, id, &params, &expected_value);
+
+  base::RunLoop run_loop;
+  ExecuteSessionCommand(
+      &map, "cmd", cmd, true /*w3c_standard_command*/, false,
+      params.CreateDeepCopy(), id,
+      base::BindRepeating(&OnSimpleCommand, &run_loop, id, &expected_value));
+  run_loop.Run();
+  SessionThreadInfo::SetUsePooledExecutor(false);
 }
 
 namespace {
@@ -282,17 +377,17 @@ void OnNoSuchSessionIsOk(const Status& status,
 
 TEST(CommandsTest, ExecuteSessionCommandOnNoSuchSession) {
   SessionThreadMap map;
-  base::DictionaryValue params;
   ExecuteSessionCommand(&map, "cmd", base::BindRepeating(&ShouldNotBeCalled),
-                        true /*w3c_standard_command*/, false, params, "session",
+                        true /*w3c_standard_command*/, false,
+                        std::make_unique<base::DictionaryValue>(), "session",
                         base::BindRepeating(&OnNoSuchSession));
 }
 
 TEST(CommandsTest, ExecuteSessionCommandOnNoSuchSessionWhenItExpectsOk) {
   SessionThreadMap map;
-  base::DictionaryValue params;
   ExecuteSessionCommand(&map, "cmd", base::BindRepeating(&ShouldNotBeCalled),
-                        true /*w3c_standard_command*/, true, params, "session",
+                        true /*w3c_standard_command*/, true,
+                        std::make_unique<base::DictionaryValue>(), "session",
                         base::BindRepeating(&OnNoSuchSessionIsOk));
 }
 
@@ -313,7 +408,7 @@ void OnNoSuchSessionAndQuit(base::RunLoop* run_loop,
 TEST(CommandsTest, ExecuteSessionCommandOnJustDeletedSession) {
   SessionThreadMap map;
   auto threadInfo = std::make_unique<SessionThreadInfo>("1", true);
-  ASSERT_TRUE(threadInfo->thread()->Start());
+  ASSERT_TRUE(threadInfo->Start());
   std::string id("id");
   map[id] = std::move(threadInfo);
 
@@ -321,13 +416,59 @@ TEST(CommandsTest, ExecuteSessionCommandOnJustDeletedSession) {
   base::RunLoop run_loop;
   ExecuteSessionCommand(
       &map, "cmd", base::BindRepeating(&ShouldNotBeCalled),
-      true /*w3c_standard_command*/, false, base::DictionaryValue(), "session",
+      true /*w3c_standard_command*/, false,
+      std::make_unique<base::DictionaryValue>(), "session",
       base::BindRepeating(&OnNoSuchSessionAndQuit, &run_loop));
   run_loop.Run();
 }
 
 namespace {
 
+void OnSessionOverloaded(const Status& status,
+                         std::unique_ptr<base::Value> value,
+                         const std::string& session_id,
+                         bool w3c_compliant) {
+  EXPECT_EQ(kSessionOverloaded, status.code());
+  EXPECT_FALSE(value.get());
+}
+
+}  // namespace
+
+TEST(CommandsTest, ExecuteSessionCommandShedsLoadWhenBacklogIsFull) {
+  SessionThreadMap map;
+  auto threadInfo = std::make_unique<SessionThreadInfo>("1", true);
+  ASSERT_TRUE(threadInfo->Start());
+  std::string id("id");
+  map[id] = std::move(threadInfo);
+
+  // Pretend the session thread already has a full queue.
+  scoped_refptr<SessionMemoryStats> stats =
+      SessionMetrics::GetInstance()->Register(id);
+  stats->command_backlog.store(1000, std::memory_order_relaxed);
+
+  base::test::SingleThreadTaskEnvironment task_environment;
+  ExecuteSessionCommand(&map, "cmd", base::BindRepeating(&ShouldNotBeCalled),
+                        true /*w3c_standard_command*/, false,
+                        std::make_unique<base::DictionaryValue>(), id,
+                        base::BindRepeating(&OnSessionOverloaded));
+  EXPECT_EQ(1, stats->commands_rejected.load(std::memory_order_relaxed));
+
+  // Quit bypasses admission control so an overloaded session can still be
+  // torn down; no session lives on the thread, so it reports invalid id.
+  base::RunLoop run_loop;
+  ExecuteSessionCommand(
+      &map, "Quit", base::BindRepeating(&ShouldNotBeCalled),
+      true /*w3c_standard_command*/, false,
+      std::make_unique<base::DictionaryValue>(), id,
+      base::BindRepeating(&OnNoSuchSessionAndQuit, &run_loop));
+  run_loop.Run();
+
+  stats->command_backlog.store(0, std::memory_order_relaxed);
+  SessionMetrics::GetInstance()->Unregister(id);
+}
+
+namespace {
+
 enum TestScenario {
   kElementExistsQueryOnce = 0,
   kElementExistsQueryTwice,
@@ -380,6 +521,12 @@ class FindElementWebView : public StubWebView {
       function = webdriver::atoms::asString(webdriver::atoms::FIND_ELEMENT);
     else
       function = webdriver::atoms::asString(webdriver::atoms::FIND_ELEMENTS);
+    // Document-rooted finds run the atom under the page-side memoization
+    // wrapper; see FindElement in element_util.cc.
+    function = base::StringPrintf(
+        "function() { return (%s).call(null, %s,"
+        " Array.prototype.slice.call(arguments), %s); }",
+        kMemoizedFindScript, function.c_str(), only_one_ ? "true" : "false");
     EXPECT_EQ(function, function_);
     ASSERT_TRUE(args_.get());
     EXPECT_TRUE(expected_args->Equals(args_.get()));
@@ -501,6 +648,107 @@ TEST(CommandsTest, FailedFindElements) {
   ASSERT_EQ(0U, list->GetSize());
 }
 
+namespace {
+
+// Returns what the pagination wrapper in FindElement produces in the page:
+// the total match count plus the requested window of element handles.
+class PagedFindElementWebView : public StubWebView {
+ public:
+  PagedFindElementWebView(int total, int returned)
+      : StubWebView("1"), total_(total), returned_(returned) {}
+  ~PagedFindElementWebView() override {}
+
+  // Overridden from WebView:
+  Status CallFunction(const std::string& frame,
+                      const std::string& function,
+                      const base::ListValue& args,
+                      std::unique_ptr<base::Value>* result) override {
+    function_ = function;
+    base::DictionaryValue page;
+    page.SetInteger("total", total_);
+    std::unique_ptr<base::ListValue> elements(new base::ListValue());
+    for (int i = 0; i < returned_; ++i) {
+      base::DictionaryValue element;
+      element.SetString("ELEMENT", base::StringPrintf("%d", i));
+      elements->Append(element.CreateDeepCopy());
+    }
+    page.Set("elements", std::move(elements));
+    *result = page.CreateDeepCopy();
+    return Status(kOk);
+  }
+
+  std::string function_;
+
+ private:
+  int total_;
+  int returned_;
+};
+
+}  // namespace
+
+TEST(CommandsTest, PagedFindElementsReturnsWindowAndNextCursor) {
+  PagedFindElementWebView web_view(5, 2);
+  Session session("id");
+  base::DictionaryValue params;
+  params.SetString("using", "css selector");
+  params.SetString("value", "div");
+  params.SetInteger("maxResults", 2);
+  params.SetInteger("cursor", 1);
+  std::unique_ptr<base::Value> result;
+  ASSERT_EQ(kOk,
+            ExecuteFindElements(1, &session, &web_view, params, &result,
+                                nullptr).code());
+  // The slice bounds are baked into the wrapper so the page never serializes
+  // matches outside the window.
+  EXPECT_NE(std::string::npos, web_view.function_.find("slice(1, 3)"));
+  base::DictionaryValue* page;
+  ASSERT_TRUE(result->GetAsDictionary(&page));
+  int total = 0;
+  EXPECT_TRUE(page->GetInteger("total", &total));
+  EXPECT_EQ(5, total);
+  base::ListValue* elements;
+  ASSERT_TRUE(page->GetList("elements", &elements));
+  EXPECT_EQ(2U, elements->GetSize());
+  int next_cursor = 0;
+  EXPECT_TRUE(page->GetInteger("nextCursor", &next_cursor));
+  EXPECT_EQ(3, next_cursor);
+}
+
+TEST(CommandsTest, PagedFindElementsLastPageOmitsNextCursor) {
+  PagedFindElementWebView web_view(3, 1);
+  Session session("id");
+  base::DictionaryValue params;
+  params.SetString("using", "css selector");
+  params.SetString("value", "div");
+  params.SetInteger("maxResults", 2);
+  params.SetInteger("cursor", 2);
+  std::unique_ptr<base::Value> result;
+  ASSERT_EQ(kOk,
+            ExecuteFindElements(1, &session, &web_view, params, &result,
+                                nullptr).code());
+  base::DictionaryValue* page;
+  ASSERT_TRUE(result->GetAsDictionary(&page));
+  EXPECT_FALSE(page->HasKey("nextCursor"));
+}
+
+TEST(CommandsTest, PagedFindElementsRejectsInvalidPagination) {
+  StubWebView web_view("1");
+  Session session("id");
+  base::DictionaryValue params;
+  params.SetString("using", "css selector");
+  params.SetString("value", "div");
+  params.SetInteger("maxResults", 0);
+  std::unique_ptr<base::Value> result;
+  ASSERT_EQ(kInvalidArgument,
+            ExecuteFindElements(1, &session, &web_view, params, &result,
+                                nullptr).code());
+  params.Remove("maxResults", nullptr);
+  params.SetInteger("cursor", 1);
+  ASSERT_EQ(kInvalidArgument,
+            ExecuteFindElements(1, &session, &web_view, params, &result,
+                                nullptr).code());
+}
+
 TEST(CommandsTest, SuccessfulFindChildElement) {
   FindElementWebView web_view(true, kElementExistsQueryTwice);
   Session session("id");
@@ -704,10 +952,11 @@ void OnSessionCommand(base::RunLoop* run_loop,
 TEST(CommandsTest, SuccessNotifyingCommandListeners) {
   SessionThreadMap map;
   auto threadInfo = std::make_unique<SessionThreadInfo>("1", true);
-  base::Thread* thread = threadInfo->thread();
-  ASSERT_TRUE(thread->Start());
+  ASSERT_TRUE(threadInfo->Start());
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner =
+      threadInfo->task_runner();
   std::string id("id");
-  thread->task_runner()->PostTask(
+  task_runner->PostTask(
       FROM_HERE,
       base::BindOnce(&internal::CreateSessionOnSessionThreadForTesting, id));
 
@@ -728,7 +977,8 @@ TEST(CommandsTest, SuccessNotifyingCommandListeners) {
   // Here, the command adds |listener| to the session, so |listener|
   // should not be notified since it will not have been added yet.
   ExecuteSessionCommand(
-      &map, "cmd", cmd, true /*w3c_standard_command*/, false, params, id,
+      &map, "cmd", cmd, true /*w3c_standard_command*/, false,
+      params.CreateDeepCopy(), id,
       base::BindRepeating(&OnSessionCommand, &run_loop_addlistener));
   run_loop_addlistener.Run();
 
@@ -740,7 +990,8 @@ TEST(CommandsTest, SuccessNotifyingCommandListeners) {
   // |listener| was added to |session| by ExecuteAddListenerToSessionCommand
   // and should be notified before the next command, ExecuteQuitSessionCommand.
   ExecuteSessionCommand(
-      &map, "cmd", cmd, true /*w3c_standard_command*/, false, params, id,
+      &map, "cmd", cmd, true /*w3c_standard_command*/, false,
+      params.CreateDeepCopy(), id,
       base::BindRepeating(&OnSessionCommand, &run_loop_testlistener));
   run_loop_testlistener.Run();
 
@@ -786,10 +1037,11 @@ void VerifySessionWasDeleted() {
 TEST(CommandsTest, ErrorNotifyingCommandListeners) {
   SessionThreadMap map;
   auto threadInfo = std::make_unique<SessionThreadInfo>("1", true);
-  base::Thread* thread = threadInfo->thread();
-  ASSERT_TRUE(thread->Start());
+  ASSERT_TRUE(threadInfo->Start());
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner =
+      threadInfo->task_runner();
   std::string id("id");
-  thread->task_runner()->PostTask(
+  task_runner->PostTask(
       FROM_HERE,
       base::BindOnce(&internal::CreateSessionOnSessionThreadForTesting, id));
   map[id] = std::move(threadInfo);
@@ -798,7 +1050,7 @@ TEST(CommandsTest, ErrorNotifyingCommandListeners) {
   // was called before (as opposed to after) command execution. We don't need to
   // verify this again, so we can just add |listener| with PostTask.
   auto listener = std::make_unique<FailingCommandListener>();
-  thread->task_runner()->PostTask(
+  task_runner->PostTask(
       FROM_HERE, base::BindOnce(&AddListenerToSessionIfSessionExists,
                                 std::move(listener)));
 
@@ -809,10 +1061,10 @@ TEST(CommandsTest, ErrorNotifyingCommandListeners) {
   base::RunLoop run_loop;
 
   ExecuteSessionCommand(
-      &map, "cmd", cmd, true /*w3c_standard_command*/, false, params, id,
+      &map, "cmd", cmd, true /*w3c_standard_command*/, false,
+      params.CreateDeepCopy(), id,
       base::BindRepeating(&OnFailBecauseErrorNotifyingListeners, &run_loop));
   run_loop.Run();
 
-  thread->task_runner()->PostTask(FROM_HERE,
-                                  base::BindOnce(&VerifySessionWasDeleted));
+  task_runner->PostTask(FROM_HERE, base::BindOnce(&VerifySessionWasDeleted));
 }
@@ -32,10 +32,13 @@ def WriteSource(base_name,
       '//     %s')
   copyright_header = copyright_header_template % (' '.join(sys.argv))
 
-  # Write header file.
+  # Write header file. Each string constant is accompanied by a <name>Len
+  # size constant, so C++ code that splices the string into a larger buffer
+  # can reserve and append without a strlen pass over tens of kilobytes.
   externs = []
   for name in global_string_map.keys():
-    externs += ['extern const char %s[];' % name]
+    externs += ['extern const char %s[];' % name,
+                'extern const size_t %sLen;' % name]
 
   temp = '_'.join(dir_from_src.split('/') + [base_name])
   define = temp.upper() + '_H_'
@@ -45,6 +48,8 @@ def WriteSource(base_name,
       '#ifndef ' + define,
       '#define ' + define,
       '',
+      '#include <stddef.h>',
+      '',
       '\n'.join(externs),
       '',
       '#endif  // ' + define])
@@ -66,6 +71,7 @@ def WriteSource(base_name,
       for line in contents.split('\n'):
         lines += ['    "%s\\n"' % EscapeLine(line)]
     definitions += ['const char %s[] =\n%s;' % (name, '\n'.join(lines))]
+    definitions += ['const size_t %sLen = sizeof(%s) - 1;' % (name, name)]
 
   cc = '\n'.join([
       copyright_header,
@@ -5,6 +5,7 @@
 #include "chrome/test/chromedriver/devtools_events_logger.h"
 
 #include "base/json/json_writer.h"
+#include "base/strings/stringprintf.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/devtools_client.h"
 #include "chrome/test/chromedriver/chrome/devtools_client_impl.h"
@@ -30,13 +31,14 @@ Status DevToolsEventsLogger::OnEvent(DevToolsClient* client,
                                      const base::DictionaryValue& params) {
   auto it = events_.find(method);
   if (it != events_.end()) {
-    base::DictionaryValue log_message_dict;
-    log_message_dict.SetString("method", method);
-    log_message_dict.SetKey("params", params.Clone());
-    std::string log_message_json;
-    base::JSONWriter::Write(log_message_dict, &log_message_json);
-
-    log_->AddEntry(Log::kInfo, log_message_json);
+    // Serialize the params in place and assemble the envelope directly,
+    // instead of deep-copying them into a wrapper dictionary first. |method|
+    // is a DevTools method name (domain.event), so it never needs escaping.
+    std::string params_json;
+    base::JSONWriter::Write(params, &params_json);
+    log_->AddEntry(Log::kInfo,
+                   base::StringPrintf("{\"method\":\"%s\",\"params\":%s}",
+                                      method.c_str(), params_json.c_str()));
   }
   return Status(kOk);
 }
@@ -28,6 +28,7 @@
 #include "chrome/test/chromedriver/chrome/web_view.h"
 #include "chrome/test/chromedriver/constants/version.h"
 #include "chrome/test/chromedriver/element_util.h"
+#include "chrome/test/chromedriver/net/timeout.h"
 #include "chrome/test/chromedriver/session.h"
 #include "chrome/test/chromedriver/util.h"
 #include "third_party/webdriver/atoms.h"
@@ -101,7 +102,8 @@ Status FocusToElement(
     return status;
   bool is_displayed = false;
   bool is_focused = false;
-  base::TimeTicks start_time = base::TimeTicks::Now();
+  Timeout timeout(session->implicit_wait);
+  AdaptiveWaiter waiter(base::TimeDelta::FromMilliseconds(100));
   while (true) {
     status = IsElementDisplayed(
         session, web_view, element_id, true, &is_displayed);
@@ -114,10 +116,10 @@ Status FocusToElement(
       return status;
     if (is_focused)
       break;
-    if (base::TimeTicks::Now() - start_time >= session->implicit_wait) {
+    if (timeout.IsExpired()) {
       return Status(kElementNotVisible);
     }
-    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(100));
+    waiter.Wait(&timeout);
   }
 
   bool is_enabled = false;
@@ -170,7 +172,8 @@ Status SendKeysToElement(Session* session,
     if (status.IsError())
       return status;
   }
-  return SendKeysOnWindow(web_view, key_list, true, &session->sticky_modifiers);
+  return SendKeysOnWindow(web_view, key_list, true, &session->sticky_modifiers,
+                          session->fast_typing);
 }
 
 }  // namespace
@@ -182,9 +185,11 @@ Status ExecuteElementCommand(
     const base::DictionaryValue& params,
     std::unique_ptr<base::Value>* value,
     Timeout* timeout) {
-  std::string id;
-  if (params.GetString("id", &id) || params.GetString("element", &id))
-    return command.Run(session, web_view, id, params, value);
+  const std::string* id = params.FindStringKey("id");
+  if (!id)
+    id = params.FindStringKey("element");
+  if (id)
+    return command.Run(session, web_view, *id, params, value);
   return Status(kInvalidArgument, "element identifier must be a string");
 }
 
@@ -341,6 +346,14 @@ Status ExecuteFlick(Session* session,
   if (speed < 1)
     return Status(kInvalidArgument, "'speed' must be a positive integer");
 
+  // One browser-side gesture costs a single round trip regardless of the
+  // flick distance; the stepped fallback below replays the gesture as
+  // individual touch events with wall-clock pacing.
+  if (!session->stepped_touch_gestures) {
+    return web_view->SynthesizeScrollGesture(location.x, location.y, xoffset,
+                                             yoffset, speed);
+  }
+
   status = web_view->DispatchTouchEvent(
       TouchEvent(kTouchStart, location.x, location.y), false);
   if (status.IsError())
@@ -428,7 +441,8 @@ Status ExecuteClearElement(Session* session,
     return Status(kInvalidElementState);
   // Scrolling to element is done by webdriver::atoms::CLEAR
   bool is_displayed = false;
-  base::TimeTicks start_time = base::TimeTicks::Now();
+  Timeout timeout(session->implicit_wait);
+  AdaptiveWaiter waiter(base::TimeDelta::FromMilliseconds(50));
   while (true) {
     status = IsElementDisplayed(
       session, web_view, element_id, true, &is_displayed);
@@ -436,10 +450,10 @@ Status ExecuteClearElement(Session* session,
       return status;
     if (is_displayed)
       break;
-    if (base::TimeTicks::Now() - start_time >= session->implicit_wait) {
+    if (timeout.IsExpired()) {
       return Status(kElementNotVisible);
     }
-    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(50));
+    waiter.Wait(&timeout);
   }
   static bool isClearWarningNotified = false;
   if (!isClearWarningNotified) {
@@ -715,10 +729,10 @@ Status ExecuteGetElementProperty(Session* session,
   base::ListValue args;
   args.Append(CreateElement(element_id));
 
-  std::string name;
-  if (!params.GetString("name", &name))
+  const std::string* name = params.FindStringKey("name");
+  if (!name)
     return Status(kInvalidArgument, "missing 'name'");
-  args.AppendString(name);
+  args.AppendString(*name);
 
   return web_view->CallFunction(
       session->GetCurrentFrameId(),
@@ -854,11 +868,16 @@ Status ExecuteIsElementDisplayed(Session* session,
     return status;
   base::ListValue args;
   args.Append(CreateElement(element_id));
-  return web_view->CallFunction(
-      session->GetCurrentFrameId(),
-      webdriver::atoms::asString(webdriver::atoms::IS_DISPLAYED),
-      args,
-      value);
+  // The fast path answers visible-and-intersecting elements from cheap
+  // in-page probes and falls back to the atom itself, so either way the
+  // command is a single evaluation.
+  std::string script = base::StringPrintf(
+      "function() { return (%s).call(null, %s,"
+      " Array.prototype.slice.call(arguments)); }",
+      kIsDisplayedFastScript,
+      webdriver::atoms::asString(webdriver::atoms::IS_DISPLAYED).c_str());
+  return web_view->CallFunction(session->GetCurrentFrameId(), script, args,
+                                value);
 }
 
 Status ExecuteGetElementLocation(Session* session,
@@ -931,7 +950,7 @@ Status ExecuteGetElementRect(Session* session,
   ret.SetDouble("y", y);
   ret.SetDouble("width", width);
   ret.SetDouble("height", height);
-  value->reset(ret.DeepCopy());
+  *value = base::Value::ToUniquePtrValue(std::move(ret));
   return Status(kOk);
 }
 
@@ -973,8 +992,8 @@ Status ExecuteGetElementAttribute(Session* session,
                                   const std::string& element_id,
                                   const base::DictionaryValue& params,
                                   std::unique_ptr<base::Value>* value) {
-  std::string attribute_name;
-  if (!params.GetString("name", &attribute_name))
+  const std::string* attribute_name = params.FindStringKey("name");
+  if (!attribute_name)
     return Status(kInvalidArgument, "missing 'name'");
 
   Status status = CheckElement(element_id);
@@ -982,15 +1001,74 @@ Status ExecuteGetElementAttribute(Session* session,
     return status;
   base::ListValue args;
   args.Append(CreateElement(element_id));
-  args.AppendString(attribute_name);
+  args.AppendString(*attribute_name);
   return web_view->CallFunction(
       session->GetCurrentFrameId(),
-      booleanAttributes.count(base::ToLowerASCII(attribute_name))
+      booleanAttributes.count(base::ToLowerASCII(*attribute_name))
           ? "(elem, attribute) => elem.hasAttribute(attribute) ? 'true' : null"
           : "(elem, attribute) => elem.getAttribute(attribute)",
       args, value);
 }
 
+Status ExecuteGetElementState(Session* session,
+                              WebView* web_view,
+                              const std::string& element_id,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value) {
+  Status status = CheckElement(element_id);
+  if (status.IsError())
+    return status;
+
+  // Attribute names are resolved to lookup specs here so the snippet applies
+  // the same boolean-attribute normalization as the attribute command.
+  auto attribute_specs = std::make_unique<base::ListValue>();
+  const base::ListValue* attribute_names = nullptr;
+  if (params.HasKey("attributes")) {
+    if (!params.GetList("attributes", &attribute_names))
+      return Status(kInvalidArgument, "'attributes' must be a list");
+    for (const base::Value& name : attribute_names->GetList()) {
+      if (!name.is_string())
+        return Status(kInvalidArgument, "attribute names must be strings");
+      auto spec = std::make_unique<base::DictionaryValue>();
+      spec->SetString("name", name.GetString());
+      spec->SetBoolean(
+          "isBoolean",
+          booleanAttributes.count(base::ToLowerASCII(name.GetString())) > 0);
+      attribute_specs->Append(std::move(spec));
+    }
+  }
+
+  auto property_names = std::make_unique<base::ListValue>();
+  const base::ListValue* properties = nullptr;
+  if (params.HasKey("properties")) {
+    if (!params.GetList("properties", &properties))
+      return Status(kInvalidArgument, "'properties' must be a list");
+    for (const base::Value& name : properties->GetList()) {
+      if (!name.is_string())
+        return Status(kInvalidArgument, "property names must be strings");
+    }
+    property_names = properties->CreateDeepCopy();
+  }
+
+  base::ListValue args;
+  args.Append(CreateElement(element_id));
+  args.Append(std::move(attribute_specs));
+  args.Append(std::move(property_names));
+
+  // Inject the standard atoms into the snippet so the combined evaluation
+  // reports exactly what the individual commands would, in one round trip.
+  std::string script = base::StringPrintf(
+      "function() { return (%s).call(null, %s, %s, %s, %s,"
+      " Array.prototype.slice.call(arguments)); }",
+      kGetElementStateScript,
+      webdriver::atoms::asString(webdriver::atoms::IS_DISPLAYED).c_str(),
+      webdriver::atoms::asString(webdriver::atoms::IS_ENABLED).c_str(),
+      webdriver::atoms::asString(webdriver::atoms::GET_LOCATION).c_str(),
+      webdriver::atoms::asString(webdriver::atoms::GET_SIZE).c_str());
+  return web_view->CallFunction(session->GetCurrentFrameId(), script, args,
+                                value);
+}
+
 Status ExecuteGetElementValueOfCSSProperty(
                                       Session* session,
                                       WebView* web_view,
@@ -1005,12 +1083,12 @@ Status ExecuteGetElementValueOfCSSProperty(
   if (is_xml) {
     *value = std::make_unique<base::Value>("");
   } else {
-    std::string property_name;
-    if (!params.GetString("propertyName", &property_name))
+    const std::string* property_name = params.FindStringKey("propertyName");
+    if (!property_name)
       return Status(kInvalidArgument, "missing 'propertyName'");
     std::string property_value;
     status = GetElementEffectiveStyle(
-        session, web_view, element_id, property_name, &property_value);
+        session, web_view, element_id, *property_name, &property_value);
     if (status.IsError())
       return status;
     *value = std::make_unique<base::Value>(property_value);
@@ -1023,10 +1101,10 @@ Status ExecuteElementEquals(Session* session,
                             const std::string& element_id,
                             const base::DictionaryValue& params,
                             std::unique_ptr<base::Value>* value) {
-  std::string other_element_id;
-  if (!params.GetString("other", &other_element_id))
+  const std::string* other_element_id = params.FindStringKey("other");
+  if (!other_element_id)
     return Status(kInvalidArgument, "'other' must be a string");
-  *value = std::make_unique<base::Value>(element_id == other_element_id);
+  *value = std::make_unique<base::Value>(element_id == *other_element_id);
   return Status(kOk);
 }
 
@@ -1035,10 +1113,56 @@ Status ExecuteElementScreenshot(Session* session,
                                 const std::string& element_id,
                                 const base::DictionaryValue& params,
                                 std::unique_ptr<base::Value>* value) {
-  Status status = session->chrome->ActivateWebView(web_view->GetId());
+  Status status = session->chrome->ActivateWebView(web_view->GetId(), false);
   if (status.IsError())
     return status;
 
+  // When the element lives in the top-level document, a single combined
+  // script scrolls it into view, measures it and derives the capture clip,
+  // so the screenshot costs one evaluation plus the capture. Elements in
+  // frames still take the multi-step path below, which walks the frame
+  // chain to translate coordinates and adjust ancestor scrolling.
+  if (session->frames.empty()) {
+    status = CheckElement(element_id);
+    if (status.IsError())
+      return status;
+    base::ListValue args;
+    args.Append(CreateElement(element_id));
+    std::unique_ptr<base::Value> clip_value;
+    status = web_view->CallFunction(session->GetCurrentFrameId(),
+                                    kGetElementScreenshotClipScript, args,
+                                    &clip_value);
+    if (status.IsError())
+      return status;
+    base::DictionaryValue* clip_info;
+    if (!clip_value->GetAsDictionary(&clip_info))
+      return Status(kUnknownError, "screenshot clip is not a dictionary");
+    auto clip_dict = std::make_unique<base::DictionaryValue>();
+    for (const char* key : {"x", "y", "width", "height"}) {
+      base::Value* clip_member = clip_info->FindKey(key);
+      if (!clip_member)
+        return Status(kUnknownError,
+                      std::string("screenshot clip missing ") + key);
+      clip_dict->SetDouble(key, clip_member->GetDouble());
+    }
+    base::Value* pixel_ratio = clip_info->FindKey("devicePixelRatio");
+    if (!pixel_ratio)
+      return Status(kUnknownError, "screenshot clip missing devicePixelRatio");
+    clip_dict->SetDouble("scale", 1 / pixel_ratio->GetDouble());
+    base::DictionaryValue screenshot_params;
+    screenshot_params.SetDictionary("clip", std::move(clip_dict));
+    status = ParseScreenshotCaptureParams(params, &screenshot_params);
+    if (status.IsError())
+      return status;
+
+    std::string screenshot;
+    status = web_view->CaptureScreenshot(&screenshot, screenshot_params);
+    if (status.IsError())
+      return status;
+    *value = std::make_unique<base::Value>(screenshot);
+    return Status(kOk);
+  }
+
   WebPoint offset(0, 0);
   WebPoint location;
   status =
@@ -1100,6 +1224,9 @@ Status ExecuteElementScreenshot(Session* session,
       std::min(viewport_width, clip_dict->FindKey("width")->GetDouble()));
   base::DictionaryValue screenshot_params;
   screenshot_params.SetDictionary("clip", std::move(clip_dict));
+  status = ParseScreenshotCaptureParams(params, &screenshot_params);
+  if (status.IsError())
+    return status;
 
   std::string screenshot;
   status = web_view->CaptureScreenshot(&screenshot, screenshot_params);
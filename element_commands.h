@@ -200,6 +200,15 @@ Status ExecuteGetElementAttribute(Session* session,
                                   const base::DictionaryValue& params,
                                   std::unique_ptr<base::Value>* value);
 
+// Returns displayedness, enabled state, rect, and any requested attributes
+// ("attributes") and properties ("properties") of an element in a single
+// page evaluation, saving the round trips of querying each separately.
+Status ExecuteGetElementState(Session* session,
+                              WebView* web_view,
+                              const std::string& element_id,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value);
+
 // Returns the effective style for a given property of the specified element.
 Status ExecuteGetElementValueOfCSSProperty(Session* session,
                                            WebView* web_view,
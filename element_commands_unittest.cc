@@ -4,11 +4,13 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/stub_chrome.h"
 #include "chrome/test/chromedriver/chrome/stub_web_view.h"
+#include "chrome/test/chromedriver/chrome/ui_events.h"
 #include "chrome/test/chromedriver/element_commands.h"
 #include "chrome/test/chromedriver/session.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -96,3 +98,151 @@ TEST(ElementCommandsTest, ExecuteGetElementRect_SizeError) {
                                      params, &result_value);
   ASSERT_EQ(kStaleElementReference, status.code()) << status.message();
 }
+
+namespace {
+
+class StoreStateArgsWebView : public StubWebView {
+ public:
+  StoreStateArgsWebView() : StubWebView("1") {}
+  ~StoreStateArgsWebView() override = default;
+
+  Status CallFunction(const std::string& frame,
+                      const std::string& function,
+                      const base::ListValue& args,
+                      std::unique_ptr<base::Value>* result) override {
+    function_ = function;
+    args_ = args.CreateDeepCopy();
+    *result = std::make_unique<base::DictionaryValue>();
+    return Status(kOk);
+  }
+
+  std::string function_;
+  std::unique_ptr<base::ListValue> args_;
+};
+
+}  // namespace
+
+TEST(ElementCommandsTest, ExecuteGetElementState_BuildsAttributeSpecs) {
+  StoreStateArgsWebView webview;
+  base::DictionaryValue params;
+  base::Value::ListStorage attributes;
+  attributes.emplace_back("checked");
+  attributes.emplace_back("class");
+  params.SetKey("attributes", base::Value(std::move(attributes)));
+  base::Value::ListStorage properties;
+  properties.emplace_back("value");
+  params.SetKey("properties", base::Value(std::move(properties)));
+
+  Status status = CallElementCommand(ExecuteGetElementState, &webview,
+                                     "3247f4d1-ce70-49e9-9a99-bdc7591e032f",
+                                     params);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  ASSERT_TRUE(webview.args_);
+  ASSERT_EQ(3u, webview.args_->GetList().size());
+  const base::Value& specs = webview.args_->GetList()[1];
+  ASSERT_TRUE(specs.is_list());
+  ASSERT_EQ(2u, specs.GetList().size());
+  // "checked" is a boolean attribute, "class" is not.
+  EXPECT_EQ("checked", *specs.GetList()[0].FindStringKey("name"));
+  EXPECT_TRUE(specs.GetList()[0].FindBoolKey("isBoolean").value());
+  EXPECT_EQ("class", *specs.GetList()[1].FindStringKey("name"));
+  EXPECT_FALSE(specs.GetList()[1].FindBoolKey("isBoolean").value());
+  const base::Value& names = webview.args_->GetList()[2];
+  ASSERT_TRUE(names.is_list());
+  ASSERT_EQ(1u, names.GetList().size());
+  EXPECT_EQ("value", names.GetList()[0].GetString());
+  // The combined snippet embeds the displayedness atom.
+  EXPECT_NE(std::string::npos,
+            webview.function_.find(
+                webdriver::atoms::asString(webdriver::atoms::IS_DISPLAYED)));
+}
+
+TEST(ElementCommandsTest, ExecuteGetElementState_RejectsNonListAttributes) {
+  StoreStateArgsWebView webview;
+  base::DictionaryValue params;
+  params.SetString("attributes", "checked");
+  Status status = CallElementCommand(ExecuteGetElementState, &webview,
+                                     "3247f4d1-ce70-49e9-9a99-bdc7591e032f",
+                                     params);
+  ASSERT_EQ(kInvalidArgument, status.code()) << status.message();
+}
+
+namespace {
+
+class OneShotClickWebView : public StubWebView {
+ public:
+  OneShotClickWebView() : StubWebView("1") {}
+  ~OneShotClickWebView() override = default;
+
+  Status CallFunction(const std::string& frame,
+                      const std::string& function,
+                      const base::ListValue& args,
+                      std::unique_ptr<base::Value>* result) override {
+    call_count_++;
+    // The combined click-preparation snippet is the only evaluation that
+    // embeds the clickability atom.
+    if (function.find(webdriver::atoms::asString(
+            webdriver::atoms::IS_ELEMENT_CLICKABLE)) != std::string::npos) {
+      auto prep = std::make_unique<base::DictionaryValue>();
+      prep->SetString("tagName", "div");
+      prep->SetBoolean("displayed", true);
+      if (zero_size_) {
+        prep->SetBoolean("zeroSize", true);
+      } else {
+        prep->SetBoolean("clickable", true);
+        prep->SetInteger("x", 30);
+        prep->SetInteger("y", 40);
+      }
+      *result = std::move(prep);
+      return Status(kOk);
+    }
+    // The remaining evaluation is the tag name lookup.
+    *result = std::make_unique<base::Value>("div");
+    return Status(kOk);
+  }
+
+  Status DispatchMouseEvents(const std::vector<MouseEvent>& events,
+                             const std::string& frame,
+                             bool async_dispatch_events = false) override {
+    dispatch_count_++;
+    events_ = events;
+    return Status(kOk);
+  }
+
+  int call_count_ = 0;
+  int dispatch_count_ = 0;
+  bool zero_size_ = false;
+  std::vector<MouseEvent> events_;
+};
+
+}  // namespace
+
+TEST(ElementCommandsTest, ExecuteClickElement_OneShotPreparation) {
+  OneShotClickWebView webview;
+  base::DictionaryValue params;
+  Status status = CallElementCommand(ExecuteClickElement, &webview,
+                                     "3247f4d1-ce70-49e9-9a99-bdc7591e032f",
+                                     params);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  // One tag name lookup plus one combined preparation evaluation.
+  EXPECT_EQ(2, webview.call_count_);
+  ASSERT_EQ(1, webview.dispatch_count_);
+  // Move, press and release are batched into the single dispatch, aimed at
+  // the coordinates the snippet returned.
+  ASSERT_EQ(3u, webview.events_.size());
+  for (const MouseEvent& event : webview.events_) {
+    EXPECT_EQ(30, event.x);
+    EXPECT_EQ(40, event.y);
+  }
+}
+
+TEST(ElementCommandsTest, ExecuteClickElement_ZeroSizeElement) {
+  OneShotClickWebView webview;
+  webview.zero_size_ = true;
+  base::DictionaryValue params;
+  Status status = CallElementCommand(ExecuteClickElement, &webview,
+                                     "3247f4d1-ce70-49e9-9a99-bdc7591e032f",
+                                     params);
+  ASSERT_EQ(kElementNotInteractable, status.code()) << status.message();
+  EXPECT_EQ(0, webview.dispatch_count_);
+}
@@ -7,6 +7,7 @@
 #include <memory>
 #include <utility>
 
+#include "base/optional.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
@@ -14,6 +15,7 @@
 #include "base/time/time.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/basic_types.h"
+#include "chrome/test/chromedriver/chrome/ax_node_cache.h"
 #include "chrome/test/chromedriver/chrome/browser_info.h"
 #include "chrome/test/chromedriver/chrome/chrome.h"
 #include "chrome/test/chromedriver/chrome/js.h"
@@ -145,9 +147,32 @@ Status ScrollElementRegionIntoViewHelper(
   args.AppendBoolean(center);
   args.Append(CreateValueFrom(region));
   std::unique_ptr<base::Value> result;
-  status = web_view->CallFunction(
-      frame, webdriver::atoms::asString(webdriver::atoms::GET_LOCATION_IN_VIEW),
-      args, &result);
+  // Native path: DOM.scrollIntoViewIfNeeded both scrolls and forces final
+  // layout in one browser call, so a cheap client-rect read replaces the
+  // scrolling atom. When the native scroll is unavailable (older browser,
+  // unresolvable element) the atom performs the scroll as before.
+  bool scrolled_natively = false;
+  status = web_view->ScrollIntoViewIfNeeded(frame, element_id, region,
+                                            &scrolled_natively);
+  if (status.IsError())
+    return status;
+  if (scrolled_natively) {
+    const char kGetRegionLocationScript[] =
+        "function(element, region) {"
+        "  var rect = element.getBoundingClientRect();"
+        "  return {x: rect.left + region.left, y: rect.top + region.top};"
+        "}";
+    base::ListValue measure_args;
+    measure_args.Append(CreateElement(element_id));
+    measure_args.Append(CreateValueFrom(region));
+    status = web_view->CallFunction(frame, kGetRegionLocationScript,
+                                    measure_args, &result);
+  } else {
+    status = web_view->CallFunction(
+        frame,
+        webdriver::atoms::asString(webdriver::atoms::GET_LOCATION_IN_VIEW),
+        args, &result);
+  }
   if (status.IsError())
     return status;
   if (!ParseFromValue(result.get(), &tmp_location)) {
@@ -281,7 +306,7 @@ Status GetElementLocationInViewCenterHelper(const std::string& frame,
 
 }  // namespace
 
-std::string GetElementKey() {
+base::StringPiece GetElementKey() {
   Session* session = GetThreadLocalSession();
   if (session && session->w3c_compliant)
     return kElementKeyW3C;
@@ -292,13 +317,13 @@ std::string GetElementKey() {
 // example of element_id - d9cf1666-0066-4c07-bb86-03edcbab6680
 // should contain only 0-9 or a-f
 // format xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
-Status CheckElement(const std::string& element_id) {
+Status CheckElement(base::StringPiece element_id) {
   Session* session = GetThreadLocalSession();
   if (session && session->w3c_compliant) {
     if (element_id.length()!=36)
       return Status(kNoSuchElement, "Element_id length is invalid");
 
-    for (std::string::size_type i=0; i<element_id.length(); ++i) {
+    for (base::StringPiece::size_type i=0; i<element_id.length(); ++i) {
       if (i==8 || i == 13 || i == 18 || i == 23) {
         if (element_id[i] != '-')
           return Status(kNoSuchElement, "Element_id format is invalid");
@@ -315,7 +340,7 @@ Status CheckElement(const std::string& element_id) {
 }
 
 std::unique_ptr<base::DictionaryValue> CreateElement(
-    const std::string& element_id) {
+    base::StringPiece element_id) {
   std::unique_ptr<base::DictionaryValue> element(new base::DictionaryValue());
   element->SetString(GetElementKey(), element_id);
   return element;
@@ -350,6 +375,54 @@ Status FindElement(int interval_ms,
   if (!params.GetString("value", &target))
     return Status(kInvalidArgument, "'value' must be a string");
 
+  // Opt-in pagination for multi-element finds. When "maxResults" is given,
+  // only that window of matches is serialized out of the page and converted
+  // to element handles; "cursor" (default 0) selects where the window
+  // starts, so a caller can stream a huge match set page by page instead of
+  // paying for one multi-megabyte response.
+  int max_results = 0;
+  int cursor = 0;
+  if (!only_one) {
+    if (params.HasKey("maxResults") &&
+        (!params.GetInteger("maxResults", &max_results) || max_results <= 0)) {
+      return Status(kInvalidArgument,
+                    "'maxResults' must be a positive integer");
+    }
+    if (params.HasKey("cursor") &&
+        (!params.GetInteger("cursor", &cursor) || cursor < 0))
+      return Status(kInvalidArgument, "'cursor' must be a non-negative integer");
+    if (cursor > 0 && max_results <= 0)
+      return Status(kInvalidArgument, "'cursor' requires 'maxResults'");
+  }
+  bool paged = max_results > 0;
+
+  // Native fast path: CSS selector locators — the overwhelming majority of
+  // finds — go straight to the browser's selector engine through the DOM
+  // agent, skipping atom evaluation and result marshaling. A miss with an
+  // implicit wait pending, and any native-side failure (including an invalid
+  // selector, which the atom classifies with the proper status), continue to
+  // the script-based machinery below.
+  if (strategy == "css selector" && !paged) {
+    std::unique_ptr<base::Value> native_result;
+    Status native_status = web_view->FindElementsByCssSelector(
+        session->GetCurrentFrameId(), target, root_element_id, only_one,
+        &native_result);
+    if (native_status.IsOk() && native_result) {
+      bool found = only_one ? !native_result->is_none()
+                            : native_result->is_list() &&
+                                  native_result->GetList().size() > 0;
+      if (found || session->implicit_wait <= base::TimeDelta()) {
+        if (!found && only_one) {
+          return Status(kNoSuchElement,
+                        "Unable to locate element: {\"method\":\"" + strategy +
+                            "\",\"selector\":\"" + target + "\"}");
+        }
+        *value = std::move(native_result);
+        return Status(kOk);
+      }
+    }
+  }
+
   std::string script;
   if (only_one)
     script = webdriver::atoms::asString(webdriver::atoms::FIND_ELEMENT);
@@ -362,7 +435,72 @@ Status FindElement(int interval_ms,
   if (root_element_id)
     arguments.Append(CreateElement(*root_element_id));
 
+  // Memoize document-rooted finds inside the page, keyed by the locator and
+  // invalidated by a MutationObserver, so retry wrappers re-running an
+  // identical find against a static DOM skip the query. Child finds are
+  // excluded because mutations inside a shadow tree are invisible to a
+  // document-level observer, and pseudo-class selectors because they can
+  // match on element state (:checked, :focus) that changes without any
+  // mutation record.
+  bool memoizable =
+      root_element_id == nullptr &&
+      !(strategy == "css selector" && target.find(':') != std::string::npos);
+  if (memoizable) {
+    script = base::StringPrintf(
+        "function() { return (%s).call(null, %s,"
+        " Array.prototype.slice.call(arguments), %s); }",
+        kMemoizedFindScript, script.c_str(), only_one ? "true" : "false");
+  }
+
+  // The find atom is a compiled blob, so the limit cannot stop its internal
+  // query early; the expensive part of a large find is not the query but
+  // handle creation and serialization of the result list, and slicing here
+  // happens before both. The total count rides along so the caller knows
+  // whether another page exists.
+  if (paged) {
+    script = base::StringPrintf(
+        "function() {"
+        " var matches = (%s).apply(null, arguments) || [];"
+        " return {total: matches.length, elements: matches.slice(%d, %d)}; }",
+        script.c_str(), cursor, cursor + max_results);
+  }
+
   base::TimeTicks start_time = base::TimeTicks::Now();
+
+  // Push-based fast path: run the find atom inside the page under a
+  // MutationObserver, so the call resolves the moment a matching node
+  // appears instead of on the driver's next poll. The observer lives in the
+  // current frame's context; any error (e.g. OOPIF context churn mid-wait)
+  // falls through to the polling loop below, which keeps the old behavior.
+  // Paged finds poll instead: the pagination wrapper always returns an
+  // object, which the in-page waiter would mistake for a match.
+  if (session->implicit_wait > base::TimeDelta() && !paged) {
+    std::string wait_script = base::StringPrintf(
+        "function() { return (%s).call(null, %s,"
+        " Array.prototype.slice.call(arguments), %d); }",
+        kWaitForElementScript, script.c_str(),
+        static_cast<int>(session->implicit_wait.InMilliseconds()));
+    std::unique_ptr<base::Value> temp;
+    Status status = web_view->CallFunctionWithTimeout(
+        session->GetCurrentFrameId(), wait_script, arguments,
+        session->implicit_wait + base::TimeDelta::FromSeconds(10), &temp);
+    if (status.IsOk()) {
+      if (temp && !temp->is_none()) {
+        // A match can only resolve non-null, so no emptiness checks needed.
+        *value = std::move(temp);
+        return Status(kOk);
+      }
+      // The implicit wait elapsed inside the page without a match.
+      if (only_one) {
+        return Status(kNoSuchElement, "Unable to locate element: {\"method\":\""
+         + strategy + "\",\"selector\":\"" + target + "\"}");
+      } else {
+        *value = std::make_unique<base::ListValue>();
+        return Status(kOk);
+      }
+    }
+  }
+
   int context_retry = 0;
   while (true) {
     std::unique_ptr<base::Value> temp;
@@ -380,6 +518,24 @@ Status FindElement(int interval_ms,
       if (only_one) {
         *value = std::move(temp);
         return Status(kOk);
+      } else if (paged) {
+        base::DictionaryValue* page;
+        if (!temp->GetAsDictionary(&page))
+          return Status(kUnknownError, "script returns unexpected result");
+        int total = 0;
+        page->GetInteger("total", &total);
+        if (total > 0) {
+          // Point the caller at the next page; absence of "nextCursor" means
+          // this page reaches the end of the match set.
+          base::ListValue* elements = nullptr;
+          int returned = 0;
+          if (page->GetList("elements", &elements))
+            returned = static_cast<int>(elements->GetSize());
+          if (cursor + returned < total)
+            page->SetInteger("nextCursor", cursor + returned);
+          *value = std::move(temp);
+          return Status(kOk);
+        }
       } else {
         base::ListValue* result;
         if (!temp->GetAsList(&result))
@@ -395,17 +551,59 @@ Status FindElement(int interval_ms,
       if (only_one) {
         return Status(kNoSuchElement, "Unable to locate element: {\"method\":\""
          + strategy + "\",\"selector\":\"" + target + "\"}");
+      } else if (paged) {
+        std::unique_ptr<base::DictionaryValue> page(
+            new base::DictionaryValue());
+        page->SetInteger("total", 0);
+        page->Set("elements", std::make_unique<base::ListValue>());
+        *value = std::move(page);
+        return Status(kOk);
       } else {
         *value = std::make_unique<base::ListValue>();
         return Status(kOk);
       }
     }
+    // The client that issued the command may have hung up; no point waiting
+    // out the rest of the implicit wait with the session thread blocked.
+    if (session->IsCommandCancelled())
+      return Status(kTimeout, "command was cancelled: client closed the "
+                              "connection");
     base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(interval_ms));
   }
 
   return Status(kUnknownError);
 }
 
+Status FindElementsInAllFrames(Session* session,
+                               WebView* web_view,
+                               const base::DictionaryValue& params,
+                               std::unique_ptr<base::Value>* value) {
+  std::string strategy;
+  if (!params.GetString("using", &strategy))
+    return Status(kInvalidArgument, "'using' must be a string");
+  if (session->w3c_compliant &&
+      strategy != "css selector" &&
+      strategy != "link text" &&
+      strategy != "partial link text" &&
+      strategy != "tag name" &&
+      strategy != "xpath")
+    return Status(kInvalidArgument, "invalid locator");
+
+  std::string target;
+  if (!params.GetString("value", &target))
+    return Status(kInvalidArgument, "'value' must be a string");
+
+  std::string script =
+      webdriver::atoms::asString(webdriver::atoms::FIND_ELEMENTS);
+  std::unique_ptr<base::DictionaryValue> locator(new base::DictionaryValue());
+  locator->SetString(strategy, target);
+  base::ListValue arguments;
+  arguments.Append(std::move(locator));
+  // One pipelined pass over all frames; no implicit-wait polling, since a
+  // cross-frame snapshot is what callers of this non-standard command want.
+  return web_view->CallFunctionInAllFrames(script, arguments, value);
+}
+
 Status GetActiveElement(Session* session,
                         WebView* web_view,
                         std::unique_ptr<base::Value>* value) {
@@ -515,8 +713,84 @@ Status GetElementClickableLocation(
     WebView* web_view,
     const std::string& element_id,
     WebPoint* location) {
+  Status status = CheckElement(element_id);
+  if (status.IsError())
+    return status;
+
+  // One-shot fast path: a single evaluation checks displayedness, computes
+  // the region, scrolls it into view, verifies the click point is not
+  // obstructed and returns the final coordinates, replacing the four-plus
+  // round trips of the step-by-step path below. The snippet receives the
+  // same atoms the individual steps use, so each answer is identical.
+  std::string script = base::StringPrintf(
+      "function() { return (%s).call(null, %s, %s, %s, %s,"
+      " Array.prototype.slice.call(arguments)); }",
+      kGetClickLocationScript, kGetElementRegionScript,
+      webdriver::atoms::asString(webdriver::atoms::IS_DISPLAYED).c_str(),
+      webdriver::atoms::asString(webdriver::atoms::GET_LOCATION_IN_VIEW)
+          .c_str(),
+      webdriver::atoms::asString(webdriver::atoms::IS_ELEMENT_CLICKABLE)
+          .c_str());
+
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  base::TimeTicks intercepted_deadline;
+  while (true) {
+    base::ListValue args;
+    args.Append(CreateElement(element_id));
+    std::unique_ptr<base::Value> result;
+    status = web_view->CallFunction(session->GetCurrentFrameId(), script, args,
+                                    &result);
+    if (status.IsError())
+      return status;
+    base::DictionaryValue* dict = nullptr;
+    if (!result->GetAsDictionary(&dict))
+      return Status(kUnknownError,
+                    "failed to parse value of getClickLocation");
+    const std::string* tag_name = dict->FindStringKey("tagName");
+    if (tag_name && *tag_name == "area") {
+      // The click region belongs to the map's image, not the area itself;
+      // fall through to the step-by-step path.
+      break;
+    }
+    if (!dict->FindBoolKey("displayed").value_or(false)) {
+      if (base::TimeTicks::Now() - start_time >= session->implicit_wait)
+        return Status(kElementNotVisible);
+      if (session->IsCommandCancelled())
+        return Status(kTimeout, "command was cancelled: client closed the "
+                                "connection");
+      base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(50));
+      continue;
+    }
+    if (dict->FindBoolKey("zeroSize").value_or(false))
+      return Status(kElementNotInteractable, "element has zero size");
+    if (!dict->FindBoolKey("clickable").value_or(false)) {
+      // A scroll event handler may still be shifting the element, so retry
+      // briefly before reporting the obstruction, like the step-by-step
+      // path does.
+      if (intercepted_deadline.is_null()) {
+        intercepted_deadline =
+            base::TimeTicks::Now() + base::TimeDelta::FromSeconds(1);
+      }
+      if (base::TimeTicks::Now() < intercepted_deadline) {
+        base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(50));
+        continue;
+      }
+      const std::string* message = dict->FindStringKey("message");
+      return Status(kElementClickIntercepted,
+                    message ? *message : "element click intercepted");
+    }
+    base::Optional<double> x = dict->FindDoubleKey("x");
+    base::Optional<double> y = dict->FindDoubleKey("y");
+    if (!x || !y)
+      return Status(kUnknownError,
+                    "failed to parse value of getClickLocation");
+    location->x = static_cast<int>(*x);
+    location->y = static_cast<int>(*y);
+    return Status(kOk);
+  }
+
   std::string tag_name;
-  Status status = GetElementTagName(session, web_view, element_id, &tag_name);
+  status = GetElementTagName(session, web_view, element_id, &tag_name);
   if (status.IsError())
     return status;
   std::string target_element_id = element_id;
@@ -554,7 +828,6 @@ Status GetElementClickableLocation(
       return Status(kUnknownError, "no element reference returned by script");
   }
   bool is_displayed = false;
-  base::TimeTicks start_time = base::TimeTicks::Now();
   while (true) {
     Status status = IsElementDisplayed(
       session, web_view, target_element_id, true, &is_displayed);
@@ -565,6 +838,9 @@ Status GetElementClickableLocation(
     if (base::TimeTicks::Now() - start_time >= session->implicit_wait) {
       return Status(kElementNotVisible);
     }
+    if (session->IsCommandCancelled())
+      return Status(kTimeout, "command was cancelled: client closed the "
+                              "connection");
     base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(50));
   }
 
@@ -924,6 +1200,18 @@ Status GetAXNodeByElementId(Session* session,
   if (status.IsError())
     return status;
 
+  // Audit suites query the computed label and role of every element on a
+  // page; unchanged nodes are answered from the cache instead of
+  // re-fetching overlapping tree fragments.
+  AXNodeCache* cache = web_view->GetAXNodeCache();
+  if (cache) {
+    base::Value cached;
+    if (cache->GetAXNode(node_id, &cached)) {
+      *axNode = std::make_unique<base::Value>(std::move(cached));
+      return Status(kOk);
+    }
+  }
+
   base::DictionaryValue body;
   body.SetInteger("nodeId", node_id);
   body.SetBoolean("fetchRelatives", false);
@@ -946,6 +1234,8 @@ Status GetAXNodeByElementId(Session* session,
   if (nodesList.size() > 1)
     return Status(kUnknownError, "Non-unique node in CDP response");
 
+  if (cache)
+    cache->PutAXNode(node_id, nodesList[0]);
   *axNode = std::make_unique<base::Value>(std::move(nodesList[0]));
   return Status(kOk);
 }
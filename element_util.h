@@ -8,6 +8,7 @@
 #include <memory>
 #include <string>
 
+#include "base/strings/string_piece.h"
 #include "chrome/test/chromedriver/basic_types.h"
 
 namespace base {
@@ -19,16 +20,22 @@ struct Session;
 class Status;
 class WebView;
 
-std::string GetElementKey();
+// Returns the dictionary key used to wrap element ids, backed by static
+// storage so callers can hold the result without copying.
+base::StringPiece GetElementKey();
 
 std::unique_ptr<base::DictionaryValue> CreateElement(
-    const std::string& element_id);
+    base::StringPiece element_id);
 
 std::unique_ptr<base::DictionaryValue> CreateValueFrom(const WebPoint& point);
 
-Status CheckElement(const std::string& element_id);
+Status CheckElement(base::StringPiece element_id);
 
 // |root_element_id| could be null when no root element is given.
+// Multi-element finds accept optional "maxResults" and "cursor" params; when
+// given, the result is {"total": ..., "elements": [...], "nextCursor": ...}
+// with only the requested window of matches serialized, instead of the plain
+// element list.
 Status FindElement(int interval_ms,
                    bool only_one,
                    const std::string* root_element_id,
@@ -37,6 +44,13 @@ Status FindElement(int interval_ms,
                    const base::DictionaryValue& params,
                    std::unique_ptr<base::Value>* value);
 
+// Runs the find-elements atom in every frame of the target in one
+// pipelined pass. See ExecuteFindElementsAllFrames.
+Status FindElementsInAllFrames(Session* session,
+                               WebView* web_view,
+                               const base::DictionaryValue& params,
+                               std::unique_ptr<base::Value>* value);
+
 Status GetActiveElement(Session* session,
                         WebView* web_view,
                         std::unique_ptr<base::Value>* value);
@@ -66,6 +80,10 @@ Status IsElementAttributeEqualToIgnoreCase(
     const std::string& attribute_value,
     bool* is_equal);
 
+// Waits for the element to be displayed, scrolls it into view, verifies the
+// click point is not obstructed and returns the final in-view click
+// coordinates. The common case is a single in-page evaluation
+// (js/get_click_location.js); <area> elements take a step-by-step path.
 Status GetElementClickableLocation(
     Session* session,
     WebView* web_view,
@@ -19,6 +19,38 @@ import sys
 import cpp_source
 
 
+def MinifyScript(contents):
+  """Conservatively minifies a JavaScript snippet.
+
+  Drops comment-only lines ("//" lines and block comments that open at the
+  start of a line), leading indentation, trailing whitespace and blank
+  lines. Only whole lines are removed and the remaining line structure is
+  preserved, so automatic semicolon insertion is unaffected and comment
+  markers inside string or regex literals (which never start a line in
+  these scripts) cannot be misparsed. Identifier renaming is deliberately
+  out of scope: it would need a real JS parser to be safe.
+  """
+  lines = []
+  in_block_comment = False
+  for line in contents.split('\n'):
+    stripped = line.strip()
+    if in_block_comment:
+      if '*/' not in stripped:
+        continue
+      in_block_comment = False
+      stripped = stripped.split('*/', 1)[1].strip()
+    if stripped.startswith('/*'):
+      if '*/' in stripped:
+        stripped = stripped.split('*/', 1)[1].strip()
+      else:
+        in_block_comment = True
+        continue
+    if not stripped or stripped.startswith('//'):
+      continue
+    lines.append(stripped)
+  return '\n'.join(lines)
+
+
 def main():
   parser = optparse.OptionParser()
   parser.add_option(
@@ -32,7 +64,7 @@ def main():
     func_name = base_name[0].lower() + base_name[1:]
     script_name = 'k%sScript' % base_name
     with open(js_file, 'r') as f:
-      contents = f.read()
+      contents = MinifyScript(f.read())
     script = 'function() { %s; return %s.apply(null, arguments) }' % (
         contents, func_name)
     global_string_map[script_name] = script
@@ -7,8 +7,8 @@
 
 The script requires the Source/devtools/front_end/emulated_devices/module.json
 file from Blink that lists the known mobile devices to be passed in as the only
-argument.  The list of known devices will be written to a C-style string to be
-parsed with JSONReader.
+argument.  The list of known devices will be written as a sorted constexpr
+table of structs, so device lookups need no JSON parsing at runtime.
 """
 
 import json
@@ -19,7 +19,27 @@ import subprocess
 import sys
 
 import chrome_paths
-import cpp_source
+import struct_table
+
+MOBILE_DEVICE_LIST_HEADER_BODY = '\n'.join([
+    '#include <stddef.h>',
+    '',
+    '// An emulated device entry from the DevTools front-end device list.',
+    'struct MobileDeviceEntry {',
+    '  const char* name;',
+    '  const char* user_agent;',
+    '  int width;',
+    '  int height;',
+    '  double device_scale_factor;',
+    '  bool touch;',
+    '  bool mobile;',
+    '};',
+    '',
+    '// Sorted by |name| (byte-wise), so entries can be found by binary'
+    ' search.',
+    'extern const MobileDeviceEntry kMobileDevices[];',
+    'extern const size_t kMobileDeviceCount;',
+])
 
 
 def main():
@@ -82,10 +102,26 @@ def main():
         }
 
   output_dir = 'chrome/test/chromedriver/chrome'
-  cpp_source.WriteSource('mobile_device_list',
-                         output_dir,
-                         options.directory,
-                         {'kMobileDevices': json.dumps(devices)})
+  rows = []
+  for title in sorted(devices.keys()):
+    device = devices[title]
+    rows.append([
+        title,
+        device['userAgent'],
+        device['width'],
+        device['height'],
+        device['deviceScaleFactor'],
+        device['touch'],
+        device['mobile'],
+    ])
+  struct_table.WriteTable('mobile_device_list',
+                          output_dir,
+                          options.directory,
+                          MOBILE_DEVICE_LIST_HEADER_BODY,
+                          'MobileDeviceEntry',
+                          'kMobileDevices',
+                          'kMobileDeviceCount',
+                          rows)
 
   clang_format = ['clang-format', '-i']
   subprocess.Popen(clang_format + ['%s/mobile_device_list.cc' % output_dir])
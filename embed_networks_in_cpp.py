@@ -7,20 +7,38 @@
 
 The script requires the devtools/front_end/toolbox/OverridesUI.js file from
 WebKit that lists the preset network conditions to be passed in as the only
-argument. The list of network conditions will be written to a C-style string to
-be parsed with JSONReader.
+argument. The list of network conditions will be written as a sorted constexpr
+table of structs, so preset lookups need no JSON parsing at runtime.
 """
 
+import json
 import optparse
 import re
 import subprocess
 import sys
 
-import cpp_source
+import struct_table
 
 UNLIMITED_THROUGHPUT = ('WebInspector.OverridesSupport'
                         '.NetworkThroughputUnlimitedValue')
 
+NETWORK_LIST_HEADER_BODY = '\n'.join([
+    '#include <stddef.h>',
+    '',
+    '// A network throttling preset from the DevTools front-end preset list.',
+    'struct NetworkListEntry {',
+    '  const char* id;',
+    '  const char* title;',
+    '  double throughput;  // In kbps; -1 means unlimited.',
+    '  double latency;     // In milliseconds.',
+    '};',
+    '',
+    '// Sorted by |title| (byte-wise), so entries can be found by binary'
+    ' search.',
+    'extern const NetworkListEntry kNetworks[];',
+    'extern const size_t kNetworkCount;',
+])
+
 
 def quotizeKeys(s, keys):
   """Returns the string s with each instance of each key wrapped in quotes.
@@ -75,9 +93,22 @@ def main():
   networks += ']'
   networks = quotizeKeys(networks, ['id', 'title', 'throughput', 'latency'])
   networks = evaluateMultiplications(networks)
-  cpp_source.WriteSource('network_list',
-                         output_dir,
-                         options.directory, {'kNetworks': networks})
+  rows = []
+  for network in sorted(json.loads(networks), key=lambda n: n['title']):
+    rows.append([
+        network['id'],
+        network['title'],
+        float(network['throughput']),
+        float(network['latency']),
+    ])
+  struct_table.WriteTable('network_list',
+                          output_dir,
+                          options.directory,
+                          NETWORK_LIST_HEADER_BODY,
+                          'NetworkListEntry',
+                          'kNetworks',
+                          'kNetworkCount',
+                          rows)
 
   clang_format = ['clang-format', '-i']
   subprocess.Popen(clang_format + ['%s/network_list.cc' % output_dir])
@@ -0,0 +1,218 @@
+#!/usr/bin/env python
+# Copyright 2021 The Chromium Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+"""Generates typed C++ param structs for hot DevTools protocol methods.
+
+Reads a JSON spec listing CDP methods and their (flat) parameter fields and
+emits cdp_bindings.h/cc containing one struct per method. Each struct carries
+typed fields and a WriteJson() that serializes them into a JSON object in a
+single pass over an output string, so the per-event command path needs no
+base::Value tree construction or generic tree walk.
+
+Only scalar fields and string arrays are supported; methods with nested
+object parameters keep using base::DictionaryValue at their call sites.
+New methods are added by editing the spec, not this script.
+"""
+
+import json
+import optparse
+import os
+import re
+import sys
+
+HEADER_PREAMBLE = '\n'.join([
+    '// Copyright 2021 The Chromium Authors. All rights reserved.',
+    '// Use of this source code is governed by a BSD-style license that'
+    ' can be',
+    '// found in the LICENSE file.',
+    '',
+    '// Generated by generate_cdp_bindings.py from %s. Do not edit.',
+    '',
+    '#ifndef CHROME_TEST_CHROMEDRIVER_CHROME_CDP_BINDINGS_H_',
+    '#define CHROME_TEST_CHROMEDRIVER_CHROME_CDP_BINDINGS_H_',
+    '',
+    '#include <string>',
+    '#include <vector>',
+    '',
+    '#include "base/optional.h"',
+    '#include "base/strings/string_piece.h"',
+    '',
+    'namespace cdp {',
+    '',
+])
+
+HEADER_EPILOGUE = '\n'.join([
+    '}  // namespace cdp',
+    '',
+    '#endif  // CHROME_TEST_CHROMEDRIVER_CHROME_CDP_BINDINGS_H_',
+    '',
+])
+
+CC_PREAMBLE = '\n'.join([
+    '// Copyright 2021 The Chromium Authors. All rights reserved.',
+    '// Use of this source code is governed by a BSD-style license that'
+    ' can be',
+    '// found in the LICENSE file.',
+    '',
+    '// Generated by generate_cdp_bindings.py from %s. Do not edit.',
+    '',
+    '#include "chrome/test/chromedriver/chrome/cdp_bindings.h"',
+    '',
+    '#include "base/json/string_escape.h"',
+    '#include "base/strings/string_number_conversions.h"',
+    '',
+    'namespace cdp {',
+    '',
+])
+
+CC_EPILOGUE = '\n'.join([
+    '}  // namespace cdp',
+    '',
+])
+
+# C++ type of a required field, by spec type name.
+FIELD_TYPES = {
+    'string': 'base::StringPiece',
+    'int': 'int',
+    'double': 'double',
+    'bool': 'bool',
+}
+
+FIELD_DEFAULTS = {
+    'int': ' = 0',
+    'double': ' = 0',
+    'bool': ' = false',
+}
+
+
+def StructName(method):
+  """Input.dispatchMouseEvent -> InputDispatchMouseEvent."""
+  domain, name = method.split('.')
+  return domain + name[0].upper() + name[1:]
+
+
+def FieldName(key):
+  """clickCount -> click_count."""
+  return re.sub('([A-Z]+)', lambda m: '_' + m.group(1).lower(), key)
+
+
+def DeclareField(field):
+  name = FieldName(field['key'])
+  spec_type = field['type']
+  if spec_type == 'string_array':
+    # Arrays are omitted from the output when empty, so they need no
+    # separate presence flag.
+    return '  std::vector<std::string> %s;' % name
+  if field.get('optional'):
+    return '  base::Optional<%s> %s;' % (FIELD_TYPES[spec_type], name)
+  return '  %s %s%s;' % (FIELD_TYPES[spec_type], name,
+                         FIELD_DEFAULTS.get(spec_type, ''))
+
+
+def AppendValueLines(lines, spec_type, expr, indent):
+  pad = ' ' * indent
+  if spec_type == 'string':
+    lines.append('%sbase::EscapeJSONString(%s, true, out);' % (pad, expr))
+  elif spec_type == 'bool':
+    lines.append('%sout->append(%s ? "true" : "false");' % (pad, expr))
+  else:
+    lines.append('%sout->append(base::NumberToString(%s));' % (pad, expr))
+
+
+def WriteJsonBody(fields):
+  lines = [
+      '  out->push_back(\'{\');',
+      '  const char* sep = "";',
+  ]
+  for field in fields:
+    name = FieldName(field['key'])
+    key_literal = '"\\"%s\\":"' % field['key']
+    spec_type = field['type']
+    if spec_type == 'string_array':
+      lines.append('  if (!%s.empty()) {' % name)
+      lines.append('    out->append(sep);')
+      lines.append('    out->append(%s);' % key_literal)
+      lines.append('    out->push_back(\'[\');')
+      lines.append('    const char* item_sep = "";')
+      lines.append('    for (const std::string& item : %s) {' % name)
+      lines.append('      out->append(item_sep);')
+      lines.append('      base::EscapeJSONString(item, true, out);')
+      lines.append('      item_sep = ",";')
+      lines.append('    }')
+      lines.append('    out->push_back(\']\');')
+      lines.append('    sep = ",";')
+      lines.append('  }')
+    elif field.get('optional'):
+      lines.append('  if (%s) {' % name)
+      lines.append('    out->append(sep);')
+      lines.append('    out->append(%s);' % key_literal)
+      AppendValueLines(lines, spec_type, '*' + name, 4)
+      lines.append('    sep = ",";')
+      lines.append('  }')
+    else:
+      lines.append('  out->append(sep);')
+      lines.append('  out->append(%s);' % key_literal)
+      AppendValueLines(lines, spec_type, name, 2)
+      lines.append('  sep = ",";')
+  lines.append('  out->push_back(\'}\');')
+  return lines
+
+
+def GenerateHeader(spec_name, methods):
+  parts = [HEADER_PREAMBLE % spec_name]
+  for entry in methods:
+    struct = StructName(entry['method'])
+    parts.append('// Typed parameters for %s.' % entry['method'])
+    parts.append('struct %s {' % struct)
+    parts.append('  static const char kMethod[];')
+    parts.append('')
+    for field in entry['fields']:
+      parts.append(DeclareField(field))
+    parts.append('')
+    parts.append('  // Appends the fields to |out| as a JSON object in one'
+                 ' pass. Unset')
+    parts.append('  // optional fields and empty arrays are omitted.')
+    parts.append('  void WriteJson(std::string* out) const;')
+    parts.append('};')
+    parts.append('')
+  parts.append(HEADER_EPILOGUE)
+  return '\n'.join(parts)
+
+
+def GenerateCc(spec_name, methods):
+  parts = [CC_PREAMBLE % spec_name]
+  for entry in methods:
+    struct = StructName(entry['method'])
+    parts.append('const char %s::kMethod[] = "%s";' % (struct,
+                                                       entry['method']))
+    parts.append('')
+    parts.append('void %s::WriteJson(std::string* out) const {' % struct)
+    parts.extend(WriteJsonBody(entry['fields']))
+    parts.append('}')
+    parts.append('')
+  parts.append(CC_EPILOGUE)
+  return '\n'.join(parts)
+
+
+def main():
+  parser = optparse.OptionParser()
+  parser.add_option(
+      '', '--directory', type='string', default='.',
+      help='Path to directory where the cc/h files should be created')
+  options, args = parser.parse_args()
+
+  spec_path = args[0]
+  spec_name = os.path.basename(spec_path)
+  with open(spec_path, 'r') as f:
+    methods = json.load(f)
+
+  with open(os.path.join(options.directory, 'cdp_bindings.h'), 'w') as f:
+    f.write(GenerateHeader(spec_name, methods))
+  with open(os.path.join(options.directory, 'cdp_bindings.cc'), 'w') as f:
+    f.write(GenerateCc(spec_name, methods))
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -387,12 +387,17 @@ function jsonDeserialize(item, opt_seen, opt_cache) {
  * @param {boolean} w3c Whether to return a W3C compliant element reference.
  * @param {boolean=} opt_unwrappedReturn Whether the function's return value
  *     should be left unwrapped.
- * @return {*} An object containing a status and value property, where status
- *     is a WebDriver status code and value is the wrapped value. If an
- *     unwrapped return was specified, this will be the function's pure return
- *     value.
+ * @param {?Element=} opt_boundElem An element to prepend to the unwrapped
+ *     arguments. The caller resolved it remotely, so it skips the cache
+ *     lookup, but it gets the same staleness check the cache would apply.
+ * @return {!Promise<*>} Promise that resolves to the wrapped return value of
+ *     the function (or to its pure return value if an unwrapped return was
+ *     specified), and rejects with a 'wd-status:<code>:<message>' string for
+ *     any failure. Carrying the status code in the rejection lets the driver
+ *     move the resolved value straight out of the DevTools response instead
+ *     of unpacking a {status, value} envelope from every call.
  */
-function callFunction(func, args, w3c, opt_unwrappedReturn) {
+function callFunction(func, args, w3c, opt_unwrappedReturn, opt_boundElem) {
   if (w3c) {
     w3cEnabled = true;
     ELEMENT_KEY = 'element-6066-11e4-a52e-4f735466cecf';
@@ -400,29 +405,32 @@ function callFunction(func, args, w3c, opt_unwrappedReturn) {
   }
   const cache = getPageCache(null, w3cEnabled);
 
-  function buildError(error) {
-    return {
-      status: error.code || StatusCode.JAVA_SCRIPT_ERROR,
-      value: error.message || error
-    };
+  // Rethrown as a plain string: a primitive exception value survives into
+  // the exceptionDetails of the DevTools response, where an Error object
+  // would arrive as an opaque remote object.
+  function encodeError(error) {
+    throw 'wd-status:' + (error.code || StatusCode.JAVA_SCRIPT_ERROR) + ':' +
+        (error.message || error);
   }
 
-  let status = 0;
-  let returnValue;
   const Promise = window.cdc_adoQpoasnfa76pfcZLmcfl_Promise || window.Promise;
   try {
     const unwrappedArgs = jsonDeserialize(args, [], cache);
+    if (opt_boundElem !== undefined && opt_boundElem !== null) {
+      if (getNodeRootThroughAnyShadows(opt_boundElem) !=
+          document.documentElement.parentNode) {
+        throw newError('element is not attached to the page document',
+                       StatusCode.STALE_ELEMENT_REFERENCE);
+      }
+      unwrappedArgs.unshift(opt_boundElem);
+    }
     const tmp = func.apply(null, unwrappedArgs);
     return Promise.resolve(tmp).then((result) => {
       if (opt_unwrappedReturn)
         return result;
-      const clone = jsonSerialize(result, []);
-      return {
-        status: 0,
-        value: clone
-      };
-    }).catch(buildError);
+      return jsonSerialize(result, []);
+    }).catch(encodeError);
   } catch (error) {
-    return Promise.resolve(buildError(error));
+    return Promise.reject(error).catch(encodeError);
   }
 }
@@ -0,0 +1,60 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// One-shot click preparation. Combines the separate displayedness, region,
+// scroll-into-view and obstruction evaluations that used to precede a click
+// into a single in-page call. The region snippet (|getElementRegion|) and
+// the standard atoms (|isDisplayed|, |getLocationInView|, |isClickable|)
+// are injected by the caller, so every step reports exactly what the
+// step-by-step path would.
+//
+// Returns an object with:
+//   tagName:   always set; lets the caller branch to its bespoke paths.
+//   displayed: whether the element is displayed (opacity ignored).
+//   zeroSize:  true when the element's region has no area.
+//   clickable: whether the click point actually hits the element.
+//   message:   the obstruction message when not clickable.
+//   x, y:      the final click coordinates when clickable.
+function getClickLocation(
+    getElementRegion, isDisplayed, getLocationInView, isClickable, args) {
+  var element = args[0];
+  if (!element || element.nodeType != 1)
+    throw new Error(element + ' is not an element');
+
+  var result = {tagName: element.tagName.toLowerCase()};
+  // Area elements borrow their image's geometry; the caller keeps the
+  // step-by-step path for them.
+  if (result.tagName == 'area')
+    return result;
+
+  result.displayed = !!isDisplayed(element, true);
+  if (!result.displayed)
+    return result;
+
+  var region = getElementRegion(element);
+  // Truncate like the driver side does, so the point matches what the
+  // step-by-step path would have dispatched.
+  var width = Math.trunc(region.width);
+  var height = Math.trunc(region.height);
+  if (width == 0 || height == 0) {
+    result.zeroSize = true;
+    return result;
+  }
+
+  // The atom scrolls the element into view and reports where the region's
+  // origin landed.
+  var location = getLocationInView(element, true, region);
+  var x = Math.trunc(location.x) + Math.trunc(width / 2);
+  var y = Math.trunc(location.y) + Math.trunc(height / 2);
+
+  var check = isClickable(element, {x: x, y: y});
+  result.clickable = !!check.clickable;
+  if (!result.clickable) {
+    result.message = check.message || 'element click intercepted';
+    return result;
+  }
+  result.x = x;
+  result.y = y;
+  return result;
+}
@@ -0,0 +1,33 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+/**
+ * Scrolls the given element into view and returns the capture clip for an
+ * element screenshot, in CSS pixels relative to the document origin. Folds
+ * the scroll, measure and viewport queries, which used to be separate
+ * evaluations, into a single script.
+ *
+ * @param {!Element} element The element to capture.
+ * @return {!Object} Clip rect {x, y, width, height} cropped to the viewport,
+ *     plus the devicePixelRatio the capture scale must invert.
+ */
+function getElementScreenshotClip(element) {
+  // Check that node type is element.
+  if (element.nodeType != 1)
+    throw new Error(element + ' is not an element');
+
+  // Scroll the minimum amount, and not at all when the element is already
+  // fully visible, like the GET_LOCATION_IN_VIEW atom does.
+  element.scrollIntoView({block: 'nearest', inline: 'nearest'});
+
+  var rect = element.getBoundingClientRect();
+  return {
+    'x': rect.left + window.pageXOffset,
+    'y': rect.top + window.pageYOffset,
+    // Crop by the viewport if the element is larger than it.
+    'width': Math.min(rect.width, document.documentElement.clientWidth),
+    'height': Math.min(rect.height, document.documentElement.clientHeight),
+    'devicePixelRatio': window.devicePixelRatio
+  };
+}
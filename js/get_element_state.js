@@ -0,0 +1,48 @@
+// Copyright (c) 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Collects displayedness, enabled state, rect, and requested attributes and
+// properties of an element in one evaluation. The atoms are injected by the
+// caller so semantics match the individual WebDriver commands exactly.
+function getElementState(isDisplayed, isEnabled, getLocation, getSize, args) {
+  var element = args[0];
+  var attributes = args[1];
+  var properties = args[2];
+
+  // Check that node type is element.
+  if (element.nodeType != 1)
+    throw new Error(element + ' is not an element');
+
+  var location = getLocation(element);
+  var size = getSize(element);
+  var state = {
+    'displayed': !!isDisplayed(element),
+    // Elements in XML documents are never enabled, matching the enabled
+    // command's document type check.
+    'enabled': document.contentType.toLowerCase() == 'text/xml' ?
+        false : !!isEnabled(element),
+    'rect': {
+      'x': location.x,
+      'y': location.y,
+      'width': size.width,
+      'height': size.height
+    },
+    'attributes': {},
+    'properties': {}
+  };
+  for (var i = 0; i < attributes.length; i++) {
+    var attribute = attributes[i];
+    // Boolean attributes report 'true'/null, like the attribute command.
+    if (attribute.isBoolean)
+      state.attributes[attribute.name] =
+          element.hasAttribute(attribute.name) ? 'true' : null;
+    else
+      state.attributes[attribute.name] = element.getAttribute(attribute.name);
+  }
+  for (var i = 0; i < properties.length; i++) {
+    var value = element[properties[i]];
+    state.properties[properties[i]] = value === undefined ? null : value;
+  }
+  return state;
+}
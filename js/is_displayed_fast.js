@@ -0,0 +1,99 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Fast-path displayedness check. The full displayedness atom walks computed
+// style and geometry for the element and all of its ancestors on every call,
+// which dominates the cost of the common "visible element, ask before each
+// interaction" pattern. This probe answers the easy cases — visible computed
+// style plus a nonzero viewport intersection reported by a persistent
+// IntersectionObserver, whose intersection rect already accounts for ancestor
+// overflow clipping — and delegates to the injected atom (|isDisplayed|)
+// whenever it cannot reproduce the atom's exact answer.
+function isDisplayedFast(isDisplayed, args) {
+  var element = args[0];
+
+  function fallback() {
+    return !!isDisplayed(element);
+  }
+
+  if (!element || element.nodeType != 1 ||
+      typeof IntersectionObserver == 'undefined') {
+    return fallback();
+  }
+
+  // Tags with bespoke rules in the atom: option visibility follows the
+  // enclosing select, map areas borrow the image's geometry, hidden inputs
+  // and noscript are special-cased, and the body is always shown.
+  var tag = element.tagName.toUpperCase();
+  if (tag == 'OPTION' || tag == 'OPTGROUP' || tag == 'MAP' || tag == 'AREA' ||
+      tag == 'INPUT' || tag == 'NOSCRIPT' || tag == 'BODY' || tag == 'HTML') {
+    return fallback();
+  }
+
+  var style = window.getComputedStyle(element);
+  // These are definitive: the atom reports such elements as not displayed
+  // (computed visibility already reflects inheritance).
+  if (style.display == 'none' || style.visibility == 'hidden' ||
+      style.visibility == 'collapse' || parseFloat(style.opacity) == 0) {
+    return false;
+  }
+
+  // Opacity chains and clip paths are the atom's territory. One ancestor
+  // walk over computed opacity/clip is still far cheaper than the atom's
+  // full geometry analysis, and it usually terminates on the first node.
+  for (var node = element.parentNode; node && node.nodeType == 1;
+       node = node.parentNode) {
+    var ancestorStyle = window.getComputedStyle(node);
+    if (parseFloat(ancestorStyle.opacity) < 1 ||
+        (ancestorStyle.clipPath && ancestorStyle.clipPath != 'none') ||
+        (ancestorStyle.clip && ancestorStyle.clip != 'auto' &&
+         ancestorStyle.clip != '')) {
+      return fallback();
+    }
+  }
+  if ((style.clipPath && style.clipPath != 'none') ||
+      (style.clip && style.clip != 'auto' && style.clip != '')) {
+    return fallback();
+  }
+
+  var key = '$cdc_displayednessObserver_';
+  var state = document[key];
+  if (!state) {
+    var entries = new WeakMap();
+    state = {
+      entries: entries,
+      observer: new IntersectionObserver(function(records) {
+        for (var i = 0; i < records.length; i++)
+          entries.set(records[i].target, records[i]);
+      })
+    };
+    document[key] = state;
+  }
+
+  // Flush records computed since the last callback so the cache reflects
+  // the most recent rendering update.
+  var records = state.observer.takeRecords();
+  for (var i = 0; i < records.length; i++)
+    state.entries.set(records[i].target, records[i]);
+
+  var entry = state.entries.get(element);
+  if (!entry) {
+    // First sight of this element; observe it so repeat queries are cheap.
+    state.observer.observe(element);
+    return fallback();
+  }
+
+  if (entry.isIntersecting && entry.intersectionRect.width > 0 &&
+      entry.intersectionRect.height > 0) {
+    // Guard against the entry predating a layout change: confirm the
+    // element still has area before trusting the cached intersection.
+    var rect = element.getBoundingClientRect();
+    if (rect.width > 0 && rect.height > 0)
+      return true;
+  }
+  // Not intersecting the viewport does not mean not displayed — elements
+  // scrolled out of view are still displayed — so anything else is the
+  // atom's call.
+  return fallback();
+}
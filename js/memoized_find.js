@@ -0,0 +1,41 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+function memoizedFind(findFunction, findArgs, onlyOne) {
+  // Applies |findFunction| (a find-element(s) atom) to |findArgs|, memoizing
+  // the result until the next DOM mutation, so repeated identical finds on a
+  // momentarily static page - the common case for stale-element retry
+  // wrappers - skip the document query entirely. Staleness is checked
+  // synchronously: a mutation since the previous find is either still queued
+  // on the observer, where takeRecords() sees it, or has already been
+  // consumed by the observer's callback, which clears the cache.
+  var memoKey = 'cdc_adoQpoasnfa76pfcZLmcfl_FindMemo';
+  var memo = window[memoKey];
+  if (!memo) {
+    memo = {results: Object.create(null), observer: null};
+    memo.observer = new MutationObserver(function() {
+      memo.results = Object.create(null);
+    });
+    // Attribute and character data changes can affect matching too (e.g.
+    // class-based selectors and link text), so observe everything.
+    memo.observer.observe(document.documentElement || document, {
+      childList: true,
+      subtree: true,
+      attributes: true,
+      characterData: true
+    });
+    window[memoKey] = memo;
+  }
+  if (memo.observer.takeRecords().length > 0)
+    memo.results = Object.create(null);
+
+  // The two find atoms return different shapes for the same locator, so the
+  // key includes which one is running.
+  var key = (onlyOne ? '1' : '*') + JSON.stringify(findArgs);
+  if (key in memo.results)
+    return memo.results[key];
+  var result = findFunction.apply(null, findArgs);
+  memo.results[key] = result;
+  return result;
+}
@@ -0,0 +1,49 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+function waitForElement(findFunction, findArgs, timeoutMs) {
+  // Runs |findFunction| (a find-element(s) atom) with |findArgs| and returns
+  // a promise for its result. If nothing matches yet, a MutationObserver
+  // re-runs the find whenever the document changes, so the promise resolves
+  // as soon as a matching node appears rather than on the next driver-side
+  // poll. Resolves with null once |timeoutMs| elapses without a match.
+  // The promise is awaited by Runtime.evaluate, so the DevTools response is
+  // only sent on resolution.
+  var promiseCtor = window.cdc_adoQpoasnfa76pfcZLmcfl_Promise || window.Promise;
+
+  function tryFind() {
+    var result = findFunction.apply(null, findArgs);
+    if (result instanceof Array)
+      return result.length > 0 ? result : null;
+    return result;
+  }
+
+  var first = tryFind();
+  if (first !== null || !(timeoutMs > 0))
+    return promiseCtor.resolve(first);
+
+  return new promiseCtor(function(resolve) {
+    var timer = null;
+    var observer = new MutationObserver(function() {
+      var found = tryFind();
+      if (found !== null) {
+        observer.disconnect();
+        clearTimeout(timer);
+        resolve(found);
+      }
+    });
+    // Attribute and character data changes can affect matching too (e.g.
+    // class-based selectors and link text), so observe everything.
+    observer.observe(document.documentElement || document, {
+      childList: true,
+      subtree: true,
+      attributes: true,
+      characterData: true
+    });
+    timer = setTimeout(function() {
+      observer.disconnect();
+      resolve(null);
+    }, timeoutMs);
+  });
+}
@@ -6,6 +6,9 @@
 
 #include <stddef.h>
 
+#include <map>
+#include <utility>
+
 #include "base/format_macros.h"
 #include "base/stl_util.h"
 #include "base/strings/stringprintf.h"
@@ -445,6 +448,82 @@ int GetKeyLocation(uint32_t code_point) {
   return 0;
 }
 
+// Maps each key and alternate key from |kCodeForKey| to its "code" string.
+// The table is layout-independent W3C data, so the map is built only once.
+// Where a code point appears in several rows (e.g. '>'), the first row wins,
+// matching the original linear scan.
+const std::map<uint32_t, const char*>& GetCodeForKeyMap() {
+  static const std::map<uint32_t, const char*>* code_map = [] {
+    auto* map = new std::map<uint32_t, const char*>();
+    for (const auto& mapping : kCodeForKey) {
+      map->emplace(mapping.key, mapping.code.c_str());
+      if (mapping.alternate_key)
+        map->emplace(mapping.alternate_key, mapping.code.c_str());
+    }
+    return map;
+  }();
+  return *code_map;
+}
+
+// Memoizes keyboard layout queries for the duration of one key-conversion
+// call. On X11, ConvertCharToKeyCode probes most of the keyboard with
+// ConvertKeyCodeToText for every character, so bulk typing repeats the same
+// layout queries thousands of times. The cache is scoped to a single call
+// rather than to the process so that keyboard layout changes are picked up.
+class KeyConversionCache {
+ public:
+  KeyConversionCache() {}
+
+  bool ConvertKeyCodeToText(ui::KeyboardCode key_code,
+                            int modifiers,
+                            std::string* text,
+                            std::string* error_msg) {
+    std::pair<int, int> cache_key(key_code, modifiers);
+    auto iter = text_for_key_code_.find(cache_key);
+    if (iter != text_for_key_code_.end()) {
+      *text = iter->second;
+      error_msg->clear();
+      return true;
+    }
+    if (!::ConvertKeyCodeToText(key_code, modifiers, text, error_msg))
+      return false;  // Failures may be transient; do not cache them.
+    text_for_key_code_[cache_key] = *text;
+    return true;
+  }
+
+  bool ConvertCharToKeyCode(char16_t key,
+                            ui::KeyboardCode* key_code,
+                            int* necessary_modifiers,
+                            std::string* error_msg) {
+    auto iter = key_code_for_char_.find(key);
+    if (iter != key_code_for_char_.end()) {
+      *key_code = iter->second.key_code;
+      *necessary_modifiers = iter->second.necessary_modifiers;
+      error_msg->clear();
+      return iter->second.found;
+    }
+    CharLookup lookup;
+    lookup.found =
+        ::ConvertCharToKeyCode(key, key_code, necessary_modifiers, error_msg);
+    if (!error_msg->empty())
+      return lookup.found;  // Failures may be transient; do not cache them.
+    lookup.key_code = lookup.found ? *key_code : ui::VKEY_UNKNOWN;
+    lookup.necessary_modifiers = lookup.found ? *necessary_modifiers : 0;
+    key_code_for_char_[key] = lookup;
+    return lookup.found;
+  }
+
+ private:
+  struct CharLookup {
+    bool found;
+    ui::KeyboardCode key_code;
+    int necessary_modifiers;
+  };
+
+  std::map<std::pair<int, int>, std::string> text_for_key_code_;
+  std::map<char16_t, CharLookup> key_code_for_char_;
+};
+
 }  // namespace
 
 Status ConvertKeysToKeyEvents(const std::u16string& client_keys,
@@ -460,6 +539,7 @@ Status ConvertKeysToKeyEvents(const std::u16string& client_keys,
     keys.push_back(kWebDriverNullKey);
 
   int sticky_modifiers = *modifiers;
+  KeyConversionCache conversion_cache;
   for (size_t i = 0; i < keys.size(); ++i) {
     char16_t key = keys[i];
 
@@ -545,24 +625,27 @@ Status ConvertKeysToKeyEvents(const std::u16string& client_keys,
         int webdriver_modifiers = 0;
         if (key_code >= ui::VKEY_NUMPAD0 && key_code <= ui::VKEY_NUMPAD9)
           webdriver_modifiers = kNumLockKeyModifierMask;
-        if (!ConvertKeyCodeToText(
+        if (!conversion_cache.ConvertKeyCodeToText(
             key_code, webdriver_modifiers, &unmodified_text, &error_msg))
           return Status(kUnknownError, error_msg);
-        if (!ConvertKeyCodeToText(
+        if (!conversion_cache.ConvertKeyCodeToText(
             key_code, all_modifiers | webdriver_modifiers, &modified_text,
             &error_msg))
           return Status(kUnknownError, error_msg);
       }
     } else {
       int necessary_modifiers = 0;
-      ConvertCharToKeyCode(key, &key_code, &necessary_modifiers, &error_msg);
+      conversion_cache.ConvertCharToKeyCode(key, &key_code,
+                                            &necessary_modifiers, &error_msg);
       if (!error_msg.empty())
         return Status(kUnknownError, error_msg);
       all_modifiers |= necessary_modifiers;
       if (key_code != ui::VKEY_UNKNOWN) {
-        if (!ConvertKeyCodeToText(key_code, 0, &unmodified_text, &error_msg))
+        if (!conversion_cache.ConvertKeyCodeToText(key_code, 0,
+                                                   &unmodified_text,
+                                                   &error_msg))
           return Status(kUnknownError, error_msg);
-        if (!ConvertKeyCodeToText(
+        if (!conversion_cache.ConvertKeyCodeToText(
             key_code, all_modifiers, &modified_text, &error_msg))
           return Status(kUnknownError, error_msg);
         if (unmodified_text.empty() || modified_text.empty()) {
@@ -644,12 +727,10 @@ Status ConvertKeyActionToKeyEvent(const base::DictionaryValue* action_object,
 
   std::string code;
   if (code_point != 0) {
-    for (auto& mapping : kCodeForKey) {
-      if (mapping.key == code_point || mapping.alternate_key == code_point) {
-        code = mapping.code;
-        break;
-      }
-    }
+    const std::map<uint32_t, const char*>& code_map = GetCodeForKeyMap();
+    auto code_iter = code_map.find(code_point);
+    if (code_iter != code_map.end())
+      code = code_iter->second;
   }
 
   int modifiers;
@@ -0,0 +1,52 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "chrome/test/chromedriver/benchmark_util.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/chrome/ui_events.h"
+#include "chrome/test/chromedriver/key_converter.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kRuns = 20000;
+
+void ConvertKeys(const std::u16string& keys) {
+  int modifiers = 0;
+  std::vector<KeyEvent> key_events;
+  Status status =
+      ConvertKeysToKeyEvents(keys, true /* release_modifiers */, &modifiers,
+                             &key_events);
+  ASSERT_EQ(kOk, status.code());
+}
+
+}  // namespace
+
+TEST(ConvertKeysToKeyEventsBenchmark, AsciiSentence) {
+  benchmark::RunAndReport(
+      "ChromeDriver.ConvertKeysToKeyEvents", "ascii_sentence", kRuns,
+      base::BindRepeating(&ConvertKeys,
+                          u"The quick brown fox jumps over the lazy dog."));
+}
+
+TEST(ConvertKeysToKeyEventsBenchmark, WithModifiers) {
+  // Mixed-case input toggles the shift modifier mid-string, exercising
+  // the modifier tracking paths that lower-case text skips.
+  benchmark::RunAndReport(
+      "ChromeDriver.ConvertKeysToKeyEvents", "with_modifiers", kRuns,
+      base::BindRepeating(&ConvertKeys, u"abcdefghiJKL"));
+}
+
+TEST(ConvertKeysToKeyEventsBenchmark, LongFormInput) {
+  std::u16string keys;
+  for (int i = 0; i < 20; ++i)
+    keys += u"form field content with spaces and numbers 0123456789 ";
+  benchmark::RunAndReport("ChromeDriver.ConvertKeysToKeyEvents",
+                          "long_form_input", kRuns / 10,
+                          base::BindRepeating(&ConvertKeys, keys));
+}
@@ -417,3 +417,28 @@ TEST(KeyConverter, ReleaseModifiers) {
 
   CheckEvents(keys, key_events, true /* release_modifiers */, 0);
 }
+
+TEST(KeyConverter, RepeatedCharsMatchSingleCharConversion) {
+  ui::ScopedKeyboardLayout keyboard_layout(ui::KEYBOARD_LAYOUT_ENGLISH_US);
+  int modifiers = 0;
+  std::vector<KeyEvent> single;
+  ASSERT_EQ(kOk,
+            ConvertKeysToKeyEvents(u"a", false /* release_modifiers */,
+                                   &modifiers, &single).code());
+  // Repeated characters hit the per-call conversion cache; each occurrence
+  // must still produce the same events as a lone conversion.
+  modifiers = 0;
+  std::vector<KeyEvent> repeated;
+  ASSERT_EQ(kOk,
+            ConvertKeysToKeyEvents(u"aaa", false /* release_modifiers */,
+                                   &modifiers, &repeated).code());
+  ASSERT_EQ(single.size() * 3, repeated.size());
+  for (size_t i = 0; i < repeated.size(); ++i) {
+    const KeyEvent& expected = single[i % single.size()];
+    EXPECT_EQ(expected.type, repeated[i].type);
+    EXPECT_EQ(expected.key_code, repeated[i].key_code);
+    EXPECT_EQ(expected.modifiers, repeated[i].modifiers);
+    EXPECT_EQ(expected.unmodified_text, repeated[i].unmodified_text);
+    EXPECT_EQ(expected.modified_text, repeated[i].modified_text);
+  }
+}
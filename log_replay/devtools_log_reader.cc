@@ -3,13 +3,48 @@
 // found in the LICENSE file.
 #include "chrome/test/chromedriver/log_replay/devtools_log_reader.h"
 
-#include <iostream>
+#include <sstream>
 #include <string>
+#include <utility>
 
 #include "base/logging.h"
 #include "base/strings/pattern.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
 
 namespace {
+// How many entries of a protocol are parsed ahead of the consumer at a time.
+const int kPrefetchBatchSize = 16;
+
+// Parses the timestamp preamble of an entry header line into seconds since
+// epoch. Handles both the compact "[1534441986.823]" form and the readable
+// "[08-20-2019 16:43:43.086749]" form; returns 0 if neither parses.
+double ParseHeaderTimestamp(const std::string& header_line) {
+  const size_t close = header_line.find(']');
+  if (header_line.empty() || header_line[0] != '[' ||
+      close == std::string::npos) {
+    return 0;
+  }
+  const std::string stamp = header_line.substr(1, close - 1);
+  double seconds = 0;
+  if (base::StringToDouble(stamp, &seconds))
+    return seconds;
+  // base::Time::FromString drops fractional seconds, so split them off and
+  // add them back; sub-second gaps are exactly what replay pacing cares
+  // about.
+  const size_t dot = stamp.rfind('.');
+  const std::string whole =
+      dot == std::string::npos ? stamp : stamp.substr(0, dot);
+  base::Time time;
+  if (base::Time::FromString(whole.c_str(), &time)) {
+    double fraction = 0;
+    if (dot != std::string::npos)
+      base::StringToDouble("0" + stamp.substr(dot), &fraction);
+    return (time - base::Time::UnixEpoch()).InSecondsF() + fraction;
+  }
+  return 0;
+}
+
 // Parses the word (id=X) and just returns the id number
 int GetId(std::istringstream& header_stream) {
   int id = 0;
@@ -22,6 +57,7 @@ int GetId(std::istringstream& header_stream) {
 
 LogEntry::LogEntry(std::istringstream& header_stream) {
   error = false;
+  recorded_time = 0;
   std::string protocol_type_string;
   header_stream >> protocol_type_string;  // "HTTP" or "WebSocket"
   if (protocol_type_string == "HTTP") {
@@ -78,7 +114,17 @@ LogEntry::LogEntry(std::istringstream& header_stream) {
 LogEntry::~LogEntry() {}
 
 DevToolsLogReader::DevToolsLogReader(const base::FilePath& log_path)
-    : log_file(log_path.value().c_str(), std::ios::in) {}
+    : next_entry_index() {
+  // A missing or empty log simply yields no entries. Mapping the file also
+  // reads it into the page cache sequentially during BuildIndex, so entry
+  // parsing afterwards hits warm pages.
+  if (mapped_file.Initialize(log_path)) {
+    log_data = base::StringPiece(
+        reinterpret_cast<const char*>(mapped_file.data()),
+        mapped_file.length());
+  }
+  BuildIndex();
+}
 
 DevToolsLogReader::~DevToolsLogReader() {}
 
@@ -107,36 +153,90 @@ std::unique_ptr<LogEntry> DevToolsLogReader::GetNext(
   if (peeked) {
     return std::move(peeked);
   }
-  std::string next_line;
-  while (true) {
-    if (log_file.eof())
+  std::deque<std::unique_ptr<LogEntry>>& queue = prefetched[protocol_type];
+  if (queue.empty())
+    PrefetchEntries(protocol_type);
+  if (queue.empty())
+    return nullptr;
+  std::unique_ptr<LogEntry> next = std::move(queue.front());
+  queue.pop_front();
+  return next;
+}
+
+void DevToolsLogReader::BuildIndex() {
+  size_t pos = 0;
+  while (pos < log_data.size()) {
+    const size_t line_start = pos;
+    std::string line = NextLine(&pos);
+    // Header lines always start with a '[' (of the timestamp); JSON payload
+    // continuation lines never do, so most lines are skipped without the
+    // cost of tokenizing them.
+    if (line.empty() || line[0] != '[')
+      continue;
+    std::istringstream line_stream(line);
+    if (!IsHeader(line_stream))
+      continue;
+    std::string protocol_word;
+    line_stream >> protocol_word;
+    if (protocol_word == "HTTP")
+      entry_offsets[LogEntry::kHTTP].push_back(line_start);
+    else if (protocol_word == "WebSocket")
+      entry_offsets[LogEntry::kWebSocket].push_back(line_start);
+  }
+}
+
+void DevToolsLogReader::PrefetchEntries(LogEntry::Protocol protocol_type) {
+  const std::vector<size_t>& offsets = entry_offsets[protocol_type];
+  size_t& index = next_entry_index[protocol_type];
+  std::deque<std::unique_ptr<LogEntry>>& queue = prefetched[protocol_type];
+  for (int i = 0; i < kPrefetchBatchSize && index < offsets.size(); i++) {
+    std::unique_ptr<LogEntry> log_entry = ParseEntryAt(offsets[index++]);
+    const bool parse_error = log_entry == nullptr;
+    queue.push_back(std::move(log_entry));
+    if (parse_error)
+      break;
+  }
+}
+
+std::unique_ptr<LogEntry> DevToolsLogReader::ParseEntryAt(size_t offset) {
+  size_t pos = offset;
+  const std::string header_line = NextLine(&pos);
+  std::istringstream header_stream(header_line);
+  // Advance the stream past the preamble; the index only records offsets of
+  // lines for which this returns true.
+  IsHeader(header_stream);
+  std::unique_ptr<LogEntry> log_entry =
+      std::make_unique<LogEntry>(header_stream);
+  if (log_entry->error) {
+    return nullptr;  // helpful error message already logged
+  }
+  log_entry->recorded_time = ParseHeaderTimestamp(header_line);
+  if (!(log_entry->event_type == LogEntry::kRequest &&
+        log_entry->protocol_type == LogEntry::kHTTP)) {
+    log_entry->payload = GetJSONString(header_stream, &pos);
+    if (log_entry->payload == "") {
+      LOG(ERROR) << "Problem parsing JSON from log file";
       return nullptr;
-    std::getline(log_file, next_line);
-
-    std::istringstream next_line_stream(next_line);
-    if (IsHeader(next_line_stream)) {
-      std::unique_ptr<LogEntry> log_entry =
-          std::make_unique<LogEntry>(next_line_stream);
-      if (log_entry->error) {
-        return nullptr;  // helpful error message already logged
-      }
-      if (log_entry->protocol_type != protocol_type)
-        continue;
-      if (!(log_entry->event_type == LogEntry::kRequest &&
-            log_entry->protocol_type == LogEntry::kHTTP)) {
-        log_entry->payload = GetJSONString(next_line_stream);
-        if (log_entry->payload == "") {
-          LOG(ERROR) << "Problem parsing JSON from log file";
-          return nullptr;
-        }
-      }
-      return log_entry;
     }
   }
+  return log_entry;
+}
+
+std::string DevToolsLogReader::NextLine(size_t* pos) const {
+  const size_t line_end = log_data.find('\n', *pos);
+  base::StringPiece line;
+  if (line_end == base::StringPiece::npos) {
+    line = log_data.substr(*pos);
+    *pos = log_data.size();
+  } else {
+    line = log_data.substr(*pos, line_end - *pos);
+    *pos = line_end + 1;
+  }
+  return std::string(line);
 }
 
-std::string DevToolsLogReader::GetJSONString(
-    std::istringstream& header_stream) {
+std::string DevToolsLogReader::GetJSONString(std::istringstream& header_stream,
+                                             size_t* pos) {
   std::string next_line, json;
 
   int opening_char_count = 0;
@@ -159,9 +259,9 @@ std::string DevToolsLogReader::GetJSONString(
     opening_char_count += CountChar(next_line, opening_char, closing_char);
     if (opening_char_count == 0)
       break;
-    if (log_file.eof())
+    if (*pos >= log_data.size())
       return "";
-    getline(log_file, next_line);
+    next_line = NextLine(pos);
   }
   return json;
 }
@@ -4,11 +4,15 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_LOG_REPLAY_DEVTOOLS_LOG_READER_H_
 #define CHROME_TEST_CHROMEDRIVER_LOG_REPLAY_DEVTOOLS_LOG_READER_H_
 
-#include <fstream>
+#include <deque>
+#include <iosfwd>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/strings/string_piece.h"
 
 // Represents one DevTools entry (command or response) in the log.
 //
@@ -55,9 +59,20 @@ class LogEntry {
   int id;
   std::string socket_id;
   bool error;
+  // Seconds since epoch from the timestamp preamble of the header line, or
+  // 0 if it could not be parsed. Only differences between entries are
+  // meaningful; replay uses them to reproduce (or collapse) the recorded
+  // pacing.
+  double recorded_time;
 };
 
 // Reads a log file for DevTools entries.
+//
+// The file is memory-mapped and indexed in a single pass up front: the
+// offsets of HTTP and WebSocket entry headers are recorded separately, so
+// advancing through one protocol's entries never re-scans the other
+// protocol's headers or payloads. Entries are then parsed from the mapped
+// data in small batches ahead of the consumer.
 class DevToolsLogReader {
  public:
   // Initialize the log reader using a path to a log file to read from.
@@ -77,13 +92,30 @@ class DevToolsLogReader {
   void UndoGetNext(std::unique_ptr<LogEntry> next);
 
  private:
-  std::unique_ptr<LogEntry> peeked;
-  std::ifstream log_file;
-  // Starting with |header_line|, parse a JSON string out of the log file.
+  // Record the offset of every HTTP and WebSocket entry header in
+  // |entry_offsets|. Runs once, at construction.
+  void BuildIndex();
+
+  // Parse up to a batch of entries of the given protocol into |prefetched|,
+  // starting at the index cursor. A nullptr is queued in place of an entry
+  // that fails to parse, so the error still reaches the caller in order.
+  void PrefetchEntries(LogEntry::Protocol protocol_type);
+
+  // Parse the complete entry (header plus any JSON payload) whose header
+  // line starts at |offset| in the mapped file.
+  std::unique_ptr<LogEntry> ParseEntryAt(size_t offset);
+
+  // Return the line starting at |*pos| in the mapped file, without the
+  // newline, and advance |*pos| past it.
+  std::string NextLine(size_t* pos) const;
+
+  // Starting with |header_line|, parse a JSON string out of the mapped file;
+  // |pos| is the offset of the line after the header and is advanced past
+  // the consumed lines.
   //
   // will parse either list or dictionary-type JSON strings, depending on the
   // starting character.
-  std::string GetJSONString(std::istringstream& header_line);
+  std::string GetJSONString(std::istringstream& header_line, size_t* pos);
 
   // Return whether |line| is a header of a DevTools entry.
   //
@@ -99,6 +131,14 @@ class DevToolsLogReader {
   int CountChar(const std::string& line,
                 char opening_char,
                 char closing_char) const;
+
+  std::unique_ptr<LogEntry> peeked;
+  base::MemoryMappedFile mapped_file;
+  base::StringPiece log_data;
+  // Indexed by LogEntry::Protocol.
+  std::vector<size_t> entry_offsets[2];
+  size_t next_entry_index[2];
+  std::deque<std::unique_ptr<LogEntry>> prefetched[2];
 };
 
 #endif  // CHROME_TEST_CHROMEDRIVER_LOG_REPLAY_DEVTOOLS_LOG_READER_H_
@@ -67,6 +67,28 @@ TEST(DevToolsLogReaderTest, ReadableTimeStampWindows) {
   EXPECT_EQ(next->payload, "{\n   \"string_key\": \"string_value\"\n}\n");
 }
 
+TEST(DevToolsLogReaderTest, CompactTimestamp) {
+  base::FilePath path = GetLogFileFromLiteral(kTestGetTitlePath);
+  DevToolsLogReader reader(path);
+  std::unique_ptr<LogEntry> next = reader.GetNext(LogEntry::kHTTP);
+  EXPECT_TRUE(next != nullptr);
+  EXPECT_DOUBLE_EQ(1534441986.823, next->recorded_time);
+}
+
+TEST(DevToolsLogReaderTest, ReadableTimestamp) {
+  base::FilePath path = GetLogFileFromLiteral(kReadableTimestampPathLinux);
+  DevToolsLogReader reader(path);
+  std::unique_ptr<LogEntry> first = reader.GetNext(LogEntry::kHTTP);
+  std::unique_ptr<LogEntry> second = reader.GetNext(LogEntry::kHTTP);
+  EXPECT_TRUE(first != nullptr);
+  EXPECT_TRUE(second != nullptr);
+  // Readable timestamps may be interpreted in local time, so only the
+  // difference between entries is specified - which is all replay pacing
+  // needs.
+  EXPECT_GT(first->recorded_time, 0);
+  EXPECT_NEAR(0.001107, second->recorded_time - first->recorded_time, 1e-6);
+}
+
 TEST(DevToolsLogReaderTest, Multiple) {
   base::FilePath path = GetLogFileFromLiteral(kTestGetTitlePath);
   DevToolsLogReader reader(path);
@@ -127,6 +149,19 @@ TEST(DevToolsLogReaderTest, WebSocketPayload) {
       "{\n   \"autoAttach\": true,\n   \"waitForDebuggerOnStart\": false\n}\n");
 }
 
+TEST(DevToolsLogReaderTest, ProtocolCursorsAreIndependent) {
+  base::FilePath path = GetLogFileFromLiteral(kTestGetTitlePath);
+  DevToolsLogReader reader(path);
+  std::unique_ptr<LogEntry> next = reader.GetNext(LogEntry::kWebSocket);
+  EXPECT_TRUE(next != nullptr);
+  EXPECT_EQ(next->command_name, "Log.enable");
+  // Serving the WebSocket read above must not consume the HTTP entries that
+  // appear earlier in the log.
+  next = reader.GetNext(LogEntry::kHTTP);
+  EXPECT_TRUE(next != nullptr);
+  EXPECT_EQ(next->command_name, "http://localhost:38037/json/version");
+}
+
 TEST(DevToolsLogReaderTest, TruncatedJSON) {
   base::FilePath path = GetLogFileFromLiteral(kTruncatedJSONPath);
   DevToolsLogReader reader(path);
@@ -3,14 +3,24 @@
 // found in the LICENSE file.
 #include "chrome/test/chromedriver/log_replay/log_replay_socket.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "base/files/file_path.h"
 #include "base/json/json_reader.h"
+#include "base/threading/platform_thread.h"
 #include "base/values.h"
+#include "chrome/test/chromedriver/net/timeout.h"
 
 LogReplaySocket::LogReplaySocket(const base::FilePath& log_path)
-    : connected_(false), log_reader_(log_path) {}
+    : LogReplaySocket(log_path, base::TimeDelta()) {}
+
+LogReplaySocket::LogReplaySocket(const base::FilePath& log_path,
+                                 const base::TimeDelta& fidelity_threshold)
+    : connected_(false),
+      log_reader_(log_path),
+      fidelity_threshold_(fidelity_threshold),
+      last_delivered_time_(0) {}
 
 LogReplaySocket::~LogReplaySocket() {}
 
@@ -48,6 +58,28 @@ std::unique_ptr<LogEntry> LogReplaySocket::GetNextSocketEntry(
   }
 }
 
+void LogReplaySocket::ScheduleDelivery(double recorded_time,
+                                       const Timeout& timeout) {
+  if (recorded_time == 0)
+    return;  // no usable timestamp in this log
+  if (last_delivered_time_ > 0 && recorded_time > last_delivered_time_) {
+    base::TimeDelta gap =
+        base::TimeDelta::FromSecondsD(recorded_time - last_delivered_time_);
+    if (!fidelity_threshold_.is_zero() && gap >= fidelity_threshold_) {
+      // Long gaps often cover real asynchrony (navigation, script
+      // settling); in fidelity mode they are reproduced for real so timing
+      // bugs stay reproducible, but never past the command's deadline.
+      if (timeout.is_set())
+        gap = std::min(gap, timeout.GetRemainingTime());
+      if (gap > base::TimeDelta())
+        base::PlatformThread::Sleep(gap);
+    } else if (Timeout::UsesVirtualClock()) {
+      Timeout::AdvanceVirtualClock(gap);
+    }
+  }
+  last_delivered_time_ = recorded_time;
+}
+
 SyncWebSocket::StatusCode LogReplaySocket::ReceiveNextMessage(
     std::string* message,
     const Timeout& timeout) {
@@ -55,6 +87,7 @@ SyncWebSocket::StatusCode LogReplaySocket::ReceiveNextMessage(
     return SyncWebSocket::kDisconnected;
   }
   std::unique_ptr<LogEntry> next = GetNextSocketEntry(false);
+  ScheduleDelivery(next->recorded_time, timeout);
   if (next->event_type == LogEntry::kResponse) {
     // We have to build the messages back up to what they would have been
     // in the actual WebSocket.
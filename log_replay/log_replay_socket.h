@@ -6,6 +6,7 @@
 
 #include <string>
 
+#include "base/time/time.h"
 #include "chrome/test/chromedriver/log_replay/devtools_log_reader.h"
 #include "chrome/test/chromedriver/net/sync_websocket.h"
 
@@ -18,6 +19,13 @@ class LogReplaySocket : public SyncWebSocket {
  public:
   // Initialize a LogReplaySocket with a ChromeDriver log.
   explicit LogReplaySocket(const base::FilePath& log_path);
+
+  // As above, but recorded gaps between delivered messages of at least
+  // |fidelity_threshold| are re-experienced in real time instead of being
+  // collapsed into the virtual clock (see ScheduleDelivery). A zero
+  // threshold collapses every gap.
+  LogReplaySocket(const base::FilePath& log_path,
+                  const base::TimeDelta& fidelity_threshold);
   ~LogReplaySocket() override;
 
   // Set the ID of this instance. This is intended to be the id_ of the
@@ -57,10 +65,24 @@ class LogReplaySocket : public SyncWebSocket {
   // Return the next WebSocket entry in the log. Returns requests only if
   // |include_requests| is true
   std::unique_ptr<LogEntry> GetNextSocketEntry(bool include_requests);
+
+  // Accounts for the recorded gap between the previously delivered message
+  // and one recorded at |recorded_time| before it is handed to the caller.
+  // Under the replay virtual clock the gap is folded into that clock, so
+  // Timeout deadlines expire in the recorded order without any real time
+  // passing; a gap of at least |fidelity_threshold_| (when one is set) is
+  // instead slept for real, clamped to the remaining time of |timeout|.
+  void ScheduleDelivery(double recorded_time, const Timeout& timeout);
+
   bool connected_;
   int max_id_;
   DevToolsLogReader log_reader_;
   std::string socket_id_;
+  // See the two-argument constructor.
+  base::TimeDelta fidelity_threshold_;
+  // recorded_time of the last message returned by ReceiveNextMessage, or 0
+  // before the first delivery.
+  double last_delivered_time_;
 };
 
 #endif  // CHROME_TEST_CHROMEDRIVER_LOG_REPLAY_LOG_REPLAY_SOCKET_H_
@@ -0,0 +1,219 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "chrome/test/chromedriver/log_replay/parallel_replay.h"
+
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/files/file_enumerator.h"
+#include "base/json/json_reader.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/system/sys_info.h"
+#include "base/task/thread_pool.h"
+#include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/values.h"
+#include "chrome/test/chromedriver/log_replay/devtools_log_reader.h"
+#include "chrome/test/chromedriver/log_replay/log_replay_socket.h"
+#include "chrome/test/chromedriver/net/timeout.h"
+#include "url/gurl.h"
+
+namespace {
+
+// Cap on |mismatch_details| per file; past this only the count grows.
+const size_t kMaxMismatchDetails = 10;
+
+void AddMismatch(ReplayResult* result, const std::string& detail) {
+  result->mismatches++;
+  if (result->mismatch_details.size() < kMaxMismatchDetails)
+    result->mismatch_details.push_back(detail);
+}
+
+// Returns the replay socket for |socket_id|, creating and "connecting" it on
+// first use. Each socket owns an independent reader over the same log and
+// skips entries belonging to other sockets, matching how a replay session
+// hands one LogReplaySocket to each DevTools client.
+LogReplaySocket* GetSocket(
+    const base::FilePath& log_path,
+    const std::string& socket_id,
+    std::map<std::string, std::unique_ptr<LogReplaySocket>>* sockets) {
+  auto it = sockets->find(socket_id);
+  if (it == sockets->end()) {
+    auto socket = std::make_unique<LogReplaySocket>(log_path);
+    socket->SetId(socket_id);
+    socket->Connect(GURL());
+    it = sockets->emplace(socket_id, std::move(socket)).first;
+  }
+  return it->second.get();
+}
+
+// Replays files |begin|, |begin| + |stride|, ... of |*paths| and signals
+// |done|. The pointers must stay valid until |done| is signaled.
+void ReplayWorker(const std::vector<base::FilePath>* paths,
+                  size_t begin,
+                  size_t stride,
+                  ReplayProgressReporter* reporter,
+                  base::WaitableEvent* done) {
+  for (size_t i = begin; i < paths->size(); i += stride)
+    reporter->ReportFileDone(ReplayLogFile((*paths)[i]));
+  done->Signal();
+}
+
+}  // namespace
+
+ReplayResult::ReplayResult() : entries(0), mismatches(0) {}
+
+ReplayResult::ReplayResult(const ReplayResult& other) = default;
+
+ReplayResult::~ReplayResult() {}
+
+ReplayProgressReporter::ReplayProgressReporter()
+    : files_done_(0), total_entries_(0), total_mismatches_(0) {}
+
+ReplayProgressReporter::~ReplayProgressReporter() {}
+
+void ReplayProgressReporter::ReportFileDone(const ReplayResult& result) {
+  base::AutoLock lock(lock_);
+  files_done_++;
+  total_entries_ += result.entries;
+  total_mismatches_ += result.mismatches;
+  results_.push_back(result);
+  VLOG(1) << "replayed " << result.log_path.value() << ": " << result.entries
+          << " entries, " << result.mismatches << " mismatches ("
+          << files_done_ << " files done)";
+}
+
+int ReplayProgressReporter::files_done() const {
+  base::AutoLock lock(lock_);
+  return files_done_;
+}
+
+int ReplayProgressReporter::total_entries() const {
+  base::AutoLock lock(lock_);
+  return total_entries_;
+}
+
+int ReplayProgressReporter::total_mismatches() const {
+  base::AutoLock lock(lock_);
+  return total_mismatches_;
+}
+
+std::vector<ReplayResult> ReplayProgressReporter::results() const {
+  base::AutoLock lock(lock_);
+  return results_;
+}
+
+ReplayResult ReplayLogFile(const base::FilePath& log_path) {
+  ReplayResult result;
+  result.log_path = log_path;
+
+  // The driver walks all WebSocket entries in global log order; the sockets
+  // each re-read the log filtered to their own id, exactly as during a
+  // replay session.
+  DevToolsLogReader reader(log_path);
+  std::map<std::string, std::unique_ptr<LogReplaySocket>> sockets;
+  Timeout timeout;
+
+  while (true) {
+    std::unique_ptr<LogEntry> entry = reader.GetNext(LogEntry::kWebSocket);
+    if (entry == nullptr)
+      break;
+    result.entries++;
+    LogReplaySocket* socket = GetSocket(log_path, entry->socket_id, &sockets);
+
+    if (entry->event_type == LogEntry::kRequest) {
+      // Send only reads the id; the socket uses it to gate responses the
+      // same way the live replay does.
+      socket->Send("{\"id\":" + base::NumberToString(entry->id) + "}");
+      continue;
+    }
+
+    // The log says a response or event arrived here; it must be available
+    // to the socket now, or replaying this log live would hang.
+    if (!socket->HasNextMessage()) {
+      AddMismatch(&result, "entry " + base::NumberToString(result.entries) +
+                               ": logged message not available for replay");
+      continue;
+    }
+    std::string message;
+    if (socket->ReceiveNextMessage(&message, timeout) != SyncWebSocket::kOk) {
+      AddMismatch(&result, "entry " + base::NumberToString(result.entries) +
+                               ": socket failed to produce logged message");
+      continue;
+    }
+    std::unique_ptr<base::Value> json =
+        base::JSONReader::ReadDeprecated(message);
+    base::DictionaryValue* message_dict = nullptr;
+    if (!json || !json->GetAsDictionary(&message_dict)) {
+      AddMismatch(&result, "entry " + base::NumberToString(result.entries) +
+                               ": replayed message is not valid JSON");
+      continue;
+    }
+    if (entry->event_type == LogEntry::kResponse) {
+      int id = -1;
+      if (!message_dict->GetInteger("id", &id) || id != entry->id) {
+        AddMismatch(&result,
+                    "entry " + base::NumberToString(result.entries) +
+                        ": expected response id " +
+                        base::NumberToString(entry->id) + ", got id " +
+                        base::NumberToString(id));
+      }
+    } else {
+      std::string method;
+      if (!message_dict->GetString("method", &method) ||
+          method != entry->command_name) {
+        AddMismatch(&result, "entry " + base::NumberToString(result.entries) +
+                                 ": expected event " + entry->command_name +
+                                 ", got " + method);
+      }
+    }
+  }
+  return result;
+}
+
+Status ReplayLogDirectory(const base::FilePath& log_dir,
+                          int num_threads,
+                          ReplayProgressReporter* reporter) {
+  std::vector<base::FilePath> paths;
+  base::FileEnumerator enumerator(log_dir, false /* recursive */,
+                                  base::FileEnumerator::FILES,
+                                  FILE_PATH_LITERAL("*.log"));
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    paths.push_back(path);
+  }
+  if (paths.empty())
+    return Status(kUnknownError,
+                  "no .log files found in " + log_dir.AsUTF8Unsafe());
+
+  if (num_threads <= 0)
+    num_threads = base::SysInfo::NumberOfProcessors();
+  if (static_cast<size_t>(num_threads) > paths.size())
+    num_threads = static_cast<int>(paths.size());
+
+  if (num_threads < 2 || !base::ThreadPoolInstance::Get()) {
+    base::WaitableEvent done;
+    ReplayWorker(&paths, 0, 1, reporter, &done);
+    return Status(kOk);
+  }
+
+  // Stripe the files across the workers; each stripe is an independent
+  // pipeline over its own readers and sockets.
+  std::vector<std::unique_ptr<base::WaitableEvent>> done_events;
+  for (int i = 0; i < num_threads; ++i) {
+    done_events.push_back(std::make_unique<base::WaitableEvent>());
+    base::ThreadPool::PostTask(
+        FROM_HERE, {base::MayBlock()},
+        base::BindOnce(&ReplayWorker, &paths, static_cast<size_t>(i),
+                       static_cast<size_t>(num_threads), reporter,
+                       done_events.back().get()));
+  }
+  // Join before returning; the workers read stack-owned state.
+  for (const auto& done : done_events)
+    done->Wait();
+  return Status(kOk);
+}
@@ -0,0 +1,71 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef CHROME_TEST_CHROMEDRIVER_LOG_REPLAY_PARALLEL_REPLAY_H_
+#define CHROME_TEST_CHROMEDRIVER_LOG_REPLAY_PARALLEL_REPLAY_H_
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/synchronization/lock.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+
+// Outcome of replaying the DevTools side of one log file.
+struct ReplayResult {
+  ReplayResult();
+  ReplayResult(const ReplayResult& other);
+  ~ReplayResult();
+
+  base::FilePath log_path;
+  // WebSocket entries consumed from the log.
+  int entries;
+  // Entries whose replay did not line up with the log: a response or event
+  // that was not available when the log says it arrived, or that came back
+  // with the wrong id or method.
+  int mismatches;
+  // Human-readable descriptions of the first few mismatches.
+  std::vector<std::string> mismatch_details;
+};
+
+// Shared sink for the per-file results of a parallel replay. All methods are
+// thread-safe; workers call ReportFileDone as they finish each log.
+class ReplayProgressReporter {
+ public:
+  ReplayProgressReporter();
+  ~ReplayProgressReporter();
+
+  void ReportFileDone(const ReplayResult& result);
+
+  int files_done() const;
+  int total_entries() const;
+  int total_mismatches() const;
+  std::vector<ReplayResult> results() const;
+
+ private:
+  mutable base::Lock lock_;
+  int files_done_;
+  int total_entries_;
+  int total_mismatches_;
+  std::vector<ReplayResult> results_;
+};
+
+// Replays the DevTools side of a single log: walks every WebSocket entry in
+// order, pushes commands through a LogReplaySocket for the entry's socket id
+// and draws the logged responses and events back out, recording anything
+// that fails to line up as a mismatch. The client side stays in
+// client_replay.py; this validates that a log still replays cleanly through
+// the reader and socket machinery.
+ReplayResult ReplayLogFile(const base::FilePath& log_path);
+
+// Replays every "*.log" file under |log_dir| (non-recursively), partitioned
+// across |num_threads| workers, each running an independent reader-and-socket
+// pipeline; results funnel into |reporter|. The pipelines share nothing but
+// the reporter, so throughput scales with cores until the logs run out.
+// |num_threads| <= 0 means one worker per processor. Runs the files inline
+// on the calling thread when no thread pool is available.
+Status ReplayLogDirectory(const base::FilePath& log_dir,
+                          int num_threads,
+                          ReplayProgressReporter* reporter);
+
+#endif  // CHROME_TEST_CHROMEDRIVER_LOG_REPLAY_PARALLEL_REPLAY_H_
@@ -0,0 +1,55 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "chrome/test/chromedriver/log_replay/parallel_replay.h"
+
+#include "base/base_paths.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/path_service.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+// Directory holding the sample logs used by the reader tests.
+const char* const kTestDataPath[] = {"chrome", "test", "chromedriver",
+                                     "log_replay", "test_data"};
+const char kTestGetTitlePath[] = "testGetTitle_simple.log";
+
+base::FilePath GetTestDataDir() {
+  base::FilePath root_dir;
+  CHECK(base::PathService::Get(base::DIR_SOURCE_ROOT, &root_dir));
+  for (int i = 0; i < 5; i++)
+    root_dir = root_dir.AppendASCII(kTestDataPath[i]);
+  CHECK(base::PathExists(root_dir));
+  return root_dir;
+}
+}  // namespace
+
+TEST(ParallelReplayTest, ReplaysSingleLogCleanly) {
+  ReplayResult result =
+      ReplayLogFile(GetTestDataDir().AppendASCII(kTestGetTitlePath));
+  // The sample log holds three WebSocket commands and no responses.
+  EXPECT_EQ(3, result.entries);
+  EXPECT_EQ(0, result.mismatches);
+}
+
+TEST(ParallelReplayTest, ReplaysDirectory) {
+  ReplayProgressReporter reporter;
+  // No thread pool runs in the unit tests, so this exercises the striping
+  // and reporting through the inline fallback.
+  Status status = ReplayLogDirectory(GetTestDataDir(), 2, &reporter);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  EXPECT_EQ(5, reporter.files_done());
+  EXPECT_GE(reporter.total_entries(), 6);
+  EXPECT_EQ(0, reporter.total_mismatches());
+  EXPECT_EQ(5U, reporter.results().size());
+}
+
+TEST(ParallelReplayTest, EmptyDirectoryIsAnError) {
+  base::FilePath missing =
+      GetTestDataDir().AppendASCII("no_such_subdirectory");
+  ReplayProgressReporter reporter;
+  EXPECT_EQ(kUnknownError,
+            ReplayLogDirectory(missing, 1, &reporter).code());
+}
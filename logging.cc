@@ -8,14 +8,29 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "base/bind.h"
 #include "base/command_line.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
 #include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
 #include "base/logging.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/rand_util.h"
+#include "base/sequenced_task_runner.h"
 #include "base/stl_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
 #include "base/strings/stringprintf.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
+#include "base/task/thread_pool/thread_pool_instance.h"
 #include "base/time/time.h"
 #include "build/build_config.h"
 #include "chrome/test/chromedriver/capabilities.h"
@@ -26,6 +41,7 @@
 #include "chrome/test/chromedriver/devtools_events_logger.h"
 #include "chrome/test/chromedriver/performance_logger.h"
 #include "chrome/test/chromedriver/session.h"
+#include "third_party/zlib/google/compression_utils.h"
 
 #if defined(OS_POSIX)
 #include <fcntl.h>
@@ -48,6 +64,26 @@ int64_t g_start_time = 0;
 
 bool readable_timestamp;
 
+// Log-file rotation state; set once in InitLogging when --log-path is
+// combined with a rotation switch, then touched only on the logger
+// sequence. |g_log_path| stays null when rotation is off.
+base::FilePath* g_log_path = nullptr;
+int64_t g_rotate_bytes = 0;           // 0 = no size-based rotation.
+int64_t g_rotate_interval_us = 0;     // 0 = no time-based rotation.
+int g_rotate_retain_count = 10;       // Rotated segments kept on disk.
+int64_t g_segment_bytes = 0;          // Written to the current segment.
+int64_t g_segment_opened_us = 0;      // TimeTicks of the current segment.
+
+// Spooled log entries are compressed and written out once this many bytes of
+// serialized JSON have accumulated. Also bounds roughly how much decompressed
+// data reading one batch back brings into memory.
+const size_t kSpoolFlushBytes = 1024 * 1024;
+
+// Approximate fixed cost of one buffered entry beyond its message and
+// source strings: the dictionary, the timestamp and level fields, and the
+// deque slot. Gauges only need to track growth, not byte-exact usage.
+const size_t kLogEntryByteOverhead = 100;
+
 // Array indices are the Log::Level enum values.
 const char* const kLevelToName[] = {
   "ALL",  // kAll
@@ -108,6 +144,145 @@ bool InternalIsVLogOn(int vlog_level) {
   return GetLevelFromSeverity(vlog_level * -1) >= level;
 }
 
+// Returns the sequence on which log lines are formatted and written out,
+// creating it on first use. The sequence blocks shutdown so that lines
+// already queued are flushed before the process exits.
+scoped_refptr<base::SequencedTaskRunner> GetLogTaskRunner() {
+  static scoped_refptr<base::SequencedTaskRunner>* task_runner =
+      new scoped_refptr<base::SequencedTaskRunner>(
+          base::ThreadPool::CreateSequencedTaskRunner(
+              {base::MayBlock(),
+               base::TaskShutdownBehavior::BLOCK_SHUTDOWN}));
+  return *task_runner;
+}
+
+// Returns the sequence that compresses and prunes rotated log segments,
+// creating it on first use. Separate from the logger sequence so that
+// gzipping a segment does not stall log writes behind it, and sequenced so
+// that prunes never race a compression of the same file. Best-effort: a
+// segment compressed a little later costs only disk space.
+scoped_refptr<base::SequencedTaskRunner> GetLogMaintenanceTaskRunner() {
+  static scoped_refptr<base::SequencedTaskRunner>* task_runner =
+      new scoped_refptr<base::SequencedTaskRunner>(
+          base::ThreadPool::CreateSequencedTaskRunner(
+              {base::MayBlock(), base::TaskPriority::BEST_EFFORT,
+               base::TaskShutdownBehavior::CONTINUE_ON_SHUTDOWN}));
+  return *task_runner;
+}
+
+// Deletes the oldest rotated segments beyond the retention cap. Rotated
+// names share the log file's stem and carry a fixed-width timestamp, so
+// lexicographic order is chronological. Runs on the maintenance sequence.
+void PruneRotatedSegments() {
+  std::vector<base::FilePath> rotated;
+  base::FileEnumerator enumerator(
+      g_log_path->DirName(), false /* recursive */,
+      base::FileEnumerator::FILES,
+      g_log_path->BaseName().RemoveExtension().value() +
+          FILE_PATH_LITERAL(".*"));
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    if (path.BaseName() == g_log_path->BaseName())
+      continue;  // The active log file.
+    rotated.push_back(path);
+  }
+  if (rotated.size() <= static_cast<size_t>(g_rotate_retain_count))
+    return;
+  std::sort(rotated.begin(), rotated.end());
+  size_t excess = rotated.size() - g_rotate_retain_count;
+  for (size_t i = 0; i < excess; ++i)
+    base::DeleteFile(rotated[i]);
+}
+
+// Gzips one rotated segment in place (segment -> segment.gz) and applies
+// the retention cap. Runs on the maintenance sequence; memory use is
+// bounded by the rotation size cap, not by total log growth.
+void CompressRotatedSegment(const base::FilePath& rotated_path) {
+  std::string contents;
+  if (base::ReadFileToString(rotated_path, &contents)) {
+    std::string compressed;
+    if (compression::GzipCompress(contents, &compressed) &&
+        base::WriteFile(rotated_path.AddExtension(FILE_PATH_LITERAL(".gz")),
+                        compressed)) {
+      base::DeleteFile(rotated_path);
+    }
+  }
+  PruneRotatedSegments();
+}
+
+// Rotates the log file once the current segment exceeds the size or age
+// cap: the segment is renamed aside with a timestamp suffix, stderr is
+// reopened onto a fresh file at the original path, and compression of the
+// renamed segment is handed to the maintenance sequence. Runs on the
+// logger sequence, so command threads never see any of this.
+void MaybeRotateLogFile(size_t bytes_just_written) {
+  g_segment_bytes += bytes_just_written;
+  if (!base::ThreadPoolInstance::Get())
+    return;
+  int64_t now_us =
+      (base::TimeTicks::Now() - base::TimeTicks()).InMicroseconds();
+  bool over_size = g_rotate_bytes > 0 && g_segment_bytes >= g_rotate_bytes;
+  bool over_age = g_rotate_interval_us > 0 &&
+                  now_us - g_segment_opened_us >= g_rotate_interval_us;
+  if (!over_size && !over_age)
+    return;
+
+  base::Time::Exploded now;
+  base::Time::Now().LocalExplode(&now);
+  base::FilePath rotated = g_log_path->InsertBeforeExtensionASCII(
+      base::StringPrintf(".%04d%02d%02d-%02d%02d%02d", now.year, now.month,
+                         now.day_of_month, now.hour, now.minute, now.second));
+  // On Windows the rename fails while stderr holds the file open; rotation
+  // is then skipped and retried at the next threshold check.
+  if (!base::Move(*g_log_path, rotated))
+    return;
+#if defined(OS_WIN)
+  _wfreopen(g_log_path->value().c_str(), FILE_PATH_LITERAL("w"), stderr);
+#else
+  freopen(g_log_path->value().c_str(), "w", stderr);
+#endif
+  g_segment_bytes = 0;
+  g_segment_opened_us = now_us;
+  GetLogMaintenanceTaskRunner()->PostTask(
+      FROM_HERE, base::BindOnce(&CompressRotatedSegment, rotated));
+}
+
+// Formats one log line and writes it to stderr. Runs on the logger sequence
+// once the thread pool is up; both timestamps are captured at the call site
+// so queueing delay does not show up in them.
+void WriteLogEntry(Log::Level level,
+                   base::Time wall_time,
+                   base::TimeTicks ticks,
+                   const std::string& message) {
+  const char* level_name = LevelToName(level);
+  std::string entry;
+
+  if (readable_timestamp) {
+    base::Time::Exploded local_time;
+    wall_time.LocalExplode(&local_time);
+    int64_t micros =
+        (wall_time - base::Time::UnixEpoch()).InMicroseconds() % 1000000;
+
+    entry = base::StringPrintf(
+        "[%02d-%02d-%04d %02d:%02d:%02d.%06ld][%s]: %s",
+        local_time.month, local_time.day_of_month, local_time.year,
+        local_time.hour, local_time.minute, local_time.second,
+        static_cast<long>(micros),
+        level_name,
+        message.c_str());
+  } else {
+    entry = base::StringPrintf(
+        "[%.3lf][%s]: %s",
+        base::TimeDelta(ticks - base::TimeTicks::UnixEpoch()).InSecondsF(),
+        level_name,
+        message.c_str());
+  }
+  fprintf(stderr, "%s", entry.c_str());
+  fflush(stderr);
+  if (g_log_path)
+    MaybeRotateLogFile(entry.size());
+}
+
 bool HandleLogMessage(int severity,
                       const char* file,
                       int line,
@@ -117,50 +292,18 @@ bool HandleLogMessage(int severity,
   std::string message = str.substr(message_start);
 
   if (level >= g_log_level) {
-    const char* level_name = LevelToName(level);
-    std::string entry;
-
-    if (readable_timestamp) {
-#if defined(OS_WIN)
-      SYSTEMTIME local_time;
-      GetLocalTime(&local_time);
-
-      entry = base::StringPrintf(
-          "[%02d-%02d-%04d %02d:%02d:%02d.%03d][%s]: %s",
-          local_time.wMonth, local_time.wDay, local_time.wYear,
-          local_time.wHour, local_time.wMinute, local_time.wSecond,
-          local_time.wMilliseconds,
-          level_name,
-          message.c_str());
-#elif defined(OS_POSIX) || defined(OS_FUCHSIA)
-      timeval tv;
-      gettimeofday(&tv, nullptr);
-      time_t t = tv.tv_sec;
-      struct tm local_time;
-      localtime_r(&t, &local_time);
-      struct tm* tm_time = &local_time;
-
-      entry = base::StringPrintf(
-          "[%02d-%02d-%04d %02d:%02d:%02d.%06ld][%s]: %s",
-          1 + tm_time->tm_mon, tm_time->tm_mday, 1900 + tm_time->tm_year,
-          tm_time->tm_hour, tm_time->tm_min, tm_time->tm_sec,
-          static_cast<long>(tv.tv_usec),
-          level_name,
-          message.c_str());
-#else
-#error Unsupported platform
-#endif
+    // Hand formatting and the stderr write to the logger sequence so that
+    // verbose logging of multi-KB DevTools payloads does not tax the command
+    // path. Before the thread pool exists (early startup), write inline.
+    base::Time wall_time = base::Time::Now();
+    base::TimeTicks ticks = base::TimeTicks::Now();
+    if (base::ThreadPoolInstance::Get()) {
+      GetLogTaskRunner()->PostTask(
+          FROM_HERE, base::BindOnce(&WriteLogEntry, level, wall_time, ticks,
+                                    message));
     } else {
-      entry = base::StringPrintf(
-          "[%.3lf][%s]: %s",
-          base::TimeDelta(base::TimeTicks::Now() -
-                          base::TimeTicks::UnixEpoch())
-              .InSecondsF(),
-          level_name,
-          message.c_str());
+      WriteLogEntry(level, wall_time, ticks, message);
     }
-    fprintf(stderr, "%s", entry.c_str());
-    fflush(stderr);
   }
 
   WebDriverLog* session_log = GetSessionLog();
@@ -188,50 +331,162 @@ bool WebDriverLog::NameToLevel(const std::string& name, Log::Level* out_level) {
 }
 
 WebDriverLog::WebDriverLog(const std::string& type, Log::Level min_level)
-    : type_(type), min_level_(min_level), emptied_(true) {}
+    : type_(type),
+      min_level_(min_level),
+      emptied_(true),
+      max_buffered_entries_(internal::kDefaultMaxBufferedEntries),
+      buffered_bytes_(0),
+      spooling_(false),
+      spool_read_offset_(0),
+      spool_write_offset_(0),
+      pending_spool_bytes_(0) {}
 
 WebDriverLog::~WebDriverLog() {
-  size_t sum = 0;
-  for (const std::unique_ptr<base::ListValue>& batch : batches_of_entries_)
-    sum += batch->GetSize();
-  VLOG(1) << "Log type '" << type_ << "' lost " << sum
+  VLOG(1) << "Log type '" << type_ << "' lost " << entries_.size()
           << " entries on destruction";
+  AdjustBufferedBytes(-static_cast<int64_t>(buffered_bytes_));
+}
+
+void WebDriverLog::set_memory_stats(
+    scoped_refptr<SessionMemoryStats> memory_stats) {
+  memory_stats_ = std::move(memory_stats);
+  // Credit whatever accumulated before the session's gauges were attached.
+  if (memory_stats_ && buffered_bytes_) {
+    memory_stats_->log_bytes.fetch_add(buffered_bytes_,
+                                       std::memory_order_relaxed);
+  }
+}
+
+void WebDriverLog::AdjustBufferedBytes(int64_t delta) {
+  buffered_bytes_ += delta;
+  if (memory_stats_)
+    memory_stats_->log_bytes.fetch_add(delta, std::memory_order_relaxed);
 }
 
 std::unique_ptr<base::ListValue> WebDriverLog::GetAndClearEntries() {
-  std::unique_ptr<base::ListValue> ret;
-  if (batches_of_entries_.empty()) {
-    ret = std::make_unique<base::ListValue>();
+  std::unique_ptr<base::ListValue> ret = std::make_unique<base::ListValue>();
+  if (spooling_) {
+    FlushSpoolBatch();
+    // Return whole batches until the cap is reached, so one call never holds
+    // much more than |kMaxReturnedEntries| entries plus one decompressed
+    // batch in memory. Clients page through the rest with further calls.
+    while (ret->GetSize() < internal::kMaxReturnedEntries) {
+      std::vector<std::string> batch;
+      if (!ReadNextSpoolBatch(&batch))
+        break;
+      for (const std::string& json : batch) {
+        std::unique_ptr<base::Value> entry =
+            base::JSONReader::ReadDeprecated(json);
+        if (entry)
+          ret->Append(std::move(entry));
+      }
+    }
+    if (spool_read_offset_ == spool_write_offset_) {
+      // Fully drained; reclaim the disk space before the next trace interval.
+      spool_file_.SetLength(0);
+      spool_read_offset_ = 0;
+      spool_write_offset_ = 0;
+    }
+    emptied_ = ret->GetSize() == 0;
+    return ret;
+  }
+  if (entries_.empty()) {
     emptied_ = true;
-  } else {
-    ret = std::move(batches_of_entries_.front());
-    batches_of_entries_.pop_front();
-    emptied_ = false;
+    return ret;
+  }
+  size_t count = std::min(entries_.size(), internal::kMaxReturnedEntries);
+  for (size_t i = 0; i < count; ++i) {
+    ret->Append(std::move(entries_.front()));
+    entries_.pop_front();
+    AdjustBufferedBytes(-static_cast<int64_t>(entry_bytes_.front()));
+    entry_bytes_.pop_front();
   }
+  emptied_ = false;
   return ret;
 }
 
-bool GetFirstErrorMessageFromList(const base::ListValue* list,
-                                  std::string* message) {
-  for (auto it = list->begin(); it != list->end(); ++it) {
-    const base::DictionaryValue* log_entry = NULL;
-    it->GetAsDictionary(&log_entry);
-    if (log_entry != NULL) {
-      std::string level;
-      if (log_entry->GetString("level", &level))
-        if (level == kLevelToName[Log::kError])
-          if (log_entry->GetString("message", message))
-            return true;
-    }
+bool WebDriverLog::EnableSpooling() {
+  base::FilePath path;
+  if (!base::CreateTemporaryFile(&path))
+    return false;
+  spool_file_.Initialize(path, base::File::FLAG_OPEN | base::File::FLAG_READ |
+                                   base::File::FLAG_WRITE |
+                                   base::File::FLAG_DELETE_ON_CLOSE);
+  if (!spool_file_.IsValid()) {
+    base::DeleteFile(path);
+    return false;
   }
-  return false;
+  spooling_ = true;
+  return true;
+}
+
+void WebDriverLog::FlushSpoolBatch() {
+  if (pending_spool_entries_.empty())
+    return;
+  std::string batch;
+  batch.reserve(pending_spool_bytes_ + pending_spool_entries_.size());
+  for (const std::string& entry : pending_spool_entries_) {
+    batch += entry;
+    batch += '\n';
+  }
+  std::string compressed;
+  if (!compression::GzipCompress(batch, &compressed)) {
+    LOG(WARNING) << "cannot compress spooled log batch, will retry";
+    return;
+  }
+  // The length prefix is read back by the same process, so host byte order
+  // is fine. A failed or short write leaves |spool_write_offset_| untouched;
+  // the retry overwrites any partial frame.
+  uint32_t batch_size = static_cast<uint32_t>(compressed.size());
+  if (spool_file_.Write(spool_write_offset_,
+                        reinterpret_cast<const char*>(&batch_size),
+                        sizeof(batch_size)) !=
+          static_cast<int>(sizeof(batch_size)) ||
+      spool_file_.Write(spool_write_offset_ + sizeof(batch_size),
+                        compressed.data(),
+                        batch_size) != static_cast<int>(batch_size)) {
+    LOG(WARNING) << "cannot write spooled log batch, will retry";
+    return;
+  }
+  spool_write_offset_ += sizeof(batch_size) + batch_size;
+  pending_spool_entries_.clear();
+  pending_spool_bytes_ = 0;
+}
+
+bool WebDriverLog::ReadNextSpoolBatch(std::vector<std::string>* entries) {
+  if (spool_read_offset_ >= spool_write_offset_)
+    return false;
+  uint32_t batch_size = 0;
+  if (spool_file_.Read(spool_read_offset_,
+                       reinterpret_cast<char*>(&batch_size),
+                       sizeof(batch_size)) !=
+      static_cast<int>(sizeof(batch_size))) {
+    return false;
+  }
+  std::string compressed(batch_size, '\0');
+  if (spool_file_.Read(spool_read_offset_ + sizeof(batch_size), &compressed[0],
+                       batch_size) != static_cast<int>(batch_size)) {
+    return false;
+  }
+  spool_read_offset_ += sizeof(batch_size) + batch_size;
+  std::string batch;
+  if (!compression::GzipUncompress(compressed, &batch))
+    return false;
+  *entries = base::SplitString(batch, "\n", base::KEEP_WHITESPACE,
+                               base::SPLIT_WANT_NONEMPTY);
+  return true;
 }
 
 std::string WebDriverLog::GetFirstErrorMessage() const {
   std::string message;
-  for (const std::unique_ptr<base::ListValue>& list : batches_of_entries_)
-    if (GetFirstErrorMessageFromList(list.get(), &message))
+  for (const std::unique_ptr<base::DictionaryValue>& entry : entries_) {
+    std::string level;
+    if (entry->GetString("level", &level) &&
+        level == kLevelToName[Log::kError] &&
+        entry->GetString("message", &message)) {
       break;
+    }
+  }
   return message;
 }
 
@@ -250,14 +505,24 @@ void WebDriverLog::AddEntryTimestamped(const base::Time& timestamp,
   if (!source.empty())
     log_entry_dict->SetString("source", source);
   log_entry_dict->SetString("message", message);
-  if (batches_of_entries_.empty() ||
-      batches_of_entries_.back()->GetSize() >= internal::kMaxReturnedEntries) {
-    std::unique_ptr<base::ListValue> list(new base::ListValue());
-    list->Append(std::move(log_entry_dict));
-    batches_of_entries_.push_back(std::move(list));
-  } else {
-    batches_of_entries_.back()->Append(std::move(log_entry_dict));
+  if (spooling_) {
+    std::string json;
+    base::JSONWriter::Write(*log_entry_dict, &json);
+    pending_spool_bytes_ += json.length();
+    pending_spool_entries_.push_back(std::move(json));
+    if (pending_spool_bytes_ >= kSpoolFlushBytes)
+      FlushSpoolBatch();
+    return;
+  }
+  if (max_buffered_entries_ && entries_.size() >= max_buffered_entries_) {
+    entries_.pop_front();
+    AdjustBufferedBytes(-static_cast<int64_t>(entry_bytes_.front()));
+    entry_bytes_.pop_front();
   }
+  size_t entry_size = message.size() + source.size() + kLogEntryByteOverhead;
+  entries_.push_back(std::move(log_entry_dict));
+  entry_bytes_.push_back(entry_size);
+  AdjustBufferedBytes(entry_size);
 }
 
 bool WebDriverLog::Emptied() const {
@@ -276,6 +541,10 @@ Log::Level WebDriverLog::min_level() const {
   return min_level_;
 }
 
+void WebDriverLog::set_max_buffered_entries(size_t max_buffered_entries) {
+  max_buffered_entries_ = max_buffered_entries;
+}
+
 bool InitLogging(uint16_t port) {
   g_start_time = base::TimeTicks::Now().ToInternalValue();
   base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
@@ -300,6 +569,43 @@ bool InitLogging(uint16_t port) {
       printf("Failed to redirect stderr to log file.\n");
       return false;
     }
+
+    int rotate_mb = 0;
+    if (cmd_line->HasSwitch("log-rotate-size-mb") &&
+        (!base::StringToInt(cmd_line->GetSwitchValueASCII("log-rotate-size-mb"),
+                            &rotate_mb) ||
+         rotate_mb <= 0)) {
+      printf("Invalid --log-rotate-size-mb value.\n");
+      return false;
+    }
+    int rotate_hours = 0;
+    if (cmd_line->HasSwitch("log-rotate-hours") &&
+        (!base::StringToInt(cmd_line->GetSwitchValueASCII("log-rotate-hours"),
+                            &rotate_hours) ||
+         rotate_hours <= 0)) {
+      printf("Invalid --log-rotate-hours value.\n");
+      return false;
+    }
+    if (cmd_line->HasSwitch("log-rotate-retain") &&
+        (!base::StringToInt(cmd_line->GetSwitchValueASCII("log-rotate-retain"),
+                            &g_rotate_retain_count) ||
+         g_rotate_retain_count < 0)) {
+      printf("Invalid --log-rotate-retain value.\n");
+      return false;
+    }
+    if (rotate_mb > 0 || rotate_hours > 0) {
+      g_rotate_bytes = static_cast<int64_t>(rotate_mb) * 1024 * 1024;
+      g_rotate_interval_us = rotate_hours * base::Time::kMicrosecondsPerHour;
+      g_log_path = new base::FilePath(log_path);
+      g_segment_opened_us =
+          (base::TimeTicks::Now() - base::TimeTicks()).InMicroseconds();
+      if (cmd_line->HasSwitch("append-log")) {
+        // The inherited file counts against the first segment's size cap.
+        int64_t existing_size = 0;
+        if (base::GetFileSize(log_path, &existing_size))
+          g_segment_bytes = existing_size;
+      }
+    }
   }
 
   Log::truncate_logged_params = !cmd_line->HasSwitch("replayable");
@@ -372,6 +678,17 @@ Status CreateLogs(
     if (type == WebDriverLog::kPerformanceType) {
       if (level != Log::kOff) {
         logs.push_back(std::make_unique<WebDriverLog>(type, Log::kAll));
+        // Fleet monitoring may ask for only 1-in-N session coverage; an
+        // unsampled session keeps the (empty) performance log so clients can
+        // still fetch it, but attaches no capture listener.
+        int sampling = capabilities.perf_logging_prefs.session_sampling_factor;
+        if (sampling > 1 && base::RandInt(1, sampling) != 1)
+          continue;
+        if (capabilities.perf_logging_prefs.spool_trace_events &&
+            !logs.back()->EnableSpooling()) {
+          LOG(WARNING) << "cannot create trace spool file; "
+                       << "performance log will buffer in memory";
+        }
         devtools_listeners.push_back(std::make_unique<PerformanceLogger>(
             logs.back().get(), session, capabilities.perf_logging_prefs,
             base::Contains(capabilities.window_types,
@@ -409,6 +726,11 @@ Status CreateLogs(
     devtools_listeners.push_back(
         std::make_unique<ConsoleLogger>(logs.back().get()));
 
+  if (capabilities.log_buffer_size > 0) {
+    for (std::unique_ptr<WebDriverLog>& log : logs)
+      log->set_max_buffered_entries(capabilities.log_buffer_size);
+  }
+
   out_logs->swap(logs);
   out_devtools_listeners->swap(devtools_listeners);
   out_command_listeners->swap(command_listeners);
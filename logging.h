@@ -10,9 +10,12 @@
 #include <vector>
 
 #include "base/containers/circular_deque.h"
+#include "base/files/file.h"
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/log.h"
+#include "chrome/test/chromedriver/session_metrics.h"
 
 struct Capabilities;
 class CommandListener;
@@ -23,6 +26,11 @@ class Status;
 
 namespace internal {
 static const size_t kMaxReturnedEntries = 100000;
+// Default cap on how many entries a log buffers between retrievals. When the
+// buffer is full the oldest entry is dropped, so a session that never fetches
+// its logs stays bounded. Overridable per session via the "bufferSize" key in
+// loggingPrefs.
+static const size_t kDefaultMaxBufferedEntries = 200000;
 }  // namespace internal
 
 // Accumulates WebDriver Logging API entries of a given type and minimum level.
@@ -47,6 +55,16 @@ class WebDriverLog : public Log {
   // creates and owns a new empty ListValue for further accumulation.
   std::unique_ptr<base::ListValue> GetAndClearEntries();
 
+  // Switches the log to spooling mode: entries are compressed and appended to
+  // a temporary file as they arrive instead of accumulating in memory, and
+  // GetAndClearEntries reads them back in bounded batches. Used for the
+  // performance log when the "spoolTraceEvents" perf logging pref is set, so
+  // a long tracing session does not hold its trace events in memory. Returns
+  // false if the spool file cannot be created; the log then stays in memory
+  // mode. GetFirstErrorMessage only sees in-memory entries, which is fine for
+  // the performance log since trace events are never error-level.
+  bool EnableSpooling();
+
   // Finds the first error message in the log and returns it. If none exist,
   // returns an empty string. Does not clear entries.
   std::string GetFirstErrorMessage() const;
@@ -63,6 +81,12 @@ class WebDriverLog : public Log {
   const std::string& type() const;
   void set_min_level(Level min_level);
   Level min_level() const;
+  void set_max_buffered_entries(size_t max_buffered_entries);
+
+  // Attributes this log's buffered-entry bytes to |memory_stats|, the owning
+  // session's gauges. May be left unset (e.g. in tests); bytes already
+  // buffered are credited when the stats block is attached.
+  void set_memory_stats(scoped_refptr<SessionMemoryStats> memory_stats);
 
  private:
   const std::string type_;  // WebDriver log type.
@@ -71,10 +95,48 @@ class WebDriverLog : public Log {
   // want GetLog to collect trace events initially).
   bool emptied_;
 
-  // A queue of batches of entries. Each batch can have no more than
-  // |kMaxReturnedEntries| values in it. This is to avoid HTTP response buffer
-  // overflow (crbug.com/681892).
-  base::circular_deque<std::unique_ptr<base::ListValue>> batches_of_entries_;
+  // Maximum number of entries buffered between retrievals; when full, the
+  // oldest entry is dropped to make room for the new one.
+  size_t max_buffered_entries_;
+
+  // A ring of buffered entries, oldest first. GetAndClearEntries returns no
+  // more than |kMaxReturnedEntries| of these per call, to avoid HTTP response
+  // buffer overflow (crbug.com/681892).
+  base::circular_deque<std::unique_ptr<base::DictionaryValue>> entries_;
+
+  // Approximate size of each element of |entries_|, kept in lockstep so a
+  // dropped or retrieved entry can be subtracted from the gauges without
+  // re-measuring it.
+  base::circular_deque<size_t> entry_bytes_;
+
+  // Sum of |entry_bytes_|, mirrored into |memory_stats_| when set.
+  size_t buffered_bytes_;
+
+  // Adds |delta| (possibly negative) to |buffered_bytes_| and to the
+  // session gauges, if attached.
+  void AdjustBufferedBytes(int64_t delta);
+
+  // Per-session gauges this log reports into; may be null.
+  scoped_refptr<SessionMemoryStats> memory_stats_;
+
+  // Compresses the pending spooled entries into one length-prefixed batch and
+  // appends it to the spool file. On failure the pending entries are kept so
+  // the next flush retries.
+  void FlushSpoolBatch();
+
+  // Reads and decompresses the next unread batch from the spool file into
+  // |entries|, one serialized entry per element. Returns false when the spool
+  // is exhausted or unreadable.
+  bool ReadNextSpoolBatch(std::vector<std::string>* entries);
+
+  // Spooling mode state; see EnableSpooling().
+  bool spooling_;
+  base::File spool_file_;
+  int64_t spool_read_offset_;
+  int64_t spool_write_offset_;
+  // Serialized entries not yet compressed into the spool file.
+  std::vector<std::string> pending_spool_entries_;
+  size_t pending_spool_bytes_;
 
   DISALLOW_COPY_AND_ASSIGN(WebDriverLog);
 };
@@ -18,6 +18,7 @@
 #include "chrome/test/chromedriver/command_listener.h"
 #include "chrome/test/chromedriver/logging.h"
 #include "chrome/test/chromedriver/session.h"
+#include "chrome/test/chromedriver/session_metrics.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace {
@@ -106,6 +107,52 @@ TEST(WebDriverLog, All) {
   ValidateLogEntry(entries.get(), 1, "DEBUG", "debug message");
 }
 
+TEST(WebDriverLog, SpoolRoundTrip) {
+  WebDriverLog log(WebDriverLog::kPerformanceType, Log::kAll);
+  ASSERT_TRUE(log.EnableSpooling());
+  log.AddEntry(Log::kInfo, "first message");
+  log.AddEntry(Log::kInfo, "second message");
+
+  std::unique_ptr<base::ListValue> entries(log.GetAndClearEntries());
+
+  ASSERT_EQ(2u, entries->GetSize());
+  ValidateLogEntry(entries.get(), 0, "INFO", "first message");
+  ValidateLogEntry(entries.get(), 1, "INFO", "second message");
+  ASSERT_FALSE(log.Emptied());
+
+  // The spool was drained; further entries still round-trip.
+  entries = log.GetAndClearEntries();
+  ASSERT_EQ(0u, entries->GetSize());
+  ASSERT_TRUE(log.Emptied());
+  log.AddEntry(Log::kInfo, "third message");
+  entries = log.GetAndClearEntries();
+  ASSERT_EQ(1u, entries->GetSize());
+  ValidateLogEntry(entries.get(), 0, "INFO", "third message");
+}
+
+TEST(WebDriverLog, MemoryStatsTrackBufferedBytes) {
+  scoped_refptr<SessionMemoryStats> stats =
+      SessionMetrics::GetInstance()->Register("log-bytes-test");
+  {
+    WebDriverLog log("type", Log::kAll);
+    log.set_memory_stats(stats);
+    log.AddEntry(Log::kInfo, "a message");
+    int64_t buffered = stats->log_bytes.load(std::memory_order_relaxed);
+    ASSERT_GT(buffered, 0);
+    log.AddEntry(Log::kInfo, "another message");
+    ASSERT_GT(stats->log_bytes.load(std::memory_order_relaxed), buffered);
+
+    log.GetAndClearEntries();
+    ASSERT_EQ(0, stats->log_bytes.load(std::memory_order_relaxed));
+
+    // Destruction of a log with unread entries releases their bytes too.
+    log.AddEntry(Log::kInfo, "unread message");
+    ASSERT_GT(stats->log_bytes.load(std::memory_order_relaxed), 0);
+  }
+  ASSERT_EQ(0, stats->log_bytes.load(std::memory_order_relaxed));
+  SessionMetrics::GetInstance()->Unregister("log-bytes-test");
+}
+
 TEST(Logging, CreatePerformanceLog) {
   Capabilities capabilities;
   Session session("test");
@@ -174,6 +221,19 @@ TEST(Logging, GetFirstErrorMessage) {
   ASSERT_EQ("first error message", entry);
 }
 
+TEST(Logging, BoundedBufferDropsOldestEntries) {
+  WebDriverLog log(WebDriverLog::kBrowserType, Log::kAll);
+  log.set_max_buffered_entries(3);
+  for (int i = 0; i < 5; i++)
+    log.AddEntry(Log::kInfo, base::StringPrintf("%d", i));
+
+  std::unique_ptr<base::ListValue> entries = log.GetAndClearEntries();
+
+  ASSERT_EQ(3u, entries->GetSize());
+  ValidateLogEntry(entries.get(), 0, "INFO", "2");
+  ValidateLogEntry(entries.get(), 2, "INFO", "4");
+}
+
 TEST(Logging, OverflowLogs) {
   WebDriverLog log(WebDriverLog::kBrowserType, Log::kAll);
   for (size_t i = 0; i < internal::kMaxReturnedEntries; i++)
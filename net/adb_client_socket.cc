@@ -5,8 +5,10 @@
 #include "chrome/test/chromedriver/net/adb_client_socket.h"
 
 #include <stddef.h>
+#include <map>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/callback_helpers.h"
@@ -28,7 +30,9 @@ namespace {
 
 const int kBufferSize = 16 * 1024;
 const int kBufferGrowthRate = 16 * 1024;
-const size_t kAdbDataChunkSize = 32 * 1024;
+// The sync protocol allows at most 64KiB per DATA chunk; use all of it so
+// large payloads take half as many header/ack round trips as 32KiB would.
+const size_t kAdbDataChunkSize = 64 * 1024;
 const char kOkayResponse[] = "OKAY";
 const char kFailResponse[] = "FAIL";
 const char kHostTransportCommand[] = "host:transport:%s";
@@ -44,6 +48,91 @@ typedef base::RepeatingCallback<void(int, const std::string&)> CommandCallback;
 typedef base::RepeatingCallback<void(int, net::StreamSocket*)> SocketCallback;
 typedef base::RepeatingCallback<void(const std::string&)> ParserCallback;
 
+std::unique_ptr<net::StreamSocket> CreateAdbServerSocket(int port) {
+  // In a IPv4/IPv6 dual stack environment, getaddrinfo for localhost could
+  // only return IPv6 address while current adb (1.0.36) will always listen
+  // on IPv4. So just try IPv4 first, then fall back to IPv6.
+  net::IPAddressList list = {net::IPAddress::IPv4Localhost(),
+                             net::IPAddress::IPv6Localhost()};
+  std::vector<std::string> aliases({"localhost"});
+  net::AddressList ip_list =
+      net::AddressList::CreateFromIPAddressList(list, std::move(aliases));
+  net::AddressList address_list =
+      net::AddressList::CopyWithPort(ip_list, port);
+
+  return std::make_unique<net::TCPClientSocket>(address_list, nullptr, nullptr,
+                                                nullptr, net::NetLogSource());
+}
+
+// The adb server dedicates every connection to a single service and closes
+// it once the response is complete - shell output is even delimited by that
+// EOF - so a finished connection can never be reused for another query. What
+// can be pooled is the connect step: a few already-connected sockets are
+// kept warm, and whenever a query takes one, a replacement is connected in
+// the background, so the back-to-back queries of Android session setup stop
+// waiting for a TCP handshake each. Everything here runs on the IO thread,
+// hence no locking.
+class WarmAdbSocketPool {
+ public:
+  static WarmAdbSocketPool* GetInstance() {
+    static WarmAdbSocketPool* instance = new WarmAdbSocketPool();
+    return instance;
+  }
+
+  // Returns a connected socket to the adb server on |port|, or null if none
+  // is warm yet. Either way, starts refilling the pool.
+  std::unique_ptr<net::StreamSocket> TakeConnectedSocket(int port) {
+    std::vector<std::unique_ptr<net::StreamSocket>>& idle = idle_sockets_[port];
+    std::unique_ptr<net::StreamSocket> socket;
+    while (!idle.empty() && !socket) {
+      socket = std::move(idle.back());
+      idle.pop_back();
+      // The server may have dropped the socket while it sat idle.
+      if (!socket->IsConnected())
+        socket.reset();
+    }
+    Replenish(port);
+    return socket;
+  }
+
+ private:
+  static const size_t kMaxIdleSocketsPerPort = 2;
+
+  WarmAdbSocketPool() = default;
+
+  void Replenish(int port) {
+    if (idle_sockets_[port].size() + pending_connects_[port] >=
+        kMaxIdleSocketsPerPort) {
+      return;
+    }
+    std::unique_ptr<net::StreamSocket> socket = CreateAdbServerSocket(port);
+    net::StreamSocket* socket_ptr = socket.get();
+    pending_connects_[port]++;
+    net::CompletionRepeatingCallback callback = base::AdaptCallbackForRepeating(
+        base::BindOnce(&WarmAdbSocketPool::OnConnected, base::Unretained(this),
+                       port, std::move(socket)));
+    int result = socket_ptr->Connect(callback);
+    if (result != net::ERR_IO_PENDING)
+      callback.Run(result);
+  }
+
+  void OnConnected(int port,
+                   std::unique_ptr<net::StreamSocket> socket,
+                   int result) {
+    pending_connects_[port]--;
+    // On failure just leave the pool short; queries fall back to connecting
+    // directly and report errors through the usual path.
+    if (result != net::OK)
+      return;
+    if (idle_sockets_[port].size() < kMaxIdleSocketsPerPort)
+      idle_sockets_[port].push_back(std::move(socket));
+    Replenish(port);
+  }
+
+  std::map<int, std::vector<std::unique_ptr<net::StreamSocket>>> idle_sockets_;
+  std::map<int, int> pending_connects_;
+};
+
 std::string EncodeMessage(const std::string& message) {
   static const char kHexChars[] = "0123456789ABCDEF";
 
@@ -325,6 +414,12 @@ class AdbQuerySocket : AdbClientSocket {
 // The first two commands use normal ADB command format implemented by
 // AdbClientSocket::SendCommand. The remaining commands use a special
 // format implemented by AdbSendFileSocket::SendPayload.
+//
+// The file content is written to the socket directly from |content_|'s
+// storage rather than being copied into a fresh buffer per chunk; only the
+// small DATA headers are materialized. A kernel sendfile/TransmitFile path
+// is not possible here: net::StreamSocket owns the descriptor, and the sync
+// protocol interleaves a header into the stream every chunk anyway.
 class AdbSendFileSocket : AdbClientSocket {
  public:
   AdbSendFileSocket(int port,
@@ -385,9 +480,46 @@ class AdbSendFileSocket : AdbClientSocket {
     size_t offset = current_offset_;
     size_t length = std::min(content_.length() - offset, kAdbDataChunkSize);
     current_offset_ += length;
-    SendPayload(kDataCommand, length, content_.c_str() + offset, length,
-                base::BindOnce(&AdbSendFileSocket::SendContent,
-                               base::Unretained(this)));
+    // Write the 8-byte DATA header on its own, then the chunk bytes straight
+    // out of |content_|.
+    SendPayload(kDataCommand, length, nullptr, 0,
+                base::BindOnce(&AdbSendFileSocket::SendContentChunk,
+                               base::Unretained(this), offset, length));
+  }
+
+  void SendContentChunk(size_t offset, size_t length, int result) {
+    if (!CheckNetResultOrDie(result))
+      return;
+    // A DrainableIOBuffer over the in-place bytes also picks up the partial
+    // writes that become likely at this chunk size.
+    scoped_refptr<net::DrainableIOBuffer> buffer =
+        base::MakeRefCounted<net::DrainableIOBuffer>(
+            base::MakeRefCounted<net::WrappedIOBuffer>(content_.c_str() +
+                                                       offset),
+            length);
+    WriteContentChunk(buffer);
+  }
+
+  void WriteContentChunk(scoped_refptr<net::DrainableIOBuffer> buffer) {
+    int result =
+        socket_->Write(buffer.get(), buffer->BytesRemaining(),
+                       base::BindOnce(&AdbSendFileSocket::OnContentChunkWritten,
+                                      base::Unretained(this), buffer),
+                       TRAFFIC_ANNOTATION_FOR_TESTS);
+    if (result != net::ERR_IO_PENDING)
+      OnContentChunkWritten(buffer, result);
+  }
+
+  void OnContentChunkWritten(scoped_refptr<net::DrainableIOBuffer> buffer,
+                             int result) {
+    if (!CheckNetResultOrDie(result))
+      return;
+    buffer->DidConsume(result);
+    if (buffer->BytesRemaining() > 0) {
+      WriteContentChunk(buffer);
+      return;
+    }
+    SendContent(net::OK);
   }
 
   void SendDone() {
@@ -496,19 +628,13 @@ AdbClientSocket::~AdbClientSocket() {
 }
 
 void AdbClientSocket::Connect(net::CompletionOnceCallback callback) {
-  // In a IPv4/IPv6 dual stack environment, getaddrinfo for localhost could
-  // only return IPv6 address while current adb (1.0.36) will always listen
-  // on IPv4. So just try IPv4 first, then fall back to IPv6.
-  net::IPAddressList list = {net::IPAddress::IPv4Localhost(),
-                             net::IPAddress::IPv6Localhost()};
-  std::vector<std::string> aliases({"localhost"});
-  net::AddressList ip_list =
-      net::AddressList::CreateFromIPAddressList(list, std::move(aliases));
-  net::AddressList address_list = net::AddressList::CopyWithPort(
-      ip_list, port_);
+  socket_ = WarmAdbSocketPool::GetInstance()->TakeConnectedSocket(port_);
+  if (socket_) {
+    std::move(callback).Run(net::OK);
+    return;
+  }
 
-  socket_ = std::make_unique<net::TCPClientSocket>(
-      address_list, nullptr, nullptr, nullptr, net::NetLogSource());
+  socket_ = CreateAdbServerSocket(port_);
 
   net::CompletionRepeatingCallback copyable_callback =
       base::AdaptCallbackForRepeating(std::move(callback));
@@ -0,0 +1,59 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/buffer_pool.h"
+
+#include <utility>
+
+namespace {
+
+// Capacity ceilings of the size classes. Most commands fall in the first
+// two classes; injected scripts and large param payloads in the upper two.
+const size_t kClassCapacities[] = {512, 4096, 32768, 262144};
+const size_t kNumClasses = 4;
+
+// Spares kept per class; beyond this, released buffers are freed.
+const size_t kBuffersPerClass = 4;
+
+// Returns the index of the smallest class whose ceiling is at least
+// |capacity|, or kNumClasses if it exceeds the largest class.
+size_t ClassForCapacity(size_t capacity) {
+  for (size_t i = 0; i < kNumClasses; ++i) {
+    if (capacity <= kClassCapacities[i])
+      return i;
+  }
+  return kNumClasses;
+}
+
+}  // namespace
+
+BufferPool::BufferPool() : classes_(kNumClasses) {}
+
+BufferPool::~BufferPool() = default;
+
+std::string BufferPool::Acquire(size_t size_hint) {
+  base::AutoLock lock(lock_);
+  // Take from the smallest class that can hold |size_hint|, or failing
+  // that from a larger one; an undersized spare would just reallocate.
+  for (size_t i = ClassForCapacity(size_hint); i < kNumClasses; ++i) {
+    std::vector<std::string>& spares = classes_[i];
+    if (spares.empty())
+      continue;
+    std::string buffer = std::move(spares.back());
+    spares.pop_back();
+    return buffer;
+  }
+  return std::string();
+}
+
+void BufferPool::Release(std::string buffer) {
+  size_t index = ClassForCapacity(buffer.capacity());
+  if (index == kNumClasses)
+    return;  // Oversized; let the allocator have it back.
+  buffer.clear();
+  base::AutoLock lock(lock_);
+  std::vector<std::string>& spares = classes_[index];
+  if (spares.size() < kBuffersPerClass)
+    spares.push_back(std::move(buffer));
+}
@@ -0,0 +1,45 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_NET_BUFFER_POOL_H_
+#define CHROME_TEST_CHROMEDRIVER_NET_BUFFER_POOL_H_
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+
+// Recycles the std::string buffers used to serialize outgoing DevTools
+// command messages. Command sizes are highly repetitive, so released
+// buffers are binned into a few capacity classes and handed back to the
+// next Acquire of a similar size, turning per-command allocator traffic
+// into a pool hit. Ref-counted because the serializing session thread
+// acquires while the transport's IO thread releases after the write.
+class BufferPool : public base::RefCountedThreadSafe<BufferPool> {
+ public:
+  BufferPool();
+
+  // Returns an empty buffer with at least |size_hint| bytes of capacity if
+  // a previously released buffer of a suitable class is available, else an
+  // ordinary empty string (the caller's reserve then allocates as before).
+  std::string Acquire(size_t size_hint);
+
+  // Returns |buffer| to its capacity class for reuse. Buffers larger than
+  // the largest class are freed rather than cached, so one screenshot-sized
+  // message does not pin megabytes for the life of the client.
+  void Release(std::string buffer);
+
+ private:
+  friend class base::RefCountedThreadSafe<BufferPool>;
+  ~BufferPool();
+
+  base::Lock lock_;
+  // One spare list per capacity class; see kClassCapacities in the .cc.
+  std::vector<std::vector<std::string>> classes_;
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_NET_BUFFER_POOL_H_
@@ -0,0 +1,66 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/buffer_pool.h"
+
+#include <string>
+
+#include "base/memory/scoped_refptr.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+TEST(BufferPool, AcquireFromEmptyPoolReturnsEmptyString) {
+  scoped_refptr<BufferPool> pool = base::MakeRefCounted<BufferPool>();
+  std::string buffer = pool->Acquire(100);
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST(BufferPool, ReleasedBufferIsReused) {
+  scoped_refptr<BufferPool> pool = base::MakeRefCounted<BufferPool>();
+  std::string buffer(1000, 'x');
+  const char* data = buffer.data();
+  size_t capacity = buffer.capacity();
+  pool->Release(std::move(buffer));
+
+  std::string reused = pool->Acquire(1000);
+  EXPECT_TRUE(reused.empty());
+  EXPECT_EQ(data, reused.data());
+  EXPECT_EQ(capacity, reused.capacity());
+}
+
+TEST(BufferPool, SmallSpareNotReturnedForLargerHint) {
+  scoped_refptr<BufferPool> pool = base::MakeRefCounted<BufferPool>();
+  std::string small(100, 'x');
+  pool->Release(std::move(small));
+
+  // A 100-byte spare lives in a smaller class than a 10000-byte request,
+  // so the request should miss rather than hand back an undersized buffer.
+  std::string buffer = pool->Acquire(10000);
+  EXPECT_LT(buffer.capacity(), 100u);
+}
+
+TEST(BufferPool, OversizedBufferIsNotCached) {
+  scoped_refptr<BufferPool> pool = base::MakeRefCounted<BufferPool>();
+  std::string huge(1 << 20, 'x');
+  pool->Release(std::move(huge));
+
+  // The megabyte buffer was freed rather than binned, so even a request
+  // for the largest class misses.
+  std::string buffer = pool->Acquire(200000);
+  EXPECT_LT(buffer.capacity(), 200000u);
+}
+
+TEST(BufferPool, SparesPerClassAreBounded) {
+  scoped_refptr<BufferPool> pool = base::MakeRefCounted<BufferPool>();
+  for (int i = 0; i < 10; ++i) {
+    std::string buffer(1000, 'x');
+    pool->Release(std::move(buffer));
+  }
+  int hits = 0;
+  for (int i = 0; i < 10; ++i) {
+    if (pool->Acquire(1000).capacity() >= 1000)
+      ++hits;
+  }
+  // Only kBuffersPerClass spares are kept; the rest were freed on Release.
+  EXPECT_EQ(4, hits);
+}
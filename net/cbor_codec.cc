@@ -0,0 +1,193 @@
+// Copyright (c) 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/cbor_codec.h"
+
+#include <utility>
+#include <vector>
+
+#include "base/base64.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/values.h"
+#include "third_party/inspector_protocol/crdtp/cbor.h"
+#include "third_party/inspector_protocol/crdtp/json.h"
+#include "third_party/inspector_protocol/crdtp/parser_handler.h"
+#include "third_party/inspector_protocol/crdtp/span.h"
+#include "third_party/inspector_protocol/crdtp/status.h"
+
+namespace cbor_codec {
+namespace {
+
+// Streaming handler that builds the base::Value tree directly as the CBOR
+// tokenizer walks the envelope, so a decoded message never exists as JSON
+// text in between.
+class ValueBuilder : public crdtp::ParserHandler {
+ public:
+  ValueBuilder() = default;
+  ~ValueBuilder() override = default;
+
+  // Returns the parsed tree, or null if parsing failed or never produced a
+  // single complete top-level value.
+  std::unique_ptr<base::Value> TakeResult() {
+    if (error_ || !stack_.empty())
+      return nullptr;
+    return std::move(result_);
+  }
+
+  void HandleMapBegin() override {
+    PushContainer(base::Value(base::Value::Type::DICTIONARY));
+  }
+
+  void HandleMapEnd() override { PopContainer(); }
+
+  void HandleArrayBegin() override {
+    PushContainer(base::Value(base::Value::Type::LIST));
+  }
+
+  void HandleArrayEnd() override { PopContainer(); }
+
+  void HandleString8(crdtp::span<uint8_t> chars) override {
+    HandleString(std::string(reinterpret_cast<const char*>(chars.data()),
+                             chars.size()));
+  }
+
+  void HandleString16(crdtp::span<uint16_t> chars) override {
+    HandleString(base::UTF16ToUTF8(base::StringPiece16(
+        reinterpret_cast<const base::char16*>(chars.data()), chars.size())));
+  }
+
+  void HandleBinary(crdtp::span<uint8_t> bytes) override {
+    // The JSON protocol mode delivers binary fields (screenshots, PDF data)
+    // as base64 strings; do the same here so consumers never need to know
+    // which mode was on the wire.
+    std::string encoded;
+    base::Base64Encode(
+        base::StringPiece(reinterpret_cast<const char*>(bytes.data()),
+                          bytes.size()),
+        &encoded);
+    AddValue(base::Value(std::move(encoded)));
+  }
+
+  void HandleDouble(double value) override { AddValue(base::Value(value)); }
+
+  void HandleInt32(int32_t value) override { AddValue(base::Value(value)); }
+
+  void HandleBool(bool value) override { AddValue(base::Value(value)); }
+
+  void HandleNull() override { AddValue(base::Value()); }
+
+  void HandleError(crdtp::Status error) override { error_ = true; }
+
+ private:
+  // A container being filled, and the key it will be stored under in its
+  // parent when that parent is a dictionary.
+  struct Frame {
+    base::Value value;
+    std::string key;
+  };
+
+  bool InDictNeedingKey() const {
+    return !stack_.empty() && stack_.back().value.is_dict() &&
+           !has_pending_key_;
+  }
+
+  void HandleString(std::string str) {
+    if (InDictNeedingKey()) {
+      pending_key_ = std::move(str);
+      has_pending_key_ = true;
+      return;
+    }
+    AddValue(base::Value(std::move(str)));
+  }
+
+  void PushContainer(base::Value container) {
+    Frame frame;
+    frame.value = std::move(container);
+    if (!stack_.empty() && stack_.back().value.is_dict()) {
+      if (!has_pending_key_) {
+        error_ = true;
+        return;
+      }
+      frame.key = std::move(pending_key_);
+      has_pending_key_ = false;
+    }
+    stack_.push_back(std::move(frame));
+  }
+
+  void PopContainer() {
+    if (stack_.empty()) {
+      error_ = true;
+      return;
+    }
+    Frame frame = std::move(stack_.back());
+    stack_.pop_back();
+    Attach(std::move(frame.value), std::move(frame.key));
+  }
+
+  void AddValue(base::Value value) {
+    if (!stack_.empty() && stack_.back().value.is_dict()) {
+      if (!has_pending_key_) {
+        error_ = true;
+        return;
+      }
+      has_pending_key_ = false;
+      Attach(std::move(value), std::move(pending_key_));
+      return;
+    }
+    Attach(std::move(value), std::string());
+  }
+
+  void Attach(base::Value value, std::string key) {
+    if (stack_.empty()) {
+      if (result_) {
+        // More than one top-level value is not a valid message.
+        error_ = true;
+        return;
+      }
+      result_ = std::make_unique<base::Value>(std::move(value));
+      return;
+    }
+    base::Value* parent = &stack_.back().value;
+    if (parent->is_dict())
+      parent->SetKey(std::move(key), std::move(value));
+    else
+      parent->Append(std::move(value));
+  }
+
+  std::vector<Frame> stack_;
+  std::string pending_key_;
+  bool has_pending_key_ = false;
+  std::unique_ptr<base::Value> result_;
+  bool error_ = false;
+};
+
+}  // namespace
+
+bool IsCBORMessage(const std::string& message) {
+  return crdtp::cbor::IsCBORMessage(crdtp::SpanFrom(message));
+}
+
+bool ParseCBORToValue(const std::string& message,
+                      std::unique_ptr<base::Value>* value) {
+  ValueBuilder builder;
+  crdtp::cbor::ParseCBOR(crdtp::SpanFrom(message), &builder);
+  std::unique_ptr<base::Value> result = builder.TakeResult();
+  if (!result)
+    return false;
+  *value = std::move(result);
+  return true;
+}
+
+bool EncodeJSONToCBOR(const std::string& json, std::string* cbor) {
+  std::vector<uint8_t> bytes;
+  crdtp::Status status =
+      crdtp::json::ConvertJSONToCBOR(crdtp::SpanFrom(json), &bytes);
+  if (!status.ok())
+    return false;
+  cbor->assign(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  return true;
+}
+
+}  // namespace cbor_codec
@@ -0,0 +1,37 @@
+// Copyright (c) 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_NET_CBOR_CODEC_H_
+#define CHROME_TEST_CHROMEDRIVER_NET_CBOR_CODEC_H_
+
+#include <memory>
+#include <string>
+
+namespace base {
+class Value;
+}
+
+// Codec for the DevTools binary (CBOR) protocol mode, which Chrome speaks on
+// the --remote-debugging-pipe=cbor transport. Messages in this mode are
+// self-delimiting envelopes instead of JSON text, so big payloads skip JSON
+// tokenization entirely.
+namespace cbor_codec {
+
+// True if |message| starts with a DevTools CBOR envelope.
+bool IsCBORMessage(const std::string& message);
+
+// Parses a DevTools CBOR message straight into a base::Value tree, without
+// going through JSON text. Binary fields are delivered base64-encoded in
+// strings, matching what the JSON protocol mode produces, so consumers need
+// not care which mode was on the wire. Returns false on malformed input.
+bool ParseCBORToValue(const std::string& message,
+                      std::unique_ptr<base::Value>* value);
+
+// Encodes a JSON message into a CBOR envelope, for sending commands to an
+// endpoint operating in binary mode. Returns false if |json| is malformed.
+bool EncodeJSONToCBOR(const std::string& json, std::string* cbor);
+
+}  // namespace cbor_codec
+
+#endif  // CHROME_TEST_CHROMEDRIVER_NET_CBOR_CODEC_H_
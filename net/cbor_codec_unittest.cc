@@ -0,0 +1,60 @@
+// Copyright (c) 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/cbor_codec.h"
+
+#include <memory>
+#include <string>
+
+#include "base/json/json_reader.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// Encodes |json| to CBOR and decodes it back, expecting the same tree that
+// parsing |json| as JSON produces.
+void ExpectRoundTrip(const std::string& json) {
+  std::string cbor;
+  ASSERT_TRUE(cbor_codec::EncodeJSONToCBOR(json, &cbor));
+  ASSERT_TRUE(cbor_codec::IsCBORMessage(cbor));
+  std::unique_ptr<base::Value> decoded;
+  ASSERT_TRUE(cbor_codec::ParseCBORToValue(cbor, &decoded));
+  std::unique_ptr<base::Value> expected = base::JSONReader::ReadDeprecated(json);
+  ASSERT_TRUE(expected);
+  EXPECT_EQ(*expected, *decoded);
+}
+
+}  // namespace
+
+TEST(CborCodecTest, RoundTripsCommandResponse) {
+  ExpectRoundTrip(
+      "{\"id\":5,\"result\":{\"frameId\":\"A1\",\"loaderId\":null,"
+      "\"ok\":true}}");
+}
+
+TEST(CborCodecTest, RoundTripsEventWithNestedParams) {
+  ExpectRoundTrip(
+      "{\"method\":\"Network.responseReceived\",\"params\":{\"response\":"
+      "{\"status\":200,\"timing\":{\"requestTime\":1.25},\"headers\":"
+      "{\"Content-Length\":\"42\"}},\"ids\":[1,2,3]}}");
+}
+
+TEST(CborCodecTest, JSONTextIsNotCBOR) {
+  EXPECT_FALSE(cbor_codec::IsCBORMessage("{\"id\":1,\"result\":{}}"));
+  EXPECT_FALSE(cbor_codec::IsCBORMessage(std::string()));
+}
+
+TEST(CborCodecTest, RejectsTruncatedEnvelope) {
+  std::string cbor;
+  ASSERT_TRUE(cbor_codec::EncodeJSONToCBOR("{\"id\":1,\"result\":{}}", &cbor));
+  std::unique_ptr<base::Value> decoded;
+  EXPECT_FALSE(
+      cbor_codec::ParseCBORToValue(cbor.substr(0, cbor.size() - 2), &decoded));
+}
+
+TEST(CborCodecTest, RejectsMalformedJSONOnEncode) {
+  std::string cbor;
+  EXPECT_FALSE(cbor_codec::EncodeJSONToCBOR("{\"id\":", &cbor));
+}
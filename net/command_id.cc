@@ -4,6 +4,15 @@
 
 #include "chrome/test/chromedriver/net/command_id.h"
 
+namespace {
+
+// Next shard to hand to a new allocator. Shards recycle after kMaxShards
+// allocators; by then the earlier holders' in-flight windows are long
+// drained.
+std::atomic<int> g_next_shard{0};
+
+}  // namespace
+
 bool CommandId::IsChromeDriverCommandId(int command_id) {
   return command_id > 0;
 }
@@ -11,3 +20,38 @@ bool CommandId::IsChromeDriverCommandId(int command_id) {
 bool CommandId::IsClientCommandId(int command_id) {
   return command_id < 0;
 }
+
+int CommandId::ShardOf(int command_id) {
+  return command_id >> kSequenceBits;
+}
+
+CommandIdAllocator::CommandIdAllocator()
+    : shard_base_((g_next_shard.fetch_add(1, std::memory_order_relaxed) %
+                   CommandId::kMaxShards)
+                  << CommandId::kSequenceBits) {}
+
+int CommandIdAllocator::Next() {
+  // Sequence 0 is reserved: in shard 0 it would yield command id 0, which
+  // IsChromeDriverCommandId and IsClientCommandId both reject, so the
+  // response would never be routed back. Skip it when the sequence wraps.
+  int seq;
+  do {
+    seq = next_seq_.fetch_add(1, std::memory_order_relaxed) &
+          CommandId::kSequenceMask;
+  } while (seq == 0);
+  return shard_base_ + seq;
+}
+
+int CommandIdAllocator::LastIssued() const {
+  return shard_base_ + ((next_seq_.load(std::memory_order_relaxed) - 1) &
+                        CommandId::kSequenceMask);
+}
+
+int CommandIdAllocator::shard() const {
+  return shard_base_ >> CommandId::kSequenceBits;
+}
+
+// static
+void CommandIdAllocator::ResetNextShardForTesting() {
+  g_next_shard.store(0, std::memory_order_relaxed);
+}
@@ -5,6 +5,8 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_NET_COMMAND_ID_H_
 #define CHROME_TEST_CHROMEDRIVER_NET_COMMAND_ID_H_
 
+#include <atomic>
+
 // ChromeDriver and Clients must use command ids to keep track of the commands
 // being sent to DevTools. This static class contains logic for determining
 // whether or not a command originated the client or chromedriver. This class
@@ -14,11 +16,50 @@
 
 class CommandId {
  public:
+  // Layout of a positive (ChromeDriver-originated) command id: the bits
+  // above kSequenceBits carry the allocating client's shard, the low
+  // kSequenceBits a per-client monotonic sequence. Client-originated ids
+  // are negative and carry no shard.
+  static constexpr int kSequenceBits = 20;
+  static constexpr int kSequenceMask = (1 << kSequenceBits) - 1;
+  static constexpr int kMaxShards = 1 << 10;
+
   // ChromeDriverCommandIds must be positive
   static bool IsChromeDriverCommandId(int command_id);
 
   // ClientCommandIds must be negative
   static bool IsClientCommandId(int command_id);
+
+  // Returns the shard encoded in a ChromeDriver command id.
+  static int ShardOf(int command_id);
+};
+
+// Hands out DevTools command ids for one client. Each allocator owns a
+// shard of the positive id space, so concurrent allocators never contend
+// or collide with each other; allocation is a single lock-free fetch_add.
+class CommandIdAllocator {
+ public:
+  CommandIdAllocator();
+
+  // Returns the next id, monotonic within this allocator. The sequence
+  // wraps after 2^20 ids, far beyond any plausible in-flight window;
+  // sequence 0 is reserved so every issued id stays nonzero in its shard.
+  int Next();
+
+  // Returns the most recently issued id, or the shard base if none has
+  // been issued yet.
+  int LastIssued() const;
+
+  // Returns this allocator's shard, for matching against ShardOf().
+  int shard() const;
+
+  // Rewinds shard assignment so the next allocator constructed gets shard
+  // 0 and issues ids starting at 1, as tests with canned responses expect.
+  static void ResetNextShardForTesting();
+
+ private:
+  const int shard_base_;
+  std::atomic<int> next_seq_{1};
 };
 
 #endif  // CHROME_TEST_CHROMEDRIVER_NET_COMMAND_ID_H_
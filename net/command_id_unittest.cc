@@ -0,0 +1,50 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/command_id.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+TEST(CommandIdAllocatorTest, FirstAllocatorStartsAtOne) {
+  CommandIdAllocator::ResetNextShardForTesting();
+  CommandIdAllocator allocator;
+  EXPECT_EQ(0, allocator.shard());
+  EXPECT_EQ(1, allocator.Next());
+  EXPECT_EQ(2, allocator.Next());
+  EXPECT_EQ(3, allocator.Next());
+  EXPECT_EQ(3, allocator.LastIssued());
+}
+
+TEST(CommandIdAllocatorTest, AllocatorsOwnDistinctShards) {
+  CommandIdAllocator::ResetNextShardForTesting();
+  CommandIdAllocator first;
+  CommandIdAllocator second;
+  EXPECT_NE(first.shard(), second.shard());
+  int first_id = first.Next();
+  int second_id = second.Next();
+  EXPECT_NE(first_id, second_id);
+  EXPECT_EQ(first.shard(), CommandId::ShardOf(first_id));
+  EXPECT_EQ(second.shard(), CommandId::ShardOf(second_id));
+}
+
+TEST(CommandIdAllocatorTest, WrapSkipsReservedZeroSequence) {
+  CommandIdAllocator::ResetNextShardForTesting();
+  CommandIdAllocator allocator;  // Shard 0, so id == sequence.
+  int last = 0;
+  for (int i = 0; i < CommandId::kSequenceMask + 2; ++i) {
+    last = allocator.Next();
+    ASSERT_TRUE(CommandId::IsChromeDriverCommandId(last));
+  }
+  // The sequence wrapped, skipped the reserved 0 and resumed counting.
+  EXPECT_EQ(2, last);
+  EXPECT_EQ(2, allocator.LastIssued());
+}
+
+TEST(CommandIdAllocatorTest, IdsStayPositive) {
+  CommandIdAllocator::ResetNextShardForTesting();
+  CommandIdAllocator allocator;
+  int id = allocator.Next();
+  EXPECT_TRUE(CommandId::IsChromeDriverCommandId(id));
+  EXPECT_FALSE(CommandId::IsClientCommandId(id));
+}
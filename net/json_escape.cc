@@ -0,0 +1,157 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/json_escape.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <cmath>
+
+#include "base/json/string_escape.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/values.h"
+
+namespace {
+
+constexpr uint64_t kOnes = 0x0101010101010101ULL;
+constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+
+// Returns a word with the high bit set in each lane whose byte is zero.
+// Standard SWAR zero-lane detection; valid for all inputs.
+constexpr uint64_t ZeroLanes(uint64_t v) {
+  return (v - kOnes) & ~v & kHighBits;
+}
+
+// Returns a word with the high bit set in each lane whose byte is below
+// 0x20. Only reliable for lanes without the high bit set, which is fine
+// here: high-bit lanes are flagged separately.
+constexpr uint64_t BelowSpaceLanes(uint64_t v) {
+  return (v - kOnes * 0x20) & ~v & kHighBits;
+}
+
+// Whether |c| may not be copied into JSON output verbatim. Mirrors
+// base::EscapeJSONString: control characters, '"', '\\' and '<' need
+// escaping, and anything with the high bit set needs UTF-8-aware handling
+// (U+2028 and U+2029 are escaped, invalid sequences replaced).
+inline bool NeedsEscape(uint8_t c) {
+  return c < 0x20 || c >= 0x80 || c == '"' || c == '\\' || c == '<';
+}
+
+// Returns the number of leading bytes of [begin, end) that can be copied
+// verbatim, scanning eight bytes per step until a byte needing escape is
+// near.
+size_t CleanRunLength(const char* begin, const char* end) {
+  const char* p = begin;
+  while (end - p >= 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    uint64_t flagged = (word & kHighBits) | BelowSpaceLanes(word) |
+                       ZeroLanes(word ^ (kOnes * '"')) |
+                       ZeroLanes(word ^ (kOnes * '\\')) |
+                       ZeroLanes(word ^ (kOnes * '<'));
+    if (flagged)
+      break;
+    p += 8;
+  }
+  while (p < end && !NeedsEscape(static_cast<uint8_t>(*p)))
+    ++p;
+  return static_cast<size_t>(p - begin);
+}
+
+}  // namespace
+
+void EscapeJSONStringFast(base::StringPiece str,
+                          bool put_in_quotes,
+                          std::string* out) {
+  if (put_in_quotes)
+    out->push_back('"');
+  const char* p = str.data();
+  const char* end = p + str.size();
+  while (p < end) {
+    size_t clean = CleanRunLength(p, end);
+    out->append(p, clean);
+    p += clean;
+    if (p == end)
+      break;
+    // Hand the escape-needing byte, plus any UTF-8 continuation bytes that
+    // follow it, to the reference implementation so the output stays
+    // byte-identical, including its treatment of invalid sequences.
+    const char* stop = p + 1;
+    if (static_cast<uint8_t>(*p) >= 0x80) {
+      while (stop < end && (static_cast<uint8_t>(*stop) & 0xC0) == 0x80)
+        ++stop;
+    }
+    base::EscapeJSONString(base::StringPiece(p, stop - p),
+                           false /* put_in_quotes */, out);
+    p = stop;
+  }
+  if (put_in_quotes)
+    out->push_back('"');
+}
+
+bool SerializeValueFast(const base::Value& value, std::string* out) {
+  switch (value.type()) {
+    case base::Value::Type::NONE:
+      out->append("null");
+      return true;
+    case base::Value::Type::BOOLEAN:
+      out->append(value.GetBool() ? "true" : "false");
+      return true;
+    case base::Value::Type::INTEGER:
+      out->append(base::NumberToString(value.GetInt()));
+      return true;
+    case base::Value::Type::DOUBLE: {
+      double number = value.GetDouble();
+      if (!std::isfinite(number))
+        return false;
+      std::string real = base::NumberToString(number);
+      // Match base::JSONWriter::Write: a whole number gets a trailing ".0"
+      // so it reads back as a double, and values in (-1, 1) get a zero
+      // before the decimal point.
+      if (real.find_first_of(".eE") == std::string::npos)
+        real.append(".0");
+      if (real[0] == '.')
+        real.insert(0, 1, '0');
+      else if (real.length() > 1 && real[0] == '-' && real[1] == '.')
+        real.insert(1, 1, '0');
+      out->append(real);
+      return true;
+    }
+    case base::Value::Type::STRING:
+      EscapeJSONStringFast(value.GetString(), true /* put_in_quotes */, out);
+      return true;
+    case base::Value::Type::LIST: {
+      out->push_back('[');
+      bool first = true;
+      for (const base::Value& entry : value.GetList()) {
+        if (!first)
+          out->push_back(',');
+        first = false;
+        if (!SerializeValueFast(entry, out))
+          return false;
+      }
+      out->push_back(']');
+      return true;
+    }
+    case base::Value::Type::DICTIONARY: {
+      out->push_back('{');
+      bool first = true;
+      for (const auto& entry : value.DictItems()) {
+        if (!first)
+          out->push_back(',');
+        first = false;
+        EscapeJSONStringFast(entry.first, true /* put_in_quotes */, out);
+        out->push_back(':');
+        if (!SerializeValueFast(entry.second, out))
+          return false;
+      }
+      out->push_back('}');
+      return true;
+    }
+    default:
+      // Binary values (and any future types) take the slow path.
+      return false;
+  }
+}
@@ -0,0 +1,37 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_NET_JSON_ESCAPE_H_
+#define CHROME_TEST_CHROMEDRIVER_NET_JSON_ESCAPE_H_
+
+#include <string>
+
+#include "base/strings/string_piece.h"
+
+namespace base {
+class Value;
+}
+
+// Fast JSON rendering for the driver's serialization hot paths: response
+// bodies carrying screenshots or page source, and outgoing DevTools command
+// messages. base::JSONWriter escapes strings a character at a time, which
+// dominates serialization for multi-MB mostly-ASCII payloads; the functions
+// here scan for bytes that need escaping a machine word at a time and
+// bulk-append the clean runs in between, so such payloads are copied at
+// near-memcpy speed. Output is byte-identical to base::JSONWriter's.
+
+// Appends |str| to |out| as JSON, escaping exactly as base::EscapeJSONString
+// does (including '<' and U+2028/U+2029), surrounded by double quotes if
+// |put_in_quotes| is true.
+void EscapeJSONStringFast(base::StringPiece str,
+                          bool put_in_quotes,
+                          std::string* out);
+
+// Appends |value| to |out| as JSON, rendering strings through
+// EscapeJSONStringFast. Returns false for trees the fast path does not
+// cover (binary values, non-finite doubles), in which case |out| may hold
+// partial output and the caller should fall back to base::JSONWriter.
+bool SerializeValueFast(const base::Value& value, std::string* out);
+
+#endif  // CHROME_TEST_CHROMEDRIVER_NET_JSON_ESCAPE_H_
@@ -0,0 +1,99 @@
+// Copyright (c) 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/json_escape.h"
+
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "base/json/json_writer.h"
+#include "base/json/string_escape.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// Escapes |str| with the fast scanner and expects output byte-identical to
+// base::EscapeJSONString's.
+void ExpectEscapeMatchesReference(const std::string& str) {
+  std::string expected;
+  base::EscapeJSONString(str, true /* put_in_quotes */, &expected);
+  std::string actual;
+  EscapeJSONStringFast(str, true /* put_in_quotes */, &actual);
+  EXPECT_EQ(expected, actual) << "input: " << str;
+}
+
+// Serializes |value| with the fast writer and expects output byte-identical
+// to base::JSONWriter's.
+void ExpectSerializeMatchesReference(const base::Value& value) {
+  std::string expected;
+  ASSERT_TRUE(base::JSONWriter::Write(value, &expected));
+  std::string actual;
+  ASSERT_TRUE(SerializeValueFast(value, &actual));
+  EXPECT_EQ(expected, actual);
+}
+
+}  // namespace
+
+TEST(EscapeJSONStringFast, MatchesReference) {
+  ExpectEscapeMatchesReference("");
+  ExpectEscapeMatchesReference("plain ascii text");
+  ExpectEscapeMatchesReference("quote \" backslash \\ tag <b>");
+  ExpectEscapeMatchesReference("control\x01\n\r\t\b\f chars");
+  ExpectEscapeMatchesReference("non-ascii \xc3\xa9\xe6\x97\xa5\xf0\x9f\x98\x80");
+  // U+2028 and U+2029 must be escaped for HTML safety.
+  ExpectEscapeMatchesReference("line\xe2\x80\xa8sep\xe2\x80\xa9");
+  // Invalid UTF-8: stray continuation byte, truncated sequence at the end.
+  ExpectEscapeMatchesReference("broken \x80 bytes \xe2\x80");
+  // Escapes at every offset within a word, so the SWAR lane math is hit for
+  // each position.
+  for (int i = 0; i < 16; ++i) {
+    std::string str(i, 'a');
+    str += '"';
+    str += std::string(16 - i, 'b');
+    ExpectEscapeMatchesReference(str);
+  }
+}
+
+TEST(EscapeJSONStringFast, LongMostlyCleanPayload) {
+  // Base64-like payload well past the word-at-a-time loop, with sparse
+  // escapes to split it into runs.
+  std::string str;
+  for (int i = 0; i < 10000; ++i)
+    str += "QUJDREVGR0hJSktMTU5PUA==";
+  str.insert(str.size() / 2, "\"\\<\n\xe2\x80\xa8");
+  ExpectEscapeMatchesReference(str);
+}
+
+TEST(SerializeValueFast, MatchesReference) {
+  base::DictionaryValue dict;
+  dict.SetString("string", "va\"lue");
+  dict.SetInteger("int", -42);
+  dict.SetBoolean("bool", true);
+  dict.SetKey("null", base::Value());
+  dict.SetDouble("whole", 2.0);
+  dict.SetDouble("fraction", 0.25);
+  dict.SetDouble("negative_fraction", -0.5);
+  auto list = std::make_unique<base::ListValue>();
+  list->AppendString("nested");
+  list->AppendInteger(7);
+  dict.SetList("list", std::move(list));
+  ExpectSerializeMatchesReference(dict);
+  ExpectSerializeMatchesReference(base::Value());
+  ExpectSerializeMatchesReference(base::Value(base::Value::Type::LIST));
+  ExpectSerializeMatchesReference(
+      base::Value(base::Value::Type::DICTIONARY));
+}
+
+TEST(SerializeValueFast, RejectsUncoveredTypes) {
+  std::string out;
+  base::Value binary(base::Value::BlobStorage{1, 2, 3});
+  EXPECT_FALSE(SerializeValueFast(binary, &out));
+
+  base::DictionaryValue dict;
+  dict.SetDouble("inf", std::numeric_limits<double>::infinity());
+  out.clear();
+  EXPECT_FALSE(SerializeValueFast(dict, &out));
+}
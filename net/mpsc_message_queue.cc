@@ -0,0 +1,128 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/mpsc_message_queue.h"
+
+#include <utility>
+
+namespace {
+
+// Process-wide gauges over all live queues; see TotalQueuedMessages().
+std::atomic<int64_t> g_queued_messages{0};
+std::atomic<int64_t> g_queued_bytes{0};
+
+}  // namespace
+
+MpscMessageQueue::Node::Node(std::string message)
+    : next(nullptr), message(std::move(message)) {}
+
+MpscMessageQueue::MpscMessageQueue()
+    : on_push_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                     base::WaitableEvent::InitialState::NOT_SIGNALED) {
+  // Start with a consumed stub node so that push and pop never contend.
+  Node* stub = new Node(std::string());
+  tail_.store(stub, std::memory_order_relaxed);
+  head_ = stub;
+}
+
+MpscMessageQueue::~MpscMessageQueue() {
+  // The first node is the consumed stub; everything after it is a message
+  // that was never popped and must leave the process-wide gauges.
+  Node* node = head_->next.load(std::memory_order_relaxed);
+  delete head_;
+  while (node) {
+    Node* next = node->next.load(std::memory_order_relaxed);
+    g_queued_messages.fetch_sub(1, std::memory_order_relaxed);
+    g_queued_bytes.fetch_sub(node->message.size(), std::memory_order_relaxed);
+    delete node;
+    node = next;
+  }
+}
+
+void MpscMessageQueue::Push(std::string message) {
+  queued_messages_.fetch_add(1, std::memory_order_relaxed);
+  queued_bytes_.fetch_add(message.size(), std::memory_order_relaxed);
+  g_queued_messages.fetch_add(1, std::memory_order_relaxed);
+  g_queued_bytes.fetch_add(message.size(), std::memory_order_relaxed);
+  Node* node = new Node(std::move(message));
+  // Serialize producers on the tail; the consumer never reads |tail_|.
+  Node* prev = tail_.exchange(node, std::memory_order_acq_rel);
+  // Publish the node. Between the exchange and this store the node is
+  // invisible to the consumer, which simply sees an empty queue.
+  prev->next.store(node, std::memory_order_release);
+  on_push_event_.Signal();
+}
+
+bool MpscMessageQueue::Pop(std::string* message) {
+  Node* next = head_->next.load(std::memory_order_acquire);
+  if (!next)
+    return false;
+  *message = std::move(next->message);
+  queued_messages_.fetch_sub(1, std::memory_order_relaxed);
+  queued_bytes_.fetch_sub(message->size(), std::memory_order_relaxed);
+  g_queued_messages.fetch_sub(1, std::memory_order_relaxed);
+  g_queued_bytes.fetch_sub(message->size(), std::memory_order_relaxed);
+  // |next| becomes the new stub; the old stub is no longer referenced by
+  // any producer since they only append after |tail_|.
+  delete head_;
+  head_ = next;
+  return true;
+}
+
+size_t MpscMessageQueue::PopAll(std::vector<std::string>* messages) {
+  size_t popped = 0;
+  int64_t bytes = 0;
+  Node* next = head_->next.load(std::memory_order_acquire);
+  while (next) {
+    messages->push_back(std::move(next->message));
+    bytes += messages->back().size();
+    popped++;
+    delete head_;
+    head_ = next;
+    next = head_->next.load(std::memory_order_acquire);
+  }
+  if (popped > 0) {
+    int64_t count = static_cast<int64_t>(popped);
+    queued_messages_.fetch_sub(count, std::memory_order_relaxed);
+    queued_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    g_queued_messages.fetch_sub(count, std::memory_order_relaxed);
+    g_queued_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+  return popped;
+}
+
+bool MpscMessageQueue::IsEmpty() {
+  return head_->next.load(std::memory_order_acquire) == nullptr;
+}
+
+void MpscMessageQueue::Clear() {
+  std::string ignored;
+  while (Pop(&ignored)) {}
+}
+
+void MpscMessageQueue::WaitForMessage(base::TimeDelta wait) {
+  on_push_event_.TimedWait(wait);
+}
+
+void MpscMessageQueue::Signal() {
+  on_push_event_.Signal();
+}
+
+int64_t MpscMessageQueue::QueuedMessages() const {
+  return queued_messages_.load(std::memory_order_relaxed);
+}
+
+int64_t MpscMessageQueue::QueuedBytes() const {
+  return queued_bytes_.load(std::memory_order_relaxed);
+}
+
+// static
+int64_t MpscMessageQueue::TotalQueuedMessages() {
+  return g_queued_messages.load(std::memory_order_relaxed);
+}
+
+// static
+int64_t MpscMessageQueue::TotalQueuedBytes() {
+  return g_queued_bytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,91 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_NET_MPSC_MESSAGE_QUEUE_H_
+#define CHROME_TEST_CHROMEDRIVER_NET_MPSC_MESSAGE_QUEUE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "base/synchronization/waitable_event.h"
+
+// An unbounded lock-free multi-producer single-consumer message queue,
+// based on Vyukov's intrusive MPSC queue. Any thread may call Push; Pop,
+// IsEmpty and Clear must only be called from a single consumer thread.
+// WaitForMessage lets the consumer block until a producer pushes, without
+// taking a lock on the push side.
+class MpscMessageQueue {
+ public:
+  MpscMessageQueue();
+  MpscMessageQueue(const MpscMessageQueue&) = delete;
+  MpscMessageQueue& operator=(const MpscMessageQueue&) = delete;
+  ~MpscMessageQueue();
+
+  // Appends |message| to the queue and wakes a consumer blocked in
+  // WaitForMessage. Callable from any thread.
+  void Push(std::string message);
+
+  // Removes the oldest message into |message|. Returns false if the queue
+  // is empty. Consumer thread only.
+  bool Pop(std::string* message);
+
+  // Removes every queued message into |messages|, oldest first, updating
+  // the byte and message gauges once for the whole batch instead of per
+  // message. Returns the number of messages moved. Consumer thread only.
+  size_t PopAll(std::vector<std::string>* messages);
+
+  // Returns true if no message is queued. Consumer thread only.
+  bool IsEmpty();
+
+  // Discards all queued messages. Consumer thread only, and must not race
+  // with WaitForMessage.
+  void Clear();
+
+  // Blocks until a producer pushes, Signal is called, or |wait| elapses.
+  // Spurious wakeups are possible; callers must re-check the queue.
+  // Consumer thread only.
+  void WaitForMessage(base::TimeDelta wait);
+
+  // Wakes a consumer blocked in WaitForMessage even though no message was
+  // pushed, e.g. on disconnect. Callable from any thread.
+  void Signal();
+
+  // Messages currently queued here and the bytes they hold. Maintained with
+  // relaxed atomics, so any thread may read them; producers use the byte
+  // gauge to apply backpressure before pushing.
+  int64_t QueuedMessages() const;
+  int64_t QueuedBytes() const;
+
+  // Process-wide totals across all live queues: messages currently queued
+  // and the bytes they hold. Maintained with relaxed atomics on the push
+  // and pop paths and read by the /status endpoint, so inbound WebSocket
+  // backlog is visible without instrumenting each consumer.
+  static int64_t TotalQueuedMessages();
+  static int64_t TotalQueuedBytes();
+
+ private:
+  struct Node {
+    explicit Node(std::string message);
+
+    std::atomic<Node*> next;
+    std::string message;
+  };
+
+  // Producers append at |tail_|; the consumer removes at |head_|. |head_|
+  // always points at a consumed stub node whose |next| is the real front of
+  // the queue, so producers and the consumer never touch the same node.
+  std::atomic<Node*> tail_;
+  Node* head_;
+
+  // This queue's share of the process-wide gauges; see QueuedMessages().
+  std::atomic<int64_t> queued_messages_{0};
+  std::atomic<int64_t> queued_bytes_{0};
+
+  base::WaitableEvent on_push_event_;
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_NET_MPSC_MESSAGE_QUEUE_H_
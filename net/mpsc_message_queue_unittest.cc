@@ -0,0 +1,132 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/mpsc_message_queue.h"
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+void PushMessages(MpscMessageQueue* queue, int start, int count) {
+  for (int i = 0; i < count; i++)
+    queue->Push(base::NumberToString(start + i));
+}
+
+}  // namespace
+
+TEST(MpscMessageQueueTest, PopOnEmptyReturnsFalse) {
+  MpscMessageQueue queue;
+  std::string message;
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_FALSE(queue.Pop(&message));
+}
+
+TEST(MpscMessageQueueTest, PreservesFifoOrder) {
+  MpscMessageQueue queue;
+  queue.Push("1");
+  queue.Push("2");
+  queue.Push("3");
+  EXPECT_FALSE(queue.IsEmpty());
+
+  std::string message;
+  ASSERT_TRUE(queue.Pop(&message));
+  EXPECT_EQ("1", message);
+  ASSERT_TRUE(queue.Pop(&message));
+  EXPECT_EQ("2", message);
+  ASSERT_TRUE(queue.Pop(&message));
+  EXPECT_EQ("3", message);
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(MpscMessageQueueTest, PopAllDrainsInOrder) {
+  MpscMessageQueue queue;
+  std::vector<std::string> messages;
+  EXPECT_EQ(0u, queue.PopAll(&messages));
+  EXPECT_TRUE(messages.empty());
+
+  queue.Push("1");
+  queue.Push("22");
+  queue.Push("333");
+  ASSERT_EQ(3u, queue.PopAll(&messages));
+  ASSERT_EQ(3u, messages.size());
+  EXPECT_EQ("1", messages[0]);
+  EXPECT_EQ("22", messages[1]);
+  EXPECT_EQ("333", messages[2]);
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_EQ(0, queue.QueuedMessages());
+  EXPECT_EQ(0, queue.QueuedBytes());
+}
+
+TEST(MpscMessageQueueTest, Clear) {
+  MpscMessageQueue queue;
+  queue.Push("1");
+  queue.Push("2");
+  queue.Clear();
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(MpscMessageQueueTest, TracksQueuedGauges) {
+  MpscMessageQueue queue;
+  EXPECT_EQ(0, queue.QueuedMessages());
+  EXPECT_EQ(0, queue.QueuedBytes());
+  queue.Push("abc");
+  queue.Push("defgh");
+  EXPECT_EQ(2, queue.QueuedMessages());
+  EXPECT_EQ(8, queue.QueuedBytes());
+
+  std::string message;
+  ASSERT_TRUE(queue.Pop(&message));
+  EXPECT_EQ(1, queue.QueuedMessages());
+  EXPECT_EQ(5, queue.QueuedBytes());
+  queue.Clear();
+  EXPECT_EQ(0, queue.QueuedMessages());
+  EXPECT_EQ(0, queue.QueuedBytes());
+}
+
+TEST(MpscMessageQueueTest, MultipleProducers) {
+  const int kMessagesPerProducer = 1000;
+  MpscMessageQueue queue;
+  base::Thread producer1("producer1");
+  base::Thread producer2("producer2");
+  ASSERT_TRUE(producer1.Start());
+  ASSERT_TRUE(producer2.Start());
+  producer1.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&PushMessages, &queue, 0,
+                                kMessagesPerProducer));
+  producer2.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&PushMessages, &queue, kMessagesPerProducer,
+                                kMessagesPerProducer));
+
+  // Consume on this thread, blocking via WaitForMessage when the queue runs
+  // dry, until both producers' messages have arrived.
+  int received = 0;
+  int last_from_producer1 = -1;
+  int last_from_producer2 = -1;
+  while (received < 2 * kMessagesPerProducer) {
+    std::string message;
+    if (!queue.Pop(&message)) {
+      queue.WaitForMessage(base::TimeDelta::FromMilliseconds(100));
+      continue;
+    }
+    int value;
+    ASSERT_TRUE(base::StringToInt(message, &value));
+    // Messages from each producer must arrive in the order they were pushed.
+    if (value < kMessagesPerProducer) {
+      EXPECT_GT(value, last_from_producer1);
+      last_from_producer1 = value;
+    } else {
+      EXPECT_GT(value, last_from_producer2);
+      last_from_producer2 = value;
+    }
+    received++;
+  }
+  EXPECT_TRUE(queue.IsEmpty());
+}
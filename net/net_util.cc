@@ -25,6 +25,19 @@ namespace {
 base::LazyInstance<scoped_refptr<base::SequencedTaskRunner>>::Leaky
     g_io_capable_task_runner_for_tests = LAZY_INSTANCE_INITIALIZER;
 
+// All fetches share one network sequence. Creating a fresh sequence per
+// fetch made the DevTools discovery polls pay ThreadPool sequence setup on
+// every request and scattered them across workers; a single sequence keeps
+// the underlying network session's sockets warm for keep-alive reuse.
+scoped_refptr<base::SequencedTaskRunner> GetNetworkTaskRunner() {
+  if (g_io_capable_task_runner_for_tests.Get())
+    return g_io_capable_task_runner_for_tests.Get();
+  static scoped_refptr<base::SequencedTaskRunner>* task_runner =
+      new scoped_refptr<base::SequencedTaskRunner>(
+          base::ThreadPool::CreateSequencedTaskRunner({base::MayBlock()}));
+  return *task_runner;
+}
+
 class SyncUrlFetcher {
  public:
   SyncUrlFetcher(const GURL& url,
@@ -32,10 +45,7 @@ class SyncUrlFetcher {
                  std::string* response)
       : url_(url),
         url_loader_factory_(url_loader_factory),
-        network_task_runner_(g_io_capable_task_runner_for_tests.Get()
-                                 ? g_io_capable_task_runner_for_tests.Get()
-                                 : base::ThreadPool::CreateSequencedTaskRunner(
-                                       {base::MayBlock()})),
+        network_task_runner_(GetNetworkTaskRunner()),
         response_(response),
         event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                base::WaitableEvent::InitialState::NOT_SIGNALED) {}
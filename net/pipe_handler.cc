@@ -3,7 +3,9 @@
 // found in the LICENSE file.
 
 #include <string.h>
+#include <algorithm>
 #include <memory>
+#include <utility>
 
 #include "base/base64.h"
 #include "base/bind.h"
@@ -16,12 +18,19 @@
 #if defined(OS_WIN)
 #include <io.h>
 #else
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
-namespace {}
+namespace {
 
-const size_t read_buffer_size = 100 * 1024 * 1024;
+// The read buffer starts small and doubles through power-of-two sizes while
+// a message does not fit. It is retained between reads, so once it has grown
+// to the size of the largest message the steady state allocates nothing.
+const int kInitialReadBufferSize = 64 * 1024;
+const int kMaxReadBufferSize = 100 * 1024 * 1024;
+
+}  // namespace
 
 PipeHandler::PipeHandler(WebSocketListener* listener, int write_fd, int read_fd)
     : listener_(listener),
@@ -30,15 +39,47 @@ PipeHandler::PipeHandler(WebSocketListener* listener, int write_fd, int read_fd)
       write_buffer_(base::MakeRefCounted<net::DrainableIOBuffer>(
           base::MakeRefCounted<net::IOBuffer>(0),
           0)),
-      read_buffer_(base::MakeRefCounted<net::DrainableIOBuffer>(
-          base::MakeRefCounted<net::IOBuffer>(read_buffer_size),
-          0)) {}
+      read_buffer_(base::MakeRefCounted<net::GrowableIOBuffer>()) {
+  read_buffer_->SetCapacity(kInitialReadBufferSize);
+}
 
 PipeHandler::~PipeHandler() = default;
 
 bool PipeHandler::Send(const std::string& message) {
   VLOG(4) << "PipeHandler::Send " << message;
 
+#if !defined(OS_WIN)
+  if (!write_buffer_->BytesRemaining() && pending_write_.empty()) {
+    // Nothing is queued, so the message and its trailing NUL terminator can
+    // go to the pipe as a single vectored write without being concatenated
+    // or copied first.
+    static const char kNul = '\0';
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<char*>(message.data());
+    iov[0].iov_len = message.length();
+    iov[1].iov_base = const_cast<char*>(&kNul);
+    iov[1].iov_len = 1;
+    ssize_t bytes_written = writev(write_fd_, iov, 2);
+    if (bytes_written == -1) {
+      LOG(ERROR) << "Connection closed, not able to write into pipe";
+      Close();
+      return true;
+    }
+    if (static_cast<size_t>(bytes_written) < message.length() + 1) {
+      // Queue only the tail the pipe did not accept, then flush it before
+      // returning: nothing else drains the queue until the next Send, and
+      // the browser must not be left holding a truncated message.
+      if (static_cast<size_t>(bytes_written) < message.length()) {
+        pending_write_.append(message, bytes_written,
+                              message.length() - bytes_written);
+      }
+      pending_write_.append("\0", 1);
+      WriteIntoPipe();
+    }
+    return true;
+  }
+#endif
+
   pending_write_.append(message);
   pending_write_.append("\0", 1);
 
@@ -53,10 +94,12 @@ void PipeHandler::WriteIntoPipe() {
     if (pending_write_.empty())
       return;
 
+    // Hand the queued bytes over to the buffer without copying them.
+    std::unique_ptr<std::string> queued = std::make_unique<std::string>();
+    queued->swap(pending_write_);
+    int length = queued->length();
     write_buffer_ = base::MakeRefCounted<net::DrainableIOBuffer>(
-        base::MakeRefCounted<net::StringIOBuffer>(pending_write_),
-        pending_write_.length());
-    pending_write_.clear();
+        base::MakeRefCounted<net::StringIOBuffer>(std::move(queued)), length);
   }
 
   while (write_buffer_->BytesRemaining()) {
@@ -75,27 +118,44 @@ void PipeHandler::WriteIntoPipe() {
 
 void PipeHandler::Read() {
   while (true) {
-    auto bytes_read = read(read_fd_, &read_buffer_, read_buffer_size);
-    if (read_buffer_->BytesRemaining() == 0) {
-      LOG(ERROR) << "Connection closed, not enough capacity";
+    if (!read_buffer_->RemainingCapacity()) {
+      int capacity = read_buffer_->capacity();
+      if (capacity >= kMaxReadBufferSize) {
+        LOG(ERROR) << "Connection closed, not enough capacity";
+        Close();
+        return;
+      }
+      read_buffer_->SetCapacity(std::min(capacity * 2, kMaxReadBufferSize));
+    }
+
+    auto bytes_read =
+        read(read_fd_, read_buffer_->data(), read_buffer_->RemainingCapacity());
+    if (bytes_read == -1) {
+      LOG(ERROR) << "Connection closed, not able to read from pipe";
       Close();
-      break;
+      return;
     }
     if (!bytes_read)
       break;
 
+    read_buffer_->set_offset(read_buffer_->offset() + bytes_read);
+
     // Go over the last read chunk, look for \0, extract messages.
+    char* data = read_buffer_->StartOfBuffer();
+    int data_length = read_buffer_->offset();
     int offset = 0;
-    for (int i = read_buffer_->size() - bytes_read; i < read_buffer_->size();
-         ++i) {
-      if (read_buffer_->data()[i] == '\0') {
-        listener_->OnMessageReceived(std::string(read_buffer_->data() + offset,
-                                                 read_buffer_->data() + i));
+    for (int i = data_length - bytes_read; i < data_length; ++i) {
+      if (data[i] == '\0') {
+        listener_->OnMessageReceived(std::string(data + offset, data + i));
         offset = i + 1;
       }
     }
-    if (offset)
-      read_buffer_->DidConsume(offset);
+    if (offset) {
+      // Keep the trailing partial message at the front of the buffer; the
+      // buffer itself is retained for the next read.
+      memmove(data, data + offset, data_length - offset);
+      read_buffer_->set_offset(data_length - offset);
+    }
   }
 }
 
@@ -13,6 +13,7 @@
 
 namespace net {
 class DrainableIOBuffer;
+class GrowableIOBuffer;
 }
 
 class WebSocketListener;
@@ -36,7 +37,7 @@ class PipeHandler {
   int read_fd_;
 
   scoped_refptr<net::DrainableIOBuffer> write_buffer_;
-  scoped_refptr<net::DrainableIOBuffer> read_buffer_;
+  scoped_refptr<net::GrowableIOBuffer> read_buffer_;
   std::string pending_write_;
 
   DISALLOW_COPY_AND_ASSIGN(PipeHandler);
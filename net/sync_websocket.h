@@ -6,7 +6,11 @@
 #define CHROME_TEST_CHROMEDRIVER_NET_SYNC_WEBSOCKET_H_
 
 #include <string>
+#include <vector>
 
+#include "base/memory/scoped_refptr.h"
+
+class BufferPool;
 class GURL;
 class Timeout;
 
@@ -32,6 +36,17 @@ class SyncWebSocket {
   // Sends message. Returns true on success.
   virtual bool Send(const std::string& message) = 0;
 
+  // Like Send(const std::string&), but allows the implementation to take
+  // ownership of the buffer so the transport writes from it without a
+  // copy and can hand it back to a buffer pool afterwards; see
+  // SetSendBufferPool. The default forwards to the copying overload.
+  virtual bool Send(std::string&& message) { return Send(message); }
+
+  // Supplies the pool that buffers passed to Send(std::string&&) are
+  // released to once written. The default ignores the pool; callers then
+  // simply pay the allocation they always have.
+  virtual void SetSendBufferPool(scoped_refptr<BufferPool> pool) {}
+
   // Receives next message and modifies the message on success. Returns
   // StatusCode::kTimedout if no message is received within |timeout|.
   // Returns StatusCode::kDisconnected if the socket is closed.
@@ -42,6 +57,22 @@ class SyncWebSocket {
   // Returns whether there are any messages that have been received and not yet
   // handled by ReceiveNextMessage.
   virtual bool HasNextMessage() = 0;
+
+  // Moves every message already received and not yet handled into
+  // |messages|, in arrival order, without blocking. Returns false if the
+  // transport does not support batch draining; |messages| is then left
+  // untouched and callers fall back to ReceiveNextMessage. The default
+  // does not support it.
+  virtual bool ReceiveQueuedMessages(std::vector<std::string>* messages) {
+    return false;
+  }
+
+  // Returns false only if no pending message can announce a JavaScript
+  // dialog opening. Implementations that scan messages as they arrive on
+  // the background thread make this a flag read, so callers can rule out
+  // a dialog without draining the queue. The default is conservative: any
+  // pending message may be such an event.
+  virtual bool MayHavePendingDialogOpening() { return HasNextMessage(); }
 };
 
 #endif  // CHROME_TEST_CHROMEDRIVER_NET_SYNC_WEBSOCKET_H_
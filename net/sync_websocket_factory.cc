@@ -4,38 +4,116 @@
 
 #include "chrome/test/chromedriver/net/sync_websocket_factory.h"
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "base/bind.h"
+#include "base/check.h"
 #include "base/command_line.h"
+#include "base/lazy_instance.h"
 #include "base/memory/ref_counted.h"
+#include "base/message_loop/message_pump_type.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "chrome/test/chromedriver/constants/version.h"
 #include "chrome/test/chromedriver/log_replay/log_replay_socket.h"
 #include "chrome/test/chromedriver/net/sync_websocket_impl.h"
+#include "chrome/test/chromedriver/net/timeout.h"
 #include "chrome/test/chromedriver/net/url_request_context_getter.h"
 
 namespace {
 
-std::unique_ptr<SyncWebSocket> CreateSyncWebSocket(
-    scoped_refptr<URLRequestContextGetter> context_getter) {
+// Dedicated transport threads for DevTools sockets, separate from the
+// server's HTTP IO threads, so a burst of event traffic from one noisy
+// browser cannot delay HTTP request parsing for other sessions and the two
+// sides scale independently. Each thread runs its own URLRequestContext; a
+// socket is assigned a thread round-robin at creation and keeps that
+// affinity for its lifetime, since its core binds to the thread's context
+// getter. Started lazily on the first DevTools connection.
+class DevToolsTransportPool {
+ public:
+  DevToolsTransportPool() : next_thread_(0) {}
+
+  URLRequestContextGetter* NextContextGetter() {
+    base::AutoLock lock(lock_);
+    if (threads_.empty())
+      Start();
+    scoped_refptr<URLRequestContextGetter>& getter =
+        getters_[next_thread_ % threads_.size()];
+    next_thread_++;
+    return getter.get();
+  }
+
+ private:
+  void Start() {
+    int thread_count = 4;
+    int parsed = 0;
+    if (base::StringToInt(
+            base::CommandLine::ForCurrentProcess()->GetSwitchValueASCII(
+                "devtools-transport-threads"),
+            &parsed) &&
+        parsed > 0) {
+      thread_count = std::min(parsed, 16);
+    }
+    for (int i = 0; i < thread_count; ++i) {
+      auto thread = std::make_unique<base::Thread>(base::StringPrintf(
+          "%s DevTools transport %d", kChromeDriverProductShortName, i));
+      CHECK(thread->StartWithOptions(
+          base::Thread::Options(base::MessagePumpType::IO, 0)));
+      getters_.push_back(
+          base::MakeRefCounted<URLRequestContextGetter>(thread->task_runner()));
+      threads_.push_back(std::move(thread));
+    }
+  }
+
+  base::Lock lock_;
+  size_t next_thread_;
+  std::vector<std::unique_ptr<base::Thread>> threads_;
+  std::vector<scoped_refptr<URLRequestContextGetter>> getters_;
+};
+
+// Leaky: the transport threads live for the whole process.
+base::LazyInstance<DevToolsTransportPool>::Leaky g_transport_pool =
+    LAZY_INSTANCE_INITIALIZER;
+
+std::unique_ptr<SyncWebSocket> CreateSyncWebSocket() {
   return std::unique_ptr<SyncWebSocket>(
-      new SyncWebSocketImpl(context_getter.get()));
+      new SyncWebSocketImpl(g_transport_pool.Get().NextContextGetter()));
 }
 
-std::unique_ptr<SyncWebSocket> CreateReplayWebSocket(base::FilePath log_path) {
-  return std::make_unique<LogReplaySocket>(log_path);
+std::unique_ptr<SyncWebSocket> CreateReplayWebSocket(
+    base::FilePath log_path,
+    base::TimeDelta fidelity_threshold) {
+  return std::make_unique<LogReplaySocket>(log_path, fidelity_threshold);
 }
 
 }  // namespace
 
-SyncWebSocketFactory CreateSyncWebSocketFactory(
-    URLRequestContextGetter* getter) {
+SyncWebSocketFactory CreateSyncWebSocketFactory() {
   const base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
   if (cmd_line->HasSwitch("devtools-replay")) {
     base::CommandLine::StringType log_path_str =
         cmd_line->GetSwitchValueNative("devtools-replay");
     base::FilePath log_path(log_path_str);
-    return base::BindRepeating(&CreateReplayWebSocket, log_path);
+    // Nothing real is on the other end of a replay socket, so waits and
+    // timeouts run against a virtual clock and the recorded session replays
+    // as fast as the log can be read. With --replay-fidelity-threshold-ms=N,
+    // recorded gaps of at least N milliseconds are still slept for real.
+    Timeout::SwitchToVirtualClockForReplay();
+    base::TimeDelta fidelity_threshold;
+    int threshold_ms = 0;
+    if (base::StringToInt(
+            cmd_line->GetSwitchValueASCII("replay-fidelity-threshold-ms"),
+            &threshold_ms) &&
+        threshold_ms > 0) {
+      fidelity_threshold = base::TimeDelta::FromMilliseconds(threshold_ms);
+    }
+    return base::BindRepeating(&CreateReplayWebSocket, log_path,
+                               fidelity_threshold);
   }
-  return base::BindRepeating(&CreateSyncWebSocket,
-                             base::WrapRefCounted(getter));
+  return base::BindRepeating(&CreateSyncWebSocket);
 }
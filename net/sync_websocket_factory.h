@@ -10,12 +10,15 @@
 #include "base/callback.h"
 
 class SyncWebSocket;
-class URLRequestContextGetter;
 
 typedef base::RepeatingCallback<std::unique_ptr<SyncWebSocket>()>
     SyncWebSocketFactory;
 
-SyncWebSocketFactory CreateSyncWebSocketFactory(
-    URLRequestContextGetter* getter);
+// Returns the factory for DevTools connections. Live sockets run on a
+// dedicated transport thread pool (sized by --devtools-transport-threads)
+// rather than the server's HTTP IO threads, so browser event bursts cannot
+// delay client-facing request handling. With --devtools-replay, sockets
+// replay a recorded log instead of connecting anywhere.
+SyncWebSocketFactory CreateSyncWebSocketFactory();
 
 #endif  // CHROME_TEST_CHROMEDRIVER_NET_SYNC_WEBSOCKET_FACTORY_H_
@@ -5,14 +5,17 @@
 #include "chrome/test/chromedriver/net/sync_websocket_impl.h"
 
 #include <memory>
+#include <utility>
 
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/json/json_reader.h"
 #include "base/json/json_writer.h"
 #include "base/location.h"
+#include "base/logging.h"
 #include "base/single_thread_task_runner.h"
 #include "base/synchronization/waitable_event.h"
+#include "chrome/test/chromedriver/chrome/driver_tracing.h"
 #include "chrome/test/chromedriver/net/command_id.h"
 #include "chrome/test/chromedriver/net/timeout.h"
 #include "net/base/net_errors.h"
@@ -37,8 +40,17 @@ bool SyncWebSocketImpl::Send(const std::string& message) {
   return core_->Send(message);
 }
 
+bool SyncWebSocketImpl::Send(std::string&& message) {
+  return core_->Send(std::move(message));
+}
+
+void SyncWebSocketImpl::SetSendBufferPool(scoped_refptr<BufferPool> pool) {
+  core_->SetSendBufferPool(std::move(pool));
+}
+
 SyncWebSocket::StatusCode SyncWebSocketImpl::ReceiveNextMessage(
     std::string* message, const Timeout& timeout) {
+  ScopedDriverSpan span("SyncWebSocketImpl::ReceiveNextMessage");
   return core_->ReceiveNextMessage(message, timeout);
 }
 
@@ -46,14 +58,64 @@ bool SyncWebSocketImpl::HasNextMessage() {
   return core_->HasNextMessage();
 }
 
+bool SyncWebSocketImpl::ReceiveQueuedMessages(
+    std::vector<std::string>* messages) {
+  return core_->ReceiveQueuedMessages(messages);
+}
+
+bool SyncWebSocketImpl::MayHavePendingDialogOpening() {
+  return core_->MayHavePendingDialogOpening();
+}
+
+namespace {
+
+// Method name scanned for in raw messages; see MayHavePendingDialogOpening.
+const char kDialogOpeningMethod[] = "Page.javascriptDialogOpening";
+
+// After this much inactivity on the socket, probe the peer with a ping.
+const int kKeepaliveIntervalSeconds = 5;
+
+// An unanswered ping older than this means the peer is gone.
+const int kKeepaliveDeadlineSeconds = 10;
+
+// Bounds on the inbound message queue, in bytes. Command responses are never
+// dropped — a caller is blocked waiting on each one — but a page can emit
+// events far faster than a busy session thread drains them, so event messages
+// are shed once the queue is this far behind: high-volume diagnostic streams
+// first, all events at the hard bound. Overridable via
+// SetInboundQueueLimitsForTesting.
+int64_t g_low_priority_event_limit_bytes = 32 * 1024 * 1024;
+int64_t g_event_limit_bytes = 256 * 1024 * 1024;
+
+// How often a drop is logged; the first one is always logged.
+const uint64_t kDropLogInterval = 1000;
+
+bool MentionsDialogOpening(const std::string& message) {
+  return message.find(kDialogOpeningMethod) != std::string::npos;
+}
+
+// Events shed first under queue pressure: pure diagnostics whose loss
+// degrades the corresponding WebDriver log but never command correctness.
+bool IsLowPriorityEvent(const std::string& method) {
+  return method == "Log.entryAdded" || method == "Runtime.consoleAPICalled" ||
+         method == "Network.dataReceived";
+}
+
+}  // namespace
+
+// static
+void SyncWebSocketImpl::SetInboundQueueLimitsForTesting(
+    int64_t low_priority_limit,
+    int64_t event_limit) {
+  g_low_priority_event_limit_bytes = low_priority_limit;
+  g_event_limit_bytes = event_limit;
+}
+
 SyncWebSocketImpl::Core::Core(net::URLRequestContextGetter* context_getter)
-    : context_getter_(context_getter),
-      is_connected_(false),
-      on_update_event_(&lock_) {}
+    : context_getter_(context_getter), is_connected_(false) {}
 
 bool SyncWebSocketImpl::Core::IsConnected() {
-  base::AutoLock lock(lock_);
-  return is_connected_;
+  return is_connected_.load(std::memory_order_acquire);
 }
 
 bool SyncWebSocketImpl::Core::Connect(const GURL& url) {
@@ -88,52 +150,107 @@ bool SyncWebSocketImpl::Core::Connect(const GURL& url) {
   return success;
 }
 
-bool SyncWebSocketImpl::Core::Send(const std::string& message) {
+bool SyncWebSocketImpl::Core::Send(std::string message) {
   bool success = false;
   base::WaitableEvent event(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                             base::WaitableEvent::InitialState::NOT_SIGNALED);
+  // The buffer is moved through the closure, so the IO thread writes from
+  // the very bytes the caller serialized into; no cross-thread copy.
   context_getter_->GetNetworkTaskRunner()->PostTask(
       FROM_HERE, base::BindOnce(&SyncWebSocketImpl::Core::SendOnIO, this,
-                                message, &success, &event));
+                                std::move(message), &success, &event));
   event.Wait();
   return success;
 }
 
+void SyncWebSocketImpl::Core::SetSendBufferPool(
+    scoped_refptr<BufferPool> pool) {
+  send_buffer_pool_ = std::move(pool);
+}
+
 SyncWebSocket::StatusCode SyncWebSocketImpl::Core::ReceiveNextMessage(
     std::string* message,
     const Timeout& timeout) {
-  base::AutoLock lock(lock_);
-  while (received_queue_.empty() && is_connected_) {
+  while (true) {
+    if (!is_connected_.load(std::memory_order_acquire))
+      return SyncWebSocket::kDisconnected;
+    if (received_queue_.Pop(message)) {
+      if (MentionsDialogOpening(*message))
+        pending_dialog_openings_.fetch_sub(1, std::memory_order_relaxed);
+      return SyncWebSocket::kOk;
+    }
     base::TimeDelta next_wait = timeout.GetRemainingTime();
     if (next_wait <= base::TimeDelta())
       return SyncWebSocket::kTimeout;
-    on_update_event_.TimedWait(next_wait);
+    received_queue_.WaitForMessage(next_wait);
   }
-  if (!is_connected_)
-    return SyncWebSocket::kDisconnected;
-  *message = received_queue_.front();
-  received_queue_.pop_front();
-  return SyncWebSocket::kOk;
 }
 
 bool SyncWebSocketImpl::Core::HasNextMessage() {
-  base::AutoLock lock(lock_);
-  return !received_queue_.empty();
+  return !received_queue_.IsEmpty();
+}
+
+bool SyncWebSocketImpl::Core::ReceiveQueuedMessages(
+    std::vector<std::string>* messages) {
+  if (!is_connected_.load(std::memory_order_acquire))
+    return false;
+  size_t first = messages->size();
+  received_queue_.PopAll(messages);
+  // Keep the pending-dialog gauge in step, as ReceiveNextMessage would.
+  for (size_t i = first; i < messages->size(); ++i) {
+    if (MentionsDialogOpening((*messages)[i]))
+      pending_dialog_openings_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+bool SyncWebSocketImpl::Core::MayHavePendingDialogOpening() {
+  return pending_dialog_openings_.load(std::memory_order_relaxed) > 0;
 }
 
 // TODO(johnchen) : Send messages with negative command ids to client.
 // https://crrev.com/c/1745493 is a pending CL that does this
-void SyncWebSocketImpl::Core::OnMessageReceived(const std::string& message) {
-  base::AutoLock lock(lock_);
+void SyncWebSocketImpl::Core::OnMessageReceived(std::string message) {
+  // Any inbound traffic proves the peer is alive.
+  last_activity_ = base::TimeTicks::Now();
+  ping_pending_ = false;
   bool send_to_chromedriver;
-  DetermineRecipient(message, &send_to_chromedriver);
-  if (send_to_chromedriver)
-    received_queue_.push_back(message);
-  on_update_event_.Signal();
+  std::string method;
+  DetermineRecipient(message, &send_to_chromedriver, &method);
+  if (!send_to_chromedriver)
+    return;
+  bool mentions_dialog_opening = MentionsDialogOpening(message);
+  // Shed event traffic once the consumer has fallen too far behind, so a
+  // misbehaving page cannot grow the queue without bound. Command responses
+  // (no method) are never dropped, and neither are dialog notifications,
+  // which the pending-dialog flag depends on.
+  if (!method.empty() && !mentions_dialog_opening) {
+    int64_t queued_bytes = received_queue_.QueuedBytes();
+    if (queued_bytes >= g_event_limit_bytes ||
+        (queued_bytes >= g_low_priority_event_limit_bytes &&
+         IsLowPriorityEvent(method))) {
+      dropped_messages_++;
+      dropped_bytes_ += message.size();
+      if (dropped_messages_ == 1 || dropped_messages_ % kDropLogInterval == 0) {
+        LOG(WARNING) << "inbound DevTools queue is " << queued_bytes
+                     << " bytes behind; dropped " << dropped_messages_
+                     << " event messages (" << dropped_bytes_
+                     << " bytes) since connect, last: " << method;
+      }
+      return;
+    }
+  }
+  // Publish dialog notifications before the message is visible to the
+  // consumer, so a consumer that saw the message also sees the flag.
+  if (mentions_dialog_opening)
+    pending_dialog_openings_.fetch_add(1, std::memory_order_relaxed);
+  received_queue_.Push(std::move(message));
 }
 
 void SyncWebSocketImpl::Core::DetermineRecipient(const std::string& message,
-                                                 bool* send_to_chromedriver) {
+                                                 bool* send_to_chromedriver,
+                                                 std::string* method) {
+  method->clear();
   base::Optional<base::Value> message_value =
       base::JSONReader::Read(message, base::JSON_REPLACE_INVALID_CHARACTERS);
   base::DictionaryValue* message_dict;
@@ -142,15 +259,25 @@ void SyncWebSocketImpl::Core::DetermineRecipient(const std::string& message,
     return;
   }
   int id;
+  bool has_id = message_dict->HasKey("id");
+  if (!has_id)
+    message_dict->GetString("method", method);
   *send_to_chromedriver =
-      !message_dict->HasKey("id") || (message_dict->GetInteger("id", &id) &&
-                                      CommandId::IsChromeDriverCommandId(id));
+      !has_id || (message_dict->GetInteger("id", &id) &&
+                  CommandId::IsChromeDriverCommandId(id));
 }
 
 void SyncWebSocketImpl::Core::OnClose() {
-  base::AutoLock lock(lock_);
-  is_connected_ = false;
-  on_update_event_.Signal();
+  is_connected_.store(false, std::memory_order_release);
+  keepalive_timer_.reset();
+  // Wake any consumer blocked in ReceiveNextMessage so it observes the
+  // disconnect.
+  received_queue_.Signal();
+}
+
+void SyncWebSocketImpl::Core::OnPong() {
+  last_activity_ = base::TimeTicks::Now();
+  ping_pending_ = false;
 }
 
 SyncWebSocketImpl::Core::~Core() { }
@@ -159,10 +286,12 @@ void SyncWebSocketImpl::Core::ConnectOnIO(
     const GURL& url,
     bool* success,
     base::WaitableEvent* event) {
-  {
-    base::AutoLock lock(lock_);
-    received_queue_.clear();
-  }
+  // The client thread is blocked in Connect() at this point, so there is no
+  // concurrent consumer and the queue may be drained from here.
+  received_queue_.Clear();
+  pending_dialog_openings_.store(0, std::memory_order_relaxed);
+  dropped_messages_ = 0;
+  dropped_bytes_ = 0;
   // If this is a retry to connect, there is a chance that the original attempt
   // to connect has succeeded after the retry was initiated, so double check if
   // we are already connected. The is_connected_ flag is only set on the I/O
@@ -171,6 +300,8 @@ void SyncWebSocketImpl::Core::ConnectOnIO(
   // stale memory, so don't use either parameters before returning.
   if (socket_ && is_connected_)
     return;
+  keepalive_timer_.reset();
+  ping_pending_ = false;
   socket_ = std::make_unique<WebSocket>(url, this);
   socket_->Connect(base::BindOnce(
       &SyncWebSocketImpl::Core::OnConnectCompletedOnIO, this, success, event));
@@ -182,18 +313,48 @@ void SyncWebSocketImpl::Core::OnConnectCompletedOnIO(
     int error) {
   *success = (error == net::OK);
   if (*success) {
-    base::AutoLock lock(lock_);
-    is_connected_ = true;
+    is_connected_.store(true, std::memory_order_release);
+    last_activity_ = base::TimeTicks::Now();
+    ping_pending_ = false;
+    keepalive_timer_ = std::make_unique<base::RepeatingTimer>();
+    keepalive_timer_->Start(
+        FROM_HERE, base::TimeDelta::FromSeconds(kKeepaliveIntervalSeconds),
+        base::BindRepeating(&SyncWebSocketImpl::Core::CheckLivenessOnIO, this));
   }
   event->Signal();
 }
 
 void SyncWebSocketImpl::Core::SendOnIO(
-    const std::string& message,
+    std::string message,
     bool* success,
     base::WaitableEvent* event) {
   *success = socket_->Send(message);
   event->Signal();
+  // The sender has been unblocked; recycling the buffer afterwards keeps
+  // the pool handoff off the command's critical path.
+  if (send_buffer_pool_)
+    send_buffer_pool_->Release(std::move(message));
+}
+
+void SyncWebSocketImpl::Core::CheckLivenessOnIO() {
+  base::TimeDelta quiet = base::TimeTicks::Now() - last_activity_;
+  if (ping_pending_ &&
+      quiet >= base::TimeDelta::FromSeconds(kKeepaliveDeadlineSeconds)) {
+    // The peer has neither sent traffic nor answered our ping: treat the
+    // connection as dead and fail blocked consumers immediately, rather
+    // than letting them wait out their own (possibly much longer) timeout.
+    LOG(WARNING) << "WebSocket peer unresponsive for " << quiet.InSeconds()
+                 << " seconds, dropping connection";
+    keepalive_timer_.reset();
+    socket_.reset();
+    is_connected_.store(false, std::memory_order_release);
+    received_queue_.Signal();
+    return;
+  }
+  if (!ping_pending_ &&
+      quiet >= base::TimeDelta::FromSeconds(kKeepaliveIntervalSeconds)) {
+    ping_pending_ = socket_->SendPing();
+  }
 }
 
 void SyncWebSocketImpl::Core::OnDestruct() const {
@@ -206,6 +367,7 @@ void SyncWebSocketImpl::Core::OnDestruct() const {
 }
 
 void SyncWebSocketImpl::Core::CloseOnIO(base::WaitableEvent* event) {
+  keepalive_timer_.reset();
   socket_.reset();
   event->Signal();
 }
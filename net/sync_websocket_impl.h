@@ -5,15 +5,20 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_NET_SYNC_WEBSOCKET_IMPL_H_
 #define CHROME_TEST_CHROMEDRIVER_NET_SYNC_WEBSOCKET_IMPL_H_
 
-#include <list>
+#include <stdint.h>
+
+#include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/compiler_specific.h"
 #include "base/memory/ref_counted.h"
 #include "base/sequenced_task_runner_helpers.h"
-#include "base/synchronization/condition_variable.h"
-#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "chrome/test/chromedriver/net/buffer_pool.h"
+#include "chrome/test/chromedriver/net/mpsc_message_queue.h"
 #include "chrome/test/chromedriver/net/sync_websocket.h"
 #include "chrome/test/chromedriver/net/websocket.h"
 
@@ -37,9 +42,18 @@ class SyncWebSocketImpl : public SyncWebSocket {
   bool IsConnected() override;
   bool Connect(const GURL& url) override;
   bool Send(const std::string& message) override;
+  bool Send(std::string&& message) override;
+  void SetSendBufferPool(scoped_refptr<BufferPool> pool) override;
   StatusCode ReceiveNextMessage(std::string* message,
                                 const Timeout& timeout) override;
   bool HasNextMessage() override;
+  bool ReceiveQueuedMessages(std::vector<std::string>* messages) override;
+  bool MayHavePendingDialogOpening() override;
+
+  // Overrides the inbound queue bounds (bytes) used by the event drop
+  // policy; see Core::OnMessageReceived. Affects all sockets.
+  static void SetInboundQueueLimitsForTesting(int64_t low_priority_limit,
+                                              int64_t event_limit);
 
  private:
   struct CoreTraits;
@@ -50,15 +64,19 @@ class SyncWebSocketImpl : public SyncWebSocket {
 
     bool IsConnected();
     bool Connect(const GURL& url);
-    bool Send(const std::string& message);
+    bool Send(std::string message);
+    void SetSendBufferPool(scoped_refptr<BufferPool> pool);
     SyncWebSocket::StatusCode ReceiveNextMessage(
         std::string* message,
         const Timeout& timeout);
     bool HasNextMessage();
+    bool ReceiveQueuedMessages(std::vector<std::string>* messages);
+    bool MayHavePendingDialogOpening();
 
     // Overriden from WebSocketListener:
-    void OnMessageReceived(const std::string& message) override;
+    void OnMessageReceived(std::string message) override;
     void OnClose() override;
+    void OnPong() override;
 
    private:
     friend class base::RefCountedThreadSafe<Core, CoreTraits>;
@@ -73,34 +91,58 @@ class SyncWebSocketImpl : public SyncWebSocket {
     void OnConnectCompletedOnIO(bool* connected,
                                 base::WaitableEvent* event,
                                 int error);
-    void SendOnIO(const std::string& message,
+    void SendOnIO(std::string message,
                   bool* result,
                   base::WaitableEvent* event);
     void CloseOnIO(base::WaitableEvent* event);
 
-    // Determines the intended recipients of the message received
+    // Periodic liveness check, run by |keepalive_timer_| on the IO thread.
+    // Pings the peer after a quiet period and tears the socket down if a
+    // previous ping went unanswered, so consumers blocked in
+    // ReceiveNextMessage fail fast instead of waiting out their timeout.
+    void CheckLivenessOnIO();
+
+    // Determines the intended recipients of the message received. For event
+    // messages, |method| receives the event method; for command responses
+    // (and unparseable messages) it is left empty.
     void DetermineRecipient(const std::string& message,
-                            bool* send_to_chromedriver);
+                            bool* send_to_chromedriver,
+                            std::string* method);
 
     // OnDestruct is meant to ensure deletion on the IO thread.
     void OnDestruct() const;
 
     scoped_refptr<net::URLRequestContextGetter> context_getter_;
 
+    // Sent buffers are released here after the write, so the serializing
+    // thread can reuse them; may be null. Set before the first Send and
+    // not changed after, so reads need no locking.
+    scoped_refptr<BufferPool> send_buffer_pool_;
+
     // Only accessed on IO thread.
     std::unique_ptr<WebSocket> socket_;
 
-    base::Lock lock_;
+    // Keepalive state, only accessed on the IO thread.
+    std::unique_ptr<base::RepeatingTimer> keepalive_timer_;
+    base::TimeTicks last_activity_;
+    bool ping_pending_ = false;
+
+    // Event messages discarded by the inbound queue bound since the last
+    // (re)connect; only accessed on the IO thread.
+    uint64_t dropped_messages_ = 0;
+    uint64_t dropped_bytes_ = 0;
 
-    // Protected by |lock_|.
-    bool is_connected_;
+    std::atomic<bool> is_connected_;
 
-    // Protected by |lock_|.
-    std::list<std::string> received_queue_;
+    // Messages flow lock-free from the IO thread (producer) to the thread
+    // blocked in ReceiveNextMessage (consumer), so heavy DevTools event
+    // traffic does not serialize the two threads on a mutex.
+    MpscMessageQueue received_queue_;
 
-    // Protected by |lock_|.
-    // Signaled when the socket closes or a message is received.
-    base::ConditionVariable on_update_event_;
+    // Count of queued messages that mention a dialog opening, published by
+    // the IO thread at receive time so consumers can rule out a pending
+    // dialog without draining the queue.
+    std::atomic<int> pending_dialog_openings_{0};
   };
 
   scoped_refptr<Core> core_;
@@ -74,6 +74,61 @@ TEST_F(SyncWebSocketImplTest, SendReceive) {
   ASSERT_STREQ("hi", message.c_str());
 }
 
+TEST_F(SyncWebSocketImplTest, PendingDialogOpeningFlag) {
+  SyncWebSocketImpl sock(context_getter_.get());
+  ASSERT_TRUE(sock.Connect(server_.web_socket_url()));
+  ASSERT_FALSE(sock.MayHavePendingDialogOpening());
+  ASSERT_TRUE(sock.Send(
+      R"({"method": "Page.javascriptDialogOpening", "params": {}})"));
+  std::string message;
+  // The flag is published when the echoed event is received; consuming the
+  // event clears it.
+  ASSERT_EQ(SyncWebSocket::kOk,
+            sock.ReceiveNextMessage(&message, long_timeout()));
+  ASSERT_FALSE(sock.MayHavePendingDialogOpening());
+}
+
+TEST_F(SyncWebSocketImplTest, InboundQueueDropsLowPriorityEventsFirst) {
+  // A zero low-priority bound drops every diagnostic event; other events and
+  // command responses pass.
+  SyncWebSocketImpl::SetInboundQueueLimitsForTesting(0, 256 * 1024 * 1024);
+  SyncWebSocketImpl sock(context_getter_.get());
+  ASSERT_TRUE(sock.Connect(server_.web_socket_url()));
+  ASSERT_TRUE(sock.Send(R"({"method": "Log.entryAdded", "params": {}})"));
+  ASSERT_TRUE(sock.Send(R"({"method": "Page.frameNavigated", "params": {}})"));
+  ASSERT_TRUE(sock.Send(R"({"id": 1, "result": {}})"));
+  std::string message;
+  ASSERT_EQ(SyncWebSocket::kOk,
+            sock.ReceiveNextMessage(&message, long_timeout()));
+  EXPECT_NE(std::string::npos, message.find("Page.frameNavigated"));
+  ASSERT_EQ(SyncWebSocket::kOk,
+            sock.ReceiveNextMessage(&message, long_timeout()));
+  EXPECT_NE(std::string::npos, message.find("\"id\""));
+  SyncWebSocketImpl::SetInboundQueueLimitsForTesting(32 * 1024 * 1024,
+                                                     256 * 1024 * 1024);
+}
+
+TEST_F(SyncWebSocketImplTest, InboundQueueNeverDropsResponsesOrDialogs) {
+  // At a zero hard bound all events are shed, but command responses and
+  // dialog-opening notifications must still come through.
+  SyncWebSocketImpl::SetInboundQueueLimitsForTesting(0, 0);
+  SyncWebSocketImpl sock(context_getter_.get());
+  ASSERT_TRUE(sock.Connect(server_.web_socket_url()));
+  ASSERT_TRUE(sock.Send(R"({"method": "Page.frameNavigated", "params": {}})"));
+  ASSERT_TRUE(sock.Send(
+      R"({"method": "Page.javascriptDialogOpening", "params": {}})"));
+  ASSERT_TRUE(sock.Send(R"({"id": 1, "result": {}})"));
+  std::string message;
+  ASSERT_EQ(SyncWebSocket::kOk,
+            sock.ReceiveNextMessage(&message, long_timeout()));
+  EXPECT_NE(std::string::npos, message.find("Page.javascriptDialogOpening"));
+  ASSERT_EQ(SyncWebSocket::kOk,
+            sock.ReceiveNextMessage(&message, long_timeout()));
+  EXPECT_NE(std::string::npos, message.find("\"id\""));
+  SyncWebSocketImpl::SetInboundQueueLimitsForTesting(32 * 1024 * 1024,
+                                                     256 * 1024 * 1024);
+}
+
 TEST_F(SyncWebSocketImplTest, DetermineRecipient) {
   SyncWebSocketImpl sock(context_getter_.get());
   ASSERT_TRUE(sock.Connect(server_.web_socket_url()));
@@ -0,0 +1,70 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/sync_websocket_pool.h"
+
+#include <utility>
+
+#include "base/lazy_instance.h"
+#include "chrome/test/chromedriver/net/sync_websocket.h"
+#include "url/gurl.h"
+
+namespace {
+
+base::LazyInstance<SyncWebSocketPool>::Leaky g_sync_websocket_pool =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+SyncWebSocketPool* SyncWebSocketPool::GetInstance() {
+  return g_sync_websocket_pool.Pointer();
+}
+
+SyncWebSocketPool::SyncWebSocketPool() {}
+
+SyncWebSocketPool::~SyncWebSocketPool() {}
+
+void SyncWebSocketPool::Prewarm(const SyncWebSocketFactory& factory,
+                                const std::string& url,
+                                int count) {
+  // Park under the canonicalized spec, which is what claimers key on.
+  const GURL gurl(url);
+  const std::string key = gurl.spec();
+  while (true) {
+    {
+      base::AutoLock auto_lock(lock_);
+      if (static_cast<int>(parked_[key].size()) >= count)
+        return;
+    }
+    // Dial outside the lock; Connect blocks on the handshake.
+    std::unique_ptr<SyncWebSocket> socket = factory.Run();
+    if (!socket->Connect(gurl))
+      return;
+    base::AutoLock auto_lock(lock_);
+    parked_[key].push_back(std::move(socket));
+  }
+}
+
+std::unique_ptr<SyncWebSocket> SyncWebSocketPool::Claim(
+    const std::string& url) {
+  base::AutoLock auto_lock(lock_);
+  auto it = parked_.find(url);
+  if (it == parked_.end())
+    return nullptr;
+  std::vector<std::unique_ptr<SyncWebSocket>>& sockets = it->second;
+  while (!sockets.empty()) {
+    std::unique_ptr<SyncWebSocket> socket = std::move(sockets.back());
+    sockets.pop_back();
+    if (socket->IsConnected())
+      return socket;
+    // The browser closed a parked connection (e.g. across a restart);
+    // discard it and try the next one.
+  }
+  return nullptr;
+}
+
+void SyncWebSocketPool::Clear() {
+  base::AutoLock auto_lock(lock_);
+  parked_.clear();
+}
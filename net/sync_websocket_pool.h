@@ -0,0 +1,56 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_NET_SYNC_WEBSOCKET_POOL_H_
+#define CHROME_TEST_CHROMEDRIVER_NET_SYNC_WEBSOCKET_POOL_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/synchronization/lock.h"
+#include "chrome/test/chromedriver/net/sync_websocket_factory.h"
+
+class SyncWebSocket;
+
+// A small pool of pre-established WebSocket connections, keyed by endpoint
+// URL. Every root DevTools connection to the same browser (the main client,
+// bulk-transfer channels, reconnects) pays the TCP plus HTTP-upgrade
+// handshake inside Connect before the first command flows; parking a spare
+// connection or two at launch makes those dials handshake-free. All methods
+// are thread-safe; a claimed socket belongs entirely to the claimer.
+class SyncWebSocketPool {
+ public:
+  // The process-wide instance; production code shares it so prewarmed
+  // connections from launch are visible to every later root dial. Tests
+  // construct their own pools.
+  static SyncWebSocketPool* GetInstance();
+
+  SyncWebSocketPool();
+  ~SyncWebSocketPool();
+
+  SyncWebSocketPool(const SyncWebSocketPool&) = delete;
+  SyncWebSocketPool& operator=(const SyncWebSocketPool&) = delete;
+
+  // Dials connections to |url| with |factory| until |count| are parked for
+  // it, synchronously. Dial failures stop the topping-up but are not errors;
+  // the pool is an optimization and Claim misses fall back to a normal dial.
+  void Prewarm(const SyncWebSocketFactory& factory,
+               const std::string& url,
+               int count);
+
+  // Returns a connected socket previously parked for |url|, or null when
+  // none is available. Stale (disconnected) parked sockets are discarded.
+  std::unique_ptr<SyncWebSocket> Claim(const std::string& url);
+
+  // Drops every parked connection.
+  void Clear();
+
+ private:
+  base::Lock lock_;
+  std::map<std::string, std::vector<std::unique_ptr<SyncWebSocket>>> parked_;
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_NET_SYNC_WEBSOCKET_POOL_H_
@@ -0,0 +1,109 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/sync_websocket_pool.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "chrome/test/chromedriver/net/sync_websocket.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace {
+
+class FakePooledSocket : public SyncWebSocket {
+ public:
+  explicit FakePooledSocket(int* dial_count) : dial_count_(dial_count) {}
+  ~FakePooledSocket() override {}
+
+  bool IsConnected() override { return connected_; }
+
+  bool Connect(const GURL& url) override {
+    ++*dial_count_;
+    connected_ = true;
+    return true;
+  }
+
+  bool Send(const std::string& message) override { return connected_; }
+
+  StatusCode ReceiveNextMessage(std::string* message,
+                                const Timeout& timeout) override {
+    return kDisconnected;
+  }
+
+  bool HasNextMessage() override { return false; }
+
+  void Disconnect() { connected_ = false; }
+
+ private:
+  int* dial_count_;
+  bool connected_ = false;
+};
+
+std::unique_ptr<SyncWebSocket> CreateFakePooledSocket(
+    int* dial_count,
+    FakePooledSocket** last_socket) {
+  auto socket = std::make_unique<FakePooledSocket>(dial_count);
+  if (last_socket)
+    *last_socket = socket.get();
+  return socket;
+}
+
+SyncWebSocketFactory MakeFactory(int* dial_count,
+                                 FakePooledSocket** last_socket) {
+  return base::BindRepeating(&CreateFakePooledSocket, dial_count, last_socket);
+}
+
+}  // namespace
+
+TEST(SyncWebSocketPool, PrewarmThenClaim) {
+  SyncWebSocketPool pool;
+  int dials = 0;
+  pool.Prewarm(MakeFactory(&dials, nullptr), "ws://host:1/devtools/browser",
+               2);
+  ASSERT_EQ(2, dials);
+
+  std::unique_ptr<SyncWebSocket> first =
+      pool.Claim(GURL("ws://host:1/devtools/browser").spec());
+  ASSERT_TRUE(first);
+  ASSERT_TRUE(first->IsConnected());
+  ASSERT_TRUE(pool.Claim(GURL("ws://host:1/devtools/browser").spec()));
+  // The pool is drained; a third claim misses.
+  ASSERT_FALSE(pool.Claim(GURL("ws://host:1/devtools/browser").spec()));
+  // No additional dials happened on claim.
+  ASSERT_EQ(2, dials);
+}
+
+TEST(SyncWebSocketPool, PrewarmIsIdempotentPerUrl) {
+  SyncWebSocketPool pool;
+  int dials = 0;
+  SyncWebSocketFactory factory = MakeFactory(&dials, nullptr);
+  pool.Prewarm(factory, "ws://host:1/devtools/browser", 2);
+  pool.Prewarm(factory, "ws://host:1/devtools/browser", 2);
+  ASSERT_EQ(2, dials);
+}
+
+TEST(SyncWebSocketPool, ClaimMissesOtherUrls) {
+  SyncWebSocketPool pool;
+  int dials = 0;
+  pool.Prewarm(MakeFactory(&dials, nullptr), "ws://host:1/devtools/browser",
+               1);
+  ASSERT_FALSE(pool.Claim(GURL("ws://host:2/devtools/browser").spec()));
+  ASSERT_TRUE(pool.Claim(GURL("ws://host:1/devtools/browser").spec()));
+}
+
+TEST(SyncWebSocketPool, DropsStaleParkedSockets) {
+  SyncWebSocketPool pool;
+  int dials = 0;
+  FakePooledSocket* last = nullptr;
+  pool.Prewarm(MakeFactory(&dials, &last), "ws://host:1/devtools/browser", 1);
+  ASSERT_TRUE(last);
+  last->Disconnect();
+  // The parked socket went away behind the pool's back; the claim must not
+  // hand out a dead connection.
+  ASSERT_FALSE(pool.Claim(GURL("ws://host:1/devtools/browser").spec()));
+}
@@ -4,12 +4,30 @@
 
 #include "chrome/test/chromedriver/net/timeout.h"
 
+#include <stdint.h>
+
 #include <algorithm>
+#include <atomic>
 
 #include "base/logging.h"
 #include "base/notreached.h"
+#include "base/threading/platform_thread.h"
+
+namespace {
+
+constexpr base::TimeDelta kInitialWaitInterval =
+    base::TimeDelta::FromMicroseconds(500);
 
-Timeout::Timeout() : start_(base::TimeTicks::Now()) {
+// Virtual clock state; see Timeout::SwitchToVirtualClockForReplay. Atomics
+// rather than a lock because the offset is read on every GetRemainingTime
+// call and small races between concurrent advancements are harmless — both
+// advancements are applied, just in either order.
+std::atomic<bool> g_use_virtual_clock{false};
+std::atomic<int64_t> g_virtual_offset_us{0};
+
+}  // namespace
+
+Timeout::Timeout() : start_(Timeout::Now()) {
 }
 
 Timeout::Timeout(const base::TimeDelta& duration) : Timeout() {
@@ -44,6 +62,62 @@ base::TimeDelta Timeout::GetDuration() const {
 }
 
 base::TimeDelta Timeout::GetRemainingTime() const {
-  return !deadline_.is_null() ? deadline_ - base::TimeTicks::Now()
+  return !deadline_.is_null() ? deadline_ - Timeout::Now()
                               : base::TimeDelta::Max();
 }
+
+// static
+void Timeout::SwitchToVirtualClockForReplay() {
+  g_use_virtual_clock.store(true, std::memory_order_relaxed);
+}
+
+// static
+bool Timeout::UsesVirtualClock() {
+  return g_use_virtual_clock.load(std::memory_order_relaxed);
+}
+
+// static
+void Timeout::AdvanceVirtualClock(const base::TimeDelta& delta) {
+  g_virtual_offset_us.fetch_add(delta.InMicroseconds(),
+                                std::memory_order_relaxed);
+}
+
+// static
+base::TimeTicks Timeout::Now() {
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (UsesVirtualClock()) {
+    now += base::TimeDelta::FromMicroseconds(
+        g_virtual_offset_us.load(std::memory_order_relaxed));
+  }
+  return now;
+}
+
+// static
+void Timeout::ResetClockForTesting() {
+  g_use_virtual_clock.store(false, std::memory_order_relaxed);
+  g_virtual_offset_us.store(0, std::memory_order_relaxed);
+}
+
+AdaptiveWaiter::AdaptiveWaiter(const base::TimeDelta& max_interval)
+    : interval_(std::min(kInitialWaitInterval, max_interval)),
+      max_interval_(max_interval) {}
+
+void AdaptiveWaiter::Wait(const Timeout* timeout) {
+  base::TimeDelta sleep_time = interval_;
+  if (timeout && timeout->is_set())
+    sleep_time = std::min(sleep_time, timeout->GetRemainingTime());
+  if (sleep_time > base::TimeDelta()) {
+    // Under the replay virtual clock, waiting for something to happen in a
+    // browser that is not there only burns wall time; make the wait count
+    // against |timeout| without actually sleeping.
+    if (Timeout::UsesVirtualClock())
+      Timeout::AdvanceVirtualClock(sleep_time);
+    else
+      base::PlatformThread::Sleep(sleep_time);
+  }
+  interval_ = std::min(interval_ * 2, max_interval_);
+}
+
+void AdaptiveWaiter::Reset() {
+  interval_ = std::min(kInitialWaitInterval, max_interval_);
+}
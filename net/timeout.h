@@ -39,9 +39,57 @@ class Timeout {
   // TimeDelta::Max().
   base::TimeDelta GetRemainingTime() const;
 
+  // Switches every Timeout in the process to a virtual clock: the real
+  // clock plus an offset that grows whenever waiting code advances it.
+  // Used by log replay (--devtools-replay), where no real browser is on
+  // the other end, so waits recorded in the log need not pass in real
+  // time — AdaptiveWaiter::Wait then advances the clock instead of
+  // sleeping, which collapses recorded delays to zero while deadlines
+  // still expire in the recorded order. Not meant to be switched back
+  // outside of tests.
+  static void SwitchToVirtualClockForReplay();
+
+  // Whether SwitchToVirtualClockForReplay has been called.
+  static bool UsesVirtualClock();
+
+  // Moves the virtual clock forward by |delta|. Only meaningful after
+  // SwitchToVirtualClockForReplay.
+  static void AdvanceVirtualClock(const base::TimeDelta& delta);
+
+  // The current time as observed by Timeout instances: the real clock
+  // plus any virtual advancement.
+  static base::TimeTicks Now();
+
+  // Restores the real clock and discards any virtual advancement, so
+  // tests do not leak warped time into each other.
+  static void ResetClockForTesting();
+
  private:
   base::TimeTicks start_;
   base::TimeTicks deadline_;
 };
 
+// Paces the iterations of a poll loop governed by a Timeout. The first waits
+// are sub-millisecond, so conditions that become true almost immediately (the
+// common case) are observed with little added latency, while waits double on
+// each iteration up to |max_interval| to keep long polls cheap.
+class AdaptiveWaiter {
+ public:
+  explicit AdaptiveWaiter(const base::TimeDelta& max_interval);
+
+  // Sleeps for the current interval, clamped to the remaining time of
+  // |timeout| if one is set, then doubles the interval up to the maximum.
+  // Does not sleep at all if |timeout| has already expired. |timeout| may be
+  // nullptr when the caller tracks its deadline separately.
+  void Wait(const Timeout* timeout);
+
+  // Restores the initial sub-millisecond interval, for reuse across phases
+  // of a multi-stage wait.
+  void Reset();
+
+ private:
+  base::TimeDelta interval_;
+  const base::TimeDelta max_interval_;
+};
+
 #endif  // CHROME_TEST_CHROMEDRIVER_NET_TIMEOUT_H_
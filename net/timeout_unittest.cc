@@ -60,3 +60,47 @@ TEST(TimeoutTest, DeriveExpired) {
   EXPECT_TRUE(derived.IsExpired());
   EXPECT_GE(TimeDelta(), derived.GetDuration());
 }
+
+TEST(TimeoutTest, VirtualClockCollapsesWaits) {
+  Timeout::SwitchToVirtualClockForReplay();
+  Timeout timeout(TimeDelta::FromMinutes(10));
+  AdaptiveWaiter waiter(TimeDelta::FromMinutes(1));
+  base::TimeTicks real_start = base::TimeTicks::Now();
+  while (!timeout.IsExpired())
+    waiter.Wait(&timeout);
+  // Ten virtual minutes elapse without any real sleeping.
+  EXPECT_LT(base::TimeTicks::Now() - real_start, TimeDelta::FromSeconds(5));
+  Timeout::ResetClockForTesting();
+}
+
+TEST(TimeoutTest, VirtualClockExpiresDeadlinesInOrder) {
+  Timeout::SwitchToVirtualClockForReplay();
+  Timeout shorter(TimeDelta::FromSeconds(10));
+  Timeout longer(TimeDelta::FromSeconds(20));
+  Timeout::AdvanceVirtualClock(TimeDelta::FromSeconds(15));
+  EXPECT_TRUE(shorter.IsExpired());
+  EXPECT_FALSE(longer.IsExpired());
+  Timeout::ResetClockForTesting();
+}
+
+TEST(AdaptiveWaiterTest, DoesNotSleepPastExpiredTimeout) {
+  Timeout timeout((TimeDelta()));
+  ASSERT_TRUE(timeout.IsExpired());
+
+  AdaptiveWaiter waiter(TimeDelta::FromSeconds(10));
+  base::TimeTicks start = base::TimeTicks::Now();
+  waiter.Wait(&timeout);
+  // An expired timeout must not incur a full interval of sleep.
+  EXPECT_LT(base::TimeTicks::Now() - start, TimeDelta::FromSeconds(1));
+}
+
+TEST(AdaptiveWaiterTest, UnsetTimeoutWaitsCurrentInterval) {
+  // With an unset timeout there is nothing to clamp against, so Wait sleeps
+  // the (initially sub-millisecond) backoff interval and returns.
+  Timeout timeout;
+  AdaptiveWaiter waiter(TimeDelta::FromMilliseconds(1));
+  base::TimeTicks start = base::TimeTicks::Now();
+  waiter.Wait(&timeout);
+  waiter.Wait(nullptr);
+  EXPECT_LT(base::TimeTicks::Now() - start, TimeDelta::FromSeconds(1));
+}
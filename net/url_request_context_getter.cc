@@ -7,17 +7,54 @@
 #include <memory>
 #include <string>
 
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted.h"
 #include "base/single_thread_task_runner.h"
+#include "base/synchronization/lock.h"
 #include "chrome/test/chromedriver/constants/version.h"
 #include "net/proxy_resolution/proxy_config_service_fixed.h"
 #include "net/url_request/url_request_context.h"
 #include "net/url_request/url_request_context_builder.h"
 
+namespace {
+
+// Holds the process-wide shared getter; components acquire it from
+// arbitrary threads, hence the lock.
+struct SharedGetterHolder {
+  base::Lock lock;
+  scoped_refptr<URLRequestContextGetter> getter;
+};
+
+base::LazyInstance<SharedGetterHolder>::Leaky g_shared_getter =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
 URLRequestContextGetter::URLRequestContextGetter(
     scoped_refptr<base::SingleThreadTaskRunner> network_task_runner)
     : network_task_runner_(network_task_runner) {
 }
 
+// static
+scoped_refptr<URLRequestContextGetter>
+URLRequestContextGetter::GetSharedInstance(
+    scoped_refptr<base::SingleThreadTaskRunner> network_task_runner,
+    const std::string& component) {
+  SharedGetterHolder& holder = g_shared_getter.Get();
+  base::AutoLock lock(holder.lock);
+  if (!holder.getter) {
+    holder.getter =
+        base::MakeRefCounted<URLRequestContextGetter>(network_task_runner);
+  } else {
+    // One network thread per process; a second runner would mean a second
+    // context in disguise.
+    DCHECK(holder.getter->GetNetworkTaskRunner() == network_task_runner);
+  }
+  VLOG(1) << "shared URL request context acquired by " << component;
+  return holder.getter;
+}
+
 net::URLRequestContext* URLRequestContextGetter::GetURLRequestContext() {
   CHECK(network_task_runner_->BelongsToCurrentThread());
   if (!url_request_context_) {
@@ -6,6 +6,7 @@
 #define CHROME_TEST_CHROMEDRIVER_NET_URL_REQUEST_CONTEXT_GETTER_H_
 
 #include <memory>
+#include <string>
 
 #include "base/compiler_specific.h"
 #include "base/macros.h"
@@ -22,6 +23,15 @@ class URLRequestContextGetter : public net::URLRequestContextGetter {
   explicit URLRequestContextGetter(
       scoped_refptr<base::SingleThreadTaskRunner> network_task_runner);
 
+  // Returns the process-wide shared getter, creating it on first use with
+  // |network_task_runner|. Every component must draw from this one
+  // instance so the process runs a single resolver and socket pool and
+  // connections are reused across components; |component| is only logged,
+  // to attribute context usage in diagnostics. Thread safe.
+  static scoped_refptr<URLRequestContextGetter> GetSharedInstance(
+      scoped_refptr<base::SingleThreadTaskRunner> network_task_runner,
+      const std::string& component);
+
   // Overridden from net::URLRequestContextGetter:
   net::URLRequestContext* GetURLRequestContext() override;
   scoped_refptr<base::SingleThreadTaskRunner> GetNetworkTaskRunner()
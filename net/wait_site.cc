@@ -0,0 +1,33 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/net/wait_site.h"
+
+#include "base/lazy_instance.h"
+#include "base/threading/thread_local.h"
+
+namespace {
+
+base::LazyInstance<
+    base::ThreadLocalPointer<std::atomic<const char*>>>::Leaky
+    lazy_tls_wait_site_slot = LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+void SetWaitSiteSlotForCurrentThread(std::atomic<const char*>* slot) {
+  lazy_tls_wait_site_slot.Pointer()->Set(slot);
+}
+
+ScopedWaitSite::ScopedWaitSite(const char* site)
+    : slot_(lazy_tls_wait_site_slot.Pointer()->Get()), previous_(nullptr) {
+  if (!slot_)
+    return;
+  previous_ = slot_->load(std::memory_order_relaxed);
+  slot_->store(site, std::memory_order_release);
+}
+
+ScopedWaitSite::~ScopedWaitSite() {
+  if (slot_)
+    slot_->store(previous_, std::memory_order_release);
+}
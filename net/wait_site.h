@@ -0,0 +1,36 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_NET_WAIT_SITE_H_
+#define CHROME_TEST_CHROMEDRIVER_NET_WAIT_SITE_H_
+
+#include <atomic>
+
+// Aims the current thread's wait-site annotations at |slot|; pass null to
+// detach. The session layer points the slot at the session's stats block
+// for the duration of a command, so blocking waits anywhere below it can
+// publish where the thread is parked without depending on the session
+// layer themselves. The stall watchdog reads the slot from another thread
+// to attribute a wedged session; see SessionMetrics.
+void SetWaitSiteSlotForCurrentThread(std::atomic<const char*>* slot);
+
+// Publishes |site| as the current thread's innermost wait site for the
+// lifetime of the scope and restores the enclosing site on destruction,
+// so nested waits report the deepest one actually blocking. |site| must be
+// a string literal (it is read from other threads after the scope may have
+// moved on). No-op on threads with no registered slot.
+class ScopedWaitSite {
+ public:
+  explicit ScopedWaitSite(const char* site);
+  ~ScopedWaitSite();
+
+  ScopedWaitSite(const ScopedWaitSite&) = delete;
+  ScopedWaitSite& operator=(const ScopedWaitSite&) = delete;
+
+ private:
+  std::atomic<const char*>* slot_;
+  const char* previous_;
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_NET_WAIT_SITE_H_
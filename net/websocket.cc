@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -32,6 +33,8 @@
 #include "net/http/http_util.h"
 #include "net/log/net_log_source.h"
 #include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
+#include "net/websockets/websocket_extension.h"
+#include "net/websockets/websocket_extension_parser.h"
 #include "net/websockets/websocket_frame.h"
 
 #if defined(OS_WIN)
@@ -74,6 +77,10 @@ WebSocket::WebSocket(const GURL& url,
 
 WebSocket::~WebSocket() {
   CHECK(thread_checker_.CalledOnValidThread());
+  if (zlib_initialized_) {
+    deflateEnd(&deflate_stream_);
+    inflateEnd(&inflate_stream_);
+  }
 }
 
 void WebSocket::Connect(net::CompletionOnceCallback callback) {
@@ -125,14 +132,38 @@ void WebSocket::Connect(net::CompletionOnceCallback callback) {
 
 bool WebSocket::Send(const std::string& message) {
   VLOG(4) << "WebSocket::Send " << message;
+  return SendFrame(net::WebSocketFrameHeader::kOpCodeText, message);
+}
+
+bool WebSocket::SendPing() {
+  VLOG(4) << "WebSocket::SendPing";
+  return SendFrame(net::WebSocketFrameHeader::kOpCodePing, std::string());
+}
+
+bool WebSocket::SendFrame(net::WebSocketFrameHeader::OpCode op_code,
+                          const std::string& message) {
   CHECK(thread_checker_.CalledOnValidThread());
   if (state_ != OPEN)
     return false;
 
-  net::WebSocketFrameHeader header(net::WebSocketFrameHeader::kOpCodeText);
+  // Once compression is negotiated, every data message is sent compressed:
+  // selectively skipping a message would advance our deflate window past
+  // bytes the peer's inflater never saw, corrupting later back-references.
+  const std::string* payload = &message;
+  std::string compressed;
+  bool compress = compression_enabled_ &&
+                  op_code == net::WebSocketFrameHeader::kOpCodeText;
+  if (compress) {
+    if (!DeflateMessage(message, &compressed))
+      return false;
+    payload = &compressed;
+  }
+
+  net::WebSocketFrameHeader header(op_code);
   header.final = true;
   header.masked = true;
-  header.payload_length = message.length();
+  header.reserved1 = compress;
+  header.payload_length = payload->length();
   int header_size = net::GetWebSocketFrameHeaderSize(header);
   net::WebSocketMaskingKey masking_key = net::GenerateWebSocketMaskingKey();
   std::string header_str;
@@ -140,10 +171,21 @@ bool WebSocket::Send(const std::string& message) {
   CHECK_EQ(header_size, net::WriteWebSocketFrameHeader(
       header, &masking_key, &header_str[0], header_str.length()));
 
-  std::string masked_message = message;
-  net::MaskWebSocketFramePayload(
-      masking_key, 0, &masked_message[0], masked_message.length());
-  Write(header_str + masked_message);
+  // Append the header and payload straight into |pending_write_| and mask
+  // the payload in place there. net::MaskWebSocketFramePayload already works
+  // a machine word at a time, so for multi-MB payloads the cost was the
+  // masked copy and the header concatenation, not the masking arithmetic.
+  size_t payload_offset = pending_write_.size() + header_str.size();
+  pending_write_.reserve(payload_offset + payload->length());
+  pending_write_ += header_str;
+  pending_write_ += *payload;
+  if (!payload->empty()) {
+    net::MaskWebSocketFramePayload(masking_key, 0,
+                                   &pending_write_[payload_offset],
+                                   payload->length());
+  }
+  if (!write_buffer_->BytesRemaining())
+    ContinueWritingIfNecessary();
   return true;
 }
 
@@ -159,6 +201,13 @@ void WebSocket::OnSocketConnect(int code) {
   }
 
   base::Base64Encode(base::RandBytesAsString(16), &sec_key_);
+  std::string extensions_header;
+  if (ShouldOfferCompression()) {
+    offered_compression_ = true;
+    extensions_header =
+        "Sec-WebSocket-Extensions: permessage-deflate; "
+        "client_max_window_bits\r\n";
+  }
   std::string handshake = base::StringPrintf(
       "GET %s HTTP/1.1\r\n"
       "Host: %s\r\n"
@@ -166,12 +215,14 @@ void WebSocket::OnSocketConnect(int code) {
       "Connection: Upgrade\r\n"
       "Sec-WebSocket-Key: %s\r\n"
       "Sec-WebSocket-Version: 13\r\n"
+      "%s"
       "Pragma: no-cache\r\n"
       "Cache-Control: no-cache\r\n"
       "\r\n",
       url_.path().c_str(),
       url_.host().c_str(),
-      sec_key_.c_str());
+      sec_key_.c_str(),
+      extensions_header.c_str());
   VLOG(4) << "WebSocket::OnSocketConnect handshake\n" << handshake;
   Write(handshake);
   if (state_ == CLOSED) {
@@ -279,6 +330,14 @@ void WebSocket::OnReadDuringHandshake(const char* data, int len) {
     Close(net::ERR_FAILED);
     return;
   }
+  if (offered_compression_) {
+    std::string extensions;
+    if (headers->GetNormalizedHeader("Sec-WebSocket-Extensions", &extensions) &&
+        !ConfigureCompression(extensions)) {
+      Close(net::ERR_FAILED);
+      return;
+    }
+  }
   std::string leftover_message = handshake_response_.substr(headers_end);
   handshake_response_.clear();
   sec_key_.clear();
@@ -297,26 +356,178 @@ void WebSocket::OnReadDuringOpen(const char* data, int len) {
       DCHECK_EQ(0u, current_frame_offset_);
       is_current_frame_masked_ = header->masked;
       current_masking_key_ = header->masking_key;
+      // Continuation frames belong to the message whose first frame carried
+      // the opcode; every other frame (including controls) brings its own.
+      if (header->opcode != net::WebSocketFrameHeader::kOpCodeContinuation) {
+        current_frame_op_code_ = header->opcode;
+        // RSV1 on the first frame of a data message marks the whole message
+        // as permessage-deflate compressed.
+        if (!net::WebSocketFrameHeader::IsKnownControlOpCode(header->opcode))
+          is_current_message_compressed_ = header->reserved1;
+      }
     }
 
-    auto& buffer = frame_chunks[i]->payload;
-    std::vector<char> payload(buffer.begin(), buffer.end());
-    if (is_current_frame_masked_) {
+    // Control frames (ping/pong/close) are assembled separately so they do
+    // not corrupt a data message; data frames append directly into the
+    // message under assembly and are unmasked in place, rather than
+    // unmasking in a scratch copy first.
+    std::string* assembly =
+        net::WebSocketFrameHeader::IsKnownControlOpCode(current_frame_op_code_)
+            ? &control_payload_
+            : &next_message_;
+    const auto& buffer = frame_chunks[i]->payload;
+    size_t chunk_offset = assembly->size();
+    assembly->append(buffer.begin(), buffer.end());
+    if (is_current_frame_masked_ && !buffer.empty()) {
       MaskWebSocketFramePayload(current_masking_key_, current_frame_offset_,
-                                payload.data(), payload.size());
+                                &(*assembly)[chunk_offset], buffer.size());
     }
-    next_message_ += std::string(payload.data(), payload.size());
-    current_frame_offset_ += payload.size();
+    current_frame_offset_ += buffer.size();
 
     if (frame_chunks[i]->final_chunk) {
-      VLOG(4) << "WebSocket::OnReadDuringOpen " << next_message_;
-      listener_->OnMessageReceived(next_message_);
-      next_message_.clear();
       current_frame_offset_ = 0;
+      switch (current_frame_op_code_) {
+        case net::WebSocketFrameHeader::kOpCodePing:
+          // Answer the peer's keepalive probe in kind, echoing the payload.
+          SendFrame(net::WebSocketFrameHeader::kOpCodePong, control_payload_);
+          control_payload_.clear();
+          break;
+        case net::WebSocketFrameHeader::kOpCodePong:
+          control_payload_.clear();
+          listener_->OnPong();
+          break;
+        case net::WebSocketFrameHeader::kOpCodeClose:
+          control_payload_.clear();
+          Close(net::ERR_CONNECTION_CLOSED);
+          return;
+        default:
+          if (is_current_message_compressed_) {
+            std::string decompressed;
+            if (!compression_enabled_ ||
+                !InflateMessage(next_message_, &decompressed)) {
+              Close(net::ERR_FAILED);
+              return;
+            }
+            next_message_ = std::move(decompressed);
+            is_current_message_compressed_ = false;
+          }
+          VLOG(4) << "WebSocket::OnReadDuringOpen " << next_message_;
+          listener_->OnMessageReceived(std::move(next_message_));
+          next_message_.clear();
+          break;
+      }
     }
   }
 }
 
+bool WebSocket::ShouldOfferCompression() const {
+  if (url_.host() == "localhost")
+    return false;
+  net::IPAddress address;
+  if (ParseURLHostnameToAddress(url_.host(), &address))
+    return !address.IsLoopback();
+  // A host name that isn't a loopback literal; assume remote.
+  return true;
+}
+
+bool WebSocket::ConfigureCompression(const std::string& header_value) {
+  net::WebSocketExtensionParser parser;
+  if (!parser.Parse(header_value))
+    return false;
+  if (parser.extensions().empty())
+    return true;  // Server declined; stay uncompressed.
+  if (parser.extensions().size() > 1)
+    return false;
+
+  const net::WebSocketExtension& extension = parser.extensions()[0];
+  if (extension.name() != "permessage-deflate")
+    return false;
+
+  int deflate_window_bits = 15;
+  bool reset_per_message = false;
+  for (const auto& param : extension.parameters()) {
+    if (param.name() == "server_no_context_takeover" ||
+        param.name() == "server_max_window_bits") {
+      // Only constrains the server's compressor; our 15-bit inflate window
+      // accepts streams from any smaller window, persistent or not.
+    } else if (param.name() == "client_no_context_takeover") {
+      reset_per_message = true;
+    } else if (param.name() == "client_max_window_bits") {
+      if (param.HasValue()) {
+        int bits = 0;
+        if (!base::StringToInt(param.value(), &bits) || bits < 8 || bits > 15)
+          return false;
+        // zlib cannot emit a raw 8-bit window; 9 produces a strict subset.
+        deflate_window_bits = std::max(bits, 9);
+      }
+    } else {
+      return false;
+    }
+  }
+  return InitCompression(deflate_window_bits, reset_per_message);
+}
+
+bool WebSocket::InitCompression(int deflate_window_bits,
+                                bool reset_per_message) {
+  memset(&deflate_stream_, 0, sizeof(deflate_stream_));
+  memset(&inflate_stream_, 0, sizeof(inflate_stream_));
+  if (deflateInit2(&deflate_stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                   -deflate_window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  if (inflateInit2(&inflate_stream_, -15) != Z_OK) {
+    deflateEnd(&deflate_stream_);
+    return false;
+  }
+  zlib_initialized_ = true;
+  compress_reset_per_message_ = reset_per_message;
+  compression_enabled_ = true;
+  return true;
+}
+
+bool WebSocket::DeflateMessage(const std::string& message,
+                               std::string* compressed) {
+  if (compress_reset_per_message_)
+    deflateReset(&deflate_stream_);
+  deflate_stream_.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(message.data()));
+  deflate_stream_.avail_in = message.length();
+  char buffer[4096];
+  do {
+    deflate_stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+    deflate_stream_.avail_out = sizeof(buffer);
+    int result = deflate(&deflate_stream_, Z_SYNC_FLUSH);
+    if (result != Z_OK && result != Z_BUF_ERROR)
+      return false;
+    compressed->append(buffer, sizeof(buffer) - deflate_stream_.avail_out);
+  } while (deflate_stream_.avail_out == 0);
+  // Strip the 0x00 0x00 0xff 0xff that Z_SYNC_FLUSH ends on; the receiver
+  // restores it before inflating (RFC 7692 section 7.2.1).
+  if (compressed->length() < 4)
+    return false;
+  compressed->resize(compressed->length() - 4);
+  return true;
+}
+
+bool WebSocket::InflateMessage(const std::string& message,
+                               std::string* decompressed) {
+  std::string input = message;
+  input.append("\x00\x00\xff\xff", 4);
+  inflate_stream_.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  inflate_stream_.avail_in = input.length();
+  char buffer[4096];
+  do {
+    inflate_stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+    inflate_stream_.avail_out = sizeof(buffer);
+    int result = inflate(&inflate_stream_, Z_SYNC_FLUSH);
+    if (result != Z_OK && result != Z_BUF_ERROR)
+      return false;
+    decompressed->append(buffer, sizeof(buffer) - inflate_stream_.avail_out);
+  } while (inflate_stream_.avail_out == 0);
+  return inflate_stream_.avail_in == 0;
+}
+
 void WebSocket::InvokeConnectCallback(int code) {
   CHECK(!connect_callback_.is_null());
   std::move(connect_callback_).Run(code);
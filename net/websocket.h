@@ -15,6 +15,7 @@
 #include "net/socket/tcp_client_socket.h"
 #include "net/websockets/websocket_frame.h"
 #include "net/websockets/websocket_frame_parser.h"
+#include "third_party/zlib/zlib.h"
 #include "url/gurl.h"
 
 namespace net {
@@ -41,6 +42,10 @@ class WebSocket {
   // Sends the given message and returns true on success.
   bool Send(const std::string& message);
 
+  // Sends a WebSocket ping frame and returns true on success. The peer's
+  // pong is reported through WebSocketListener::OnPong.
+  bool SendPing();
+
  private:
   enum State {
     INITIALIZED,
@@ -49,6 +54,9 @@ class WebSocket {
     CLOSED
   };
 
+  bool SendFrame(net::WebSocketFrameHeader::OpCode op_code,
+                 const std::string& message);
+
   void OnSocketConnect(int code);
 
   void Write(const std::string& data);
@@ -63,6 +71,19 @@ class WebSocket {
   void InvokeConnectCallback(int code);
   void Close(int code);
 
+  // permessage-deflate (RFC 7692). Compression is offered only for
+  // non-loopback endpoints: DevTools JSON is highly compressible and the
+  // ~5x size cut matters on WAN links, while on loopback it is pure CPU
+  // overhead.
+  bool ShouldOfferCompression() const;
+  // Applies the server's Sec-WebSocket-Extensions response |header_value|.
+  // Returns false if the response is malformed or demands something
+  // unsupported, which fails the handshake.
+  bool ConfigureCompression(const std::string& header_value);
+  bool InitCompression(int deflate_window_bits, bool reset_per_message);
+  bool DeflateMessage(const std::string& message, std::string* compressed);
+  bool InflateMessage(const std::string& message, std::string* decompressed);
+
   base::ThreadChecker thread_checker_;
 
   GURL url_;
@@ -82,7 +103,23 @@ class WebSocket {
   net::WebSocketMaskingKey current_masking_key_ = {};
   bool is_current_frame_masked_ = false;
   uint64_t current_frame_offset_ = 0;
+  net::WebSocketFrameHeader::OpCode current_frame_op_code_ =
+      net::WebSocketFrameHeader::kOpCodeText;
   std::string next_message_;
+  // Payload of the control frame being assembled; control frames carry
+  // their own header, so they do not disturb |next_message_|.
+  std::string control_payload_;
+
+  // The zlib streams live for the whole connection, so back-references can
+  // reach into earlier messages (the shared sliding window); that is where
+  // most of the win on repetitive DevTools JSON comes from.
+  bool offered_compression_ = false;
+  bool compression_enabled_ = false;
+  bool compress_reset_per_message_ = false;
+  bool zlib_initialized_ = false;
+  bool is_current_message_compressed_ = false;
+  z_stream deflate_stream_;
+  z_stream inflate_stream_;
 
   DISALLOW_COPY_AND_ASSIGN(WebSocket);
 };
@@ -93,13 +130,19 @@ class WebSocketListener {
  public:
   virtual ~WebSocketListener() {}
 
-  // Called when a WebSocket message is received.
-  virtual void OnMessageReceived(const std::string& message) = 0;
+  // Called when a WebSocket message is received. The message buffer is
+  // handed off by value so each stage of the pipeline can move it onward
+  // instead of copying.
+  virtual void OnMessageReceived(std::string message) = 0;
 
   // Called when the WebSocket connection closes. Will be called at most once.
   // Will not be called if the connection was never established or if the close
   // was initiated by the client.
   virtual void OnClose() = 0;
+
+  // Called when a pong frame is received. Default is to ignore it; only
+  // listeners that send pings care.
+  virtual void OnPong() {}
 };
 
 #endif  // CHROME_TEST_CHROMEDRIVER_NET_WEBSOCKET_H_
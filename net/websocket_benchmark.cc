@@ -0,0 +1,76 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "chrome/test/chromedriver/benchmark_util.h"
+#include "net/websockets/websocket_frame.h"
+#include "net/websockets/websocket_frame_parser.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kRuns = 20000;
+
+// Builds an unmasked server-to-client text frame carrying |payload_size|
+// bytes, the shape WebSocket::OnReadDuringOpen() receives from DevTools.
+std::string BuildTextFrame(size_t payload_size) {
+  std::string frame;
+  frame.push_back(static_cast<char>(0x81));  // FIN + text opcode.
+  if (payload_size < 126) {
+    frame.push_back(static_cast<char>(payload_size));
+  } else if (payload_size <= 0xffff) {
+    frame.push_back(static_cast<char>(126));
+    frame.push_back(static_cast<char>((payload_size >> 8) & 0xff));
+    frame.push_back(static_cast<char>(payload_size & 0xff));
+  } else {
+    frame.push_back(static_cast<char>(127));
+    for (int shift = 56; shift >= 0; shift -= 8)
+      frame.push_back(static_cast<char>((payload_size >> shift) & 0xff));
+  }
+  frame.append(payload_size, 'x');
+  return frame;
+}
+
+// Mirrors the decode-and-assemble loop in WebSocket::OnReadDuringOpen():
+// parse the wire bytes into frame chunks and append each chunk's payload
+// to the message under assembly. The parser is constructed per run, as
+// each benchmark iteration stands in for one read off the socket.
+void DecodeFrame(const std::string& frame) {
+  net::WebSocketFrameParser parser;
+  std::vector<std::unique_ptr<net::WebSocketFrameChunk>> frame_chunks;
+  ASSERT_TRUE(parser.Decode(frame.data(), frame.size(), &frame_chunks));
+  std::string message;
+  for (size_t i = 0; i < frame_chunks.size(); ++i) {
+    const auto& buffer = frame_chunks[i]->payload;
+    message.append(buffer.begin(), buffer.end());
+  }
+  ASSERT_FALSE(message.empty());
+}
+
+}  // namespace
+
+TEST(WebSocketFrameDecodeBenchmark, SmallFrame) {
+  benchmark::RunAndReport("ChromeDriver.WebSocketFrameDecode", "small_frame",
+                          kRuns,
+                          base::BindRepeating(&DecodeFrame,
+                                              BuildTextFrame(128)));
+}
+
+TEST(WebSocketFrameDecodeBenchmark, MediumFrame) {
+  benchmark::RunAndReport("ChromeDriver.WebSocketFrameDecode", "medium_frame",
+                          kRuns,
+                          base::BindRepeating(&DecodeFrame,
+                                              BuildTextFrame(16 * 1024)));
+}
+
+TEST(WebSocketFrameDecodeBenchmark, LargeFrame) {
+  benchmark::RunAndReport("ChromeDriver.WebSocketFrameDecode", "large_frame",
+                          kRuns / 20,
+                          base::BindRepeating(&DecodeFrame,
+                                              BuildTextFrame(1024 * 1024)));
+}
@@ -37,7 +37,7 @@ class Listener : public WebSocketListener {
 
   ~Listener() override { EXPECT_TRUE(messages_.empty()); }
 
-  void OnMessageReceived(const std::string& message) override {
+  void OnMessageReceived(std::string message) override {
     ASSERT_TRUE(messages_.size());
     EXPECT_EQ(messages_[0], message);
     messages_.erase(messages_.begin());
@@ -57,7 +57,7 @@ class CloseListener : public WebSocketListener {
 
   ~CloseListener() override { EXPECT_FALSE(run_loop_); }
 
-  void OnMessageReceived(const std::string& message) override {}
+  void OnMessageReceived(std::string message) override {}
 
   void OnClose() override {
     EXPECT_TRUE(run_loop_);
@@ -168,6 +168,16 @@ TEST_F(WebSocketTest, CloseOnReceive) {
   run_loop.Run();
 }
 
+TEST_F(WebSocketTest, SendPingRequiresOpenConnection) {
+  CloseListener listener(nullptr);
+  WebSocket unconnected(GURL("ws://127.0.0.1:2222"), &listener);
+  ASSERT_FALSE(unconnected.SendPing());
+
+  std::unique_ptr<WebSocket> sock(CreateConnectedWebSocket(&listener));
+  ASSERT_TRUE(sock);
+  ASSERT_TRUE(sock->SendPing());
+}
+
 TEST_F(WebSocketTest, CloseOnSend) {
   base::RunLoop run_loop;
   CloseListener listener(&run_loop);
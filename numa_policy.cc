@@ -0,0 +1,143 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/numa_policy.h"
+
+#include <stddef.h>
+
+#include <utility>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
+#include "build/build_config.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include <sched.h>
+#endif
+
+namespace {
+
+// CPUs of each NUMA node, read once by InitNumaPolicy. Null while the policy
+// is disabled, which makes every other entry point a no-op.
+std::vector<std::vector<int>>* g_node_cpus = nullptr;
+
+// Next node to hand out. Sessions are created on the main thread, so no
+// synchronization is needed.
+size_t g_next_node = 0;
+
+// The node the current thread was pinned to; carried from the session
+// thread's first task to the browser launch running on the same thread.
+thread_local int tls_numa_node = -1;
+
+// Reads the CPU set of every NUMA node from sysfs. Returns an empty vector
+// on hosts where the topology is unavailable.
+std::vector<std::vector<int>> ReadNodeTopology() {
+  std::vector<std::vector<int>> nodes;
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  for (int node = 0;; ++node) {
+    std::string cpu_list;
+    if (!base::ReadFileToString(
+            base::FilePath(base::StringPrintf(
+                "/sys/devices/system/node/node%d/cpulist", node)),
+            &cpu_list)) {
+      break;
+    }
+    std::vector<int> cpus;
+    if (!internal::ParseCpuList(cpu_list, &cpus))
+      return std::vector<std::vector<int>>();
+    nodes.push_back(std::move(cpus));
+  }
+#endif
+  return nodes;
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+// |pid| of 0 addresses the calling thread.
+bool SetCpuAffinity(pid_t pid, const std::vector<int>& cpus) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus)
+    CPU_SET(cpu, &cpu_set);
+  return sched_setaffinity(pid, sizeof(cpu_set), &cpu_set) == 0;
+}
+#endif
+
+}  // namespace
+
+bool InitNumaPolicy(const std::string& policy) {
+  if (policy == "none")
+    return true;
+  if (policy != "round-robin")
+    return false;
+  std::vector<std::vector<int>> nodes = ReadNodeTopology();
+  // A single node offers nothing to balance across.
+  if (nodes.size() < 2)
+    return true;
+  g_node_cpus = new std::vector<std::vector<int>>(std::move(nodes));
+  return true;
+}
+
+int AssignNumaNode() {
+  if (!g_node_cpus)
+    return -1;
+  int node = static_cast<int>(g_next_node);
+  g_next_node = (g_next_node + 1) % g_node_cpus->size();
+  return node;
+}
+
+void PinCurrentThreadToNumaNode(int node) {
+  if (!g_node_cpus || node < 0)
+    return;
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  if (SetCpuAffinity(0, (*g_node_cpus)[node]))
+    tls_numa_node = node;
+#endif
+}
+
+void PinProcessToNumaNode(base::ProcessId pid, int node) {
+  if (!g_node_cpus || node < 0)
+    return;
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  // Affinity is inherited across fork, so the renderer and GPU children the
+  // browser spawns stay on the node too; their memory follows by first
+  // touch. Failure just leaves the browser where the scheduler put it.
+  SetCpuAffinity(pid, (*g_node_cpus)[node]);
+#endif
+}
+
+int CurrentThreadNumaNode() {
+  return tls_numa_node;
+}
+
+namespace internal {
+
+bool ParseCpuList(const std::string& cpu_list, std::vector<int>* cpus) {
+  for (const std::string& token : base::SplitString(
+           cpu_list, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    std::vector<std::string> bounds = base::SplitString(
+        token, "-", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
+    int low;
+    int high;
+    if (bounds.size() == 1) {
+      if (!base::StringToInt(bounds[0], &low))
+        return false;
+      high = low;
+    } else if (bounds.size() == 2) {
+      if (!base::StringToInt(bounds[0], &low) ||
+          !base::StringToInt(bounds[1], &high) || high < low) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+    for (int cpu = low; cpu <= high; ++cpu)
+      cpus->push_back(cpu);
+  }
+  return !cpus->empty();
+}
+
+}  // namespace internal
@@ -0,0 +1,52 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_NUMA_POLICY_H_
+#define CHROME_TEST_CHROMEDRIVER_NUMA_POLICY_H_
+
+#include <string>
+#include <vector>
+
+#include "base/process/process_handle.h"
+
+// NUMA-aware placement of session threads and the browsers they launch. On
+// a multi-socket host a session whose thread and browser sit on different
+// nodes pays interconnect latency on every DevTools message; the round-robin
+// policy keeps each session's work on one node and spreads sessions across
+// nodes. Nothing here has any effect until --numa-policy selects a policy;
+// by default placement is left to the OS scheduler.
+
+// Initializes the policy; called once at startup before any session exists.
+// |policy| is "none" or "round-robin". Returns false for an unknown policy
+// name. With "round-robin" on a host whose NUMA topology cannot be read, or
+// that has only one node, the policy silently stays disabled.
+bool InitNumaPolicy(const std::string& policy);
+
+// Returns the node the next session should run on, advancing the round-robin
+// cursor, or -1 when the policy is disabled. Called on the main thread.
+int AssignNumaNode();
+
+// Restricts the calling thread to the CPUs of |node| and remembers the node
+// for CurrentThreadNumaNode(). No-op when |node| is -1 or pinning fails.
+void PinCurrentThreadToNumaNode(int node);
+
+// Restricts |pid|, and the children it forks, to the CPUs of |node|. Memory
+// lands on the same node by first touch once the CPUs are confined. No-op
+// when |node| is -1.
+void PinProcessToNumaNode(base::ProcessId pid, int node);
+
+// Returns the node the calling thread was pinned to, or -1. This is how the
+// browser launcher, which runs on the session thread, learns the session's
+// node without the node being plumbed through the launch call chain.
+int CurrentThreadNumaNode();
+
+namespace internal {
+
+// Parses a sysfs cpulist string such as "0-3,8-11" into CPU numbers.
+// Exposed for testing.
+bool ParseCpuList(const std::string& cpu_list, std::vector<int>* cpus);
+
+}  // namespace internal
+
+#endif  // CHROME_TEST_CHROMEDRIVER_NUMA_POLICY_H_
@@ -0,0 +1,30 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/numa_policy.h"
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+TEST(NumaPolicyTest, ParseCpuListRangesAndSingles) {
+  // Mixed ranges and single CPUs, with the trailing newline sysfs appends.
+  std::vector<int> cpus;
+  ASSERT_TRUE(internal::ParseCpuList("0-2,5,8-9\n", &cpus));
+  ASSERT_EQ(std::vector<int>({0, 1, 2, 5, 8, 9}), cpus);
+}
+
+TEST(NumaPolicyTest, ParseCpuListSingleCpu) {
+  std::vector<int> cpus;
+  ASSERT_TRUE(internal::ParseCpuList("0\n", &cpus));
+  ASSERT_EQ(std::vector<int>({0}), cpus);
+}
+
+TEST(NumaPolicyTest, ParseCpuListMalformed) {
+  std::vector<int> cpus;
+  ASSERT_FALSE(internal::ParseCpuList("", &cpus));
+  ASSERT_FALSE(internal::ParseCpuList("x", &cpus));
+  ASSERT_FALSE(internal::ParseCpuList("3-1", &cpus));
+  ASSERT_FALSE(internal::ParseCpuList("1-2-3", &cpus));
+}
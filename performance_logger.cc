@@ -75,7 +75,10 @@ PerformanceLogger::PerformanceLogger(Log* log, const Session* session)
       session_(session),
       browser_client_(nullptr),
       trace_buffering_(false),
-      enable_service_worker_(false) {}
+      enable_service_worker_(false),
+      inspector_event_count_(0),
+      captured_bytes_(0),
+      capture_disabled_(false) {}
 
 PerformanceLogger::PerformanceLogger(Log* log,
                                      const Session* session,
@@ -86,7 +89,10 @@ PerformanceLogger::PerformanceLogger(Log* log,
       prefs_(prefs),
       browser_client_(nullptr),
       trace_buffering_(false),
-      enable_service_worker_(enable_service_worker) {}
+      enable_service_worker_(enable_service_worker),
+      inspector_event_count_(0),
+      captured_bytes_(0),
+      capture_disabled_(false) {}
 
 bool PerformanceLogger::subscribes_to_browser() {
   return true;
@@ -163,6 +169,7 @@ void PerformanceLogger::AddLogEntry(
   log_message_dict.SetPath({"message", "params"}, params.Clone());
   std::string log_message_json;
   base::JSONWriter::Write(log_message_dict, &log_message_json);
+  captured_bytes_ += log_message_json.size();
 
   // TODO(klm): extract timestamp from params?
   // Look at where it is for Page, Network, and trace events.
@@ -201,6 +208,16 @@ Status PerformanceLogger::HandleInspectorEvents(
   if (!ShouldLogEvent(method))
     return Status(kOk);
 
+  // When sampling, the interval applies to loggable events across all
+  // targets, so fleet monitoring gets an even 1-in-N slice of the session.
+  inspector_event_count_++;
+  if (prefs_.event_sampling_interval > 1 &&
+      inspector_event_count_ % prefs_.event_sampling_interval != 0)
+    return Status(kOk);
+
+  if (CaptureBudgetExhausted())
+    return Status(kOk);
+
   AddLogEntry(client->GetId(), method, params);
   return Status(kOk);
 }
@@ -219,6 +236,9 @@ Status PerformanceLogger::HandleTraceEvents(
       return Status(kUnknownError,
                     "received DevTools trace data in unexpected format");
     }
+    // The budget is approximate, so checking once per batch is enough.
+    if (CaptureBudgetExhausted())
+      return Status(kOk);
     for (const auto& trace : *traces) {
       const base::DictionaryValue* event_dict;
       if (!trace.GetAsDictionary(&event_dict))
@@ -250,6 +270,25 @@ Status PerformanceLogger::HandleTraceEvents(
   return Status(kOk);
 }
 
+bool PerformanceLogger::CaptureBudgetExhausted() {
+  if (prefs_.capture_byte_limit <= 0)
+    return false;
+  if (capture_disabled_)
+    return true;
+  if (captured_bytes_ < prefs_.capture_byte_limit)
+    return false;
+  capture_disabled_ = true;
+  base::DictionaryValue params;
+  std::string err("performance log capture byte limit exhausted, "
+                  "so further events for this session will be dropped");
+  params.SetString("error", err);
+  // Expose error to client via perf log using same format as other entries.
+  AddLogEntry(Log::kWarning, DevToolsClientImpl::kBrowserwideDevToolsClientId,
+              "PerformanceLogger.captureDisabled", params);
+  LOG(WARNING) << err;
+  return true;
+}
+
 Status PerformanceLogger::StartTrace() {
   if (!browser_client_) {
     return Status(kUnknownError, "tried to start tracing, but connection to "
@@ -297,9 +336,12 @@ Status PerformanceLogger::CollectTraceEvents() {
   }
 
   // Block up to 30 seconds until Tracing.tracingComplete event is received.
+  // Only Tracing events can finish the wait, so data-collection events from
+  // other domains skip the condition check.
   status = browser_client_->HandleEventsUntil(
       base::BindRepeating(&PerformanceLogger::IsTraceDone,
                           base::Unretained(this)),
+      std::vector<std::string>({"Tracing."}),
       Timeout(base::TimeDelta::FromSeconds(30)));
   if (status.IsError())
     return status;
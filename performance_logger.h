@@ -5,6 +5,8 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_PERFORMANCE_LOGGER_H_
 #define CHROME_TEST_CHROMEDRIVER_PERFORMANCE_LOGGER_H_
 
+#include <stdint.h>
+
 #include <string>
 
 #include "base/compiler_specific.h"
@@ -77,6 +79,10 @@ class PerformanceLogger : public DevToolsEventListener, public CommandListener {
                            const std::string& method,
                            const base::DictionaryValue& params);
 
+  // Returns true once |prefs_.capture_byte_limit| is exhausted, adding one
+  // warning entry on the transition so the truncation is visible in the log.
+  bool CaptureBudgetExhausted();
+
   bool ShouldReportTracingError();
   Status StartTrace();  // Must not call before browser-wide client connects.
   Status CollectTraceEvents();  // Ditto.
@@ -88,6 +94,9 @@ class PerformanceLogger : public DevToolsEventListener, public CommandListener {
   DevToolsClient* browser_client_; // Pointer to browser-wide |DevToolsClient|.
   bool trace_buffering_;  // True unless trace stopped and all events received.
   bool enable_service_worker_;
+  int inspector_event_count_;  // Loggable Network/Page events seen so far.
+  int64_t captured_bytes_;  // Bytes of formatted entries added to the log.
+  bool capture_disabled_;  // True once the byte budget has been exhausted.
 
   DISALLOW_COPY_AND_ASSIGN(PerformanceLogger);
 };
@@ -254,6 +254,53 @@ TEST(PerformanceLogger, PerfLoggingPrefs) {
   ASSERT_FALSE(client.PopSentCommand(&cmd));
 }
 
+TEST(PerformanceLogger, EventSampling) {
+  FakeDevToolsClient client("webview-1");
+  FakeLog log;
+  Session session("test");
+  PerfLoggingPrefs prefs;
+  prefs.event_sampling_interval = 2;
+  PerformanceLogger logger(&log, &session, prefs);
+
+  client.AddListener(&logger);
+  logger.OnConnected(&client);
+  ExpectEnableDomains(&client);
+  ASSERT_EQ(kOk, client.TriggerEvent("Network.one").code());
+  ASSERT_EQ(kOk, client.TriggerEvent("Network.two").code());
+  ASSERT_EQ(kOk, client.TriggerEvent("Page.three").code());
+  ASSERT_EQ(kOk, client.TriggerEvent("Page.four").code());
+
+  // Every 2nd loggable event is kept.
+  ASSERT_EQ(2u, log.GetEntries().size());
+  ValidateLogEntry(log.GetEntries()[0].get(), "webview-1", "Network.two");
+  ValidateLogEntry(log.GetEntries()[1].get(), "webview-1", "Page.four");
+}
+
+TEST(PerformanceLogger, CaptureByteLimit) {
+  FakeDevToolsClient client("webview-1");
+  FakeLog log;
+  Session session("test");
+  PerfLoggingPrefs prefs;
+  prefs.capture_byte_limit = 1;
+  PerformanceLogger logger(&log, &session, prefs);
+
+  client.AddListener(&logger);
+  logger.OnConnected(&client);
+  ExpectEnableDomains(&client);
+  // The first event fits in the budget; the second exhausts it and is
+  // replaced by a single warning entry; the third is dropped silently.
+  ASSERT_EQ(kOk, client.TriggerEvent("Network.one").code());
+  ASSERT_EQ(kOk, client.TriggerEvent("Network.two").code());
+  ASSERT_EQ(kOk, client.TriggerEvent("Network.three").code());
+
+  ASSERT_EQ(2u, log.GetEntries().size());
+  ValidateLogEntry(log.GetEntries()[0].get(), "webview-1", "Network.one");
+  EXPECT_EQ(Log::kWarning, log.GetEntries()[1]->level);
+  EXPECT_NE(std::string::npos,
+            log.GetEntries()[1]->message.find(
+                "PerformanceLogger.captureDisabled"));
+}
+
 namespace {
 
 class FakeBrowserwideClient : public FakeDevToolsClient {
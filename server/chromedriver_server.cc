@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <deque>
 #include <locale>
 #include <memory>
 #include <string>
@@ -22,6 +23,8 @@
 #include "base/json/json_reader.h"
 #include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
 #include "base/message_loop/message_pump_type.h"
 #include "base/run_loop.h"
 #include "base/single_thread_task_runner.h"
@@ -29,6 +32,7 @@
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/task/single_thread_task_executor.h"
 #include "base/task/thread_pool/thread_pool_instance.h"
@@ -37,10 +41,15 @@
 #include "base/threading/thread_task_runner_handle.h"
 #include "build/build_config.h"
 #include "build/chromeos_buildflags.h"
+#include "chrome/test/chromedriver/browser_pool.h"
+#include "chrome/test/chromedriver/chrome/allocation_tracker.h"
 #include "chrome/test/chromedriver/constants/version.h"
 #include "chrome/test/chromedriver/logging.h"
+#include "chrome/test/chromedriver/numa_policy.h"
 #include "chrome/test/chromedriver/server/http_handler.h"
 #include "chrome/test/chromedriver/server/http_server.h"
+#include "chrome/test/chromedriver/session_metrics.h"
+#include "chrome/test/chromedriver/session_thread_map.h"
 #include "mojo/core/embedder/embedder.h"
 #include "net/base/ip_address.h"
 #include "net/base/ip_endpoint.h"
@@ -72,17 +81,108 @@ void EnsureSharedMemory(base::CommandLine* cmd_line) {
 }
 #endif
 
+// Two-level response-write queue, one per IO thread. Writes are FIFO within
+// a class, but a queued response for an interactive session is always
+// written before any queued response for a bulk session (one that set the
+// "priority" chrome option to "batch"), so a bulk session draining large
+// payloads cannot delay an interactive session's responses on a shared IO
+// thread. Ref-counted because the cmd thread enqueues while the owning IO
+// thread drains.
+class ResponseWriteQueue
+    : public base::RefCountedThreadSafe<ResponseWriteQueue> {
+ public:
+  explicit ResponseWriteQueue(
+      scoped_refptr<base::SingleThreadTaskRunner> io_task_runner)
+      : io_task_runner_(std::move(io_task_runner)) {}
+
+  // Queues |write_func| and schedules a drain step on the owning IO thread.
+  // Called on the cmd thread.
+  void Enqueue(bool low_priority, base::OnceClosure write_func) {
+    {
+      base::AutoLock lock(lock_);
+      if (low_priority)
+        bulk_writes_.push_back(std::move(write_func));
+      else
+        interactive_writes_.push_back(std::move(write_func));
+    }
+    io_task_runner_->PostTask(
+        FROM_HERE, base::BindOnce(&ResponseWriteQueue::WriteOne, this));
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<ResponseWriteQueue>;
+  ~ResponseWriteQueue() = default;
+
+  // Writes the oldest queued interactive response, falling back to the
+  // oldest bulk response. Runs on the IO thread exactly once per Enqueue,
+  // so both levels drain fully.
+  void WriteOne() {
+    base::OnceClosure write_func;
+    {
+      base::AutoLock lock(lock_);
+      if (!interactive_writes_.empty()) {
+        write_func = std::move(interactive_writes_.front());
+        interactive_writes_.pop_front();
+      } else if (!bulk_writes_.empty()) {
+        write_func = std::move(bulk_writes_.front());
+        bulk_writes_.pop_front();
+      } else {
+        return;
+      }
+    }
+    std::move(write_func).Run();
+  }
+
+  const scoped_refptr<base::SingleThreadTaskRunner> io_task_runner_;
+  base::Lock lock_;
+  std::deque<base::OnceClosure> interactive_writes_;
+  std::deque<base::OnceClosure> bulk_writes_;
+};
+
+// Each IO thread owns one ResponseWriteQueue, created lazily on the first
+// request the thread accepts and released in StopServerOnIOThread.
+base::LazyInstance<base::ThreadLocalPointer<ResponseWriteQueue>>::
+    DestructorAtExit lazy_tls_response_write_queue = LAZY_INSTANCE_INITIALIZER;
+
+// Extracts the session id from a request path of the form
+// "<url-base>/session/<id>/...". Returns an empty string for requests that
+// do not address a session.
+std::string SessionIdFromPath(const std::string& path) {
+  const char kSessionSegment[] = "/session/";
+  size_t pos = path.find(kSessionSegment);
+  if (pos == std::string::npos)
+    return std::string();
+  size_t begin = pos + sizeof(kSessionSegment) - 1;
+  size_t end = path.find('/', begin);
+  if (end == std::string::npos)
+    return path.substr(begin);
+  return path.substr(begin, end - begin);
+}
+
+// Whether the response belongs to a session that declared itself bulk
+// traffic. Unknown sessions and non-session requests count as interactive.
+bool IsLowPrioritySession(const std::string& session_id) {
+  if (session_id.empty())
+    return false;
+  scoped_refptr<SessionMemoryStats> stats =
+      SessionMetrics::GetInstance()->Lookup(session_id);
+  return stats && stats->low_priority.load(std::memory_order_relaxed);
+}
+
 void SendResponseOnCmdThread(
-    const scoped_refptr<base::SingleThreadTaskRunner>& io_task_runner,
+    const scoped_refptr<ResponseWriteQueue>& write_queue,
+    const std::string& session_id,
     const HttpResponseSenderFunc& send_response_on_io_func,
-    std::unique_ptr<net::HttpServerResponseInfo> response) {
-  io_task_runner->PostTask(
-      FROM_HERE, base::BindOnce(send_response_on_io_func, std::move(response)));
+    std::unique_ptr<HttpResponsePayload> response) {
+  write_queue->Enqueue(
+      IsLowPrioritySession(session_id),
+      base::BindOnce(send_response_on_io_func, std::move(response)));
 }
 
 void HandleRequestOnCmdThread(
     HttpHandler* handler,
     const std::vector<net::IPAddress>& allowed_ips,
+    int connection_id,
     const net::HttpServerRequestInfo& request,
     const HttpResponseSenderFunc& send_response_func) {
   if (!allowed_ips.empty()) {
@@ -92,24 +192,36 @@ void HandleRequestOnCmdThread(
       std::unique_ptr<net::HttpServerResponseInfo> response(
           new net::HttpServerResponseInfo(net::HTTP_UNAUTHORIZED));
       response->SetBody("Unauthorized access", "text/plain");
-      send_response_func.Run(std::move(response));
+      send_response_func.Run(
+          std::make_unique<HttpResponsePayload>(std::move(response)));
       return;
     }
   }
 
-  handler->Handle(request, send_response_func);
+  handler->Handle(request, send_response_func, connection_id);
 }
 
 void HandleRequestOnIOThread(
     const scoped_refptr<base::SingleThreadTaskRunner>& cmd_task_runner,
     const HttpRequestHandlerFunc& handle_request_on_cmd_func,
+    int connection_id,
     const net::HttpServerRequestInfo& request,
     const HttpResponseSenderFunc& send_response_func) {
+  ResponseWriteQueue* write_queue =
+      lazy_tls_response_write_queue.Pointer()->Get();
+  if (!write_queue) {
+    write_queue = new ResponseWriteQueue(base::ThreadTaskRunnerHandle::Get());
+    // The reference is owned by this IO thread's TLS slot; see
+    // StopServerOnIOThread.
+    write_queue->AddRef();
+    lazy_tls_response_write_queue.Pointer()->Set(write_queue);
+  }
   cmd_task_runner->PostTask(
       FROM_HERE,
-      base::BindOnce(handle_request_on_cmd_func, request,
+      base::BindOnce(handle_request_on_cmd_func, connection_id, request,
                      base::BindRepeating(&SendResponseOnCmdThread,
-                                         base::ThreadTaskRunnerHandle::Get(),
+                                         base::WrapRefCounted(write_queue),
+                                         SessionIdFromPath(request.path),
                                          send_response_func)));
 }
 
@@ -117,6 +229,8 @@ base::LazyInstance<base::ThreadLocalPointer<HttpServer>>::DestructorAtExit
     lazy_tls_server_ipv4 = LAZY_INSTANCE_INITIALIZER;
 base::LazyInstance<base::ThreadLocalPointer<HttpServer>>::DestructorAtExit
     lazy_tls_server_ipv6 = LAZY_INSTANCE_INITIALIZER;
+base::LazyInstance<base::ThreadLocalPointer<HttpServer>>::DestructorAtExit
+    lazy_tls_server_unix = LAZY_INSTANCE_INITIALIZER;
 
 void StopServerOnIOThread() {
   // Note, |server| may be NULL.
@@ -127,11 +241,24 @@ void StopServerOnIOThread() {
   server = lazy_tls_server_ipv6.Pointer()->Get();
   lazy_tls_server_ipv6.Pointer()->Set(NULL);
   delete server;
+
+  server = lazy_tls_server_unix.Pointer()->Get();
+  lazy_tls_server_unix.Pointer()->Set(NULL);
+  delete server;
+
+  // Drop the TLS reference to this thread's response-write queue; in-flight
+  // SendResponseOnCmdThread callbacks keep the queue itself alive.
+  ResponseWriteQueue* write_queue =
+      lazy_tls_response_write_queue.Pointer()->Get();
+  lazy_tls_response_write_queue.Pointer()->Set(nullptr);
+  if (write_queue)
+    write_queue->Release();
 }
 
 void StartServerOnIOThread(
     uint16_t port,
     bool allow_remote,
+    bool reuse_port,
     const std::string& url_base,
     const std::vector<net::IPAddress>& allowed_ips,
     const HttpRequestHandlerFunc& handle_request_func,
@@ -153,7 +280,7 @@ void StartServerOnIOThread(
 #if defined(OS_MAC)
   temp_server = std::make_unique<HttpServer>(
       url_base, allowed_ips, handle_request_func, handler, cmd_task_runner);
-  int ipv4_status = temp_server->Start(port, allow_remote, true);
+  int ipv4_status = temp_server->Start(port, allow_remote, true, reuse_port);
   if (ipv4_status == net::OK) {
     lazy_tls_server_ipv4.Pointer()->Set(temp_server.release());
   } else if (ipv4_status == net::ERR_ADDRESS_IN_USE) {
@@ -170,7 +297,7 @@ void StartServerOnIOThread(
 
   temp_server = std::make_unique<HttpServer>(
       url_base, allowed_ips, handle_request_func, handler, cmd_task_runner);
-  int ipv6_status = temp_server->Start(port, allow_remote, false);
+  int ipv6_status = temp_server->Start(port, allow_remote, false, reuse_port);
   if (ipv6_status == net::OK) {
     lazy_tls_server_ipv6.Pointer()->Set(temp_server.release());
   } else if (ipv6_status == net::ERR_ADDRESS_IN_USE) {
@@ -221,7 +348,7 @@ void StartServerOnIOThread(
   } else {
     temp_server = std::make_unique<HttpServer>(
         url_base, allowed_ips, handle_request_func, handler, cmd_task_runner);
-    ipv4_status = temp_server->Start(port, allow_remote, true);
+    ipv4_status = temp_server->Start(port, allow_remote, true, reuse_port);
     if (ipv4_status == net::OK) {
       lazy_tls_server_ipv4.Pointer()->Set(temp_server.release());
     } else if (ipv4_status == net::ERR_ADDRESS_IN_USE) {
@@ -243,16 +370,86 @@ void StartServerOnIOThread(
   fflush(stdout);
 }
 
+// Starts one extra acceptor on the calling IO thread. Unlike the primary
+// acceptor this never exits the process: the primary has already proven the
+// port is usable, so a failure here only costs parallelism, not service.
+void StartExtraAcceptorOnIOThread(
+    uint16_t port,
+    bool allow_remote,
+    const std::string& url_base,
+    const std::vector<net::IPAddress>& allowed_ips,
+    const HttpRequestHandlerFunc& handle_request_func,
+    base::WeakPtr<HttpHandler> handler,
+    const scoped_refptr<base::SingleThreadTaskRunner>& cmd_task_runner) {
+  auto temp_server = std::make_unique<HttpServer>(
+      url_base, allowed_ips, handle_request_func, handler, cmd_task_runner);
+  int ipv6_status =
+      temp_server->Start(port, allow_remote, false, true /* reuse_port */);
+  if (ipv6_status == net::OK)
+    lazy_tls_server_ipv6.Pointer()->Set(temp_server.release());
+
+  temp_server = std::make_unique<HttpServer>(
+      url_base, allowed_ips, handle_request_func, handler, cmd_task_runner);
+  int ipv4_status =
+      temp_server->Start(port, allow_remote, true, true /* reuse_port */);
+  if (ipv4_status == net::OK)
+    lazy_tls_server_ipv4.Pointer()->Set(temp_server.release());
+
+  if (ipv4_status != net::OK && ipv6_status != net::OK) {
+    LOG(WARNING) << "Unable to start an extra HTTP acceptor; continuing with "
+                 << "fewer IO threads.";
+  }
+}
+
+// Starts the Unix domain socket acceptor for co-located clients. Requested
+// explicitly via --listen-unix, so a failure exits like an unusable port.
+void StartUnixAcceptorOnIOThread(
+    const std::string& socket_path,
+    const std::string& url_base,
+    const HttpRequestHandlerFunc& handle_request_func,
+    base::WeakPtr<HttpHandler> handler,
+    const scoped_refptr<base::SingleThreadTaskRunner>& cmd_task_runner) {
+  auto temp_server = std::make_unique<HttpServer>(
+      url_base, std::vector<net::IPAddress>(), handle_request_func, handler,
+      cmd_task_runner);
+  int status = temp_server->StartOnUnixSocket(socket_path);
+  if (status != net::OK) {
+    printf("Unable to listen on Unix domain socket %s. Exiting...\n",
+           socket_path.c_str());
+    exit(1);
+  }
+  lazy_tls_server_unix.Pointer()->Set(temp_server.release());
+}
+
 void RunServer(uint16_t port,
                bool allow_remote,
                const std::vector<net::IPAddress>& allowed_ips,
                const std::string& url_base,
-               int adb_port) {
+               const std::string& unix_socket_path,
+               int adb_port,
+               int http_threads) {
   base::Thread io_thread(
       base::StringPrintf("%s IO", kChromeDriverProductShortName));
   CHECK(io_thread.StartWithOptions(
       base::Thread::Options(base::MessagePumpType::IO, 0)));
 
+  // Extra acceptor threads each listen on their own SO_REUSEPORT socket; the
+  // kernel hashes connections across them, so one client connection - and
+  // with keep-alive, typically one session - stays on one IO thread.
+  std::vector<std::unique_ptr<base::Thread>> extra_io_threads;
+  for (int i = 1; i < http_threads; ++i) {
+    auto extra_thread = std::make_unique<base::Thread>(
+        base::StringPrintf("%s IO %d", kChromeDriverProductShortName, i));
+    CHECK(extra_thread->StartWithOptions(
+        base::Thread::Options(base::MessagePumpType::IO, 0)));
+    extra_io_threads.push_back(std::move(extra_thread));
+  }
+  const bool reuse_port = http_threads > 1;
+
+  // Background sampling of session threads stuck in one command; samples
+  // surface on /status.
+  SessionMetrics::GetInstance()->StartWatchdog();
+
   base::SingleThreadTaskExecutor main_task_executor;
   base::RunLoop cmd_run_loop;
   HttpHandler handler(cmd_run_loop.QuitClosure(), io_thread.task_runner(),
@@ -262,18 +459,46 @@ void RunServer(uint16_t port,
 
   io_thread.task_runner()->PostTask(
       FROM_HERE,
-      base::BindOnce(&StartServerOnIOThread, port, allow_remote, url_base,
-                     allowed_ips,
+      base::BindOnce(&StartServerOnIOThread, port, allow_remote, reuse_port,
+                     url_base, allowed_ips,
                      base::BindRepeating(&HandleRequestOnIOThread,
                                          main_task_executor.task_runner(),
                                          handle_request_func),
                      handler.WeakPtr(), main_task_executor.task_runner()));
+  if (!unix_socket_path.empty()) {
+    // Unix-socket peers are vetted by the kernel's credential check in the
+    // acceptor, so the IP allowlist does not apply to them.
+    HttpRequestHandlerFunc unix_handle_request_func = base::BindRepeating(
+        &HandleRequestOnCmdThread, &handler, std::vector<net::IPAddress>());
+    io_thread.task_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&StartUnixAcceptorOnIOThread, unix_socket_path,
+                       url_base,
+                       base::BindRepeating(&HandleRequestOnIOThread,
+                                           main_task_executor.task_runner(),
+                                           unix_handle_request_func),
+                       handler.WeakPtr(), main_task_executor.task_runner()));
+  }
+  for (auto& extra_thread : extra_io_threads) {
+    extra_thread->task_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&StartExtraAcceptorOnIOThread, port, allow_remote,
+                       url_base, allowed_ips,
+                       base::BindRepeating(&HandleRequestOnIOThread,
+                                           main_task_executor.task_runner(),
+                                           handle_request_func),
+                       handler.WeakPtr(), main_task_executor.task_runner()));
+  }
   // Run the command loop. This loop is quit after the response for a shutdown
   // request is posted to the IO loop. After the command loop quits, a task
   // is posted to the IO loop to stop the server. Lastly, the IO thread is
   // destroyed, which waits until all pending tasks have been completed.
   // This assumes the response is sent synchronously as part of the IO task.
   cmd_run_loop.Run();
+  for (auto& extra_thread : extra_io_threads) {
+    extra_thread->task_runner()->PostTask(
+        FROM_HERE, base::BindOnce(&StopServerOnIOThread));
+  }
   io_thread.task_runner()->PostTask(FROM_HERE,
                                     base::BindOnce(&StopServerOnIOThread));
 }
@@ -327,6 +552,29 @@ int main(int argc, char *argv[]) {
       "base URL path prefix for commands, e.g. wd/url",
       "readable-timestamp",
       "add readable timestamps to log",
+      "session-executor=MODE",
+      "session command executor: thread (default, one thread per session) "
+      "or pool (sessions share a fixed pool of worker threads)",
+      "numa-policy=POLICY",
+      "placement of sessions across NUMA nodes: none (default) or "
+      "round-robin (pin each session's thread and browser to one node; "
+      "Linux only, needs --session-executor=thread)",
+      "browser-pool-size=N",
+      "keep N pre-launched browsers warm for faster session creation "
+      "(default 0, disabled)",
+      "http-threads=N",
+      "serve HTTP from N IO threads sharing the port via SO_REUSEPORT "
+      "(default 1; POSIX only)",
+      "devtools-transport-threads=N",
+      "run DevTools websocket traffic on N dedicated transport threads, "
+      "separate from the HTTP IO threads (default 4)",
+      "listen-unix=PATH",
+      "additionally accept commands on a Unix domain socket bound to PATH; "
+      "peers are verified by socket credentials instead of Host/Origin "
+      "checks (POSIX only)",
+      "session-idle-timeout=SECONDS",
+      "quit sessions that receive no command for this long; should exceed "
+      "the longest expected single command (default 0, disabled)",
       "enable-chrome-logs",
       "show logs from the browser (overrides other logging options)",
 // TODO(crbug.com/1052397): Revisit the macro expression once build flag switch
@@ -377,6 +625,71 @@ int main(int argc, char *argv[]) {
       return 1;
     }
   }
+  if (cmd_line->HasSwitch("session-executor")) {
+    std::string executor = cmd_line->GetSwitchValueASCII("session-executor");
+    if (executor == "pool") {
+      SessionThreadInfo::SetUsePooledExecutor(true);
+    } else if (executor != "thread") {
+      printf("Invalid session-executor. Exiting...\n");
+      return 1;
+    }
+  }
+  if (cmd_line->HasSwitch("numa-policy")) {
+    if (!InitNumaPolicy(cmd_line->GetSwitchValueASCII("numa-policy"))) {
+      printf("Invalid numa-policy. Exiting...\n");
+      return 1;
+    }
+  }
+  if (cmd_line->HasSwitch("browser-pool-size")) {
+    int pool_size;
+    if (!base::StringToInt(cmd_line->GetSwitchValueASCII("browser-pool-size"),
+                           &pool_size) ||
+        pool_size < 0) {
+      printf("Invalid browser-pool-size. Exiting...\n");
+      return 1;
+    }
+    BrowserPool::SetTargetSize(pool_size);
+  }
+  if (cmd_line->HasSwitch("session-idle-timeout")) {
+    int idle_timeout_seconds;
+    if (!base::StringToInt(
+            cmd_line->GetSwitchValueASCII("session-idle-timeout"),
+            &idle_timeout_seconds) ||
+        idle_timeout_seconds < 0) {
+      printf("Invalid session-idle-timeout. Exiting...\n");
+      return 1;
+    }
+    HttpHandler::SetSessionIdleTimeout(
+        base::TimeDelta::FromSeconds(idle_timeout_seconds));
+  }
+  int http_threads = 1;
+  if (cmd_line->HasSwitch("http-threads")) {
+    if (!base::StringToInt(cmd_line->GetSwitchValueASCII("http-threads"),
+                           &http_threads) ||
+        http_threads < 1) {
+      printf("Invalid http-threads. Exiting...\n");
+      return 1;
+    }
+#if !defined(OS_POSIX)
+    if (http_threads > 1) {
+      printf("http-threads requires SO_REUSEPORT; using a single IO thread.\n");
+      http_threads = 1;
+    }
+#endif
+  }
+  std::string unix_socket_path;
+  if (cmd_line->HasSwitch("listen-unix")) {
+#if defined(OS_POSIX)
+    unix_socket_path = cmd_line->GetSwitchValueASCII("listen-unix");
+    if (unix_socket_path.empty()) {
+      printf("Invalid listen-unix. Exiting...\n");
+      return 1;
+    }
+#else
+    printf("listen-unix is only supported on POSIX. Exiting...\n");
+    return 1;
+#endif
+  }
   if (cmd_line->HasSwitch("url-base"))
     url_base = cmd_line->GetSwitchValueASCII("url-base");
   if (url_base.empty() || url_base.front() != '/')
@@ -449,10 +762,16 @@ int main(int argc, char *argv[]) {
 
   mojo::core::Init();
 
+  // No-op unless the build was configured with
+  // chromedriver_track_allocations; must precede thread startup so every
+  // thread's totals start at zero.
+  allocation_tracker::Install();
+
   base::ThreadPoolInstance::CreateAndStartWithDefaultParams(
       kChromeDriverProductShortName);
 
-  RunServer(port, allow_remote, allowed_ips, url_base, adb_port);
+  RunServer(port, allow_remote, allowed_ips, url_base, unix_socket_path,
+            adb_port, http_threads);
 
   // clean up
   base::ThreadPoolInstance::Get()->Shutdown();
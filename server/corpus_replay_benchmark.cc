@@ -0,0 +1,179 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Replays a JSONL corpus of WebDriver HTTP commands through a real
+// HttpHandler and reports the end-to-end latency distribution per command
+// class, giving a repeatable production-like workload for validating
+// dispatch-path optimizations against each other.
+//
+// Pass --corpus-file=<path> to replay a captured corpus; each line is a
+// JSON object {"method": ..., "path": ..., "data": {...}}. Without the
+// switch a built-in mix of common commands is used so the benchmark always
+// runs. No session exists during replay, so session commands stop at the
+// session lookup; the measured work is the routing, parameter parsing and
+// response serialization every real command also pays.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/timer/elapsed_timer.h"
+#include "base/values.h"
+#include "chrome/test/chromedriver/server/http_handler.h"
+#include "net/server/http_server_request_info.h"
+#include "net/server/http_server_response_info.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace {
+
+// Passes over the corpus; each request contributes one latency sample per
+// pass to its command class.
+const int kRuns = 500;
+
+const char kCorpusFileSwitch[] = "corpus-file";
+
+// A command mix modeled on a typical scripted session: mostly finds,
+// interactions and script evaluation, with the occasional navigation and
+// screenshot.
+const char kDefaultCorpus[] =
+    R"({"method": "get", "path": "/status"})"
+    "\n"
+    R"({"method": "post", "path": "/session/s-1/url",)"
+    R"( "data": {"url": "http://example.com/"}})"
+    "\n"
+    R"({"method": "post", "path": "/session/s-1/element",)"
+    R"( "data": {"using": "css selector", "value": "#main"}})"
+    "\n"
+    R"({"method": "post", "path": "/session/s-1/element/e-7/click",)"
+    R"( "data": {}})"
+    "\n"
+    R"({"method": "get", "path": "/session/s-1/element/e-7/text"})"
+    "\n"
+    R"({"method": "post", "path": "/session/s-1/execute/sync",)"
+    R"( "data": {"script": "return 1;", "args": []}})"
+    "\n"
+    R"({"method": "get", "path": "/session/s-1/screenshot"})"
+    "\n";
+
+struct CorpusEntry {
+  std::string method;
+  std::string path;
+  std::string data;
+  std::string command_class;
+};
+
+// Buckets a request into a command class by blanking out the id path
+// segments, so the same command against different sessions or elements
+// lands in one distribution.
+std::string CommandClass(const std::string& method, const std::string& path) {
+  std::vector<std::string> parts = base::SplitString(
+      path, "/", base::KEEP_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+  std::string result = method;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    bool is_id = i > 0 && (parts[i - 1] == "session" ||
+                           parts[i - 1] == "element" ||
+                           parts[i - 1] == "window");
+    result += "_" + (is_id ? "id" : parts[i]);
+  }
+  // Perf dashboard story names cannot hold arbitrary punctuation.
+  for (char& c : result) {
+    if (!base::IsAsciiAlpha(c) && !base::IsAsciiDigit(c))
+      c = '_';
+  }
+  return result;
+}
+
+bool ParseCorpus(const std::string& jsonl, std::vector<CorpusEntry>* corpus) {
+  for (const std::string& line : base::SplitString(
+           jsonl, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    std::unique_ptr<base::Value> value =
+        base::JSONReader::ReadDeprecated(line);
+    base::DictionaryValue* dict = nullptr;
+    if (!value || !value->GetAsDictionary(&dict))
+      return false;
+    CorpusEntry entry;
+    if (!dict->GetString("method", &entry.method) ||
+        !dict->GetString("path", &entry.path)) {
+      return false;
+    }
+    const base::Value* data = dict->FindKey("data");
+    if (data)
+      base::JSONWriter::Write(*data, &entry.data);
+    entry.command_class = CommandClass(entry.method, entry.path);
+    corpus->push_back(entry);
+  }
+  return !corpus->empty();
+}
+
+bool LoadCorpus(std::vector<CorpusEntry>* corpus) {
+  base::FilePath corpus_path =
+      base::CommandLine::ForCurrentProcess()->GetSwitchValuePath(
+          kCorpusFileSwitch);
+  std::string jsonl = kDefaultCorpus;
+  if (!corpus_path.empty() && !base::ReadFileToString(corpus_path, &jsonl))
+    return false;
+  return ParseCorpus(jsonl, corpus);
+}
+
+void DiscardResponse(std::unique_ptr<HttpResponsePayload> response) {}
+
+double Percentile(const std::vector<double>& sorted_samples, double fraction) {
+  size_t index = static_cast<size_t>(fraction * (sorted_samples.size() - 1));
+  return sorted_samples[index];
+}
+
+}  // namespace
+
+TEST(CorpusReplayBenchmark, ReplayCommandMix) {
+  std::vector<CorpusEntry> corpus;
+  ASSERT_TRUE(LoadCorpus(&corpus));
+
+  HttpHandler handler("/");
+  std::map<std::string, std::vector<double>> latencies_us;
+
+  for (int run = -1; run < kRuns; ++run) {
+    for (const CorpusEntry& entry : corpus) {
+      net::HttpServerRequestInfo request;
+      request.method = entry.method;
+      request.path = entry.path;
+      request.data = entry.data;
+      base::ElapsedTimer timer;
+      handler.Handle(request, base::BindRepeating(&DiscardResponse));
+      // The first pass warms caches and lazy initialization; discard it.
+      if (run >= 0) {
+        latencies_us[entry.command_class].push_back(
+            timer.Elapsed().InMicrosecondsF());
+      }
+    }
+  }
+
+  for (auto& it : latencies_us) {
+    std::vector<double>& samples = it.second;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double sample : samples)
+      sum += sample;
+    perf_test::PerfResultReporter reporter("ChromeDriver.CorpusReplay",
+                                           it.first);
+    reporter.RegisterImportantMetric(".mean", "us");
+    reporter.RegisterImportantMetric(".p50", "us");
+    reporter.RegisterImportantMetric(".p95", "us");
+    reporter.RegisterImportantMetric(".p99", "us");
+    reporter.AddResult(".mean", sum / samples.size());
+    reporter.AddResult(".p50", Percentile(samples, 0.50));
+    reporter.AddResult(".p95", Percentile(samples, 0.95));
+    reporter.AddResult(".p99", Percentile(samples, 0.99));
+  }
+}
@@ -6,29 +6,42 @@
 
 #include <stddef.h>
 
+#include <algorithm>
+#include <map>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/json/json_reader.h"
 #include "base/json/json_writer.h"
+#include "base/json/string_escape.h"
 #include "base/logging.h"  // For CHECK macros.
 #include "base/single_thread_task_runner.h"
 #include "base/stl_util.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/system/sys_info.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
+#include "base/task/thread_pool/thread_pool_instance.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/values.h"
 #include "build/build_config.h"
 #include "chrome/test/chromedriver/alert_commands.h"
+#include "chrome/test/chromedriver/browser_pool.h"
 #include "chrome/test/chromedriver/chrome/adb_impl.h"
 #include "chrome/test/chromedriver/chrome/device_manager.h"
+#include "chrome/test/chromedriver/chrome/driver_tracing.h"
+#include "chrome/test/chromedriver/chrome/json_parser.h"
 #include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/command_metrics.h"
 #include "chrome/test/chromedriver/constants/version.h"
+#include "chrome/test/chromedriver/net/json_escape.h"
 #include "chrome/test/chromedriver/net/url_request_context_getter.h"
 #include "chrome/test/chromedriver/server/http_server.h"
 #include "chrome/test/chromedriver/session.h"
@@ -42,6 +55,7 @@
 #include "services/network/public/cpp/shared_url_loader_factory.h"
 #include "services/network/public/mojom/url_loader_factory.mojom.h"
 #include "services/network/transitional_url_loader_factory_owner.h"
+#include "third_party/zlib/google/compression_utils.h"
 #include "url/url_util.h"
 
 #if defined(OS_MAC)
@@ -66,6 +80,87 @@ bool w3cMode(const std::string& session_id,
   return kW3CDefault;
 }
 
+// Appends a null or scalar |value| to |out| as JSON, returning false for
+// types the envelope fast path does not cover: doubles keep JSONWriter's
+// formatting quirks, lists and dictionaries its recursive rendering.
+bool RenderScalarResult(const base::Value* value, std::string* out) {
+  if (!value || value->is_none()) {
+    out->append("null");
+    return true;
+  }
+  if (value->is_bool()) {
+    out->append(value->GetBool() ? "true" : "false");
+    return true;
+  }
+  if (value->is_int()) {
+    out->append(base::NumberToString(value->GetInt()));
+    return true;
+  }
+  if (value->is_string()) {
+    // Word-at-a-time escaping; screenshots and page source are multi-MB
+    // strings that are almost entirely clean ASCII.
+    EscapeJSONStringFast(value->GetString(), true /*put_in_quotes*/, out);
+    return true;
+  }
+  return false;
+}
+
+// Bodies below this size are sent as-is: gzip's header and deflate
+// overhead eat the savings, and small responses dominate the command mix.
+const size_t kGzipBodyThreshold = 16 * 1024;
+
+// A body at or above this size is handed to the IO thread ref-counted in
+// HttpResponsePayload::body rather than copied into the response info.
+// The write path in http_server.cc already serializes headers separately
+// and sends bodies of this size in slices, so the buffer reaches the
+// socket without another full copy in between.
+const size_t kRefCountedBodyThreshold = 1024 * 1024;  // 1 MB
+
+// A request body at or above this size is parsed on a worker thread instead
+// of inline on the command thread, so one session's multi-megabyte script
+// payload does not delay every other session's small commands. Below it the
+// cross-thread handoff costs more than the parse.
+const size_t kOffThreadBodyParseThreshold = 256 * 1024;
+
+// Worker-side half of the off-thread parse; |body| is a copy owned by the
+// task.
+std::unique_ptr<base::Value> ParseBodyOnWorkerThread(const std::string& body) {
+  return ParseJsonHotPath(body, base::JSON_PARSE_RFC);
+}
+
+// Sets the JSON |body| on |payload|, gzip-compressing it first when the
+// client advertised gzip support and the body is large enough (e.g. page
+// source or screenshots) for compression to pay for itself.
+void SetJsonBody(HttpResponsePayload* payload,
+                 bool accepts_gzip,
+                 std::string body) {
+  net::HttpServerResponseInfo* response = payload->info.get();
+  if (accepts_gzip && body.size() >= kGzipBodyThreshold) {
+    std::string compressed;
+    if (compression::GzipCompress(body, &compressed) &&
+        compressed.size() < body.size()) {
+      response->AddHeader("Content-Encoding", "gzip");
+      body = std::move(compressed);
+    }
+  }
+  if (body.size() >= kRefCountedBodyThreshold) {
+    // The same headers SetBody() would have added, so the response on the
+    // wire is identical.
+    response->AddHeader("Content-Length", base::NumberToString(body.size()));
+    response->AddHeader("Content-Type", "application/json; charset=utf-8");
+    payload->body = base::RefCountedString::TakeString(&body);
+    return;
+  }
+  response->SetBody(body, "application/json; charset=utf-8");
+}
+
+// Returns whether the request's Accept-Encoding header allows a gzip
+// response body.
+bool AcceptsGzip(const net::HttpServerRequestInfo& request) {
+  return request.GetHeaderValue("accept-encoding").find("gzip") !=
+         std::string::npos;
+}
+
 net::HttpServerResponseInfo createWebSocketRejectResponse(
     net::HttpStatusCode code,
     const std::string& msg) {
@@ -73,6 +168,46 @@ net::HttpServerResponseInfo createWebSocketRejectResponse(
   response.AddHeader("X-WebSocket-Reject-Reason", msg);
   return response;
 }
+
+const char* MethodToString(HttpMethod method) {
+  switch (method) {
+    case kGet:
+      return "GET";
+    case kPost:
+      return "POST";
+    case kDelete:
+      return "DELETE";
+  }
+  return "UNKNOWN";
+}
+
+// How long a session may go without receiving a command before the idle
+// reaper quits it. Zero disables reaping. Set once at startup.
+base::TimeDelta g_session_idle_timeout;
+
+// Completion callback for quit commands issued by the idle-session reaper;
+// no client is waiting, so the result is only logged.
+void OnIdleSessionQuit(const Status& status,
+                       std::unique_ptr<base::Value> value,
+                       const std::string& session_id,
+                       bool w3c_compliant) {
+  if (status.IsError())
+    LOG(WARNING) << "failed to quit idle session: " << status.message();
+}
+
+// Records the command's latency into |histogram| before forwarding the
+// result to |next|.
+void RecordCommandLatency(CommandLatencyHistogram* histogram,
+                          base::TimeTicks start,
+                          const CommandCallback& next,
+                          const Status& status,
+                          std::unique_ptr<base::Value> value,
+                          const std::string& session_id,
+                          bool w3c_compliant) {
+  histogram->Record(base::TimeTicks::Now() - start);
+  next.Run(status, std::move(value), session_id, w3c_compliant);
+}
+
 }  // namespace
 
 // WrapperURLLoaderFactory subclasses mojom::URLLoaderFactory as non-mojo, cross
@@ -120,6 +255,14 @@ class WrapperURLLoaderFactory : public network::mojom::URLLoaderFactory {
   DISALLOW_COPY_AND_ASSIGN(WrapperURLLoaderFactory);
 };
 
+HttpResponsePayload::HttpResponsePayload() {}
+
+HttpResponsePayload::HttpResponsePayload(
+    std::unique_ptr<net::HttpServerResponseInfo> info)
+    : info(std::move(info)) {}
+
+HttpResponsePayload::~HttpResponsePayload() {}
+
 CommandMapping::CommandMapping(HttpMethod method,
                                const std::string& path_pattern,
                                const Command& command)
@@ -156,8 +299,9 @@ HttpHandler::HttpHandler(
 #if defined(OS_MAC)
   base::mac::ScopedNSAutoreleasePool autorelease_pool;
 #endif
-  context_getter_ = new URLRequestContextGetter(io_task_runner_);
-  socket_factory_ = CreateSyncWebSocketFactory(context_getter_.get());
+  context_getter_ = URLRequestContextGetter::GetSharedInstance(
+      io_task_runner_, "http_handler");
+  socket_factory_ = CreateSyncWebSocketFactory();
   adb_ = std::make_unique<AdbImpl>(io_task_runner_, adb_port);
   device_manager_ = std::make_unique<DeviceManager>(adb_.get());
   url_loader_factory_owner_ =
@@ -166,6 +310,10 @@ HttpHandler::HttpHandler(
 
   wrapper_url_loader_factory_ = std::make_unique<WrapperURLLoaderFactory>(
       url_loader_factory_owner_->GetURLLoaderFactory());
+  browser_pool_ = base::MakeRefCounted<BrowserPool>(
+      wrapper_url_loader_factory_.get(), socket_factory_,
+      device_manager_.get());
+  browser_pool_->Start();
   CommandMapping commands[] = {
       //
       // W3C standard endpoints
@@ -181,7 +329,8 @@ HttpHandler::HttpHandler(
                       InitSessionParams(wrapper_url_loader_factory_.get(),
                                         socket_factory_, device_manager_.get(),
                                         cmd_task_runner,
-                                        &session_connection_map_))))),
+                                        &session_connection_map_,
+                                        browser_pool_))))),
       CommandMapping(kDelete, "session/:sessionId",
                      base::BindRepeating(
                          &ExecuteSessionCommand, &session_thread_map_, "Quit",
@@ -270,6 +419,11 @@ HttpHandler::HttpHandler(
           kPost, "session/:sessionId/elements",
           WrapToCommand("FindElements",
                         base::BindRepeating(&ExecuteFindElements, 50))),
+      CommandMapping(
+          kPost, "session/:sessionId/chromium/elements/all_frames",
+          WrapToCommand("FindElementsAllFrames",
+                        base::BindRepeating(&ExecuteFindElementsAllFrames),
+                        false /*w3c_standard_command*/)),
       CommandMapping(
           kPost, "session/:sessionId/element/:id/element",
           WrapToCommand("FindChildElement",
@@ -538,6 +692,14 @@ HttpHandler::HttpHandler(
           WrapToCommand("IsElementDisplayed",
                         base::BindRepeating(&ExecuteIsElementDisplayed))),
 
+      // Extension: combined element-state snapshot, one evaluation instead of
+      // chained displayed/rect/enabled/attribute queries.
+      CommandMapping(
+          kPost, "session/:sessionId/element/:id/chromium/state",
+          WrapToCommand("GetElementState",
+                        base::BindRepeating(&ExecuteGetElementState),
+                        false /*w3c_standard_command*/)),
+
       // No W3C equivalent.
       CommandMapping(
           kGet, "session/:sessionId/element/:id/location",
@@ -695,6 +857,22 @@ HttpHandler::HttpHandler(
               base::BindRepeating(&ExecuteRemoveStorageItem, kLocalStorage),
               false /*w3c_standard_command*/)),
 
+      // No W3C equivalent.
+      CommandMapping(
+          kGet, "session/:sessionId/local_storage/snapshot",
+          WrapToCommand(
+              "GetLocalStorageSnapshot",
+              base::BindRepeating(&ExecuteGetStorageSnapshot, kLocalStorage),
+              false /*w3c_standard_command*/)),
+
+      // No W3C equivalent.
+      CommandMapping(
+          kPost, "session/:sessionId/local_storage/snapshot",
+          WrapToCommand(
+              "SetLocalStorageItems",
+              base::BindRepeating(&ExecuteSetStorageItems, kLocalStorage),
+              false /*w3c_standard_command*/)),
+
       // No W3C equivalent.
       CommandMapping(kGet, "session/:sessionId/local_storage/size",
                      WrapToCommand("GetLocalStorageSize",
@@ -738,6 +916,22 @@ HttpHandler::HttpHandler(
               base::BindRepeating(&ExecuteRemoveStorageItem, kSessionStorage),
               false /*w3c_standard_command*/)),
 
+      // No W3C equivalent.
+      CommandMapping(
+          kGet, "session/:sessionId/session_storage/snapshot",
+          WrapToCommand(
+              "GetSessionStorageSnapshot",
+              base::BindRepeating(&ExecuteGetStorageSnapshot, kSessionStorage),
+              false /*w3c_standard_command*/)),
+
+      // No W3C equivalent.
+      CommandMapping(
+          kPost, "session/:sessionId/session_storage/snapshot",
+          WrapToCommand(
+              "SetSessionStorageItems",
+              base::BindRepeating(&ExecuteSetStorageItems, kSessionStorage),
+              false /*w3c_standard_command*/)),
+
       // No W3C equivalent.
       CommandMapping(kGet, "session/:sessionId/session_storage/size",
                      WrapToCommand("GetSessionStorageSize",
@@ -763,6 +957,11 @@ HttpHandler::HttpHandler(
       CommandMapping(kGet, "session/:sessionId/application_cache/status",
                      base::BindRepeating(&ExecuteGetStatus)),
 
+      // Dumps the driver's own span trace (see DriverTracing) as Trace
+      // Event JSON. Recording is enabled by goog:chromeOptions.traceDriver.
+      CommandMapping(kGet, "chromium/driver_trace",
+                     base::BindRepeating(&ExecuteGetDriverTrace)),
+
       //
       // Extension commands from other specs.
       //
@@ -808,6 +1007,15 @@ HttpHandler::HttpHandler(
               "AddCredential",
               base::BindRepeating(&ExecuteWebAuthnCommand,
                                   base::BindRepeating(&ExecuteAddCredential)))),
+      CommandMapping(
+          kPost,
+          "session/:sessionId/webauthn/authenticator/:authenticatorId/"
+          "chromium/credentials",
+          WrapToCommand(
+              "AddCredentials",
+              base::BindRepeating(&ExecuteWebAuthnCommand,
+                                  base::BindRepeating(&ExecuteAddCredentials)),
+              false /*w3c_standard_command*/)),
       CommandMapping(
           kGet,
           "session/:sessionId/webauthn/authenticator/:authenticatorId/"
@@ -816,6 +1024,16 @@ HttpHandler::HttpHandler(
                         base::BindRepeating(
                             &ExecuteWebAuthnCommand,
                             base::BindRepeating(&ExecuteGetCredentials)))),
+      CommandMapping(
+          kPost,
+          "session/:sessionId/webauthn/authenticator/:authenticatorId/"
+          "chromium/credentials/page",
+          WrapToCommand(
+              "GetCredentialsPage",
+              base::BindRepeating(
+                  &ExecuteWebAuthnCommand,
+                  base::BindRepeating(&ExecuteGetCredentialsPage)),
+              false /*w3c_standard_command*/)),
       CommandMapping(
           kDelete,
           "session/:sessionId/webauthn/authenticator/:authenticatorId/"
@@ -898,6 +1116,14 @@ HttpHandler::HttpHandler(
           kGet, "session/:sessionId/chromium/heap_snapshot",
           WrapToCommand("HeapSnapshot",
                         base::BindRepeating(&ExecuteTakeHeapSnapshot))),
+      CommandMapping(
+          kGet, "session/:sessionId/chromium/capture_snapshot",
+          WrapToCommand("CaptureSnapshot",
+                        base::BindRepeating(&ExecuteCaptureSnapshot))),
+      CommandMapping(
+          kPost, "session/:sessionId/chromium/extract_content",
+          WrapToCommand("ExtractContent",
+                        base::BindRepeating(&ExecuteExtractContent))),
       CommandMapping(
           kGet, "session/:sessionId/chromium/network_conditions",
           WrapToCommand("GetNetworkConditions",
@@ -910,6 +1136,27 @@ HttpHandler::HttpHandler(
           kDelete, "session/:sessionId/chromium/network_conditions",
           WrapToCommand("DeleteNetworkConditions",
                         base::BindRepeating(&ExecuteDeleteNetworkConditions))),
+      CommandMapping(kGet, "session/:sessionId/chromium/windows",
+                     WrapToCommand("GetWindows",
+                                   base::BindRepeating(&ExecuteGetWindows))),
+      CommandMapping(
+          kPost, "session/:sessionId/chromium/poll_state",
+          WrapToCommand("PollState", base::BindRepeating(&ExecutePollState))),
+      CommandMapping(
+          kGet, "session/:sessionId/chromium/export_session",
+          WrapToCommand("ExportSession",
+                        base::BindRepeating(&ExecuteExportSession))),
+      CommandMapping(kPost, "session/:sessionId/chromium/screenshot_all",
+                     WrapToCommand("ScreenshotAll",
+                                   base::BindRepeating(&ExecuteScreenshotAll))),
+      CommandMapping(
+          kPost, "session/:sessionId/chromium/set_cookies",
+          WrapToCommand("SetCookies",
+                        base::BindRepeating(&ExecuteSetCookies))),
+      CommandMapping(
+          kPost, "session/:sessionId/chromium/delete_cookies",
+          WrapToCommand("DeleteCookies",
+                        base::BindRepeating(&ExecuteDeleteCookies))),
       CommandMapping(kPost, "session/:sessionId/chromium/send_command",
                      WrapToCommand("SendCommand",
                                    base::BindRepeating(&ExecuteSendCommand))),
@@ -921,6 +1168,49 @@ HttpHandler::HttpHandler(
           kPost, "session/:sessionId/chromium/send_command_and_get_result",
           WrapToCommand("SendCommandAndGetResult",
                         base::BindRepeating(&ExecuteSendCommandAndGetResult))),
+      CommandMapping(
+          kPost, "session/:sessionId/chromium/batch",
+          WrapToCommand("ExecuteBatch",
+                        base::BindRepeating(&ExecuteBatch,
+                                            &batch_command_map_))),
+      CommandMapping(
+          kPost, "session/:sessionId/chromium/reset",
+          WrapToCommand("ResetSession",
+                        base::BindRepeating(&ExecuteResetSession))),
+      // Log streaming over the chromium/create_websocket channel; pushed
+      // batches are dropped when no WebSocket is connected.
+      CommandMapping(
+          kPost, "session/:sessionId/chromium/subscribe_logs",
+          WrapToCommand(
+              "SubscribeLogs",
+              base::BindRepeating(
+                  &ExecuteSubscribeLogs,
+                  base::BindRepeating(&HttpHandler::SendLogFrameForSession,
+                                      weak_ptr_factory_.GetWeakPtr()),
+                  cmd_task_runner))),
+      CommandMapping(
+          kPost, "session/:sessionId/chromium/unsubscribe_logs",
+          WrapToCommand("UnsubscribeLogs",
+                        base::BindRepeating(&ExecuteUnsubscribeLogs))),
+      CommandMapping(kPost, "session/:sessionId/chromium/ack_logs",
+                     WrapToCommand("AckLogs",
+                                   base::BindRepeating(&ExecuteAckLogs))),
+      // Asynchronous navigation: starts the load and returns a token;
+      // completion is pushed over the chromium/create_websocket channel and
+      // the same state is poll-able under chromium/navigation_status.
+      CommandMapping(
+          kPost, "session/:sessionId/chromium/navigate_async",
+          WrapToCommand(
+              "NavigateAsync",
+              base::BindRepeating(
+                  &ExecuteNavigateAsync,
+                  base::BindRepeating(&HttpHandler::SendLogFrameForSession,
+                                      weak_ptr_factory_.GetWeakPtr()),
+                  cmd_task_runner))),
+      CommandMapping(
+          kPost, "session/:sessionId/chromium/navigation_status",
+          WrapToCommand("NavigationStatus",
+                        base::BindRepeating(&ExecuteGetNavigationStatus))),
       VendorPrefixedCommandMapping(
           kPost, "session/:sessionId/%s/page/freeze",
           WrapToCommand("Freeze", base::BindRepeating(&ExecuteFreeze))),
@@ -946,6 +1236,26 @@ HttpHandler::HttpHandler(
           kGet, "session/:sessionId/%s/cast/get_issue_message",
           WrapToCommand("GetIssueMessage",
                         base::BindRepeating(&ExecuteGetIssueMessage))),
+      VendorPrefixedCommandMapping(
+          kPost, "session/:sessionId/%s/screencast/start",
+          WrapToCommand("StartScreencast",
+                        base::BindRepeating(&ExecuteStartScreencast))),
+      VendorPrefixedCommandMapping(
+          kPost, "session/:sessionId/%s/screencast/stop",
+          WrapToCommand("StopScreencast",
+                        base::BindRepeating(&ExecuteStopScreencast))),
+      VendorPrefixedCommandMapping(
+          kGet, "session/:sessionId/%s/screencast/frame",
+          WrapToCommand("GetScreencastFrame",
+                        base::BindRepeating(&ExecuteScreencastFrame))),
+      VendorPrefixedCommandMapping(
+          kPost, "session/:sessionId/%s/screenshot_delta",
+          WrapToCommand("ScreenshotDelta",
+                        base::BindRepeating(&ExecuteScreenshotDelta))),
+      VendorPrefixedCommandMapping(
+          kPost, "session/:sessionId/%s/accessibility/computed_labels",
+          WrapToCommand("GetComputedLabels",
+                        base::BindRepeating(&ExecuteGetComputedLabels))),
 
       //
       // Commands used for internal testing only.
@@ -974,13 +1284,30 @@ HttpHandler::HttpHandler(
   };
   command_map_ =
       std::make_unique<CommandMap>(commands, commands + base::size(commands));
+
+  if (g_session_idle_timeout > base::TimeDelta()) {
+    // Sweeping a few times per timeout keeps the reaping delay bounded
+    // without waking the command thread often; each sweep is one atomic
+    // load per session.
+    base::TimeDelta sweep_interval =
+        std::max(g_session_idle_timeout / 4, base::TimeDelta::FromSeconds(1));
+    idle_session_timer_.Start(
+        FROM_HERE, sweep_interval,
+        base::BindRepeating(&HttpHandler::ReapIdleSessions,
+                            base::Unretained(this)));
+  }
 }
 
-HttpHandler::~HttpHandler() {}
+HttpHandler::~HttpHandler() {
+  if (browser_pool_)
+    browser_pool_->Shutdown();
+}
 
 void HttpHandler::Handle(const net::HttpServerRequestInfo& request,
-                         const HttpResponseSenderFunc& send_response_func) {
+                         const HttpResponseSenderFunc& send_response_func,
+                         int connection_id) {
   CHECK(thread_checker_.CalledOnValidThread());
+  ScopedDriverSpan span("HttpHandler::Handle");
 
   if (received_shutdown_)
     return;
@@ -990,13 +1317,14 @@ void HttpHandler::Handle(const net::HttpServerRequestInfo& request,
     std::unique_ptr<net::HttpServerResponseInfo> response(
         new net::HttpServerResponseInfo(net::HTTP_BAD_REQUEST));
     response->SetBody("unhandled request", "text/plain");
-    send_response_func.Run(std::move(response));
+    send_response_func.Run(
+        std::make_unique<HttpResponsePayload>(std::move(response)));
     return;
   }
 
   path.erase(0, url_base_.length());
 
-  HandleCommand(request, path, send_response_func);
+  HandleCommand(request, path, send_response_func, connection_id);
 
   if (path == kShutdownPath)
     received_shutdown_ = true;
@@ -1009,6 +1337,12 @@ base::WeakPtr<HttpHandler> HttpHandler::WeakPtr() {
 Command HttpHandler::WrapToCommand(const char* name,
                                    const SessionCommand& session_command,
                                    bool w3c_standard_command) {
+  // Every session-scoped command is also callable through the batch
+  // endpoint. Batches may not nest, and InitSession is only meaningful
+  // through the new session endpoint.
+  base::StringPiece name_piece(name);
+  if (name_piece != "ExecuteBatch" && name_piece != "InitSession")
+    batch_command_map_[name] = {session_command, w3c_standard_command};
   return base::BindRepeating(&ExecuteSessionCommand, &session_thread_map_, name,
                              session_command, w3c_standard_command, false);
 }
@@ -1032,101 +1366,188 @@ Command HttpHandler::WrapToCommand(const char* name,
 void HttpHandler::HandleCommand(
     const net::HttpServerRequestInfo& request,
     const std::string& trimmed_path,
-    const HttpResponseSenderFunc& send_response_func) {
-  base::DictionaryValue params;
+    const HttpResponseSenderFunc& send_response_func,
+    int connection_id) {
+  auto params = std::make_unique<base::DictionaryValue>();
   std::string session_id;
-  CommandMap::const_iterator iter = command_map_->begin();
-  while (true) {
-    if (iter == command_map_->end()) {
-      if (w3cMode(session_id, session_thread_map_)) {
-        PrepareResponse(
-            trimmed_path, send_response_func,
-            Status(kUnknownCommand, "unknown command: " + trimmed_path),
-            nullptr, session_id, true);
-      } else {
-        std::unique_ptr<net::HttpServerResponseInfo> response(
-            new net::HttpServerResponseInfo(net::HTTP_NOT_FOUND));
-        response->SetBody("unknown command: " + trimmed_path, "text/plain");
-        send_response_func.Run(std::move(response));
-      }
-      return;
-    }
-    if (internal::MatchesCommand(
-            request.method, trimmed_path, *iter, &session_id, &params)) {
-      break;
+  bool accepts_gzip = AcceptsGzip(request);
+  const CommandMapping* command = GetRouteTrie()->Find(
+      request.method, trimmed_path, &session_id, params.get());
+  if (!command) {
+    if (W3cModeForConnection(connection_id, session_id)) {
+      PrepareResponse(
+          trimmed_path, send_response_func, accepts_gzip,
+          Status(kUnknownCommand, "unknown command: " + trimmed_path),
+          nullptr, session_id, true);
+    } else {
+      std::unique_ptr<net::HttpServerResponseInfo> response(
+          new net::HttpServerResponseInfo(net::HTTP_NOT_FOUND));
+      response->SetBody("unknown command: " + trimmed_path, "text/plain");
+      send_response_func.Run(
+          std::make_unique<HttpResponsePayload>(std::move(response)));
     }
-    ++iter;
+    return;
   }
 
+  // The dispatch below tears the session down, so cached bindings to it
+  // must not outlive this request.
+  if (internal::IsDeleteSession(*command))
+    InvalidateSessionBindings(session_id);
+
   if (request.data.length()) {
-    base::DictionaryValue* body_params;
-    std::unique_ptr<base::Value> parsed_body =
-        base::JSONReader::ReadDeprecated(request.data);
-    if (!parsed_body || !parsed_body->GetAsDictionary(&body_params)) {
-      if (w3cMode(session_id, session_thread_map_)) {
-        PrepareResponse(trimmed_path, send_response_func,
-                        Status(kInvalidArgument, "missing command parameters"),
-                        nullptr, session_id, true);
-      } else {
-        std::unique_ptr<net::HttpServerResponseInfo> response(
-            new net::HttpServerResponseInfo(net::HTTP_BAD_REQUEST));
-        response->SetBody("missing command parameters", "text/plain");
-        send_response_func.Run(std::move(response));
-      }
+    if (request.data.length() >= kOffThreadBodyParseThreshold &&
+        base::ThreadPoolInstance::Get()) {
+      // Parsing a body this large blocks this thread for tens of
+      // milliseconds; hand it to a worker and pick the dispatch back up in
+      // FinishCommandWithParsedBody. Command order is preserved per client,
+      // since a client does not send its next command until this one's
+      // response is out.
+      base::ThreadPool::PostTaskAndReplyWithResult(
+          FROM_HERE, {base::TaskPriority::USER_BLOCKING},
+          base::BindOnce(&ParseBodyOnWorkerThread, request.data),
+          base::BindOnce(&HttpHandler::FinishCommandWithParsedBody,
+                         weak_ptr_factory_.GetWeakPtr(), command,
+                         std::move(params), session_id, accepts_gzip,
+                         trimmed_path, send_response_func,
+                         request.GetHeaderValue("host"), connection_id));
       return;
     }
-    params.MergeDictionary(body_params);
-  } else if (iter->method == kPost &&
-             w3cMode(session_id, session_thread_map_)) {
+    FinishCommandWithParsedBody(
+        command, std::move(params), session_id, accepts_gzip, trimmed_path,
+        send_response_func, request.GetHeaderValue("host"), connection_id,
+        ParseJsonHotPath(request.data, base::JSON_PARSE_RFC));
+    return;
+  }
+  if (command->method == kPost &&
+      W3cModeForConnection(connection_id, session_id)) {
     // Data in JSON format is required for POST requests. See step 5 of
     // https://www.w3.org/TR/2018/REC-webdriver1-20180605/#processing-model.
-    PrepareResponse(trimmed_path, send_response_func,
+    PrepareResponse(trimmed_path, send_response_func, accepts_gzip,
                     Status(kInvalidArgument, "missing command parameters"),
                     nullptr, session_id, true);
     return;
   }
+  DispatchCommand(command, std::move(params), session_id, accepts_gzip,
+                  trimmed_path, send_response_func,
+                  request.GetHeaderValue("host"));
+}
+
+void HttpHandler::FinishCommandWithParsedBody(
+    const CommandMapping* command,
+    std::unique_ptr<base::DictionaryValue> params,
+    const std::string& session_id,
+    bool accepts_gzip,
+    const std::string& trimmed_path,
+    const HttpResponseSenderFunc& send_response_func,
+    const std::string& host_header,
+    int connection_id,
+    std::unique_ptr<base::Value> parsed_body) {
+  CHECK(thread_checker_.CalledOnValidThread());
+  base::DictionaryValue* body_params;
+  if (!parsed_body || !parsed_body->GetAsDictionary(&body_params)) {
+    if (W3cModeForConnection(connection_id, session_id)) {
+      PrepareResponse(trimmed_path, send_response_func, accepts_gzip,
+                      Status(kInvalidArgument, "missing command parameters"),
+                      nullptr, session_id, true);
+    } else {
+      std::unique_ptr<net::HttpServerResponseInfo> response(
+          new net::HttpServerResponseInfo(net::HTTP_BAD_REQUEST));
+      response->SetBody("missing command parameters", "text/plain");
+      send_response_func.Run(
+          std::make_unique<HttpResponsePayload>(std::move(response)));
+    }
+    return;
+  }
+  params->MergeDictionary(body_params);
+  DispatchCommand(command, std::move(params), session_id, accepts_gzip,
+                  trimmed_path, send_response_func, host_header);
+}
+
+bool HttpHandler::W3cModeForConnection(int connection_id,
+                                       const std::string& session_id) {
+  if (connection_id < 0 || session_id.empty())
+    return w3cMode(session_id, session_thread_map_);
+  auto it = connection_binding_cache_.find(connection_id);
+  if (it != connection_binding_cache_.end() &&
+      it->second.session_id == session_id) {
+    return it->second.w3c_mode;
+  }
+  // Only bind sessions that exist; an unknown id must keep falling through
+  // to the default so a session created later on this connection is not
+  // shadowed by a stale verdict.
+  auto session_it = session_thread_map_.find(session_id);
+  if (session_it == session_thread_map_.end())
+    return kW3CDefault;
+  bool w3c_mode = session_it->second->w3cMode();
+  connection_binding_cache_[connection_id] = {session_id, w3c_mode};
+  return w3c_mode;
+}
+
+void HttpHandler::InvalidateSessionBindings(const std::string& session_id) {
+  for (auto it = connection_binding_cache_.begin();
+       it != connection_binding_cache_.end();) {
+    if (it->second.session_id == session_id)
+      it = connection_binding_cache_.erase(it);
+    else
+      ++it;
+  }
+}
+
+void HttpHandler::DispatchCommand(
+    const CommandMapping* command,
+    std::unique_ptr<base::DictionaryValue> params,
+    const std::string& session_id,
+    bool accepts_gzip,
+    const std::string& trimmed_path,
+    const HttpResponseSenderFunc& send_response_func,
+    const std::string& host_header) {
+  CommandLatencyHistogram* histogram =
+      CommandMetrics::GetInstance()->GetHistogram(
+          std::string(MethodToString(command->method)) + " /" +
+          command->path_pattern);
   // Pass host instead for potential WebSocketUrl if it's a new session
-  iter->command.Run(params,
-                    internal::IsNewSession(*iter)
-                        ? request.GetHeaderValue("host")
-                        : session_id,
-                    base::BindRepeating(&HttpHandler::PrepareResponse,
-                                        weak_ptr_factory_.GetWeakPtr(),
-                                        trimmed_path, send_response_func));
+  command->command.Run(
+      std::move(params),
+      internal::IsNewSession(*command) ? host_header : session_id,
+      base::BindRepeating(
+          &RecordCommandLatency, histogram, base::TimeTicks::Now(),
+          base::BindRepeating(&HttpHandler::PrepareResponse,
+                              weak_ptr_factory_.GetWeakPtr(), trimmed_path,
+                              send_response_func, accepts_gzip)));
 }
 
 void HttpHandler::PrepareResponse(
     const std::string& trimmed_path,
     const HttpResponseSenderFunc& send_response_func,
+    bool accepts_gzip,
     const Status& status,
     std::unique_ptr<base::Value> value,
     const std::string& session_id,
     bool w3c_compliant) {
   CHECK(thread_checker_.CalledOnValidThread());
-  std::unique_ptr<net::HttpServerResponseInfo> response;
+  std::unique_ptr<HttpResponsePayload> response;
   if (w3c_compliant)
-    response = PrepareStandardResponse(
-        trimmed_path, status, std::move(value), session_id);
+    response = PrepareStandardResponse(trimmed_path, status, std::move(value),
+                                       session_id, accepts_gzip);
   else
-    response = PrepareLegacyResponse(trimmed_path,
-                                     status,
-                                     std::move(value),
-                                     session_id);
+    response = PrepareLegacyResponse(trimmed_path, status, std::move(value),
+                                     session_id, accepts_gzip);
   send_response_func.Run(std::move(response));
   if (trimmed_path == kShutdownPath)
     quit_func_.Run();
 }
 
-std::unique_ptr<net::HttpServerResponseInfo> HttpHandler::PrepareLegacyResponse(
+std::unique_ptr<HttpResponsePayload> HttpHandler::PrepareLegacyResponse(
     const std::string& trimmed_path,
     const Status& status,
     std::unique_ptr<base::Value> value,
-    const std::string& session_id) {
+    const std::string& session_id,
+    bool accepts_gzip) {
   if (status.code() == kUnknownCommand) {
     std::unique_ptr<net::HttpServerResponseInfo> response(
         new net::HttpServerResponseInfo(net::HTTP_NOT_IMPLEMENTED));
     response->SetBody("unimplemented command: " + trimmed_path, "text/plain");
-    return response;
+    return std::make_unique<HttpResponsePayload>(std::move(response));
   }
 
   if (status.IsError()) {
@@ -1141,6 +1562,23 @@ std::unique_ptr<net::HttpServerResponseInfo> HttpHandler::PrepareLegacyResponse(
     error->SetString("message", full_status.message());
     value = std::move(error);
   }
+  // Most commands return null or a small scalar; render those into the
+  // envelope template directly instead of building and serializing a Value
+  // tree. Keys stay in JSONWriter's alphabetical order, so the bytes match
+  // the slow path exactly.
+  if (status.IsOk()) {
+    std::string body = "{\"sessionId\":";
+    body += SessionIdJsonFragment(session_id);
+    body += ",\"status\":0,\"value\":";
+    if (RenderScalarResult(value.get(), &body)) {
+      body += "}";
+      auto payload = std::make_unique<HttpResponsePayload>(
+          std::make_unique<net::HttpServerResponseInfo>(net::HTTP_OK));
+      SetJsonBody(payload.get(), accepts_gzip, std::move(body));
+      return payload;
+    }
+  }
+
   if (!value)
     value = std::make_unique<base::Value>();
 
@@ -1152,18 +1590,36 @@ std::unique_ptr<net::HttpServerResponseInfo> HttpHandler::PrepareLegacyResponse(
   base::JSONWriter::WriteWithOptions(
       body_params, base::JSONWriter::OPTIONS_OMIT_DOUBLE_TYPE_PRESERVATION,
       &body);
-  std::unique_ptr<net::HttpServerResponseInfo> response(
-      new net::HttpServerResponseInfo(net::HTTP_OK));
-  response->SetBody(body, "application/json; charset=utf-8");
-  return response;
+  // Drop the Value tree before the body is handed off, so a large payload
+  // never exists in three copies at once.
+  body_params.DictClear();
+  auto payload = std::make_unique<HttpResponsePayload>(
+      std::make_unique<net::HttpServerResponseInfo>(net::HTTP_OK));
+  SetJsonBody(payload.get(), accepts_gzip, std::move(body));
+  return payload;
 }
 
-std::unique_ptr<net::HttpServerResponseInfo>
-HttpHandler::PrepareStandardResponse(
+const std::string& HttpHandler::SessionIdJsonFragment(
+    const std::string& session_id) {
+  auto it = session_id_json_cache_.find(session_id);
+  if (it != session_id_json_cache_.end())
+    return it->second;
+  // A long-lived server sees many session ids; keep the cache small since
+  // re-escaping is cheap compared to letting it grow without bound.
+  if (session_id_json_cache_.size() > 128)
+    session_id_json_cache_.clear();
+  std::string fragment;
+  base::EscapeJSONString(session_id, true /*put_in_quotes*/, &fragment);
+  return session_id_json_cache_.emplace(session_id, std::move(fragment))
+      .first->second;
+}
+
+std::unique_ptr<HttpResponsePayload> HttpHandler::PrepareStandardResponse(
     const std::string& trimmed_path,
     const Status& status,
     std::unique_ptr<base::Value> value,
-    const std::string& session_id) {
+    const std::string& session_id,
+    bool accepts_gzip) {
   std::unique_ptr<net::HttpServerResponseInfo> response;
   switch (status.code()) {
     case kOk:
@@ -1266,6 +1722,12 @@ HttpHandler::PrepareStandardResponse(
       response =
           std::make_unique<net::HttpServerResponseInfo>(net::HTTP_NOT_FOUND);
       break;
+    case kSessionOverloaded:
+      // Load shedding: the session's command queue is full, so tell the
+      // client to back off rather than queue the request.
+      response = std::make_unique<net::HttpServerResponseInfo>(
+          net::HTTP_SERVICE_UNAVAILABLE);
+      break;
 
     // TODO(kereliuk): evaluate the usage of these as they relate to the spec
     case kElementNotVisible:
@@ -1289,6 +1751,40 @@ HttpHandler::PrepareStandardResponse(
       break;
   }
 
+  // Scalar fast path mirroring PrepareLegacyResponse: the W3C envelope for
+  // a successful null or scalar result is a fixed template around the
+  // rendered value.
+  if (status.IsOk()) {
+    std::string body = "{\"value\":";
+    if (RenderScalarResult(value.get(), &body)) {
+      body += "}";
+      auto payload = std::make_unique<HttpResponsePayload>(std::move(response));
+      SetJsonBody(payload.get(), accepts_gzip, std::move(body));
+      payload->info->AddHeader("cache-control", "no-cache");
+      return payload;
+    }
+  }
+
+  base::DictionaryValue body_params =
+      CreateStandardResponseBody(status, std::move(value));
+
+  std::string body;
+  base::JSONWriter::WriteWithOptions(
+      body_params, base::JSONWriter::OPTIONS_OMIT_DOUBLE_TYPE_PRESERVATION,
+      &body);
+  // Drop the Value tree before the body is handed off, so a large payload
+  // (e.g. a screenshot) never exists in three copies at once.
+  body_params.DictClear();
+  auto payload = std::make_unique<HttpResponsePayload>(std::move(response));
+  SetJsonBody(payload.get(), accepts_gzip, std::move(body));
+  payload->info->AddHeader("cache-control", "no-cache");
+  return payload;
+}
+
+// static
+base::DictionaryValue HttpHandler::CreateStandardResponseBody(
+    const Status& status,
+    std::unique_ptr<base::Value> value) {
   if (!value)
     value = std::make_unique<base::Value>();
 
@@ -1320,14 +1816,18 @@ HttpHandler::PrepareStandardResponse(
   } else {
     body_params.Set("value", std::move(value));
   }
+  return body_params;
+}
 
-  std::string body;
-  base::JSONWriter::WriteWithOptions(
-      body_params, base::JSONWriter::OPTIONS_OMIT_DOUBLE_TYPE_PRESERVATION,
-      &body);
-  response->SetBody(body, "application/json; charset=utf-8");
-  response->AddHeader("cache-control", "no-cache");
-  return response;
+internal::RouteTrie* HttpHandler::GetRouteTrie() {
+  if (!route_trie_) {
+    // Built lazily rather than in the constructor because tests install
+    // their own command maps after constructing the handler.
+    route_trie_ = std::make_unique<internal::RouteTrie>();
+    for (const CommandMapping& mapping : *command_map_)
+      route_trie_->Add(mapping);
+  }
+  return route_trie_.get();
 }
 
 void HttpHandler::OnWebSocketRequest(HttpServer* http_server,
@@ -1364,6 +1864,9 @@ void HttpHandler::OnWebSocketRequest(HttpServer* http_server,
   } else {
     session_connection_map_[session_id] = connection_id;
     connection_session_map_[connection_id] = session_id;
+    // Remember which server accepted the channel, so unsolicited frames
+    // (log batches) can be routed back through it.
+    session_websocket_server_map_[session_id] = http_server;
     io_task_runner_->PostTask(
         FROM_HERE,
         base::BindOnce(&HttpServer::AcceptWebSocket,
@@ -1371,15 +1874,187 @@ void HttpHandler::OnWebSocketRequest(HttpServer* http_server,
   }
 }
 
+void HttpHandler::OnWebSocketMessage(HttpServer* http_server,
+                                     int connection_id,
+                                     const std::string& data) {
+  CHECK(thread_checker_.CalledOnValidThread());
+  auto it = connection_session_map_.find(connection_id);
+  if (it == connection_session_map_.end()) {
+    // The connection was closed before the message was processed.
+    return;
+  }
+  const std::string session_id = it->second;
+
+  std::unique_ptr<base::Value> parsed =
+      ParseJsonHotPath(data, base::JSON_PARSE_RFC);
+  base::DictionaryValue* frame = nullptr;
+  if (!parsed || !parsed->GetAsDictionary(&frame)) {
+    SendWebSocketFrame(
+        http_server, connection_id,
+        CreateStandardResponseBody(
+            Status(kInvalidArgument, "frame must be a JSON object"), nullptr));
+    return;
+  }
+  int frame_id;
+  if (!frame->GetInteger("id", &frame_id)) {
+    SendWebSocketFrame(
+        http_server, connection_id,
+        CreateStandardResponseBody(
+            Status(kInvalidArgument, "frame has no integer 'id'"), nullptr));
+    return;
+  }
+
+  std::string method = "POST";
+  frame->GetString("method", &method);
+  std::string command_path;
+  frame->GetString("path", &command_path);
+  // The connection is bound to one session, so frames address endpoints
+  // relative to session/:sessionId; an empty path is the session itself.
+  std::string full_path = "session/" + session_id;
+  if (!command_path.empty())
+    full_path += "/" + command_path;
+
+  auto params = std::make_unique<base::DictionaryValue>();
+  std::string path_session_id;
+  const CommandMapping* command =
+      GetRouteTrie()->Find(method, full_path, &path_session_id, params.get());
+  if (!command) {
+    base::DictionaryValue body = CreateStandardResponseBody(
+        Status(kUnknownCommand, "unknown command: " + full_path), nullptr);
+    body.SetInteger("id", frame_id);
+    SendWebSocketFrame(http_server, connection_id, body);
+    return;
+  }
+  const base::DictionaryValue* frame_params;
+  if (frame->GetDictionary("parameters", &frame_params))
+    params->MergeDictionary(frame_params);
+
+  command->command.Run(
+      std::move(params), session_id,
+      base::BindRepeating(&HttpHandler::OnWebSocketCommandResponse,
+                          weak_ptr_factory_.GetWeakPtr(), http_server,
+                          connection_id, frame_id));
+}
+
+void HttpHandler::OnWebSocketCommandResponse(
+    HttpServer* http_server,
+    int connection_id,
+    int frame_id,
+    const Status& status,
+    std::unique_ptr<base::Value> value,
+    const std::string& session_id,
+    bool w3c_compliant) {
+  CHECK(thread_checker_.CalledOnValidThread());
+  // The channel always speaks the W3C wire format; the legacy format
+  // predates it and has no WebSocket clients.
+  base::DictionaryValue body =
+      CreateStandardResponseBody(status, std::move(value));
+  body.SetInteger("id", frame_id);
+  SendWebSocketFrame(http_server, connection_id, body);
+}
+
+void HttpHandler::SendWebSocketFrame(HttpServer* http_server,
+                                     int connection_id,
+                                     const base::DictionaryValue& body) {
+  std::string message;
+  base::JSONWriter::WriteWithOptions(
+      body, base::JSONWriter::OPTIONS_OMIT_DOUBLE_TYPE_PRESERVATION, &message);
+  io_task_runner_->PostTask(
+      FROM_HERE,
+      base::BindOnce(&HttpServer::SendOverWebSocket,
+                     base::Unretained(http_server), connection_id,
+                     std::move(message)));
+}
+
 void HttpHandler::OnClose(HttpServer* http_server, int connection_id) {
+  connection_binding_cache_.erase(connection_id);
+  auto http_it = http_connection_session_map_.find(connection_id);
+  if (http_it != http_connection_session_map_.end()) {
+    // The connection dropped with a command still in flight; ask the
+    // session's waits to bail out instead of running out their timeouts.
+    auto session_it = session_thread_map_.find(http_it->second);
+    if (session_it != session_thread_map_.end()) {
+      VLOG(0) << "Client closed the connection for session " << http_it->second
+              << " with a command in flight; cancelling";
+      session_it->second->RequestCommandCancellation();
+    }
+    http_connection_session_map_.erase(http_it);
+  }
+
   auto it = connection_session_map_.find(connection_id);
   if (it == connection_session_map_.end()) {
     return;
   }
   session_connection_map_[it->second] = -1;
+  session_websocket_server_map_.erase(it->second);
   connection_session_map_.erase(it);
 }
 
+void HttpHandler::SendLogFrameForSession(const std::string& session_id,
+                                         const std::string& frame) {
+  CHECK(thread_checker_.CalledOnValidThread());
+  auto connection_it = session_connection_map_.find(session_id);
+  auto server_it = session_websocket_server_map_.find(session_id);
+  if (connection_it == session_connection_map_.end() ||
+      connection_it->second == -1 ||
+      server_it == session_websocket_server_map_.end()) {
+    // No WebSocket channel right now; the batch is dropped, like entries a
+    // polling client never fetched.
+    return;
+  }
+  io_task_runner_->PostTask(
+      FROM_HERE, base::BindOnce(&HttpServer::SendOverWebSocket,
+                                base::Unretained(server_it->second),
+                                connection_it->second, frame));
+}
+
+void HttpHandler::OnHttpRequestStart(int connection_id,
+                                     const std::string& path) {
+  const std::string prefix = url_base_ + "session/";
+  if (!base::StartsWith(path, prefix, base::CompareCase::SENSITIVE))
+    return;
+  size_t end = path.find('/', prefix.length());
+  std::string session_id =
+      path.substr(prefix.length(), end == std::string::npos
+                                       ? std::string::npos
+                                       : end - prefix.length());
+  if (session_id.empty())
+    return;
+  http_connection_session_map_[connection_id] = session_id;
+}
+
+void HttpHandler::OnHttpRequestDone(int connection_id) {
+  http_connection_session_map_.erase(connection_id);
+}
+
+void HttpHandler::ReapIdleSessions() {
+  base::TimeTicks cutoff = base::TimeTicks::Now() - g_session_idle_timeout;
+  // Collect ids first: quitting goes through ExecuteSessionCommand, which
+  // must not run while this loop holds iterators into the map.
+  std::vector<std::string> expired;
+  for (const auto& entry : session_thread_map_) {
+    if (entry.second->LastActivity() < cutoff)
+      expired.push_back(entry.first);
+  }
+  for (const std::string& session_id : expired) {
+    LOG(WARNING) << "quitting session " << session_id << ": no command for "
+                 << g_session_idle_timeout.InSeconds() << " seconds";
+    // The same teardown as DELETE /session/:sessionId, so the browser is
+    // killed and the session thread is joined in the background.
+    ExecuteSessionCommand(&session_thread_map_, "Quit",
+                          base::BindRepeating(&ExecuteQuit, false),
+                          true /*w3c_standard_command*/,
+                          true /*return_ok_without_session*/,
+                          std::make_unique<base::DictionaryValue>(), session_id,
+                          base::BindRepeating(&OnIdleSessionQuit));
+  }
+}
+
+// static
+void HttpHandler::SetSessionIdleTimeout(base::TimeDelta timeout) {
+  g_session_idle_timeout = timeout;
+}
+
 void HttpHandler::SendWebSocketRejectResponse(HttpServer* http_server,
                                               int connection_id,
                                               net::HttpStatusCode code,
@@ -1396,6 +2071,125 @@ namespace internal {
 
 const char kNewSessionPathPattern[] = "session";
 
+namespace {
+
+// URL-decodes one path segment the way command patterns expect.
+std::string DecodePathSegment(base::StringPiece segment) {
+  url::RawCanonOutputT<char16_t> output;
+  url::DecodeURLEscapeSequences(segment.data(), segment.length(),
+                                url::DecodeURLMode::kUTF8OrIsomorphic, &output);
+  std::string decoded =
+      base::UTF16ToASCII(std::u16string(output.data(), output.length()));
+  // Due to crbug.com/533361, the url decoding libraries decodes all of the
+  // % escape sequences except for %%. We need to handle this case manually.
+  // So, replacing all the instances of "%%" with "%".
+  base::ReplaceSubstringsAfterOffset(&decoded, 0, "%%", "%");
+  return decoded;
+}
+
+// Maps an HTTP method string to its HttpMethod value, or -1 if unknown.
+int MethodToIndex(const std::string& method) {
+  std::string lower_method = base::ToLowerASCII(method);
+  if (lower_method == "get")
+    return kGet;
+  if (lower_method == "post" || lower_method == "put")
+    return kPost;
+  if (lower_method == "delete")
+    return kDelete;
+  return -1;
+}
+
+}  // namespace
+
+struct RouteTrie::Node {
+  Node() : terminals() {}
+  ~Node() = default;
+
+  // Children for literal path segments, and the single child shared by all
+  // ":name" captures at this position. Which capture name applies is
+  // recovered from the matched command's pattern, so commands with
+  // different capture names can share nodes.
+  std::map<std::string, std::unique_ptr<Node>, std::less<>> literals;
+  std::unique_ptr<Node> wildcard;
+  // Indexed by HttpMethod; the command whose pattern ends at this node.
+  const CommandMapping* terminals[3];
+};
+
+RouteTrie::RouteTrie() : root_(std::make_unique<Node>()) {}
+
+RouteTrie::~RouteTrie() = default;
+
+void RouteTrie::Add(const CommandMapping& command) {
+  std::vector<std::string> pattern_parts =
+      base::SplitString(command.path_pattern, "/", base::TRIM_WHITESPACE,
+                        base::SPLIT_WANT_ALL);
+  Node* node = root_.get();
+  for (const std::string& part : pattern_parts) {
+    CHECK(part.length());
+    if (part[0] == ':') {
+      if (!node->wildcard)
+        node->wildcard = std::make_unique<Node>();
+      node = node->wildcard.get();
+    } else {
+      std::unique_ptr<Node>& child = node->literals[part];
+      if (!child)
+        child = std::make_unique<Node>();
+      node = child.get();
+    }
+  }
+  if (!node->terminals[command.method])
+    node->terminals[command.method] = &command;
+}
+
+const CommandMapping* RouteTrie::Match(
+    const Node* node,
+    const std::vector<base::StringPiece>& path_parts,
+    size_t part_index,
+    HttpMethod method) const {
+  if (part_index == path_parts.size())
+    return node->terminals[method];
+  auto it = node->literals.find(path_parts[part_index]);
+  if (it != node->literals.end()) {
+    const CommandMapping* command =
+        Match(it->second.get(), path_parts, part_index + 1, method);
+    if (command)
+      return command;
+  }
+  if (node->wildcard)
+    return Match(node->wildcard.get(), path_parts, part_index + 1, method);
+  return nullptr;
+}
+
+const CommandMapping* RouteTrie::Find(const std::string& method,
+                                      const std::string& path,
+                                      std::string* session_id,
+                                      base::DictionaryValue* out_params) const {
+  const int method_index = MethodToIndex(method);
+  if (method_index < 0)
+    return nullptr;
+  std::vector<base::StringPiece> path_parts = base::SplitStringPiece(
+      path, "/", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
+  const CommandMapping* command = Match(
+      root_.get(), path_parts, 0, static_cast<HttpMethod>(method_index));
+  if (!command)
+    return nullptr;
+
+  // Extract the ":name" captures using the matched pattern.
+  std::vector<base::StringPiece> pattern_parts = base::SplitStringPiece(
+      command->path_pattern, "/", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
+  for (size_t i = 0; i < path_parts.size(); ++i) {
+    if (pattern_parts[i][0] != ':')
+      continue;
+    std::string name(pattern_parts[i].substr(1));
+    std::string decoded = DecodePathSegment(path_parts[i]);
+    if (name == "sessionId")
+      *session_id = decoded;
+    else
+      out_params->SetString(name, decoded);
+  }
+  return command;
+}
+
 bool MatchesMethod(HttpMethod command_method, const std::string& method) {
   std::string lower_method = base::ToLowerASCII(method);
   switch (command_method) {
@@ -1431,16 +2225,7 @@ bool MatchesCommand(const std::string& method,
       std::string name = command_path_parts[i];
       name.erase(0, 1);
       CHECK(name.length());
-      url::RawCanonOutputT<char16_t> output;
-      url::DecodeURLEscapeSequences(
-          path_parts[i].data(), path_parts[i].length(),
-          url::DecodeURLMode::kUTF8OrIsomorphic, &output);
-      std::string decoded =
-          base::UTF16ToASCII(std::u16string(output.data(), output.length()));
-      // Due to crbug.com/533361, the url decoding libraries decodes all of the
-      // % escape sequences except for %%. We need to handle this case manually.
-      // So, replacing all the instances of "%%" with "%".
-      base::ReplaceSubstringsAfterOffset(&decoded, 0 , "%%" , "%");
+      std::string decoded = DecodePathSegment(path_parts[i]);
       if (name == "sessionId")
         *session_id = decoded;
       else
@@ -1458,4 +2243,9 @@ bool IsNewSession(const CommandMapping& command) {
          command.path_pattern == kNewSessionPathPattern;
 }
 
+bool IsDeleteSession(const CommandMapping& command) {
+  return command.method == kDelete &&
+         command.path_pattern == "session/:sessionId";
+}
+
 }  // namespace internal
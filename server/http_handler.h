@@ -5,6 +5,7 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_SERVER_HTTP_HANDLER_H_
 #define CHROME_TEST_CHROMEDRIVER_SERVER_HTTP_HANDLER_H_
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -14,8 +15,11 @@
 #include "base/gtest_prod_util.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/ref_counted_memory.h"
 #include "base/memory/weak_ptr.h"
+#include "base/strings/string_piece.h"
 #include "base/threading/thread_checker.h"
+#include "base/timer/timer.h"
 #include "chrome/test/chromedriver/command.h"
 #include "chrome/test/chromedriver/commands.h"
 #include "chrome/test/chromedriver/connection_session_map.h"
@@ -30,6 +34,7 @@
 namespace base {
 class DictionaryValue;
 class SingleThreadTaskRunner;
+class Value;
 }
 
 namespace net {
@@ -42,12 +47,17 @@ class TransitionalURLLoaderFactoryOwner;
 }
 
 class Adb;
+class BrowserPool;
 class DeviceManager;
 class URLRequestContextGetter;
 class WrapperURLLoaderFactory;
 
 class HttpServer;
 
+namespace internal {
+class RouteTrie;
+}
+
 enum HttpMethod {
   kGet,
   kPost,
@@ -69,8 +79,24 @@ struct CommandMapping {
 extern const char kCreateWebSocketPath[];
 extern const char kSendCommandFromWebSocket[];
 
-typedef base::RepeatingCallback<void(
-    std::unique_ptr<net::HttpServerResponseInfo>)>
+// A prepared response on its way from the command thread to an IO thread.
+// Headers and small bodies travel inside |info| as before; a large body
+// (a screenshot or PDF) travels in |body| instead, ref-counted so
+// preparation, the cross-thread handoff, and the write path all share one
+// allocation rather than copying megabytes at each step. When |body| is
+// set, |info| already carries the Content-Length and Content-Type headers
+// and its own body is empty.
+struct HttpResponsePayload {
+  HttpResponsePayload();
+  explicit HttpResponsePayload(
+      std::unique_ptr<net::HttpServerResponseInfo> info);
+  ~HttpResponsePayload();
+
+  std::unique_ptr<net::HttpServerResponseInfo> info;
+  scoped_refptr<base::RefCountedString> body;
+};
+
+typedef base::RepeatingCallback<void(std::unique_ptr<HttpResponsePayload>)>
     HttpResponseSenderFunc;
 
 class HttpHandler {
@@ -83,11 +109,20 @@ class HttpHandler {
               int adb_port);
   ~HttpHandler();
 
+  // |connection_id| identifies the client connection the request arrived on
+  // and keys the per-connection session binding cache; -1 (used by tests)
+  // bypasses the cache.
   void Handle(const net::HttpServerRequestInfo& request,
-              const HttpResponseSenderFunc& send_response_func);
+              const HttpResponseSenderFunc& send_response_func,
+              int connection_id = -1);
 
   base::WeakPtr<HttpHandler> WeakPtr();
 
+  // Sets how long a session may go without receiving a command before it is
+  // quit by the idle-session reaper. Zero (the default) disables reaping.
+  // Called once at startup, before the handler is constructed.
+  static void SetSessionIdleTimeout(base::TimeDelta timeout);
+
  private:
   FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, HandleUnknownCommand);
   FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, HandleNewSession);
@@ -95,6 +130,20 @@ class HttpHandler {
   FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, HandleUnimplementedCommand);
   FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, HandleCommand);
   FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, StandardResponse_ErrorNoMessage);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, StandardResponse_ScalarFastPath);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, LegacyResponse_ScalarFastPath);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, StandardResponse_GzipLargeBody);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest,
+                           StandardResponse_RefCountedLargeBody);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, CancelsInFlightCommandOnClose);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, LargeBodyParsedOffThread);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, LargeInvalidBodyRejected);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, ResponseClearsInFlightRecord);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, ConnectionBindingCachesW3cMode);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerTest, ConnectionBindingInvalidation);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerLoadTest, StubBackedSessionThroughput);
+  FRIEND_TEST_ALL_PREFIXES(HttpHandlerLoadTest,
+                           StubBackedSessionWithBrowserLatency);
   typedef std::vector<CommandMapping> CommandMap;
 
   friend class HttpServer;
@@ -110,36 +159,128 @@ class HttpHandler {
                         bool w3c_standard_command = true);
   void HandleCommand(const net::HttpServerRequestInfo& request,
                      const std::string& trimmed_path,
-                     const HttpResponseSenderFunc& send_response_func);
+                     const HttpResponseSenderFunc& send_response_func,
+                     int connection_id);
+  // Continues HandleCommand once the request body has been parsed, either
+  // inline or on a worker thread for bodies large enough to block this
+  // thread noticeably. |parsed_body| is null if the body was not valid JSON.
+  void FinishCommandWithParsedBody(
+      const CommandMapping* command,
+      std::unique_ptr<base::DictionaryValue> params,
+      const std::string& session_id,
+      bool accepts_gzip,
+      const std::string& trimmed_path,
+      const HttpResponseSenderFunc& send_response_func,
+      const std::string& host_header,
+      int connection_id,
+      std::unique_ptr<base::Value> parsed_body);
+  // w3cMode resolution through the per-connection binding cache: with HTTP
+  // keep-alive one connection serves the same session for thousands of
+  // consecutive requests, so after the first resolution the session map
+  // lookup shrinks to an id comparison. Entries drop with their connection
+  // and when their session is deleted.
+  bool W3cModeForConnection(int connection_id, const std::string& session_id);
+  // Drops every cached binding to |session_id|; called when the dispatch
+  // about to run will delete that session.
+  void InvalidateSessionBindings(const std::string& session_id);
+  // Tail of HandleCommand: records latency metrics and runs |command|.
+  void DispatchCommand(const CommandMapping* command,
+                       std::unique_ptr<base::DictionaryValue> params,
+                       const std::string& session_id,
+                       bool accepts_gzip,
+                       const std::string& trimmed_path,
+                       const HttpResponseSenderFunc& send_response_func,
+                       const std::string& host_header);
+  // |accepts_gzip| is whether the client's Accept-Encoding allows a
+  // gzip-compressed response body; large JSON bodies are compressed then.
   void PrepareResponse(const std::string& trimmed_path,
                        const HttpResponseSenderFunc& send_response_func,
+                       bool accepts_gzip,
                        const Status& status,
                        std::unique_ptr<base::Value> value,
                        const std::string& session_id,
                        bool w3c_compliant);
-  std::unique_ptr<net::HttpServerResponseInfo> PrepareLegacyResponse(
+  std::unique_ptr<HttpResponsePayload> PrepareLegacyResponse(
       const std::string& trimmed_path,
       const Status& status,
       std::unique_ptr<base::Value> value,
-      const std::string& session_id);
+      const std::string& session_id,
+      bool accepts_gzip);
 
-  std::unique_ptr<net::HttpServerResponseInfo> PrepareStandardResponse(
+  std::unique_ptr<HttpResponsePayload> PrepareStandardResponse(
       const std::string& trimmed_path,
       const Status& status,
       std::unique_ptr<base::Value> value,
-      const std::string& session_id);
+      const std::string& session_id,
+      bool accepts_gzip);
 
   void OnWebSocketRequest(HttpServer* http_server,
                           int connection_id,
                           const net::HttpServerRequestInfo& info);
 
+  // Handles a WebDriver command frame received over a session's WebSocket:
+  // {"id": <int>, "method": <HTTP method, default POST>, "path": <endpoint
+  // path relative to session/:sessionId>, "parameters": <dict>}. The frame
+  // is routed through the same CommandMapping table as HTTP requests; the
+  // response frame carries the standard W3C response body plus the echoed
+  // "id", so a long-lived client can skip per-command HTTP framing.
+  void OnWebSocketMessage(HttpServer* http_server,
+                          int connection_id,
+                          const std::string& data);
+
   void OnClose(HttpServer* http_server, int connection_id);
 
+  // Sends one already-serialized push frame (a log batch or an
+  // async-navigation completion) over the session's WebSocket channel,
+  // dropping it when the session has no channel connected. Runs on the
+  // command thread; bound into the chromium/subscribe_logs and
+  // chromium/navigate_async commands.
+  void SendLogFrameForSession(const std::string& session_id,
+                              const std::string& frame);
+
+  // Records which session the HTTP request on |connection_id| targets, so a
+  // close before the response is out can cancel the in-flight command.
+  void OnHttpRequestStart(int connection_id, const std::string& path);
+
+  // Clears the record once the response for |connection_id| is sent.
+  void OnHttpRequestDone(int connection_id);
+
+  // Timer callback: quits every session whose last command dispatch is
+  // older than the configured idle timeout, through the same path as
+  // DELETE /session/:sessionId.
+  void ReapIdleSessions();
+
   void SendWebSocketRejectResponse(HttpServer* http_server,
                                    int connection_id,
                                    net::HttpStatusCode code,
                                    const std::string& msg);
 
+  // Returns |route_trie_|, compiling it from |command_map_| on first use.
+  internal::RouteTrie* GetRouteTrie();
+
+  // Builds the body of a W3C response: {"value": <result or error dict>}.
+  static base::DictionaryValue CreateStandardResponseBody(
+      const Status& status,
+      std::unique_ptr<base::Value> value);
+
+  // Returns the session id rendered as a quoted, escaped JSON fragment,
+  // cached per session for the envelope fast path.
+  const std::string& SessionIdJsonFragment(const std::string& session_id);
+
+  // Completion callback for commands started by OnWebSocketMessage.
+  void OnWebSocketCommandResponse(HttpServer* http_server,
+                                  int connection_id,
+                                  int frame_id,
+                                  const Status& status,
+                                  std::unique_ptr<base::Value> value,
+                                  const std::string& session_id,
+                                  bool w3c_compliant);
+
+  // Serializes |body| and sends it over the WebSocket on the IO thread.
+  void SendWebSocketFrame(HttpServer* http_server,
+                          int connection_id,
+                          const base::DictionaryValue& body);
+
   base::ThreadChecker thread_checker_;
   base::RepeatingClosure quit_func_;
   scoped_refptr<base::SingleThreadTaskRunner> io_task_runner_;
@@ -153,9 +294,37 @@ class HttpHandler {
   SessionThreadMap session_thread_map_;
   SessionConnectionMap session_connection_map_;
   ConnectionSessionMap connection_session_map_;
+  // The HttpServer that accepted each session's WebSocket channel; there is
+  // one server per IO thread, and unsolicited frames must go back through
+  // the right one. Entries live as long as the channel.
+  std::map<std::string, HttpServer*> session_websocket_server_map_;
+  // Session targeted by the HTTP request currently in flight on each
+  // connection; entries live from request start until the response is sent.
+  std::map<int, std::string> http_connection_session_map_;
+  // See W3cModeForConnection.
+  struct ConnectionSessionBinding {
+    std::string session_id;
+    bool w3c_mode;
+  };
+  std::map<int, ConnectionSessionBinding> connection_binding_cache_;
   std::unique_ptr<CommandMap> command_map_;
+  // Session commands callable through the batch endpoint, keyed by command
+  // name. Populated as a side effect of WrapToCommand during construction
+  // and read-only afterwards, so session threads may read it without locks.
+  BatchCommandMap batch_command_map_;
+  // Compiled from |command_map_| on the first request, so tests can install
+  // their own command maps after construction.
+  std::unique_ptr<internal::RouteTrie> route_trie_;
+  // Session ids pre-rendered as quoted JSON fragments for the envelope
+  // fast path. Only touched on the command thread, like all responses.
+  std::map<std::string, std::string> session_id_json_cache_;
   std::unique_ptr<Adb> adb_;
   std::unique_ptr<DeviceManager> device_manager_;
+  // Periodically runs ReapIdleSessions on the command thread; only started
+  // when an idle timeout is configured.
+  base::RepeatingTimer idle_session_timer_;
+  // Declared after the factories it uses, so it is shut down first.
+  scoped_refptr<BrowserPool> browser_pool_;
 
   base::WeakPtrFactory<HttpHandler> weak_ptr_factory_{this};
 
@@ -166,6 +335,41 @@ namespace internal {
 
 extern const char kNewSessionPathPattern[];
 
+// Compiled dispatch structure for CommandMapping path patterns. Requests
+// walk one node per path segment instead of being tokenized against every
+// pattern in the command list.
+class RouteTrie {
+ public:
+  RouteTrie();
+  ~RouteTrie();
+
+  // Adds |command| to the trie. |command| must outlive this object. When
+  // several commands collide on method and pattern, the first one added
+  // wins, matching the old linear scan.
+  void Add(const CommandMapping& command);
+
+  // Returns the command matching |method| and |path|, or null. On a match,
+  // URL-decoded ":name" captures are stored in |out_params|, except
+  // ":sessionId" which goes to |session_id|, as MatchesCommand does.
+  // Literal segments take precedence over ":name" captures.
+  const CommandMapping* Find(const std::string& method,
+                             const std::string& path,
+                             std::string* session_id,
+                             base::DictionaryValue* out_params) const;
+
+ private:
+  struct Node;
+
+  const CommandMapping* Match(const Node* node,
+                              const std::vector<base::StringPiece>& path_parts,
+                              size_t part_index,
+                              HttpMethod method) const;
+
+  std::unique_ptr<Node> root_;
+
+  DISALLOW_COPY_AND_ASSIGN(RouteTrie);
+};
+
 bool MatchesCommand(const std::string& method,
                     const std::string& path,
                     const CommandMapping& command,
@@ -174,6 +378,8 @@ bool MatchesCommand(const std::string& method,
 
 bool IsNewSession(const CommandMapping& command);
 
+bool IsDeleteSession(const CommandMapping& command);
+
 }  // namespace internal
 
 #endif  // CHROME_TEST_CHROMEDRIVER_SERVER_HTTP_HANDLER_H_
@@ -0,0 +1,63 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "chrome/test/chromedriver/benchmark_util.h"
+#include "chrome/test/chromedriver/server/http_handler.h"
+#include "net/server/http_server_request_info.h"
+#include "net/server/http_server_response_info.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kRuns = 5000;
+
+void DiscardResponse(std::unique_ptr<HttpResponsePayload> response) {}
+
+// Routes one request through the full command table and response
+// preparation. No session exists, so matched session commands return
+// kInvalidSessionId without touching a browser; the measured work is the
+// routing, parameter parsing and response serialization that every real
+// command also pays.
+void HandleRequest(HttpHandler* handler,
+                   const std::string& method,
+                   const std::string& path,
+                   const std::string& data) {
+  net::HttpServerRequestInfo request;
+  request.method = method;
+  request.path = path;
+  request.data = data;
+  handler->Handle(request, base::BindRepeating(&DiscardResponse));
+}
+
+}  // namespace
+
+TEST(HttpHandlerBenchmark, RouteElementClick) {
+  HttpHandler handler("/");
+  benchmark::RunAndReport(
+      "ChromeDriver.HttpHandlerRouting", "element_click", kRuns,
+      base::BindRepeating(&HandleRequest, &handler, "post",
+                          "/session/some-session-id/element/elem-id/click",
+                          "{}"));
+}
+
+TEST(HttpHandlerBenchmark, RouteStatus) {
+  HttpHandler handler("/");
+  benchmark::RunAndReport(
+      "ChromeDriver.HttpHandlerRouting", "status", kRuns,
+      base::BindRepeating(&HandleRequest, &handler, "get", "/status",
+                          std::string()));
+}
+
+TEST(HttpHandlerBenchmark, RouteUnknownCommand) {
+  HttpHandler handler("/");
+  benchmark::RunAndReport(
+      "ChromeDriver.HttpHandlerRouting", "unknown_command", kRuns,
+      base::BindRepeating(&HandleRequest, &handler, "get",
+                          "/session/some-session-id/no/such/command",
+                          std::string()));
+}
@@ -0,0 +1,249 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Load test for ChromeDriver's own dispatch overhead. It stands up the real
+// HttpHandler and session-thread machinery, but backs the session with stub
+// Chrome/WebView objects that answer from canned data, so the measured
+// numbers contain everything ChromeDriver does per command - routing,
+// cmd/session thread hops, parameter copies, response serialization - and
+// nothing the browser does. Regressions in the dispatch path show up here
+// directly instead of having to be bisected out of end-to-end runs.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/run_loop.h"
+#include "base/single_thread_task_runner.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task/single_thread_task_executor.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "chrome/test/chromedriver/chrome/browser_info.h"
+#include "chrome/test/chromedriver/chrome/javascript_dialog_manager.h"
+#include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/chrome/stub_chrome.h"
+#include "chrome/test/chromedriver/chrome/stub_devtools_client.h"
+#include "chrome/test/chromedriver/chrome/stub_web_view.h"
+#include "chrome/test/chromedriver/server/http_handler.h"
+#include "chrome/test/chromedriver/session.h"
+#include "chrome/test/chromedriver/session_thread_map.h"
+#include "net/server/http_server_request_info.h"
+#include "net/server/http_server_response_info.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace {
+
+// WebView that answers CallFunction from canned data after an optional
+// synthetic delay standing in for browser execution time. Subtracting the
+// configured delay from the reported latency gives the driver's own cost.
+class LoadTestWebView : public StubWebView {
+ public:
+  explicit LoadTestWebView(const base::TimeDelta& synthetic_latency)
+      : StubWebView("loadtest-view"),
+        synthetic_latency_(synthetic_latency),
+        dialog_manager_(&client_, &browser_info_) {}
+  ~LoadTestWebView() override = default;
+
+  JavaScriptDialogManager* GetJavaScriptDialogManager() override {
+    return &dialog_manager_;
+  }
+
+  Status CallFunction(const std::string& frame,
+                      const std::string& function,
+                      const base::ListValue& args,
+                      std::unique_ptr<base::Value>* result) override {
+    if (synthetic_latency_.InMicroseconds() > 0)
+      base::PlatformThread::Sleep(synthetic_latency_);
+    *result = std::make_unique<base::Value>("http://loadtest.invalid/");
+    return Status(kOk);
+  }
+
+ private:
+  const base::TimeDelta synthetic_latency_;
+  BrowserInfo browser_info_;
+  StubDevToolsClient client_;
+  JavaScriptDialogManager dialog_manager_;
+};
+
+class LoadTestChrome : public StubChrome {
+ public:
+  explicit LoadTestChrome(const base::TimeDelta& synthetic_latency)
+      : web_view_(synthetic_latency) {}
+  ~LoadTestChrome() override = default;
+
+  Status GetWebViewById(const std::string& id, WebView** web_view) override {
+    *web_view = &web_view_;
+    return Status(kOk);
+  }
+
+ private:
+  LoadTestWebView web_view_;
+};
+
+void CompleteRequest(base::WaitableEvent* done,
+                     std::unique_ptr<HttpResponsePayload> response) {
+  done->Signal();
+}
+
+void IssueRequest(HttpHandler* handler,
+                  const net::HttpServerRequestInfo& request,
+                  base::WaitableEvent* done) {
+  handler->Handle(request, base::BindRepeating(&CompleteRequest, done));
+}
+
+// Body of one simulated connection. Like a real client it has at most one
+// request in flight: each request is posted to the command thread and the
+// next one is not sent until the response callback has run.
+void DriveConnection(
+    const scoped_refptr<base::SingleThreadTaskRunner>& cmd_runner,
+    HttpHandler* handler,
+    const std::string& session_id,
+    int requests,
+    std::vector<base::TimeDelta>* latencies,
+    const base::RepeatingClosure& on_done) {
+  net::HttpServerRequestInfo request;
+  request.method = "get";
+  request.path = "/session/" + session_id + "/url";
+  latencies->reserve(requests);
+  for (int i = 0; i < requests; ++i) {
+    base::WaitableEvent done;
+    base::TimeTicks start = base::TimeTicks::Now();
+    cmd_runner->PostTask(
+        FROM_HERE, base::BindOnce(&IssueRequest, handler, request, &done));
+    done.Wait();
+    latencies->push_back(base::TimeTicks::Now() - start);
+  }
+  cmd_runner->PostTask(FROM_HERE, on_done);
+}
+
+void OnConnectionDone(int* remaining, const base::RepeatingClosure& quit) {
+  if (--*remaining == 0)
+    quit.Run();
+}
+
+base::TimeDelta Percentile(const std::vector<base::TimeDelta>& sorted,
+                           double fraction) {
+  size_t index = static_cast<size_t>(fraction * (sorted.size() - 1));
+  return sorted[index];
+}
+
+void ReportResults(const std::string& story,
+                   std::vector<std::vector<base::TimeDelta>>* per_connection,
+                   base::TimeDelta elapsed) {
+  std::vector<base::TimeDelta> all;
+  for (const auto& latencies : *per_connection)
+    all.insert(all.end(), latencies.begin(), latencies.end());
+  std::sort(all.begin(), all.end());
+
+  perf_test::PerfResultReporter reporter("ChromeDriver.LoadTest", story);
+  reporter.RegisterImportantMetric(".commands_per_second", "runs/s");
+  reporter.RegisterImportantMetric(".latency_p50", "us");
+  reporter.RegisterImportantMetric(".latency_p90", "us");
+  reporter.RegisterImportantMetric(".latency_p99", "us");
+  reporter.AddResult(".commands_per_second", all.size() / elapsed.InSecondsF());
+  reporter.AddResult(".latency_p50", Percentile(all, 0.5).InMicrosecondsF());
+  reporter.AddResult(".latency_p90", Percentile(all, 0.9).InMicrosecondsF());
+  reporter.AddResult(".latency_p99", Percentile(all, 0.99).InMicrosecondsF());
+}
+
+}  // namespace
+
+// The two tests differ only in the synthetic per-command browser latency:
+// zero isolates pure driver overhead, while a realistic delay shows how
+// much of it pipeline effects (thread hops overlapping the "browser" work
+// of other connections) can hide under load.
+
+TEST(HttpHandlerLoadTest, StubBackedSessionThroughput) {
+  const int kConnections = 4;
+  const int kRequestsPerConnection = 2000;
+  const std::string kSessionId = "loadtest-session";
+
+  base::SingleThreadTaskExecutor cmd_task_executor;
+  HttpHandler handler("/");
+
+  auto thread_info = std::make_unique<SessionThreadInfo>(kSessionId, true);
+  ASSERT_TRUE(thread_info->Start());
+  auto session = std::make_unique<Session>(
+      kSessionId,
+      std::make_unique<LoadTestChrome>(base::TimeDelta() /* no latency */));
+  thread_info->task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&SetThreadLocalSession, std::move(session)));
+  handler.session_thread_map_.insert(
+      std::make_pair(kSessionId, std::move(thread_info)));
+
+  std::vector<std::vector<base::TimeDelta>> latencies(kConnections);
+  std::vector<std::unique_ptr<base::Thread>> connections;
+  int remaining = kConnections;
+  base::RunLoop run_loop;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kConnections; ++i) {
+    auto connection =
+        std::make_unique<base::Thread>(base::StringPrintf("LoadConn%d", i));
+    ASSERT_TRUE(connection->Start());
+    connection->task_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&DriveConnection, cmd_task_executor.task_runner(),
+                       &handler, kSessionId, kRequestsPerConnection,
+                       &latencies[i],
+                       base::BindRepeating(&OnConnectionDone, &remaining,
+                                           run_loop.QuitClosure())));
+    connections.push_back(std::move(connection));
+  }
+  run_loop.Run();
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  connections.clear();
+
+  ReportResults("driver_overhead_only", &latencies, elapsed);
+}
+
+TEST(HttpHandlerLoadTest, StubBackedSessionWithBrowserLatency) {
+  const int kConnections = 4;
+  const int kRequestsPerConnection = 500;
+  const base::TimeDelta kBrowserLatency =
+      base::TimeDelta::FromMicroseconds(500);
+  const std::string kSessionId = "loadtest-session";
+
+  base::SingleThreadTaskExecutor cmd_task_executor;
+  HttpHandler handler("/");
+
+  auto thread_info = std::make_unique<SessionThreadInfo>(kSessionId, true);
+  ASSERT_TRUE(thread_info->Start());
+  auto session = std::make_unique<Session>(
+      kSessionId, std::make_unique<LoadTestChrome>(kBrowserLatency));
+  thread_info->task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&SetThreadLocalSession, std::move(session)));
+  handler.session_thread_map_.insert(
+      std::make_pair(kSessionId, std::move(thread_info)));
+
+  std::vector<std::vector<base::TimeDelta>> latencies(kConnections);
+  std::vector<std::unique_ptr<base::Thread>> connections;
+  int remaining = kConnections;
+  base::RunLoop run_loop;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kConnections; ++i) {
+    auto connection =
+        std::make_unique<base::Thread>(base::StringPrintf("LoadConn%d", i));
+    ASSERT_TRUE(connection->Start());
+    connection->task_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&DriveConnection, cmd_task_executor.task_runner(),
+                       &handler, kSessionId, kRequestsPerConnection,
+                       &latencies[i],
+                       base::BindRepeating(&OnConnectionDone, &remaining,
+                                           run_loop.QuitClosure())));
+    connections.push_back(std::move(connection));
+  }
+  run_loop.Run();
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  connections.clear();
+
+  ReportResults("with_synthetic_browser_latency", &latencies, elapsed);
+}
@@ -4,33 +4,45 @@
 
 #include "chrome/test/chromedriver/server/http_handler.h"
 
+#include <atomic>
 #include <memory>
 #include <string>
 
 #include "base/bind.h"
 #include "base/json/json_writer.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/test/task_environment.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/log.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/command.h"
+#include "chrome/test/chromedriver/session.h"
 #include "net/http/http_status_code.h"
 #include "net/server/http_server_request_info.h"
 #include "net/server/http_server_response_info.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/google/compression_utils.h"
 
 namespace {
 
 void DummyCommand(
     const Status& status,
-    const base::DictionaryValue& params,
+    std::unique_ptr<base::DictionaryValue> params,
     const std::string& session_id,
     const CommandCallback& callback) {
   callback.Run(status, std::make_unique<base::Value>(1), "session_id", false);
 }
 
 void OnResponse(net::HttpServerResponseInfo* response_to_set,
-                std::unique_ptr<net::HttpServerResponseInfo> response) {
-  *response_to_set = *response;
+                std::unique_ptr<HttpResponsePayload> payload) {
+  *response_to_set = *payload->info;
+}
+
+void OnResponseSetFlag(net::HttpServerResponseInfo* response_to_set,
+                       bool* responded,
+                       std::unique_ptr<HttpResponsePayload> payload) {
+  *responded = true;
+  *response_to_set = *payload->info;
 }
 
 }  // namespace
@@ -125,11 +137,205 @@ TEST(HttpHandlerTest, HandleCommand) {
   ASSERT_EQ(json, response.body());
 }
 
+TEST(HttpHandlerTest, LargeBodyParsedOffThread) {
+  base::test::TaskEnvironment task_environment;
+  HttpHandler handler("/");
+  handler.command_map_->push_back(CommandMapping(
+      kPost, "path", base::BindRepeating(&DummyCommand, Status(kOk))));
+  net::HttpServerRequestInfo request;
+  request.method = "post";
+  request.path = "/path";
+  request.data = "{\"blob\":\"" + std::string(512 * 1024, 'x') + "\"}";
+  net::HttpServerResponseInfo response;
+  bool responded = false;
+  handler.Handle(request,
+                 base::BindRepeating(&OnResponseSetFlag, &response, &responded));
+  // The body is parsed on a worker, so the response is not produced inline.
+  ASSERT_FALSE(responded);
+  task_environment.RunUntilIdle();
+  ASSERT_TRUE(responded);
+  ASSERT_EQ(net::HTTP_OK, response.status_code());
+}
+
+TEST(HttpHandlerTest, LargeInvalidBodyRejected) {
+  base::test::TaskEnvironment task_environment;
+  HttpHandler handler("/");
+  handler.command_map_->push_back(CommandMapping(
+      kPost, "path", base::BindRepeating(&DummyCommand, Status(kOk))));
+  net::HttpServerRequestInfo request;
+  request.method = "post";
+  request.path = "/path";
+  request.data = "[" + std::string(512 * 1024, 'x') + "]";
+  net::HttpServerResponseInfo response;
+  bool responded = false;
+  handler.Handle(request,
+                 base::BindRepeating(&OnResponseSetFlag, &response, &responded));
+  task_environment.RunUntilIdle();
+  ASSERT_TRUE(responded);
+  ASSERT_EQ(net::HTTP_BAD_REQUEST, response.status_code());
+}
+
 TEST(HttpHandlerTest, StandardResponse_ErrorNoMessage) {
   HttpHandler handler("/");
   Status status = Status(kUnexpectedAlertOpen);
   ASSERT_NO_FATAL_FAILURE(handler.PrepareStandardResponse(
-      "not used", status, std::make_unique<base::Value>(), "1234"));
+      "not used", status, std::make_unique<base::Value>(), "1234", false));
+}
+
+TEST(HttpHandlerTest, StandardResponse_ScalarFastPath) {
+  HttpHandler handler("/");
+  // Strings with characters needing escapes must match JSONWriter exactly.
+  std::unique_ptr<HttpResponsePayload> response =
+      handler.PrepareStandardResponse(
+          "not used", Status(kOk),
+          std::make_unique<base::Value>("a\"b\\c"), "1234", false);
+  base::DictionaryValue body;
+  body.SetString("value", "a\"b\\c");
+  std::string json;
+  base::JSONWriter::Write(body, &json);
+  ASSERT_EQ(json, response->info->body());
+
+  // A null result renders as {"value":null}.
+  response = handler.PrepareStandardResponse(
+      "not used", Status(kOk), std::make_unique<base::Value>(), "1234", false);
+  ASSERT_EQ("{\"value\":null}", response->info->body());
+}
+
+TEST(HttpHandlerTest, LegacyResponse_ScalarFastPath) {
+  HttpHandler handler("/");
+  std::unique_ptr<HttpResponsePayload> response =
+      handler.PrepareLegacyResponse(
+          "not used", Status(kOk), std::make_unique<base::Value>(true),
+          "session_id", false);
+  base::DictionaryValue body;
+  body.SetInteger("status", kOk);
+  body.SetBoolean("value", true);
+  body.SetString("sessionId", "session_id");
+  std::string json;
+  base::JSONWriter::Write(body, &json);
+  ASSERT_EQ(json, response->info->body());
+
+  // The cached session id fragment must serve repeat responses too.
+  response = handler.PrepareLegacyResponse(
+      "not used", Status(kOk), std::make_unique<base::Value>(true),
+      "session_id", false);
+  ASSERT_EQ(json, response->info->body());
+}
+
+TEST(HttpHandlerTest, StandardResponse_GzipLargeBody) {
+  HttpHandler handler("/");
+  // Large enough to clear the compression threshold.
+  std::string page_source(64 * 1024, 'x');
+  std::unique_ptr<HttpResponsePayload> response =
+      handler.PrepareStandardResponse(
+          "not used", Status(kOk), std::make_unique<base::Value>(page_source),
+          "1234", true);
+  ASSERT_NE(std::string::npos,
+            response->info->Serialize().find("Content-Encoding:gzip"));
+  std::string body;
+  ASSERT_TRUE(compression::GzipUncompress(response->info->body(), &body));
+  base::DictionaryValue expected;
+  expected.SetString("value", page_source);
+  std::string json;
+  base::JSONWriter::Write(expected, &json);
+  ASSERT_EQ(json, body);
+
+  // Small bodies are not worth compressing even when the client allows it.
+  response = handler.PrepareStandardResponse(
+      "not used", Status(kOk), std::make_unique<base::Value>(true), "1234",
+      true);
+  ASSERT_EQ("{\"value\":true}", response->info->body());
+}
+
+TEST(HttpHandlerTest, StandardResponse_RefCountedLargeBody) {
+  HttpHandler handler("/");
+  // Large enough to clear the ref-counted handoff threshold; the client
+  // does not accept gzip, so the body stays at full size.
+  std::string screenshot(2 * 1024 * 1024, 'x');
+  std::unique_ptr<HttpResponsePayload> response =
+      handler.PrepareStandardResponse(
+          "not used", Status(kOk), std::make_unique<base::Value>(screenshot),
+          "1234", false);
+  ASSERT_TRUE(response->body);
+  ASSERT_TRUE(response->info->body().empty());
+  // The headers SetBody() would have added must be present, since the IO
+  // thread serializes them separately from the body.
+  std::string headers = response->info->Serialize();
+  ASSERT_NE(std::string::npos,
+            headers.find("Content-Length:" +
+                         base::NumberToString(response->body->data().size())));
+  ASSERT_NE(std::string::npos, headers.find("Content-Type:application/json"));
+  base::DictionaryValue expected;
+  expected.SetString("value", screenshot);
+  std::string json;
+  base::JSONWriter::Write(expected, &json);
+  ASSERT_EQ(json, response->body->data());
+}
+
+TEST(HttpHandlerTest, CancelsInFlightCommandOnClose) {
+  HttpHandler handler("/");
+  auto thread_info = std::make_unique<SessionThreadInfo>("1", true);
+  std::shared_ptr<std::atomic<bool>> flag = thread_info->cancel_flag();
+  handler.session_thread_map_["abc"] = std::move(thread_info);
+
+  handler.OnHttpRequestStart(5, "/session/abc/element");
+  EXPECT_FALSE(flag->load());
+  // Closing an unrelated connection cancels nothing.
+  handler.OnClose(nullptr, 7);
+  EXPECT_FALSE(flag->load());
+  // Closing the connection with the request in flight raises the flag.
+  handler.OnClose(nullptr, 5);
+  EXPECT_TRUE(flag->load());
+}
+
+TEST(HttpHandlerTest, ResponseClearsInFlightRecord) {
+  HttpHandler handler("/");
+  auto thread_info = std::make_unique<SessionThreadInfo>("1", true);
+  std::shared_ptr<std::atomic<bool>> flag = thread_info->cancel_flag();
+  handler.session_thread_map_["abc"] = std::move(thread_info);
+
+  handler.OnHttpRequestStart(5, "/session/abc/url");
+  handler.OnHttpRequestDone(5);
+  // The response went out first, so a later close must not cancel anything.
+  handler.OnClose(nullptr, 5);
+  EXPECT_FALSE(flag->load());
+
+  // Requests outside session paths are not tracked at all.
+  handler.OnHttpRequestStart(6, "/status");
+  handler.OnClose(nullptr, 6);
+  EXPECT_FALSE(flag->load());
+}
+
+TEST(HttpHandlerTest, ConnectionBindingCachesW3cMode) {
+  HttpHandler handler("/");
+  handler.session_thread_map_["abc"] =
+      std::make_unique<SessionThreadInfo>("1", true);
+  // The first resolution goes through the session map and binds the
+  // connection to the session.
+  EXPECT_TRUE(handler.W3cModeForConnection(5, "abc"));
+  ASSERT_EQ(1u, handler.connection_binding_cache_.count(5));
+  // A repeat is served from the binding without touching the map.
+  handler.session_thread_map_.clear();
+  EXPECT_TRUE(handler.W3cModeForConnection(5, "abc"));
+  // A different session id on the same connection misses the binding, and
+  // an unknown session is not bound.
+  EXPECT_EQ(kW3CDefault, handler.W3cModeForConnection(5, "other"));
+  EXPECT_EQ("abc", handler.connection_binding_cache_[5].session_id);
+}
+
+TEST(HttpHandlerTest, ConnectionBindingInvalidation) {
+  HttpHandler handler("/");
+  handler.session_thread_map_["abc"] =
+      std::make_unique<SessionThreadInfo>("1", true);
+  ASSERT_TRUE(handler.W3cModeForConnection(5, "abc"));
+  ASSERT_TRUE(handler.W3cModeForConnection(6, "abc"));
+  // Deleting the session drops the bindings of every connection to it.
+  handler.InvalidateSessionBindings("abc");
+  EXPECT_TRUE(handler.connection_binding_cache_.empty());
+  // A closing connection drops its own binding.
+  ASSERT_TRUE(handler.W3cModeForConnection(5, "abc"));
+  handler.OnClose(nullptr, 5);
+  EXPECT_EQ(0u, handler.connection_binding_cache_.count(5));
 }
 
 TEST(MatchesCommandTest, DiffMethod) {
@@ -207,3 +413,60 @@ TEST(MatchesCommandTest, DecodePercent) {
   ASSERT_TRUE(params.GetString("xyz", &param));
   ASSERT_EQ("@a%b%c%%", param);
 }
+
+TEST(RouteTrieTest, FindsCommandAndExtractsParams) {
+  CommandMapping command(kPost, "session/:sessionId/element/:id/click",
+                         base::BindRepeating(&DummyCommand, Status(kOk)));
+  internal::RouteTrie trie;
+  trie.Add(command);
+  std::string session_id;
+  base::DictionaryValue params;
+  ASSERT_EQ(&command, trie.Find("post", "session/1/element/e%2F2/click",
+                                &session_id, &params));
+  ASSERT_EQ("1", session_id);
+  std::string param;
+  ASSERT_TRUE(params.GetString("id", &param));
+  ASSERT_EQ("e/2", param);
+}
+
+TEST(RouteTrieTest, NoMatch) {
+  CommandMapping command(kPost, "path/apath",
+                         base::BindRepeating(&DummyCommand, Status(kOk)));
+  internal::RouteTrie trie;
+  trie.Add(command);
+  std::string session_id;
+  base::DictionaryValue params;
+  ASSERT_FALSE(trie.Find("get", "path/apath", &session_id, &params));
+  ASSERT_FALSE(trie.Find("post", "path/bpath", &session_id, &params));
+  ASSERT_FALSE(trie.Find("post", "path", &session_id, &params));
+  ASSERT_FALSE(trie.Find("post", "path/apath/extra", &session_id, &params));
+}
+
+TEST(RouteTrieTest, LiteralBeatsCapture) {
+  CommandMapping wildcard(kGet, "session/:sessionId",
+                          base::BindRepeating(&DummyCommand, Status(kOk)));
+  CommandMapping literal(kGet, "session/status",
+                         base::BindRepeating(&DummyCommand, Status(kOk)));
+  internal::RouteTrie trie;
+  trie.Add(wildcard);
+  trie.Add(literal);
+  std::string session_id;
+  base::DictionaryValue params;
+  ASSERT_EQ(&literal, trie.Find("get", "session/status", &session_id, &params));
+  ASSERT_TRUE(session_id.empty());
+  ASSERT_EQ(&wildcard, trie.Find("get", "session/123", &session_id, &params));
+  ASSERT_EQ("123", session_id);
+}
+
+TEST(RouteTrieTest, FirstAddedWins) {
+  CommandMapping first(kPost, "path/:a",
+                       base::BindRepeating(&DummyCommand, Status(kOk)));
+  CommandMapping second(kPost, "path/:a",
+                        base::BindRepeating(&DummyCommand, Status(kOk)));
+  internal::RouteTrie trie;
+  trie.Add(first);
+  trie.Add(second);
+  std::string session_id;
+  base::DictionaryValue params;
+  ASSERT_EQ(&first, trie.Find("post", "path/x", &session_id, &params));
+}
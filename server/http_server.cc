@@ -4,12 +4,41 @@
 
 #include "chrome/test/chromedriver/server/http_server.h"
 
+#include <algorithm>
+#include <utility>
+
+#include "build/build_config.h"
+#include "net/base/ip_endpoint.h"
+#include "net/socket/socket_descriptor.h"
+
+#if defined(OS_POSIX)
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/socket/unix_domain_server_socket_posix.h"
+#endif
+
 namespace {
 
 // Maximum message size between app and ChromeDriver. Data larger than 150 MB
 // or so can cause crashes in Chrome (https://crbug.com/890854), so there is no
 // need to support messages that are too large.
-const int kBufferSize = 256 * 1024 * 1024;  // 256 MB
+const int kMaxBufferSize = 256 * 1024 * 1024;  // 256 MB
+
+// Smallest send-ceiling tier for a connection. Covers everything but
+// screenshot/print-sized responses, which raise the ceiling to the size
+// class that fits and drop back with the next small response.
+const size_t kDefaultSendBufferSize = 1024 * 1024;  // 1 MB
+
+// Allowance for status line and headers on top of a response body when
+// sizing the send ceiling.
+const size_t kResponseHeaderAllowance = 1024;
+
+// Response bodies at least this large are written to the socket in slices
+// instead of being concatenated with the headers into one string, so a
+// screenshot or page-source response is never duplicated whole.
+const size_t kStreamedBodyThreshold = 1024 * 1024;  // 1 MB
+const size_t kBodySliceSize = 1024 * 1024;          // 1 MB
 
 int ListenOnIPv4(net::ServerSocket* socket, uint16_t port, bool allow_remote) {
   std::string binding_ip = net::IPAddress::IPv4Localhost().ToString();
@@ -25,51 +54,147 @@ int ListenOnIPv6(net::ServerSocket* socket, uint16_t port, bool allow_remote) {
   return socket->ListenWithAddressAndPort(binding_ip, port, 5);
 }
 
-bool RequestIsSafeToServe(const net::HttpServerRequestInfo& info,
-                          bool allow_remote,
-                          const std::vector<net::IPAddress>& whitelisted_ips) {
-  // To guard against browser-originating cross-site requests, when host header
-  // and/or origin header are present, serve only those coming from localhost
-  // or from an explicitly whitelisted ip.
-  std::string origin_header = info.GetHeaderValue("origin");
+// Creates the socket by hand so SO_REUSEPORT can be set before binding;
+// the net stack exposes no option hook on its listen path.
+int ListenWithReusePort(net::TCPServerSocket* socket,
+                        uint16_t port,
+                        bool allow_remote,
+                        bool use_ipv4) {
+#if defined(OS_POSIX)
+  net::SocketDescriptor fd = net::CreatePlatformSocket(
+      use_ipv4 ? AF_INET : AF_INET6, SOCK_STREAM, IPPROTO_TCP);
+  if (fd == net::kInvalidSocket)
+    return net::ERR_CONNECTION_FAILED;
+  int on = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) {
+    close(fd);
+    return net::ERR_NOT_IMPLEMENTED;
+  }
+  int result = socket->AdoptSocket(fd);
+  if (result != net::OK)
+    return result;
+  net::IPAddress binding_ip;
+  if (use_ipv4) {
+    binding_ip = allow_remote ? net::IPAddress::IPv4AllZeros()
+                              : net::IPAddress::IPv4Localhost();
+  } else {
+    binding_ip = allow_remote ? net::IPAddress::IPv6AllZeros()
+                              : net::IPAddress::IPv6Localhost();
+  }
+  return socket->Listen(net::IPEndPoint(binding_ip, port), 5);
+#else
+  return net::ERR_NOT_IMPLEMENTED;
+#endif
+}
+
+#if defined(OS_POSIX)
+// Admits a Unix-socket peer only when it runs as the same user as this
+// process. The kernel supplies the credentials, so unlike the header-based
+// admission checks nothing here can be forged by a remote page.
+bool AuthenticateUnixPeer(
+    const net::UnixDomainServerSocket::Credentials& credentials) {
+  return credentials.user_id == getuid();
+}
+#endif
+
+// Cached header verdicts kept before the cache is reset; unique header
+// values beyond this are an abuse signal, not a working set.
+const size_t kMaxHeaderVerdicts = 128;
+
+}  // namespace
+
+AdmissionPolicy::AdmissionPolicy(
+    bool allow_remote,
+    const std::vector<net::IPAddress>& whitelisted_ips)
+    : allow_remote_(allow_remote), whitelisted_ips_(whitelisted_ips) {
+  std::sort(whitelisted_ips_.begin(), whitelisted_ips_.end());
+}
+
+AdmissionPolicy::~AdmissionPolicy() = default;
+
+AdmissionPolicy::OriginVerdict AdmissionPolicy::ClassifyOrigin(
+    const std::string& origin_header) {
+  if (net::IsLocalhost(GURL(origin_header)))
+    return OriginVerdict::kAllowLocal;
+  if (!allow_remote_)
+    return OriginVerdict::kRejectRemoteDisallowed;
+  if (!whitelisted_ips_.empty()) {
+    net::IPAddress address;
+    if (!ParseURLHostnameToAddress(origin_header, &address))
+      return OriginVerdict::kRejectUnparsable;
+    if (!std::binary_search(whitelisted_ips_.begin(), whitelisted_ips_.end(),
+                            address)) {
+      return OriginVerdict::kRejectNotWhitelisted;
+    }
+  }
+  return OriginVerdict::kAllowRemote;
+}
+
+bool AdmissionPolicy::RequestIsSafeToServe(
+    const net::HttpServerRequestInfo& info) {
+  // To guard against browser-originating cross-site requests, when host
+  // header and/or origin header are present, serve only those coming from
+  // localhost or from an explicitly whitelisted ip. Header names are stored
+  // lower-cased, so the map is probed directly rather than through
+  // GetHeaderValue, which copies the value.
   bool local_origin = false;
-  if (!origin_header.empty()) {
-    GURL url = GURL(origin_header);
-    local_origin = net::IsLocalhost(url);
-    if (!local_origin) {
-      if (!allow_remote) {
+  auto origin_it = info.headers.find("origin");
+  const std::string* origin_header =
+      origin_it != info.headers.end() ? &origin_it->second : nullptr;
+  if (origin_header && !origin_header->empty()) {
+    OriginVerdict verdict;
+    auto cached = origin_verdicts_.find(*origin_header);
+    if (cached != origin_verdicts_.end()) {
+      verdict = cached->second;
+    } else {
+      verdict = ClassifyOrigin(*origin_header);
+      if (origin_verdicts_.size() >= kMaxHeaderVerdicts)
+        origin_verdicts_.clear();
+      origin_verdicts_.emplace(*origin_header, verdict);
+    }
+    switch (verdict) {
+      case OriginVerdict::kAllowLocal:
+        local_origin = true;
+        break;
+      case OriginVerdict::kAllowRemote:
+        break;
+      case OriginVerdict::kRejectRemoteDisallowed:
         LOG(ERROR)
             << "Remote connections not allowed; rejecting request with origin: "
-            << origin_header;
+            << *origin_header;
+        return false;
+      case OriginVerdict::kRejectUnparsable:
+        LOG(ERROR) << "Unable to parse origin to IPAddress: "
+                   << *origin_header;
+        return false;
+      case OriginVerdict::kRejectNotWhitelisted:
+        LOG(ERROR) << "Rejecting request with origin: " << *origin_header;
         return false;
-      }
-      if (!whitelisted_ips.empty()) {
-        net::IPAddress address = net::IPAddress();
-        if (!ParseURLHostnameToAddress(origin_header, &address)) {
-          LOG(ERROR) << "Unable to parse origin to IPAddress: "
-                     << origin_header;
-          return false;
-        }
-        if (!base::Contains(whitelisted_ips, address)) {
-          LOG(ERROR) << "Rejecting request with origin: " << origin_header;
-          return false;
-        }
-      }
     }
   }
   // TODO https://crbug.com/chromedriver/3389
   //  When remote access is allowed and origin is not specified,
   // we should confirm that host is current machines ip or hostname
 
-  if (local_origin || !allow_remote) {
+  if (local_origin || !allow_remote_) {
     // when origin is localhost host must be localhost
     // when origin is not set, and no remote access, host must be localhost
-    std::string host_header = info.GetHeaderValue("host");
-    if (!host_header.empty()) {
-      GURL url = GURL("http://" + host_header);
-      if (!net::IsLocalhost(url)) {
-        LOG(ERROR) << "Rejecting request with host: " << host_header
-                   << ". origin is " << origin_header;
+    auto host_it = info.headers.find("host");
+    if (host_it != info.headers.end() && !host_it->second.empty()) {
+      bool local_host;
+      auto cached = host_verdicts_.find(host_it->second);
+      if (cached != host_verdicts_.end()) {
+        local_host = cached->second;
+      } else {
+        local_host = net::IsLocalhost(GURL("http://" + host_it->second));
+        if (host_verdicts_.size() >= kMaxHeaderVerdicts)
+          host_verdicts_.clear();
+        host_verdicts_.emplace(host_it->second, local_host);
+      }
+      if (!local_host) {
+        LOG(ERROR) << "Rejecting request with host: " << host_it->second
+                   << ". origin is "
+                   << (origin_header ? *origin_header : std::string());
         return false;
       }
     }
@@ -77,8 +202,6 @@ bool RequestIsSafeToServe(const net::HttpServerRequestInfo& info,
   return true;
 }
 
-}  // namespace
-
 HttpServer::HttpServer(const std::string& url_base,
                        const std::vector<net::IPAddress>& whitelisted_ips,
                        const HttpRequestHandlerFunc& handle_request_func,
@@ -86,17 +209,26 @@ HttpServer::HttpServer(const std::string& url_base,
                        scoped_refptr<base::SingleThreadTaskRunner> cmd_runner)
     : url_base_(url_base),
       handle_request_func_(handle_request_func),
-      allow_remote_(false),
       whitelisted_ips_(whitelisted_ips),
       handler_(handler),
       cmd_runner_(cmd_runner) {}
 
-int HttpServer::Start(uint16_t port, bool allow_remote, bool use_ipv4) {
-  allow_remote_ = allow_remote;
-  std::unique_ptr<net::ServerSocket> server_socket(
+int HttpServer::Start(uint16_t port,
+                      bool allow_remote,
+                      bool use_ipv4,
+                      bool reuse_port) {
+  admission_policy_ =
+      std::make_unique<AdmissionPolicy>(allow_remote, whitelisted_ips_);
+  std::unique_ptr<net::TCPServerSocket> server_socket(
       new net::TCPServerSocket(nullptr, net::NetLogSource()));
-  int status = use_ipv4 ? ListenOnIPv4(server_socket.get(), port, allow_remote)
-                        : ListenOnIPv6(server_socket.get(), port, allow_remote);
+  int status;
+  if (reuse_port) {
+    status =
+        ListenWithReusePort(server_socket.get(), port, allow_remote, use_ipv4);
+  } else {
+    status = use_ipv4 ? ListenOnIPv4(server_socket.get(), port, allow_remote)
+                      : ListenOnIPv6(server_socket.get(), port, allow_remote);
+  }
   if (status != net::OK) {
     VLOG(0) << "listen on " << (use_ipv4 ? "IPv4" : "IPv6")
             << " failed with error " << net::ErrorToShortString(status);
@@ -107,27 +239,87 @@ int HttpServer::Start(uint16_t port, bool allow_remote, bool use_ipv4) {
   return server_->GetLocalAddress(&address);
 }
 
+int HttpServer::StartOnUnixSocket(const std::string& socket_path) {
+#if defined(OS_POSIX)
+  // A socket file left behind by an earlier run would fail the bind; remove
+  // it. A concurrently running instance is not protected against, but it
+  // would have failed the same way.
+  unlink(socket_path.c_str());
+  auto server_socket = std::make_unique<net::UnixDomainServerSocket>(
+      base::BindRepeating(&AuthenticateUnixPeer),
+      false /* use_abstract_namespace */);
+  int status = server_socket->BindAndListen(socket_path, 5);
+  if (status != net::OK) {
+    VLOG(0) << "listen on " << socket_path << " failed with error "
+            << net::ErrorToShortString(status);
+    return status;
+  }
+  trust_peer_credentials_ = true;
+  unix_socket_path_ = socket_path;
+  server_ = std::make_unique<net::HttpServer>(std::move(server_socket), this);
+  return net::OK;
+#else
+  return net::ERR_NOT_IMPLEMENTED;
+#endif
+}
+
 void HttpServer::OnConnect(int connection_id) {
-  server_->SetSendBufferSize(connection_id, kBufferSize);
-  server_->SetReceiveBufferSize(connection_id, kBufferSize);
+  // The receive ceiling stays at the maximum: the size of an incoming body
+  // (e.g. a file upload) is not known until it has been read, and the cap
+  // is a growth limit rather than an allocation.
+  server_->SetReceiveBufferSize(connection_id, kMaxBufferSize);
+  // The send ceiling is tiered per response instead: it starts at the
+  // smallest class, so a connection never keeps a 256 MB allowance for
+  // queued writes just because it once carried a screenshot.
+  send_buffer_sizes_[connection_id] = kDefaultSendBufferSize;
+  server_->SetSendBufferSize(connection_id, kDefaultSendBufferSize);
+}
+
+void HttpServer::UpdateSendBufferSize(int connection_id, size_t bytes) {
+  size_t size_class = kDefaultSendBufferSize;
+  while (size_class < bytes &&
+         size_class < static_cast<size_t>(kMaxBufferSize)) {
+    size_class *= 2;
+  }
+  auto it = send_buffer_sizes_.find(connection_id);
+  if (it == send_buffer_sizes_.end() || it->second == size_class)
+    return;
+  it->second = size_class;
+  server_->SetSendBufferSize(connection_id, size_class);
 }
 
 void HttpServer::OnHttpRequest(int connection_id,
                                const net::HttpServerRequestInfo& info) {
-  if (!RequestIsSafeToServe(info, allow_remote_, whitelisted_ips_)) {
+  // A credential-verified Unix-socket listener carries no admission policy:
+  // its peers are already vetted, and their Host headers are socket paths
+  // that would never classify as localhost.
+  if (!trust_peer_credentials_ &&
+      !admission_policy_->RequestIsSafeToServe(info)) {
     server_->Send500(connection_id,
                      "Host header or origin header is specified and is not "
                      "whitelisted or localhost.",
                      TRAFFIC_ANNOTATION_FOR_TESTS);
     return;
   }
+  // Posted ahead of the command task below, so the handler can tie the
+  // connection to the session command about to run and cancel it if the
+  // connection closes before the response is sent.
+  cmd_runner_->PostTask(
+      FROM_HERE, base::BindOnce(&HttpHandler::OnHttpRequestStart, handler_,
+                                connection_id, info.path));
   handle_request_func_.Run(
-      info, base::BindRepeating(&HttpServer::OnResponse,
-                                weak_factory_.GetWeakPtr(), connection_id,
-                                !info.HasHeaderValue("connection", "close")));
+      connection_id, info,
+      base::BindRepeating(&HttpServer::OnResponse, weak_factory_.GetWeakPtr(),
+                          connection_id,
+                          !info.HasHeaderValue("connection", "close")));
 }
 
-HttpServer::~HttpServer() = default;
+HttpServer::~HttpServer() {
+#if defined(OS_POSIX)
+  if (!unix_socket_path_.empty())
+    unlink(unix_socket_path_.c_str());
+#endif
+}
 
 void HttpServer::OnWebSocketRequest(int connection_id,
                                     const net::HttpServerRequestInfo& info) {
@@ -137,11 +329,14 @@ void HttpServer::OnWebSocketRequest(int connection_id,
 }
 
 void HttpServer::OnWebSocketMessage(int connection_id, std::string data) {
-  // TODO: Make use of WebSocket data
   VLOG(0) << "HttpServer::OnWebSocketMessage received: " << data;
+  cmd_runner_->PostTask(
+      FROM_HERE, base::BindOnce(&HttpHandler::OnWebSocketMessage, handler_,
+                                this, connection_id, std::move(data)));
 }
 
 void HttpServer::OnClose(int connection_id) {
+  send_buffer_sizes_.erase(connection_id);
   cmd_runner_->PostTask(
       FROM_HERE,
       base::BindOnce(&HttpHandler::OnClose, handler_, this, connection_id));
@@ -153,20 +348,53 @@ void HttpServer::AcceptWebSocket(int connection_id,
                            TRAFFIC_ANNOTATION_FOR_TESTS);
 }
 
+void HttpServer::SendOverWebSocket(int connection_id, std::string data) {
+  UpdateSendBufferSize(connection_id, data.size() + kResponseHeaderAllowance);
+  server_->SendOverWebSocket(connection_id, data,
+                             TRAFFIC_ANNOTATION_FOR_TESTS);
+}
+
 void HttpServer::SendResponse(
     int connection_id,
     const net::HttpServerResponseInfo& response,
     const net::NetworkTrafficAnnotationTag& traffic_annotation) {
+  UpdateSendBufferSize(
+      connection_id, response.body().size() + kResponseHeaderAllowance);
   server_->SendResponse(connection_id, response, traffic_annotation);
 }
 
-void HttpServer::OnResponse(
-    int connection_id,
-    bool keep_alive,
-    std::unique_ptr<net::HttpServerResponseInfo> response) {
+void HttpServer::OnResponse(int connection_id,
+                            bool keep_alive,
+                            std::unique_ptr<HttpResponsePayload> payload) {
+  cmd_runner_->PostTask(
+      FROM_HERE, base::BindOnce(&HttpHandler::OnHttpRequestDone, handler_,
+                                connection_id));
+  net::HttpServerResponseInfo* response = payload->info.get();
   if (!keep_alive)
     response->AddHeader("Connection", "close");
-  server_->SendResponse(connection_id, *response, TRAFFIC_ANNOTATION_FOR_TESTS);
+  const std::string& body =
+      payload->body ? payload->body->data() : response->body();
+  // Both paths below queue the entire response at once, so the ceiling must
+  // fit it whole; it shrinks back with the next small response.
+  UpdateSendBufferSize(connection_id,
+                       body.size() + kResponseHeaderAllowance);
+  if (!payload->body && body.size() < kStreamedBodyThreshold) {
+    server_->SendResponse(connection_id, *response,
+                          TRAFFIC_ANNOTATION_FOR_TESTS);
+  } else {
+    // SendResponse() builds headers + body as one string, which would
+    // briefly double a large body's memory. Send the headers first and
+    // then the body in bounded slices; Content-Length is already on the
+    // headers, so the response on the wire is identical. A ref-counted
+    // body never passed through the response info at all, so the slices
+    // are the only place it is copied on its way to the socket.
+    server_->SendRaw(connection_id, response->Serialize(),
+                     TRAFFIC_ANNOTATION_FOR_TESTS);
+    for (size_t offset = 0; offset < body.size(); offset += kBodySliceSize) {
+      server_->SendRaw(connection_id, body.substr(offset, kBodySliceSize),
+                       TRAFFIC_ANNOTATION_FOR_TESTS);
+    }
+  }
   // Don't need to call server_->Close(), since SendResponse() will handle
   // this for us.
 }
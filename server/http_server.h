@@ -5,6 +5,11 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_SERVER_HTTP_SERVER_H_
 #define CHROME_TEST_CHROMEDRIVER_SERVER_HTTP_SERVER_H_
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "base/json/json_reader.h"
 #include "chrome/test/chromedriver/server/http_handler.h"
 #include "net/base/url_util.h"
@@ -14,10 +19,50 @@
 #include "net/socket/tcp_server_socket.h"
 #include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
 
-typedef base::RepeatingCallback<void(const net::HttpServerRequestInfo&,
+typedef base::RepeatingCallback<void(int /* connection_id */,
+                                     const net::HttpServerRequestInfo&,
                                      const HttpResponseSenderFunc&)>
     HttpRequestHandlerFunc;
 
+// Request-admission policy, compiled once at server start so per-request
+// vetting does not reparse header values into GURLs or scan the whitelist
+// linearly. Origin and Host header values repeat for the life of a client,
+// so verdicts (positive and negative) are cached by exact header value and
+// the whitelist is binary-searched in sorted order; the steady state is a
+// hash probe per header. Lives on one IO thread; not thread safe.
+class AdmissionPolicy {
+ public:
+  AdmissionPolicy(bool allow_remote,
+                  const std::vector<net::IPAddress>& whitelisted_ips);
+  ~AdmissionPolicy();
+
+  // Returns whether the request may be served: a non-local origin requires
+  // remote access to be on and, when a whitelist is configured, an origin
+  // IP on it; requests with a local origin (or any request when remote
+  // access is off) must carry a local Host header if they carry one.
+  bool RequestIsSafeToServe(const net::HttpServerRequestInfo& info);
+
+ private:
+  // How an Origin header value classifies, including why it was rejected
+  // so repeated rejections still log their cause per request.
+  enum class OriginVerdict {
+    kAllowLocal,
+    kAllowRemote,
+    kRejectRemoteDisallowed,
+    kRejectUnparsable,
+    kRejectNotWhitelisted,
+  };
+
+  OriginVerdict ClassifyOrigin(const std::string& origin_header);
+
+  const bool allow_remote_;
+  std::vector<net::IPAddress> whitelisted_ips_;  // Sorted.
+  // Verdict caches keyed by exact header value, cleared wholesale at a
+  // size cap so a flood of unique junk headers cannot grow them.
+  std::unordered_map<std::string, OriginVerdict> origin_verdicts_;
+  std::unordered_map<std::string, bool> host_verdicts_;
+};
+
 class HttpServer : public net::HttpServer::Delegate {
  public:
   explicit HttpServer(const std::string& url_base,
@@ -28,7 +73,19 @@ class HttpServer : public net::HttpServer::Delegate {
 
   ~HttpServer() override;
 
-  int Start(uint16_t port, bool allow_remote, bool use_ipv4);
+  // Binds the listening socket and starts serving. With |reuse_port|, the
+  // socket is created with SO_REUSEPORT so several acceptor threads can
+  // listen on the same port and the kernel spreads incoming connections
+  // among them; unsupported off POSIX, where it fails with
+  // net::ERR_NOT_IMPLEMENTED.
+  int Start(uint16_t port, bool allow_remote, bool use_ipv4, bool reuse_port);
+
+  // Binds a Unix domain socket at |socket_path| and starts serving. Only
+  // peers running as the same user as this process are accepted, verified by
+  // the kernel via socket peer credentials, so the per-request Host/Origin
+  // admission checks are skipped for this listener. POSIX only; returns
+  // net::ERR_NOT_IMPLEMENTED elsewhere.
+  int StartOnUnixSocket(const std::string& socket_path);
 
   // Overridden from net::HttpServer::Delegate:
   void OnConnect(int connection_id) override;
@@ -46,6 +103,8 @@ class HttpServer : public net::HttpServer::Delegate {
   void AcceptWebSocket(int connection_id,
                        const net::HttpServerRequestInfo& request);
 
+  void SendOverWebSocket(int connection_id, std::string data);
+
   void SendResponse(int connection_id,
                     const net::HttpServerResponseInfo& response,
                     const net::NetworkTrafficAnnotationTag& traffic_annotation);
@@ -53,13 +112,29 @@ class HttpServer : public net::HttpServer::Delegate {
  private:
   void OnResponse(int connection_id,
                   bool keep_alive,
-                  std::unique_ptr<net::HttpServerResponseInfo> response);
+                  std::unique_ptr<HttpResponsePayload> payload);
+
+  // Raises or lowers the connection's send-buffer ceiling to the smallest
+  // size class that fits a payload of |bytes|, so queued writes to a slow
+  // client are bounded by the current response rather than by the maximum.
+  void UpdateSendBufferSize(int connection_id, size_t bytes);
+
   const std::string url_base_;
   HttpRequestHandlerFunc handle_request_func_;
   std::unique_ptr<net::HttpServer> server_;
   std::map<int, std::string> connection_to_session_map;
-  bool allow_remote_;
+  // Current send-buffer size class per connection, to skip redundant
+  // SetSendBufferSize calls.
+  std::map<int, size_t> send_buffer_sizes_;
   const std::vector<net::IPAddress> whitelisted_ips_;
+  // Compiled in Start, once |allow_remote| is known.
+  std::unique_ptr<AdmissionPolicy> admission_policy_;
+  // Set by StartOnUnixSocket: every peer was already vetted by credentials,
+  // so header-based admission checks do not apply.
+  bool trust_peer_credentials_ = false;
+  // Non-empty for a Unix domain listener; the socket file is removed when
+  // the server is destroyed.
+  std::string unix_socket_path_;
   base::WeakPtr<HttpHandler> handler_;
   scoped_refptr<base::SingleThreadTaskRunner> cmd_runner_;
   base::WeakPtrFactory<HttpServer> weak_factory_{this};  // Should be last.
@@ -0,0 +1,92 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/server/http_server.h"
+
+#include <vector>
+
+#include "net/base/ip_address.h"
+#include "net/server/http_server_request_info.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+net::HttpServerRequestInfo RequestWithHeaders(const std::string& origin,
+                                              const std::string& host) {
+  net::HttpServerRequestInfo info;
+  if (!origin.empty())
+    info.headers["origin"] = origin;
+  if (!host.empty())
+    info.headers["host"] = host;
+  return info;
+}
+
+}  // namespace
+
+TEST(AdmissionPolicy, NoHeadersAreAllowed) {
+  AdmissionPolicy policy(false, std::vector<net::IPAddress>());
+  EXPECT_TRUE(policy.RequestIsSafeToServe(RequestWithHeaders("", "")));
+}
+
+TEST(AdmissionPolicy, LocalOriginAndHostAreAllowed) {
+  AdmissionPolicy policy(false, std::vector<net::IPAddress>());
+  EXPECT_TRUE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("http://localhost:9515", "localhost:9515")));
+}
+
+TEST(AdmissionPolicy, RemoteOriginRejectedWithoutAllowRemote) {
+  AdmissionPolicy policy(false, std::vector<net::IPAddress>());
+  EXPECT_FALSE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("http://10.1.2.3", "")));
+  // The cached negative verdict must agree with the computed one.
+  EXPECT_FALSE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("http://10.1.2.3", "")));
+}
+
+TEST(AdmissionPolicy, RemoteOriginAllowedWithoutWhitelist) {
+  AdmissionPolicy policy(true, std::vector<net::IPAddress>());
+  EXPECT_TRUE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("http://10.1.2.3", "")));
+}
+
+TEST(AdmissionPolicy, WhitelistIsEnforced) {
+  std::vector<net::IPAddress> whitelist;
+  whitelist.push_back(net::IPAddress(10, 1, 2, 3));
+  AdmissionPolicy policy(true, whitelist);
+  EXPECT_TRUE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("http://10.1.2.3", "")));
+  EXPECT_FALSE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("http://10.9.9.9", "")));
+  // Repeat lookups hit the verdict caches and must not flip.
+  EXPECT_TRUE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("http://10.1.2.3", "")));
+  EXPECT_FALSE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("http://10.9.9.9", "")));
+}
+
+TEST(AdmissionPolicy, UnparsableOriginRejectedWithWhitelist) {
+  std::vector<net::IPAddress> whitelist;
+  whitelist.push_back(net::IPAddress(10, 1, 2, 3));
+  AdmissionPolicy policy(true, whitelist);
+  EXPECT_FALSE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("http://not an origin", "")));
+}
+
+TEST(AdmissionPolicy, NonLocalHostRejectedWhenRemoteAccessIsOff) {
+  AdmissionPolicy policy(false, std::vector<net::IPAddress>());
+  EXPECT_FALSE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("", "example.com:9515")));
+  EXPECT_FALSE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("http://localhost:9515", "example.com:9515")));
+  EXPECT_TRUE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("", "127.0.0.1:9515")));
+}
+
+TEST(AdmissionPolicy, HostIgnoredForWhitelistedRemoteOrigin) {
+  std::vector<net::IPAddress> whitelist;
+  whitelist.push_back(net::IPAddress(10, 1, 2, 3));
+  AdmissionPolicy policy(true, whitelist);
+  EXPECT_TRUE(policy.RequestIsSafeToServe(
+      RequestWithHeaders("http://10.1.2.3", "example.com:9515")));
+}
@@ -5,20 +5,52 @@
 #include "chrome/test/chromedriver/session.h"
 
 #include <list>
+#include <map>
 #include <utility>
 
+#include "base/bind.h"
+#include "base/files/file_util.h"
 #include "base/lazy_instance.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
 #include "base/threading/thread_local.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/chrome.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/web_view.h"
 #include "chrome/test/chromedriver/logging.h"
+#include "chrome/test/chromedriver/session_metrics.h"
 
 namespace {
 
-base::LazyInstance<base::ThreadLocalPointer<Session>>::DestructorAtExit
-    lazy_tls_session = LAZY_INSTANCE_INITIALIZER;
+// Sessions bound to the current thread, keyed by session id, plus the
+// session whose command is currently executing. With the default
+// thread-per-session executor the map holds at most one entry; with the
+// pooled executor several sessions may share a worker thread.
+struct ThreadLocalSessions {
+  std::map<std::string, std::unique_ptr<Session>> sessions;
+  Session* current = nullptr;
+};
+
+base::LazyInstance<base::ThreadLocalPointer<ThreadLocalSessions>>::
+    DestructorAtExit lazy_tls_sessions = LAZY_INSTANCE_INITIALIZER;
+
+void DeleteTempDirInBackground(const base::FilePath& path) {
+  ScopedTempDirWithRetry temp_dir;
+  if (!temp_dir.Set(path))
+    base::DeletePathRecursively(path);
+  // Otherwise deletion, with the usual retry on failure, happens when
+  // |temp_dir| goes out of scope.
+}
+
+ThreadLocalSessions* GetThreadLocalSessions() {
+  ThreadLocalSessions* tls = lazy_tls_sessions.Pointer()->Get();
+  if (!tls) {
+    tls = new ThreadLocalSessions();
+    lazy_tls_sessions.Pointer()->Set(tls);
+  }
+  return tls;
+}
 
 }  // namespace
 
@@ -51,6 +83,17 @@ InputCancelListEntry::InputCancelListEntry(InputCancelListEntry&& other) =
 
 InputCancelListEntry::~InputCancelListEntry() = default;
 
+SessionCapabilities::SessionCapabilities(
+    std::unique_ptr<base::DictionaryValue> caps)
+    : caps_(std::move(caps)) {}
+
+SessionCapabilities::~SessionCapabilities() = default;
+
+std::unique_ptr<base::DictionaryValue> SessionCapabilities::CreateCopy()
+    const {
+  return caps_->CreateDeepCopy();
+}
+
 // The default timeout values came from W3C spec.
 const base::TimeDelta Session::kDefaultImplicitWaitTimeout =
     base::TimeDelta::FromSeconds(0);
@@ -72,7 +115,9 @@ Session::Session(const std::string& id)
       script_timeout(kDefaultScriptTimeout),
       strict_file_interactability(false),
       click_count(0),
-      mouse_click_timestamp(base::TimeTicks::Now()) {}
+      mouse_click_timestamp(base::TimeTicks::Now()) {
+  memory_stats = SessionMetrics::GetInstance()->Register(id);
+}
 
 Session::Session(const std::string& id, std::unique_ptr<Chrome> chrome)
     : Session(id) {
@@ -83,7 +128,9 @@ Session::Session(const std::string& id, const std::string& host) : Session(id) {
   this->host = host;
 }
 
-Session::~Session() {}
+Session::~Session() {
+  SessionMetrics::GetInstance()->Unregister(id);
+}
 
 Status Session::GetTargetWindow(WebView** web_view) {
   if (!chrome)
@@ -146,9 +193,39 @@ void Session::SwitchFrameInternal(bool for_top_frame) {
 }
 
 Session* GetThreadLocalSession() {
-  return lazy_tls_session.Pointer()->Get();
+  return GetThreadLocalSessions()->current;
 }
 
 void SetThreadLocalSession(std::unique_ptr<Session> session) {
-  lazy_tls_session.Pointer()->Set(session.release());
+  ThreadLocalSessions* tls = GetThreadLocalSessions();
+  tls->current = session.get();
+  tls->sessions[session->id] = std::move(session);
+}
+
+Session* SwitchThreadLocalSession(const std::string& id) {
+  ThreadLocalSessions* tls = GetThreadLocalSessions();
+  auto iter = tls->sessions.find(id);
+  tls->current = iter == tls->sessions.end() ? nullptr : iter->second.get();
+  return tls->current;
+}
+
+void RemoveThreadLocalSession(const std::string& id) {
+  ThreadLocalSessions* tls = GetThreadLocalSessions();
+  auto iter = tls->sessions.find(id);
+  if (iter == tls->sessions.end())
+    return;
+  if (tls->current == iter->second.get())
+    tls->current = nullptr;
+  // Recursive deletion of the scratch directory retries with sleeps on
+  // failure and can dominate teardown. Hand the directory to a pool worker
+  // so this thread can exit, and be joined, without waiting on the file
+  // system; the quit response has already been posted by the caller.
+  if (iter->second->temp_dir.IsValid()) {
+    base::ThreadPool::PostTask(
+        FROM_HERE,
+        {base::MayBlock(), base::TaskShutdownBehavior::BLOCK_SHUTDOWN},
+        base::BindOnce(&DeleteTempDirInBackground,
+                       iter->second->temp_dir.Take()));
+  }
+  tls->sessions.erase(iter);
 }
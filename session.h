@@ -5,11 +5,16 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_SESSION_H_
 #define CHROME_TEST_CHROMEDRIVER_SESSION_H_
 
+#include <atomic>
 #include <list>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "base/callback.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
 #include "base/time/time.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/basic_types.h"
@@ -19,6 +24,7 @@
 #include "chrome/test/chromedriver/chrome/scoped_temp_dir_with_retry.h"
 #include "chrome/test/chromedriver/chrome/ui_events.h"
 #include "chrome/test/chromedriver/command_listener.h"
+#include "chrome/test/chromedriver/session_metrics.h"
 
 static const char kAccept[] = "accept";
 static const char kAcceptAndNotify[] = "accept and notify";
@@ -49,6 +55,32 @@ struct FrameInfo {
   std::string chromedriver_frame_id;
 };
 
+// One memoized frame-switch resolution; see Session::frame_switch_cache.
+struct FrameSwitchCacheEntry {
+  int navigation_epoch = 0;
+  std::string frame_id;
+  std::string chromedriver_frame_id;
+};
+
+// The capabilities dictionary returned to the client, built once when the
+// session starts. Immutable and ref-counted, so the session and the response
+// path share one instance instead of deep-copying it; readers that must hand
+// out an owned value clone it at that boundary only.
+class SessionCapabilities
+    : public base::RefCountedThreadSafe<SessionCapabilities> {
+ public:
+  explicit SessionCapabilities(std::unique_ptr<base::DictionaryValue> caps);
+
+  const base::DictionaryValue& dict() const { return *caps_; }
+  std::unique_ptr<base::DictionaryValue> CreateCopy() const;
+
+ private:
+  friend class base::RefCountedThreadSafe<SessionCapabilities>;
+  ~SessionCapabilities();
+
+  const std::unique_ptr<const base::DictionaryValue> caps_;
+};
+
 struct InputCancelListEntry {
   InputCancelListEntry(base::DictionaryValue* input_state,
                        const MouseEvent* mouse_event,
@@ -82,6 +114,12 @@ struct Session {
   std::string GetCurrentFrameId() const;
   std::vector<WebDriverLog*> GetAllLogs() const;
 
+  // Whether the HTTP client that issued the currently running command has
+  // dropped its connection; see |cmd_cancel_flag|.
+  bool IsCommandCancelled() const {
+    return cmd_cancel_flag && cmd_cancel_flag->load(std::memory_order_relaxed);
+  }
+
   const std::string id;
   bool w3c_compliant;
   bool webSocketUrl = false;
@@ -90,6 +128,28 @@ struct Session {
   std::unique_ptr<Chrome> chrome;
   std::string window;
   int sticky_modifiers;
+  // From the fastTyping capability: deliver plain-text runs of Send Keys
+  // with Input.insertText instead of synthesized key events.
+  bool fast_typing = false;
+  // Use the legacy stepped touch-event sequence for flick gestures instead
+  // of Input.synthesizeScrollGesture; from the "steppedTouchGestures"
+  // chromeOptions capability.
+  bool stepped_touch_gestures = false;
+  // From the "recoverOnCrash" chromeOptions capability: a page or browser
+  // crash relaunches the browser in place and restores recoverable state
+  // instead of deleting the session.
+  bool recover_on_crash = false;
+  // Relaunches the browser and re-applies recoverable state after a crash.
+  // Bound during session creation when recoverOnCrash is on, null otherwise;
+  // the binding carries the launch plumbing so the crash handler need not
+  // know how sessions are created.
+  base::RepeatingCallback<Status(Session*)> crash_recovery;
+  // Most recent periodic state snapshot in the ExecuteExportSession format,
+  // and when it was captured. Cookies cannot be read from a dead browser, so
+  // the snapshot is refreshed between commands and restored after a crash
+  // relaunch; see MaybeRefreshCrashRecoverySnapshot.
+  std::unique_ptr<base::DictionaryValue> crash_recovery_snapshot;
+  base::TimeTicks crash_snapshot_time;
   // List of input sources for each active input. Everytime a new input source
   // is added, there must be a corresponding entry made in input_state_table.
   base::ListValue active_input_sources;
@@ -102,6 +162,11 @@ struct Session {
   // first frame element in the root document. If target frame is window.top,
   // this list will be empty.
   std::list<FrameInfo> frames;
+  // Memoized frame-switch resolutions, keyed by window, parent frame and
+  // locator. An entry is honored only while the target's navigation epoch
+  // still matches the one recorded at resolution time, so a navigation in
+  // between forces a fresh resolution; see ExecuteSwitchToFrame.
+  std::map<std::string, FrameSwitchCacheEntry> frame_switch_cache;
   // Download directory that the user specifies. Used only in headless mode.
   // Defaults to current directory in headless mode if no directory specified
   std::unique_ptr<std::string> headless_download_directory;
@@ -118,8 +183,35 @@ struct Session {
   // Logs that populate from DevTools events.
   std::vector<std::unique_ptr<WebDriverLog>> devtools_logs;
   std::unique_ptr<WebDriverLog> driver_log;
+  // Log types streamed to the client over the session's WebSocket channel;
+  // empty when there is no subscription. See ExecuteSubscribeLogs.
+  std::vector<std::string> log_subscriptions;
+  // Sends one serialized log frame toward the session's WebSocket. Bound by
+  // ExecuteSubscribeLogs; safe to run on the session thread, as it only
+  // posts to the command thread.
+  base::RepeatingCallback<void(const std::string&)> log_push_func;
+  // Sequence number of the last pushed log batch and of the last one the
+  // client acknowledged; the drain pauses when their gap reaches the cap, so
+  // unread batches stay bounded on both sides.
+  int log_batch_seq = 0;
+  int log_batch_acked = 0;
+  // State of the navigation started by chromium/navigate_async. |token| is 0
+  // until the first async navigation is issued; |status| is "pending",
+  // "complete", "timeout" or "error". See ExecuteNavigateAsync.
+  int async_navigation_token = 0;
+  std::string async_navigation_status;
+  std::string async_navigation_error;
+  base::TimeTicks async_navigation_deadline;
+  // Sends one serialized completion frame toward the session's WebSocket
+  // when the async navigation settles; bound by ExecuteNavigateAsync and,
+  // like log_push_func, only posts to the command thread.
+  base::RepeatingCallback<void(const std::string&)> navigation_push_func;
   ScopedTempDirWithRetry temp_dir;
-  std::unique_ptr<base::DictionaryValue> capabilities;
+  // Extracted upload files keyed by a hash of the client payload, so
+  // repeated uploads of an identical archive reuse one extraction. The
+  // entries live inside |temp_dir| and are deleted with the session.
+  std::map<std::string, base::FilePath> upload_cache;
+  scoped_refptr<SessionCapabilities> capabilities;
   // |command_listeners| should be declared after |chrome|. When the |Session|
   // is destroyed, |command_listeners| should be freed first, since some
   // |CommandListener|s might be |CommandListenerProxy|s that forward to
@@ -131,13 +223,33 @@ struct Session {
   int click_count;
   base::TimeTicks mouse_click_timestamp;
   std::string host;
+  // Raised by the command thread when the HTTP connection that issued the
+  // currently running command goes away. Long waits poll it through
+  // IsCommandCancelled() so abandoned commands release the session thread
+  // instead of running out their full timeout. Null in tests.
+  std::atomic<bool>* cmd_cancel_flag = nullptr;
+  // Per-session gauges registered with SessionMetrics for the lifetime of
+  // this object; logs and the command dispatcher report into it.
+  scoped_refptr<SessionMemoryStats> memory_stats;
 
  private:
   void SwitchFrameInternal(bool for_top_frame);
 };
 
+// Returns the session whose command is currently executing on this thread,
+// or null if none is.
 Session* GetThreadLocalSession();
 
+// Binds |session| to the current thread and makes it current. Several
+// sessions may be bound to the same thread when the pooled session executor
+// is in use.
 void SetThreadLocalSession(std::unique_ptr<Session> session);
 
+// Makes the session with |id| current on this thread and returns it, or
+// returns null and clears the current session if |id| is not bound here.
+Session* SwitchThreadLocalSession(const std::string& id);
+
+// Unbinds and destroys the session with |id| on this thread.
+void RemoveThreadLocalSession(const std::string& id);
+
 #endif  // CHROME_TEST_CHROMEDRIVER_SESSION_H_
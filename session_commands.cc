@@ -4,13 +4,17 @@
 
 #include "chrome/test/chromedriver/session_commands.h"
 
+#include <algorithm>
 #include <list>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/files/file_util.h"
+#include "base/json/json_writer.h"
+#include "base/sha1.h"
 #include "base/logging.h"  // For CHECK macros.
 #include "base/memory/ref_counted.h"
 #include "base/strings/string_util.h"
@@ -19,23 +23,30 @@
 #include "base/synchronization/waitable_event.h"
 #include "base/system/sys_info.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/basic_types.h"
+#include "chrome/test/chromedriver/browser_pool.h"
 #include "chrome/test/chromedriver/capabilities.h"
 #include "chrome/test/chromedriver/chrome/browser_info.h"
 #include "chrome/test/chromedriver/chrome/chrome.h"
 #include "chrome/test/chromedriver/chrome/chrome_android_impl.h"
 #include "chrome/test/chromedriver/chrome/chrome_desktop_impl.h"
 #include "chrome/test/chromedriver/chrome/device_manager.h"
+#include "chrome/test/chromedriver/chrome/devtools_client_impl.h"
 #include "chrome/test/chromedriver/chrome/devtools_event_listener.h"
+#include "chrome/test/chromedriver/chrome/devtools_http_client.h"
+#include "chrome/test/chromedriver/chrome/driver_tracing.h"
 #include "chrome/test/chromedriver/chrome/geoposition.h"
 #include "chrome/test/chromedriver/chrome/javascript_dialog_manager.h"
+#include "chrome/test/chromedriver/chrome/network_conditions.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/web_view.h"
 #include "chrome/test/chromedriver/chrome_launcher.h"
 #include "chrome/test/chromedriver/command_listener.h"
 #include "chrome/test/chromedriver/constants/version.h"
 #include "chrome/test/chromedriver/logging.h"
+#include "chrome/test/chromedriver/net/timeout.h"
 #include "chrome/test/chromedriver/session.h"
 #include "chrome/test/chromedriver/util.h"
 #include "services/network/public/mojom/url_loader_factory.mojom.h"
@@ -91,12 +102,14 @@ InitSessionParams::InitSessionParams(
     const SyncWebSocketFactory& socket_factory,
     DeviceManager* device_manager,
     const scoped_refptr<base::SingleThreadTaskRunner> cmd_task_runner,
-    SessionConnectionMap* session_map)
+    SessionConnectionMap* session_map,
+    const scoped_refptr<BrowserPool>& browser_pool)
     : url_loader_factory(factory),
       socket_factory(socket_factory),
       device_manager(device_manager),
       cmd_task_runner(cmd_task_runner),
-      session_map(session_map) {}
+      session_map(session_map),
+      browser_pool(browser_pool) {}
 
 InitSessionParams::InitSessionParams(const InitSessionParams& other) = default;
 
@@ -138,6 +151,41 @@ bool GetW3CSetting(const base::DictionaryValue& params) {
   return kW3CDefault;
 }
 
+// Look for the session priority setting in InitSession command parameters.
+// Needed before full capabilities parsing because the session's executor is
+// created before the InitSession command runs; validation of the value is
+// left to the capabilities parser.
+bool GetLowPrioritySetting(const base::DictionaryValue& params) {
+  std::string priority;
+  const base::ListValue* list;
+  const base::DictionaryValue* caps_dict;
+  const base::DictionaryValue* options_dict;
+
+  if (params.GetDictionary("capabilities.alwaysMatch", &caps_dict)) {
+    if (GetChromeOptionsDictionary(*caps_dict, &options_dict) &&
+        options_dict->GetString("priority", &priority)) {
+      return priority == "batch";
+    }
+  }
+
+  if (params.GetList("capabilities.firstMatch", &list) &&
+      list->GetDictionary(0, &caps_dict)) {
+    if (GetChromeOptionsDictionary(*caps_dict, &options_dict) &&
+        options_dict->GetString("priority", &priority)) {
+      return priority == "batch";
+    }
+  }
+
+  if (params.GetDictionary("desiredCapabilities", &caps_dict)) {
+    if (GetChromeOptionsDictionary(*caps_dict, &options_dict) &&
+        options_dict->GetString("priority", &priority)) {
+      return priority == "batch";
+    }
+  }
+
+  return false;
+}
+
 namespace {
 
 // Creates a JSON object (represented by base::DictionaryValue) that contains
@@ -272,6 +320,73 @@ Status CheckSessionCreated(Session* session) {
   return Status(kOk);
 }
 
+// Replaces a crashed browser with a freshly launched one and re-applies the
+// session state that can be recovered: capability-derived configuration via
+// relaunch, and the most recent periodic snapshot (cookies, overrides,
+// current url) via the session-snapshot path. Runs on the session thread in
+// place of session deletion; see ExecuteSessionCommand's crash handling.
+Status RecoverSessionAfterCrash(const InitSessionParams& bound_params,
+                                const base::DictionaryValue* desired_caps,
+                                Session* session) {
+  Capabilities capabilities;
+  Status status = capabilities.Parse(*desired_caps, session->w3c_compliant);
+  if (status.IsError())
+    return status;
+
+  // The old command listeners may proxy to DevToolsEventListeners owned by
+  // the dead browser, so they go first; buffered DevTools logs die with it.
+  session->command_listeners.clear();
+  session->devtools_logs.clear();
+  if (session->chrome) {
+    session->chrome->Quit();
+    session->chrome.reset();
+  }
+
+  std::vector<std::unique_ptr<DevToolsEventListener>> devtools_event_listeners;
+  std::vector<std::unique_ptr<CommandListener>> command_listeners;
+  status = CreateLogs(capabilities, session, &session->devtools_logs,
+                      &devtools_event_listeners, &command_listeners);
+  if (status.IsError())
+    return status;
+  for (auto& log : session->devtools_logs)
+    log->set_memory_stats(session->memory_stats);
+  session->command_listeners.swap(command_listeners);
+
+  status = LaunchChrome(bound_params.url_loader_factory,
+                        bound_params.socket_factory,
+                        bound_params.device_manager, capabilities,
+                        std::move(devtools_event_listeners), &session->chrome,
+                        session->w3c_compliant);
+  if (status.IsError())
+    return status;
+
+  if (capabilities.accept_insecure_certs) {
+    status = session->chrome->SetAcceptInsecureCerts();
+    if (status.IsError())
+      return status;
+  }
+
+  status = session->chrome->GetWebViewIdForFirstTab(&session->window,
+                                                    session->w3c_compliant);
+  if (status.IsError())
+    return status;
+  // Frame and input state referenced the crashed renderer.
+  session->frames.clear();
+  session->input_cancel_list.clear();
+
+  status = internal::ConfigureHeadlessSession(session, capabilities);
+  if (status.IsError())
+    return status;
+
+  if (session->crash_recovery_snapshot) {
+    status = internal::AdoptSessionSnapshot(
+        session, *session->crash_recovery_snapshot);
+    if (status.IsError())
+      return status;
+  }
+  return Status(kOk);
+}
+
 Status InitSessionHelper(const InitSessionParams& bound_params,
                          Session* session,
                          const base::DictionaryValue& params,
@@ -297,17 +412,28 @@ Status InitSessionHelper(const InitSessionParams& bound_params,
                       &command_listeners);
   if (status.IsError())
     return status;
+  for (auto& log : session->devtools_logs)
+    log->set_memory_stats(session->memory_stats);
 
   // |session| will own the |CommandListener|s.
   session->command_listeners.swap(command_listeners);
 
-  status =
-      LaunchChrome(bound_params.url_loader_factory, bound_params.socket_factory,
-                   bound_params.device_manager, capabilities,
-                   std::move(devtools_event_listeners), &session->chrome,
-                   session->w3c_compliant);
-  if (status.IsError())
-    return status;
+  // Adopt a pre-launched browser from the warm pool when one is available.
+  // Sessions that need DevTools event listeners or a non-default launch
+  // configuration still get a dedicated launch below.
+  if (bound_params.browser_pool && devtools_event_listeners.empty() &&
+      BrowserPool::IsPoolCompatible(capabilities)) {
+    session->chrome = bound_params.browser_pool->TakeBrowser();
+  }
+  if (!session->chrome) {
+    status = LaunchChrome(bound_params.url_loader_factory,
+                          bound_params.socket_factory,
+                          bound_params.device_manager, capabilities,
+                          std::move(devtools_event_listeners), &session->chrome,
+                          session->w3c_compliant);
+    if (status.IsError())
+      return status;
+  }
 
   if (capabilities.accept_insecure_certs) {
     status = session->chrome->SetAcceptInsecureCerts();
@@ -320,23 +446,46 @@ Status InitSessionHelper(const InitSessionParams& bound_params,
   if (status.IsError())
     return status;
   session->detach = capabilities.detach;
-  session->capabilities =
-      CreateCapabilities(session, capabilities, *desired_caps);
+  session->fast_typing = capabilities.fast_typing;
+  session->stepped_touch_gestures = capabilities.stepped_touch_gestures;
+  session->recover_on_crash = capabilities.recover_on_crash;
+  if (capabilities.recover_on_crash) {
+    // A relaunch needs the original capabilities and the launch plumbing;
+    // both are bound here so the crash handler can recover the session
+    // without knowing how sessions are created.
+    session->crash_recovery =
+        base::BindRepeating(&RecoverSessionAfterCrash, bound_params,
+                            base::Owned(desired_caps->CreateDeepCopy()));
+  }
+  if (capabilities.trace_driver)
+    DriverTracing::SetEnabled(true);
+  session->capabilities = base::MakeRefCounted<SessionCapabilities>(
+      CreateCapabilities(session, capabilities, *desired_caps));
 
   status = internal::ConfigureHeadlessSession(session, capabilities);
   if (status.IsError())
     return status;
 
+  // Rehydrate state exported by chromium/export_session on another node,
+  // after the browser is up but before the session is reported created.
+  const base::DictionaryValue* snapshot = nullptr;
+  if (params.GetDictionary("chromium:sessionSnapshot", &snapshot)) {
+    status = internal::AdoptSessionSnapshot(session, *snapshot);
+    if (status.IsError()) {
+      return Status(kSessionNotCreated, "cannot adopt session snapshot",
+                    status);
+    }
+  }
+
+  // One clone hands ownership to the response; the session keeps sharing the
+  // ref-counted original.
   if (session->w3c_compliant) {
-    std::unique_ptr<base::DictionaryValue> capabilities =
-        std::unique_ptr<base::DictionaryValue>(
-            session->capabilities->DeepCopy());
     base::DictionaryValue body;
-    body.SetDictionary("capabilities", std::move(capabilities));
+    body.SetDictionary("capabilities", session->capabilities->CreateCopy());
     body.SetString("sessionId", session->id);
-    value->reset(body.DeepCopy());
+    *value = std::make_unique<base::DictionaryValue>(std::move(body));
   } else {
-    value->reset(session->capabilities->DeepCopy());
+    *value = session->capabilities->CreateCopy();
   }
   return CheckSessionCreated(session);
 }
@@ -352,6 +501,7 @@ Status ConfigureSession(Session* session,
                         Capabilities* capabilities) {
   session->driver_log =
       std::make_unique<WebDriverLog>(WebDriverLog::kDriverType, Log::kAll);
+  session->driver_log->set_memory_stats(session->memory_stats);
 
   session->w3c_compliant = GetW3CSetting(params);
   if (session->w3c_compliant) {
@@ -388,6 +538,10 @@ Status ConfigureSession(Session* session,
   if (capabilities->logging_prefs.count(WebDriverLog::kDriverType))
     driver_level = capabilities->logging_prefs[WebDriverLog::kDriverType];
   session->driver_log->set_min_level(driver_level);
+  if (capabilities->log_buffer_size > 0) {
+    session->driver_log->set_max_buffered_entries(
+        capabilities->log_buffer_size);
+  }
 
   return Status(kOk);
 }
@@ -415,6 +569,82 @@ Status ConfigureHeadlessSession(Session* session,
   return Status(kOk);
 }
 
+Status AdoptSessionSnapshot(Session* session,
+                            const base::DictionaryValue& snapshot) {
+  int snapshot_version = 0;
+  if (!snapshot.GetInteger("snapshotVersion", &snapshot_version) ||
+      snapshot_version != 1) {
+    return Status(kInvalidArgument, "unsupported session snapshot version");
+  }
+
+  int timeout_ms = 0;
+  if (snapshot.GetInteger("timeouts.script", &timeout_ms))
+    session->script_timeout = base::TimeDelta::FromMilliseconds(timeout_ms);
+  if (snapshot.GetInteger("timeouts.pageLoad", &timeout_ms))
+    session->page_load_timeout = base::TimeDelta::FromMilliseconds(timeout_ms);
+  if (snapshot.GetInteger("timeouts.implicit", &timeout_ms))
+    session->implicit_wait = base::TimeDelta::FromMilliseconds(timeout_ms);
+
+  WebView* web_view = nullptr;
+  Status status = session->GetTargetWindow(&web_view);
+  if (status.IsError())
+    return status;
+
+  const base::ListValue* cookies = nullptr;
+  if (snapshot.GetList("cookies", &cookies) && !cookies->empty()) {
+    status = web_view->SetCookies(*cookies);
+    if (status.IsError())
+      return status;
+  }
+
+  const base::DictionaryValue* geolocation = nullptr;
+  if (snapshot.GetDictionary("geolocation", &geolocation)) {
+    Geoposition geoposition;
+    if (!geolocation->GetDouble("latitude", &geoposition.latitude) ||
+        !geolocation->GetDouble("longitude", &geoposition.longitude) ||
+        !geolocation->GetDouble("accuracy", &geoposition.accuracy)) {
+      return Status(kInvalidArgument, "invalid geolocation in snapshot");
+    }
+    status = web_view->OverrideGeolocation(geoposition);
+    if (status.IsError())
+      return status;
+    session->overridden_geoposition =
+        std::make_unique<Geoposition>(geoposition);
+  }
+
+  const base::DictionaryValue* conditions = nullptr;
+  if (snapshot.GetDictionary("networkConditions", &conditions)) {
+    auto network_conditions = std::make_unique<NetworkConditions>();
+    if (!conditions->GetBoolean("offline", &network_conditions->offline) ||
+        !conditions->GetDouble("latency", &network_conditions->latency) ||
+        !conditions->GetDouble("downloadThroughput",
+                               &network_conditions->download_throughput) ||
+        !conditions->GetDouble("uploadThroughput",
+                               &network_conditions->upload_throughput)) {
+      return Status(kInvalidArgument, "invalid networkConditions in snapshot");
+    }
+    status = web_view->OverrideNetworkConditions(*network_conditions);
+    if (status.IsError())
+      return status;
+    session->overridden_network_conditions = std::move(network_conditions);
+  }
+
+  // Navigation is best effort: the exported page may be gone by the time the
+  // session lands on the new node, and a missing page should not void the
+  // state restored above.
+  std::string url;
+  if (snapshot.GetString("url", &url) && !url.empty() &&
+      url != "about:blank") {
+    Timeout timeout(session->page_load_timeout);
+    status = web_view->Load(url, &timeout);
+    if (status.IsError()) {
+      LOG(WARNING) << "session snapshot navigation to " << url
+                   << " failed: " << status.message();
+    }
+  }
+  return Status(kOk);
+}
+
 }  // namespace internal
 
 bool MergeCapabilities(const base::DictionaryValue* always_match,
@@ -646,7 +876,7 @@ Status ExecuteQuit(bool allow_detach,
 Status ExecuteGetSessionCapabilities(Session* session,
                                      const base::DictionaryValue& params,
                                      std::unique_ptr<base::Value>* value) {
-  value->reset(session->capabilities->DeepCopy());
+  *value = session->capabilities->CreateCopy();
   return Status(kOk);
 }
 
@@ -752,6 +982,100 @@ Status ExecuteGetWindowHandles(Session* session,
   return Status(kOk);
 }
 
+Status ExecuteGetWindows(Session* session,
+                         const base::DictionaryValue& params,
+                         std::unique_ptr<base::Value>* value) {
+  std::vector<WebViewInfo> views;
+  Status status =
+      session->chrome->GetWebViewsSummary(&views, session->w3c_compliant);
+  if (status.IsError())
+    return status;
+  std::unique_ptr<base::ListValue> windows(new base::ListValue());
+  for (const WebViewInfo& view : views) {
+    auto window = std::make_unique<base::DictionaryValue>();
+    window->SetString("handle", WebViewIdToWindowHandle(view.id));
+    window->SetString("title", view.title);
+    window->SetString("url", view.url);
+    window->SetString("type", WebViewTypeToString(view.type));
+    windows->Append(std::move(window));
+  }
+  *value = std::move(windows);
+  return Status(kOk);
+}
+
+namespace {
+
+// One in-flight capture of ExecuteScreenshotAll. |data| carries the image
+// when the view's client executed the capture synchronously instead of
+// handing back a future.
+struct PendingCapture {
+  explicit PendingCapture(const std::string& web_view_id)
+      : web_view_id(web_view_id), status(kOk) {}
+  PendingCapture(PendingCapture&&) = default;
+  PendingCapture& operator=(PendingCapture&&) = default;
+
+  std::string web_view_id;
+  Status status;
+  std::string data;
+  std::unique_ptr<DevToolsCommandFuture> future;
+};
+
+}  // namespace
+
+Status ExecuteScreenshotAll(Session* session,
+                            const base::DictionaryValue& params,
+                            std::unique_ptr<base::Value>* value) {
+  std::list<std::string> web_view_ids;
+  Status status = session->chrome->GetWebViewIds(&web_view_ids,
+                                                 session->w3c_compliant);
+  if (status.IsError())
+    return status;
+
+  // Issue every capture before collecting any response, so the browser
+  // rasterizes the views concurrently; each view's client pumps its own
+  // connection.
+  std::vector<PendingCapture> captures;
+  for (const std::string& web_view_id : web_view_ids) {
+    captures.push_back(PendingCapture(web_view_id));
+    PendingCapture& capture = captures.back();
+    WebView* web_view = nullptr;
+    capture.status = session->chrome->GetWebViewById(web_view_id, &web_view);
+    if (capture.status.IsOk()) {
+      capture.status = web_view->CaptureScreenshotAndGetFuture(
+          params, &capture.data, &capture.future);
+    }
+  }
+
+  // The captures run in parallel, so one deadline covers the batch; this
+  // matches the per-capture budget of the single-window screenshot.
+  Timeout timeout(base::TimeDelta::FromSeconds(10));
+  std::unique_ptr<base::DictionaryValue> images(new base::DictionaryValue());
+  for (PendingCapture& capture : captures) {
+    if (capture.status.IsOk() && capture.future) {
+      std::unique_ptr<base::DictionaryValue> result;
+      capture.status = capture.future->Get(&timeout, &result);
+      if (capture.status.IsOk()) {
+        std::string* data = result->FindStringKey("data");
+        if (data)
+          capture.data = std::move(*data);
+        else
+          capture.status =
+              Status(kUnknownError, "expected string 'data' in response");
+      }
+    }
+    // A failed capture (e.g. a window closed mid-command) becomes a null
+    // entry rather than failing the whole snapshot, mirroring
+    // SendCommandBatch.
+    std::string handle = WebViewIdToWindowHandle(capture.web_view_id);
+    if (capture.status.IsOk())
+      images->SetKey(handle, base::Value(std::move(capture.data)));
+    else
+      images->SetKey(handle, base::Value());
+  }
+  *value = std::move(images);
+  return Status(kOk);
+}
+
 Status ExecuteSwitchToWindow(Session* session,
                              const base::DictionaryValue& params,
                              std::unique_ptr<base::Value>* value) {
@@ -846,7 +1170,7 @@ Status ExecuteSwitchToWindow(Session* session,
     }
   }
 
-  status = session->chrome->ActivateWebView(web_view_id);
+  status = session->chrome->ActivateWebView(web_view_id, true);
   if (status.IsError())
     return status;
   session->window = web_view_id;
@@ -941,10 +1265,156 @@ Status ExecuteGetTimeouts(Session* session,
                         session->page_load_timeout.InMilliseconds());
   SetSafeInt(&timeouts, "implicit", session->implicit_wait.InMilliseconds());
 
-  value->reset(timeouts.DeepCopy());
+  *value = base::Value::ToUniquePtrValue(std::move(timeouts));
+  return Status(kOk);
+}
+
+namespace {
+
+// Reduces DevTools cookie objects to the fields Network.setCookies accepts,
+// dropping read-only bookkeeping (size, session, priority) and session
+// cookies' sentinel expiry.
+std::unique_ptr<base::ListValue> FilterTransferableCookies(
+    const base::ListValue& cookies) {
+  auto filtered = std::make_unique<base::ListValue>();
+  for (const base::Value& entry : cookies.GetList()) {
+    const base::DictionaryValue* cookie = nullptr;
+    if (!entry.GetAsDictionary(&cookie))
+      continue;
+    auto out = std::make_unique<base::DictionaryValue>();
+    std::string str;
+    bool flag;
+    double num;
+    if (!cookie->GetString("name", &str))
+      continue;
+    out->SetString("name", str);
+    if (!cookie->GetString("value", &str))
+      continue;
+    out->SetString("value", str);
+    if (cookie->GetString("domain", &str))
+      out->SetString("domain", str);
+    if (cookie->GetString("path", &str))
+      out->SetString("path", str);
+    if (cookie->GetBoolean("secure", &flag))
+      out->SetBoolean("secure", flag);
+    if (cookie->GetBoolean("httpOnly", &flag))
+      out->SetBoolean("httpOnly", flag);
+    if (cookie->GetString("sameSite", &str))
+      out->SetString("sameSite", str);
+    if (cookie->GetDouble("expires", &num) && num > 0)
+      out->SetDouble("expires", num);
+    filtered->Append(std::move(out));
+  }
+  return filtered;
+}
+
+}  // namespace
+
+Status ExecuteExportSession(Session* session,
+                            const base::DictionaryValue& params,
+                            std::unique_ptr<base::Value>* value) {
+  auto snapshot = std::make_unique<base::DictionaryValue>();
+  snapshot->SetInteger("snapshotVersion", 1);
+  snapshot->SetBoolean("w3c", session->w3c_compliant);
+  snapshot->SetDictionary("capabilities", session->capabilities->CreateCopy());
+  snapshot->SetString("unhandledPromptBehavior",
+                      session->unhandled_prompt_behavior);
+
+  base::DictionaryValue timeouts;
+  if (session->script_timeout != base::TimeDelta::Max())
+    SetSafeInt(&timeouts, "script", session->script_timeout.InMilliseconds());
+  SetSafeInt(&timeouts, "pageLoad",
+             session->page_load_timeout.InMilliseconds());
+  SetSafeInt(&timeouts, "implicit", session->implicit_wait.InMilliseconds());
+  snapshot->SetKey("timeouts", std::move(timeouts));
+
+  if (session->overridden_geoposition) {
+    base::DictionaryValue geoposition;
+    geoposition.SetDouble("latitude",
+                          session->overridden_geoposition->latitude);
+    geoposition.SetDouble("longitude",
+                          session->overridden_geoposition->longitude);
+    geoposition.SetDouble("accuracy",
+                          session->overridden_geoposition->accuracy);
+    snapshot->SetKey("geolocation", std::move(geoposition));
+  }
+  if (session->overridden_network_conditions) {
+    base::DictionaryValue conditions;
+    conditions.SetBoolean("offline",
+                          session->overridden_network_conditions->offline);
+    conditions.SetDouble("latency",
+                         session->overridden_network_conditions->latency);
+    conditions.SetDouble(
+        "downloadThroughput",
+        session->overridden_network_conditions->download_throughput);
+    conditions.SetDouble(
+        "uploadThroughput",
+        session->overridden_network_conditions->upload_throughput);
+    snapshot->SetKey("networkConditions", std::move(conditions));
+  }
+
+  WebView* web_view = nullptr;
+  Status status = session->GetTargetWindow(&web_view);
+  if (status.IsError())
+    return status;
+  std::string url;
+  status = web_view->GetUrl(&url);
+  if (status.IsError())
+    return status;
+  snapshot->SetString("url", url);
+
+  // The whole profile's cookies, not just the current document's, so logins
+  // against other origins survive the move.
+  base::DictionaryValue cookie_params;
+  std::unique_ptr<base::Value> cookie_result;
+  status = web_view->SendCommandAndGetResult("Network.getAllCookies",
+                                             cookie_params, &cookie_result);
+  if (status.IsError())
+    return status;
+  base::DictionaryValue* cookie_dict = nullptr;
+  base::ListValue* cookies = nullptr;
+  if (cookie_result && cookie_result->GetAsDictionary(&cookie_dict) &&
+      cookie_dict->GetList("cookies", &cookies)) {
+    snapshot->Set("cookies", FilterTransferableCookies(*cookies));
+  }
+
+  *value = std::move(snapshot);
   return Status(kOk);
 }
 
+namespace {
+
+// How old the crash-recovery snapshot may get before a command boundary
+// refreshes it. The interval bounds both the staleness of the restored state
+// and the DevTools traffic spent keeping it fresh.
+const int kCrashSnapshotIntervalSeconds = 30;
+
+}  // namespace
+
+void MaybeRefreshCrashRecoverySnapshot(Session* session) {
+  if (!session->recover_on_crash || !session->chrome)
+    return;
+  const base::TimeTicks now = base::TimeTicks::Now();
+  if (!session->crash_snapshot_time.is_null() &&
+      now - session->crash_snapshot_time <
+          base::TimeDelta::FromSeconds(kCrashSnapshotIntervalSeconds)) {
+    return;
+  }
+  // Stamp before exporting so a browser that cannot be snapshotted is only
+  // retried once per interval, not on every command.
+  session->crash_snapshot_time = now;
+
+  base::DictionaryValue params;
+  std::unique_ptr<base::Value> snapshot;
+  Status status = ExecuteExportSession(session, params, &snapshot);
+  if (status.IsError() || !snapshot)
+    return;
+  std::unique_ptr<base::DictionaryValue> dict =
+      base::DictionaryValue::From(std::move(snapshot));
+  if (dict)
+    session->crash_recovery_snapshot = std::move(dict);
+}
+
 Status ExecuteSetScriptTimeout(Session* session,
                                const base::DictionaryValue& params,
                                std::unique_ptr<base::Value>* value) {
@@ -1001,7 +1471,7 @@ Status ExecuteGetLocation(Session* session,
   // Set a dummy altitude to make WebDriver clients happy.
   // https://code.google.com/p/chromedriver/issues/detail?id=281
   location.SetDouble("altitude", 0);
-  value->reset(location.DeepCopy());
+  *value = base::Value::ToUniquePtrValue(std::move(location));
   return Status(kOk);
 }
 
@@ -1040,7 +1510,7 @@ Status ExecuteGetNetworkConditions(Session* session,
   conditions.SetInteger(
       "upload_throughput",
       session->overridden_network_conditions->upload_throughput);
-  value->reset(conditions.DeepCopy());
+  *value = base::Value::ToUniquePtrValue(std::move(conditions));
   return Status(kOk);
 }
 
@@ -1102,14 +1572,20 @@ Status ExecuteSetNetworkConnection(Session* session,
   if (status.IsError())
     return status;
 
+  // Issue every view's emulation commands before collecting any response,
+  // so the fan-out costs one round trip however many views the session has.
+  std::vector<WebView*> web_views;
   for (std::string web_view_id : web_view_ids) {
     WebView* web_view;
     status = session->chrome->GetWebViewById(web_view_id, &web_view);
     if (status.IsError())
       return status;
-    web_view->OverrideNetworkConditions(
-      *session->overridden_network_conditions);
+    web_view->OverrideNetworkConditionsAsync(
+        *session->overridden_network_conditions);
+    web_views.push_back(web_view);
   }
+  for (WebView* web_view : web_views)
+    web_view->CollectNetworkConditionsAck();
 
   *value = std::make_unique<base::Value>(connection_type);
   return Status(kOk);
@@ -1127,7 +1603,7 @@ Status ExecuteGetWindowPosition(Session* session,
   base::DictionaryValue position;
   position.SetInteger("x", windowRect.x);
   position.SetInteger("y", windowRect.y);
-  value->reset(position.DeepCopy());
+  *value = base::Value::ToUniquePtrValue(std::move(position));
   return Status(kOk);
 }
 
@@ -1157,7 +1633,7 @@ Status ExecuteGetWindowSize(Session* session,
   base::DictionaryValue size;
   size.SetInteger("width", windowRect.width);
   size.SetInteger("height", windowRect.height);
-  value->reset(size.DeepCopy());
+  *value = base::Value::ToUniquePtrValue(std::move(size));
   return Status(kOk);
 }
 
@@ -1186,6 +1662,12 @@ Status ExecuteGetAvailableLogTypes(Session* session,
        ++log) {
     types->AppendString((*log)->type());
   }
+  // The device console is only captured on Android; see Device's logcat
+  // capture.
+  if (session->chrome &&
+      session->chrome->GetOperatingSystemName() == "ANDROID") {
+    types->AppendString("logcat");
+  }
   *value = std::move(types);
   return Status(kOk);
 }
@@ -1198,6 +1680,31 @@ Status ExecuteGetLog(Session* session,
     return Status(kInvalidArgument, "missing or invalid 'type'");
   }
 
+  // The device console is buffered driver-side by the persistent logcat
+  // capture (see Device::StartLogcatCapture), so it is served straight from
+  // memory without flushing the renderer or another adb round trip.
+  if (log_type == "logcat") {
+    if (!session->chrome)
+      return Status(kInvalidSessionId, "session has no browser");
+    std::vector<std::string> lines;
+    Status status = session->chrome->GetBufferedDeviceLog(&lines);
+    if (status.IsError())
+      return status;
+    auto entries = std::make_unique<base::ListValue>();
+    // Logcat lines carry their own device-side timestamps in the message
+    // text; the entry timestamp only records when the line was served.
+    double timestamp = base::Time::Now().ToJsTime();
+    for (const std::string& line : lines) {
+      auto entry = std::make_unique<base::DictionaryValue>();
+      entry->SetDouble("timestamp", static_cast<int64_t>(timestamp));
+      entry->SetString("level", "INFO");
+      entry->SetString("message", line);
+      entries->Append(std::move(entry));
+    }
+    *value = std::move(entries);
+    return Status(kOk);
+  }
+
   // Evaluate a JavaScript in the renderer process for the current tab, to flush
   // out any pending logging-related events.
   Status status = EvaluateScriptAndIgnoreResult(session, "1");
@@ -1221,12 +1728,264 @@ Status ExecuteGetLog(Session* session,
   return Status(kInvalidArgument, "log type '" + log_type + "' not found");
 }
 
+namespace {
+
+// How many pushed log batches may await acknowledgement before the drain
+// pauses. While paused, entries wait in the logs' own bounded ring buffers,
+// so a slow or stalled client cannot grow server-side memory.
+const int kMaxUnackedLogBatches = 16;
+
+// Session-thread half of the log push: hands the serialized frame to the
+// command thread, which owns the WebSocket connection maps.
+void PostLogFrameToCommandThread(
+    const scoped_refptr<base::SingleThreadTaskRunner>& cmd_task_runner,
+    const base::RepeatingCallback<void(const std::string&,
+                                       const std::string&)>& send_frame_func,
+    const std::string& session_id,
+    const std::string& frame) {
+  cmd_task_runner->PostTask(
+      FROM_HERE, base::BindOnce(send_frame_func, session_id, frame));
+}
+
+}  // namespace
+
+Status ExecuteSubscribeLogs(
+    const base::RepeatingCallback<void(const std::string&,
+                                       const std::string&)>& send_frame_func,
+    const scoped_refptr<base::SingleThreadTaskRunner>& cmd_task_runner,
+    Session* session,
+    const base::DictionaryValue& params,
+    std::unique_ptr<base::Value>* value) {
+  const base::ListValue* types = nullptr;
+  if (!params.GetList("types", &types) || types->empty())
+    return Status(kInvalidArgument, "'types' must be a non-empty list");
+
+  std::vector<std::string> subscriptions;
+  std::vector<WebDriverLog*> logs = session->GetAllLogs();
+  for (const base::Value& entry : types->GetList()) {
+    if (!entry.is_string())
+      return Status(kInvalidArgument, "'types' entries must be strings");
+    const std::string& type = entry.GetString();
+    bool known = false;
+    for (WebDriverLog* log : logs) {
+      if (log->type() == type) {
+        known = true;
+        break;
+      }
+    }
+    if (!known)
+      return Status(kInvalidArgument, "log type '" + type + "' not found");
+    subscriptions.push_back(type);
+  }
+
+  session->log_subscriptions.swap(subscriptions);
+  session->log_push_func = base::BindRepeating(
+      &PostLogFrameToCommandThread, cmd_task_runner, send_frame_func,
+      session->id);
+  return Status(kOk);
+}
+
+Status ExecuteUnsubscribeLogs(Session* session,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value) {
+  session->log_subscriptions.clear();
+  return Status(kOk);
+}
+
+namespace {
+
+// How often the async-navigation watcher checks whether the load has
+// settled. Each check interleaves with client commands on the session
+// thread, so a short interval keeps completion latency low without holding
+// the thread.
+const int kAsyncNavigationPollIntervalMs = 100;
+
+// Serializes the settled async navigation's outcome and hands it to the
+// session's WebSocket channel as a "navigation.completed" frame.
+void PushAsyncNavigationFrame(Session* session) {
+  if (session->navigation_push_func.is_null())
+    return;
+  base::DictionaryValue result;
+  result.SetInteger("token", session->async_navigation_token);
+  result.SetString("status", session->async_navigation_status);
+  if (!session->async_navigation_error.empty())
+    result.SetString("message", session->async_navigation_error);
+  base::DictionaryValue frame;
+  frame.SetString("method", "navigation.completed");
+  frame.SetKey("params", std::move(result));
+  std::string serialized;
+  base::JSONWriter::Write(frame, &serialized);
+  session->navigation_push_func.Run(serialized);
+}
+
+// Session-thread watcher behind ExecuteNavigateAsync. Exits quietly when
+// the session is gone or a newer async navigation superseded |token|;
+// otherwise it settles the token or re-posts itself.
+void PollAsyncNavigationOnSessionThread(const std::string& session_id,
+                                        int token) {
+  Session* session = SwitchThreadLocalSession(session_id);
+  if (!session || session->async_navigation_token != token ||
+      session->async_navigation_status != "pending")
+    return;
+
+  WebView* web_view = nullptr;
+  Status status = session->GetTargetWindow(&web_view);
+  bool is_pending = false;
+  if (status.IsOk()) {
+    Timeout timeout(base::TimeDelta::FromSeconds(10));
+    status = web_view->IsPendingNavigation(&timeout, &is_pending);
+  }
+  if (status.IsError()) {
+    session->async_navigation_status = "error";
+    session->async_navigation_error = status.message();
+  } else if (!is_pending) {
+    session->async_navigation_status = "complete";
+  } else if (base::TimeTicks::Now() >= session->async_navigation_deadline) {
+    session->async_navigation_status = "timeout";
+  } else {
+    base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+        FROM_HERE,
+        base::BindOnce(&PollAsyncNavigationOnSessionThread, session_id,
+                       token),
+        base::TimeDelta::FromMilliseconds(kAsyncNavigationPollIntervalMs));
+    return;
+  }
+  PushAsyncNavigationFrame(session);
+}
+
+}  // namespace
+
+Status ExecuteNavigateAsync(
+    const base::RepeatingCallback<void(const std::string&,
+                                       const std::string&)>& send_frame_func,
+    const scoped_refptr<base::SingleThreadTaskRunner>& cmd_task_runner,
+    Session* session,
+    const base::DictionaryValue& params,
+    std::unique_ptr<base::Value>* value) {
+  const std::string* url = params.FindStringKey("url");
+  if (!url)
+    return Status(kInvalidArgument, "'url' must be a string");
+
+  WebView* web_view = nullptr;
+  Status status = session->GetTargetWindow(&web_view);
+  if (status.IsError())
+    return status;
+  status = web_view->ConnectIfNecessary();
+  if (status.IsError())
+    return status;
+
+  // Load() returns once the browser has accepted the navigation; unlike
+  // ExecuteGet, nothing here waits for the page-load strategy.
+  Timeout timeout(session->page_load_timeout);
+  status = web_view->Load(*url, &timeout);
+  if (status.IsError())
+    return status;
+  session->SwitchToTopFrame();
+
+  int token = ++session->async_navigation_token;
+  session->async_navigation_status = "pending";
+  session->async_navigation_error.clear();
+  session->async_navigation_deadline =
+      base::TimeTicks::Now() + session->page_load_timeout;
+  session->navigation_push_func = base::BindRepeating(
+      &PostLogFrameToCommandThread, cmd_task_runner, send_frame_func,
+      session->id);
+  base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&PollAsyncNavigationOnSessionThread, session->id, token),
+      base::TimeDelta::FromMilliseconds(kAsyncNavigationPollIntervalMs));
+
+  auto result = std::make_unique<base::DictionaryValue>();
+  result->SetInteger("token", token);
+  *value = std::move(result);
+  return Status(kOk);
+}
+
+Status ExecuteGetNavigationStatus(Session* session,
+                                  const base::DictionaryValue& params,
+                                  std::unique_ptr<base::Value>* value) {
+  if (session->async_navigation_token == 0)
+    return Status(kInvalidArgument, "no async navigation has been started");
+  int token = 0;
+  if (params.GetInteger("token", &token) &&
+      token != session->async_navigation_token) {
+    return Status(kInvalidArgument,
+                  "unknown navigation token; only the most recent async "
+                  "navigation can be polled");
+  }
+  auto result = std::make_unique<base::DictionaryValue>();
+  result->SetInteger("token", session->async_navigation_token);
+  result->SetString("status", session->async_navigation_status);
+  if (!session->async_navigation_error.empty())
+    result->SetString("message", session->async_navigation_error);
+  *value = std::move(result);
+  return Status(kOk);
+}
+
+Status ExecuteAckLogs(Session* session,
+                      const base::DictionaryValue& params,
+                      std::unique_ptr<base::Value>* value) {
+  int seq = 0;
+  if (!params.GetInteger("seq", &seq))
+    return Status(kInvalidArgument, "missing or invalid 'seq'");
+  if (seq > session->log_batch_acked)
+    session->log_batch_acked = std::min(seq, session->log_batch_seq);
+  return Status(kOk);
+}
+
+void PushSubscribedLogEntries(Session* session) {
+  if (session->log_subscriptions.empty() || session->log_push_func.is_null())
+    return;
+  std::vector<WebDriverLog*> logs = session->GetAllLogs();
+  for (const std::string& type : session->log_subscriptions) {
+    if (session->log_batch_seq - session->log_batch_acked >=
+        kMaxUnackedLogBatches) {
+      // The client is behind; leave further entries buffering in the logs
+      // until it acknowledges.
+      return;
+    }
+    for (WebDriverLog* log : logs) {
+      if (log->type() != type)
+        continue;
+      std::unique_ptr<base::ListValue> entries = log->GetAndClearEntries();
+      if (!entries || entries->empty())
+        continue;
+      base::DictionaryValue batch;
+      batch.SetString("type", type);
+      batch.SetInteger("seq", ++session->log_batch_seq);
+      batch.Set("entries", std::move(entries));
+      base::DictionaryValue frame;
+      frame.SetString("method", "log.entriesAdded");
+      frame.SetKey("params", std::move(batch));
+      // Serialized here, on the session thread, so the command thread only
+      // forwards bytes.
+      std::string serialized;
+      base::JSONWriter::Write(frame, &serialized);
+      session->log_push_func.Run(serialized);
+    }
+  }
+}
+
 Status ExecuteUploadFile(Session* session,
                          const base::DictionaryValue& params,
                          std::unique_ptr<base::Value>* value) {
   std::string base64_zip_data;
   if (!params.GetString("file", &base64_zip_data))
     return Status(kInvalidArgument, "missing or invalid 'file'");
+
+  // Data-driven tests upload the same fixture archives over and over; an
+  // identical payload resolves to the already extracted file, skipping the
+  // decode, disk write and unzip. Keyed on the raw payload so a hit does no
+  // base64 work either; the extraction lives in |temp_dir|, so its lifetime
+  // matches the session.
+  const std::string content_hash = base::SHA1HashString(base64_zip_data);
+  auto cached = session->upload_cache.find(content_hash);
+  if (cached != session->upload_cache.end() &&
+      base::PathExists(cached->second)) {
+    *value = std::make_unique<base::Value>(cached->second.AsUTF8Unsafe());
+    return Status(kOk);
+  }
+
   std::string zip_data;
   if (!Base64Decode(base64_zip_data, &zip_data))
     return Status(kUnknownError, "unable to decode 'file'");
@@ -1247,6 +2006,7 @@ Status ExecuteUploadFile(Session* session,
   if (status.IsError())
     return Status(kUnknownError, "unable to unzip 'file'", status);
 
+  session->upload_cache[content_hash] = upload;
   *value = std::make_unique<base::Value>(upload.AsUTF8Unsafe());
   return Status(kOk);
 }
@@ -1298,3 +2058,154 @@ Status ExecuteSetTimeZone(Session* session,
                                     value);
   return Status(kOk);
 }
+
+Status ExecuteBatch(const BatchCommandMap* batch_commands,
+                    Session* session,
+                    const base::DictionaryValue& params,
+                    std::unique_ptr<base::Value>* value) {
+  const base::ListValue* commands;
+  if (!params.GetList("commands", &commands))
+    return Status(kInvalidArgument, "'commands' must be a list");
+
+  std::unique_ptr<base::ListValue> results(new base::ListValue());
+  for (size_t i = 0; i < commands->GetSize(); ++i) {
+    const base::DictionaryValue* entry;
+    if (!commands->GetDictionary(i, &entry)) {
+      return Status(kInvalidArgument,
+                    base::StringPrintf("batch entry %zu is not an object", i));
+    }
+    std::string name;
+    if (!entry->GetString("name", &name)) {
+      return Status(
+          kInvalidArgument,
+          base::StringPrintf("batch entry %zu has no string 'name'", i));
+    }
+    auto iter = batch_commands->find(name);
+    if (iter == batch_commands->end())
+      return Status(kInvalidArgument, "unknown batch command: " + name);
+    if (session->w3c_compliant && !iter->second.w3c_standard_command) {
+      return Status(kUnknownCommand,
+                    "Cannot call non W3C standard command while in W3C mode");
+    }
+    const base::DictionaryValue* command_params;
+    base::DictionaryValue no_params;
+    if (!entry->GetDictionary("parameters", &command_params)) {
+      if (entry->FindKey("parameters")) {
+        return Status(
+            kInvalidArgument,
+            base::StringPrintf("batch entry %zu 'parameters' is not an object",
+                               i));
+      }
+      command_params = &no_params;
+    }
+    std::unique_ptr<base::Value> command_value;
+    Status status =
+        iter->second.command.Run(session, *command_params, &command_value);
+    if (status.IsError()) {
+      status.AddDetails(base::StringPrintf(
+          "batch stopped at command %zu (%s)", i, name.c_str()));
+      return status;
+    }
+    if (command_value)
+      results->Append(std::move(command_value));
+    else
+      results->Append(std::make_unique<base::Value>());
+  }
+  *value = std::move(results);
+  return Status(kOk);
+}
+
+Status ExecuteResetSession(Session* session,
+                           const base::DictionaryValue& params,
+                           std::unique_ptr<base::Value>* value) {
+  if (!session->chrome)
+    return Status(kInvalidSessionId, "session has no browser to reset");
+
+  // Keep the first tab and close every other window, so the session ends up
+  // with the same shape as a freshly created one.
+  std::string first_view;
+  Status status = session->chrome->GetWebViewIdForFirstTab(
+      &first_view, session->w3c_compliant);
+  if (status.IsError())
+    return status;
+  std::list<std::string> web_view_ids;
+  status = session->chrome->GetWebViewIds(&web_view_ids,
+                                          session->w3c_compliant);
+  if (status.IsError())
+    return status;
+  for (const std::string& web_view_id : web_view_ids) {
+    if (web_view_id == first_view)
+      continue;
+    status = session->chrome->CloseWebView(web_view_id);
+    if (status.IsError())
+      return status;
+  }
+  session->window = first_view;
+  session->SwitchToTopFrame();
+
+  WebView* web_view = nullptr;
+  status = session->GetTargetWindow(&web_view);
+  if (status.IsError())
+    return status;
+  status = web_view->ConnectIfNecessary();
+  if (status.IsError())
+    return status;
+
+  // Drop the overrides before touching browser state; the override managers
+  // re-apply only what the session still records, so a later reconnect will
+  // not resurrect them.
+  base::DictionaryValue no_params;
+  if (session->overridden_geoposition) {
+    session->overridden_geoposition.reset();
+    status = web_view->SendCommand("Emulation.clearGeolocationOverride",
+                                   no_params);
+    if (status.IsError())
+      return status;
+  }
+  if (session->overridden_network_conditions) {
+    // Chrome has no command to stop overriding network conditions, so apply
+    // the "No throttling" preset, as Delete Network Conditions does.
+    NetworkConditions network_conditions;
+    status = FindPresetNetwork("No throttling", &network_conditions);
+    if (status.IsError())
+      return status;
+    status = web_view->OverrideNetworkConditions(network_conditions);
+    if (status.IsError())
+      return status;
+    session->overridden_network_conditions.reset();
+  }
+
+  // Clear browser-wide state: cookies, cache, and all origins' storage.
+  status = web_view->SendCommand("Network.clearBrowserCookies", no_params);
+  if (status.IsError())
+    return status;
+  status = web_view->SendCommand("Network.clearBrowserCache", no_params);
+  if (status.IsError())
+    return status;
+  base::DictionaryValue clear_storage_params;
+  clear_storage_params.SetString("origin", "*");
+  clear_storage_params.SetString("storageTypes", "all");
+  status = web_view->SendCommand("Storage.clearDataForOrigin",
+                                 clear_storage_params);
+  if (status.IsError())
+    return status;
+
+  Timeout timeout(session->page_load_timeout);
+  status = web_view->Load("about:blank", &timeout);
+  if (status.IsError())
+    return status;
+
+  // Restore the per-session state a new session would start with.
+  session->sticky_modifiers = 0;
+  session->mouse_position = WebPoint(0, 0);
+  session->pressed_mouse_button = kNoneMouseButton;
+  session->active_input_sources.ClearList();
+  session->input_state_table.DictClear();
+  session->input_cancel_list.clear();
+  session->prompt_text.reset();
+  session->implicit_wait = Session::kDefaultImplicitWaitTimeout;
+  session->page_load_timeout = Session::kDefaultPageLoadTimeout;
+  session->script_timeout = Session::kDefaultScriptTimeout;
+  session->click_count = 0;
+  return Status(kOk);
+}
@@ -5,11 +5,13 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_SESSION_COMMANDS_H_
 #define CHROME_TEST_CHROMEDRIVER_SESSION_COMMANDS_H_
 
+#include <map>
 #include <memory>
 #include <string>
 
 #include "base/callback_forward.h"
 #include "chrome/test/chromedriver/command.h"
+#include "chrome/test/chromedriver/commands.h"
 #include "chrome/test/chromedriver/net/sync_websocket_factory.h"
 #include "chrome/test/chromedriver/session_connection_map.h"
 #include "services/network/public/mojom/url_loader_factory.mojom.h"
@@ -19,6 +21,7 @@ class DictionaryValue;
 class Value;
 }
 
+class BrowserPool;
 struct Capabilities;
 class DeviceManager;
 struct Session;
@@ -30,7 +33,8 @@ struct InitSessionParams {
       const SyncWebSocketFactory& socket_factory,
       DeviceManager* device_manager,
       const scoped_refptr<base::SingleThreadTaskRunner> cmd_task_runner,
-      SessionConnectionMap* session_map);
+      SessionConnectionMap* session_map,
+      const scoped_refptr<BrowserPool>& browser_pool);
   InitSessionParams(const InitSessionParams& other);
   ~InitSessionParams();
 
@@ -39,10 +43,14 @@ struct InitSessionParams {
   DeviceManager* device_manager;
   scoped_refptr<base::SingleThreadTaskRunner> cmd_task_runner;
   SessionConnectionMap* session_map;
+  // May be null when browser pooling is disabled.
+  scoped_refptr<BrowserPool> browser_pool;
 };
 
 bool GetW3CSetting(const base::DictionaryValue& params);
 
+bool GetLowPrioritySetting(const base::DictionaryValue& params);
+
 bool MergeCapabilities(const base::DictionaryValue* always_match,
                        const base::DictionaryValue* first_match,
                        base::DictionaryValue* merged);
@@ -84,6 +92,21 @@ Status ExecuteGetWindowHandles(Session* session,
                                const base::DictionaryValue& params,
                                std::unique_ptr<base::Value>* value);
 
+// Retrieve handle, title, URL and type for every window in one response,
+// from the browser's target list, without switching windows.
+Status ExecuteGetWindows(Session* session,
+                         const base::DictionaryValue& params,
+                         std::unique_ptr<base::Value>* value);
+
+// Captures every window in one command, issuing the captures concurrently
+// instead of switching to and screenshotting each window in turn. Returns a
+// dictionary mapping window handle to base64-encoded PNG; a window whose
+// capture fails maps to null. |params| are passed through to
+// Page.captureScreenshot.
+Status ExecuteScreenshotAll(Session* session,
+                            const base::DictionaryValue& params,
+                            std::unique_ptr<base::Value>* value);
+
 // Change target window to another. The window to target at may be specified by
 // its server assigned window handle, or by the value of its name attribute.
 Status ExecuteSwitchToWindow(Session* session,
@@ -101,6 +124,75 @@ Status ExecuteGetTimeouts(Session* session,
                           const base::DictionaryValue& params,
                           std::unique_ptr<base::Value>* value);
 
+// Snapshot the transferable parts of the session (capabilities, timeouts,
+// profile cookies, current url, geolocation and network-condition overrides)
+// so a client can recreate it against a fresh browser on another node by
+// passing the snapshot as "chromium:sessionSnapshot" in a New Session
+// request. Window topology beyond the current window and frame state are not
+// exported; migration is intentionally partial-fidelity.
+Status ExecuteExportSession(Session* session,
+                            const base::DictionaryValue& params,
+                            std::unique_ptr<base::Value>* value);
+
+// Refreshes |session|'s crash-recovery snapshot if the recoverOnCrash
+// capability is on and the previous snapshot is old enough. Called between
+// commands; best effort, so a failed export keeps the previous snapshot.
+void MaybeRefreshCrashRecoverySnapshot(Session* session);
+
+// Subscribes the session to push-based log streaming: new entries of the
+// log "types" given in the parameters are drained at command boundaries and
+// pushed over the session's chromium/create_websocket channel as
+// "log.entriesAdded" frames, each carrying a batch sequence number.
+// |send_frame_func| runs on the command thread and writes one serialized
+// frame to the session's WebSocket; without a connected WebSocket, pushed
+// batches are dropped.
+Status ExecuteSubscribeLogs(
+    const base::RepeatingCallback<void(const std::string&,
+                                       const std::string&)>& send_frame_func,
+    const scoped_refptr<base::SingleThreadTaskRunner>& cmd_task_runner,
+    Session* session,
+    const base::DictionaryValue& params,
+    std::unique_ptr<base::Value>* value);
+
+// Ends log streaming; entries go back to buffering for ExecuteGetLog.
+Status ExecuteUnsubscribeLogs(Session* session,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value);
+
+// Acknowledges pushed log batches up to the "seq" parameter. Only a fixed
+// number of batches may be unacknowledged at a time; past that the drain
+// pauses and entries wait in the logs' own bounded buffers.
+Status ExecuteAckLogs(Session* session,
+                      const base::DictionaryValue& params,
+                      std::unique_ptr<base::Value>* value);
+
+// Starts navigating to the "url" parameter and returns immediately with a
+// navigation token, instead of blocking the session thread until the
+// page-load strategy is satisfied like the standard url command. A watcher
+// task interleaved with commands on the session thread tracks the load and,
+// once it completes, times out against the page-load timeout, or fails,
+// pushes a "navigation.completed" frame over the session's
+// chromium/create_websocket channel via |send_frame_func|. The same state
+// can be polled with ExecuteGetNavigationStatus.
+Status ExecuteNavigateAsync(
+    const base::RepeatingCallback<void(const std::string&,
+                                       const std::string&)>& send_frame_func,
+    const scoped_refptr<base::SingleThreadTaskRunner>& cmd_task_runner,
+    Session* session,
+    const base::DictionaryValue& params,
+    std::unique_ptr<base::Value>* value);
+
+// Reports the most recent async navigation's token and status ("pending",
+// "complete", "timeout" or "error"). An optional "token" parameter is
+// validated against the current token.
+Status ExecuteGetNavigationStatus(Session* session,
+                                  const base::DictionaryValue& params,
+                                  std::unique_ptr<base::Value>* value);
+
+// Drains subscribed logs and pushes the non-empty batches; called at
+// command boundaries on the session thread. No-op without a subscription.
+void PushSubscribedLogEntries(Session* session);
+
 // Set the timeout for asynchronous scripts.
 Status ExecuteSetScriptTimeout(Session* session,
                                const base::DictionaryValue& params,
@@ -171,6 +263,38 @@ Status ExecuteSetTimeZone(Session* session,
                           const base::DictionaryValue& params,
                           std::unique_ptr<base::Value>* value);
 
+// Restores the running browser and session to a just-created state: closes
+// extra windows, clears cookies, cache and storage, drops overrides, and
+// resets per-session input and timeout state, all without relaunching
+// Chrome or reconnecting DevTools. A vendor alternative to quit-plus-create
+// when the next test wants identical capabilities.
+Status ExecuteResetSession(Session* session,
+                           const base::DictionaryValue& params,
+                           std::unique_ptr<base::Value>* value);
+
+// A session command callable through the batch endpoint, plus whether it is
+// a W3C standard command (non-standard commands are rejected in W3C mode,
+// matching ExecuteSessionCommand).
+struct BatchableCommand {
+  SessionCommand command;
+  bool w3c_standard_command;
+};
+
+// Maps command names, as registered by HttpHandler::WrapToCommand, to the
+// commands callable from ExecuteBatch.
+typedef std::map<std::string, BatchableCommand> BatchCommandMap;
+
+// Runs an ordered list of session commands in a single session-thread hop.
+// |params| holds "commands", a list of {"name": ..., "parameters": {...}}
+// entries, where "parameters" carries everything the command would normally
+// get from the request body and URL (e.g. an element "id"). Execution stops
+// at the first error, which becomes the response status; on success the
+// response value is the list of individual command result values.
+Status ExecuteBatch(const BatchCommandMap* batch_commands,
+                    Session* session,
+                    const base::DictionaryValue& params,
+                    std::unique_ptr<base::Value>* value);
+
 namespace internal {
 Status ConfigureHeadlessSession(Session* session,
                                 const Capabilities& capabilities);
@@ -181,6 +305,12 @@ Status ConfigureSession(Session* session,
                         base::DictionaryValue* merged_caps,
                         Capabilities* capabilities);
 
+// Restores state captured by ExecuteExportSession into a freshly created
+// session: timeouts, cookies, overrides, then a best-effort navigation to
+// the exported url.
+Status AdoptSessionSnapshot(Session* session,
+                            const base::DictionaryValue& snapshot);
+
 }  // namespace internal
 
 #endif  // CHROME_TEST_CHROMEDRIVER_SESSION_COMMANDS_H_
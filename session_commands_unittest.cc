@@ -4,8 +4,10 @@
 
 #include "chrome/test/chromedriver/session_commands.h"
 
+#include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/callback.h"
@@ -14,9 +16,13 @@
 #include "base/json/json_reader.h"
 #include "base/run_loop.h"
 #include "base/system/sys_info.h"
+#include "base/test/task_environment.h"
 #include "base/threading/thread.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/capabilities.h"
+#include "chrome/test/chromedriver/chrome/devtools_client_impl.h"
+#include "chrome/test/chromedriver/chrome/devtools_http_client.h"
 #include "chrome/test/chromedriver/chrome/status.h"
 #include "chrome/test/chromedriver/chrome/stub_chrome.h"
 #include "chrome/test/chromedriver/chrome/stub_web_view.h"
@@ -347,6 +353,25 @@ TEST(SessionCommandsTest, FileUpload) {
   ASSERT_STREQ("COW\n", data.c_str());
 }
 
+TEST(SessionCommandsTest, FileUploadCachedForIdenticalPayload) {
+  Session session("id");
+  base::DictionaryValue params;
+  // Same archive as in FileUpload above.
+  const char kBase64ZipEntry[] =
+      "UEsDBBQAAAAAAMROi0K/wAzGBAAAAAQAAAADAAAAbW9vQ09XClBLAQIUAxQAAAAAAMROi0K/"
+      "wAzG\nBAAAAAQAAAADAAAAAAAAAAAAAACggQAAAABtb29QSwUGAAAAAAEAAQAxAAAAJQAAAA"
+      "AA\n";
+  params.SetString("file", kBase64ZipEntry);
+  std::unique_ptr<base::Value> first;
+  ASSERT_EQ(kOk, ExecuteUploadFile(&session, params, &first).code());
+  std::unique_ptr<base::Value> second;
+  ASSERT_EQ(kOk, ExecuteUploadFile(&session, params, &second).code());
+  // The repeated upload resolves to the already extracted file.
+  ASSERT_EQ(first->GetString(), second->GetString());
+  ASSERT_TRUE(
+      base::PathExists(base::FilePath::FromUTF8Unsafe(first->GetString())));
+}
+
 namespace {
 
 class DetachChrome : public StubChrome {
@@ -363,8 +388,51 @@ class DetachChrome : public StubChrome {
   bool quit_called_;
 };
 
+class WindowSummaryChrome : public StubChrome {
+ public:
+  WindowSummaryChrome() = default;
+  ~WindowSummaryChrome() override = default;
+
+  // Overridden from Chrome:
+  Status GetWebViewsSummary(std::vector<WebViewInfo>* views,
+                            bool w3c_compliant) override {
+    views->clear();
+    WebViewInfo tab("id1", "", "http://example.com/", WebViewInfo::kPage);
+    tab.title = "Example";
+    views->push_back(tab);
+    views->push_back(
+        WebViewInfo("id2", "", "http://other.test/", WebViewInfo::kPage));
+    return Status(kOk);
+  }
+};
+
 }  // namespace
 
+TEST(SessionCommandsTest, GetWindows) {
+  Session session("id", std::unique_ptr<Chrome>(new WindowSummaryChrome()));
+  base::DictionaryValue params;
+  std::unique_ptr<base::Value> value;
+  ASSERT_EQ(kOk, ExecuteGetWindows(&session, params, &value).code());
+
+  base::ListValue* windows;
+  ASSERT_TRUE(value->GetAsList(&windows));
+  ASSERT_EQ(2u, windows->GetSize());
+  base::DictionaryValue* window;
+  ASSERT_TRUE(windows->GetDictionary(0, &window));
+  std::string handle, title, url, type;
+  ASSERT_TRUE(window->GetString("handle", &handle));
+  ASSERT_TRUE(window->GetString("title", &title));
+  ASSERT_TRUE(window->GetString("url", &url));
+  ASSERT_TRUE(window->GetString("type", &type));
+  ASSERT_EQ("CDwindow-id1", handle);
+  ASSERT_EQ("Example", title);
+  ASSERT_EQ("http://example.com/", url);
+  ASSERT_EQ("page", type);
+  ASSERT_TRUE(windows->GetDictionary(1, &window));
+  ASSERT_TRUE(window->GetString("title", &title));
+  ASSERT_EQ("", title);
+}
+
 TEST(SessionCommandsTest, MatchCapabilities) {
   base::DictionaryValue merged;
   merged.SetString("browserName", "not chrome");
@@ -685,3 +753,448 @@ TEST(SessionCommandsTest, ConfigureSession_legacyDefault) {
   // legacy values:
   ASSERT_EQ(kIgnore, session.unhandled_prompt_behavior);
 }
+
+namespace {
+
+Status RecordBatchCommand(std::vector<std::string>* names,
+                          const std::string& name,
+                          const Status& result,
+                          Session* session,
+                          const base::DictionaryValue& params,
+                          std::unique_ptr<base::Value>* value) {
+  names->push_back(name);
+  std::string arg;
+  if (params.GetString("arg", &arg))
+    *value = std::make_unique<base::Value>(arg);
+  return result;
+}
+
+}  // namespace
+
+TEST(SessionCommandsTest, ExecuteBatchRunsCommandsInOrder) {
+  Session session("id");
+  std::vector<std::string> names;
+  BatchCommandMap batch_commands;
+  batch_commands["First"] = {
+      base::BindRepeating(&RecordBatchCommand, &names, "First", Status(kOk)),
+      true};
+  batch_commands["Second"] = {
+      base::BindRepeating(&RecordBatchCommand, &names, "Second", Status(kOk)),
+      true};
+
+  base::DictionaryValue params;
+  base::Value::ListStorage commands;
+  base::Value first(base::Value::Type::DICTIONARY);
+  first.SetStringKey("name", "Second");
+  base::Value first_params(base::Value::Type::DICTIONARY);
+  first_params.SetStringKey("arg", "two");
+  first.SetKey("parameters", std::move(first_params));
+  commands.push_back(std::move(first));
+  base::Value second(base::Value::Type::DICTIONARY);
+  second.SetStringKey("name", "First");
+  commands.push_back(std::move(second));
+  params.SetKey("commands", base::Value(std::move(commands)));
+
+  std::unique_ptr<base::Value> value;
+  Status status = ExecuteBatch(&batch_commands, &session, params, &value);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  ASSERT_EQ(2u, names.size());
+  ASSERT_EQ("Second", names[0]);
+  ASSERT_EQ("First", names[1]);
+  ASSERT_TRUE(value->is_list());
+  ASSERT_EQ(2u, value->GetList().size());
+  ASSERT_EQ("two", value->GetList()[0].GetString());
+  ASSERT_TRUE(value->GetList()[1].is_none());
+}
+
+TEST(SessionCommandsTest, ExecuteBatchShortCircuitsOnError) {
+  Session session("id");
+  std::vector<std::string> names;
+  BatchCommandMap batch_commands;
+  batch_commands["Fails"] = {
+      base::BindRepeating(&RecordBatchCommand, &names, "Fails",
+                          Status(kNoSuchElement)),
+      true};
+  batch_commands["Never"] = {
+      base::BindRepeating(&RecordBatchCommand, &names, "Never", Status(kOk)),
+      true};
+
+  base::DictionaryValue params;
+  base::Value::ListStorage commands;
+  base::Value fails(base::Value::Type::DICTIONARY);
+  fails.SetStringKey("name", "Fails");
+  commands.push_back(std::move(fails));
+  base::Value never(base::Value::Type::DICTIONARY);
+  never.SetStringKey("name", "Never");
+  commands.push_back(std::move(never));
+  params.SetKey("commands", base::Value(std::move(commands)));
+
+  std::unique_ptr<base::Value> value;
+  Status status = ExecuteBatch(&batch_commands, &session, params, &value);
+  ASSERT_EQ(kNoSuchElement, status.code());
+  ASSERT_EQ(1u, names.size());
+}
+
+TEST(SessionCommandsTest, ExecuteBatchRejectsUnknownCommand) {
+  Session session("id");
+  BatchCommandMap batch_commands;
+
+  base::DictionaryValue params;
+  base::Value::ListStorage commands;
+  base::Value entry(base::Value::Type::DICTIONARY);
+  entry.SetStringKey("name", "NoSuchCommand");
+  commands.push_back(std::move(entry));
+  params.SetKey("commands", base::Value(std::move(commands)));
+
+  std::unique_ptr<base::Value> value;
+  Status status = ExecuteBatch(&batch_commands, &session, params, &value);
+  ASSERT_EQ(kInvalidArgument, status.code());
+}
+
+namespace {
+
+class ResettableChrome : public StubChrome {
+ public:
+  ResettableChrome() : web_view_("first") {}
+  ~ResettableChrome() override = default;
+
+  // Overridden from Chrome:
+  Status GetWebViewIdForFirstTab(std::string* web_view_id,
+                                 bool w3c_compliant) override {
+    *web_view_id = "first";
+    return Status(kOk);
+  }
+  Status GetWebViewIds(std::list<std::string>* web_view_ids,
+                       bool w3c_compliant) override {
+    *web_view_ids = {"first", "second", "third"};
+    return Status(kOk);
+  }
+  Status GetWebViewById(const std::string& id, WebView** web_view) override {
+    if (id != "first")
+      return Status(kNoSuchWindow);
+    *web_view = &web_view_;
+    return Status(kOk);
+  }
+  Status CloseWebView(const std::string& id) override {
+    closed_web_views_.push_back(id);
+    return Status(kOk);
+  }
+
+  std::vector<std::string> closed_web_views_;
+
+ private:
+  StubWebView web_view_;
+};
+
+}  // namespace
+
+TEST(SessionCommandsTest, ResetSession) {
+  ResettableChrome* chrome = new ResettableChrome();
+  Session session("id", std::unique_ptr<Chrome>(chrome));
+  session.window = "third";
+  session.sticky_modifiers = 2;
+  session.implicit_wait = base::TimeDelta::FromSeconds(7);
+  session.prompt_text = std::make_unique<std::string>("prompt");
+
+  base::DictionaryValue params;
+  std::unique_ptr<base::Value> value;
+  Status status = ExecuteResetSession(&session, params, &value);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+
+  ASSERT_EQ(2u, chrome->closed_web_views_.size());
+  ASSERT_EQ("second", chrome->closed_web_views_[0]);
+  ASSERT_EQ("third", chrome->closed_web_views_[1]);
+  ASSERT_EQ("first", session.window);
+  ASSERT_TRUE(session.frames.empty());
+  ASSERT_EQ(0, session.sticky_modifiers);
+  ASSERT_EQ(Session::kDefaultImplicitWaitTimeout, session.implicit_wait);
+  ASSERT_FALSE(session.prompt_text);
+}
+
+TEST(SessionCommandsTest, ResetSessionWithoutBrowser) {
+  Session session("id");
+  base::DictionaryValue params;
+  std::unique_ptr<base::Value> value;
+  ASSERT_EQ(kInvalidSessionId,
+            ExecuteResetSession(&session, params, &value).code());
+}
+
+TEST(SessionCommandsTest, ExportSessionSnapshotsState) {
+  BrowserInfo binfo;
+  MockChrome* chrome = new MockChrome(binfo);
+  Session session("id", std::unique_ptr<Chrome>(chrome));
+  session.window = "1";
+  session.capabilities = base::MakeRefCounted<SessionCapabilities>(
+      std::make_unique<base::DictionaryValue>());
+  session.script_timeout = base::TimeDelta::FromMilliseconds(1111);
+  session.page_load_timeout = base::TimeDelta::FromMilliseconds(2222);
+  session.implicit_wait = base::TimeDelta::FromMilliseconds(3333);
+
+  base::DictionaryValue params;
+  std::unique_ptr<base::Value> value;
+  Status status = ExecuteExportSession(&session, params, &value);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+
+  base::DictionaryValue* snapshot;
+  ASSERT_TRUE(value->GetAsDictionary(&snapshot));
+  int version = 0;
+  ASSERT_TRUE(snapshot->GetInteger("snapshotVersion", &version));
+  ASSERT_EQ(1, version);
+  ASSERT_TRUE(snapshot->HasKey("capabilities"));
+  int timeout_ms = 0;
+  ASSERT_TRUE(snapshot->GetInteger("timeouts.script", &timeout_ms));
+  ASSERT_EQ(1111, timeout_ms);
+  ASSERT_TRUE(snapshot->GetInteger("timeouts.pageLoad", &timeout_ms));
+  ASSERT_EQ(2222, timeout_ms);
+  ASSERT_TRUE(snapshot->GetInteger("timeouts.implicit", &timeout_ms));
+  ASSERT_EQ(3333, timeout_ms);
+}
+
+TEST(SessionCommandsTest, AdoptSessionSnapshotRestoresTimeouts) {
+  BrowserInfo binfo;
+  MockChrome* chrome = new MockChrome(binfo);
+  Session session("id", std::unique_ptr<Chrome>(chrome));
+  session.window = "1";
+
+  base::DictionaryValue snapshot;
+  snapshot.SetInteger("snapshotVersion", 1);
+  snapshot.SetInteger("timeouts.script", 4444);
+  snapshot.SetInteger("timeouts.pageLoad", 5555);
+  snapshot.SetInteger("timeouts.implicit", 6666);
+
+  Status status = internal::AdoptSessionSnapshot(&session, snapshot);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  ASSERT_EQ(4444, session.script_timeout.InMilliseconds());
+  ASSERT_EQ(5555, session.page_load_timeout.InMilliseconds());
+  ASSERT_EQ(6666, session.implicit_wait.InMilliseconds());
+}
+
+TEST(SessionCommandsTest, AdoptSessionSnapshotRejectsUnknownVersion) {
+  Session session("id");
+  base::DictionaryValue snapshot;
+  snapshot.SetInteger("snapshotVersion", 2);
+  ASSERT_EQ(kInvalidArgument,
+            internal::AdoptSessionSnapshot(&session, snapshot).code());
+}
+
+namespace {
+
+void RecordLogFrame(std::vector<std::string>* frames,
+                    const std::string& session_id,
+                    const std::string& frame) {
+  frames->push_back(session_id + "|" + frame);
+}
+
+}  // namespace
+
+TEST(SessionCommandsTest, SubscribeLogsRejectsUnknownType) {
+  base::test::SingleThreadTaskEnvironment task_environment;
+  Session session("id");
+  session.driver_log =
+      std::make_unique<WebDriverLog>(WebDriverLog::kDriverType, Log::kAll);
+  base::DictionaryValue params;
+  auto types = std::make_unique<base::ListValue>();
+  types->AppendString("bogus");
+  params.Set("types", std::move(types));
+  std::vector<std::string> frames;
+  std::unique_ptr<base::Value> value;
+  ASSERT_EQ(kInvalidArgument,
+            ExecuteSubscribeLogs(base::BindRepeating(&RecordLogFrame, &frames),
+                                 base::ThreadTaskRunnerHandle::Get(), &session,
+                                 params, &value)
+                .code());
+  ASSERT_TRUE(session.log_subscriptions.empty());
+}
+
+TEST(SessionCommandsTest, PushSubscribedLogEntriesStreamsAndAcks) {
+  base::test::SingleThreadTaskEnvironment task_environment;
+  Session session("id");
+  session.driver_log =
+      std::make_unique<WebDriverLog>(WebDriverLog::kDriverType, Log::kAll);
+  base::DictionaryValue params;
+  auto types = std::make_unique<base::ListValue>();
+  types->AppendString(WebDriverLog::kDriverType);
+  params.Set("types", std::move(types));
+  std::vector<std::string> frames;
+  std::unique_ptr<base::Value> value;
+  ASSERT_EQ(kOk,
+            ExecuteSubscribeLogs(base::BindRepeating(&RecordLogFrame, &frames),
+                                 base::ThreadTaskRunnerHandle::Get(), &session,
+                                 params, &value)
+                .code());
+
+  session.driver_log->AddEntryTimestamped(base::Time::Now(), Log::kInfo,
+                                          "driver", "hello");
+  PushSubscribedLogEntries(&session);
+  base::RunLoop().RunUntilIdle();
+  ASSERT_EQ(1u, frames.size());
+  ASSERT_NE(std::string::npos, frames[0].find("log.entriesAdded"));
+  ASSERT_NE(std::string::npos, frames[0].find("hello"));
+  ASSERT_EQ(1, session.log_batch_seq);
+
+  // No new entries, no new frame.
+  PushSubscribedLogEntries(&session);
+  base::RunLoop().RunUntilIdle();
+  ASSERT_EQ(1u, frames.size());
+
+  // A full unacknowledged window pauses the stream until the client acks.
+  session.log_batch_seq = session.log_batch_acked + 16;
+  session.driver_log->AddEntryTimestamped(base::Time::Now(), Log::kInfo,
+                                          "driver", "later");
+  PushSubscribedLogEntries(&session);
+  base::RunLoop().RunUntilIdle();
+  ASSERT_EQ(1u, frames.size());
+
+  base::DictionaryValue ack_params;
+  ack_params.SetInteger("seq", session.log_batch_seq);
+  ASSERT_EQ(kOk, ExecuteAckLogs(&session, ack_params, &value).code());
+  PushSubscribedLogEntries(&session);
+  base::RunLoop().RunUntilIdle();
+  ASSERT_EQ(2u, frames.size());
+  ASSERT_NE(std::string::npos, frames[1].find("later"));
+
+  // Unsubscribing stops the drain.
+  ASSERT_EQ(kOk, ExecuteUnsubscribeLogs(&session, params, &value).code());
+  session.driver_log->AddEntryTimestamped(base::Time::Now(), Log::kInfo,
+                                          "driver", "unseen");
+  PushSubscribedLogEntries(&session);
+  base::RunLoop().RunUntilIdle();
+  ASSERT_EQ(2u, frames.size());
+}
+
+TEST(SessionCommandsTest, NavigationStatusPollsCurrentToken) {
+  Session session("id");
+  base::DictionaryValue params;
+  std::unique_ptr<base::Value> value;
+  ASSERT_EQ(kInvalidArgument,
+            ExecuteGetNavigationStatus(&session, params, &value).code());
+
+  session.async_navigation_token = 3;
+  session.async_navigation_status = "pending";
+  ASSERT_EQ(kOk, ExecuteGetNavigationStatus(&session, params, &value).code());
+  base::DictionaryValue* dict = nullptr;
+  ASSERT_TRUE(value->GetAsDictionary(&dict));
+  ASSERT_EQ(3, *dict->FindIntKey("token"));
+  ASSERT_EQ("pending", *dict->FindStringKey("status"));
+
+  // Only the most recent token can be polled.
+  params.SetInteger("token", 2);
+  ASSERT_EQ(kInvalidArgument,
+            ExecuteGetNavigationStatus(&session, params, &value).code());
+
+  session.async_navigation_status = "error";
+  session.async_navigation_error = "target window already closed";
+  params.SetInteger("token", 3);
+  ASSERT_EQ(kOk, ExecuteGetNavigationStatus(&session, params, &value).code());
+  ASSERT_TRUE(value->GetAsDictionary(&dict));
+  ASSERT_EQ("error", *dict->FindStringKey("status"));
+  ASSERT_EQ("target window already closed", *dict->FindStringKey("message"));
+}
+
+TEST(SessionCommandsTest, CrashSnapshotRefreshRequiresCapability) {
+  BrowserInfo binfo;
+  MockChrome* chrome = new MockChrome(binfo);
+  Session session("id", std::unique_ptr<Chrome>(chrome));
+  session.window = "1";
+
+  MaybeRefreshCrashRecoverySnapshot(&session);
+  ASSERT_FALSE(session.crash_recovery_snapshot);
+}
+
+TEST(SessionCommandsTest, CrashSnapshotRefreshCapturesAndThrottles) {
+  BrowserInfo binfo;
+  MockChrome* chrome = new MockChrome(binfo);
+  Session session("id", std::unique_ptr<Chrome>(chrome));
+  session.window = "1";
+  session.recover_on_crash = true;
+  session.capabilities = base::MakeRefCounted<SessionCapabilities>(
+      std::make_unique<base::DictionaryValue>());
+  session.script_timeout = base::TimeDelta::FromMilliseconds(1111);
+
+  MaybeRefreshCrashRecoverySnapshot(&session);
+  ASSERT_TRUE(session.crash_recovery_snapshot);
+  int timeout_ms = 0;
+  ASSERT_TRUE(session.crash_recovery_snapshot->GetInteger("timeouts.script",
+                                                          &timeout_ms));
+  ASSERT_EQ(1111, timeout_ms);
+
+  // A second refresh inside the interval must not re-export.
+  session.script_timeout = base::TimeDelta::FromMilliseconds(2222);
+  MaybeRefreshCrashRecoverySnapshot(&session);
+  ASSERT_TRUE(session.crash_recovery_snapshot->GetInteger("timeouts.script",
+                                                          &timeout_ms));
+  ASSERT_EQ(1111, timeout_ms);
+
+  // Aging the stamp past the interval lets the next boundary refresh it.
+  session.crash_snapshot_time =
+      base::TimeTicks::Now() - base::TimeDelta::FromMinutes(1);
+  MaybeRefreshCrashRecoverySnapshot(&session);
+  ASSERT_TRUE(session.crash_recovery_snapshot->GetInteger("timeouts.script",
+                                                          &timeout_ms));
+  ASSERT_EQ(2222, timeout_ms);
+}
+
+namespace {
+
+// A web view whose concurrent-capture hook reports a recognizable image
+// synchronously, exercising the no-future fallback of ExecuteScreenshotAll.
+class ScreenshotWebView : public StubWebView {
+ public:
+  explicit ScreenshotWebView(const std::string& id) : StubWebView(id) {}
+  ~ScreenshotWebView() override {}
+
+  Status CaptureScreenshotAndGetFuture(
+      const base::DictionaryValue& params,
+      std::string* screenshot,
+      std::unique_ptr<DevToolsCommandFuture>* future) override {
+    future->reset();
+    *screenshot = "png-" + GetId();
+    return Status(kOk);
+  }
+};
+
+class ScreenshotChrome : public StubChrome {
+ public:
+  ScreenshotChrome() : view1_("1"), view2_("2") {}
+  ~ScreenshotChrome() override {}
+
+  Status GetWebViewIds(std::list<std::string>* web_view_ids,
+                       bool w3c_compliant) override {
+    web_view_ids->push_back("1");
+    web_view_ids->push_back("2");
+    return Status(kOk);
+  }
+
+  Status GetWebViewById(const std::string& id, WebView** web_view) override {
+    if (id == "1") {
+      *web_view = &view1_;
+      return Status(kOk);
+    }
+    if (id == "2") {
+      *web_view = &view2_;
+      return Status(kOk);
+    }
+    return Status(kNoSuchWindow);
+  }
+
+ private:
+  ScreenshotWebView view1_;
+  ScreenshotWebView view2_;
+};
+
+}  // namespace
+
+TEST(SessionCommandsTest, ScreenshotAllReturnsHandleKeyedImages) {
+  Session session("id", std::unique_ptr<Chrome>(new ScreenshotChrome()));
+  base::DictionaryValue params;
+  std::unique_ptr<base::Value> value;
+  Status status = ExecuteScreenshotAll(&session, params, &value);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  base::DictionaryValue* images;
+  ASSERT_TRUE(value->GetAsDictionary(&images));
+  std::string data;
+  ASSERT_TRUE(images->GetString("CDwindow-1", &data));
+  ASSERT_EQ("png-1", data);
+  ASSERT_TRUE(images->GetString("CDwindow-2", &data));
+  ASSERT_EQ("png-2", data);
+}
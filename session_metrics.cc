@@ -0,0 +1,175 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/session_metrics.h"
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/threading/thread.h"
+#include "base/values.h"
+
+namespace {
+
+base::LazyInstance<SessionMetrics>::Leaky g_session_metrics =
+    LAZY_INSTANCE_INITIALIZER;
+
+// A command running longer than this is considered stalled and gets an
+// attribution sample. Normal commands finish in milliseconds; navigation
+// waits are the slowest common case and are bounded by page load timeouts.
+const int kStallThresholdSeconds = 10;
+
+// How often the watchdog rescans the registry.
+const int kWatchdogPollSeconds = 1;
+
+// Samples kept; beyond this the oldest is dropped.
+const size_t kMaxStallSamples = 32;
+
+}  // namespace
+
+SessionMemoryStats::SessionMemoryStats() {}
+
+SessionMemoryStats::~SessionMemoryStats() {}
+
+// static
+SessionMetrics* SessionMetrics::GetInstance() {
+  return g_session_metrics.Pointer();
+}
+
+SessionMetrics::SessionMetrics() {}
+
+SessionMetrics::~SessionMetrics() {}
+
+scoped_refptr<SessionMemoryStats> SessionMetrics::Register(
+    const std::string& session_id) {
+  base::AutoLock lock(lock_);
+  scoped_refptr<SessionMemoryStats>& stats = stats_[session_id];
+  if (!stats)
+    stats = base::MakeRefCounted<SessionMemoryStats>();
+  return stats;
+}
+
+scoped_refptr<SessionMemoryStats> SessionMetrics::Lookup(
+    const std::string& session_id) {
+  base::AutoLock lock(lock_);
+  auto it = stats_.find(session_id);
+  if (it == stats_.end())
+    return nullptr;
+  return it->second;
+}
+
+void SessionMetrics::Unregister(const std::string& session_id) {
+  base::AutoLock lock(lock_);
+  stats_.erase(session_id);
+}
+
+std::unique_ptr<base::DictionaryValue> SessionMetrics::ToValue() const {
+  auto result = std::make_unique<base::DictionaryValue>();
+  base::AutoLock lock(lock_);
+  for (const auto& entry : stats_) {
+    auto session = std::make_unique<base::DictionaryValue>();
+    session->SetDoubleKey("logBytes",
+                          static_cast<double>(entry.second->log_bytes.load(
+                              std::memory_order_relaxed)));
+    session->SetIntKey("commandBacklog",
+                       static_cast<int>(entry.second->command_backlog.load(
+                           std::memory_order_relaxed)));
+    session->SetIntKey("commandsRejected",
+                       static_cast<int>(entry.second->commands_rejected.load(
+                           std::memory_order_relaxed)));
+    session->SetBoolKey("lowPriority", entry.second->low_priority.load(
+                                           std::memory_order_relaxed));
+    result->SetKey(entry.first, base::Value::FromUniquePtrValue(
+                                    std::move(session)));
+  }
+  return result;
+}
+
+void SessionMetrics::StartWatchdog() {
+  base::AutoLock lock(lock_);
+  if (watchdog_thread_)
+    return;
+  watchdog_thread_ = std::make_unique<base::Thread>("stall watchdog");
+  base::Thread::Options options;
+  options.priority = base::ThreadPriority::BACKGROUND;
+  watchdog_thread_->StartWithOptions(std::move(options));
+  // base::Unretained is safe: the registry is a leaky singleton.
+  watchdog_thread_->task_runner()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&SessionMetrics::PollOnWatchdogThread,
+                     base::Unretained(this)),
+      base::TimeDelta::FromSeconds(kWatchdogPollSeconds));
+}
+
+std::unique_ptr<base::ListValue> SessionMetrics::StallSamplesToValue() const {
+  auto result = std::make_unique<base::ListValue>();
+  base::AutoLock lock(lock_);
+  for (const StallSample& sample : stall_samples_) {
+    auto entry = std::make_unique<base::DictionaryValue>();
+    entry->SetString("sessionId", sample.session_id);
+    entry->SetString("command", sample.command);
+    entry->SetString("waitSite", sample.wait_site);
+    entry->SetDoubleKey("elapsedMs", sample.elapsed.InMillisecondsF());
+    result->Append(std::move(entry));
+  }
+  return result;
+}
+
+void SessionMetrics::SampleStallsForTesting(base::TimeTicks now) {
+  SampleStalls(now);
+}
+
+void SessionMetrics::PollOnWatchdogThread() {
+  SampleStalls(base::TimeTicks::Now());
+  // |watchdog_thread_| is set once before the first poll is queued, so
+  // reading it here without |lock_| is fine.
+  watchdog_thread_->task_runner()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&SessionMetrics::PollOnWatchdogThread,
+                     base::Unretained(this)),
+      base::TimeDelta::FromSeconds(kWatchdogPollSeconds));
+}
+
+void SessionMetrics::SampleStalls(base::TimeTicks now) {
+  base::AutoLock lock(lock_);
+  for (const auto& entry : stats_) {
+    const SessionMemoryStats& stats = *entry.second;
+    int64_t start_us =
+        stats.command_start_us.load(std::memory_order_acquire);
+    if (start_us == 0)
+      continue;  // Idle.
+    base::TimeTicks start =
+        base::TimeTicks() + base::TimeDelta::FromMicroseconds(start_us);
+    base::TimeDelta elapsed = now - start;
+    if (elapsed < base::TimeDelta::FromSeconds(kStallThresholdSeconds))
+      continue;
+    const char* command = stats.command_name.load(std::memory_order_relaxed);
+    const char* wait_site = stats.wait_site.load(std::memory_order_relaxed);
+    // A stall already sampled keeps its ring entry and just grows older;
+    // search newest-first since a continuing stall is usually recent.
+    bool updated = false;
+    for (auto it = stall_samples_.rbegin(); it != stall_samples_.rend();
+         ++it) {
+      if (it->command_start_us == start_us &&
+          it->session_id == entry.first) {
+        it->elapsed = elapsed;
+        if (wait_site)
+          it->wait_site = wait_site;
+        updated = true;
+        break;
+      }
+    }
+    if (updated)
+      continue;
+    StallSample sample;
+    sample.session_id = entry.first;
+    sample.command = command ? command : "";
+    sample.wait_site = wait_site ? wait_site : "";
+    sample.command_start_us = start_us;
+    sample.elapsed = elapsed;
+    stall_samples_.push_back(std::move(sample));
+    if (stall_samples_.size() > kMaxStallSamples)
+      stall_samples_.pop_front();
+  }
+}
@@ -0,0 +1,138 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_TEST_CHROMEDRIVER_SESSION_METRICS_H_
+#define CHROME_TEST_CHROMEDRIVER_SESSION_METRICS_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/lazy_instance.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+
+namespace base {
+class DictionaryValue;
+class ListValue;
+class Thread;
+}
+
+// Gauges of memory and work the driver holds on one session's behalf.
+// Owners update the fields with relaxed atomic operations as bytes enter
+// and leave their buffers; the /status endpoint reads them, so attributing
+// node memory growth to a session is a dashboard read rather than a heap
+// dump. Ref-counted because owners (logs, session threads) can outlive the
+// registry entry during teardown.
+struct SessionMemoryStats
+    : public base::RefCountedThreadSafe<SessionMemoryStats> {
+  SessionMemoryStats();
+
+  // Approximate bytes of log entries buffered in the session's
+  // WebDriverLogs, awaiting retrieval over the /log command.
+  std::atomic<int64_t> log_bytes{0};
+
+  // Commands dispatched to the session thread whose response has not been
+  // produced yet; values above 1 mean the session thread has a backlog.
+  std::atomic<int64_t> command_backlog{0};
+
+  // Commands rejected by admission control because |command_backlog| had
+  // already reached the per-session limit; see ExecuteSessionCommand. A
+  // growing value identifies a client flooding the session faster than its
+  // thread can drain.
+  std::atomic<int64_t> commands_rejected{0};
+
+  // Whether the session declared itself bulk traffic via the "priority"
+  // chrome option. Set once at session creation and read by the IO threads'
+  // response-write queues, which write interactive sessions' responses
+  // first; this registry is the only session state they may touch.
+  std::atomic<bool> low_priority{false};
+
+  // What the session thread is doing right now, published at command entry
+  // and cleared at command exit so the stall watchdog can attribute a
+  // wedged session without attaching a debugger. |command_name| and
+  // |wait_site| hold string literals (the command map and wait annotations
+  // outlive every session); |command_start_us| is the command's start in
+  // base::TimeTicks microseconds, 0 while the thread is idle.
+  std::atomic<const char*> command_name{nullptr};
+  std::atomic<int64_t> command_start_us{0};
+  std::atomic<const char*> wait_site{nullptr};
+
+ private:
+  friend class base::RefCountedThreadSafe<SessionMemoryStats>;
+  ~SessionMemoryStats();
+};
+
+// Process-wide registry of per-session gauges, keyed by session id and
+// reported by the /status endpoint.
+class SessionMetrics {
+ public:
+  static SessionMetrics* GetInstance();
+
+  SessionMetrics(const SessionMetrics&) = delete;
+  SessionMetrics& operator=(const SessionMetrics&) = delete;
+
+  // Returns the stats block for |session_id|, creating it on first use.
+  scoped_refptr<SessionMemoryStats> Register(const std::string& session_id);
+
+  // Returns the stats block for |session_id|, or null if none exists.
+  scoped_refptr<SessionMemoryStats> Lookup(const std::string& session_id);
+
+  // Drops |session_id| from the registry; outstanding references keep the
+  // block itself alive.
+  void Unregister(const std::string& session_id);
+
+  // Returns a dictionary mapping each registered session id to its gauges.
+  std::unique_ptr<base::DictionaryValue> ToValue() const;
+
+  // Starts the background watchdog that periodically scans the registry
+  // for session threads stuck in one command past the latency SLO and
+  // records attribution samples; called once at server startup. Safe to
+  // call again (subsequent calls are no-ops).
+  void StartWatchdog();
+
+  // Returns the recorded stall samples, oldest first, each with the
+  // session id, command name, innermost wait site and elapsed time.
+  std::unique_ptr<base::ListValue> StallSamplesToValue() const;
+
+  // Runs one watchdog scan as if the current time were |now|, without
+  // needing the watchdog thread.
+  void SampleStallsForTesting(base::TimeTicks now);
+
+ private:
+  friend struct base::LazyInstanceTraitsBase<SessionMetrics>;
+
+  // One observation of a session thread over the stall SLO. A continuing
+  // stall updates its sample's |elapsed| in place rather than appending,
+  // keyed by |command_start_us|, so one wedged command is one ring entry.
+  struct StallSample {
+    std::string session_id;
+    std::string command;
+    std::string wait_site;
+    int64_t command_start_us;
+    base::TimeDelta elapsed;
+  };
+
+  SessionMetrics();
+  ~SessionMetrics();
+
+  // Scans the registry for commands running longer than the SLO and
+  // updates |stall_samples_|; runs on the watchdog thread (or a test).
+  void SampleStalls(base::TimeTicks now);
+  void PollOnWatchdogThread();
+
+  mutable base::Lock lock_;
+  std::map<std::string, scoped_refptr<SessionMemoryStats>> stats_;
+  // Bounded diagnostics ring, oldest first; guarded by |lock_|.
+  std::deque<StallSample> stall_samples_;
+  // Set once by StartWatchdog and never torn down (the registry is leaky).
+  std::unique_ptr<base::Thread> watchdog_thread_;
+};
+
+#endif  // CHROME_TEST_CHROMEDRIVER_SESSION_METRICS_H_
@@ -0,0 +1,110 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/session_metrics.h"
+
+#include <atomic>
+
+#include "base/time/time.h"
+#include "base/values.h"
+#include "chrome/test/chromedriver/net/wait_site.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+TEST(SessionMetricsTest, RegisterIsStable) {
+  SessionMetrics* metrics = SessionMetrics::GetInstance();
+  scoped_refptr<SessionMemoryStats> stats = metrics->Register("stable-id");
+  EXPECT_EQ(stats.get(), metrics->Register("stable-id").get());
+  EXPECT_EQ(stats.get(), metrics->Lookup("stable-id").get());
+  metrics->Unregister("stable-id");
+}
+
+TEST(SessionMetricsTest, LookupMissingReturnsNull) {
+  EXPECT_FALSE(SessionMetrics::GetInstance()->Lookup("no-such-session"));
+}
+
+TEST(SessionMetricsTest, UnregisteredReferencesStayValid) {
+  SessionMetrics* metrics = SessionMetrics::GetInstance();
+  scoped_refptr<SessionMemoryStats> stats = metrics->Register("short-lived");
+  metrics->Unregister("short-lived");
+  EXPECT_FALSE(metrics->Lookup("short-lived"));
+  // The block outlives its registry entry; late updates must not crash.
+  stats->log_bytes.fetch_add(10, std::memory_order_relaxed);
+  EXPECT_EQ(10, stats->log_bytes.load(std::memory_order_relaxed));
+}
+
+TEST(SessionMetricsTest, ToValueReportsGauges) {
+  SessionMetrics* metrics = SessionMetrics::GetInstance();
+  scoped_refptr<SessionMemoryStats> stats = metrics->Register("reported");
+  stats->log_bytes.store(1234, std::memory_order_relaxed);
+  stats->command_backlog.store(2, std::memory_order_relaxed);
+
+  std::unique_ptr<base::DictionaryValue> value = metrics->ToValue();
+  base::Value* session = value->FindDictKey("reported");
+  ASSERT_TRUE(session);
+  EXPECT_EQ(1234, session->FindDoubleKey("logBytes").value_or(-1));
+  EXPECT_EQ(2, session->FindIntKey("commandBacklog").value_or(-1));
+  metrics->Unregister("reported");
+}
+
+TEST(SessionMetricsTest, WatchdogSamplesStalledCommand) {
+  SessionMetrics* metrics = SessionMetrics::GetInstance();
+  size_t baseline = metrics->StallSamplesToValue()->GetList().size();
+
+  scoped_refptr<SessionMemoryStats> stats = metrics->Register("stalled");
+  base::TimeTicks start =
+      base::TimeTicks() + base::TimeDelta::FromSeconds(100);
+  stats->command_name.store("FindElement", std::memory_order_relaxed);
+  stats->wait_site.store("SyncWebSocket::ReceiveNextMessage",
+                         std::memory_order_relaxed);
+  stats->command_start_us.store((start - base::TimeTicks()).InMicroseconds(),
+                                std::memory_order_release);
+
+  // Still under the SLO: nothing recorded.
+  metrics->SampleStallsForTesting(start + base::TimeDelta::FromSeconds(1));
+  EXPECT_EQ(baseline, metrics->StallSamplesToValue()->GetList().size());
+
+  metrics->SampleStallsForTesting(start + base::TimeDelta::FromSeconds(30));
+  std::unique_ptr<base::ListValue> samples = metrics->StallSamplesToValue();
+  ASSERT_EQ(baseline + 1, samples->GetList().size());
+  const base::Value& sample = samples->GetList().back();
+  const std::string* session_id = sample.FindStringKey("sessionId");
+  ASSERT_TRUE(session_id);
+  EXPECT_EQ("stalled", *session_id);
+  const std::string* command = sample.FindStringKey("command");
+  ASSERT_TRUE(command);
+  EXPECT_EQ("FindElement", *command);
+  const std::string* wait_site = sample.FindStringKey("waitSite");
+  ASSERT_TRUE(wait_site);
+  EXPECT_EQ("SyncWebSocket::ReceiveNextMessage", *wait_site);
+  EXPECT_EQ(30000.0, sample.FindDoubleKey("elapsedMs").value_or(0));
+
+  // A continuing stall updates its sample rather than appending another.
+  metrics->SampleStallsForTesting(start + base::TimeDelta::FromSeconds(60));
+  samples = metrics->StallSamplesToValue();
+  ASSERT_EQ(baseline + 1, samples->GetList().size());
+  EXPECT_EQ(60000.0,
+            samples->GetList().back().FindDoubleKey("elapsedMs").value_or(0));
+
+  // Once the command finishes, further scans record nothing new.
+  stats->command_start_us.store(0, std::memory_order_release);
+  metrics->SampleStallsForTesting(start + base::TimeDelta::FromSeconds(90));
+  EXPECT_EQ(baseline + 1, metrics->StallSamplesToValue()->GetList().size());
+  metrics->Unregister("stalled");
+}
+
+TEST(SessionMetricsTest, WaitSiteNestingRestoresEnclosingSite) {
+  std::atomic<const char*> slot{nullptr};
+  SetWaitSiteSlotForCurrentThread(&slot);
+  {
+    ScopedWaitSite outer("outer");
+    EXPECT_STREQ("outer", slot.load(std::memory_order_relaxed));
+    {
+      ScopedWaitSite inner("inner");
+      EXPECT_STREQ("inner", slot.load(std::memory_order_relaxed));
+    }
+    EXPECT_STREQ("outer", slot.load(std::memory_order_relaxed));
+  }
+  EXPECT_EQ(nullptr, slot.load(std::memory_order_relaxed));
+  SetWaitSiteSlotForCurrentThread(nullptr);
+}
@@ -0,0 +1,82 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/test/chromedriver/session_thread_map.h"
+
+#include "base/bind.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
+#include "chrome/test/chromedriver/numa_policy.h"
+
+namespace {
+
+// Whether new sessions use the pooled executor. Set once at startup, before
+// any session is created, so no synchronization is needed.
+bool g_use_pooled_executor = false;
+
+}  // namespace
+
+SessionThreadInfo::SessionThreadInfo(const std::string& name,
+                                     bool w3c_mode,
+                                     bool low_priority)
+    : w3c_mode_(w3c_mode), low_priority_(low_priority) {
+  // A session that never receives a command still counts as active from its
+  // creation, so the idle reaper does not fire on a fresh session.
+  TouchActivity();
+  if (!g_use_pooled_executor)
+    thread_ = std::make_unique<base::Thread>(name);
+}
+
+SessionThreadInfo::~SessionThreadInfo() = default;
+
+bool SessionThreadInfo::Start() {
+  if (thread_) {
+    if (low_priority_) {
+      // A bulk session's dedicated thread runs at background priority, so
+      // the OS scheduler prefers interactive sessions' threads whenever
+      // both are runnable.
+      base::Thread::Options options;
+      options.priority = base::ThreadPriority::BACKGROUND;
+      if (!thread_->StartWithOptions(std::move(options)))
+        return false;
+    } else if (!thread_->Start()) {
+      return false;
+    }
+    task_runner_ = thread_->task_runner();
+    // Pinning runs as the thread's first task, so every session command --
+    // including the browser launch -- already executes on the assigned node.
+    // AssignNumaNode() returns -1 unless --numa-policy enabled placement.
+    int numa_node = AssignNumaNode();
+    if (numa_node >= 0) {
+      task_runner_->PostTask(
+          FROM_HERE, base::BindOnce(&PinCurrentThreadToNumaNode, numa_node));
+    }
+    return true;
+  }
+  // SHARED mode multiplexes many sessions onto a small, fixed set of pool
+  // threads while still pinning each session to a single thread, which keeps
+  // thread-affine session state (see GetThreadLocalSession) valid. The NUMA
+  // policy is not applied here: pool threads are shared across sessions, so
+  // no per-session node assignment is possible.
+  // Bulk sessions run at USER_VISIBLE rather than BEST_EFFORT: their tasks
+  // must still run promptly once no interactive work is queued, and
+  // BEST_EFFORT does not mix with BLOCK_SHUTDOWN.
+  const base::TaskPriority priority = low_priority_
+                                          ? base::TaskPriority::USER_VISIBLE
+                                          : base::TaskPriority::USER_BLOCKING;
+  task_runner_ = base::ThreadPool::CreateSingleThreadTaskRunner(
+      {priority, base::MayBlock(), base::WithBaseSyncPrimitives(),
+       base::TaskShutdownBehavior::BLOCK_SHUTDOWN},
+      base::SingleThreadTaskRunnerThreadMode::SHARED);
+  return task_runner_ != nullptr;
+}
+
+scoped_refptr<base::SingleThreadTaskRunner> SessionThreadInfo::task_runner() {
+  return task_runner_;
+}
+
+// static
+void SessionThreadInfo::SetUsePooledExecutor(bool use_pooled_executor) {
+  g_use_pooled_executor = use_pooled_executor;
+}
@@ -5,24 +5,96 @@
 #ifndef CHROME_TEST_CHROMEDRIVER_SESSION_THREAD_MAP_H_
 #define CHROME_TEST_CHROMEDRIVER_SESSION_THREAD_MAP_H_
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
 
+#include "base/memory/scoped_refptr.h"
+#include "base/single_thread_task_runner.h"
 #include "base/threading/thread.h"
+#include "base/time/time.h"
 
-// Info related to session threads, one instance per session. This object should
-// only be accessed on the main thread.
+// Info related to session execution, one instance per session. Session
+// commands run either on a dedicated thread (the default) or on a worker
+// borrowed from the shared thread pool when the pooled session executor is
+// selected via --session-executor=pool. This object should only be accessed
+// on the main thread, except that it may be destroyed on a pool worker so
+// the join of a dedicated session thread does not block the main thread.
 class SessionThreadInfo {
  public:
-  SessionThreadInfo(const std::string& name, bool w3c_mode)
-      : thread_(name), w3c_mode_(w3c_mode) {}
-  base::Thread* thread() { return &thread_; }
+  // |low_priority| marks a session that declared itself bulk traffic via
+  // the "priority" chrome option; its executor runs below interactive
+  // sessions' executors so they are preempted whenever both have work.
+  SessionThreadInfo(const std::string& name,
+                    bool w3c_mode,
+                    bool low_priority = false);
+  ~SessionThreadInfo();
+
+  // Starts the session executor. With the default executor this starts the
+  // dedicated session thread; with the pooled executor this binds a task
+  // runner that shares a fixed set of pool threads with other sessions.
+  // Returns false if the executor could not be started.
+  bool Start();
+
+  // Returns the task runner that session commands must be posted to. Valid
+  // only after Start() has succeeded. All tasks for a given session run on
+  // the same OS thread, though with the pooled executor that thread may be
+  // shared with other sessions.
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner();
+
   bool w3cMode() const { return w3c_mode_; }
 
+  bool LowPriority() const { return low_priority_; }
+
+  // Requests cancelation of the session's in-flight command, if any. Called
+  // on the main thread when the HTTP connection that issued the command goes
+  // away; long waits on the session thread poll the flag and bail out, so an
+  // abandoned command releases the session quickly. The flag is cleared on
+  // the session thread at the start of each command.
+  void RequestCommandCancellation() {
+    cancel_requested_->store(true, std::memory_order_relaxed);
+  }
+
+  // Shared so a command task queued behind this object's teardown (possible
+  // with the pooled executor) cannot be left with a dangling flag.
+  std::shared_ptr<std::atomic<bool>> cancel_flag() { return cancel_requested_; }
+
+  // Records that a command was just dispatched to this session. Called on
+  // the command thread for every session command, so it is a single relaxed
+  // atomic store.
+  void TouchActivity() {
+    last_activity_us_.store(
+        (base::TimeTicks::Now() - base::TimeTicks()).InMicroseconds(),
+        std::memory_order_relaxed);
+  }
+
+  // Returns when a command was last dispatched to this session; used by the
+  // idle-session reaper.
+  base::TimeTicks LastActivity() const {
+    return base::TimeTicks() + base::TimeDelta::FromMicroseconds(
+                                   last_activity_us_.load(
+                                       std::memory_order_relaxed));
+  }
+
+  // Selects the pooled session executor for subsequently created sessions.
+  // Called once at startup before any session exists.
+  static void SetUsePooledExecutor(bool use_pooled_executor);
+
  private:
-  base::Thread thread_;
+  // Unlike the rest of this object, written on the main thread and read on
+  // the session thread; see RequestCommandCancellation().
+  std::shared_ptr<std::atomic<bool>> cancel_requested_ =
+      std::make_shared<std::atomic<bool>>(false);
+  // TimeTicks of the last command dispatch, as microseconds since the ticks
+  // origin. Atomic so the stamp could be touched off the command thread
+  // without a rework; today both writer and reader are the command thread.
+  std::atomic<int64_t> last_activity_us_{0};
+  // Used by the default executor; null in pooled mode.
+  std::unique_ptr<base::Thread> thread_;
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
   bool w3c_mode_;
+  bool low_priority_;
 };
 
 using SessionThreadMap =
@@ -0,0 +1,150 @@
+#!/usr/bin/env python
+# Copyright 2021 The Chromium Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+"""Writes C++ header/cc source files embedding a constexpr struct table.
+
+Unlike cpp_source, which embeds data as one JSON string to be parsed with
+JSONReader at runtime, this module emits the rows as a constexpr array of
+structs, so lookups need no parsing or heap allocation at all.
+"""
+
+import os
+import sys
+
+try:
+  string_types = basestring
+except NameError:
+  string_types = str
+
+
+def _Escape(value):
+  return value.replace('\\', '\\\\').replace('"', '\\"')
+
+
+def _FormatScalar(value):
+  if isinstance(value, bool):
+    return 'true' if value else 'false'
+  if isinstance(value, float) and value == int(value):
+    return str(int(value))
+  return str(value)
+
+
+def _WrapLiteral(value, indent):
+  """Formats |value| as adjacent C string literals wrapped to ~80 columns."""
+  width = 76 - indent
+  chunks = []
+  i = 0
+  while True:
+    chunk = ''
+    n = 0
+    while i < len(value) and n < width:
+      escaped = _Escape(value[i])
+      chunk += escaped
+      n += len(escaped)
+      i += 1
+    chunks.append('"%s"' % chunk)
+    if i >= len(value):
+      break
+  joiner = '\n' + ' ' * indent
+  return joiner.join(chunks)
+
+
+def _FormatRow(row):
+  """Formats one struct initializer, one line if it fits, wrapped if not."""
+  fields = []
+  for field in row:
+    if isinstance(field, string_types):
+      fields.append('"%s"' % _Escape(field))
+    else:
+      fields.append(_FormatScalar(field))
+  line = '    {%s},' % ', '.join(fields)
+  if len(line) <= 80:
+    return line
+  # Long rows get each string field on its own (wrapped) line, with runs of
+  # scalar fields grouped together.
+  groups = []
+  for field in row:
+    if isinstance(field, string_types):
+      groups.append(['string', field])
+    elif groups and groups[-1][0] == 'scalars':
+      groups[-1][1].append(_FormatScalar(field))
+    else:
+      groups.append(['scalars', [_FormatScalar(field)]])
+  lines = []
+  for index, (kind, data) in enumerate(groups):
+    prefix = '    {' if index == 0 else '     '
+    if kind == 'string':
+      text = prefix + _WrapLiteral(data, 5)
+    else:
+      text = prefix + ', '.join(data)
+    text += '},' if index == len(groups) - 1 else ','
+    lines.append(text)
+  return '\n'.join(lines)
+
+
+def WriteTable(base_name,
+               dir_from_src,
+               output_dir,
+               header_body,
+               struct_name,
+               table_name,
+               count_name,
+               rows):
+  """Writes C++ header/cc source files for the given table of rows.
+
+  Args:
+      base_name: The basename of the file, without the extension.
+      dir_from_src: Path from src to the directory that will contain the file,
+          using forward slashes.
+      output_dir: Directory to output the sources to.
+      header_body: Declarations to place in the header: the struct definition
+          and externs for |table_name| and |count_name|.
+      struct_name: Name of the struct each row initializes.
+      table_name: Name of the emitted constexpr array.
+      count_name: Name of the emitted size_t row count.
+      rows: List of rows; each row is a list of python values (strings,
+          numbers, bools) matching the struct fields in order.
+  """
+  copyright_header_template = (
+      '// Copyright 2021 The Chromium Authors. All rights reserved.\n'
+      '// Use of this source code is governed by a BSD-style license '
+      'that can be\n'
+      '// found in the LICENSE file.\n\n'
+      '// This file was generated by running:\n'
+      '//     %s')
+  copyright_header = copyright_header_template % (' '.join(sys.argv))
+
+  temp = '_'.join(dir_from_src.split('/') + [base_name])
+  define = temp.upper() + '_H_'
+  header = '\n'.join([
+      copyright_header,
+      '',
+      '#ifndef ' + define,
+      '#define ' + define,
+      '',
+      header_body,
+      '',
+      '#endif  // ' + define])
+  header += '\n'
+
+  with open(os.path.join(output_dir, base_name + '.h'), 'w') as f:
+    f.write(header)
+
+  body_lines = [
+      copyright_header,
+      '',
+      '#include "%s/%s.h"' % (dir_from_src, base_name),
+      '',
+      'constexpr %s %s[] = {' % (struct_name, table_name)]
+  for row in rows:
+    body_lines.append(_FormatRow(row))
+  body_lines += [
+      '};',
+      '',
+      'const size_t %s =' % count_name,
+      '    sizeof(%s) / sizeof(%s[0]);' % (table_name, table_name)]
+
+  with open(os.path.join(output_dir, base_name + '.cc'), 'w') as f:
+    f.write('\n'.join(body_lines) + '\n')
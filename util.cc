@@ -7,16 +7,25 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "base/base64.h"
+#include "base/bind.h"
 #include "base/files/file_enumerator.h"
 #include "base/files/file_util.h"
-#include "base/files/scoped_temp_dir.h"
 #include "base/format_macros.h"
 #include "base/rand_util.h"
+#include "base/strings/string_piece.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
+#include "base/task/thread_pool_instance.h"
 #include "base/third_party/icu/icu_utf.h"
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/browser_info.h"
@@ -28,7 +37,7 @@
 #include "chrome/test/chromedriver/constants/version.h"
 #include "chrome/test/chromedriver/key_converter.h"
 #include "chrome/test/chromedriver/session.h"
-#include "third_party/zlib/google/zip.h"
+#include "third_party/zlib/google/zip_reader.h"
 
 const char kWindowHandlePrefix[] = "CDwindow-";
 
@@ -61,19 +70,67 @@ Status FlattenStringArray(const base::ListValue* src, std::u16string* dest) {
   return Status(kOk);
 }
 
+// Whether |key| is one of the WebDriver special key code points (modifiers,
+// navigation, editing and function keys), which must be synthesized as real
+// key events rather than inserted as text.
+bool IsWebDriverSpecialKey(char16_t key) {
+  return key >= 0xE000 && key <= 0xE05D;
+}
+
 }  // namespace
 
 Status SendKeysOnWindow(
     WebView* web_view,
     const base::ListValue* key_list,
     bool release_modifiers,
-    int* sticky_modifiers) {
+    int* sticky_modifiers,
+    bool use_insert_text) {
   std::u16string keys;
   Status status = FlattenStringArray(key_list, &keys);
   if (status.IsError())
     return status;
-  std::vector<KeyEvent> events;
   int sticky_modifiers_tmp = *sticky_modifiers;
+  if (use_insert_text) {
+    // Split |keys| into plain-text runs and special keys, in order. A run of
+    // plain text typed with no modifiers held becomes one Input.insertText
+    // call; special keys, and any text typed while a modifier is held (which
+    // insertText would paste uninterpreted), keep full key-event synthesis.
+    // Special keys are converted one at a time so a plain-text run can resume
+    // as soon as the modifier state drops back to zero.
+    size_t i = 0;
+    while (i < keys.size()) {
+      if (sticky_modifiers_tmp == 0 && !IsWebDriverSpecialKey(keys[i])) {
+        size_t start = i;
+        while (i < keys.size() && !IsWebDriverSpecialKey(keys[i]))
+          ++i;
+        status = web_view->InsertText(
+            base::UTF16ToUTF8(keys.substr(start, i - start)));
+      } else {
+        std::vector<KeyEvent> events;
+        status = ConvertKeysToKeyEvents(
+            keys.substr(i, 1), false, &sticky_modifiers_tmp, &events);
+        if (status.IsError())
+          return status;
+        status = web_view->DispatchKeyEvents(events, false);
+        ++i;
+      }
+      if (status.IsError())
+        return status;
+    }
+    if (release_modifiers && sticky_modifiers_tmp != 0) {
+      std::vector<KeyEvent> events;
+      status = ConvertKeysToKeyEvents(
+          std::u16string(), true, &sticky_modifiers_tmp, &events);
+      if (status.IsError())
+        return status;
+      status = web_view->DispatchKeyEvents(events, false);
+      if (status.IsError())
+        return status;
+    }
+    *sticky_modifiers = sticky_modifiers_tmp;
+    return Status(kOk);
+  }
+  std::vector<KeyEvent> events;
   status = ConvertKeysToKeyEvents(
       keys, release_modifiers, &sticky_modifiers_tmp, &events);
   if (status.IsError())
@@ -86,32 +143,92 @@ Status SendKeysOnWindow(
 
 bool Base64Decode(const std::string& base64,
                   std::string* bytes) {
-  std::string copy = base64;
   // Some WebDriver client base64 encoders follow RFC 1521, which require that
-  // 'encoded lines be no more than 76 characters long'. Just remove any
-  // newlines.
-  base::RemoveChars(copy, "\n", &copy);
-  return base::Base64Decode(copy, bytes);
+  // 'encoded lines be no more than 76 characters long', so newlines must be
+  // stripped before decoding. Most clients send an unbroken string, and
+  // payloads can run to many MB, so decode in place unless a newline is
+  // actually present.
+  if (base64.find('\n') == std::string::npos)
+    return base::Base64Decode(base64, bytes);
+
+  // Strip newlines into a fixed-size buffer and decode it as it fills,
+  // instead of materializing a full-size newline-free copy of the input.
+  // The buffer size is a multiple of 4, so every full buffer is a
+  // self-contained run of base64 quads; valid input has a character count
+  // that is a multiple of 4 once newlines are removed, so the final partial
+  // buffer (with any '=' padding) decodes on its own as well.
+  bytes->clear();
+  bytes->reserve(base64.size() / 4 * 3);
+  char buffer[4096];
+  size_t filled = 0;
+  std::string piece;
+  for (char c : base64) {
+    if (c == '\n')
+      continue;
+    buffer[filled++] = c;
+    if (filled == sizeof(buffer)) {
+      if (!base::Base64Decode(base::StringPiece(buffer, filled), &piece))
+        return false;
+      bytes->append(piece);
+      filled = 0;
+    }
+  }
+  if (filled) {
+    if (!base::Base64Decode(base::StringPiece(buffer, filled), &piece))
+      return false;
+    bytes->append(piece);
+  }
+  return true;
 }
 
 namespace {
 
-Status UnzipArchive(const base::FilePath& unzip_dir,
-                    const std::string& bytes) {
-  base::ScopedTempDir dir;
-  if (!dir.CreateUniqueTempDir())
-    return Status(kUnknownError, "unable to create temp dir");
-
-  base::FilePath archive = dir.GetPath().AppendASCII("temp.zip");
-  int length = bytes.length();
-  if (base::WriteFile(archive, bytes.c_str(), length) != length)
-    return Status(kUnknownError, "could not write file to temp dir");
-
-  if (!zip::Unzip(archive, unzip_dir))
-    return Status(kUnknownError, "could not unzip archive");
+// Maximum number of workers inflating zip entries in parallel.
+const int kMaxUnzipWorkers = 4;
+
+// Inflates the entries of the in-memory zip archive |bytes| whose indices
+// are congruent to |worker_index| modulo |worker_count| into |unzip_dir|.
+// Each worker walks the archive with its own reader over the shared buffer,
+// so no synchronization is needed. Concurrent directory creation is safe:
+// base::CreateDirectory treats an already-existing directory as success.
+Status ExtractZipEntryStripe(const std::string& bytes,
+                             const base::FilePath& unzip_dir,
+                             int worker_index,
+                             int worker_count) {
+  zip::ZipReader reader;
+  if (!reader.OpenFromString(bytes))
+    return Status(kUnknownError, "could not open zip archive");
+  for (int index = 0; reader.HasMore(); index++) {
+    if (index % worker_count == worker_index) {
+      if (!reader.OpenCurrentEntryInZip())
+        return Status(kUnknownError, "could not open zip archive entry");
+      zip::ZipReader::EntryInfo* entry = reader.current_entry_info();
+      // Drop entries with unsafe paths (absolute or referencing a parent),
+      // as zip::Unzip does.
+      if (!entry->is_unsafe() &&
+          !reader.ExtractCurrentEntryToFilePath(
+              unzip_dir.Append(entry->file_path()))) {
+        return Status(kUnknownError, "could not unzip archive entry " +
+                                         entry->file_path().AsUTF8Unsafe());
+      }
+    }
+    if (!reader.AdvanceToNextEntry())
+      return Status(kUnknownError, "could not read zip archive");
+  }
   return Status(kOk);
 }
 
+void RunExtractZipEntryStripe(const std::string* bytes,
+                              const base::FilePath* unzip_dir,
+                              int worker_index,
+                              int worker_count,
+                              Status* result,
+                              base::WaitableEvent* done) {
+  *result =
+      ExtractZipEntryStripe(*bytes, *unzip_dir, worker_index, worker_count);
+  done->Signal();
+}
+
 // Stream for writing binary data.
 class DataOutputStream {
  public:
@@ -380,6 +497,41 @@ Status UnzipEntry(const base::FilePath& unzip_dir,
 
 }  // namespace
 
+Status UnzipArchive(const base::FilePath& unzip_dir,
+                    const std::string& bytes) {
+  zip::ZipReader reader;
+  if (!reader.OpenFromString(bytes))
+    return Status(kUnknownError, "could not open zip archive");
+  const int num_entries = reader.num_entries();
+  reader.Close();
+  if (num_entries == 0)
+    return Status(kOk);
+
+  int worker_count = std::min(kMaxUnzipWorkers, num_entries);
+  // Without a thread pool (e.g. in unit tests), inflate on this thread.
+  if (!base::ThreadPoolInstance::Get())
+    worker_count = 1;
+  if (worker_count == 1)
+    return ExtractZipEntryStripe(bytes, unzip_dir, 0, 1);
+
+  std::vector<Status> results(worker_count, Status(kOk));
+  std::vector<std::unique_ptr<base::WaitableEvent>> done_events;
+  for (int i = 0; i < worker_count; i++) {
+    done_events.push_back(std::make_unique<base::WaitableEvent>());
+    base::ThreadPool::PostTask(
+        FROM_HERE, {base::MayBlock()},
+        base::BindOnce(&RunExtractZipEntryStripe, &bytes, &unzip_dir, i,
+                       worker_count, &results[i], done_events.back().get()));
+  }
+  for (const auto& done : done_events)
+    done->Wait();
+  for (const Status& result : results) {
+    if (result.IsError())
+      return result;
+  }
+  return Status(kOk);
+}
+
 Status UnzipSoleFile(const base::FilePath& unzip_dir,
                      const std::string& bytes,
                      base::FilePath* file) {
@@ -575,6 +727,33 @@ bool SetSafeInt(base::DictionaryValue* dict,
     return dict->SetDouble(path, in_value_64);
 }
 
+Status ParseScreenshotCaptureParams(const base::DictionaryValue& params,
+                                    base::DictionaryValue* capture_params) {
+  std::string format;
+  bool has_format = false;
+  if (!GetOptionalString(&params, "format", &format, &has_format))
+    return Status(kInvalidArgument, "'format' must be a string");
+  if (has_format) {
+    if (format != "png" && format != "jpeg" && format != "webp")
+      return Status(kInvalidArgument,
+                    "'format' must be 'png', 'jpeg' or 'webp'");
+    capture_params->SetString("format", format);
+  }
+  int quality = 0;
+  bool has_quality = false;
+  if (!GetOptionalInt(&params, "quality", &quality, &has_quality))
+    return Status(kInvalidArgument, "'quality' must be an integer");
+  if (has_quality) {
+    if (quality < 0 || quality > 100)
+      return Status(kInvalidArgument, "'quality' must be between 0 and 100");
+    if (format != "jpeg" && format != "webp")
+      return Status(kInvalidArgument,
+                    "'quality' requires 'format' to be 'jpeg' or 'webp'");
+    capture_params->SetInteger("quality", quality);
+  }
+  return Status(kOk);
+}
+
 std::string WebViewIdToWindowHandle(const std::string& web_view_id) {
   return kWindowHandlePrefix + web_view_id;
 }
@@ -21,17 +21,26 @@ class WebView;
 // Generates a random, 32-character hexidecimal ID.
 std::string GenerateId();
 
-// Send a sequence of key strokes to the active Element in window.
+// Send a sequence of key strokes to the active Element in window. If
+// |use_insert_text| is true, runs of plain text typed with no modifiers held
+// are delivered with a single Input.insertText call each; special keys and
+// modified text are still synthesized as real key events.
 Status SendKeysOnWindow(
     WebView* web_view,
     const base::ListValue* key_list,
     bool release_modifiers,
-    int* sticky_modifiers);
+    int* sticky_modifiers,
+    bool use_insert_text);
 
 // Decodes the given base64-encoded string, after removing any newlines,
 // which are required in some base64 standards. Returns true on success.
 bool Base64Decode(const std::string& base64, std::string* bytes);
 
+// Unzips the given zip archive data |bytes| into |unzip_dir|, inflating
+// entries directly from the in-memory buffer (in parallel when a thread pool
+// is available) instead of staging the archive in a temporary file.
+Status UnzipArchive(const base::FilePath& unzip_dir, const std::string& bytes);
+
 // Unzips the sole file contained in the given zip data |bytes| into
 // |unzip_dir|. The zip data may be a normal zip archive or a single zip file
 // entry. If the unzip successfully produced one file, returns true and sets
@@ -102,6 +111,13 @@ bool SetSafeInt(base::DictionaryValue* dict,
                 const base::StringPiece path,
                 int64_t in_value_64);
 
+// Parses the vendor screenshot encoding options in |params| into
+// Page.captureScreenshot parameters: "format" must be "png", "jpeg" or
+// "webp", and "quality" an integer from 0 to 100 (lossy formats only).
+// Absent options leave the browser's default, lossless PNG, in effect.
+Status ParseScreenshotCaptureParams(const base::DictionaryValue& params,
+                                    base::DictionaryValue* capture_params);
+
 // Provides WindowHandle to WebView method to maintain consistency across
 // ChromeDriver.
 std::string WebViewIdToWindowHandle(const std::string& web_view_id);
@@ -3,12 +3,15 @@
 // found in the LICENSE file.
 
 #include <string>
+#include <vector>
 
 #include "base/base64.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/files/scoped_temp_dir.h"
 #include "chrome/test/chromedriver/chrome/status.h"
+#include "chrome/test/chromedriver/chrome/stub_web_view.h"
+#include "chrome/test/chromedriver/chrome/ui_events.h"
 #include "chrome/test/chromedriver/util.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -366,3 +369,122 @@ TEST(ConvertCentimeterToInch, NegativeDouble) {
   ASSERT_EQ(-1, ConvertCentimeterToInch(-2.54));
   ASSERT_EQ(-0.1, ConvertCentimeterToInch(-0.254));
 }
+
+namespace {
+
+// Records InsertText and DispatchKeyEvents calls so tests can check how
+// SendKeysOnWindow splits its input in fast-typing mode.
+class FastTypingWebView : public StubWebView {
+ public:
+  FastTypingWebView() : StubWebView("1") {}
+
+  Status InsertText(const std::string& text) override {
+    inserted_texts.push_back(text);
+    return Status(kOk);
+  }
+
+  Status DispatchKeyEvents(const std::vector<KeyEvent>& events,
+                           bool async_dispatch_events) override {
+    dispatched_events.insert(dispatched_events.end(), events.begin(),
+                             events.end());
+    return Status(kOk);
+  }
+
+  std::vector<std::string> inserted_texts;
+  std::vector<KeyEvent> dispatched_events;
+};
+
+}  // namespace
+
+TEST(SendKeysOnWindow, FastTypingInsertsPlainRunInOneCall) {
+  FastTypingWebView web_view;
+  base::ListValue key_list;
+  key_list.AppendString("hello world");
+  int sticky_modifiers = 0;
+  Status status = SendKeysOnWindow(&web_view, &key_list, true,
+                                   &sticky_modifiers, true);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  ASSERT_EQ(1u, web_view.inserted_texts.size());
+  ASSERT_EQ("hello world", web_view.inserted_texts[0]);
+  ASSERT_TRUE(web_view.dispatched_events.empty());
+  ASSERT_EQ(0, sticky_modifiers);
+}
+
+TEST(SendKeysOnWindow, FastTypingSynthesizesSpecialKeys) {
+  FastTypingWebView web_view;
+  base::ListValue key_list;
+  // "ab", Tab (U+E004), "cd".
+  key_list.AppendString("ab\xEE\x80\x84""cd");
+  int sticky_modifiers = 0;
+  Status status = SendKeysOnWindow(&web_view, &key_list, true,
+                                   &sticky_modifiers, true);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  ASSERT_EQ(2u, web_view.inserted_texts.size());
+  ASSERT_EQ("ab", web_view.inserted_texts[0]);
+  ASSERT_EQ("cd", web_view.inserted_texts[1]);
+  ASSERT_FALSE(web_view.dispatched_events.empty());
+}
+
+TEST(SendKeysOnWindow, FastTypingSynthesizesModifiedText) {
+  FastTypingWebView web_view;
+  base::ListValue key_list;
+  // Shift (U+E008) followed by text: the text is typed while a modifier is
+  // held, so it must go through key events, not insertText.
+  key_list.AppendString("\xEE\x80\x88""ab");
+  int sticky_modifiers = 0;
+  Status status = SendKeysOnWindow(&web_view, &key_list, true,
+                                   &sticky_modifiers, true);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  ASSERT_TRUE(web_view.inserted_texts.empty());
+  ASSERT_FALSE(web_view.dispatched_events.empty());
+  // release_modifiers is true, so Shift is depressed again at the end.
+  ASSERT_EQ(0, sticky_modifiers);
+}
+
+TEST(SendKeysOnWindow, FastTypingDisabledUsesKeyEvents) {
+  FastTypingWebView web_view;
+  base::ListValue key_list;
+  key_list.AppendString("hello");
+  int sticky_modifiers = 0;
+  Status status = SendKeysOnWindow(&web_view, &key_list, true,
+                                   &sticky_modifiers, false);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  ASSERT_TRUE(web_view.inserted_texts.empty());
+  ASSERT_FALSE(web_view.dispatched_events.empty());
+}
+
+TEST(Base64Decode, PlainInput) {
+  std::string bytes;
+  ASSERT_TRUE(Base64Decode("Y2hyb21lZHJpdmVy", &bytes));
+  ASSERT_EQ("chromedriver", bytes);
+}
+
+TEST(Base64Decode, NewlinesStripped) {
+  std::string bytes;
+  ASSERT_TRUE(Base64Decode("Y2hyb21l\nZHJpdmVy\n", &bytes));
+  ASSERT_EQ("chromedriver", bytes);
+}
+
+TEST(Base64Decode, LineBrokenInputSpanningChunks) {
+  // Large enough that the streaming decode crosses its internal buffer
+  // boundary several times, with RFC 1521 style 76-character lines.
+  std::string data;
+  for (int i = 0; i < 9001; ++i)
+    data.push_back(static_cast<char>(i % 251));
+  std::string encoded;
+  base::Base64Encode(data, &encoded);
+  std::string wrapped;
+  for (size_t i = 0; i < encoded.size(); i += 76) {
+    wrapped.append(encoded, i, 76);
+    wrapped.push_back('\n');
+  }
+  std::string bytes;
+  ASSERT_TRUE(Base64Decode(wrapped, &bytes));
+  ASSERT_EQ(data, bytes);
+}
+
+TEST(Base64Decode, InvalidInput) {
+  std::string bytes;
+  ASSERT_FALSE(Base64Decode("not base64!", &bytes));
+  ASSERT_FALSE(Base64Decode("YWJj\nZA", &bytes));
+}
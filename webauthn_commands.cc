@@ -4,6 +4,7 @@
 
 #include "chrome/test/chromedriver/webauthn_commands.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
@@ -177,10 +178,13 @@ Status ExecuteRemoveVirtualAuthenticator(WebView* web_view,
       MapParams({{"authenticatorId", "authenticatorId"}}, params), value);
 }
 
-Status ExecuteAddCredential(WebView* web_view,
-                            const base::Value& params,
-                            std::unique_ptr<base::Value>* value) {
-  base::DictionaryValue mapped_params = MapParams(
+namespace {
+
+// Builds the WebAuthn.addCredential parameters for a single credential,
+// converting the binary fields from base64url to base64 on the way.
+Status BuildAddCredentialParams(const base::Value& params,
+                                base::DictionaryValue* mapped_params) {
+  *mapped_params = MapParams(
       {
           {"authenticatorId", "authenticatorId"},
           {"credential.credentialId", "credentialId"},
@@ -192,9 +196,18 @@ Status ExecuteAddCredential(WebView* web_view,
           {"credential.largeBlob", "largeBlob"},
       },
       params);
-  Status status = ConvertBase64UrlToBase64(
-      mapped_params.FindKey("credential"),
+  return ConvertBase64UrlToBase64(
+      mapped_params->FindKey("credential"),
       {"credentialId", "privateKey", "userHandle", "largeBlob"});
+}
+
+}  // namespace
+
+Status ExecuteAddCredential(WebView* web_view,
+                            const base::Value& params,
+                            std::unique_ptr<base::Value>* value) {
+  base::DictionaryValue mapped_params;
+  Status status = BuildAddCredentialParams(params, &mapped_params);
   if (status.IsError())
     return status;
 
@@ -202,6 +215,45 @@ Status ExecuteAddCredential(WebView* web_view,
                                            std::move(mapped_params), value);
 }
 
+Status ExecuteAddCredentials(WebView* web_view,
+                             const base::Value& params,
+                             std::unique_ptr<base::Value>* value) {
+  const base::Value* credentials = params.FindListKey("credentials");
+  if (!credentials)
+    return Status(kInvalidArgument, "credentials must be a list");
+  const base::Value* authenticator_id = params.FindKey("authenticatorId");
+
+  // Validate and convert every credential before sending anything, so a
+  // malformed entry fails the whole batch up front.
+  std::vector<base::DictionaryValue> batch;
+  for (const base::Value& credential : credentials->GetList()) {
+    if (!credential.is_dict())
+      return Status(kInvalidArgument, "each credential must be an object");
+    base::Value merged = credential.Clone();
+    if (authenticator_id)
+      merged.SetKey("authenticatorId", authenticator_id->Clone());
+    base::DictionaryValue mapped_params;
+    Status status = BuildAddCredentialParams(merged, &mapped_params);
+    if (status.IsError())
+      return status;
+    batch.push_back(std::move(mapped_params));
+  }
+  if (batch.empty())
+    return Status(kOk);
+
+  // Pipeline all but the last credential without waiting for responses;
+  // the final blocking command is processed after them, so one round-trip
+  // wait covers the whole batch.
+  for (size_t i = 0; i + 1 < batch.size(); ++i) {
+    Status status = web_view->SendCommandAndIgnoreResponse(
+        "WebAuthn.addCredential", batch[i]);
+    if (status.IsError())
+      return status;
+  }
+  return web_view->SendCommandAndGetResult("WebAuthn.addCredential",
+                                           batch.back(), value);
+}
+
 Status ExecuteGetCredentials(WebView* web_view,
                              const base::Value& params,
                              std::unique_ptr<base::Value>* value) {
@@ -224,6 +276,48 @@ Status ExecuteGetCredentials(WebView* web_view,
   return status;
 }
 
+Status ExecuteGetCredentialsPage(WebView* web_view,
+                                 const base::Value& params,
+                                 std::unique_ptr<base::Value>* value) {
+  base::Optional<int> page = params.FindIntKey("page");
+  base::Optional<int> page_size = params.FindIntKey("pageSize");
+  if (!page || *page < 0)
+    return Status(kInvalidArgument, "page must be a non-negative integer");
+  if (!page_size || *page_size <= 0)
+    return Status(kInvalidArgument, "pageSize must be a positive integer");
+
+  std::unique_ptr<base::Value> result;
+  Status status = web_view->SendCommandAndGetResult(
+      "WebAuthn.getCredentials",
+      MapParams({{"authenticatorId", "authenticatorId"}}, params), &result);
+  if (status.IsError())
+    return status;
+
+  base::Optional<base::Value> credentials = result->ExtractKey("credentials");
+  if (!credentials)
+    return Status(kUnknownError, kDevToolsDidNotReturnExpectedValue);
+
+  base::Value::ListStorage all = std::move(*credentials).TakeList();
+  const size_t total = all.size();
+  const size_t begin =
+      std::min(static_cast<size_t>(*page) * *page_size, total);
+  const size_t end = std::min(begin + static_cast<size_t>(*page_size), total);
+
+  base::Value page_list(base::Value::Type::LIST);
+  for (size_t i = begin; i < end; ++i) {
+    // Only the returned slice pays the base64url re-encoding cost.
+    ConvertBase64ToBase64Url(
+        &all[i], {"credentialId", "privateKey", "userHandle", "largeBlob"});
+    page_list.Append(std::move(all[i]));
+  }
+
+  base::Value paged(base::Value::Type::DICTIONARY);
+  paged.SetIntKey("total", static_cast<int>(total));
+  paged.SetKey("credentials", std::move(page_list));
+  *value = std::make_unique<base::Value>(std::move(paged));
+  return status;
+}
+
 Status ExecuteRemoveCredential(WebView* web_view,
                                const base::Value& params,
                                std::unique_ptr<base::Value>* value) {
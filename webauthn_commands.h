@@ -44,11 +44,23 @@ Status ExecuteAddCredential(WebView* web_view,
                             const base::Value& params,
                             std::unique_ptr<base::Value>* value);
 
+// Inject a batch of credentials into an authenticator with a single
+// round-trip wait, pipelining one WebAuthn.addCredential call per entry.
+Status ExecuteAddCredentials(WebView* web_view,
+                             const base::Value& params,
+                             std::unique_ptr<base::Value>* value);
+
 // Retrieve all the credentials stored in an authenticator.
 Status ExecuteGetCredentials(WebView* web_view,
                              const base::Value& params,
                              std::unique_ptr<base::Value>* value);
 
+// Retrieve one page of the credentials stored in an authenticator, so
+// large credential stores need not be re-encoded wholesale per request.
+Status ExecuteGetCredentialsPage(WebView* web_view,
+                                 const base::Value& params,
+                                 std::unique_ptr<base::Value>* value);
+
 // Remove a single credential stored in an authenticator.
 Status ExecuteRemoveCredential(WebView* web_view,
                                const base::Value& params,
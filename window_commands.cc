@@ -6,12 +6,18 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <list>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "base/callback.h"
+#include "base/files/file_path.h"
+#include "base/hash/hash.h"
+#include "base/json/json_writer.h"
 #include "base/logging.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
@@ -23,10 +29,14 @@
 #include "base/values.h"
 #include "build/build_config.h"
 #include "chrome/test/chromedriver/basic_types.h"
+#include "chrome/test/chromedriver/chrome/ax_node_cache.h"
 #include "chrome/test/chromedriver/chrome/browser_info.h"
 #include "chrome/test/chromedriver/chrome/chrome.h"
 #include "chrome/test/chromedriver/chrome/chrome_desktop_impl.h"
 #include "chrome/test/chromedriver/chrome/devtools_client.h"
+#include "chrome/test/chromedriver/chrome/devtools_http_client.h"
+#include "chrome/test/chromedriver/chrome/dom_snapshot_extractor.h"
+#include "chrome/test/chromedriver/chrome/frame_tracker.h"
 #include "chrome/test/chromedriver/chrome/geoposition.h"
 #include "chrome/test/chromedriver/chrome/javascript_dialog_manager.h"
 #include "chrome/test/chromedriver/chrome/js.h"
@@ -624,6 +634,86 @@ Status ParsePageRanges(const base::DictionaryValue& params,
   *pageRanges = base::JoinString(ranges, ",");
   return Status(kOk);
 }
+
+bool UrlSupportsCookies(const std::string& url) {
+  return base::StartsWith(url, "http://",
+                          base::CompareCase::INSENSITIVE_ASCII) ||
+         base::StartsWith(url, "https://",
+                          base::CompareCase::INSENSITIVE_ASCII) ||
+         base::StartsWith(url, "ftp://", base::CompareCase::INSENSITIVE_ASCII);
+}
+
+// A cookie from command parameters, validated and normalized the same way for
+// single and bulk adds.
+struct ParsedCookie {
+  std::string name;
+  std::string value;
+  std::string domain;
+  std::string path;
+  std::string same_site;
+  bool secure = false;
+  bool http_only = false;
+  double expiry = -1;
+};
+
+Status ParseCookie(Session* session,
+                   const base::DictionaryValue& cookie,
+                   const std::string& url,
+                   ParsedCookie* parsed) {
+  if (!cookie.GetString("name", &parsed->name))
+    return Status(kInvalidArgument, "missing 'name'");
+  if (!cookie.GetString("value", &parsed->value))
+    return Status(kInvalidArgument, "missing 'value'");
+  if (!GetOptionalString(&cookie, "domain", &parsed->domain))
+    return Status(kInvalidArgument, "invalid 'domain'");
+  if (session->w3c_compliant && !parsed->domain.empty() &&
+      !url::HostIsIPAddress(parsed->domain)) {
+    std::string& domain = parsed->domain;
+    if (domain[0] == '.')
+      domain = domain.substr(1);
+
+    if (domain.size() < 2)
+      return Status(kInvalidCookieDomain, "invalid 'domain'");
+
+    if (!GURL(url).DomainIs(domain))
+      return Status(kInvalidCookieDomain, "Cookie 'domain' mismatch");
+
+    domain.insert(0, 1, '.');
+  }
+  parsed->path = "/";
+  if (!GetOptionalString(&cookie, "path", &parsed->path))
+    return Status(kInvalidArgument, "invalid 'path'");
+  if (!GetOptionalString(&cookie, "sameSite", &parsed->same_site))
+    return Status(kInvalidArgument, "invalid 'sameSite'");
+  if (!parsed->same_site.empty() && parsed->same_site != "Strict" &&
+      parsed->same_site != "Lax" && parsed->same_site != "None")
+    return Status(kInvalidArgument, "invalid 'sameSite'");
+  if (!GetOptionalBool(&cookie, "secure", &parsed->secure))
+    return Status(kInvalidArgument, "invalid 'secure'");
+  if (!GetOptionalBool(&cookie, "httpOnly", &parsed->http_only))
+    return Status(kInvalidArgument, "invalid 'httpOnly'");
+  bool has_value;
+  if (session->w3c_compliant) {
+    // W3C spec says expiry is a safe integer.
+    int64_t expiry_int64;
+    if (!GetOptionalSafeInt(&cookie, "expiry", &expiry_int64, &has_value) ||
+        (has_value && expiry_int64 < 0))
+      return Status(kInvalidArgument, "invalid 'expiry'");
+    // Use negative value to indicate expiry not specified.
+    parsed->expiry = has_value ? static_cast<double>(expiry_int64) : -1.0;
+  } else {
+    // JSON wire protocol didn't specify the type of expiry, but ChromeDriver
+    // has always accepted double, so we keep that in legacy mode.
+    if (!GetOptionalDouble(&cookie, "expiry", &parsed->expiry, &has_value) ||
+        (has_value && parsed->expiry < 0))
+      return Status(kInvalidArgument, "invalid 'expiry'");
+    if (!has_value)
+      parsed->expiry =
+          (base::Time::Now() - base::Time::UnixEpoch()).InSeconds() +
+          kDefaultCookieExpiryTime;
+  }
+  return Status(kOk);
+}
 }  // namespace
 
 Status ExecuteWindowCommand(const WindowCommand& command,
@@ -640,12 +730,18 @@ Status ExecuteWindowCommand(const WindowCommand& command,
   if (status.IsError())
     return status;
 
-  status = web_view->HandleReceivedEvents();
-  if (status.IsError())
-    return status;
-
   JavaScriptDialogManager* dialog_manager =
       web_view->GetJavaScriptDialogManager();
+  // Dialog-opening events are flagged by the socket at receive time, so
+  // the queue only needs to be drained here when one may be waiting.
+  // Other queued events are handled while the command awaits its own
+  // response, in the same order as before.
+  if (dialog_manager->MayHavePendingDialogEvents()) {
+    status = web_view->HandleReceivedEvents();
+    if (status.IsError())
+      return status;
+  }
+
   if (dialog_manager->IsDialogOpen()) {
     std::string alert_text;
     status = dialog_manager->GetDialogMessage(&alert_text);
@@ -727,10 +823,10 @@ Status ExecuteGet(Session* session,
                   std::unique_ptr<base::Value>* value,
                   Timeout* timeout) {
   timeout->SetDuration(session->page_load_timeout);
-  std::string url;
-  if (!params.GetString("url", &url))
+  const std::string* url = params.FindStringKey("url");
+  if (!url)
     return Status(kInvalidArgument, "'url' must be a string");
-  Status status = web_view->Load(url, timeout);
+  Status status = web_view->Load(*url, timeout);
   if (status.IsError())
     return status;
   session->SwitchToTopFrame();
@@ -742,25 +838,29 @@ Status ExecuteExecuteScript(Session* session,
                             const base::DictionaryValue& params,
                             std::unique_ptr<base::Value>* value,
                             Timeout* timeout) {
-  std::string script;
-  if (!params.GetString("script", &script))
+  const std::string* script = params.FindStringKey("script");
+  if (!script)
     return Status(kInvalidArgument, "'script' must be a string");
-  if (script == ":takeHeapSnapshot") {
+  if (*script == ":takeHeapSnapshot") {
     return web_view->TakeHeapSnapshot(value);
-  } else if (script == ":startProfile") {
+  } else if (*script == ":startProfile") {
     return web_view->StartProfile();
-  } else if (script == ":endProfile") {
+  } else if (*script == ":endProfile") {
     return web_view->EndProfile(value);
   } else {
     const base::ListValue* args;
     if (!params.GetList("args", &args))
       return Status(kInvalidArgument, "'args' must be a list");
-    // Need to support line oriented comment
-    if (script.find("//") != std::string::npos)
-      script = script + "\n";
+    // Need to support line oriented comment. Only copy the script when the
+    // trailing newline actually has to be appended.
+    std::string script_with_newline;
+    if (script->find("//") != std::string::npos) {
+      script_with_newline = *script + "\n";
+      script = &script_with_newline;
+    }
 
     Status status =
-        web_view->CallUserSyncScript(session->GetCurrentFrameId(), script,
+        web_view->CallUserSyncScript(session->GetCurrentFrameId(), *script,
                                      *args, session->script_timeout, value);
     if (status.code() == kTimeout)
       return Status(kScriptTimeout);
@@ -773,19 +873,22 @@ Status ExecuteExecuteAsyncScript(Session* session,
                                  const base::DictionaryValue& params,
                                  std::unique_ptr<base::Value>* value,
                                  Timeout* timeout) {
-  std::string script;
-  if (!params.GetString("script", &script))
+  const std::string* script = params.FindStringKey("script");
+  if (!script)
     return Status(kInvalidArgument, "'script' must be a string");
   const base::ListValue* args;
   if (!params.GetList("args", &args))
     return Status(kInvalidArgument, "'args' must be a list");
 
-  // Need to support line oriented comment
-  if (script.find("//") != std::string::npos)
-    script = script + "\n";
+  // Need to support line oriented comment. The wrapper concatenation below is
+  // the first point that actually needs an owned copy.
+  std::string wrapped = "async function(){" + *script;
+  if (script->find("//") != std::string::npos)
+    wrapped += "\n";
+  wrapped += "}";
 
   Status status = web_view->CallUserAsyncFunction(
-      session->GetCurrentFrameId(), "async function(){" + script + "}", *args,
+      session->GetCurrentFrameId(), wrapped, *args,
       session->script_timeout, value);
   if (status.code() == kTimeout)
     return Status(kScriptTimeout);
@@ -840,16 +943,15 @@ Status ExecuteSwitchToFrame(Session* session,
 
   std::string script;
   base::ListValue args;
+  std::string locator_key;
+  std::string displayed_check_element_id;
   const base::DictionaryValue* id_dict;
   if (id->GetAsDictionary(&id_dict)) {
     std::string element_id;
     if (!id_dict->GetString(GetElementKey(), &element_id))
       return Status(kInvalidArgument, "missing 'ELEMENT'");
-    bool is_displayed = false;
-    Status status = IsElementDisplayed(
-          session, web_view, element_id, true, &is_displayed);
-    if (status.IsError())
-      return status;
+    locator_key = "elem:" + element_id;
+    displayed_check_element_id = element_id;
     script = "function(elem) { return elem; }";
     args.Append(id_dict->CreateDeepCopy());
   } else {
@@ -876,8 +978,42 @@ Status ExecuteSwitchToFrame(Session* session,
     } else {
       return Status(kInvalidArgument, "invalid 'id'");
     }
+    locator_key = "xpath:" + xpath;
     args.AppendString(xpath);
   }
+
+  // Repeat switches to the same frame within a stable page are common in
+  // SPA suites, so the resolution below is memoized per session. A hit
+  // replays the recorded switch with no DevTools traffic at all; any
+  // navigation since resolution time has bumped the tracker's epoch and
+  // misses the cache. Test web views have no tracker and skip memoization.
+  FrameTracker* frame_tracker = web_view->GetFrameTracker();
+  std::string cache_key;
+  int navigation_epoch = 0;
+  if (frame_tracker) {
+    navigation_epoch = frame_tracker->navigation_epoch();
+    cache_key =
+        session->window + "|" + session->GetCurrentFrameId() + "|" +
+        locator_key;
+    auto it = session->frame_switch_cache.find(cache_key);
+    if (it != session->frame_switch_cache.end()) {
+      if (it->second.navigation_epoch == navigation_epoch) {
+        session->SwitchToSubFrame(it->second.frame_id,
+                                  it->second.chromedriver_frame_id);
+        return Status(kOk);
+      }
+      session->frame_switch_cache.erase(it);
+    }
+  }
+
+  if (!displayed_check_element_id.empty()) {
+    bool is_displayed = false;
+    Status status = IsElementDisplayed(
+          session, web_view, displayed_check_element_id, true, &is_displayed);
+    if (status.IsError())
+      return status;
+  }
+
   std::string frame;
   Status status = web_view->GetFrameByFunction(
       session->GetCurrentFrameId(), script, args, &frame);
@@ -899,13 +1035,25 @@ Status ExecuteSwitchToFrame(Session* session,
       "  frame.setAttribute('cd_frame_id_', id);"
       "}";
   base::ListValue new_args;
-  new_args.Append(element->CreateDeepCopy());
+  // |element| is a view into |result|, which is not needed afterwards, so
+  // the dictionary can be moved into the argument list instead of cloned.
+  new_args.Append(std::move(*result));
   new_args.AppendString(chrome_driver_id);
   result.reset(NULL);
   status = web_view->CallFunction(
       session->GetCurrentFrameId(), kSetFrameIdentifier, new_args, &result);
   if (status.IsError())
     return status;
+  if (frame_tracker) {
+    // Record under the epoch read before resolving: if a navigation raced
+    // the calls above, the entry is born stale and the next switch misses.
+    if (session->frame_switch_cache.size() >= 128)
+      session->frame_switch_cache.clear();
+    FrameSwitchCacheEntry& entry = session->frame_switch_cache[cache_key];
+    entry.navigation_epoch = navigation_epoch;
+    entry.frame_id = frame;
+    entry.chromedriver_frame_id = chrome_driver_id;
+  }
   session->SwitchToSubFrame(frame, chrome_driver_id);
   return Status(kOk);
 }
@@ -934,12 +1082,7 @@ Status ExecuteGetPageSource(Session* session,
                             const base::DictionaryValue& params,
                             std::unique_ptr<base::Value>* value,
                             Timeout* timeout) {
-  const char kGetPageSource[] =
-      " () => (document.documentElement || {}).outerHTML || ''";
-
-  base::ListValue args;
-  return web_view->CallFunction(
-      session->GetCurrentFrameId(), kGetPageSource, args, value);
+  return web_view->GetPageSource(session->GetCurrentFrameId(), value);
 }
 
 Status ExecuteFindElement(int interval_ms,
@@ -961,15 +1104,30 @@ Status ExecuteFindElements(int interval_ms,
       interval_ms, false, NULL, session, web_view, params, value);
 }
 
+Status ExecuteFindElementsAllFrames(Session* session,
+                                    WebView* web_view,
+                                    const base::DictionaryValue& params,
+                                    std::unique_ptr<base::Value>* value,
+                                    Timeout* timeout) {
+  return FindElementsInAllFrames(session, web_view, params, value);
+}
+
 Status ExecuteGetCurrentUrl(Session* session,
                             WebView* web_view,
                             const base::DictionaryValue& params,
                             std::unique_ptr<base::Value>* value,
                             Timeout* timeout) {
   std::string url;
-  Status status = GetUrl(web_view, std::string(), &url);
-  if (status.IsError())
-    return status;
+  // Served from tracked navigation state when it is known to be current,
+  // so polling for SPA route changes costs no renderer round trip; the
+  // script evaluation remains the fallback whenever the tracker is in
+  // doubt (mid-load, fresh connection, non-tracking load strategy).
+  Status status(kOk);
+  if (!web_view->GetTrackedTopFrameUrl(&url)) {
+    status = GetUrl(web_view, std::string(), &url);
+    if (status.IsError())
+      return status;
+  }
   if (url == kUnreachableWebDataURL ||
       url == kDeprecatedUnreachableWebDataURL) {
     status = web_view->GetUrl(&url);
@@ -980,6 +1138,82 @@ Status ExecuteGetCurrentUrl(Session* session,
   return Status(kOk);
 }
 
+Status ExecutePollState(Session* session,
+                        WebView* web_view,
+                        const base::DictionaryValue& params,
+                        std::unique_ptr<base::Value>* value,
+                        Timeout* timeout) {
+  std::string last_hash;
+  params.GetString("lastValueHash", &last_hash);
+  int timeout_ms = 10000;
+  if (params.HasKey("timeout") &&
+      (!params.GetInteger("timeout", &timeout_ms) || timeout_ms < 0 ||
+       timeout_ms > 60000)) {
+    return Status(kInvalidArgument,
+                  "'timeout' must be between 0 and 60000 milliseconds");
+  }
+  Timeout deadline(base::TimeDelta::FromMilliseconds(timeout_ms));
+  const base::TimeDelta kTick = base::TimeDelta::FromMilliseconds(100);
+
+  while (true) {
+    Status status = web_view->HandleReceivedEvents();
+    if (status.IsError())
+      return status;
+
+    // The snapshot is built entirely from tracked state: the navigation
+    // tracker's top-frame url (with the browser-side url as fallback) and
+    // the target tracker's view list, which also carries titles. No
+    // renderer script runs however often clients poll.
+    auto snapshot = std::make_unique<base::DictionaryValue>();
+    std::string url;
+    if (!web_view->GetTrackedTopFrameUrl(&url)) {
+      status = web_view->GetUrl(&url);
+      if (status.IsError())
+        return status;
+    }
+    snapshot->SetString("url", url);
+    std::vector<WebViewInfo> views;
+    status =
+        session->chrome->GetWebViewsSummary(&views, session->w3c_compliant);
+    if (status.IsError())
+      return status;
+    auto handles = std::make_unique<base::ListValue>();
+    for (const WebViewInfo& view : views) {
+      if (view.id == web_view->GetId())
+        snapshot->SetString("title", view.title);
+      handles->AppendString(WebViewIdToWindowHandle(view.id));
+    }
+    snapshot->Set("handles", std::move(handles));
+
+    std::string serialized;
+    base::JSONWriter::Write(*snapshot, &serialized);
+    std::string hash = base::NumberToString(base::PersistentHash(serialized));
+    if (last_hash.empty() || hash != last_hash) {
+      snapshot->SetString("hash", hash);
+      *value = std::move(snapshot);
+      return Status(kOk);
+    }
+    if (deadline.IsExpired()) {
+      // Nothing changed before the deadline; answer with just the hash so
+      // an idle page costs one tiny response per poll interval.
+      auto unchanged = std::make_unique<base::DictionaryValue>();
+      unchanged->SetString("hash", hash);
+      unchanged->SetBoolean("unchanged", true);
+      *value = std::move(unchanged);
+      return Status(kOk);
+    }
+    // Block on the DevTools socket so a navigation or target event wakes
+    // the loop immediately; the tick bounds how stale state observed only
+    // through another client's events (e.g. a title update) can get.
+    status = web_view->HandleNextEvent(
+        Timeout(std::min(kTick, deadline.GetRemainingTime())));
+    if (status.IsError()) {
+      base::PlatformThread::Sleep(
+          std::min(kTick, deadline.GetRemainingTime()));
+    }
+  }
+}
+
 Status ExecuteGoBack(Session* session,
                      WebView* web_view,
                      const base::DictionaryValue& params,
@@ -1041,6 +1275,102 @@ Status ExecuteResume(Session* session,
   return Status(kOk);
 }
 
+Status ExecuteGetComputedLabels(Session* session,
+                                WebView* web_view,
+                                const base::DictionaryValue& params,
+                                std::unique_ptr<base::Value>* value,
+                                Timeout* timeout) {
+  const base::ListValue* elements = nullptr;
+  if (!params.GetList("elements", &elements))
+    return Status(kInvalidArgument, "'elements' must be a list of element ids");
+
+  // Resolve every element to its DOM node id first, then fetch all the
+  // fragments the cache cannot answer as one pipelined batch, so a
+  // page-wide audit costs one CDP round trip instead of one per element.
+  AXNodeCache* cache = web_view->GetAXNodeCache();
+  std::vector<int> node_ids;  // -1 where element resolution failed
+  node_ids.reserve(elements->GetSize());
+  for (const base::Value& id_value : elements->GetList()) {
+    int node_id = -1;
+    if (id_value.is_string() &&
+        !CheckElement(id_value.GetString()).IsError()) {
+      std::unique_ptr<base::DictionaryValue> element(
+          CreateElement(id_value.GetString()));
+      if (web_view
+              ->GetNodeIdByElement(session->GetCurrentFrameId(), *element,
+                                   &node_id)
+              .IsError()) {
+        node_id = -1;
+      }
+    }
+    node_ids.push_back(node_id);
+  }
+
+  std::map<int, base::Value> ax_nodes;
+  std::vector<int> to_fetch;
+  for (int node_id : node_ids) {
+    if (node_id < 0 || ax_nodes.count(node_id) ||
+        std::find(to_fetch.begin(), to_fetch.end(), node_id) !=
+            to_fetch.end()) {
+      continue;
+    }
+    base::Value cached;
+    if (cache && cache->GetAXNode(node_id, &cached))
+      ax_nodes.emplace(node_id, std::move(cached));
+    else
+      to_fetch.push_back(node_id);
+  }
+
+  if (!to_fetch.empty()) {
+    std::vector<std::unique_ptr<base::DictionaryValue>> params_storage;
+    std::vector<const base::DictionaryValue*> params_batch;
+    for (int node_id : to_fetch) {
+      auto body = std::make_unique<base::DictionaryValue>();
+      body->SetInteger("nodeId", node_id);
+      body->SetBoolean("fetchRelatives", false);
+      params_batch.push_back(body.get());
+      params_storage.push_back(std::move(body));
+    }
+    std::vector<std::unique_ptr<base::DictionaryValue>> batch_results;
+    Status status = web_view->SendCommandBatch(
+        "Accessibility.getPartialAXTree", params_batch, &batch_results);
+    if (status.IsError())
+      return status;
+    for (size_t i = 0; i < to_fetch.size() && i < batch_results.size(); ++i) {
+      // A null batch entry is a command-level failure for that node; it
+      // surfaces as a null entry in the response below.
+      if (!batch_results[i])
+        continue;
+      base::Value* nodes = batch_results[i]->FindListKey("nodes");
+      if (!nodes || nodes->GetList().size() != 1)
+        continue;
+      base::Value node = std::move(nodes->GetList()[0]);
+      if (cache)
+        cache->PutAXNode(to_fetch[i], node);
+      ax_nodes.emplace(to_fetch[i], std::move(node));
+    }
+  }
+
+  auto labels = std::make_unique<base::ListValue>();
+  for (int node_id : node_ids) {
+    auto it = node_id < 0 ? ax_nodes.end() : ax_nodes.find(node_id);
+    if (it == ax_nodes.end()) {
+      labels->Append(std::make_unique<base::Value>());
+      continue;
+    }
+    base::DictionaryValue entry;
+    const base::Value* label = it->second.FindPath("name.value");
+    entry.SetString("label",
+                    label && label->is_string() ? label->GetString() : "");
+    const base::Value* role = it->second.FindPath("role.value");
+    entry.SetString("role",
+                    role && role->is_string() ? role->GetString() : "");
+    labels->Append(std::make_unique<base::Value>(std::move(entry)));
+  }
+  *value = std::move(labels);
+  return Status(kOk);
+}
+
 Status ExecuteMouseMoveTo(Session* session,
                           WebView* web_view,
                           const base::DictionaryValue& params,
@@ -1212,7 +1542,7 @@ Status ExecuteTouchScroll(Session* session,
   if (!params.GetInteger("yoffset", &yoffset))
     return Status(kInvalidArgument, "'yoffset' must be an integer");
   return web_view->SynthesizeScrollGesture(
-      location.x, location.y, xoffset, yoffset);
+      location.x, location.y, xoffset, yoffset, 0);
 }
 
 Status ProcessInputActionSequence(
@@ -1528,6 +1858,34 @@ Status ProcessInputActionSequence(
   return Status(kOk);
 }
 
+namespace {
+
+// Implements the "computing the tick duration" algorithm from the W3C spec
+// (https://w3c.github.io/webdriver/#dfn-computing-the-tick-duration): the
+// longest "duration" among the tick's pause, pointerMove and scroll actions.
+int ComputeTickDuration(
+    const std::vector<std::vector<std::unique_ptr<base::DictionaryValue>>>&
+        actions_list,
+    size_t tick) {
+  int tick_duration = 0;
+  for (const auto& action_list : actions_list) {
+    if (action_list.size() <= tick)
+      continue;
+    const base::DictionaryValue* action = action_list[tick].get();
+    std::string action_type;
+    action->GetString("subtype", &action_type);
+    if (action_type == "pause" || action_type == "pointerMove" ||
+        action_type == "scroll") {
+      int duration = 0;
+      GetOptionalInt(action, "duration", &duration);
+      tick_duration = std::max(tick_duration, duration);
+    }
+  }
+  return tick_duration;
+}
+
+}  // namespace
+
 Status ExecutePerformActions(Session* session,
                              WebView* web_view,
                              const base::DictionaryValue& params,
@@ -1572,7 +1930,28 @@ Status ExecutePerformActions(Session* session,
         std::max(longest_action_list_size, actions_list[i].size());
   }
 
+  // Precompute the whole tick timeline up front. Each tick's events are
+  // stamped with the tick's intended start time, and the end-of-tick wait is
+  // measured against the timeline instead of slept in full, so time spent on
+  // DevTools round trips counts toward the tick duration rather than being
+  // added on top of it.
+  const base::TimeTicks timeline_start_ticks = base::TimeTicks::Now();
+  const base::Time timeline_start_time = base::Time::Now();
+  std::vector<base::TimeDelta> tick_deadlines;
+  tick_deadlines.reserve(longest_action_list_size);
+  base::TimeDelta timeline;
   for (size_t i = 0; i < longest_action_list_size; i++) {
+    timeline +=
+        base::TimeDelta::FromMilliseconds(ComputeTickDuration(actions_list, i));
+    tick_deadlines.push_back(timeline);
+  }
+
+  for (size_t i = 0; i < longest_action_list_size; i++) {
+    const base::TimeDelta tick_start =
+        i == 0 ? base::TimeDelta() : tick_deadlines[i - 1];
+    const double tick_timestamp =
+        (timeline_start_time + tick_start - base::Time::UnixEpoch())
+            .InSecondsF();
     // Find the last pointer action, and it has to be sent synchronously by
     // default.
     size_t last_action_index = 0;
@@ -1596,10 +1975,6 @@ Status ExecutePerformActions(Session* session,
       }
     }
 
-    // Implements "compute the tick duration" algorithm from W3C spec
-    // (https://w3c.github.io/webdriver/#dfn-computing-the-tick-duration).
-    // This is the duration for actions in one tick.
-    int tick_duration = 0;
     std::vector<TouchEvent> dispatch_touch_events;
     for (size_t j = 0; j < actions_list.size(); j++) {
       if (actions_list[j].size() > i) {
@@ -1642,12 +2017,6 @@ Status ExecutePerformActions(Session* session,
         }
 
         action->GetString("subtype", &action_type);
-        int duration = 0;
-        if (action_type == "pause") {
-          GetOptionalInt(action, "duration", &duration);
-          tick_duration = std::max(tick_duration, duration);
-        }
-
         if (type != "none") {
           bool async_dispatch_event = true;
           if (j == last_action_index) {
@@ -1675,6 +2044,11 @@ Status ExecutePerformActions(Session* session,
                   session->sticky_modifiers &= ~KeyToKeyModifiers(event.key);
                 }
 
+                // Stamp after the cancel-list copy above: the matching
+                // release is dispatched much later and must not reuse this
+                // tick's timestamp.
+                for (KeyEvent& key_event : dispatch_key_events)
+                  key_event.timestamp = tick_timestamp;
                 Status status = web_view->DispatchKeyEvents(
                     dispatch_key_events, async_dispatch_event);
                 if (status.IsError())
@@ -1717,10 +2091,6 @@ Status ExecutePerformActions(Session* session,
 
               action_locations[id] = gfx::Point(x, y);
 
-              duration = 0;
-              GetOptionalInt(action, "duration", &duration);
-              tick_duration = std::max(tick_duration, duration);
-
               if (action_type == "scroll") {
                 int delta_x = 0, delta_y = 0;
                 action->GetInteger("deltaX", &delta_x);
@@ -1737,6 +2107,7 @@ Status ExecutePerformActions(Session* session,
                 last_pressed_buttons[id] =
                     StringToModifierMouseButton(button_type[id]);
                 session->mouse_position = WebPoint(event.x, event.y);
+                event.timestamp = tick_timestamp;
                 dispatch_wheel_events.push_back(event);
                 Status status = web_view->DispatchMouseEvents(
                     dispatch_wheel_events, session->GetCurrentFrameId(),
@@ -1820,6 +2191,7 @@ Status ExecutePerformActions(Session* session,
                   }
                 }
                 event.force = pressure;
+                event.timestamp = tick_timestamp;
                 dispatch_mouse_events.push_back(event);
                 Status status = web_view->DispatchMouseEvents(
                     dispatch_mouse_events, session->GetCurrentFrameId(),
@@ -1851,6 +2223,7 @@ Status ExecutePerformActions(Session* session,
                 if (event.type == kPause)
                   event.type = kTouchMove;
                 event.id = j;
+                event.timestamp = tick_timestamp;
                 dispatch_touch_events.push_back(event);
               }
               if (j == last_touch_index) {
@@ -1869,20 +2242,39 @@ Status ExecutePerformActions(Session* session,
       }
     }
 
-    if (tick_duration > 0) {
-      base::PlatformThread::Sleep(
-          base::TimeDelta::FromMilliseconds(tick_duration));
-    }
+    // Wait out whatever remains of this tick on the precomputed timeline.
+    // Ticks whose duration was already consumed by dispatching do not sleep.
+    base::TimeDelta remaining =
+        tick_deadlines[i] - (base::TimeTicks::Now() - timeline_start_ticks);
+    if (remaining > base::TimeDelta())
+      base::PlatformThread::Sleep(remaining);
   }
 
   return Status(kOk);
 }
 
+namespace {
+
+// Dispatches the accumulated key events as one batch, in which only the last
+// event waits for an acknowledgement, and clears the batch.
+void FlushPendingKeyEvents(WebView* web_view, std::vector<KeyEvent>* events) {
+  if (events->empty())
+    return;
+  web_view->DispatchKeyEvents(*events, false);
+  events->clear();
+}
+
+}  // namespace
+
 Status ExecuteReleaseActions(Session* session,
                              WebView* web_view,
                              const base::DictionaryValue& params,
                              std::unique_ptr<base::Value>* value,
                              Timeout* timeout) {
+  // Consecutive key releases are batched so that each run of keys costs one
+  // DevTools round trip instead of one per key. Mouse and touch releases
+  // flush the batch first to preserve the overall event order.
+  std::vector<KeyEvent> pending_key_events;
   for (auto it = session->input_cancel_list.rbegin();
        it != session->input_cancel_list.rend(); ++it) {
     if (it->key_event) {
@@ -1890,9 +2282,10 @@ Status ExecuteReleaseActions(Session* session,
       it->input_state->GetDictionary("pressed", &pressed);
       if (!pressed->HasKey(it->key_event->key))
         continue;
-      web_view->DispatchKeyEvents({*it->key_event}, false);
+      pending_key_events.push_back(*it->key_event);
       pressed->Remove(it->key_event->key, nullptr);
     } else if (it->mouse_event) {
+      FlushPendingKeyEvents(web_view, &pending_key_events);
       int pressed = it->input_state->FindKey("pressed")->GetInt();
       int button_mask = 1 << it->mouse_event->button;
       if ((pressed & button_mask) == 0)
@@ -1901,6 +2294,7 @@ Status ExecuteReleaseActions(Session* session,
                                     session->GetCurrentFrameId(), false);
       it->input_state->SetInteger("pressed", pressed & ~button_mask);
     } else if (it->touch_event) {
+      FlushPendingKeyEvents(web_view, &pending_key_events);
       int pressed = it->input_state->FindKey("pressed")->GetInt();
       if (pressed == 0)
         continue;
@@ -1908,6 +2302,7 @@ Status ExecuteReleaseActions(Session* session,
       it->input_state->SetInteger("pressed", 0);
     }
   }
+  FlushPendingKeyEvents(web_view, &pending_key_events);
 
   session->input_cancel_list.clear();
   session->input_state_table.Clear();
@@ -1991,7 +2386,8 @@ Status ExecuteSendKeysToActiveElement(Session* session,
   if (!params.GetList("value", &key_list))
     return Status(kInvalidArgument, "'value' must be a list");
   return SendKeysOnWindow(
-      web_view, key_list, false, &session->sticky_modifiers);
+      web_view, key_list, false, &session->sticky_modifiers,
+      session->fast_typing);
 }
 
 Status ExecuteGetStorageItem(const char* storage,
@@ -2030,6 +2426,25 @@ Status ExecuteGetStorageKeys(const char* storage,
                                   value);
 }
 
+Status ExecuteGetStorageSnapshot(const char* storage,
+                                 Session* session,
+                                 WebView* web_view,
+                                 const base::DictionaryValue& params,
+                                 std::unique_ptr<base::Value>* value,
+                                 Timeout* timeout) {
+  const char script[] =
+      "var items = {};"
+      "var storage = %s;"
+      "for (var i = 0; i < storage.length; i++) {"
+      "  var key = storage.key(i);"
+      "  items[key] = storage.getItem(key);"
+      "}"
+      "items";
+  return web_view->EvaluateScript(session->GetCurrentFrameId(),
+                                  base::StringPrintf(script, storage), false,
+                                  value);
+}
+
 Status ExecuteSetStorageItem(const char* storage,
                              Session* session,
                              WebView* web_view,
@@ -2052,6 +2467,32 @@ Status ExecuteSetStorageItem(const char* storage,
       value);
 }
 
+Status ExecuteSetStorageItems(const char* storage,
+                              Session* session,
+                              WebView* web_view,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value,
+                              Timeout* timeout) {
+  const base::DictionaryValue* items;
+  if (!params.GetDictionary("items", &items))
+    return Status(kInvalidArgument, "'items' must be a dictionary");
+  for (base::DictionaryValue::Iterator it(*items); !it.IsAtEnd();
+       it.Advance()) {
+    if (!it.value().is_string())
+      return Status(kInvalidArgument, "each value of 'items' must be a string");
+  }
+  base::ListValue args;
+  args.Append(items->Clone());
+  return web_view->CallFunction(
+      session->GetCurrentFrameId(),
+      base::StringPrintf("function(items) {"
+                         "  for (var key in items)"
+                         "    %s.setItem(key, items[key]);"
+                         "}",
+                         storage),
+      args, value);
+}
+
 Status ExecuteRemoveStorageItem(const char* storage,
                                 Session* session,
                                 WebView* web_view,
@@ -2097,12 +2538,17 @@ Status ExecuteScreenshot(Session* session,
                          const base::DictionaryValue& params,
                          std::unique_ptr<base::Value>* value,
                          Timeout* timeout) {
-  Status status = session->chrome->ActivateWebView(web_view->GetId());
+  Status status = session->chrome->ActivateWebView(web_view->GetId(), false);
+  if (status.IsError())
+    return status;
+
+  base::DictionaryValue capture_params;
+  status = ParseScreenshotCaptureParams(params, &capture_params);
   if (status.IsError())
     return status;
 
   std::string screenshot;
-  status = web_view->CaptureScreenshot(&screenshot, base::DictionaryValue());
+  status = web_view->CaptureScreenshot(&screenshot, capture_params);
   if (status.IsError()) {
     if (status.code() == kUnexpectedAlertOpen) {
       LOG(WARNING) << status.message() << ", cancelling screenshot";
@@ -2112,12 +2558,12 @@ Status ExecuteScreenshot(Session* session,
       return Status(kUnexpectedAlertOpen_Keep);
     }
     LOG(WARNING) << "screenshot failed, retrying " << status.message();
-    status = web_view->CaptureScreenshot(&screenshot, base::DictionaryValue());
+    status = web_view->CaptureScreenshot(&screenshot, capture_params);
   }
   if (status.IsError())
     return status;
 
-  *value = std::make_unique<base::Value>(screenshot);
+  *value = std::make_unique<base::Value>(std::move(screenshot));
   return Status(kOk);
 }
 
@@ -2126,7 +2572,13 @@ Status ExecuteFullPageScreenshot(Session* session,
                                  const base::DictionaryValue& params,
                                  std::unique_ptr<base::Value>* value,
                                  Timeout* timeout) {
-  Status status = session->chrome->ActivateWebView(web_view->GetId());
+  Status status = session->chrome->ActivateWebView(web_view->GetId(), false);
+  if (status.IsError())
+    return status;
+
+  // Reject bad encoding options before overriding the device metrics.
+  base::DictionaryValue capture_params;
+  status = ParseScreenshotCaptureParams(params, &capture_params);
   if (status.IsError())
     return status;
 
@@ -2173,7 +2625,7 @@ Status ExecuteFullPageScreenshot(Session* session,
   std::string screenshot;
   // No need to supply clip as it would be default to the device metrics
   // parameters
-  status = web_view->CaptureScreenshot(&screenshot, base::DictionaryValue());
+  status = web_view->CaptureScreenshot(&screenshot, capture_params);
   if (status.IsError()) {
     if (status.code() == kUnexpectedAlertOpen) {
       LOG(WARNING) << status.message() << ", cancelling screenshot";
@@ -2183,12 +2635,12 @@ Status ExecuteFullPageScreenshot(Session* session,
       return Status(kUnexpectedAlertOpen_Keep);
     }
     LOG(WARNING) << "screenshot failed, retrying " << status.message();
-    status = web_view->CaptureScreenshot(&screenshot, base::DictionaryValue());
+    status = web_view->CaptureScreenshot(&screenshot, capture_params);
   }
   if (status.IsError())
     return status;
 
-  *value = std::make_unique<base::Value>(screenshot);
+  *value = std::make_unique<base::Value>(std::move(screenshot));
 
   // Check if there is already deviceMetricsOverride in use,
   // if so, restore to that instead
@@ -2257,7 +2709,10 @@ Status ExecutePrint(Session* session,
   printParams.SetDouble("marginRight", margin.right);
   printParams.SetBoolean("preferCSSPageSize", !shrinkToFit);
   printParams.SetString("pageRanges", pageRanges);
-  printParams.SetString("transferMode", "ReturnAsBase64");
+  // Stream the document over IO.read instead of receiving it as a single
+  // DevTools message, which for large PDFs stalls the IO thread and holds
+  // several copies of the document in memory at once.
+  printParams.SetString("transferMode", "ReturnAsStream");
 
   std::string pdf;
   status = web_view->PrintToPDF(printParams, &pdf);
@@ -2268,6 +2723,20 @@ Status ExecutePrint(Session* session,
   return Status(kOk);
 }
 
+Status ExecuteCaptureSnapshot(Session* session,
+                              WebView* web_view,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value,
+                              Timeout* timeout) {
+  std::string mhtml;
+  Status status = web_view->CaptureSnapshot(&mhtml);
+  if (status.IsError())
+    return status;
+
+  *value = std::make_unique<base::Value>(std::move(mhtml));
+  return Status(kOk);
+}
+
 Status ExecuteGetCookies(Session* session,
                          WebView* web_view,
                          const base::DictionaryValue& params,
@@ -2303,7 +2772,7 @@ Status ExecuteGetNamedCookie(Session* session,
   for (std::list<Cookie>::const_iterator it = cookies.begin();
        it != cookies.end(); ++it) {
     if (name == it->name) {
-      value->reset(CreateDictionaryFrom(*it)->DeepCopy());
+      *value = CreateDictionaryFrom(*it);
       return Status(kOk);
     }
   }
@@ -2318,74 +2787,62 @@ Status ExecuteAddCookie(Session* session,
   const base::DictionaryValue* cookie;
   if (!params.GetDictionary("cookie", &cookie))
     return Status(kInvalidArgument, "missing 'cookie'");
-  std::string name;
-  std::string cookie_value;
-  if (!cookie->GetString("name", &name))
-    return Status(kInvalidArgument, "missing 'name'");
-  if (!cookie->GetString("value", &cookie_value))
-    return Status(kInvalidArgument, "missing 'value'");
   std::string url;
   Status status = GetUrl(web_view, session->GetCurrentFrameId(), &url);
   if (status.IsError())
     return status;
-  if (!base::StartsWith(url, "http://", base::CompareCase::INSENSITIVE_ASCII) &&
-      !base::StartsWith(url, "https://",
-                        base::CompareCase::INSENSITIVE_ASCII) &&
-      !base::StartsWith(url, "ftp://", base::CompareCase::INSENSITIVE_ASCII))
+  if (!UrlSupportsCookies(url))
     return Status(kInvalidCookieDomain);
-  std::string domain;
-  if (!GetOptionalString(cookie, "domain", &domain))
-    return Status(kInvalidArgument, "invalid 'domain'");
-  if (session->w3c_compliant && !domain.empty() &&
-      !url::HostIsIPAddress(domain)) {
-    if (domain[0] == '.')
-      domain = domain.substr(1);
-
-    if (domain.size() < 2)
-      return Status(kInvalidCookieDomain, "invalid 'domain'");
+  ParsedCookie parsed;
+  status = ParseCookie(session, *cookie, url, &parsed);
+  if (status.IsError())
+    return status;
+  return web_view->AddCookie(parsed.name, url, parsed.value, parsed.domain,
+                             parsed.path, parsed.same_site, parsed.secure,
+                             parsed.http_only, parsed.expiry);
+}
 
-    if (!GURL(url).DomainIs(domain))
-      return Status(kInvalidCookieDomain, "Cookie 'domain' mismatch");
+Status ExecuteSetCookies(Session* session,
+                         WebView* web_view,
+                         const base::DictionaryValue& params,
+                         std::unique_ptr<base::Value>* value,
+                         Timeout* timeout) {
+  const base::ListValue* cookies;
+  if (!params.GetList("cookies", &cookies))
+    return Status(kInvalidArgument, "missing 'cookies'");
+  std::string url;
+  Status status = GetUrl(web_view, session->GetCurrentFrameId(), &url);
+  if (status.IsError())
+    return status;
+  if (!UrlSupportsCookies(url))
+    return Status(kInvalidCookieDomain);
 
-    domain.insert(0, 1, '.');
-  }
-  std::string path("/");
-  if (!GetOptionalString(cookie, "path", &path))
-    return Status(kInvalidArgument, "invalid 'path'");
-  std::string samesite("");
-  if (!GetOptionalString(cookie, "sameSite", &samesite))
-    return Status(kInvalidArgument, "invalid 'sameSite'");
-  if (!samesite.empty() && samesite != "Strict" && samesite != "Lax" &&
-      samesite != "None")
-    return Status(kInvalidArgument, "invalid 'sameSite'");
-  bool secure = false;
-  if (!GetOptionalBool(cookie, "secure", &secure))
-    return Status(kInvalidArgument, "invalid 'secure'");
-  bool httpOnly = false;
-  if (!GetOptionalBool(cookie, "httpOnly", &httpOnly))
-    return Status(kInvalidArgument, "invalid 'httpOnly'");
-  double expiry;
-  bool has_value;
-  if (session->w3c_compliant) {
-    // W3C spec says expiry is a safe integer.
-    int64_t expiry_int64;
-    if (!GetOptionalSafeInt(cookie, "expiry", &expiry_int64, &has_value) ||
-        (has_value && expiry_int64 < 0))
-      return Status(kInvalidArgument, "invalid 'expiry'");
-    // Use negative value to indicate expiry not specified.
-    expiry = has_value ? static_cast<double>(expiry_int64) : -1.0;
-  } else {
-    // JSON wire protocol didn't specify the type of expiry, but ChromeDriver
-    // has always accepted double, so we keep that in legacy mode.
-    if (!GetOptionalDouble(cookie, "expiry", &expiry, &has_value) ||
-        (has_value && expiry < 0))
-      return Status(kInvalidArgument, "invalid 'expiry'");
-    if (!has_value)
-      expiry = (base::Time::Now() - base::Time::UnixEpoch()).InSeconds() +
-               kDefaultCookieExpiryTime;
+  // Validate the whole batch up front, so an invalid entry rejects the
+  // command before any cookie is set.
+  base::ListValue cdp_cookies;
+  for (size_t i = 0; i < cookies->GetSize(); ++i) {
+    const base::DictionaryValue* cookie;
+    if (!cookies->GetDictionary(i, &cookie))
+      return Status(kInvalidArgument, "each entry of 'cookies' must be a dict");
+    ParsedCookie parsed;
+    status = ParseCookie(session, *cookie, url, &parsed);
+    if (status.IsError())
+      return status;
+    base::DictionaryValue cdp_cookie;
+    cdp_cookie.SetString("name", parsed.name);
+    cdp_cookie.SetString("value", parsed.value);
+    cdp_cookie.SetString("url", url);
+    cdp_cookie.SetString("domain", parsed.domain);
+    cdp_cookie.SetString("path", parsed.path);
+    cdp_cookie.SetBoolean("secure", parsed.secure);
+    cdp_cookie.SetBoolean("httpOnly", parsed.http_only);
+    if (!parsed.same_site.empty())
+      cdp_cookie.SetString("sameSite", parsed.same_site);
+    if (parsed.expiry >= 0)
+      cdp_cookie.SetDouble("expires", parsed.expiry);
+    cdp_cookies.Append(std::move(cdp_cookie));
   }
-  return web_view->AddCookie(name, url, cookie_value, domain, path, samesite,
-                             secure, httpOnly, expiry);
+  return web_view->SetCookies(cdp_cookies);
 }
 
 Status ExecuteDeleteCookie(Session* session,
@@ -2419,6 +2876,45 @@ Status ExecuteDeleteCookie(Session* session,
   return Status(kOk);
 }
 
+Status ExecuteDeleteCookies(Session* session,
+                            WebView* web_view,
+                            const base::DictionaryValue& params,
+                            std::unique_ptr<base::Value>* value,
+                            Timeout* timeout) {
+  const base::ListValue* names;
+  if (!params.GetList("names", &names))
+    return Status(kInvalidArgument, "missing 'names'");
+  std::vector<std::string> cookie_names;
+  for (const base::Value& name : names->GetList()) {
+    if (!name.is_string())
+      return Status(kInvalidArgument, "each entry of 'names' must be a string");
+    cookie_names.push_back(name.GetString());
+  }
+  std::string url;
+  Status status = GetUrl(web_view, session->GetCurrentFrameId(), &url);
+  if (status.IsError())
+    return status;
+
+  // The visible cookies are fetched once for the whole batch. DevTools has no
+  // plural delete, so a command per matching cookie still goes out, but the
+  // per-name HTTP round trips are gone.
+  std::list<Cookie> cookies;
+  status = GetVisibleCookies(session, web_view, &cookies);
+  if (status.IsError())
+    return status;
+
+  for (std::list<Cookie>::const_iterator it = cookies.begin();
+       it != cookies.end(); ++it) {
+    if (std::find(cookie_names.begin(), cookie_names.end(), it->name) ==
+        cookie_names.end())
+      continue;
+    status = web_view->DeleteCookie(it->name, url, it->domain, it->path);
+    if (status.IsError())
+      return status;
+  }
+  return Status(kOk);
+}
+
 Status ExecuteDeleteAllCookies(Session* session,
                                WebView* web_view,
                                const base::DictionaryValue& params,
@@ -2541,20 +3037,10 @@ Status ExecuteDeleteNetworkConditions(Session* session,
                                       const base::DictionaryValue& params,
                                       std::unique_ptr<base::Value>* value,
                                       Timeout* timeout) {
-  // Chrome does not have any command to stop overriding network conditions, so
-  // we just override the network conditions with the "No throttling" preset.
-  NetworkConditions network_conditions;
-  // Get conditions from preset list.
-  Status status = FindPresetNetwork("No throttling", &network_conditions);
-  if (status.IsError())
-    return status;
-
-  status = web_view->OverrideNetworkConditions(network_conditions);
+  Status status = web_view->RemoveNetworkConditionsOverride();
   if (status.IsError())
     return status;
 
-  // After we've successfully overridden the network conditions with
-  // "No throttling", we can delete them from |session|.
   session->overridden_network_conditions.reset();
   return status;
 }
@@ -2564,9 +3050,56 @@ Status ExecuteTakeHeapSnapshot(Session* session,
                                const base::DictionaryValue& params,
                                std::unique_ptr<base::Value>* value,
                                Timeout* timeout) {
+  // With saveToFile, the snapshot is streamed to a temporary file on the
+  // machine running ChromeDriver and its path is returned, so the snapshot
+  // is never held in the driver's memory as one large string.
+  bool save_to_file = false;
+  if (params.GetBoolean("saveToFile", &save_to_file) && save_to_file) {
+    base::FilePath snapshot_path;
+    Status status = web_view->TakeHeapSnapshotToFile(&snapshot_path);
+    if (status.IsError())
+      return status;
+    *value = std::make_unique<base::Value>(snapshot_path.AsUTF8Unsafe());
+    return Status(kOk);
+  }
   return web_view->TakeHeapSnapshot(value);
 }
 
+Status ExecuteExtractContent(Session* session,
+                             WebView* web_view,
+                             const base::DictionaryValue& params,
+                             std::unique_ptr<base::Value>* value,
+                             Timeout* timeout) {
+  const base::ListValue* selector_list = nullptr;
+  if (!params.GetList("selectors", &selector_list) ||
+      selector_list->GetSize() == 0)
+    return Status(kInvalidArgument, "'selectors' must be a non-empty list");
+  std::vector<std::string> selectors;
+  for (const base::Value& entry : selector_list->GetList()) {
+    if (!entry.is_string())
+      return Status(kInvalidArgument, "'selectors' entries must be strings");
+    selectors.push_back(entry.GetString());
+  }
+
+  base::DictionaryValue capture_params;
+  capture_params.Set("computedStyles", std::make_unique<base::ListValue>());
+  std::unique_ptr<base::Value> snapshot;
+  Status status = web_view->SendCommandAndGetResult(
+      "DOMSnapshot.captureSnapshot", capture_params, &snapshot);
+  if (status.IsError())
+    return status;
+  const base::DictionaryValue* snapshot_dict = nullptr;
+  if (!snapshot || !snapshot->GetAsDictionary(&snapshot_dict))
+    return Status(kUnknownError, "no result from DOMSnapshot.captureSnapshot");
+
+  std::unique_ptr<base::ListValue> matches;
+  status = ExtractContentFromSnapshot(*snapshot_dict, selectors, &matches);
+  if (status.IsError())
+    return status;
+  *value = std::move(matches);
+  return Status(kOk);
+}
+
 Status ExecuteGetWindowRect(Session* session,
                             WebView* web_view,
                             const base::DictionaryValue& params,
@@ -2582,7 +3115,7 @@ Status ExecuteGetWindowRect(Session* session,
   rect.SetInteger("y", windowRect.y);
   rect.SetInteger("width", windowRect.width);
   rect.SetInteger("height", windowRect.height);
-  value->reset(rect.DeepCopy());
+  *value = base::Value::ToUniquePtrValue(std::move(rect));
   return Status(kOk);
 }
 
@@ -2683,6 +3216,67 @@ Status ExecuteFullScreenWindow(Session* session,
   return ExecuteGetWindowRect(session, web_view, params, value, timeout);
 }
 
+Status ExecuteStartScreencast(Session* session,
+                              WebView* web_view,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value,
+                              Timeout* timeout) {
+  // Like ExecuteScreenshot, make sure the target tab is visible; a hidden
+  // tab produces no screencast frames.
+  Status status = session->chrome->ActivateWebView(web_view->GetId(), false);
+  if (status.IsError())
+    return status;
+  return web_view->StartScreencast(params);
+}
+
+Status ExecuteStopScreencast(Session* session,
+                             WebView* web_view,
+                             const base::DictionaryValue& params,
+                             std::unique_ptr<base::Value>* value,
+                             Timeout* timeout) {
+  return web_view->StopScreencast();
+}
+
+Status ExecuteScreenshotDelta(Session* session,
+                              WebView* web_view,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value,
+                              Timeout* timeout) {
+  int last_frame_id = 0;
+  if (params.HasKey("lastFrameId") &&
+      !params.GetInteger("lastFrameId", &last_frame_id))
+    return Status(kInvalidArgument, "'lastFrameId' must be an integer");
+  // Like ExecuteScreenshot, make sure the target tab is visible; a hidden
+  // tab neither paints nor produces damage.
+  Status status = session->chrome->ActivateWebView(web_view->GetId(), false);
+  if (status.IsError())
+    return status;
+  std::unique_ptr<base::DictionaryValue> delta;
+  status = web_view->CaptureScreenshotDelta(last_frame_id, &delta);
+  if (status.IsError())
+    return status;
+  *value = std::move(delta);
+  return Status(kOk);
+}
+
+Status ExecuteScreencastFrame(Session* session,
+                              WebView* web_view,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value,
+                              Timeout* timeout) {
+  std::string data;
+  double timestamp = 0;
+  Status status = web_view->GetScreencastFrame(&data, &timestamp);
+  if (status.IsError())
+    return status;
+
+  auto result = std::make_unique<base::DictionaryValue>();
+  result->SetKey("data", base::Value(std::move(data)));
+  result->SetDoubleKey("timestamp", timestamp);
+  *value = std::move(result);
+  return Status(kOk);
+}
+
 Status ExecuteSetSinkToUse(Session* session,
                            WebView* web_view,
                            const base::DictionaryValue& params,
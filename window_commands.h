@@ -107,6 +107,16 @@ Status ExecuteFindElements(int interval_ms,
                            std::unique_ptr<base::Value>* value,
                            Timeout* timeout);
 
+// Search for elements matching the locator in every frame of the target
+// at once (non-standard). Returns one {"frame", "value"} entry per frame
+// with hits; element references in each entry are only usable while that
+// frame is the session's current frame.
+Status ExecuteFindElementsAllFrames(Session* session,
+                                    WebView* web_view,
+                                    const base::DictionaryValue& params,
+                                    std::unique_ptr<base::Value>* value,
+                                    Timeout* timeout);
+
 // Get the current page url.
 Status ExecuteGetCurrentUrl(Session* session,
                             WebView* web_view,
@@ -114,6 +124,18 @@ Status ExecuteGetCurrentUrl(Session* session,
                             std::unique_ptr<base::Value>* value,
                             Timeout* timeout);
 
+// Vendor long-poll replacement for tight GetCurrentUrl/GetTitle/
+// GetWindowHandles loops. Returns the current url, title and window handles
+// together with a hash of that snapshot; when the request carries the hash
+// of the last value seen ("lastValueHash"), the command instead blocks until
+// the snapshot changes or a deadline passes, so redundant polls park on
+// DevTools events rather than re-evaluating unchanged state.
+Status ExecutePollState(Session* session,
+                        WebView* web_view,
+                        const base::DictionaryValue& params,
+                        std::unique_ptr<base::Value>* value,
+                        Timeout* timeout);
+
 // Navigate backward in the browser history.
 Status ExecuteGoBack(Session* session,
                      WebView* web_view,
@@ -149,6 +171,15 @@ Status ExecuteResume(Session* session,
                      std::unique_ptr<base::Value>* value,
                      Timeout* timeout);
 
+// Returns the computed label and role for every element id in the
+// "elements" list parameter, fetched in one DevTools exchange. Elements
+// that cannot be resolved yield a null entry instead of failing the batch.
+Status ExecuteGetComputedLabels(Session* session,
+                                WebView* web_view,
+                                const base::DictionaryValue& params,
+                                std::unique_ptr<base::Value>* value,
+                                Timeout* timeout);
+
 // Move the mouse by an offset of the element if specified .
 Status ExecuteMouseMoveTo(Session* session,
                           WebView* web_view,
@@ -257,6 +288,14 @@ Status ExecuteGetStorageKeys(const char* storage,
                              std::unique_ptr<base::Value>* value,
                              Timeout* timeout);
 
+// Returns the whole storage as a key/value dictionary in one evaluation.
+Status ExecuteGetStorageSnapshot(const char* storage,
+                                 Session* session,
+                                 WebView* web_view,
+                                 const base::DictionaryValue& params,
+                                 std::unique_ptr<base::Value>* value,
+                                 Timeout* timeout);
+
 Status ExecuteSetStorageItem(const char* storage,
                              Session* session,
                              WebView* web_view,
@@ -264,6 +303,14 @@ Status ExecuteSetStorageItem(const char* storage,
                              std::unique_ptr<base::Value>* value,
                              Timeout* timeout);
 
+// Applies the 'items' key/value dictionary to the storage in one script.
+Status ExecuteSetStorageItems(const char* storage,
+                              Session* session,
+                              WebView* web_view,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value,
+                              Timeout* timeout);
+
 Status ExecuteRemoveStorageItem(const char* storage,
                                 Session* session,
                                 WebView* web_view,
@@ -303,6 +350,14 @@ Status ExecutePrint(Session* session,
                     std::unique_ptr<base::Value>* value,
                     Timeout* timeout);
 
+// Capture the page as a single MHTML archive, including subframes and
+// resources, in one round trip.
+Status ExecuteCaptureSnapshot(Session* session,
+                              WebView* web_view,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value,
+                              Timeout* timeout);
+
 // Retrieve all cookies visible to the current page.
 Status ExecuteGetCookies(Session* session,
                          WebView* web_view,
@@ -325,6 +380,14 @@ Status ExecuteAddCookie(Session* session,
                         std::unique_ptr<base::Value>* value,
                         Timeout* timeout);
 
+// Set multiple cookies with one DevTools command. Each entry of the 'cookies'
+// parameter is validated like ExecuteAddCookie's single cookie.
+Status ExecuteSetCookies(Session* session,
+                         WebView* web_view,
+                         const base::DictionaryValue& params,
+                         std::unique_ptr<base::Value>* value,
+                         Timeout* timeout);
+
 // Delete the cookie with the given name if it exists in the current page.
 Status ExecuteDeleteCookie(Session* session,
                            WebView* web_view,
@@ -332,6 +395,14 @@ Status ExecuteDeleteCookie(Session* session,
                            std::unique_ptr<base::Value>* value,
                            Timeout* timeout);
 
+// Delete the cookies with the given names, fetching the visible cookies once
+// for the whole batch.
+Status ExecuteDeleteCookies(Session* session,
+                            WebView* web_view,
+                            const base::DictionaryValue& params,
+                            std::unique_ptr<base::Value>* value,
+                            Timeout* timeout);
+
 // Delete all cookies visible to the current page.
 Status ExecuteDeleteAllCookies(Session* session,
                                WebView* web_view,
@@ -363,6 +434,16 @@ Status ExecuteTakeHeapSnapshot(Session* session,
                                std::unique_ptr<base::Value>* value,
                                Timeout* timeout);
 
+// Returns text content, attributes, and layout rects for every element
+// matching each entry of the 'selectors' list, decoded from one
+// DOMSnapshot.captureSnapshot exchange; see
+// chrome/dom_snapshot_extractor.h for the supported selector subset.
+Status ExecuteExtractContent(Session* session,
+                             WebView* web_view,
+                             const base::DictionaryValue& params,
+                             std::unique_ptr<base::Value>* value,
+                             Timeout* timeout);
+
 Status ExecutePerformActions(Session* session,
                              WebView* web_view,
                              const base::DictionaryValue& params,
@@ -410,6 +491,39 @@ Status ExecuteFullScreenWindow(Session* session,
                                std::unique_ptr<base::Value>* value,
                                Timeout* timeout);
 
+// Starts a screencast that keeps the most recent frame buffered in the web
+// view. |params| are parameters for Page.startScreencast.
+Status ExecuteStartScreencast(Session* session,
+                              WebView* web_view,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value,
+                              Timeout* timeout);
+
+// Stops the screencast started by ExecuteStartScreencast.
+Status ExecuteStopScreencast(Session* session,
+                             WebView* web_view,
+                             const base::DictionaryValue& params,
+                             std::unique_ptr<base::Value>* value,
+                             Timeout* timeout);
+
+// Captures only the regions repainted since the client's last acknowledged
+// frame, identified by the optional "lastFrameId" param. Returns "frameId"
+// plus either per-rect images or a full frame when a resync is needed; see
+// WebView::CaptureScreenshotDelta.
+Status ExecuteScreenshotDelta(Session* session,
+                              WebView* web_view,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value,
+                              Timeout* timeout);
+
+// Returns the buffered screencast frame as base64-encoded image "data" plus
+// its capture "timestamp", without a DevTools round trip.
+Status ExecuteScreencastFrame(Session* session,
+                              WebView* web_view,
+                              const base::DictionaryValue& params,
+                              std::unique_ptr<base::Value>* value,
+                              Timeout* timeout);
+
 // Sets the sink to be used when the web page invokes Presentation or Remote
 // Playback API. Uses the "sinkName" value in |params|.
 Status ExecuteSetSinkToUse(Session* session,
@@ -4,6 +4,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/values.h"
 #include "chrome/test/chromedriver/chrome/mobile_emulation_override_manager.h"
@@ -102,6 +103,52 @@ TEST(WindowCommandsTest, ExecuteSendCommandAndGetResult_NoParams) {
   ASSERT_NE(status.message().find("params not passed"), std::string::npos);
 }
 
+TEST(WindowCommandsTest, ExecutePollState_ReturnsSnapshot) {
+  base::DictionaryValue params;
+  std::unique_ptr<base::Value> result;
+  Status status = CallWindowCommand(ExecutePollState, params, &result);
+  ASSERT_EQ(kOk, status.code());
+  const base::DictionaryValue* dict;
+  ASSERT_TRUE(result->GetAsDictionary(&dict));
+  ASSERT_TRUE(dict->HasKey("url"));
+  ASSERT_TRUE(dict->HasKey("handles"));
+  std::string hash;
+  ASSERT_TRUE(dict->GetString("hash", &hash));
+  ASSERT_FALSE(hash.empty());
+}
+
+TEST(WindowCommandsTest, ExecutePollState_UnchangedStateWaitsForDeadline) {
+  base::DictionaryValue params;
+  std::unique_ptr<base::Value> first;
+  Status status = CallWindowCommand(ExecutePollState, params, &first);
+  ASSERT_EQ(kOk, status.code());
+  const base::DictionaryValue* first_dict;
+  ASSERT_TRUE(first->GetAsDictionary(&first_dict));
+  std::string hash;
+  ASSERT_TRUE(first_dict->GetString("hash", &hash));
+
+  params.SetString("lastValueHash", hash);
+  params.SetInteger("timeout", 0);
+  std::unique_ptr<base::Value> second;
+  status = CallWindowCommand(ExecutePollState, params, &second);
+  ASSERT_EQ(kOk, status.code());
+  const base::DictionaryValue* second_dict;
+  ASSERT_TRUE(second->GetAsDictionary(&second_dict));
+  bool unchanged = false;
+  ASSERT_TRUE(second_dict->GetBoolean("unchanged", &unchanged));
+  ASSERT_TRUE(unchanged);
+  std::string second_hash;
+  ASSERT_TRUE(second_dict->GetString("hash", &second_hash));
+  ASSERT_EQ(hash, second_hash);
+}
+
+TEST(WindowCommandsTest, ExecutePollState_InvalidTimeout) {
+  base::DictionaryValue params;
+  params.SetInteger("timeout", -1);
+  Status status = CallWindowCommand(ExecutePollState, params);
+  ASSERT_EQ(kInvalidArgument, status.code());
+}
+
 TEST(WindowCommandsTest, ProcessInputActionSequencePointerMouse) {
   Session session("1");
   std::vector<std::unique_ptr<base::DictionaryValue>> action_list;
@@ -374,6 +421,158 @@ TEST(WindowCommandsTest, ExecuteAddCookie_SameSiteNotSet) {
 
 namespace {
 
+class BulkCookieWebView : public AddCookieWebView {
+ public:
+  explicit BulkCookieWebView(std::string document_url)
+      : AddCookieWebView(std::move(document_url)) {}
+
+  Status SetCookies(const base::ListValue& cookies) override {
+    set_cookies_ = cookies.Clone();
+    return Status(kOk);
+  }
+
+  Status GetCookies(std::unique_ptr<base::ListValue>* cookies,
+                    const std::string& current_page_url) override {
+    *cookies = base::ListValue::From(visible_cookies_.CreateDeepCopy());
+    return Status(kOk);
+  }
+
+  Status DeleteCookie(const std::string& name,
+                      const std::string& url,
+                      const std::string& domain,
+                      const std::string& path) override {
+    deleted_names_.push_back(name);
+    return Status(kOk);
+  }
+
+  base::Value set_cookies_{base::Value::Type::LIST};
+  base::ListValue visible_cookies_;
+  std::vector<std::string> deleted_names_;
+};
+
+base::Value MakeCookieDict(const std::string& name, const std::string& value) {
+  base::Value cookie(base::Value::Type::DICTIONARY);
+  cookie.SetStringKey("name", name);
+  cookie.SetStringKey("value", value);
+  return cookie;
+}
+
+}  // namespace
+
+namespace {
+
+class StoreStorageWebView : public StubWebView {
+ public:
+  StoreStorageWebView() : StubWebView("1") {}
+  ~StoreStorageWebView() override = default;
+
+  Status CallFunction(const std::string& frame,
+                      const std::string& function,
+                      const base::ListValue& args,
+                      std::unique_ptr<base::Value>* result) override {
+    function_ = function;
+    args_ = args.Clone();
+    return Status(kOk);
+  }
+
+  std::string function_;
+  base::Value args_{base::Value::Type::LIST};
+};
+
+}  // namespace
+
+TEST(WindowCommandsTest, ExecuteSetStorageItems_AppliesDictInOneCall) {
+  StoreStorageWebView webview;
+  MockChrome* chrome = new MockChrome();
+  Session session("id", std::unique_ptr<Chrome>(chrome));
+  base::DictionaryValue params;
+  base::Value items(base::Value::Type::DICTIONARY);
+  items.SetStringKey("key1", "value1");
+  items.SetStringKey("key2", "value2");
+  params.SetKey("items", std::move(items));
+  std::unique_ptr<base::Value> result_value;
+  Timeout timeout;
+  Status status = ExecuteSetStorageItems("localStorage", &session, &webview,
+                                         params, &result_value, &timeout);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  EXPECT_NE(std::string::npos, webview.function_.find("localStorage.setItem"));
+  ASSERT_EQ(1u, webview.args_.GetList().size());
+  EXPECT_EQ("value1", *webview.args_.GetList()[0].FindStringKey("key1"));
+  EXPECT_EQ("value2", *webview.args_.GetList()[0].FindStringKey("key2"));
+}
+
+TEST(WindowCommandsTest, ExecuteSetStorageItems_NonStringValueRejected) {
+  StoreStorageWebView webview;
+  MockChrome* chrome = new MockChrome();
+  Session session("id", std::unique_ptr<Chrome>(chrome));
+  base::DictionaryValue params;
+  base::Value items(base::Value::Type::DICTIONARY);
+  items.SetIntKey("key1", 1);
+  params.SetKey("items", std::move(items));
+  std::unique_ptr<base::Value> result_value;
+  Timeout timeout;
+  Status status = ExecuteSetStorageItems("localStorage", &session, &webview,
+                                         params, &result_value, &timeout);
+  ASSERT_EQ(kInvalidArgument, status.code()) << status.message();
+  EXPECT_TRUE(webview.function_.empty());
+}
+
+TEST(WindowCommandsTest, ExecuteSetCookies_Valid) {
+  BulkCookieWebView webview("http://chromium.org");
+  base::DictionaryValue params;
+  base::Value cookie_list(base::Value::Type::LIST);
+  cookie_list.Append(MakeCookieDict("cookie1", "value1"));
+  cookie_list.Append(MakeCookieDict("cookie2", "value2"));
+  params.SetKey("cookies", std::move(cookie_list));
+  std::unique_ptr<base::Value> result_value;
+  Status status =
+      CallWindowCommand(ExecuteSetCookies, &webview, params, &result_value);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  // All cookies arrive in one call, each bound to the document URL.
+  ASSERT_EQ(2u, webview.set_cookies_.GetList().size());
+  const base::Value& first = webview.set_cookies_.GetList()[0];
+  EXPECT_EQ("cookie1", *first.FindStringKey("name"));
+  EXPECT_EQ("http://chromium.org", *first.FindStringKey("url"));
+}
+
+TEST(WindowCommandsTest, ExecuteSetCookies_InvalidEntryRejectsBatch) {
+  BulkCookieWebView webview("http://chromium.org");
+  base::DictionaryValue params;
+  base::Value cookie_list(base::Value::Type::LIST);
+  cookie_list.Append(MakeCookieDict("cookie1", "value1"));
+  base::Value bad_cookie(base::Value::Type::DICTIONARY);
+  bad_cookie.SetStringKey("name", "cookie2");
+  cookie_list.Append(std::move(bad_cookie));
+  params.SetKey("cookies", std::move(cookie_list));
+  std::unique_ptr<base::Value> result_value;
+  Status status =
+      CallWindowCommand(ExecuteSetCookies, &webview, params, &result_value);
+  ASSERT_EQ(kInvalidArgument, status.code()) << status.message();
+  ASSERT_EQ(0u, webview.set_cookies_.GetList().size());
+}
+
+TEST(WindowCommandsTest, ExecuteDeleteCookies_OnlyNamedCookies) {
+  BulkCookieWebView webview("http://chromium.org");
+  webview.visible_cookies_.Append(MakeCookieDict("cookie1", "value1"));
+  webview.visible_cookies_.Append(MakeCookieDict("cookie2", "value2"));
+  webview.visible_cookies_.Append(MakeCookieDict("cookie3", "value3"));
+  base::DictionaryValue params;
+  base::Value names(base::Value::Type::LIST);
+  names.Append("cookie1");
+  names.Append("cookie3");
+  names.Append("not_present");
+  params.SetKey("names", std::move(names));
+  std::unique_ptr<base::Value> result_value;
+  Status status =
+      CallWindowCommand(ExecuteDeleteCookies, &webview, params, &result_value);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  ASSERT_EQ(2u, webview.deleted_names_.size());
+  EXPECT_EQ("cookie1", webview.deleted_names_[0]);
+  EXPECT_EQ("cookie3", webview.deleted_names_[1]);
+}
+
+namespace {
+
 class StorePrintParamsWebView : public StubWebView {
  public:
   StorePrintParamsWebView() : StubWebView("1") {}
@@ -404,7 +603,7 @@ base::DictionaryValue getDefaultPrintParams() {
   printParams.SetString("pageRanges", "");
   printParams.SetBoolean("preferCSSPageSize", false);
   printParams.SetBoolean("printBackground", false);
-  printParams.SetString("transferMode", "ReturnAsBase64");
+  printParams.SetString("transferMode", "ReturnAsStream");
   return printParams;
 }
 }  // namespace
@@ -804,6 +1003,34 @@ TEST(WindowCommandsTest, ExecutePrintSpecifyMargin) {
   ASSERT_EQ(kInvalidArgument, status.code()) << status.message();
 }
 
+namespace {
+
+class CaptureSnapshotWebView : public StubWebView {
+ public:
+  CaptureSnapshotWebView() : StubWebView("1") {}
+  ~CaptureSnapshotWebView() override = default;
+
+  Status CaptureSnapshot(std::string* mhtml) override {
+    *mhtml = "From: <Saved by Blink>\r\nSnapshot-Content-Location: about:blank";
+    return Status(kOk);
+  }
+};
+
+}  // namespace
+
+TEST(WindowCommandsTest, ExecuteCaptureSnapshotReturnsMhtml) {
+  CaptureSnapshotWebView webview;
+  base::DictionaryValue params;
+  std::unique_ptr<base::Value> result_value;
+  Status status = CallWindowCommand(ExecuteCaptureSnapshot, &webview, params,
+                                    &result_value);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  ASSERT_TRUE(result_value->is_string());
+  ASSERT_EQ(
+      "From: <Saved by Blink>\r\nSnapshot-Content-Location: about:blank",
+      result_value->GetString());
+}
+
 namespace {
 constexpr double wd = 345.6;
 constexpr double hd = 5432.1;
@@ -885,6 +1112,46 @@ TEST(WindowCommandsTest, ExecuteScreenCapture) {
             webview.getParams());
 }
 
+TEST(WindowCommandsTest, ExecuteScreenCaptureJpegFormat) {
+  StoreScreenshotParamsWebView webview;
+  base::DictionaryValue params;
+  params.SetString("format", "jpeg");
+  params.SetInteger("quality", 80);
+  std::unique_ptr<base::Value> result_value;
+  Status status =
+      CallWindowCommand(ExecuteScreenshot, &webview, params, &result_value);
+  ASSERT_EQ(kOk, status.code()) << status.message();
+  base::DictionaryValue expected;
+  expected.SetString("format", "jpeg");
+  expected.SetInteger("quality", 80);
+  ASSERT_EQ(static_cast<const base::Value&>(expected), webview.getParams());
+}
+
+TEST(WindowCommandsTest, ExecuteScreenCaptureRejectsBadEncodingOptions) {
+  StoreScreenshotParamsWebView webview;
+  std::unique_ptr<base::Value> result_value;
+
+  base::DictionaryValue params;
+  params.SetString("format", "gif");
+  Status status =
+      CallWindowCommand(ExecuteScreenshot, &webview, params, &result_value);
+  ASSERT_EQ(kInvalidArgument, status.code());
+
+  params.Clear();
+  params.SetString("format", "jpeg");
+  params.SetInteger("quality", 101);
+  status =
+      CallWindowCommand(ExecuteScreenshot, &webview, params, &result_value);
+  ASSERT_EQ(kInvalidArgument, status.code());
+
+  // Quality only makes sense for the lossy formats.
+  params.Clear();
+  params.SetInteger("quality", 80);
+  status =
+      CallWindowCommand(ExecuteScreenshot, &webview, params, &result_value);
+  ASSERT_EQ(kInvalidArgument, status.code());
+}
+
 TEST(WindowCommandsTest, ExecuteFullPageScreenCapture) {
   StoreScreenshotParamsWebView webview;
   base::DictionaryValue params;